@@ -125,6 +125,65 @@ int32 *hashSha1(const void *data, uint32 len, void *dest) {
 	return (int32*)sha1To;
 }
 
+// Delta is a sequence of (inserted bytes, copy offset, copy length)
+// blocks, where the copied bytes are taken from the base file.
+QByteArray countDelta(const QByteArray &base, const QByteArray &data) {
+	const int32 block = 64, baseSize = base.size(), size = data.size();
+	const uint32 multiplier = 257;
+	uint32 outPower = 1;
+	for (int32 i = 1; i < block; ++i) {
+		outPower *= multiplier;
+	}
+	const auto hashBlock = [&](const char *from) {
+		uint32 result = 0;
+		for (int32 i = 0; i < block; ++i) {
+			result = result * multiplier + uchar(from[i]);
+		}
+		return result;
+	};
+	std::unordered_map<uint32, int32> offsets;
+	for (int32 offset = 0; offset + block <= baseSize; offset += block) {
+		offsets.emplace(hashBlock(base.constData() + offset), offset);
+	}
+
+	QByteArray result;
+	QDataStream stream(&result, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	const char *b = base.constData(), *d = data.constData();
+	int32 position = 0, insertFrom = 0;
+	uint32 hash = (size >= block) ? hashBlock(d) : 0;
+	while (position + block <= size) {
+		const auto i = offsets.find(hash);
+		if (i != offsets.end() && !memcmp(b + i->second, d + position, block)) {
+			int32 offset = i->second, length = block;
+			while (position > insertFrom && offset > 0 && d[position - 1] == b[offset - 1]) {
+				--position;
+				--offset;
+				++length;
+			}
+			while (position + length < size && offset + length < baseSize && d[position + length] == b[offset + length]) {
+				++length;
+			}
+			stream << data.mid(insertFrom, position - insertFrom) << quint32(offset) << quint32(length);
+			position += length;
+			insertFrom = position;
+			if (position + block <= size) {
+				hash = hashBlock(d + position);
+			}
+		} else {
+			if (position + block < size) {
+				hash = (hash - uchar(d[position]) * outPower) * multiplier + uchar(d[position + block]);
+			}
+			++position;
+		}
+	}
+	if (insertFrom < size) {
+		stream << data.mid(insertFrom) << quint32(0) << quint32(0);
+	}
+	return result;
+}
+
 QString AlphaSignature;
 
 int writeAlphaKey() {
@@ -147,6 +206,7 @@ int main(int argc, char *argv[])
 	QString workDir;
 
 	QString remove;
+	QString deltaPath;
 	int version = 0;
 	bool target32 = false;
 	QFileInfoList files;
@@ -156,6 +216,8 @@ int main(int argc, char *argv[])
 			QFileInfo info(path);
 			files.push_back(info);
 			if (remove.isEmpty()) remove = info.canonicalPath() + "/";
+		} else if (string("-delta") == argv[i] && i + 1 < argc) {
+			deltaPath = QDir(workDir + QString(argv[i + 1])).canonicalPath() + "/";
 		} else if (string("-target") == argv[i] && i + 1 < argc) {
 			target32 = (string("mac32") == argv[i + 1]);
 		} else if (string("-version") == argv[i] && i + 1 < argc) {
@@ -190,6 +252,7 @@ int main(int argc, char *argv[])
 #else
 		cout << "Usage: Packer -path {file} -version {version} OR Packer -path {dir} -version {version}\n";
 #endif
+		cout << "Add -delta {dir} to pack changes against the installed files in {dir}\n";
 		return -1;
 	}
 
@@ -239,7 +302,12 @@ int main(int argc, char *argv[])
 			stream << quint32(version);
 		}
 
-		stream << quint32(files.size());
+		QByteArray fullData, deltaData;
+		QDataStream fullStream(&fullData, QIODevice::WriteOnly), deltaStream(&deltaData, QIODevice::WriteOnly);
+		fullStream.setVersion(QDataStream::Qt_5_1);
+		deltaStream.setVersion(QDataStream::Qt_5_1);
+		quint32 fullCount = 0, deltaCount = 0;
+
 		cout << "Found " << files.size() << " file" << (files.size() == 1 ? "" : "s") << "..\n";
 		for (QFileInfoList::iterator i = files.begin(); i != files.end(); ++i) {
 			QFileInfo info(*i);
@@ -253,10 +321,42 @@ int main(int argc, char *argv[])
 				return -1;
 			}
 			QByteArray inner = f.readAll();
-			stream << name << quint32(inner.size()) << inner;
+			bool executable = QFileInfo(fullName).isExecutable();
+
+			QFile baseFile(deltaPath + name);
+			if (!deltaPath.isEmpty() && baseFile.open(QIODevice::ReadOnly)) {
+				QByteArray base = baseFile.readAll(), delta = countDelta(base, inner);
+				if (delta.size() < inner.size()) {
+					cout << "Delta size: " << delta.size() << "\n";
+
+					uchar baseSha1[20], innerSha1[20];
+					hashSha1(base.constData(), base.size(), baseSha1);
+					hashSha1(inner.constData(), inner.size(), innerSha1);
+					deltaStream << name << QByteArray((const char*)baseSha1, 20) << quint32(inner.size()) << delta << QByteArray((const char*)innerSha1, 20);
+#if defined Q_OS_MAC || defined Q_OS_LINUX
+					deltaStream << executable;
+#endif
+					++deltaCount;
+					continue;
+				}
+			}
+			fullStream << name << quint32(inner.size()) << inner;
 #if defined Q_OS_MAC || defined Q_OS_LINUX
-			stream << (QFileInfo(fullName).isExecutable() ? true : false);
+			fullStream << executable;
 #endif
+			++fullCount;
+		}
+
+		// Delta entries follow the full files, so they are written only if present.
+		stream << fullCount;
+		stream.writeRawData(fullData.constData(), fullData.size());
+		if (deltaCount) {
+			stream << deltaCount;
+			stream.writeRawData(deltaData.constData(), deltaData.size());
+		}
+		if (fullStream.status() != QDataStream::Ok || deltaStream.status() != QDataStream::Ok) {
+			cout << "Stream status is bad!\n";
+			return -1;
 		}
 		if (stream.status() != QDataStream::Ok) {
 			cout << "Stream status is bad: " << stream.status() << "\n";
@@ -474,6 +574,9 @@ int main(int argc, char *argv[])
 #else
 #error Unknown platform!
 #endif
+	if (!deltaPath.isEmpty()) {
+		outName += "_delta";
+	}
 	if (AlphaVersion) {
 		outName += "_" + AlphaSignature;
 	}
@@ -34,6 +34,7 @@ extern "C" {
 #endif
 
 #include <string>
+#include <unordered_map>
 #include <iostream>
 #include <exception>
 
@@ -21,6 +21,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_chat.h"
 #include "data/data_user.h"
 #include "dialogs/dialogs_key.h"
+#include "dialogs/dialogs_indexed_list.h"
 #include "core/core_cloud_password.h"
 #include "core/application.h"
 #include "base/openssl_help.h"
@@ -86,13 +87,25 @@ constexpr auto kSharedMediaLimit = 100;
 //constexpr auto kFeedMessagesLimit = 50; // #feed
 constexpr auto kReadFeaturedSetsTimeout = crl::time(1000);
 constexpr auto kFileLoaderQueueStopTimeout = crl::time(5000);
+constexpr auto kFileLoaderQueueThreads = 4;
 //constexpr auto kFeedReadTimeout = crl::time(1000); // #feed
 constexpr auto kStickersByEmojiInvalidateTimeout = crl::time(60 * 60 * 1000);
+constexpr auto kWebPagePreviewCacheTimeout = crl::time(60 * 60 * 1000);
 constexpr auto kNotifySettingSaveTimeout = crl::time(1000);
 constexpr auto kDialogsFirstLoad = 20;
 constexpr auto kDialogsPerPage = 500;
 constexpr auto kBlockedFirstSlice = 16;
 
+// Reading many chats at once sends at most 8 read requests at a time.
+constexpr auto kMaxReadRequestsInFlight = 8;
+
+// Sharing to many chats sends at most 8 forward requests at a time.
+constexpr auto kMaxForwardRequestsInFlight = 8;
+
+// Cached full peer info is shown until the server answer arrives.
+constexpr auto kFullPeerCacheTimeout = TimeId(7 * 24 * 60 * 60);
+constexpr auto kFullPeerCacheVersion = qint32(1);
+
 using PhotoFileLocationId = Data::PhotoFileLocationId;
 using DocumentFileLocationId = Data::DocumentFileLocationId;
 using UpdatedFileReferences = Data::UpdatedFileReferences;
@@ -154,6 +167,105 @@ MTPVector<MTPDocumentAttribute> ComposeSendingDocumentAttributes(
 	return MTP_vector<MTPDocumentAttribute>(attributes);
 }
 
+QByteArray SerializeFullPeer(not_null<PeerData*> peer) {
+	const auto channel = peer->asChannel();
+	const auto user = peer->asUser();
+	const auto info = (user && user->botInfo && user->botInfo->inited)
+		? user->botInfo.get()
+		: nullptr;
+
+	auto result = QByteArray();
+	{
+		QDataStream stream(&result, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_1);
+		stream
+			<< kFullPeerCacheVersion
+			<< qint32(base::unixtime::now())
+			<< peer->about()
+			<< qint32(peer->pinnedMessageId())
+			<< qint32(channel ? channel->membersCount() : 0)
+			<< qint32(channel ? channel->adminsCount() : 0)
+			<< qint32(channel ? channel->restrictedCount() : 0)
+			<< qint32(channel ? channel->kickedCount() : 0)
+			<< qint32(info ? 1 : 0);
+		if (info) {
+			stream << info->description << qint32(info->commands.size());
+			for (const auto &command : info->commands) {
+				stream << command.command << command.description();
+			}
+		}
+	}
+	return result;
+}
+
+void ApplyCachedFullPeer(
+		not_null<PeerData*> peer,
+		const QByteArray &serialized) {
+	QDataStream stream(serialized);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto version = qint32();
+	stream >> version;
+	if (version != kFullPeerCacheVersion) {
+		return;
+	}
+	auto date = qint32();
+	auto about = QString();
+	auto pinned = qint32();
+	auto members = qint32();
+	auto admins = qint32();
+	auto restricted = qint32();
+	auto kicked = qint32();
+	auto hasBotInfo = qint32();
+	stream
+		>> date
+		>> about
+		>> pinned
+		>> members
+		>> admins
+		>> restricted
+		>> kicked
+		>> hasBotInfo;
+	auto description = QString();
+	auto commands = QVector<MTPBotCommand>();
+	if (hasBotInfo) {
+		auto count = qint32();
+		stream >> description >> count;
+		for (auto i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+			auto command = QString();
+			auto commandDescription = QString();
+			stream >> command >> commandDescription;
+			commands.push_back(MTP_botCommand(
+				MTP_string(command),
+				MTP_string(commandDescription)));
+		}
+	}
+	if (stream.status() != QDataStream::Ok
+		|| base::unixtime::now() > date + kFullPeerCacheTimeout) {
+		return;
+	}
+
+	peer->setAbout(about);
+	if (pinned) {
+		peer->setPinnedMessageId(pinned);
+	}
+	if (const auto channel = peer->asChannel()) {
+		if (members > 0) {
+			channel->setMembersCount(members);
+		}
+		channel->setAdminsCount(admins);
+		channel->setRestrictedCount(restricted);
+		channel->setKickedCount(kicked);
+	} else if (const auto user = peer->asUser()) {
+		if (hasBotInfo && user->botInfo) {
+			user->setBotInfo(MTP_botInfo(
+				MTP_int(peerToUser(user->id)),
+				MTP_string(description),
+				MTP_vector<MTPBotCommand>(commands)));
+		}
+	}
+}
+
 } // namespace
 
 ApiWrap::SendOptions::SendOptions(not_null<History*> history)
@@ -221,12 +333,19 @@ bool ApiWrap::BlockedUsersSlice::operator!=(const BlockedUsersSlice &other) cons
 
 ApiWrap::ApiWrap(not_null<Main::Session*> session)
 : _session(session)
-, _messageDataResolveDelayed([=] { resolveMessageDatas(); })
+, _messageDataRequests([=](
+		ChannelData *channel,
+		const std::vector<MsgId> &ids) {
+	return sendMessageDataRequest(channel, ids);
+})
+, _messageDataResolveDelayed([=] { _messageDataRequests.flush(); })
 , _webPagesTimer([=] { resolveWebPages(); })
 , _draftsSaveTimer([=] { saveDraftsToCloud(); })
 , _featuredSetsReadTimer([=] { readFeaturedSets(); })
 , _dialogsLoadState(std::make_unique<DialogsLoadState>())
-, _fileLoader(std::make_unique<TaskQueue>(kFileLoaderQueueStopTimeout))
+, _fileLoader(std::make_unique<TaskQueue>(
+	kFileLoaderQueueStopTimeout,
+	std::min(QThread::idealThreadCount(), kFileLoaderQueueThreads)))
 //, _feedReadTimer([=] { readFeeds(); }) // #feed
 , _proxyPromotionTimer([=] { refreshProxyPromotion(); })
 , _updateNotifySettingsTimer([=] { sendNotifySettingsUpdates(); }) {
@@ -571,78 +690,35 @@ void ApiWrap::sendMessageFail(
 }
 
 void ApiWrap::requestMessageData(ChannelData *channel, MsgId msgId, RequestMessageDataCallback callback) {
-	auto &req = (channel ? _channelMessageDataRequests[channel][msgId] : _messageDataRequests[msgId]);
-	if (callback) {
-		req.callbacks.append(callback);
-	}
-	if (!req.requestId) _messageDataResolveDelayed.call();
-}
-
-QVector<MTPInputMessage> ApiWrap::collectMessageIds(const MessageDataRequests &requests) {
-	auto result = QVector<MTPInputMessage>();
-	result.reserve(requests.size());
-	for (auto i = requests.cbegin(), e = requests.cend(); i != e; ++i) {
-		if (i.value().requestId > 0) continue;
-		result.push_back(MTP_inputMessageID(MTP_int(i.key())));
-	}
-	return result;
-}
-
-ApiWrap::MessageDataRequests *ApiWrap::messageDataRequests(ChannelData *channel, bool onlyExisting) {
-	if (channel) {
-		auto i = _channelMessageDataRequests.find(channel);
-		if (i == _channelMessageDataRequests.cend()) {
-			if (onlyExisting) {
-				return nullptr;
-			}
-			i = _channelMessageDataRequests.insert(channel, MessageDataRequests());
-		}
-		return &i.value();
+	if (_messageDataRequests.add(channel, msgId, std::move(callback))) {
+		_messageDataResolveDelayed.call();
 	}
-	return &_messageDataRequests;
 }
 
-void ApiWrap::resolveMessageDatas() {
-	if (_messageDataRequests.isEmpty() && _channelMessageDataRequests.isEmpty()) return;
-
-	auto ids = collectMessageIds(_messageDataRequests);
-	if (!ids.isEmpty()) {
-		auto requestId = request(MTPmessages_GetMessages(
-			MTP_vector<MTPInputMessage>(ids)
-		)).done([this](const MTPmessages_Messages &result, mtpRequestId requestId) {
-			gotMessageDatas(nullptr, result, requestId);
-		}).fail([this](const RPCError &error, mtpRequestId requestId) {
-			finalizeMessageDataRequest(nullptr, requestId);
-		}).afterDelay(kSmallDelayMs).send();
-		for (auto &request : _messageDataRequests) {
-			if (request.requestId > 0) continue;
-			request.requestId = requestId;
-		}
-	}
-	for (auto j = _channelMessageDataRequests.begin(); j != _channelMessageDataRequests.cend();) {
-		if (j->isEmpty()) {
-			j = _channelMessageDataRequests.erase(j);
-			continue;
-		}
-		auto ids = collectMessageIds(j.value());
-		if (!ids.isEmpty()) {
-			auto channel = j.key();
-			auto requestId = request(MTPchannels_GetMessages(
-				j.key()->inputChannel,
-				MTP_vector<MTPInputMessage>(ids)
-			)).done([=](const MTPmessages_Messages &result, mtpRequestId requestId) {
-				gotMessageDatas(channel, result, requestId);
-			}).fail([=](const RPCError &error, mtpRequestId requestId) {
-				finalizeMessageDataRequest(channel, requestId);
-			}).afterDelay(kSmallDelayMs).send();
-
-			for (auto &request : *j) {
-				if (request.requestId > 0) continue;
-				request.requestId = requestId;
-			}
-		}
-		++j;
-	}
+mtpRequestId ApiWrap::sendMessageDataRequest(
+		ChannelData *channel,
+		const std::vector<MsgId> &ids) {
+	auto list = QVector<MTPInputMessage>();
+	list.reserve(ids.size());
+	for (const auto id : ids) {
+		list.push_back(MTP_inputMessageID(MTP_int(id)));
+	}
+	const auto fail = [=](const RPCError &error, mtpRequestId requestId) {
+		_messageDataRequests.finish(channel, requestId);
+	};
+	const auto done = [=](
+			const MTPmessages_Messages &result,
+			mtpRequestId requestId) {
+		gotMessageDatas(channel, result, requestId);
+	};
+	return channel
+		? request(MTPchannels_GetMessages(
+			channel->inputChannel,
+			MTP_vector<MTPInputMessage>(list)
+		)).done(done).fail(fail).afterDelay(kSmallDelayMs).send()
+		: request(MTPmessages_GetMessages(
+			MTP_vector<MTPInputMessage>(list)
+		)).done(done).fail(fail).afterDelay(kSmallDelayMs).send();
 }
 
 void ApiWrap::gotMessageDatas(ChannelData *channel, const MTPmessages_Messages &msgs, mtpRequestId requestId) {
@@ -673,28 +749,7 @@ void ApiWrap::gotMessageDatas(ChannelData *channel, const MTPmessages_Messages &
 		LOG(("API Error: received messages.messagesNotModified! (ApiWrap::gotDependencyItem)"));
 		break;
 	}
-	finalizeMessageDataRequest(channel, requestId);
-}
-
-void ApiWrap::finalizeMessageDataRequest(
-		ChannelData *channel,
-		mtpRequestId requestId) {
-	auto requests = messageDataRequests(channel, true);
-	if (requests) {
-		for (auto i = requests->begin(); i != requests->cend();) {
-			if (i.value().requestId == requestId) {
-				for_const (auto &callback, i.value().callbacks) {
-					callback(channel, i.key());
-				}
-				i = requests->erase(i);
-			} else {
-				++i;
-			}
-		}
-		if (channel && requests->isEmpty()) {
-			_channelMessageDataRequests.remove(channel);
-		}
-	}
+	_messageDataRequests.finish(channel, requestId);
 }
 
 QString ApiWrap::exportDirectMessageLink(not_null<HistoryItem*> item) {
@@ -797,7 +852,12 @@ void ApiWrap::requestMoreDialogs(Data::Folder *folder) {
 			: MTP_inputPeerEmpty()),
 		MTP_int(loadCount),
 		MTP_int(hash)
-	)).done([=](const MTPmessages_Dialogs &result) {
+	)).doneAsync([=](const MTPmessages_Dialogs &result) {
+		result.match([](const MTPDmessages_dialogsNotModified & data) {
+		}, [&](const auto &data) {
+			_session->data().processUsers(data.vusers());
+			_session->data().processChats(data.vchats());
+		});
 		const auto state = dialogsLoadState(folder);
 		const auto count = result.match([](
 				const MTPDmessages_dialogsNotModified &) {
@@ -816,18 +876,9 @@ void ApiWrap::requestMoreDialogs(Data::Folder *folder) {
 				data.vmessages().v);
 			return data.vcount().v;
 		});
-		result.match([](const MTPDmessages_dialogsNotModified & data) {
-			LOG(("API Error: not-modified received for requested dialogs."));
-		}, [&](const auto &data) {
-			_session->data().processUsers(data.vusers());
-			_session->data().processChats(data.vchats());
-			_session->data().applyDialogs(
-				folder,
-				data.vmessages().v,
-				data.vdialogs().v,
-				count);
-		});
 
+		// The next slice is requested before this one is applied,
+		// so that applying it overlaps with the network round trip.
 		if (!folder) {
 			if (!_dialogsLoadState || !_dialogsLoadState->listReceived) {
 				refreshDialogsLoadBlocked();
@@ -835,6 +886,15 @@ void ApiWrap::requestMoreDialogs(Data::Folder *folder) {
 			requestDialogs(folder);
 			requestContacts();
 		}
+
+		result.match([](const MTPDmessages_dialogsNotModified & data) {
+		}, [&](const auto &data) {
+			_session->data().applyDialogs(
+				folder,
+				data.vmessages().v,
+				data.vdialogs().v,
+				count);
+		});
 		_session->data().chatsListChanged(folder);
 	}).fail([=](const RPCError &error) {
 		dialogsLoadState(folder)->requestId = 0;
@@ -1131,7 +1191,7 @@ void ApiWrap::requestFakeChatListMessage(
 		MTP_int(0),  // max_id
 		MTP_int(0),  // min_id
 		MTP_int(0)
-	)).done([=](const MTPmessages_Messages &result) {
+	)).doneAsync([=](const MTPmessages_Messages &result) {
 		_fakeChatListRequests.erase(history);
 		history->setFakeChatListMessageFrom(result);
 	}).fail([=](const RPCError &error) {
@@ -1182,6 +1242,9 @@ void ApiWrap::requestWallPaper(
 void ApiWrap::requestFullPeer(not_null<PeerData*> peer) {
 	if (_fullPeerRequests.contains(peer)) {
 		return;
+	} else if (!peer->wasFullUpdated()
+		&& _fullPeerCacheChecked.emplace(peer).second) {
+		loadCachedFullPeer(peer);
 	}
 
 	const auto requestId = [&] {
@@ -1221,6 +1284,26 @@ void ApiWrap::requestFullPeer(not_null<PeerData*> peer) {
 	_fullPeerRequests.insert(peer, requestId);
 }
 
+void ApiWrap::loadCachedFullPeer(not_null<PeerData*> peer) {
+	_session->data().cache().get(
+		Data::FullPeerCacheKey(peer->id),
+		[=](QByteArray &&value) {
+			crl::on_main(_session, [=, value = std::move(value)] {
+				// The server answer is newer, if it came first.
+				if (!value.isEmpty() && !peer->wasFullUpdated()) {
+					ApplyCachedFullPeer(peer, value);
+				}
+			});
+		});
+}
+
+void ApiWrap::saveCachedFullPeer(not_null<PeerData*> peer) {
+	_fullPeerCacheChecked.emplace(peer);
+	_session->data().cache().put(
+		Data::FullPeerCacheKey(peer->id),
+		SerializeFullPeer(peer));
+}
+
 void ApiWrap::processFullPeer(
 		not_null<PeerData*> peer,
 		const MTPmessages_ChatFull &result) {
@@ -1265,6 +1348,7 @@ void ApiWrap::gotChatFull(
 			_fullPeerRequests.erase(i);
 		}
 	}
+	saveCachedFullPeer(peer);
 	fullPeerUpdated().notify(peer);
 }
 
@@ -1288,6 +1372,7 @@ void ApiWrap::gotUserFull(
 			_fullPeerRequests.erase(i);
 		}
 	}
+	saveCachedFullPeer(user);
 	fullPeerUpdated().notify(user);
 }
 
@@ -1553,7 +1638,7 @@ void ApiWrap::requestLastParticipants(not_null<ChannelData*> channel) {
 		MTP_int(offset),
 		MTP_int(Global::ChatSizeMax()),
 		MTP_int(participantsHash)
-	)).done([=](const MTPchannels_ChannelParticipants &result) {
+	)).doneAsync([=](const MTPchannels_ChannelParticipants &result) {
 		_participantsRequests.remove(channel);
 		parseChannelParticipants(channel, result, [&](
 				int availableCount,
@@ -1583,7 +1668,7 @@ void ApiWrap::requestBots(not_null<ChannelData*> channel) {
 		MTP_int(offset),
 		MTP_int(Global::ChatSizeMax()),
 		MTP_int(participantsHash)
-	)).done([this, channel](const MTPchannels_ChannelParticipants &result) {
+	)).doneAsync([this, channel](const MTPchannels_ChannelParticipants &result) {
 		_botsRequests.remove(channel);
 		parseChannelParticipants(channel, result, [&](
 				int availableCount,
@@ -1613,7 +1698,7 @@ void ApiWrap::requestAdmins(not_null<ChannelData*> channel) {
 		MTP_int(offset),
 		MTP_int(Global::ChatSizeMax()),
 		MTP_int(participantsHash)
-	)).done([this, channel](const MTPchannels_ChannelParticipants &result) {
+	)).doneAsync([this, channel](const MTPchannels_ChannelParticipants &result) {
 		_adminsRequests.remove(channel);
 		result.match([&](const MTPDchannels_channelParticipants &data) {
 			Data::ApplyMegagroupAdmins(channel, data);
@@ -1922,7 +2007,7 @@ void ApiWrap::requestChannelMembersForAdd(
 		MTP_int(offset),
 		MTP_int(Global::ChatSizeMax()),
 		MTP_int(participantsHash)
-	)).done([this](const MTPchannels_ChannelParticipants &result) {
+	)).doneAsync([this](const MTPchannels_ChannelParticipants &result) {
 		base::take(_channelMembersForAddRequestId);
 		base::take(_channelMembersForAdd);
 		base::take(_channelMembersForAddCallback)(result);
@@ -1945,7 +2030,7 @@ void ApiWrap::requestStickerSets() {
 		if (i.value().second) continue;
 
 		auto waitMs = (j == e) ? 0 : kSmallDelayMs;
-		i.value().second = request(MTPmessages_GetStickerSet(MTP_inputStickerSetID(MTP_long(i.key()), MTP_long(i.value().first)))).done([this, setId = i.key()](const MTPmessages_StickerSet &result) {
+		i.value().second = request(MTPmessages_GetStickerSet(MTP_inputStickerSetID(MTP_long(i.key()), MTP_long(i.value().first)))).doneAsync([this, setId = i.key()](const MTPmessages_StickerSet &result) {
 			gotStickerSet(setId, result);
 		}).fail([this, setId = i.key()](const RPCError &error) {
 			_stickerSetRequests.remove(setId);
@@ -2704,6 +2789,64 @@ void ApiWrap::clearWebPageRequests() {
 	_webPagesTimer.cancel();
 }
 
+std::optional<WebPageId> ApiWrap::cachedWebPagePreview(
+		const QString &links) {
+	const auto i = _webPagePreviews.find(links);
+	if (i == end(_webPagePreviews)) {
+		return std::nullopt;
+	} else if (crl::now() >= i->second.received + kWebPagePreviewCacheTimeout) {
+		_webPagePreviews.erase(i);
+		return std::nullopt;
+	}
+	return i->second.id;
+}
+
+void ApiWrap::requestWebPagePreview(const QString &links) {
+	if (_webPagePreviewRequests.contains(links)) {
+		return;
+	}
+	const auto requestId = request(MTPmessages_GetWebPagePreview(
+		MTP_flags(0),
+		MTP_string(links),
+		MTPVector<MTPMessageEntity>()
+	)).done([=](const MTPMessageMedia &result) {
+		_webPagePreviewRequests.erase(links);
+		gotWebPagePreview(links, result);
+	}).fail([=](const RPCError &error) {
+		_webPagePreviewRequests.erase(links);
+	}).send();
+	_webPagePreviewRequests.emplace(links, requestId);
+}
+
+void ApiWrap::gotWebPagePreview(
+		const QString &links,
+		const MTPMessageMedia &result) {
+	auto page = (WebPageData*)nullptr;
+	if (result.type() == mtpc_messageMediaWebPage) {
+		const auto &data = result.c_messageMediaWebPage().vwebpage();
+		page = _session->data().processWebpage(data);
+		if (page->pendingTill > 0
+			&& page->pendingTill <= base::unixtime::now()) {
+			page->pendingTill = -1;
+		}
+	} else if (result.type() != mtpc_messageMediaEmpty) {
+		return;
+	}
+	_webPagePreviews[links] = CachedWebPagePreview{
+		page ? page->id : WebPageId(0),
+		crl::now()
+	};
+	_webPagePreviewReceived.fire({ links, page });
+	if (page) {
+		_session->data().sendWebPageGamePollNotifications();
+	}
+}
+
+auto ApiWrap::webPagePreviewReceived() const
+-> rpl::producer<WebPagePreview> {
+	return _webPagePreviewReceived.events();
+}
+
 void ApiWrap::resolveWebPages() {
 	auto ids = QVector<MTPInputMessage>(); // temp_req_id = -1
 	using IndexAndMessageIds = QPair<int32, QVector<MTPInputMessage>>;
@@ -3304,7 +3447,7 @@ void ApiWrap::requestStickers(TimeId now) {
 	};
 	_stickersUpdateRequest = request(MTPmessages_GetAllStickers(
 		MTP_int(Local::countStickersHash(true))
-	)).done(onDone).fail([=](const RPCError &error) {
+	)).doneAsync(onDone).fail([=](const RPCError &error) {
 		LOG(("App Fail: Failed to get stickers!"));
 		onDone(MTP_messages_allStickersNotModified());
 	}).send();
@@ -3769,7 +3912,7 @@ void ApiWrap::requestMessageAfterDate(
 		MTP_int(maxId),
 		MTP_int(minId),
 		MTP_int(historyHash)
-	)).done([
+	)).doneAsync([
 		=,
 		callback = std::forward<Callback>(callback)
 	](const MTPmessages_Messages &result) {
@@ -4505,6 +4648,81 @@ void ApiWrap::forwardMessages(
 	_session->data().sendHistoryChangeNotifications();
 }
 
+void ApiWrap::forwardMessagesToMany(
+		not_null<PeerData*> from,
+		const QVector<MTPint> &ids,
+		const std::vector<not_null<History*>> &histories,
+		MTPmessages_ForwardMessages::Flags flags,
+		FnMut<void()> &&successCallback) {
+	Expects(!ids.empty());
+
+	if (histories.empty()) {
+		return;
+	}
+	_forwardsPending.push_back(std::make_shared<ForwardToMany>(
+		ForwardToMany{
+			from,
+			ids,
+			flags,
+			{ begin(histories), end(histories) },
+			int(histories.size()),
+			false,
+			std::move(successCallback) }));
+	sendPendingForwards();
+}
+
+void ApiWrap::sendPendingForwards() {
+	while (!_forwardsPending.empty()
+		&& _forwardRequestsInFlight < kMaxForwardRequestsInFlight) {
+		const auto forward = _forwardsPending.front();
+		const auto history = forward->histories.front();
+		forward->histories.pop_front();
+		if (forward->histories.empty()) {
+			_forwardsPending.pop_front();
+		}
+		sendForwardToMany(forward, history);
+	}
+}
+
+void ApiWrap::sendForwardToMany(
+		const std::shared_ptr<ForwardToMany> &forward,
+		not_null<History*> history) {
+	const auto peer = history->peer;
+	auto randomIds = QVector<MTPlong>();
+	randomIds.reserve(forward->ids.size());
+	for (auto i = 0, count = int(forward->ids.size()); i != count; ++i) {
+		randomIds.push_back(rand_value<MTPlong>());
+	}
+	const auto finish = [=](bool success) {
+		--_forwardRequestsInFlight;
+		if (!success) {
+			forward->failed = true;
+		}
+		if (!--forward->requestsLeft
+			&& !forward->failed
+			&& forward->callback) {
+			forward->callback();
+		}
+		sendPendingForwards();
+	};
+	++_forwardRequestsInFlight;
+	history->sendRequestId = request(MTPmessages_ForwardMessages(
+		MTP_flags(forward->flags),
+		forward->from->input,
+		MTP_vector<MTPint>(forward->ids),
+		MTP_vector<MTPlong>(randomIds),
+		peer->input
+	)).done([=](const MTPUpdates &updates) {
+		applyUpdates(updates);
+		finish(true);
+	}).fail([=](const RPCError &error) {
+		sendMessageFail(error, peer);
+		finish(false);
+	}).afterRequest(
+		history->sendRequestId
+	).send();
+}
+
 void ApiWrap::shareContact(
 		const QString &phone,
 		const QString &firstName,
@@ -4606,7 +4824,8 @@ void ApiWrap::sendVoiceMessage(
 		QByteArray result,
 		VoiceWaveform waveform,
 		int duration,
-		const SendOptions &options) {
+		const SendOptions &options,
+		uint64 streamedId) {
 	const auto caption = TextWithTags();
 	const auto to = fileLoadTaskOptions(options);
 	_fileLoader->addTask(std::make_unique<FileLoadTask>(
@@ -4614,7 +4833,8 @@ void ApiWrap::sendVoiceMessage(
 		duration,
 		waveform,
 		to,
-		caption));
+		caption,
+		streamedId));
 }
 
 void ApiWrap::editMedia(
@@ -4985,6 +5205,7 @@ void ApiWrap::sendMessage(MessageToSend &&message) {
 			}
 			history->clearSentDraftText(QString());
 		}).afterRequest(history->sendRequestId
+		).withPriority(MTP::RequestPriority::Interactive
 		).send();
 	}
 
@@ -5928,7 +6149,8 @@ void ApiWrap::readServerHistoryForce(not_null<History*> history) {
 		}
 	}
 
-	if (_readRequests.contains(peer)) {
+	if (_readRequests.contains(peer)
+		|| _readRequests.size() >= kMaxReadRequestsInFlight) {
 		const auto i = _readRequestsPending.find(peer);
 		if (i == _readRequestsPending.cend()) {
 			_readRequestsPending.emplace(peer, upTo);
@@ -5939,6 +6161,21 @@ void ApiWrap::readServerHistoryForce(not_null<History*> history) {
 		sendReadRequest(peer, upTo);
 	}
 }
+
+void ApiWrap::readServerHistories(not_null<Data::Folder*> folder) {
+	auto histories = std::vector<not_null<History*>>();
+	for (const auto row : folder->chatsList()->indexed()->all()) {
+		if (const auto history = row->history()) {
+			histories.push_back(history);
+			if (const auto migrated = history->migrateSibling()) {
+				histories.push_back(migrated);
+			}
+		}
+	}
+	for (const auto history : histories) {
+		readServerHistory(history);
+	}
+}
 // // #feed
 //void ApiWrap::readFeed(
 //		not_null<Data::Feed*> feed,
@@ -6005,6 +6242,7 @@ void ApiWrap::sendReadRequest(not_null<PeerData*> peer, MsgId upTo) {
 					requestDialogEntry(history);
 				}
 			}
+			sendPendingReadRequests();
 		};
 		if (const auto channel = peer->asChannel()) {
 			return request(MTPchannels_ReadHistory(
@@ -6014,7 +6252,7 @@ void ApiWrap::sendReadRequest(not_null<PeerData*> peer, MsgId upTo) {
 				finished();
 			}).fail([=](const RPCError &error) {
 				finished();
-			}).send();
+			}).withPriority(MTP::RequestPriority::Interactive).send();
 		}
 		return request(MTPmessages_ReadHistory(
 			peer->input,
@@ -6024,9 +6262,24 @@ void ApiWrap::sendReadRequest(not_null<PeerData*> peer, MsgId upTo) {
 			finished();
 		}).fail([=](const RPCError &error) {
 			finished();
-		}).send();
+		}).withPriority(MTP::RequestPriority::Interactive).send();
 	}();
 	_readRequests.emplace(peer, requestId, upTo);
 }
 
+void ApiWrap::sendPendingReadRequests() {
+	auto i = begin(_readRequestsPending);
+	while (i != end(_readRequestsPending)
+		&& _readRequests.size() < kMaxReadRequestsInFlight) {
+		if (_readRequests.contains(i->first)) {
+			++i;
+			continue;
+		}
+		const auto peer = i->first;
+		const auto upTo = i->second;
+		i = _readRequestsPending.erase(i);
+		sendReadRequest(peer, upTo);
+	}
+}
+
 ApiWrap::~ApiWrap() = default;
@@ -12,6 +12,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/flat_map.h"
 #include "base/flat_set.h"
 #include "mtproto/sender.h"
+#include "mtproto/request_batcher.h"
 #include "chat_helpers/stickers.h"
 #include "data/data_messages.h"
 
@@ -29,6 +30,7 @@ class Session;
 namespace Data {
 struct UpdatedFileReferences;
 class WallPaper;
+class Folder;
 } // namespace Data
 
 namespace InlineBots {
@@ -261,6 +263,15 @@ public:
 	void clearWebPageRequest(WebPageData *page);
 	void clearWebPageRequests();
 
+	struct WebPagePreview {
+		QString links;
+		WebPageData *page = nullptr;
+	};
+	// Previews are shared by all chats, std::nullopt if not known yet.
+	std::optional<WebPageId> cachedWebPagePreview(const QString &links);
+	void requestWebPagePreview(const QString &links);
+	rpl::producer<WebPagePreview> webPagePreviewReceived() const;
+
 	void requestAttachedStickerSets(not_null<PhotoData*> photo);
 	void scheduleStickerSetRequest(uint64 setId, uint64 access);
 	void requestStickerSets();
@@ -394,6 +405,14 @@ public:
 		HistoryItemsList &&items,
 		const SendOptions &options,
 		FnMut<void()> &&successCallback = nullptr);
+
+	// Sends the same forward to many chats, a few requests at a time.
+	void forwardMessagesToMany(
+		not_null<PeerData*> from,
+		const QVector<MTPint> &ids,
+		const std::vector<not_null<History*>> &histories,
+		MTPmessages_ForwardMessages::Flags flags,
+		FnMut<void()> &&successCallback = nullptr);
 	void shareContact(
 		const QString &phone,
 		const QString &firstName,
@@ -402,6 +421,7 @@ public:
 	void shareContact(not_null<UserData*> user, const SendOptions &options);
 	void readServerHistory(not_null<History*> history);
 	void readServerHistoryForce(not_null<History*> history);
+	void readServerHistories(not_null<Data::Folder*> folder);
 	//void readFeed( // #feed
 	//	not_null<Data::Feed*> feed,
 	//	Data::MessagePosition position);
@@ -410,7 +430,8 @@ public:
 		QByteArray result,
 		VoiceWaveform waveform,
 		int duration,
-		const SendOptions &options);
+		const SendOptions &options,
+		uint64 streamedId = 0);
 	void sendFiles(
 		Storage::PreparedList &&list,
 		SendMediaType type,
@@ -510,12 +531,6 @@ public:
 	~ApiWrap();
 
 private:
-	struct MessageDataRequest {
-		using Callbacks = QList<RequestMessageDataCallback>;
-		mtpRequestId requestId = 0;
-		Callbacks callbacks;
-	};
-	using MessageDataRequests = QMap<MsgId, MessageDataRequest>;
 	using SharedMediaType = Storage::SharedMediaType;
 
 	struct StickersByEmoji {
@@ -524,6 +539,16 @@ private:
 		crl::time received = 0;
 	};
 
+	struct ForwardToMany {
+		not_null<PeerData*> from;
+		QVector<MTPint> ids;
+		MTPmessages_ForwardMessages::Flags flags;
+		std::deque<not_null<History*>> histories;
+		int requestsLeft = 0;
+		bool failed = false;
+		FnMut<void()> callback;
+	};
+
 	struct DialogsLoadState {
 		TimeId offsetDate = 0;
 		MsgId offsetId = 0;
@@ -549,16 +574,14 @@ private:
 
 	void saveDraftsToCloud();
 
-	void resolveMessageDatas();
-	void gotMessageDatas(ChannelData *channel, const MTPmessages_Messages &result, mtpRequestId requestId);
-	void finalizeMessageDataRequest(
+	mtpRequestId sendMessageDataRequest(
 		ChannelData *channel,
-		mtpRequestId requestId);
-
-	QVector<MTPInputMessage> collectMessageIds(const MessageDataRequests &requests);
-	MessageDataRequests *messageDataRequests(ChannelData *channel, bool onlyExisting = false);
+		const std::vector<MsgId> &ids);
+	void gotMessageDatas(ChannelData *channel, const MTPmessages_Messages &result, mtpRequestId requestId);
 	void applyPeerDialogs(const MTPmessages_PeerDialogs &dialogs);
 
+	void loadCachedFullPeer(not_null<PeerData*> peer);
+	void saveCachedFullPeer(not_null<PeerData*> peer);
 	void gotChatFull(
 		not_null<PeerData*> peer,
 		const MTPmessages_ChatFull &result,
@@ -576,6 +599,9 @@ private:
 		int availableCount,
 		const QVector<MTPChannelParticipant> &list);
 	void resolveWebPages();
+	void gotWebPagePreview(
+		const QString &links,
+		const MTPMessageMedia &result);
 	void gotWebPages(
 		ChannelData *channel,
 		const MTPmessages_Messages &result,
@@ -650,6 +676,11 @@ private:
 		bool justClear,
 		bool revoke);
 	void sendReadRequest(not_null<PeerData*> peer, MsgId upTo);
+	void sendPendingReadRequests();
+	void sendPendingForwards();
+	void sendForwardToMany(
+		const std::shared_ptr<ForwardToMany> &forward,
+		not_null<History*> history);
 	int applyAffectedHistory(
 		not_null<PeerData*> peer,
 		const MTPmessages_AffectedHistory &result);
@@ -719,12 +750,12 @@ private:
 
 	base::flat_map<QString, int> _modifyRequests;
 
-	MessageDataRequests _messageDataRequests;
-	QMap<ChannelData*, MessageDataRequests> _channelMessageDataRequests;
+	MTP::RequestBatcher<ChannelData*, MsgId> _messageDataRequests;
 	SingleQueuedInvokation _messageDataResolveDelayed;
 
 	using PeerRequests = QMap<PeerData*, mtpRequestId>;
 	PeerRequests _fullPeerRequests;
+	base::flat_set<not_null<PeerData*>> _fullPeerCacheChecked;
 	PeerRequests _peerRequests;
 	base::flat_set<not_null<PeerData*>> _requestedPeerSettings;
 
@@ -753,6 +784,14 @@ private:
 		mtpRequestId> _rangeDifferenceRequests;
 
 	QMap<WebPageData*, mtpRequestId> _webPagesPending;
+
+	struct CachedWebPagePreview {
+		WebPageId id = 0;
+		crl::time received = 0;
+	};
+	base::flat_map<QString, CachedWebPagePreview> _webPagePreviews;
+	base::flat_map<QString, mtpRequestId> _webPagePreviewRequests;
+	rpl::event_stream<WebPagePreview> _webPagePreviewReceived;
 	base::Timer _webPagesTimer;
 
 	QMap<uint64, QPair<uint64, mtpRequestId> > _stickerSetRequests;
@@ -840,6 +879,9 @@ private:
 	base::flat_map<not_null<PeerData*>, ReadRequest> _readRequests;
 	base::flat_map<not_null<PeerData*>, MsgId> _readRequestsPending;
 
+	std::deque<std::shared_ptr<ForwardToMany>> _forwardsPending;
+	int _forwardRequestsInFlight = 0;
+
 	std::unique_ptr<TaskQueue> _fileLoader;
 	base::flat_map<uint64, std::shared_ptr<SendingAlbum>> _sendingAlbums;
 
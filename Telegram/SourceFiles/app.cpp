@@ -353,7 +353,7 @@ namespace App {
 		App::quit();
 	}
 
-	QImage readImage(QByteArray data, QByteArray *format, bool opaque, bool *animated) {
+	QImage readImage(QByteArray data, QByteArray *format, bool opaque, bool *animated, QSize box) {
         QByteArray tmpFormat;
 		QImage result;
 		QBuffer buffer(&data);
@@ -368,6 +368,18 @@ namespace App {
 			if (animated) *animated = reader.supportsAnimation() && reader.imageCount() > 1;
 			QByteArray fmt = reader.format();
 			if (!fmt.isEmpty()) *format = fmt;
+			if (!box.isEmpty()) {
+#ifndef OS_MAC_OLD
+				if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+					box.transpose();
+				}
+#endif // OS_MAC_OLD
+				const auto size = reader.size();
+				if (size.width() > box.width() || size.height() > box.height()) {
+					// The JPEG reader uses the libjpeg DCT scaling for that.
+					reader.setScaledSize(size.scaled(box, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+				}
+			}
 			if (!reader.read(&result)) {
 				return QImage();
 			}
@@ -0,0 +1,34 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+
+namespace base::benchmark {
+
+// Runs the measured code the given number of times.
+using Method = void(*)(int iterations);
+
+bool Register(const char *name, Method method);
+
+// Keeps the compiler from throwing away the computed results.
+void Consume(int64 value);
+
+} // namespace base::benchmark
+
+#define BENCHMARK_NAME_CONCAT(a, b) a##b
+#define BENCHMARK_NAME(prefix, line) BENCHMARK_NAME_CONCAT(prefix, line)
+
+// One benchmark per line, the name is a string literal.
+#define BENCHMARK(name) \
+	static void BENCHMARK_NAME(BenchmarkMethod, __LINE__)(int iterations); \
+	static const auto BENCHMARK_NAME(BenchmarkRegistered, __LINE__) \
+		= ::base::benchmark::Register( \
+			name, \
+			&BENCHMARK_NAME(BenchmarkMethod, __LINE__)); \
+	static void BENCHMARK_NAME(BenchmarkMethod, __LINE__)(int iterations)
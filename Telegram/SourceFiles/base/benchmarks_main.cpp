@@ -0,0 +1,118 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "base/benchmark.h"
+
+#include "base/concurrent_timer.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace base {
+namespace assertion {
+
+// For Assert() / Expects() / Ensures() / Unexpected() to work.
+void log(const char *message, const char *file, int line) {
+	std::cout << message << " (" << file << ":" << line << ")" << std::endl;
+}
+
+} // namespace assertion
+
+namespace benchmark {
+namespace {
+
+constexpr auto kMinimalDuration = std::chrono::milliseconds(200);
+constexpr auto kMaximalIterations = (1 << 30);
+
+struct Entry {
+	const char *name = nullptr;
+	Method method = nullptr;
+};
+
+std::vector<Entry> &Entries() {
+	static auto result = std::vector<Entry>();
+	return result;
+}
+
+volatile int64 Sink/* = 0*/;
+
+} // namespace
+
+bool Register(const char *name, Method method) {
+	Entries().push_back({ name, method });
+	return true;
+}
+
+void Consume(int64 value) {
+	Sink = Sink + value;
+}
+
+} // namespace benchmark
+} // namespace base
+
+int main(int argc, char *argv[]) {
+	using namespace base::benchmark;
+	using Clock = std::chrono::steady_clock;
+
+	auto output = QString();
+	auto filter = QString();
+	for (auto i = 0; i + 1 < argc; ++i) {
+		if (argv[i] == QString("--output")) {
+			output = QFile::decodeName(argv[++i]);
+		} else if (argv[i] == QString("--filter")) {
+			filter = QString::fromUtf8(argv[++i]);
+		}
+	}
+
+	// For the benchmarks using crl and base::ConcurrentTimer.
+	QCoreApplication application(argc, argv);
+	base::ConcurrentTimerEnvironment environment;
+
+	auto result = QByteArray("{\"benchmarks\":[");
+	auto first = true;
+	for (const auto &entry : Entries()) {
+		if (!filter.isEmpty() && !QString(entry.name).contains(filter)) {
+			continue;
+		}
+		auto iterations = 1;
+		auto duration = Clock::duration();
+		while (true) {
+			const auto start = Clock::now();
+			entry.method(iterations);
+			duration = Clock::now() - start;
+			if (duration >= kMinimalDuration
+				|| iterations >= kMaximalIterations / 2) {
+				break;
+			}
+			iterations *= 2;
+		}
+		const auto nanoseconds = std::chrono::duration<double, std::nano>(
+			duration).count();
+		std::cerr << entry.name << ": " << (nanoseconds / iterations)
+			<< " ns" << std::endl;
+
+		result.append(first ? "\n" : ",\n");
+		result.append("{\"name\":\"").append(entry.name);
+		result.append("\",\"iterations\":");
+		result.append(QByteArray::number(iterations));
+		result.append(",\"ns_per_iteration\":");
+		result.append(QByteArray::number(nanoseconds / iterations, 'f', 2));
+		result.append('}');
+		first = false;
+	}
+	result.append("\n]}\n");
+
+	if (output.isEmpty()) {
+		std::cout << result.constData();
+		return 0;
+	}
+	QFile file(output);
+	return (file.open(QIODevice::WriteOnly)
+		&& file.write(result) == result.size()) ? 0 : 1;
+}
@@ -329,7 +329,7 @@ public:
 		typename = typename std::iterator_traits<Iterator>::iterator_category>
 	flat_multi_map(Iterator first, Iterator last)
 	: _data(first, last) {
-		std::sort(std::begin(impl()), std::end(impl()), compare());
+		sortFrom(std::begin(impl()));
 	}
 
 	flat_multi_map(std::initializer_list<pair_type> iter)
@@ -516,6 +516,22 @@ public:
 		return (range.second - range.first);
 	}
 
+	// Linear when the merged range is sorted by key.
+	template <
+		typename Iterator,
+		typename = typename std::iterator_traits<Iterator>::iterator_category>
+	void merge(Iterator first, Iterator last) {
+		const auto size = impl().size();
+		for (; first != last; ++first) {
+			impl().push_back(*first);
+		}
+		mergeFrom(std::begin(impl()) + size);
+	}
+
+	void merge(const flat_multi_map<Key, Type, Compare> &other) {
+		merge(other.begin(), other.end());
+	}
+
 private:
 	friend class flat_map<Key, Type, Compare>;
 
@@ -587,6 +603,20 @@ private:
 		return _data.elements;
 	}
 
+	void sortFrom(typename impl_t::iterator from) {
+		if (!std::is_sorted(from, std::end(impl()), compare())) {
+			std::stable_sort(from, std::end(impl()), compare());
+		}
+	}
+	void mergeFrom(typename impl_t::iterator from) {
+		sortFrom(from);
+		std::inplace_merge(
+			std::begin(impl()),
+			from,
+			std::end(impl()),
+			compare());
+	}
+
 	template <typename OtherKey>
 	typename impl_t::iterator getLowerBound(const OtherKey &key) {
 		return std::lower_bound(
@@ -834,6 +864,19 @@ public:
 		return where->second;
 	}
 
+	// Keeps the existing values for the keys that are already here.
+	template <
+		typename Iterator,
+		typename = typename std::iterator_traits<Iterator>::iterator_category>
+	void merge(Iterator first, Iterator last) {
+		parent::merge(first, last);
+		finalize();
+	}
+
+	void merge(const flat_map<Key, Type, Compare> &other) {
+		merge(other.begin(), other.end());
+	}
+
 	std::optional<Type> take(const Key &key) {
 		auto it = find(key);
 		if (it == this->end()) {
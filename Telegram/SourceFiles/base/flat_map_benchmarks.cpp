@@ -0,0 +1,122 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "base/benchmark.h"
+
+#include "base/flat_map.h"
+#include "base/flat_set.h"
+#include <map>
+#include <set>
+#include <vector>
+
+namespace {
+
+constexpr auto kCount = 1000;
+
+const std::vector<int> &Keys() {
+	static const auto result = [] {
+		auto result = std::vector<int>();
+		result.reserve(kCount);
+		auto state = uint32(1);
+		for (auto i = 0; i != kCount; ++i) {
+			state = state * 1103515245U + 12345U;
+			result.push_back(int(state >> 8));
+		}
+		return result;
+	}();
+	return result;
+}
+
+template <typename Map>
+void InsertMap(int iterations) {
+	const auto &keys = Keys();
+	for (auto i = 0; i != iterations; ++i) {
+		auto map = Map();
+		for (const auto key : keys) {
+			map.emplace(key, key);
+		}
+		base::benchmark::Consume(map.size());
+	}
+}
+
+template <typename Map>
+void FindMap(int iterations) {
+	const auto &keys = Keys();
+	auto map = Map();
+	for (const auto key : keys) {
+		map.emplace(key, key);
+	}
+	for (auto i = 0; i != iterations; ++i) {
+		auto sum = int64();
+		for (const auto key : keys) {
+			sum += map.find(key)->second;
+		}
+		base::benchmark::Consume(sum);
+	}
+}
+
+template <typename Set>
+void InsertSet(int iterations) {
+	const auto &keys = Keys();
+	for (auto i = 0; i != iterations; ++i) {
+		auto set = Set();
+		for (const auto key : keys) {
+			set.insert(key);
+		}
+		base::benchmark::Consume(set.size());
+	}
+}
+
+template <typename Set>
+void FindSet(int iterations) {
+	const auto &keys = Keys();
+	auto set = Set();
+	for (const auto key : keys) {
+		set.insert(key);
+	}
+	for (auto i = 0; i != iterations; ++i) {
+		auto found = int64();
+		for (const auto key : keys) {
+			found += (set.find(key) != set.end()) ? 1 : 0;
+		}
+		base::benchmark::Consume(found);
+	}
+}
+
+} // namespace
+
+BENCHMARK("flat_map insert 1000 random") {
+	InsertMap<base::flat_map<int, int>>(iterations);
+}
+
+BENCHMARK("std::map insert 1000 random") {
+	InsertMap<std::map<int, int>>(iterations);
+}
+
+BENCHMARK("flat_map find 1000 of 1000") {
+	FindMap<base::flat_map<int, int>>(iterations);
+}
+
+BENCHMARK("std::map find 1000 of 1000") {
+	FindMap<std::map<int, int>>(iterations);
+}
+
+BENCHMARK("flat_set insert 1000 random") {
+	InsertSet<base::flat_set<int>>(iterations);
+}
+
+BENCHMARK("std::set insert 1000 random") {
+	InsertSet<std::set<int>>(iterations);
+}
+
+BENCHMARK("flat_set find 1000 of 1000") {
+	FindSet<base::flat_set<int>>(iterations);
+}
+
+BENCHMARK("std::set find 1000 of 1000") {
+	FindSet<std::set<int>>(iterations);
+}
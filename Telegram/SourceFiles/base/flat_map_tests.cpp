@@ -119,3 +119,79 @@ TEST_CASE("flat_maps structured bindings", "[flat_map]") {
 		}
 	}
 }
+
+TEST_CASE("flat_maps bulk construction and merge", "[flat_map]") {
+	using Pair = base::flat_multi_map_pair_type<int, string>;
+	auto checkSorted = [](const base::flat_map<int, string> &v) {
+		for (auto i = v.begin(); i != v.end() && i + 1 != v.end(); ++i) {
+			REQUIRE(i->first < (i + 1)->first);
+		}
+	};
+
+	SECTION("range constructor keeps the first value of a key") {
+		const auto values = std::vector<Pair>{
+			{ 3, "a" },
+			{ 1, "b" },
+			{ 3, "c" },
+			{ 2, "d" },
+			{ 1, "e" },
+		};
+		base::flat_map<int, string> v(values.begin(), values.end());
+		REQUIRE(v.size() == 3);
+		checkSorted(v);
+		REQUIRE(v.find(1)->second == "b");
+		REQUIRE(v.find(2)->second == "d");
+		REQUIRE(v.find(3)->second == "a");
+	}
+
+	SECTION("merge of a sorted range") {
+		base::flat_map<int, string> v = { { 1, "a" }, { 4, "b" }, { 6, "c" } };
+		base::flat_map<int, string> u = { { 0, "d" }, { 4, "e" }, { 5, "f" } };
+		v.merge(u);
+		REQUIRE(v.size() == 5);
+		checkSorted(v);
+		REQUIRE(v.find(0)->second == "d");
+		REQUIRE(v.find(4)->second == "b");
+		REQUIRE(v.find(5)->second == "f");
+	}
+
+	SECTION("merge of an unsorted range") {
+		base::flat_map<int, string> v = { { 2, "a" }, { 4, "b" } };
+		const auto values = std::vector<Pair>{
+			{ 5, "c" },
+			{ 1, "d" },
+			{ 5, "e" },
+			{ 2, "f" },
+		};
+		v.merge(values.begin(), values.end());
+		REQUIRE(v.size() == 4);
+		checkSorted(v);
+		REQUIRE(v.find(1)->second == "d");
+		REQUIRE(v.find(2)->second == "a");
+		REQUIRE(v.find(5)->second == "c");
+	}
+
+	SECTION("multi map merge keeps all values in order") {
+		base::flat_multi_map<int, string> v;
+		v.emplace(1, "a");
+		v.emplace(2, "b");
+		const auto values = std::vector<Pair>{
+			{ 1, "c" },
+			{ 3, "d" },
+		};
+		v.merge(values.begin(), values.end());
+		REQUIRE(v.size() == 4);
+		REQUIRE(v.count(1) == 2);
+		REQUIRE(v.findFirst(1)->second == "a");
+		REQUIRE((v.findFirst(1) + 1)->second == "c");
+	}
+
+	SECTION("increasing keys are appended") {
+		base::flat_map<int, string> v;
+		for (auto i = 0; i != 100; ++i) {
+			v.emplace(i, string());
+		}
+		REQUIRE(v.size() == 100);
+		checkSorted(v);
+	}
+}
@@ -186,7 +186,7 @@ public:
 		typename = typename std::iterator_traits<Iterator>::iterator_category>
 	flat_multi_set(Iterator first, Iterator last)
 	: _data(first, last) {
-		std::sort(std::begin(impl()), std::end(impl()), compare());
+		sortFrom(std::begin(impl()));
 	}
 
 	flat_multi_set(std::initializer_list<Type> iter)
@@ -392,12 +392,14 @@ public:
 		return result;
 	}
 
+	// Linear when the merged range is sorted.
 	template <
 		typename Iterator,
 		typename = typename std::iterator_traits<Iterator>::iterator_category>
 	void merge(Iterator first, Iterator last) {
+		const auto size = impl().size();
 		impl().insert(impl().end(), first, last);
-		std::sort(std::begin(impl()), std::end(impl()), compare());
+		mergeFrom(std::begin(impl()) + size);
 	}
 
 	void merge(const flat_multi_set<Type, Compare> &other) {
@@ -485,6 +487,20 @@ private:
 		return _data.elements;
 	}
 
+	void sortFrom(typename impl_t::iterator from) {
+		if (!std::is_sorted(from, std::end(impl()), compare())) {
+			std::stable_sort(from, std::end(impl()), compare());
+		}
+	}
+	void mergeFrom(typename impl_t::iterator from) {
+		sortFrom(from);
+		std::inplace_merge(
+			std::begin(impl()),
+			from,
+			std::end(impl()),
+			compare());
+	}
+
 	typename impl_t::iterator getLowerBound(const Type &value) {
 		return std::lower_bound(
 			std::begin(impl()),
@@ -82,3 +82,21 @@ TEST_CASE("flat_sets with custom comparators", "[flat_set]") {
 		checkSorted();
 	}
 }
+
+TEST_CASE("flat_sets merge", "[flat_set]") {
+	base::flat_set<int> v = { 1, 4, 6 };
+
+	SECTION("merge of a sorted range") {
+		v.merge({ 0, 4, 5, 7 });
+		REQUIRE(v.size() == 6);
+		REQUIRE(std::is_sorted(v.begin(), v.end()));
+		REQUIRE(std::adjacent_find(v.begin(), v.end()) == v.end());
+	}
+
+	SECTION("merge of an unsorted range") {
+		v.merge({ 7, 1, 2, 2 });
+		REQUIRE(v.size() == 5);
+		REQUIRE(std::is_sorted(v.begin(), v.end()));
+		REQUIRE(std::adjacent_find(v.begin(), v.end()) == v.end());
+	}
+}
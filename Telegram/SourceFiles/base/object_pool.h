@@ -0,0 +1,200 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/assertion.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace base {
+
+// Blocks of one size carved from slabs of a few dozens of blocks.
+// A slab is freed as soon as all its blocks are freed (except the last).
+// Not thread safe.
+class object_pool final {
+public:
+	explicit object_pool(std::size_t size, int perSlab = 64)
+	: _blockSize(Align(std::max(size, sizeof(void*))))
+	, _perSlab(perSlab) {
+		Expects(perSlab > 0);
+	}
+	object_pool(const object_pool &other) = delete;
+	object_pool &operator=(const object_pool &other) = delete;
+
+	[[nodiscard]] void *allocate() {
+		const auto slab = partialSlab();
+		++slab->used;
+		if (const auto result = slab->free) {
+			slab->free = *static_cast<void**>(result);
+			return result;
+		}
+		return slab->begin() + (slab->fresh++) * _blockSize;
+	}
+
+	void deallocate(void *block) {
+		const auto i = find(static_cast<char*>(block));
+		Assert(i != end(_slabs));
+
+		const auto slab = i->get();
+		if (!--slab->used && _slabs.size() > 1) {
+			if (slab->partial) {
+				_partial.erase(std::find(begin(_partial), end(_partial), slab));
+			}
+			_slabs.erase(i);
+			return;
+		}
+		*static_cast<void**>(block) = slab->free;
+		slab->free = block;
+		if (!slab->partial) {
+			slab->partial = true;
+			_partial.push_back(slab);
+		}
+	}
+
+	[[nodiscard]] int slabs() const {
+		return int(_slabs.size());
+	}
+
+private:
+	using Storage = std::aligned_storage_t<
+		alignof(std::max_align_t),
+		alignof(std::max_align_t)>;
+
+	struct Slab {
+		explicit Slab(std::size_t size)
+		: storage(std::make_unique<Storage[]>(size / sizeof(Storage))) {
+		}
+
+		[[nodiscard]] char *begin() const {
+			return reinterpret_cast<char*>(storage.get());
+		}
+
+		std::unique_ptr<Storage[]> storage;
+		void *free = nullptr;
+		int used = 0;
+		int fresh = 0;
+		bool partial = false;
+	};
+	using Slabs = std::vector<std::unique_ptr<Slab>>;
+
+	static constexpr std::size_t Align(std::size_t size) {
+		return ((size + sizeof(Storage) - 1) / sizeof(Storage))
+			* sizeof(Storage);
+	}
+
+	[[nodiscard]] Slabs::iterator upperBound(const char *address) {
+		return std::upper_bound(
+			begin(_slabs),
+			end(_slabs),
+			address,
+			[](const char *address, const std::unique_ptr<Slab> &slab) {
+				return address < slab->begin();
+			});
+	}
+
+	[[nodiscard]] Slab *partialSlab() {
+		while (!_partial.empty()) {
+			const auto result = _partial.back();
+			if (result->used < _perSlab) {
+				return result;
+			}
+			result->partial = false;
+			_partial.pop_back();
+		}
+		auto slab = std::make_unique<Slab>(_blockSize * _perSlab);
+		const auto result = slab.get();
+		_slabs.insert(upperBound(result->begin()), std::move(slab));
+		result->partial = true;
+		_partial.push_back(result);
+		return result;
+	}
+
+	[[nodiscard]] Slabs::iterator find(const char *address) {
+		auto i = upperBound(address);
+		if (i == begin(_slabs)) {
+			return end(_slabs);
+		}
+		--i;
+		const auto offset = std::size_t(address - (*i)->begin());
+		return (offset < _blockSize * _perSlab) ? i : end(_slabs);
+	}
+
+	const std::size_t _blockSize = 0;
+	const int _perSlab = 0;
+
+	// Sorted by the address of their blocks.
+	Slabs _slabs;
+	std::vector<Slab*> _partial;
+
+};
+
+namespace details {
+
+// Pools for all sizes of the objects in one class hierarchy.
+class pooled_sizes final {
+public:
+	pooled_sizes() {
+		for (auto i = 0; i != kClasses; ++i) {
+			_pools[i] = std::make_unique<object_pool>((i + 1) * kStep);
+		}
+	}
+
+	[[nodiscard]] void *allocate(std::size_t size) {
+		const auto index = (size - 1) / kStep;
+		return (index < kClasses)
+			? _pools[index]->allocate()
+			: ::operator new(size);
+	}
+
+	void deallocate(void *object, std::size_t size) {
+		const auto index = (size - 1) / kStep;
+		if (index < kClasses) {
+			_pools[index]->deallocate(object);
+		} else {
+			::operator delete(object);
+		}
+	}
+
+private:
+	static constexpr auto kStep = std::size_t(16);
+	static constexpr auto kClasses = std::size_t(32);
+
+	std::array<std::unique_ptr<object_pool>, kClasses> _pools;
+
+};
+
+} // namespace details
+
+// Objects of classes derived from pooled<Base> up to 512 bytes are
+// allocated from slabs shared by the whole Base class hierarchy.
+// Base must have a virtual destructor if derived objects are deleted
+// through Base pointers, so that delete gets the right object size.
+template <typename Base>
+class pooled {
+public:
+	static void *operator new(std::size_t size) {
+		return Pools().allocate(size);
+	}
+	static void operator delete(void *object, std::size_t size) {
+		Pools().deallocate(object, size);
+	}
+
+private:
+	static details::pooled_sizes &Pools() {
+		// Never destroyed, objects may be deleted during static destruction.
+		static const auto result = new details::pooled_sizes();
+		return *result;
+	}
+
+};
+
+} // namespace base
@@ -0,0 +1,96 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/object_pool.h"
+
+#include <cstring>
+#include <set>
+
+namespace {
+
+struct Base : base::pooled<Base> {
+	virtual ~Base() = default;
+
+	int value = 0;
+};
+
+struct Derived : Base {
+	char data[100] = { 0 };
+};
+
+struct Huge : Base {
+	char data[1000] = { 0 };
+};
+
+} // namespace
+
+TEST_CASE("object pools reuse and free blocks", "[object_pool]") {
+	auto pool = base::object_pool(24, 4);
+	REQUIRE(pool.slabs() == 0);
+
+	SECTION("blocks are distinct and aligned") {
+		auto blocks = std::set<void*>();
+		for (auto i = 0; i != 10; ++i) {
+			const auto block = pool.allocate();
+			REQUIRE(reinterpret_cast<std::uintptr_t>(block)
+				% alignof(std::max_align_t) == 0);
+			std::memset(block, 0xFF, 24);
+			REQUIRE(blocks.emplace(block).second);
+		}
+		REQUIRE(pool.slabs() == 3);
+		for (const auto block : blocks) {
+			pool.deallocate(block);
+		}
+		REQUIRE(pool.slabs() == 1);
+	}
+	SECTION("freed blocks are reused") {
+		const auto first = pool.allocate();
+		const auto second = pool.allocate();
+		pool.deallocate(first);
+		REQUIRE(pool.allocate() == first);
+		pool.deallocate(second);
+		pool.deallocate(first);
+		REQUIRE(pool.slabs() == 1);
+	}
+	SECTION("slabs with free blocks are filled first") {
+		auto blocks = std::vector<void*>();
+		for (auto i = 0; i != 8; ++i) {
+			blocks.push_back(pool.allocate());
+		}
+		REQUIRE(pool.slabs() == 2);
+		pool.deallocate(blocks[1]);
+		REQUIRE(pool.allocate() == blocks[1]);
+		REQUIRE(pool.slabs() == 2);
+		for (const auto block : blocks) {
+			pool.deallocate(block);
+		}
+		REQUIRE(pool.slabs() == 1);
+	}
+}
+
+TEST_CASE("pooled objects are allocated by their size", "[object_pool]") {
+	auto objects = std::vector<std::unique_ptr<Base>>();
+	for (auto i = 0; i != 300; ++i) {
+		switch (i % 3) {
+		case 0: objects.push_back(std::make_unique<Base>()); break;
+		case 1: objects.push_back(std::make_unique<Derived>()); break;
+		case 2: objects.push_back(std::make_unique<Huge>()); break;
+		}
+		objects.back()->value = i;
+	}
+	for (auto i = 0; i != 300; ++i) {
+		REQUIRE(objects[i]->value == i);
+	}
+	for (auto i = 0; i != 300; i += 2) {
+		objects[i] = nullptr;
+	}
+	for (auto i = 1; i < 300; i += 2) {
+		REQUIRE(objects[i]->value == i);
+	}
+}
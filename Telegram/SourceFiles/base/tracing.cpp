@@ -0,0 +1,141 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "base/tracing.h"
+
+#include <QtCore/QFile>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace base::tracing {
+namespace details {
+
+std::atomic<bool> EnabledValue = false;
+
+} // namespace details
+namespace {
+
+constexpr auto kEventsPerThread = 65536;
+
+struct Event {
+	const char *name = nullptr;
+	int64 start = 0;
+	int64 duration = -1; // Counters don't have a duration.
+	int64 value = 0;
+};
+
+struct ThreadEvents {
+	std::mutex mutex;
+	std::vector<Event> events;
+	int oldest = 0;
+	int id = 0;
+};
+
+std::mutex AllMutex;
+std::vector<std::shared_ptr<ThreadEvents>> All;
+
+ThreadEvents &Local() {
+	// Shared with All, so that events survive the end of their thread.
+	thread_local const auto result = [] {
+		auto result = std::make_shared<ThreadEvents>();
+		std::lock_guard<std::mutex> lock(AllMutex);
+		result->id = int(All.size()) + 1;
+		All.push_back(result);
+		return result;
+	}();
+	return *result;
+}
+
+void Add(const Event &event) {
+	auto &local = Local();
+	std::lock_guard<std::mutex> lock(local.mutex);
+	if (local.events.size() < kEventsPerThread) {
+		local.events.push_back(event);
+	} else {
+		local.events[local.oldest] = event;
+		local.oldest = (local.oldest + 1) % kEventsPerThread;
+	}
+}
+
+void AppendName(QByteArray &to, const char *name) {
+	for (; *name; ++name) {
+		if (*name == '"' || *name == '\\') {
+			to.append('\\');
+		}
+		to.append(*name);
+	}
+}
+
+void AppendEvent(QByteArray &to, const Event &event, int thread) {
+	to.append("{\"name\":\"");
+	AppendName(to, event.name);
+	to.append("\",\"pid\":1,\"tid\":").append(QByteArray::number(thread));
+	to.append(",\"ts\":").append(QByteArray::number(qint64(event.start)));
+	if (event.duration >= 0) {
+		to.append(",\"ph\":\"X\",\"dur\":");
+		to.append(QByteArray::number(qint64(event.duration)));
+		to.append('}');
+	} else {
+		to.append(",\"ph\":\"C\",\"args\":{\"value\":");
+		to.append(QByteArray::number(qint64(event.value)));
+		to.append("}}");
+	}
+}
+
+} // namespace
+
+namespace details {
+
+int64 Now() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+void AddZone(const char *name, int64 start, int64 finish) {
+	Add({ name, start, finish - start });
+}
+
+} // namespace details
+
+void SetEnabled(bool enabled) {
+	details::EnabledValue.store(enabled, std::memory_order_relaxed);
+}
+
+void Counter(const char *name, int64 value) {
+	if (Enabled()) {
+		Add({ name, details::Now(), -1, value });
+	}
+}
+
+bool Dump(const QString &path) {
+	auto result = QByteArray("{\"traceEvents\":[");
+	auto first = true;
+	{
+		std::lock_guard<std::mutex> lock(AllMutex);
+		for (const auto &thread : All) {
+			std::lock_guard<std::mutex> lock(thread->mutex);
+			const auto count = int(thread->events.size());
+			for (auto i = 0; i != count; ++i) {
+				const auto index = (thread->oldest + i) % count;
+				result.append(first ? "\n" : ",\n");
+				AppendEvent(result, thread->events[index], thread->id);
+				first = false;
+			}
+		}
+	}
+	result.append("\n]}\n");
+
+	QFile file(path);
+	return file.open(QIODevice::WriteOnly)
+		&& (file.write(result) == result.size());
+}
+
+} // namespace base::tracing
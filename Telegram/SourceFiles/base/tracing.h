@@ -0,0 +1,65 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+
+#include <atomic>
+
+namespace base::tracing {
+namespace details {
+
+extern std::atomic<bool> EnabledValue;
+
+[[nodiscard]] int64 Now();
+void AddZone(const char *name, int64 start, int64 finish);
+
+} // namespace details
+
+// Zones and counters are recorded only while tracing is enabled.
+// Each thread keeps its last events in a ring buffer of its own.
+void SetEnabled(bool enabled);
+
+[[nodiscard]] inline bool Enabled() {
+	return details::EnabledValue.load(std::memory_order_relaxed);
+}
+
+// The name must be a string literal, it is stored as a pointer.
+void Counter(const char *name, int64 value);
+
+// Writes the recorded events in the Chrome trace event format.
+bool Dump(const QString &path);
+
+class Zone final {
+public:
+	explicit Zone(const char *name)
+	: _name(Enabled() ? name : nullptr)
+	, _start(_name ? details::Now() : 0) {
+	}
+	Zone(const Zone &other) = delete;
+	Zone &operator=(const Zone &other) = delete;
+	~Zone() {
+		if (_name) {
+			details::AddZone(_name, _start, details::Now());
+		}
+	}
+
+private:
+	const char *_name = nullptr;
+	int64 _start = 0;
+
+};
+
+} // namespace base::tracing
+
+#define TRACE_ZONE_NAME_CONCAT(a, b) a##b
+#define TRACE_ZONE_NAME(index) TRACE_ZONE_NAME_CONCAT(TraceZone, index)
+
+// Records the time until the end of the current scope.
+#define TRACE_ZONE(name) \
+	const ::base::tracing::Zone TRACE_ZONE_NAME(__COUNTER__)(name)
@@ -32,6 +32,39 @@ namespace {
 
 constexpr auto kSaveSettingsDelayedTimeout = crl::time(1000);
 
+QString TelemetryText(const std::vector<MTP::ConnectionTelemetry> &list) {
+	auto lines = QStringList();
+	for (const auto &data : list) {
+		const auto average = data.containersCount
+			? (data.containerMessagesCount / data.containersCount)
+			: 0;
+		lines.push_back(QString("DC %1: rtt %2ms, "
+			"in %3 KB/s, out %4 KB/s, resent %5, "
+			"containers %6 (x%7), queued %8, sent %9"
+			).arg(data.shiftedDcId
+			).arg(data.rtt
+			).arg(data.bytesReceivedPerSecond / 1024
+			).arg(data.bytesSentPerSecond / 1024
+			).arg(data.resendsCount
+			).arg(data.containersCount
+			).arg(average
+			).arg(data.toSendCount
+			).arg(data.haveSentCount));
+	}
+	return lines.join('\n');
+}
+
+rpl::producer<QString> TelemetryValue(not_null<MTP::Instance*> instance) {
+	return rpl::single(rpl::empty_value()) | rpl::then(
+		instance->telemetryUpdates(
+		) | rpl::map([](const MTP::ConnectionTelemetry &) {
+			return rpl::empty_value();
+		})
+	) | rpl::map([=] {
+		return TelemetryText(instance->telemetry());
+	});
+}
+
 class Base64UrlInput : public Ui::MaskedInputField {
 public:
 	Base64UrlInput(
@@ -591,6 +624,16 @@ void ProxiesBox::setupContent() {
 			st::proxyAboutPadding),
 		style::margins(0, 0, 0, st::proxyRowPadding.top()));
 
+	const auto mtproto = Core::App().activeAccount().mtp();
+	if (Logs::DebugEnabled() && mtproto) {
+		inner->add(
+			object_ptr<Ui::FlatLabel>(
+				inner,
+				TelemetryValue(mtproto),
+				st::boxDividerLabel),
+			st::proxyAboutPadding);
+	}
+
 	_wrap = inner->add(std::move(_initialWrap));
 	inner->add(object_ptr<Ui::FixedHeightWidget>(
 		inner,
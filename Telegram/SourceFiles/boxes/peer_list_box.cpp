@@ -31,6 +31,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/unixtime.h"
 #include "window/themes/window_theme.h"
 
+namespace {
+
+// Texts of rows far from the visible part are released above this count.
+constexpr auto kPreparedRowsLimit = 512;
+
+} // namespace
+
 auto PaintUserpicCallback(
 	not_null<PeerData*> peer,
 	bool respectSavedMessagesChat)
@@ -354,7 +361,8 @@ PeerListRow::PeerListRow(not_null<PeerData*> peer, PeerListRowId id)
 , _peer(peer)
 , _initialized(false)
 , _isSearchResult(false)
-, _isSavedMessagesChat(false) {
+, _isSavedMessagesChat(false)
+, _textsReleased(false) {
 }
 
 bool PeerListRow::checked() const {
@@ -373,7 +381,7 @@ void PeerListRow::clearCustomStatus() {
 }
 
 void PeerListRow::refreshStatus() {
-	if (!_initialized || _statusType == StatusType::Custom) {
+	if (!textsPrepared() || _statusType == StatusType::Custom) {
 		return;
 	}
 	_statusType = StatusType::LastSeen;
@@ -410,7 +418,7 @@ crl::time PeerListRow::refreshStatusTime() const {
 }
 
 void PeerListRow::refreshName(const style::PeerListItem &st) {
-	if (!_initialized) {
+	if (!textsPrepared()) {
 		return;
 	}
 	const auto text = _isSavedMessagesChat
@@ -427,6 +435,18 @@ void PeerListRow::invalidatePixmapsCache() {
 	}
 }
 
+void PeerListRow::releaseTexts() {
+	if (!textsPrepared()) {
+		return;
+	}
+	_textsReleased = true;
+	_name = Ui::Text::String();
+	if (_statusType != StatusType::Custom) {
+		_status = Ui::Text::String();
+	}
+	invalidatePixmapsCache();
+}
+
 int PeerListRow::nameIconWidth() const {
 	return _peer->isVerified() ? st::dialogsVerifiedIcon.width() : 0;
 }
@@ -549,6 +569,11 @@ float64 PeerListRow::checkedRatio() {
 
 void PeerListRow::lazyInitialize(const style::PeerListItem &st) {
 	if (_initialized) {
+		if (_textsReleased) {
+			_textsReleased = false;
+			refreshName(st);
+			refreshStatus();
+		}
 		return;
 	}
 	_initialized = true;
@@ -786,6 +811,7 @@ void PeerListContent::clearAllContent() {
 	_searchIndex.clear();
 	_rows.clear();
 	_searchRows.clear();
+	_preparedRows.clear();
 	_searchQuery
 		= _normalizedSearchQuery
 		= _mentionHighlight
@@ -1109,6 +1135,9 @@ crl::time PeerListContent::paintRow(Painter &p, crl::time ms, RowIndex index) {
 	auto row = getRow(index);
 	Assert(row != nullptr);
 
+	if (!row->textsPrepared()) {
+		_preparedRows.push_back(row->id());
+	}
 	row->lazyInitialize(_st.item);
 
 	auto refreshStatusAt = row->refreshStatusTime();
@@ -1305,6 +1334,32 @@ void PeerListContent::loadProfilePhotos() {
 	}
 }
 
+void PeerListContent::releaseHiddenTexts() {
+	if (_preparedRows.size() <= kPreparedRowsLimit || showingSearch()) {
+		return;
+	}
+	const auto top = _visibleTop - rowsTop();
+	const auto bottom = _visibleBottom - rowsTop();
+	const auto visible = std::max(bottom - top, _rowHeight);
+	const auto keepFrom = (top - visible * PreloadHeightsCount) / _rowHeight;
+	const auto keepTill = (bottom + visible * PreloadHeightsCount)
+		/ _rowHeight + 1;
+	const auto removeFrom = ranges::remove_if(_preparedRows, [&](
+			PeerListRowId id) {
+		const auto row = findRow(id);
+		if (!row || !row->textsPrepared()) {
+			return true;
+		}
+		const auto index = row->absoluteIndex();
+		if (index >= keepFrom && index < keepTill) {
+			return false;
+		}
+		row->releaseTexts();
+		return true;
+	});
+	_preparedRows.erase(removeFrom, end(_preparedRows));
+}
+
 void PeerListContent::checkScrollForPreload() {
 	if (_visibleBottom + PreloadHeightsCount * (_visibleBottom - _visibleTop) >= height()) {
 		_controller->loadMoreRows();
@@ -1440,6 +1495,7 @@ void PeerListContent::visibleTopBottomUpdated(
 	_visibleTop = visibleTop;
 	_visibleBottom = visibleBottom;
 	loadProfilePhotos();
+	releaseHiddenTexts();
 	checkScrollForPreload();
 }
 
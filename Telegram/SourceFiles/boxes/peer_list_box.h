@@ -154,6 +154,12 @@ public:
 	}
 	void invalidatePixmapsCache();
 
+	// Texts are prepared again by lazyInitialize() after being released.
+	bool textsPrepared() const {
+		return _initialized && !_textsReleased;
+	}
+	void releaseTexts();
+
 	template <typename UpdateCallback>
 	void addRipple(
 		const style::PeerListItem &st,
@@ -217,6 +223,7 @@ private:
 	bool _initialized : 1;
 	bool _isSearchResult : 1;
 	bool _isSavedMessagesChat : 1;
+	bool _textsReleased : 1;
 
 };
 
@@ -559,6 +566,7 @@ private:
 
 	void selectByMouse(QPoint globalPosition);
 	void loadProfilePhotos();
+	void releaseHiddenTexts();
 	void checkScrollForPreload();
 
 	void updateRow(not_null<PeerListRow*> row, RowIndex hint);
@@ -630,6 +638,7 @@ private:
 	object_ptr<Ui::FlatLabel> _searchLoading = { nullptr };
 
 	std::vector<std::unique_ptr<PeerListRow>> _searchRows;
+	std::vector<PeerListRowId> _preparedRows;
 	base::Timer _repaintByStatus;
 	base::unique_qptr<Ui::PopupMenu> _contextMenu;
 
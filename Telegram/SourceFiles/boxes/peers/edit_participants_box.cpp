@@ -965,7 +965,7 @@ auto ParticipantsBoxController::saveState() const
 	auto my = std::make_unique<SavedState>(_additional);
 	my->offset = _offset;
 	my->allLoaded = _allLoaded;
-	my->wasLoading = (_loadRequestId != 0);
+	my->wasLoading = (_loadRequestId != 0) && _showLoadedSlice;
 	if (const auto search = searchController()) {
 		my->searchState = search->saveState();
 	}
@@ -1019,9 +1019,7 @@ void ParticipantsBoxController::restoreState(
 		? state->controllerState.get()
 		: nullptr;
 	if (const auto my = dynamic_cast<SavedState*>(typeErasedState)) {
-		if (const auto requestId = base::take(_loadRequestId)) {
-			request(requestId).cancel();
-		}
+		clearSlices();
 
 		_additional = std::move(my->additional);
 		_offset = my->offset;
@@ -1223,15 +1221,27 @@ void ParticipantsBoxController::rebuildRowTypes() {
 void ParticipantsBoxController::loadMoreRows() {
 	if (searchController() && searchController()->loadMoreRows()) {
 		return;
-	} else if (!_peer->isChannel() || _loadRequestId || _allLoaded) {
+	} else if (!_peer->isChannel() || _allLoaded) {
+		return;
+	} else if (_loadRequestId) {
+		// The slice being preloaded will be shown when it arrives.
+		_showLoadedSlice = true;
+		return;
+	} else if (feedMegagroupLastParticipants()) {
+		return;
+	} else if (const auto slice = base::take(_preloadedSlice)) {
+		applySlice(*slice);
+		requestSlice(false);
 		return;
 	}
+	requestSlice(true);
+}
 
-	const auto channel = _peer->asChannel();
-	if (feedMegagroupLastParticipants()) {
+void ParticipantsBoxController::requestSlice(bool show) {
+	if (_allLoaded) {
 		return;
 	}
-
+	const auto channel = _peer->asChannel();
 	const auto filter = [&] {
 		if (_role == Role::Members || _role == Role::Profile) {
 			return MTP_channelParticipantsRecent();
@@ -1249,6 +1259,7 @@ void ParticipantsBoxController::loadMoreRows() {
 		: kParticipantsFirstPageCount;
 	const auto participantsHash = 0;
 
+	_showLoadedSlice = show;
 	_loadRequestId = request(MTPchannels_GetParticipants(
 		channel->inputChannel,
 		filter,
@@ -1256,53 +1267,75 @@ void ParticipantsBoxController::loadMoreRows() {
 		MTP_int(perPage),
 		MTP_int(participantsHash)
 	)).done([=](const MTPchannels_ChannelParticipants &result) {
-		const auto firstLoad = !_offset;
 		_loadRequestId = 0;
+		if (base::take(_showLoadedSlice)) {
+			applySlice(result);
 
-		auto wasRecentRequest = firstLoad
-			&& (_role == Role::Members || _role == Role::Profile);
-		auto parseParticipants = [&](auto &&result, auto &&callback) {
-			if (wasRecentRequest) {
-				channel->session().api().parseRecentChannelParticipants(
-					channel,
-					result,
-					callback);
-			} else {
-				channel->session().api().parseChannelParticipants(
-					channel,
-					result,
-					callback);
-			}
-		};
-		parseParticipants(result, [&](
-				int availableCount,
-				const QVector<MTPChannelParticipant> &list) {
-			for (const auto &data : list) {
-				if (const auto user = _additional.applyParticipant(data)) {
-					appendRow(user);
-				}
-			}
-			if (const auto size = list.size()) {
-				_offset += size;
-			} else {
-				// To be sure - wait for a whole empty result list.
-				_allLoaded = true;
-			}
-		});
-
-		if (_allLoaded
-			|| (firstLoad && delegate()->peerListFullRowsCount() > 0)) {
-			refreshDescription();
-		}
-		if (_onlineSorter) {
-			_onlineSorter->sort();
+			// Keep the next slice ready before the list is scrolled to it.
+			requestSlice(false);
+		} else {
+			_preloadedSlice = result;
 		}
-		delegate()->peerListRefreshRows();
 	}).fail([this](const RPCError &error) {
 		_loadRequestId = 0;
+		_showLoadedSlice = false;
 	}).send();
 }
 
+void ParticipantsBoxController::applySlice(
+		const MTPchannels_ChannelParticipants &result) {
+	const auto channel = _peer->asChannel();
+	const auto firstLoad = !_offset;
+
+	auto wasRecentRequest = firstLoad
+		&& (_role == Role::Members || _role == Role::Profile);
+	auto parseParticipants = [&](auto &&result, auto &&callback) {
+		if (wasRecentRequest) {
+			channel->session().api().parseRecentChannelParticipants(
+				channel,
+				result,
+				callback);
+		} else {
+			channel->session().api().parseChannelParticipants(
+				channel,
+				result,
+				callback);
+		}
+	};
+	parseParticipants(result, [&](
+			int availableCount,
+			const QVector<MTPChannelParticipant> &list) {
+		for (const auto &data : list) {
+			if (const auto user = _additional.applyParticipant(data)) {
+				appendRow(user);
+			}
+		}
+		if (const auto size = list.size()) {
+			_offset += size;
+		} else {
+			// To be sure - wait for a whole empty result list.
+			_allLoaded = true;
+		}
+	});
+
+	if (_allLoaded
+		|| (firstLoad && delegate()->peerListFullRowsCount() > 0)) {
+		refreshDescription();
+	}
+	if (_onlineSorter) {
+		_onlineSorter->sort();
+	}
+	delegate()->peerListRefreshRows();
+}
+
+void ParticipantsBoxController::clearSlices() {
+	if (const auto requestId = base::take(_loadRequestId)) {
+		request(requestId).cancel();
+	}
+	_showLoadedSlice = false;
+	_preloadedSlice = std::nullopt;
+}
+
 void ParticipantsBoxController::refreshDescription() {
 	setDescriptionText((_role == Role::Kicked)
 		? ((_peer->isChat() || _peer->isMegagroup())
@@ -1889,6 +1922,7 @@ void ParticipantsBoxController::subscribeToCreatorChange(
 
 void ParticipantsBoxController::fullListRefresh() {
 	_additional = ParticipantsAdditionalData(_peer, _role);
+	clearSlices();
 
 	while (const auto count = delegate()->peerListFullRowsCount()) {
 		delegate()->peerListRemoveRow(
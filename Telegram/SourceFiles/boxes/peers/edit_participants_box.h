@@ -228,6 +228,9 @@ private:
 	bool removeRow(not_null<UserData*> user);
 	void refreshCustomStatus(not_null<PeerListRow*> row) const;
 	bool feedMegagroupLastParticipants();
+	void requestSlice(bool show);
+	void applySlice(const MTPchannels_ChannelParticipants &result);
+	void clearSlices();
 	Type computeType(not_null<UserData*> user) const;
 	void recomputeTypeFor(not_null<UserData*> user);
 
@@ -241,6 +244,8 @@ private:
 	Role _role = Role::Admins;
 	int _offset = 0;
 	mtpRequestId _loadRequestId = 0;
+	bool _showLoadedSlice = false;
+	std::optional<MTPchannels_ChannelParticipants> _preloadedSlice;
 	bool _allLoaded = false;
 	ParticipantsAdditionalData _additional;
 	std::unique_ptr<ParticipantsOnlineSorter> _onlineSorter;
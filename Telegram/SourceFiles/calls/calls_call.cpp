@@ -21,6 +21,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_user.h"
 #include "data/data_session.h"
 
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
 #ifdef slots
 #undef slots
 #define NEED_TO_RESTORE_SLOTS
@@ -40,6 +43,51 @@ namespace {
 constexpr auto kMinLayer = 65;
 constexpr auto kHangupTimeoutMs = 5000;
 constexpr auto kSha256Size = 32;
+constexpr auto kMetricsLogInterval = 10 * crl::time(1000);
+
+std::string ServerConfigData;
+
+struct JitterDelays {
+	int frameDuration = 0;
+	int minDelay = 0;
+	int maxDelay = 0;
+};
+
+// Jitter buffer delays are counted in packets of the frame duration.
+std::vector<JitterDelays> JitterPresetDelays(DBICallJitterPreset preset) {
+	switch (preset) {
+	case dbicjLowLatency: return {
+		{ 20, 2, 10 },
+		{ 40, 1, 6 },
+		{ 60, 1, 4 },
+	};
+	case dbicjStable: return {
+		{ 20, 10, 40 },
+		{ 40, 6, 24 },
+		{ 60, 4, 16 },
+	};
+	}
+	return {};
+}
+
+std::string ApplyJitterPreset(
+		const std::string &data,
+		DBICallJitterPreset preset) {
+	const auto delays = JitterPresetDelays(preset);
+	if (delays.empty()) {
+		return data;
+	}
+	auto object = QJsonDocument::fromJson(
+		QByteArray::fromRawData(data.data(), data.size())).object();
+	for (const auto &entry : delays) {
+		const auto suffix = QString::number(entry.frameDuration);
+		object.insert("jitter_min_delay_" + suffix, entry.minDelay);
+		object.insert("jitter_max_delay_" + suffix, entry.maxDelay);
+	}
+	const auto result = QJsonDocument(object).toJson(
+		QJsonDocument::Compact);
+	return std::string(result.constData(), result.size());
+}
 
 void AppendEndpoint(
 		std::vector<tgvoip::Endpoint> &list,
@@ -131,6 +179,7 @@ Call::Call(
 , _user(user)
 , _type(type) {
 	_discardByTimeoutTimer.setCallback([this] { hangup(); });
+	_metricsLogTimer.setCallback([=] { logMetrics(); });
 
 	if (_type == Type::Outgoing) {
 		setState(State::Requesting);
@@ -332,6 +381,28 @@ QString Call::getDebugLog() const {
 	return QString::fromUtf8(debug.data(), debug.size());
 }
 
+Call::Metrics Call::metrics() const {
+	auto result = Metrics();
+	if (!_controller) {
+		return result;
+	}
+	auto stats = tgvoip::VoIPController::TrafficStats();
+	_controller->GetStats(&stats);
+	result.bytesSent = stats.bytesSentWifi + stats.bytesSentMobile;
+	result.bytesReceived = stats.bytesRecvdWifi + stats.bytesRecvdMobile;
+	result.details = getDebugLog();
+	return result;
+}
+
+void Call::logMetrics() {
+	const auto metrics = this->metrics();
+	DEBUG_LOG(("Call Info: Metrics, sent %1, received %2, jitter preset %3."
+		).arg(metrics.bytesSent
+		).arg(metrics.bytesReceived
+		).arg(int(Global::CallJitterPreset())));
+	DEBUG_LOG(("Call Info: Controller stats:\n%1").arg(metrics.details));
+}
+
 void Call::startWaitingTrack() {
 	_waitingTrack = Media::Audio::Current().createTrack();
 	auto trackFileName = _user->session().settings().getSoundPath(
@@ -762,6 +833,9 @@ void Call::setState(State state) {
 		switch (_state) {
 		case State::Established:
 			_startTime = crl::now();
+			if (Logs::DebugEnabled()) {
+				_metricsLogTimer.callEach(kMetricsLogInterval);
+			}
 			break;
 		case State::ExchangingKeys:
 			_delegate->playSound(Delegate::Sound::Connecting);
@@ -893,6 +967,7 @@ void Call::handleControllerError(int error) {
 }
 
 void Call::destroyController() {
+	_metricsLogTimer.cancel();
 	if (_controller) {
 		DEBUG_LOG(("Call Info: Destroying call controller.."));
 		_controller.reset();
@@ -906,7 +981,14 @@ Call::~Call() {
 }
 
 void UpdateConfig(const std::string& data) {
-	tgvoip::ServerConfig::GetSharedInstance()->Update(data);
+	ServerConfigData = data;
+	RefreshJitterPreset();
+}
+
+void RefreshJitterPreset() {
+	tgvoip::ServerConfig::GetSharedInstance()->Update(ApplyJitterPreset(
+		ServerConfigData,
+		Global::CallJitterPreset()));
 }
 
 } // namespace Calls
@@ -122,6 +122,16 @@ public:
 
 	QString getDebugLog() const;
 
+	// Controller statistics for diagnosing call quality.
+	// Loss, jitter buffer, bitrate and round-trip time are reported
+	// by the controller inside its debug string only.
+	struct Metrics {
+		uint64 bytesSent = 0;
+		uint64 bytesReceived = 0;
+		QString details;
+	};
+	[[nodiscard]] Metrics metrics() const;
+
 	void setCurrentAudioDevice(bool input, std::string deviceID);
 	void setAudioVolume(bool input, float level);
 	void setAudioDuckingEnabled(bool enabled);
@@ -180,6 +190,7 @@ private:
 	void setFailedQueued(int error);
 	void setSignalBarCount(int count);
 	void destroyController();
+	void logMetrics();
 
 	not_null<Delegate*> _delegate;
 	not_null<UserData*> _user;
@@ -193,6 +204,7 @@ private:
 	crl::time _startTime = 0;
 	base::DelayedCallTimer _finishByTimeoutTimer;
 	base::Timer _discardByTimeoutTimer;
+	base::Timer _metricsLogTimer;
 
 	bool _mute = false;
 	base::Observable<bool> _muteChanged;
@@ -217,4 +229,7 @@ private:
 
 void UpdateConfig(const std::string& data);
 
+// Applies Global::CallJitterPreset() to the last received server config.
+void RefreshJitterPreset();
+
 } // namespace Calls
@@ -164,21 +164,19 @@ void WriteLocalCache(const QString &id, const LangPackData &data) {
 
 void AppendFoundEmoji(
 		std::vector<Result> &result,
+		base::flat_set<EmojiPtr> &found,
 		const QString &label,
 		const std::vector<LangPackEmoji> &list) {
-	auto &&add = ranges::view::all(
-		list
-	) | ranges::view::filter([&](const LangPackEmoji &entry) {
-		const auto i = ranges::find(result, entry.emoji, &Result::emoji);
-		return (i == end(result));
-	}) | ranges::view::transform([&](const LangPackEmoji &entry) {
-		return Result{ entry.emoji, label, entry.text };
-	});
-	result.insert(end(result), add.begin(), add.end());
+	for (const auto &entry : list) {
+		if (found.emplace(entry.emoji).second) {
+			result.push_back({ entry.emoji, label, entry.text });
+		}
+	}
 }
 
 void AppendLegacySuggestions(
 		std::vector<Result> &result,
+		base::flat_set<EmojiPtr> &found,
 		const QString &query) {
 	const auto badSuggestionChar = [](QChar ch) {
 		return (ch < 'a' || ch > 'z')
@@ -193,22 +191,16 @@ void AppendLegacySuggestions(
 	}
 
 	const auto suggestions = GetSuggestions(QStringToUTF16(query));
-	auto &&add = ranges::view::all(
-		suggestions
-	) | ranges::view::transform([](const Suggestion &suggestion) {
-		return Result{
-			Find(QStringFromUTF16(suggestion.emoji())),
-			QStringFromUTF16(suggestion.label()),
-			QStringFromUTF16(suggestion.replacement())
-		};
-	}) | ranges::view::filter([&](const Result &entry) {
-		const auto i = entry.emoji
-			? ranges::find(result, entry.emoji, &Result::emoji)
-			: end(result);
-		return (entry.emoji != nullptr)
-			&& (i == end(result));
-	});
-	result.insert(end(result), add.begin(), add.end());
+	for (const auto &suggestion : suggestions) {
+		const auto emoji = Find(QStringFromUTF16(suggestion.emoji()));
+		if (emoji && found.emplace(emoji).second) {
+			result.push_back({
+				emoji,
+				QStringFromUTF16(suggestion.label()),
+				QStringFromUTF16(suggestion.replacement())
+			});
+		}
+	}
 }
 
 void ApplyDifference(
@@ -456,8 +448,9 @@ std::vector<Result> EmojiKeywords::LangPack::query(
 	});
 
 	auto result = std::vector<Result>();
+	auto found = base::flat_set<EmojiPtr>();
 	for (const auto &[key, list] : chosen) {
-		AppendFoundEmoji(result, key, list);
+		AppendFoundEmoji(result, found, key, list);
 	}
 	return result;
 }
@@ -581,27 +574,16 @@ std::vector<Result> EmojiKeywords::query(
 		return {};
 	}
 	auto result = std::vector<Result>();
+	auto found = base::flat_set<EmojiPtr>();
 	for (const auto &[language, item] : _data) {
-		const auto oldcount = result.size();
-		const auto list = item->query(normalized, exact);
-		auto &&add = ranges::view::all(
-			list
-		) | ranges::view::filter([&](Result entry) {
-			// In each item->query() result the list has no duplicates.
-			// So we need to check only for duplicates between queries.
-			const auto oldbegin = begin(result);
-			const auto oldend = oldbegin + oldcount;
-			const auto i = ranges::find(
-				oldbegin,
-				oldend,
-				entry.emoji,
-				&Result::emoji);
-			return (i == oldend);
-		});
-		result.insert(end(result), add.begin(), add.end());
+		for (auto &entry : item->query(normalized, exact)) {
+			if (found.emplace(entry.emoji).second) {
+				result.push_back(std::move(entry));
+			}
+		}
 	}
 	if (!exact) {
-		AppendLegacySuggestions(result, query);
+		AppendLegacySuggestions(result, found, query);
 	}
 	return result;
 }
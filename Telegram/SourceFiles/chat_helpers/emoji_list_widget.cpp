@@ -521,7 +521,9 @@ void EmojiListWidget::paintEvent(QPaintEvent *e) {
 		toColumn = _columnCount - toColumn;
 	}
 
-	enumerateSections([this, &p, r, fromColumn, toColumn](const SectionInfo &info) {
+	// All hover backgrounds and headers go first, the emoji in one batch.
+	auto emoji = std::vector<std::pair<EmojiPtr, QPoint>>();
+	enumerateSections([&](const SectionInfo &info) {
 		if (r.top() >= info.rowsBottom) {
 			return true;
 		} else if (r.top() + r.height() <= info.top) {
@@ -549,17 +551,17 @@ void EmojiListWidget::paintEvent(QPaintEvent *e) {
 						if (rtl()) tl.setX(width() - tl.x() - _singleSize.width());
 						App::roundRect(p, QRect(tl, _singleSize), st::emojiPanHover, StickerHoverCorners);
 					}
-					Ui::Emoji::Draw(
-						p,
+					emoji.emplace_back(
 						_emoji[info.section][index],
-						_esize,
-						w.x() + (_singleSize.width() - (_esize / cIntRetinaFactor())) / 2,
-						w.y() + (_singleSize.height() - (_esize / cIntRetinaFactor())) / 2);
+						QPoint(
+							w.x() + (_singleSize.width() - (_esize / cIntRetinaFactor())) / 2,
+							w.y() + (_singleSize.height() - (_esize / cIntRetinaFactor())) / 2));
 				}
 			}
 		}
 		return true;
 	});
+	Ui::Emoji::Draw(p, emoji, _esize);
 }
 
 bool EmojiListWidget::checkPickerHide() {
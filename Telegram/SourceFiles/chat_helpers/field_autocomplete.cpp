@@ -152,7 +152,7 @@ bool FieldAutocomplete::clearFilteredBotCommands() {
 namespace {
 template <typename T, typename U>
 inline int indexOfInFirstN(const T &v, const U &elem, int last) {
-	for (auto b = v.cbegin(), i = b, e = b + qMax(v.size(), last); i != e; ++i) {
+	for (auto b = v.cbegin(), i = b, e = b + qMin(v.size(), last); i != e; ++i) {
 		if (*i == elem) {
 			return (i - b);
 		}
@@ -27,7 +27,65 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Stickers {
 namespace {
 
-constexpr auto kDontCacheLottieAfterArea = 512 * 512;
+constexpr auto kDontCacheLottieAfterArea = 1024 * 1024;
+
+// Blocks the calling thread, so it must not be the main one.
+QByteArray GetCachedSync(
+		base::weak_ptr<Main::Session> weak,
+		Storage::Cache::Key key) {
+	struct State {
+		crl::semaphore semaphore;
+		QByteArray result;
+	};
+	const auto state = std::make_shared<State>();
+
+	// Wake up the caller both when the request is done and dropped.
+	auto guard = std::shared_ptr<void>(nullptr, [=](void*) {
+		state->semaphore.release();
+	});
+	crl::on_main(weak, [=, guard = std::move(guard)] {
+		const auto done = [state, guard](QByteArray &&value) {
+			state->result = std::move(value);
+		};
+		weak->data().cacheBigFile().get(key, done);
+	});
+	state->semaphore.acquire();
+	return std::move(state->result);
+}
+
+void PrepareCacheWith(
+		const QByteArray &content,
+		const Lottie::FrameRequest &request,
+		Fn<bool()> cancelled,
+		Fn<void(bool prepared)> done) {
+	// Frames are not cached for this document.
+	done(true);
+}
+
+void PrepareCacheWith(
+		FnMut<void(FnMut<void(QByteArray &&cached)>)> get,
+		FnMut<void(QByteArray &&cached)> put,
+		Lottie::CacheChunks chunks,
+		const QByteArray &content,
+		const Lottie::FrameRequest &request,
+		Fn<bool()> cancelled,
+		Fn<void(bool prepared)> done) {
+	get([=, put = std::move(put)](QByteArray &&cached) mutable {
+		crl::async([=, put = std::move(put)]() mutable {
+			const auto prepared = Lottie::PrepareCache(
+				std::move(put),
+				std::move(chunks),
+				cached,
+				content,
+				request,
+				Lottie::Quality::Default,
+				cancelled);
+			crl::on_main([=] {
+				done(prepared);
+			});
+		});
+	});
+}
 
 } // namespace
 
@@ -384,20 +442,22 @@ void SetsReceived(const QVector<MTPStickerSet> &data, int32 hash) {
 			}
 		}
 	}
-	auto writeRecent = false;
 	auto &recent = GetRecentPack();
+	auto recentLeft = base::flat_set<DocumentData*>();
+	for (const auto &item : recent) {
+		recentLeft.emplace(item.first);
+	}
+	auto recentRemove = base::flat_set<DocumentData*>();
 	for (auto it = sets.begin(), e = sets.end(); it != e;) {
 		bool installed = (it->flags & MTPDstickerSet::Flag::f_installed_date);
 		bool featured = (it->flags & MTPDstickerSet_ClientFlag::f_featured);
 		bool special = (it->flags & MTPDstickerSet_ClientFlag::f_special);
 		bool archived = (it->flags & MTPDstickerSet::Flag::f_archived);
-		if (!installed) { // remove not mine sets from recent stickers
-			for (auto i = recent.begin(); i != recent.cend();) {
-				if (it->stickers.indexOf(i->first) >= 0) {
-					i = recent.erase(i);
-					writeRecent = true;
-				} else {
-					++i;
+		if (!installed && !recentLeft.empty()) {
+			// Remove not mine sets from recent stickers.
+			for (const auto document : it->stickers) {
+				if (recentLeft.remove(document)) {
+					recentRemove.emplace(document);
 				}
 			}
 		}
@@ -407,6 +467,14 @@ void SetsReceived(const QVector<MTPStickerSet> &data, int32 hash) {
 			it = sets.erase(it);
 		}
 	}
+	const auto writeRecent = !recentRemove.empty();
+	if (writeRecent) {
+		recent.erase(
+			ranges::remove_if(recent, [&](const auto &item) {
+				return recentRemove.contains(item.first);
+			}),
+			recent.end());
+	}
 
 	if (!setsToRequest.isEmpty()) {
 		auto &api = Auth().api();
@@ -718,13 +786,12 @@ std::vector<not_null<DocumentData*>> GetListByEmoji(
 		TimeId date = 0;
 	};
 	auto result = std::vector<StickerWithDate>();
+	auto added = base::flat_set<not_null<DocumentData*>>();
 	auto &sets = session->data().stickerSetsRef();
 	auto setsToRequest = base::flat_map<uint64, uint64>();
 
 	const auto add = [&](not_null<DocumentData*> document, TimeId date) {
-		if (ranges::find(result, document, [](const StickerWithDate &data) {
-			return data.document;
-		}) == result.end()) {
+		if (added.emplace(document).second) {
 			result.push_back({ document, date });
 		}
 	};
@@ -796,6 +863,7 @@ std::vector<not_null<DocumentData*>> GetListByEmoji(
 				const auto date = usageDate
 					? usageDate
 					: InstallDate(document);
+				added.emplace(document);
 				result.push_back({
 					document,
 					date ? date : CreateRecentSortKey(document) });
@@ -1134,9 +1202,27 @@ auto LottieCachedFromContent(
 			weak->data().cacheBigFile().put(key, std::move(data));
 		});
 	};
+	const auto chunkKey = [=](int index) {
+		Expects(index >= 0 && index < 0xFF);
+
+		return Storage::Cache::Key{
+			key.high,
+			key.low + (uint64(index + 1) << 8)
+		};
+	};
+	auto chunks = Lottie::CacheChunks();
+	chunks.get = [=](int index) {
+		return GetCachedSync(weak, chunkKey(index));
+	};
+	chunks.put = [=](int index, QByteArray &&chunk) {
+		crl::on_main(weak, [=, data = std::move(chunk)]() mutable {
+			weak->data().cacheBigFile().put(chunkKey(index), std::move(data));
+		});
+	};
 	return method(
 		get,
 		put,
+		std::move(chunks),
 		content,
 		Lottie::FrameRequest{ box });
 }
@@ -1214,6 +1300,21 @@ not_null<Lottie::Animation*> LottieAnimationFromDocument(
 	return LottieFromDocument(method, document, uint8(sizeTag), box);
 }
 
+void PrepareLottieCache(
+		not_null<DocumentData*> document,
+		LottieSize sizeTag,
+		QSize box,
+		Fn<bool()> cancelled,
+		Fn<void(bool prepared)> done) {
+	const auto method = [&](auto &&...args) {
+		PrepareCacheWith(
+			std::forward<decltype(args)>(args)...,
+			std::move(cancelled),
+			std::move(done));
+	};
+	LottieFromDocument(method, document, uint8(sizeTag), box);
+}
+
 bool HasLottieThumbnail(
 		ImagePtr thumbnail,
 		not_null<DocumentData*> sticker) {
@@ -133,6 +133,7 @@ enum class LottieSize : uchar {
 	StickersFooter,
 	SetsListThumbnail,
 	InlineResults,
+	MediaPreview,
 };
 
 [[nodiscard]] std::unique_ptr<Lottie::SinglePlayer> LottiePlayerFromDocument(
@@ -154,6 +155,14 @@ enum class LottieSize : uchar {
 	LottieSize sizeTag,
 	QSize box);
 
+// Fills the frames cache for players with the same size tag and box.
+void PrepareLottieCache(
+	not_null<DocumentData*> document,
+	LottieSize sizeTag,
+	QSize box,
+	Fn<bool()> cancelled,
+	Fn<void(bool prepared)> done);
+
 [[nodiscard]] bool HasLottieThumbnail(
 	ImagePtr thumbnail,
 	not_null<DocumentData*> sticker);
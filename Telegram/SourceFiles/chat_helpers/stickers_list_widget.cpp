@@ -831,7 +831,8 @@ StickersListWidget::StickersListWidget(
 , _addWidth(st::stickersTrendingAdd.font->width(_addText))
 , _settings(this, tr::lng_stickers_you_have(tr::now))
 , _previewTimer([=] { showPreview(); })
-, _searchRequestTimer([=] { sendSearchRequest(); }) {
+, _searchRequestTimer([=] { sendSearchRequest(); })
+, _lottiePrewarmer(Stickers::LottieSize::StickersPanel) {
 	setMouseTracking(true);
 	setAttribute(Qt::WA_OpaquePaintEvent);
 
@@ -881,12 +882,18 @@ object_ptr<TabbedSelector::InnerFooter> StickersListWidget::createFooter() {
 void StickersListWidget::visibleTopBottomUpdated(
 		int visibleTop,
 		int visibleBottom) {
+	const auto scrolled = (visibleTop != getVisibleTop());
 	Inner::visibleTopBottomUpdated(visibleTop, visibleBottom);
 	if (_section == Section::Featured) {
 		checkVisibleFeatured(visibleTop, visibleBottom);
 	} else {
 		checkVisibleLottie();
 	}
+	if (scrolled) {
+		for (const auto &[id, data] : _lottieData) {
+			data.player->markScrolled();
+		}
+	}
 	validateSelectedIcon(ValidateIconAnimations::Full);
 }
 
@@ -1336,6 +1343,7 @@ void StickersListWidget::paintStickers(Painter &p, QRect clip) {
 	if (sets.empty() && _section == Section::Search) {
 		paintEmptySearchResults(p);
 	}
+	_stickersAtlas.setCell(boundingBoxSize() * cIntRetinaFactor());
 	enumerateSections([&](const SectionInfo &info) {
 		if (clip.top() >= info.rowsBottom) {
 			return true;
@@ -1465,6 +1473,7 @@ void StickersListWidget::paintStickers(Painter &p, QRect clip) {
 		markLottieFrameShown(set);
 		return true;
 	});
+	_stickersAtlas.paint(p);
 }
 
 void StickersListWidget::markLottieFrameShown(Set &set) {
@@ -1693,20 +1702,18 @@ void StickersListWidget::paintSticker(Painter &p, Set &set, int y, int section,
 		set.lottiePlayer->unpause(sticker.animated);
 	} else if (const auto image = document->getStickerSmall()) {
 		if (image->loaded()) {
-			p.drawPixmapLeft(
-				ppos,
-				width(),
-				image->pixSingle(
-					document->stickerSetOrigin(),
-					w,
-					h,
-					w,
-					h,
-					ImageRoundRadius::None));
+			paintStickerThumbnail(
+				p,
+				document,
+				image,
+				QPoint(rtl() ? (width() - ppos.x() - w) : ppos.x(), ppos.y()),
+				QSize(w, h));
 		}
 	}
 
 	if (selected && stickerHasDeleteButton(set, index)) {
+		_stickersAtlas.paint(p);
+
 		auto xPos = pos + QPoint(_singleSize.width() - st::stickerPanDeleteIconBg.width(), 0);
 		p.setOpacity(deleteSelected ? st::stickerPanDeleteOpacityBgOver : st::stickerPanDeleteOpacityBg);
 		st::stickerPanDeleteIconBg.paint(p, xPos, width());
@@ -2062,8 +2069,32 @@ void StickersListWidget::clearLottieData() {
 	_lottieData.clear();
 }
 
+void StickersListWidget::paintStickerThumbnail(
+		Painter &p,
+		not_null<DocumentData*> document,
+		not_null<Image*> image,
+		QPoint position,
+		QSize size) {
+	const auto key = document->id;
+	if (_stickersAtlas.enqueue(key, position)) {
+		return;
+	}
+	const auto &pixmap = image->pixSingle(
+		document->stickerSetOrigin(),
+		size.width(),
+		size.height(),
+		size.width(),
+		size.height(),
+		ImageRoundRadius::None);
+	if (!_stickersAtlas.insert(key, pixmap)
+		|| !_stickersAtlas.enqueue(key, position)) {
+		p.drawPixmap(position, pixmap);
+	}
+}
+
 void StickersListWidget::refreshStickers() {
 	clearSelection();
+	_stickersAtlas.clear();
 
 	refreshMySets();
 	refreshFeaturedSets();
@@ -2071,6 +2102,7 @@ void StickersListWidget::refreshStickers() {
 	refillLottieData();
 
 	resizeToWidth(width());
+	prewarmLottieCaches();
 
 	if (_footer) {
 		refreshFooterIcons();
@@ -2082,6 +2114,20 @@ void StickersListWidget::refreshStickers() {
 	update();
 }
 
+void StickersListWidget::prewarmLottieCaches() {
+	const auto box = boundingBoxSize() * cIntRetinaFactor();
+	if (box.isEmpty()) {
+		return;
+	}
+	auto documents = std::vector<not_null<DocumentData*>>();
+	for (const auto &set : _mySets) {
+		for (const auto &sticker : set.stickers) {
+			documents.push_back(sticker.document);
+		}
+	}
+	_lottiePrewarmer.setDocuments(std::move(documents), box);
+}
+
 void StickersListWidget::refreshMySets() {
 	_mySets.clear();
 	_favedStickersMap.clear();
@@ -9,6 +9,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "chat_helpers/tabbed_selector.h"
 #include "chat_helpers/stickers.h"
+#include "chat_helpers/stickers_prewarm.h"
+#include "ui/image/image_atlas.h"
 #include "base/variant.h"
 #include "base/timer.h"
 
@@ -246,6 +248,12 @@ private:
 	void paintStickers(Painter &p, QRect clip);
 	void paintMegagroupEmptySet(Painter &p, int y, bool buttonSelected);
 	void paintSticker(Painter &p, Set &set, int y, int section, int index, bool selected, bool deleteSelected);
+	void paintStickerThumbnail(
+		Painter &p,
+		not_null<DocumentData*> document,
+		not_null<Image*> image,
+		QPoint position,
+		QSize size);
 	void paintEmptySearchResults(Painter &p);
 
 	void ensureLottiePlayer(Set &set);
@@ -256,6 +264,7 @@ private:
 	void destroyLottieIn(Set &set);
 	void refillLottieData();
 	void refillLottieData(Set &set);
+	void prewarmLottieCaches();
 	void clearLottieData();
 
 	int stickersRight() const;
@@ -343,6 +352,8 @@ private:
 	mtpRequestId _searchRequestId = 0;
 
 	base::flat_map<uint64, LottieSet> _lottieData;
+	Stickers::LottiePrewarmer _lottiePrewarmer;
+	Images::Atlas _stickersAtlas;
 
 	rpl::event_stream<not_null<DocumentData*>> _chosen;
 	rpl::event_stream<> _scrollUpdated;
@@ -0,0 +1,132 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "chat_helpers/stickers_prewarm.h"
+
+#include "data/data_document.h"
+#include "core/application.h"
+
+namespace Stickers {
+namespace {
+
+constexpr auto kIdleTimeout = crl::time(3000);
+constexpr auto kCheckIdleDelay = crl::time(1000);
+constexpr auto kCheckInputDelay = crl::time(100);
+constexpr auto kPrepareNextDelay = crl::time(200);
+
+[[nodiscard]] bool UserIdle() {
+	return (crl::now() - Core::App().lastNonIdleTime() >= kIdleTimeout);
+}
+
+[[nodiscard]] bool GoodForPrewarm(not_null<DocumentData*> document) {
+	const auto sticker = document->sticker();
+	return sticker
+		&& sticker->animated
+		&& document->loaded()
+		&& document->bigFileBaseCacheKey().has_value();
+}
+
+} // namespace
+
+LottiePrewarmer::LottiePrewarmer(LottieSize sizeTag)
+: _sizeTag(sizeTag)
+, _timer([=] { check(); }) {
+}
+
+LottiePrewarmer::~LottiePrewarmer() {
+	cancel();
+}
+
+void LottiePrewarmer::setDocuments(
+		std::vector<not_null<DocumentData*>> documents,
+		QSize box) {
+	if (_box != box) {
+		cancel();
+		_ready.clear();
+		_box = box;
+	}
+	_queue.clear();
+
+	// Take the documents from the end, in the order they were given.
+	for (auto i = documents.rbegin(); i != documents.rend(); ++i) {
+		const auto document = *i;
+		if (document != _preparing
+			&& !_ready.contains(document)
+			&& GoodForPrewarm(document)) {
+			_queue.push_back(document);
+		}
+	}
+	if (!_queue.empty() && !_preparing) {
+		_timer.callOnce(kCheckIdleDelay);
+	}
+}
+
+void LottiePrewarmer::check() {
+	if (_preparing) {
+		if (UserIdle()) {
+			_timer.callOnce(kCheckInputDelay);
+		} else {
+			cancel();
+			_timer.callOnce(kCheckIdleDelay);
+		}
+	} else if (!_queue.empty()) {
+		if (UserIdle()) {
+			prepareNext();
+		} else {
+			_timer.callOnce(kCheckIdleDelay);
+		}
+	}
+}
+
+void LottiePrewarmer::prepareNext() {
+	Expects(!_preparing);
+
+	while (!_queue.empty() && !_preparing) {
+		const auto document = _queue.back();
+		_queue.pop_back();
+		if (GoodForPrewarm(document)) {
+			_preparing = document;
+		}
+	}
+	if (!_preparing) {
+		return;
+	}
+	const auto document = not_null<DocumentData*>(_preparing);
+	_cancelled = std::make_shared<std::atomic<bool>>(false);
+	const auto cancelled = [flag = _cancelled] {
+		return flag->load(std::memory_order_relaxed);
+	};
+	const auto box = _box;
+	const auto done = crl::guard(this, [=](bool prepared) {
+		this->prepared(document, prepared && (box == _box));
+	});
+	_timer.callOnce(kCheckInputDelay);
+	PrepareLottieCache(document, _sizeTag, _box, cancelled, done);
+}
+
+void LottiePrewarmer::prepared(not_null<DocumentData*> document, bool done) {
+	if (_preparing != document) {
+		return;
+	}
+	_preparing = nullptr;
+	_cancelled = nullptr;
+	if (done) {
+		_ready.emplace(document);
+	} else {
+		// Stopped by the user input, the cache will continue later.
+		_queue.push_back(document);
+	}
+	_timer.callOnce(UserIdle() ? kPrepareNextDelay : kCheckIdleDelay);
+}
+
+void LottiePrewarmer::cancel() {
+	if (_cancelled) {
+		_cancelled->store(true, std::memory_order_relaxed);
+	}
+}
+
+} // namespace Stickers
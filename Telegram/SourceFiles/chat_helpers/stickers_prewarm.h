@@ -0,0 +1,46 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "chat_helpers/stickers.h"
+#include "base/timer.h"
+#include "base/weak_ptr.h"
+#include "base/flat_set.h"
+
+class DocumentData;
+
+namespace Stickers {
+
+// Fills the frames caches of animated stickers one by one while the
+// user is idle, so that the first display of them doesn't stutter.
+class LottiePrewarmer final : public base::has_weak_ptr {
+public:
+	explicit LottiePrewarmer(LottieSize sizeTag);
+	~LottiePrewarmer();
+
+	void setDocuments(
+		std::vector<not_null<DocumentData*>> documents,
+		QSize box);
+
+private:
+	void check();
+	void prepareNext();
+	void prepared(not_null<DocumentData*> document, bool done);
+	void cancel();
+
+	const LottieSize _sizeTag;
+	QSize _box;
+	std::vector<not_null<DocumentData*>> _queue;
+	base::flat_set<not_null<DocumentData*>> _ready;
+	DocumentData *_preparing = nullptr;
+	std::shared_ptr<std::atomic<bool>> _cancelled;
+	base::Timer _timer;
+
+};
+
+} // namespace Stickers
@@ -668,6 +668,30 @@ bool Generator::writeFindFromDictionary(
 		uniqueFirstChars[ch] = 0;
 	}
 
+	// Most of the text characters are below the first non-latin1 key
+	// character and can't start a key, reject them with a short check.
+	const auto firstHigh = uniqueFirstChars.lower_bound(0x100);
+	const auto lowLimit = (firstHigh != end(uniqueFirstChars))
+		? firstHigh->first
+		: 0x10000;
+	const auto lowLimitString = "0x" + QString::number(lowLimit, 16);
+	source_->stream() << "\tif (ch == end) return 0;\n";
+	if (uniqueFirstChars.begin() == firstHigh) {
+		source_->stream() << "\tif (ch->unicode() < " << lowLimitString << ") return 0;\n";
+	} else {
+		if (lowLimit < 0x10000) {
+			source_->stream() << "\tif (ch->unicode() < " << lowLimitString << ") ";
+		} else {
+			source_->stream() << "\t";
+		}
+		source_->stream() << "switch (ch->unicode()) {\n";
+		for (auto i = uniqueFirstChars.begin(); i != firstHigh; ++i) {
+			source_->stream() << "\tcase 0x" << QString::number(i->first, 16) << ":\n";
+		}
+		source_->stream() << "\t\tbreak;\n\tdefault:\n\t\treturn 0;\n\t}\n";
+	}
+	source_->stream() << "\n";
+
 	enum class UsedCheckType {
 		Switch,
 		If,
@@ -789,7 +789,7 @@ for restype in typesList:
       reader += '\tcase mtpc_' + name + ': _type = cons; '; # read switch line
       if (len(prms) > len(trivialConditions)):
         reader += '{\n';
-        reader += '\t\tif (const auto data = new MTPD' + name + '(); data->read(from, end)) {\n';
+        reader += '\t\tif (const auto data = new (MTP::internal::TypeDataArena::Current()) MTPD' + name + '(); data->read(from, end)) {\n';
         reader += '\t\t\tsetData(data);\n';
         reader += '\t\t} else {\n';
         reader += '\t\t\tdelete data;\n';
@@ -805,7 +805,7 @@ for restype in typesList:
         reader += 'break;\n';
     else:
       if (len(prms) > len(trivialConditions)):
-        reader += '\tif (const auto data = new MTPD' + name + '(); data->read(from, end)) {\n';
+        reader += '\tif (const auto data = new (MTP::internal::TypeDataArena::Current()) MTPD' + name + '(); data->read(from, end)) {\n';
         reader += '\t\tsetData(data);\n';
         reader += '\t} else {\n';
         reader += '\t\tdelete data;\n';
@@ -19,6 +19,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/sandbox.h"
 #include "core/local_url_handlers.h"
 #include "core/launcher.h"
+#include "core/startup_timeline.h"
 #include "chat_helpers/emoji_keywords.h"
 #include "storage/localstorage.h"
 #include "platform/platform_specific.h"
@@ -150,13 +151,19 @@ Application::~Application() {
 }
 
 void Application::run() {
-	Fonts::Start();
+	{
+		const auto phase = Startup::Phase("Fonts");
+		Fonts::Start();
+	}
 
 	ThirdParty::start();
 	Global::start();
 	refreshGlobalProxy(); // Depends on Global::started().
 
-	startLocalStorage();
+	{
+		const auto phase = Startup::Phase("Local storage");
+		startLocalStorage();
+	}
 
 	if (Local::oldSettingsVersion() < AppVersion) {
 		psNewVersion();
@@ -171,10 +178,19 @@ void Application::run() {
 	_translator = std::make_unique<Lang::Translator>();
 	QCoreApplication::instance()->installTranslator(_translator.get());
 
-	style::startManager();
+	{
+		const auto phase = Startup::Phase("Style");
+		style::startManager();
+	}
 	Ui::InitTextOptions();
-	Ui::Emoji::Init();
-	Media::Player::start(_audio.get());
+	{
+		const auto phase = Startup::Phase("Emoji");
+		Ui::Emoji::Init();
+	}
+	{
+		const auto phase = Startup::Phase("Media");
+		Media::Player::start(_audio.get());
+	}
 
 	DEBUG_LOG(("Application Info: inited..."));
 
@@ -185,11 +201,14 @@ void Application::run() {
 	// Create mime database, so it won't be slow later.
 	QMimeDatabase().mimeTypeForName(qsl("text/plain"));
 
-	_window = std::make_unique<Window::Controller>(&activeAccount());
+	{
+		const auto phase = Startup::Phase("Window");
+		_window = std::make_unique<Window::Controller>(&activeAccount());
 
-	const auto currentGeometry = _window->widget()->geometry();
-	_mediaView = std::make_unique<Media::View::OverlayWidget>();
-	_window->widget()->setGeometry(currentGeometry);
+		const auto currentGeometry = _window->widget()->geometry();
+		_mediaView = std::make_unique<Media::View::OverlayWidget>();
+		_window->widget()->setGeometry(currentGeometry);
+	}
 
 	QCoreApplication::instance()->installEventFilter(this);
 	connect(
@@ -203,7 +222,10 @@ void Application::run() {
 	startShortcuts();
 	App::initMedia();
 
-	Local::ReadMapState state = Local::readMap(QByteArray());
+	const auto state = [&] {
+		const auto phase = Startup::Phase("Local map");
+		return Local::readMap(QByteArray());
+	}();
 	if (state == Local::ReadMapPassNeeded) {
 		Global::SetLocalPasscode(true);
 		Global::RefLocalPasscodeChanged().notify();
@@ -211,8 +233,12 @@ void Application::run() {
 		DEBUG_LOG(("Application Info: passcode needed..."));
 	} else {
 		DEBUG_LOG(("Application Info: local map read..."));
-		activeAccount().startMtp();
+		{
+			const auto phase = Startup::Phase("MTP");
+			activeAccount().startMtp();
+		}
 		DEBUG_LOG(("Application Info: MTP started..."));
+		const auto phase = Startup::Phase("Main widget");
 		if (activeAccount().sessionExists()) {
 			_window->setupMain();
 		} else {
@@ -220,7 +246,10 @@ void Application::run() {
 		}
 	}
 	DEBUG_LOG(("Application Info: showing."));
-	_window->firstShow();
+	{
+		const auto phase = Startup::Phase("First show");
+		_window->firstShow();
+	}
 
 	if (!locked() && cStartToSettings()) {
 		_window->showSettings();
@@ -14,7 +14,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/main_queue_processor.h"
 #include "core/update_checker.h"
 #include "core/sandbox.h"
+#include "core/startup_timeline.h"
 #include "base/concurrent_timer.h"
+#include "base/tracing.h"
 
 namespace Core {
 namespace {
@@ -275,6 +277,10 @@ int Launcher::exec() {
 
 	DEBUG_LOG(("Telegram finished, result: %1").arg(result));
 
+	if (base::tracing::Enabled()) {
+		base::tracing::Dump(cWorkingDir() + qsl("trace.json"));
+	}
+
 	if (!UpdaterDisabled() && cRestartingUpdate()) {
 		DEBUG_LOG(("Sandbox Info: executing updater to install update."));
 		if (!launchUpdater(UpdaterLaunch::PerformUpdate)) {
@@ -387,8 +393,11 @@ void Launcher::processArguments() {
 		{ "-externalupdater", KeyFormat::NoValues },
 		{ "-tosettings"     , KeyFormat::NoValues },
 		{ "-startintray"    , KeyFormat::NoValues },
+		{ "-tracing"        , KeyFormat::NoValues },
+		{ "-startuptimeline", KeyFormat::NoValues },
 		{ "-sendpath"       , KeyFormat::AllLeftValues },
 		{ "-workdir"        , KeyFormat::OneValue },
+		{ "-updatesmirror"  , KeyFormat::OneValue },
 		{ "--"              , KeyFormat::OneValue },
 		{ "-scale"          , KeyFormat::OneValue },
 	};
@@ -420,6 +429,10 @@ void Launcher::processArguments() {
 	}
 	gTestMode = parseResult.contains("-testmode");
 	Logs::SetDebugEnabled(parseResult.contains("-debug"));
+	base::tracing::SetEnabled(parseResult.contains("-tracing"));
+	if (parseResult.contains("-startuptimeline")) {
+		Startup::StartRecording();
+	}
 	gManyInstance = parseResult.contains("-many");
 	gKeyFile = parseResult.value("-key", {}).join(QString()).toLower();
 	gKeyFile = gKeyFile.replace(QRegularExpression("[^a-z0-9\\-_]"), {});
@@ -440,6 +453,7 @@ void Launcher::processArguments() {
 		}
 	}
 	gStartUrl = parseResult.value("--", {}).join(QString());
+	gUpdatesMirror = parseResult.value("-updatesmirror", {}).join(QString());
 
 	const auto scaleKey = parseResult.value("-scale", {});
 	if (scaleKey.size() > 0) {
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/last_used_cache.h"
+#include "core/memory_counters.h"
 
 namespace Core {
 
@@ -15,7 +16,7 @@ template <typename Type>
 class MediaActiveCache {
 public:
 	template <typename Unload>
-	MediaActiveCache(int64 limit, Unload &&unload);
+	MediaActiveCache(const char *name, int64 limit, Unload &&unload);
 
 	void up(Type *entry);
 	void remove(Type *entry);
@@ -30,6 +31,7 @@ private:
 
 	base::last_used_cache<Type*> _cache;
 	SingleQueuedInvokation _delayed;
+	MemoryCounter _counter;
 	int64 _usage = 0;
 	int64 _limit = 0;
 
@@ -37,8 +39,12 @@ private:
 
 template <typename Type>
 template <typename Unload>
-MediaActiveCache<Type>::MediaActiveCache(int64 limit, Unload &&unload)
+MediaActiveCache<Type>::MediaActiveCache(
+	const char *name,
+	int64 limit,
+	Unload &&unload)
 : _delayed([=] { check(unload); })
+, _counter(name)
 , _limit(limit) {
 }
 
@@ -61,11 +67,13 @@ void MediaActiveCache<Type>::clear() {
 template <typename Type>
 void MediaActiveCache<Type>::increment(int64 amount) {
 	_usage += amount;
+	_counter.add(amount);
 }
 
 template <typename Type>
 void MediaActiveCache<Type>::decrement(int64 amount) {
 	_usage -= amount;
+	_counter.subtract(amount);
 }
 
 template <typename Type>
@@ -0,0 +1,78 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/memory_counters.h"
+
+#include <mutex>
+
+namespace Core {
+namespace {
+
+std::mutex CountersMutex;
+
+std::vector<MemoryCounter*> &Counters() {
+	static auto result = std::vector<MemoryCounter*>();
+	return result;
+}
+
+QString FormatMegabytes(int64 bytes) {
+	return QString::number(bytes / (1024. * 1024.), 'f', 1) + qsl(" MB");
+}
+
+} // namespace
+
+MemoryCounter::MemoryCounter(const char *name) : _name(name) {
+	std::lock_guard<std::mutex> lock(CountersMutex);
+	Counters().push_back(this);
+}
+
+MemoryCounter::~MemoryCounter() {
+	std::lock_guard<std::mutex> lock(CountersMutex);
+	auto &counters = Counters();
+	counters.erase(ranges::remove(counters, this), end(counters));
+}
+
+void MemoryCounter::add(int64 amount) {
+	const auto now = _current.fetch_add(amount) + amount;
+	auto peak = _peak.load();
+	while (now > peak && !_peak.compare_exchange_weak(peak, now)) {
+	}
+}
+
+void MemoryCounter::subtract(int64 amount) {
+	_current.fetch_sub(amount);
+}
+
+const char *MemoryCounter::name() const {
+	return _name;
+}
+
+int64 MemoryCounter::current() const {
+	return _current.load();
+}
+
+int64 MemoryCounter::peak() const {
+	return _peak.load();
+}
+
+QString MemoryReport() {
+	auto result = QStringList();
+	std::lock_guard<std::mutex> lock(CountersMutex);
+	for (const auto counter : Counters()) {
+		result.push_back(qsl("%1: %2 (peak %3)"
+		).arg(counter->name()
+		).arg(FormatMegabytes(counter->current())
+		).arg(FormatMegabytes(counter->peak())));
+	}
+	return result.join('\n');
+}
+
+void LogMemoryReport() {
+	LOG(("Memory Info:\n%1").arg(MemoryReport()));
+}
+
+} // namespace Core
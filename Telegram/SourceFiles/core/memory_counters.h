@@ -0,0 +1,41 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+
+namespace Core {
+
+// Bytes held by one cache, with the high-water mark, for the memory
+// report. Counters must outlive any call to MemoryReport().
+class MemoryCounter final {
+public:
+	explicit MemoryCounter(const char *name);
+	MemoryCounter(const MemoryCounter &other) = delete;
+	MemoryCounter &operator=(const MemoryCounter &other) = delete;
+	~MemoryCounter();
+
+	void add(int64 amount);
+	void subtract(int64 amount);
+
+	[[nodiscard]] const char *name() const;
+	[[nodiscard]] int64 current() const;
+	[[nodiscard]] int64 peak() const;
+
+private:
+	const char * const _name = nullptr;
+	std::atomic<int64> _current = 0;
+	std::atomic<int64> _peak = 0;
+
+};
+
+// One "name: current MB (peak MB)" line for each counter.
+[[nodiscard]] QString MemoryReport();
+void LogMemoryReport();
+
+} // namespace Core
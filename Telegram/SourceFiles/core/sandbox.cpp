@@ -18,6 +18,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/launcher.h"
 #include "core/local_url_handlers.h"
 #include "core/update_checker.h"
+#include "core/stall_detector.h"
+#include "core/startup_timeline.h"
 #include "base/timer.h"
 #include "base/concurrent_timer.h"
 #include "base/invoke_queued.h"
@@ -86,6 +88,7 @@ int Sandbox::start() {
 	if (!Core::UpdaterDisabled()) {
 		_updateChecker = std::make_unique<Core::UpdateChecker>();
 	}
+	_stallDetector = std::make_unique<StallDetector>();
 	const auto d = QFile::encodeName(QDir(cWorkingDir()).absolutePath());
 	char h[33] = { 0 };
 	hashMd5Hex(d.constData(), d.size(), h);
@@ -148,6 +151,7 @@ void Sandbox::launchApplication() {
 		}
 		setupScreenScale();
 
+		const auto phase = Startup::Phase("Application");
 		_application = std::make_unique<Application>(_launcher);
 
 		// Ideally this should go to constructor.
@@ -508,6 +512,9 @@ bool Sandbox::notify(QObject *receiver, QEvent *e) {
 		return notifyOrInvoke(receiver, e);
 	}
 
+	if (_stallDetector && receiver) {
+		_stallDetector->eventStarted(receiver, e);
+	}
 	const auto wrap = createEventNestingLevel();
 	if (e->type() == QEvent::UpdateRequest) {
 		const auto weak = make_weak(receiver);
@@ -515,6 +522,12 @@ bool Sandbox::notify(QObject *receiver, QEvent *e) {
 		if (!weak) {
 			return true;
 		}
+	} else if (e->type() == QEvent::Paint
+		&& _application
+		&& Startup::Recording()) {
+		const auto result = notifyOrInvoke(receiver, e);
+		Startup::FirstPaintDone();
+		return result;
 	}
 	return notifyOrInvoke(receiver, e);
 }
@@ -588,6 +601,7 @@ void Sandbox::closeApplication() {
 	_localSocket.close();
 
 	_updateChecker = nullptr;
+	_stallDetector = nullptr;
 }
 
 void Sandbox::execExternal(const QString &cmd) {
@@ -12,6 +12,7 @@ namespace Core {
 class Launcher;
 class UpdateChecker;
 class Application;
+class StallDetector;
 
 class Sandbox final
 	: public QApplication
@@ -118,6 +119,7 @@ private:
 	bool _secondInstance = false;
 
 	std::unique_ptr<UpdateChecker> _updateChecker;
+	std::unique_ptr<StallDetector> _stallDetector;
 
 	QByteArray _lastCrashDump;
 	ProxyData _sandboxProxy;
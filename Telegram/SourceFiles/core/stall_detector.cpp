@@ -0,0 +1,121 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/stall_detector.h"
+
+#include <QtCore/QAbstractEventDispatcher>
+
+namespace Core {
+namespace {
+
+constexpr auto kCheckInterval = std::chrono::milliseconds(250);
+constexpr auto kStallThreshold = crl::time(1000);
+
+} // namespace
+
+StallDetector::StallDetector()
+: _activity(crl::now()) {
+	const auto dispatcher = QAbstractEventDispatcher::instance();
+	Assert(dispatcher != nullptr);
+
+	_connections.push_back(QObject::connect(
+		dispatcher,
+		&QAbstractEventDispatcher::aboutToBlock,
+		[=] { wake(true); }));
+	_connections.push_back(QObject::connect(
+		dispatcher,
+		&QAbstractEventDispatcher::awake,
+		[=] { wake(false); }));
+	_thread = std::thread([=] { watch(); });
+}
+
+StallDetector::~StallDetector() {
+	for (const auto &connection : base::take(_connections)) {
+		QObject::disconnect(connection);
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_finished = true;
+	}
+	_finishes.notify_one();
+	_thread.join();
+
+	for (const auto &[signature, stalls] : _stalls) {
+		LOG(("Stall Info: %1 stalls in %2, %3 ms total, %4 ms longest."
+			).arg(stalls.count
+			).arg(signature
+			).arg(stalls.total
+			).arg(stalls.longest));
+	}
+}
+
+void StallDetector::eventStarted(
+		not_null<QObject*> receiver,
+		not_null<QEvent*> e) {
+	_receiver.store(
+		receiver->metaObject()->className(),
+		std::memory_order_relaxed);
+	_eventType.store(int(e->type()), std::memory_order_relaxed);
+	_activity.store(crl::now(), std::memory_order_release);
+}
+
+void StallDetector::wake(bool waiting) {
+	// Native events are processed between awake and the first event.
+	_receiver.store(nullptr, std::memory_order_relaxed);
+	_waiting.store(waiting, std::memory_order_relaxed);
+	_activity.store(crl::now(), std::memory_order_release);
+}
+
+QString StallDetector::signature() const {
+	const auto receiver = _receiver.load(std::memory_order_relaxed);
+	return receiver
+		? QString("%1 (event %2)"
+			).arg(receiver
+			).arg(_eventType.load(std::memory_order_relaxed))
+		: QString("native events");
+}
+
+void StallDetector::watch() {
+	auto lock = std::unique_lock<std::mutex>(_mutex);
+	auto stallStarted = crl::time(0);
+	auto stallSignature = QString();
+	while (!_finishes.wait_for(lock, kCheckInterval, [=] {
+		return _finished;
+	})) {
+		const auto activity = _activity.load(std::memory_order_acquire);
+		if (stallStarted) {
+			if (activity != stallStarted) {
+				finished(stallSignature, activity - stallStarted);
+				stallStarted = 0;
+			}
+			continue;
+		}
+		if (_waiting.load(std::memory_order_relaxed)
+			|| crl::now() - activity < kStallThreshold) {
+			continue;
+		}
+		stallSignature = signature();
+		if (_activity.load(std::memory_order_acquire) != activity) {
+			continue;
+		}
+		stallStarted = activity;
+		LOG(("Stall Info: main thread is busy in %1.").arg(stallSignature));
+	}
+}
+
+void StallDetector::finished(const QString &signature, crl::time duration) {
+	LOG(("Stall Info: main thread was busy for %1 ms in %2."
+		).arg(duration
+		).arg(signature));
+
+	auto &stalls = _stalls[signature];
+	++stalls.count;
+	stalls.total += duration;
+	stalls.longest = std::max(stalls.longest, duration);
+}
+
+} // namespace Core
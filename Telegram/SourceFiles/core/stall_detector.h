@@ -0,0 +1,58 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/flat_map.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Core {
+
+// Watches the main thread from a thread of its own and logs the events
+// that kept the main thread busy for too long, grouped by receiver class.
+class StallDetector final {
+public:
+	StallDetector();
+	StallDetector(const StallDetector &other) = delete;
+	StallDetector &operator=(const StallDetector &other) = delete;
+	~StallDetector();
+
+	// Called on the main thread before each event is delivered.
+	void eventStarted(not_null<QObject*> receiver, not_null<QEvent*> e);
+
+private:
+	struct Stalls {
+		int count = 0;
+		crl::time total = 0;
+		crl::time longest = 0;
+	};
+
+	void wake(bool waiting);
+	void watch();
+	[[nodiscard]] QString signature() const;
+	void finished(const QString &signature, crl::time duration);
+
+	std::atomic<crl::time> _activity = 0;
+	std::atomic<const char*> _receiver = nullptr;
+	std::atomic<int> _eventType = 0;
+	std::atomic<bool> _waiting = false;
+
+	std::mutex _mutex;
+	std::condition_variable _finishes;
+	bool _finished = false;
+	base::flat_map<QString, Stalls> _stalls;
+
+	std::vector<QMetaObject::Connection> _connections;
+	std::thread _thread;
+
+};
+
+} // namespace Core
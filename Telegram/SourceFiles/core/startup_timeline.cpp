@@ -0,0 +1,101 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/startup_timeline.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+
+#include <mutex>
+
+namespace Core {
+namespace Startup {
+namespace details {
+
+std::atomic<bool> RecordingValue = false;
+
+} // namespace details
+namespace {
+
+struct Entry {
+	const char *name = nullptr;
+	quintptr thread = 0;
+	crl::time start = 0;
+	crl::time duration = 0;
+};
+
+std::mutex Mutex;
+std::vector<Entry> Entries;
+crl::time Origin = 0;
+
+void WriteReport(crl::time firstPaint) {
+	auto result = QByteArray("{\"firstPaint\":");
+	result.append(QByteArray::number(qint64(firstPaint)));
+	result.append(",\"phases\":[");
+	auto first = true;
+	for (const auto &entry : Entries) {
+		result.append(first ? "\n" : ",\n");
+		result.append("{\"name\":\"").append(entry.name);
+		result.append("\",\"thread\":");
+		result.append(QByteArray::number(quint64(entry.thread)));
+		result.append(",\"start\":");
+		result.append(QByteArray::number(qint64(entry.start)));
+		result.append(",\"duration\":");
+		result.append(QByteArray::number(qint64(entry.duration)));
+		result.append('}');
+		first = false;
+	}
+	result.append("\n]}\n");
+
+	QFile file(cWorkingDir() + qsl("startup.json"));
+	if (!file.open(QIODevice::WriteOnly)
+		|| file.write(result) != result.size()) {
+		LOG(("Startup Error: Could not write the report."));
+	}
+}
+
+} // namespace
+
+void StartRecording() {
+	Origin = crl::now();
+	details::RecordingValue.store(true, std::memory_order_relaxed);
+}
+
+void FirstPaintDone() {
+	if (!details::RecordingValue.exchange(false)) {
+		return;
+	}
+	const auto firstPaint = crl::now() - Origin;
+	LOG(("Startup: first paint after %1 ms.").arg(firstPaint));
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	WriteReport(firstPaint);
+	Entries.clear();
+}
+
+Phase::Phase(const char *name)
+: _name(Recording() ? name : nullptr)
+, _start(_name ? crl::now() : 0) {
+}
+
+Phase::~Phase() {
+	if (!_name || !Recording()) {
+		return;
+	}
+	const auto duration = crl::now() - _start;
+	LOG(("Startup: %1 took %2 ms.").arg(_name).arg(duration));
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	Entries.push_back({
+		_name,
+		quintptr(QThread::currentThreadId()),
+		_start - Origin,
+		duration });
+}
+
+} // namespace Startup
+} // namespace Core
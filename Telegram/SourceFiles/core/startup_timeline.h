@@ -0,0 +1,46 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+
+namespace Core {
+namespace Startup {
+namespace details {
+
+extern std::atomic<bool> RecordingValue;
+
+} // namespace details
+
+// Starts recording the startup phases, the times are counted from here.
+void StartRecording();
+
+[[nodiscard]] inline bool Recording() {
+	return details::RecordingValue.load(std::memory_order_relaxed);
+}
+
+// Stops recording and writes the report to the working folder.
+void FirstPaintDone();
+
+// Records the time until the end of the current scope.
+// The name must be a string literal, it is stored as a pointer.
+class Phase final {
+public:
+	explicit Phase(const char *name);
+	Phase(const Phase &other) = delete;
+	Phase &operator=(const Phase &other) = delete;
+	~Phase();
+
+private:
+	const char *_name = nullptr;
+	crl::time _start = 0;
+
+};
+
+} // namespace Startup
+} // namespace Core
@@ -26,6 +26,7 @@ extern "C" {
 #include <openssl/pem.h>
 #include <openssl/bio.h>
 #include <openssl/err.h>
+#include <openssl/sha.h>
 } // extern "C"
 
 #ifdef Q_OS_WIN // use Lzma SDK for win
@@ -39,6 +40,7 @@ namespace {
 
 constexpr auto kUpdaterTimeout = 10 * crl::time(1000);
 constexpr auto kMaxResponseSize = 1024 * 1024;
+constexpr auto kUnpackChunkSize = 1024 * 1024;
 
 #ifdef TDESKTOP_DISABLE_AUTOUPDATE
 bool UpdaterIsDisabled = true;
@@ -48,6 +50,9 @@ bool UpdaterIsDisabled = false;
 
 std::weak_ptr<Updater> UpdaterInstance;
 
+// Set when a delta package couldn't be applied to the installed files.
+std::atomic<bool> SkipDeltaUpdates = false;
+
 using ErrorSignal = void(QNetworkReply::*)(QNetworkReply::NetworkError);
 const auto QNetworkReply_error = ErrorSignal(&QNetworkReply::error);
 
@@ -220,7 +225,7 @@ QString FindUpdateFile() {
 			"tmac32upd|"
 			"tlinuxupd|"
 			"tlinux32upd"
-			")\\d+(_[a-z\\d]+)?$",
+			")\\d+(_delta)?(_[a-z\\d]+)?$",
 			QRegularExpression::CaseInsensitiveOption
 		).match(info.fileName()).hasMatch()) {
 			return info.absoluteFilePath();
@@ -239,9 +244,74 @@ QString ExtractFilename(const QString &url) {
 	return QString();
 }
 
+QString InstalledFilePath(const QString &relativeName) {
+#ifdef Q_OS_WIN
+	const auto binary = qsl("Telegram.exe");
+#elif defined Q_OS_MAC // Q_OS_WIN
+	const auto binary = qsl("Telegram.app");
+#else // Q_OS_WIN || Q_OS_MAC
+	const auto binary = qsl("Telegram");
+#endif // Q_OS_WIN || Q_OS_MAC
+	const auto slash = relativeName.indexOf('/');
+	const auto first = (slash >= 0) ? relativeName.mid(0, slash) : relativeName;
+	return cExeDir() + ((first == binary)
+		? (cExeName() + relativeName.mid(first.size()))
+		: relativeName);
+}
+
+std::optional<QByteArray> ApplyDelta(
+		const QString &basePath,
+		const QByteArray &baseSha1,
+		const QByteArray &delta,
+		quint32 resultSize,
+		const QByteArray &resultSha1) {
+	const auto countSha1 = [](const QByteArray &data) {
+		uchar buffer[20];
+		hashSha1(data.constData(), data.size(), buffer);
+		return QByteArray(reinterpret_cast<const char*>(buffer), 20);
+	};
+
+	QFile file(basePath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		LOG(("Update Error: cant read installed file '%1'").arg(basePath));
+		return std::nullopt;
+	}
+	const auto base = file.readAll();
+	file.close();
+	if (countSha1(base) != baseSha1) {
+		LOG(("Update Error: installed file '%1' was changed").arg(basePath));
+		return std::nullopt;
+	}
+
+	auto result = QByteArray();
+	result.reserve(resultSize);
+	QDataStream stream(delta);
+	stream.setVersion(QDataStream::Qt_5_1);
+	while (!stream.atEnd()) {
+		QByteArray inserted;
+		quint32 offset = 0, length = 0;
+		stream >> inserted >> offset >> length;
+		if (stream.status() != QDataStream::Ok
+			|| offset > quint32(base.size())
+			|| length > quint32(base.size()) - offset
+			|| quint32(inserted.size()) + length
+				> resultSize - quint32(result.size())) {
+			LOG(("Update Error: bad delta for '%1'").arg(basePath));
+			return std::nullopt;
+		}
+		result.append(inserted);
+		result.append(base.constData() + offset, length);
+	}
+	if (quint32(result.size()) != resultSize
+		|| countSha1(result) != resultSha1) {
+		LOG(("Update Error: bad delta result for '%1'").arg(basePath));
+		return std::nullopt;
+	}
+	return result;
+}
+
 bool UnpackUpdate(const QString &filepath) {
 	QFile input(filepath);
-	QByteArray packed;
 	if (!input.open(QIODevice::ReadOnly)) {
 		LOG(("Update Error: cant read updates file!"));
 		return false;
@@ -253,13 +323,12 @@ bool UnpackUpdate(const QString &filepath) {
 	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = 0, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hOriginalSizeLen; // header
 #endif // Q_OS_WIN
 
-	QByteArray compressed = input.readAll();
-	int32 compressedLen = compressed.size() - hSize;
-	if (compressedLen <= 0) {
-		LOG(("Update Error: bad compressed size: %1").arg(compressed.size()));
+	const auto header = input.read(hSize);
+	const auto compressedLen = input.size() - hSize;
+	if (header.size() != hSize || compressedLen <= 0) {
+		LOG(("Update Error: bad compressed size: %1").arg(input.size()));
 		return false;
 	}
-	input.close();
 
 	QString tempDirPath = cWorkingDir() + qsl("tupdates/temp"), readyFilePath = cWorkingDir() + qsl("tupdates/temp/ready");
 	psDeleteDir(tempDirPath);
@@ -270,8 +339,23 @@ bool UnpackUpdate(const QString &filepath) {
 		return false;
 	}
 
+	// The package is read by chunks, so that memory usage stays bounded.
+	auto chunk = QByteArray(kUnpackChunkSize, Qt::Uninitialized);
+	auto sha1Context = SHA_CTX();
+	SHA1_Init(&sha1Context);
+	SHA1_Update(&sha1Context, header.constData() + hSigLen + hShaLen, hPropsLen + hOriginalSizeLen);
+	for (auto left = compressedLen; left > 0;) {
+		const auto read = input.read(chunk.data(), std::min(qint64(chunk.size()), left));
+		if (read <= 0) {
+			LOG(("Update Error: cant read updates file!"));
+			return false;
+		}
+		SHA1_Update(&sha1Context, chunk.constData(), read);
+		left -= read;
+	}
 	uchar sha1Buffer[20];
-	bool goodSha1 = !memcmp(compressed.constData() + hSigLen, hashSha1(compressed.constData() + hSigLen + hShaLen, compressedLen + hPropsLen + hOriginalSizeLen, sha1Buffer), hShaLen);
+	SHA1_Final(sha1Buffer, &sha1Context);
+	bool goodSha1 = !memcmp(header.constData() + hSigLen, sha1Buffer, hShaLen);
 	if (!goodSha1) {
 		LOG(("Update Error: bad SHA1 hash of update file!"));
 		return false;
@@ -282,7 +366,7 @@ bool UnpackUpdate(const QString &filepath) {
 		LOG(("Update Error: cant read public rsa key!"));
 		return false;
 	}
-	if (RSA_verify(NID_sha1, (const uchar*)(compressed.constData() + hSigLen), hShaLen, (const uchar*)(compressed.constData()), hSigLen, pbKey) != 1) { // verify signature
+	if (RSA_verify(NID_sha1, (const uchar*)(header.constData() + hSigLen), hShaLen, (const uchar*)(header.constData()), hSigLen, pbKey) != 1) { // verify signature
 		RSA_free(pbKey);
 
 		// try other public key, if we update from beta to stable or vice versa
@@ -291,7 +375,7 @@ bool UnpackUpdate(const QString &filepath) {
 			LOG(("Update Error: cant read public rsa key!"));
 			return false;
 		}
-		if (RSA_verify(NID_sha1, (const uchar*)(compressed.constData() + hSigLen), hShaLen, (const uchar*)(compressed.constData()), hSigLen, pbKey) != 1) { // verify signature
+		if (RSA_verify(NID_sha1, (const uchar*)(header.constData() + hSigLen), hShaLen, (const uchar*)(header.constData()), hSigLen, pbKey) != 1) { // verify signature
 			RSA_free(pbKey);
 			LOG(("Update Error: bad RSA signature of update file!"));
 			return false;
@@ -299,20 +383,43 @@ bool UnpackUpdate(const QString &filepath) {
 	}
 	RSA_free(pbKey);
 
-	QByteArray uncompressed;
-
 	int32 uncompressedLen;
-	memcpy(&uncompressedLen, compressed.constData() + hSigLen + hShaLen + hPropsLen, hOriginalSizeLen);
-	uncompressed.resize(uncompressedLen);
+	memcpy(&uncompressedLen, header.constData() + hSigLen + hShaLen + hPropsLen, hOriginalSizeLen);
 
-	size_t resultLen = uncompressed.size();
-#ifdef Q_OS_WIN // use Lzma SDK for win
-	SizeT srcLen = compressedLen;
-	int uncompressRes = LzmaUncompress((uchar*)uncompressed.data(), &resultLen, (const uchar*)(compressed.constData() + hSize), &srcLen, (const uchar*)(compressed.constData() + hSigLen + hShaLen), LZMA_PROPS_SIZE);
-	if (uncompressRes != SZ_OK) {
-		LOG(("Update Error: could not uncompress lzma, code: %1").arg(uncompressRes));
+	// Files are read from the unpacked stream on disk one by one.
+	QFile unpacked(UpdatesFolder() + qsl("/unpacked"));
+	if (!unpacked.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+		LOG(("Update Error: cant open unpacked file for writing!"));
 		return false;
 	}
+	const auto unpackedGuard = gsl::finally([&] {
+		unpacked.close();
+		unpacked.remove();
+	});
+	if (!input.seek(hSize)) {
+		LOG(("Update Error: cant read updates file!"));
+		return false;
+	}
+
+#ifdef Q_OS_WIN // use Lzma SDK for win
+	{
+		// LzmaLib provides only the whole buffer decoder.
+		const auto compressed = input.readAll();
+		QByteArray uncompressed;
+		uncompressed.resize(uncompressedLen);
+
+		size_t resultLen = uncompressed.size();
+		SizeT srcLen = compressed.size();
+		int uncompressRes = LzmaUncompress((uchar*)uncompressed.data(), &resultLen, (const uchar*)(compressed.constData()), &srcLen, (const uchar*)(header.constData() + hSigLen + hShaLen), LZMA_PROPS_SIZE);
+		if (uncompressRes != SZ_OK) {
+			LOG(("Update Error: could not uncompress lzma, code: %1").arg(uncompressRes));
+			return false;
+		}
+		if (unpacked.write(uncompressed.constData(), resultLen) != qint64(resultLen)) {
+			LOG(("Update Error: cant write unpacked file!"));
+			return false;
+		}
+	}
 #else // Q_OS_WIN
 	lzma_stream stream = LZMA_STREAM_INIT;
 
@@ -329,21 +436,36 @@ bool UnpackUpdate(const QString &filepath) {
 		return false;
 	}
 
-	stream.avail_in = compressedLen;
-	stream.next_in = (uint8_t*)(compressed.constData() + hSize);
-	stream.avail_out = resultLen;
-	stream.next_out = (uint8_t*)uncompressed.data();
-
-	lzma_ret res = lzma_code(&stream, LZMA_FINISH);
-	if (stream.avail_in) {
-		LOG(("Error in decompression, %1 bytes left in _in of %2 whole.").arg(stream.avail_in).arg(compressedLen));
-		return false;
-	} else if (stream.avail_out) {
-		LOG(("Error in decompression, %1 bytes free left in _out of %2 whole.").arg(stream.avail_out).arg(resultLen));
-		return false;
+	auto output = QByteArray(kUnpackChunkSize, Qt::Uninitialized);
+	auto written = qint64(0);
+	auto res = LZMA_OK;
+	for (auto left = compressedLen; res == LZMA_OK;) {
+		if (!stream.avail_in && left > 0) {
+			const auto read = input.read(chunk.data(), std::min(qint64(chunk.size()), left));
+			if (read <= 0) {
+				lzma_end(&stream);
+				LOG(("Update Error: cant read updates file!"));
+				return false;
+			}
+			left -= read;
+			stream.next_in = (const uint8_t*)chunk.constData();
+			stream.avail_in = read;
+		}
+		stream.next_out = (uint8_t*)output.data();
+		stream.avail_out = output.size();
+		res = lzma_code(&stream, left ? LZMA_RUN : LZMA_FINISH);
+
+		const auto produced = qint64(output.size() - stream.avail_out);
+		if (unpacked.write(output.constData(), produced) != produced) {
+			lzma_end(&stream);
+			LOG(("Update Error: cant write unpacked file!"));
+			return false;
+		}
+		written += produced;
 	}
+	const auto leftIn = stream.avail_in;
 	lzma_end(&stream);
-	if (res != LZMA_OK && res != LZMA_STREAM_END) {
+	if (res != LZMA_STREAM_END) {
 		const char *msg;
 		switch (res) {
 		case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
@@ -355,14 +477,27 @@ bool UnpackUpdate(const QString &filepath) {
 		}
 		LOG(("Error in decompression: %1 (error code %2)").arg(msg).arg(res));
 		return false;
+	} else if (leftIn) {
+		LOG(("Error in decompression, %1 bytes left in _in of %2 whole.").arg(leftIn).arg(compressedLen));
+		return false;
+	} else if (written != uncompressedLen) {
+		LOG(("Error in decompression, %1 bytes written of %2 whole.").arg(written).arg(uncompressedLen));
+		return false;
 	}
 #endif // Q_OS_WIN
 
+	chunk = QByteArray();
+	input.close();
+	if (!unpacked.seek(0)) {
+		LOG(("Update Error: cant read unpacked file!"));
+		return false;
+	}
+
 	tempDir.mkdir(tempDir.absolutePath());
 
 	quint32 version;
 	{
-		QDataStream stream(uncompressed);
+		QDataStream stream(&unpacked);
 		stream.setVersion(QDataStream::Qt_5_1);
 
 		stream >> version;
@@ -387,16 +522,41 @@ bool UnpackUpdate(const QString &filepath) {
 			return false;
 		}
 
+		const auto writeFile = [&](
+				const QString &relativeName,
+				const QByteArray &fileInnerData,
+				bool executable) {
+			const auto fileSize = fileInnerData.size();
+			QFile f(tempDirPath + '/' + relativeName);
+			if (!QDir().mkpath(QFileInfo(f).absolutePath())) {
+				LOG(("Update Error: cant mkpath for file '%1'").arg(tempDirPath + '/' + relativeName));
+				return false;
+			}
+			if (!f.open(QIODevice::WriteOnly)) {
+				LOG(("Update Error: cant open file '%1' for writing").arg(tempDirPath + '/' + relativeName));
+				return false;
+			}
+			auto writtenBytes = f.write(fileInnerData);
+			if (writtenBytes != fileSize) {
+				f.close();
+				LOG(("Update Error: cant write file '%1', desiredSize: %2, write result: %3").arg(tempDirPath + '/' + relativeName).arg(fileSize).arg(writtenBytes));
+				return false;
+			}
+			f.close();
+			if (executable) {
+				QFileDevice::Permissions p = f.permissions();
+				p |= QFileDevice::ExeOwner | QFileDevice::ExeUser | QFileDevice::ExeGroup | QFileDevice::ExeOther;
+				f.setPermissions(p);
+			}
+			return true;
+		};
+
 		quint32 filesCount;
 		stream >> filesCount;
 		if (stream.status() != QDataStream::Ok) {
 			LOG(("Update Error: cant read files count from downloaded stream, status: %1").arg(stream.status()));
 			return false;
 		}
-		if (!filesCount) {
-			LOG(("Update Error: update is empty!"));
-			return false;
-		}
 		for (uint32 i = 0; i < filesCount; ++i) {
 			QString relativeName;
 			quint32 fileSize;
@@ -415,29 +575,52 @@ bool UnpackUpdate(const QString &filepath) {
 				LOG(("Update Error: bad file size %1 not matching data size %2").arg(fileSize).arg(fileInnerData.size()));
 				return false;
 			}
-
-			QFile f(tempDirPath + '/' + relativeName);
-			if (!QDir().mkpath(QFileInfo(f).absolutePath())) {
-				LOG(("Update Error: cant mkpath for file '%1'").arg(tempDirPath + '/' + relativeName));
+			if (!writeFile(relativeName, fileInnerData, executable)) {
 				return false;
 			}
-			if (!f.open(QIODevice::WriteOnly)) {
-				LOG(("Update Error: cant open file '%1' for writing").arg(tempDirPath + '/' + relativeName));
+		}
+
+		// Delta packages carry patches against the installed files.
+		quint32 deltaCount = 0;
+		if (!stream.atEnd()) {
+			stream >> deltaCount;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: cant read delta count from downloaded stream, status: %1").arg(stream.status()));
 				return false;
 			}
-			auto writtenBytes = f.write(fileInnerData);
-			if (writtenBytes != fileSize) {
-				f.close();
-				LOG(("Update Error: cant write file '%1', desiredSize: %2, write result: %3").arg(tempDirPath + '/' + relativeName).arg(fileSize).arg(writtenBytes));
+		}
+		for (uint32 i = 0; i < deltaCount; ++i) {
+			QString relativeName;
+			QByteArray baseSha1, delta, resultSha1;
+			quint32 fileSize;
+			bool executable = false;
+
+			stream >> relativeName >> baseSha1 >> fileSize >> delta >> resultSha1;
+#if defined Q_OS_MAC || defined Q_OS_LINUX
+			stream >> executable;
+#endif // Q_OS_MAC || Q_OS_LINUX
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: cant read delta from downloaded stream, status: %1").arg(stream.status()));
 				return false;
 			}
-			f.close();
-			if (executable) {
-				QFileDevice::Permissions p = f.permissions();
-				p |= QFileDevice::ExeOwner | QFileDevice::ExeUser | QFileDevice::ExeGroup | QFileDevice::ExeOther;
-				f.setPermissions(p);
+			const auto result = ApplyDelta(
+				InstalledFilePath(relativeName),
+				baseSha1,
+				delta,
+				fileSize,
+				resultSha1);
+			if (!result) {
+				LOG(("Update Error: cant apply delta to '%1'").arg(relativeName));
+				SkipDeltaUpdates = true;
+				return false;
+			} else if (!writeFile(relativeName, *result, executable)) {
+				return false;
 			}
 		}
+		if (!filesCount && !deltaCount) {
+			LOG(("Update Error: update is empty!"));
+			return false;
+		}
 
 		// create tdata/version file
 		tempDir.mkdir(QDir(tempDirPath + qsl("/tdata")).absolutePath());
@@ -480,6 +663,30 @@ bool UnpackUpdate(const QString &filepath) {
 	return true;
 }
 
+// Delta packages are listed by the installed version they apply to.
+std::optional<QString> FindDeltaEntry(
+		const QJsonObject &map,
+		bool testing) {
+	if (SkipDeltaUpdates) {
+		return std::nullopt;
+	}
+	const auto deltas = map.constFind(testing
+		? "testing_delta"
+		: "released_delta");
+	if (deltas == map.constEnd() || !(*deltas).isObject()) {
+		return std::nullopt;
+	}
+	const auto installed = cAlphaVersion()
+		? cAlphaVersion()
+		: uint64(AppVersion);
+	const auto list = (*deltas).toObject();
+	const auto entry = list.constFind(QString::number(installed));
+	if (entry == list.constEnd() || !(*entry).isString()) {
+		return std::nullopt;
+	}
+	return (*entry).toString();
+}
+
 template <typename Callback>
 bool ParseCommonMap(
 		const QByteArray &json,
@@ -720,7 +927,8 @@ std::optional<QString> HttpChecker::parseResponse(
 				).arg(version));
 			return false;
 		}
-		bestLink = (*link).toString();
+		bestLink = FindDeltaEntry(map, testing()).value_or(
+			(*link).toString());
 		return true;
 	};
 	const auto result = ParseCommonMap(response, testing(), accumulate);
@@ -965,7 +1173,8 @@ auto MtpChecker::parseText(const QByteArray &text) const
 				).arg(version));
 			return false;
 		}
-		const auto full = (*entry).toString();
+		const auto full = FindDeltaEntry(map, testing()).value_or(
+			(*entry).toString());
 		const auto start = full.indexOf(':');
 		const auto post = full.indexOf('#');
 		if (start <= 0 || post < start) {
@@ -1060,7 +1269,7 @@ private:
 	void checkerFail(not_null<Implementation*> which);
 
 	void finalize(QString filepath);
-	void unpackDone(bool ready);
+	void unpackDone(bool ready, bool retryFull);
 	void handleChecking();
 	void handleProgress();
 	void handleLatest();
@@ -1227,9 +1436,12 @@ void Updater::start(bool forceWait) {
 		startImplementation(
 			&_httpImplementation,
 			std::make_unique<HttpChecker>(_testing));
+		// With a mirror all packages are loaded from it.
 		startImplementation(
 			&_mtpImplementation,
-			std::make_unique<MtpChecker>(_mtproto, _testing));
+			(cUpdatesMirror().isEmpty()
+				? std::make_unique<MtpChecker>(_mtproto, _testing)
+				: nullptr));
 
 		_checking.fire({});
 	} else {
@@ -1368,16 +1580,24 @@ void Updater::finalize(QString filepath) {
 	_activeLoader = nullptr;
 	_action = Action::Unpacking;
 	crl::async([=] {
+		const auto skippedDelta = SkipDeltaUpdates.load();
 		const auto ready = UnpackUpdate(filepath);
+		const auto retryFull = !ready && !skippedDelta && SkipDeltaUpdates;
 		crl::on_main([=] {
-			GetUpdaterInstance()->unpackDone(ready);
+			GetUpdaterInstance()->unpackDone(ready, retryFull);
 		});
 	});
 }
 
-void Updater::unpackDone(bool ready) {
+void Updater::unpackDone(bool ready, bool retryFull) {
 	if (ready) {
 		_ready.fire({});
+	} else if (retryFull) {
+		LOG(("Update Info: delta failed, requesting the full package."));
+		ClearAll();
+		stop();
+		cSetLastUpdateCheck(0);
+		start(false);
 	} else {
 		ClearAll();
 		_failed.fire({});
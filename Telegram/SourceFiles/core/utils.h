@@ -240,6 +240,12 @@ enum DBIWorkMode {
 	dbiwmWindowOnly = 2,
 };
 
+enum DBICallJitterPreset {
+	dbicjDefault = 0,
+	dbicjLowLatency = 1,
+	dbicjStable = 2,
+};
+
 struct ProxyData {
 	enum class Settings {
 		System,
@@ -43,6 +43,7 @@ using FilePathResolve = DocumentData::FilePathResolve;
 
 Core::MediaActiveCache<DocumentData> &ActiveCache() {
 	static auto Instance = Core::MediaActiveCache<DocumentData>(
+		"Documents",
 		kMemoryForCache,
 		[](DocumentData *document) { document->unload(); });
 	return Instance;
@@ -922,8 +923,18 @@ void DocumentData::save(
 		}
 	} else {
 		status = FileReady;
-		auto reader = owner().documentStreamedReader(this, origin, true);
-		if (reader) {
+		auto resumed = toFile.isEmpty()
+			? nullptr
+			: session().downloader().takeResumedLoader(mediaKey(), toFile);
+		auto reader = resumed
+			? nullptr
+			: owner().documentStreamedReader(this, origin, true);
+		if (resumed) {
+			_loader = std::move(resumed);
+			if (fromCloud == LoadFromCloudOrLocal) {
+				_loader->permitLoadFromCloud();
+			}
+		} else if (reader) {
 			_loader = std::make_unique<Storage::StreamedFileDownloader>(
 				id,
 				_dc,
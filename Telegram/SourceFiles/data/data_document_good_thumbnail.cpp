@@ -19,6 +19,8 @@ namespace {
 
 constexpr auto kGoodThumbQuality = 87;
 constexpr auto kWallPaperSize = 960;
+constexpr auto kMaxGeneratingCount = 2;
+constexpr auto kGenerationStaleTimeout = crl::time(1000);
 
 enum class FileType {
 	Video,
@@ -62,6 +64,70 @@ QImage Prepare(
 		: result;
 }
 
+struct Generation {
+	not_null<const void*> owner;
+	base::binary_guard guard;
+	crl::time requested = 0;
+	FnMut<void(base::binary_guard &&guard)> start;
+};
+
+// Generations are started from the main thread only.
+auto Generating = 0;
+std::vector<Generation> Queued;
+
+void StartGenerations() {
+	// Owners that were not painted for a while are out of view,
+	// they will request the thumbnail again when they are painted.
+	const auto now = crl::now();
+	for (auto &generation : Queued) {
+		if (now - generation.requested > kGenerationStaleTimeout) {
+			generation.guard = nullptr;
+		}
+	}
+	const auto dead = [](const Generation &generation) {
+		return !generation.guard.alive();
+	};
+	Queued.erase(ranges::remove_if(Queued, dead), end(Queued));
+
+	// The most recently requested owners are the visible ones.
+	while (Generating < kMaxGeneratingCount && !Queued.empty()) {
+		const auto i = ranges::max_element(
+			Queued,
+			ranges::less(),
+			&Generation::requested);
+		auto generation = std::move(*i);
+		Queued.erase(i);
+		++Generating;
+		generation.start(std::move(generation.guard));
+	}
+}
+
+void EnqueueGeneration(
+		not_null<const void*> owner,
+		base::binary_guard &&guard,
+		FnMut<void(base::binary_guard &&guard)> start) {
+	Queued.push_back({
+		owner,
+		std::move(guard),
+		crl::now(),
+		std::move(start) });
+	StartGenerations();
+}
+
+void RefreshGeneration(not_null<const void*> owner) {
+	for (auto &generation : Queued) {
+		if (generation.owner == owner && generation.guard.alive()) {
+			generation.requested = crl::now();
+			return;
+		}
+	}
+}
+
+void GenerationFinished() {
+	--Generating;
+	StartGenerations();
+}
+
 } // namespace
 
 GoodThumbSource::GoodThumbSource(not_null<DocumentData*> document)
@@ -85,35 +151,45 @@ void GoodThumbSource::generate(base::binary_guard &&guard) {
 		_empty = true;
 		return;
 	}
-	crl::async([
-		=,
-		guard = std::move(guard),
-		location = std::move(location)
-	]() mutable {
-		const auto filepath = (location && location->accessEnable())
-			? location->name()
-			: QString();
-		auto result = Prepare(filepath, data, type);
-		auto bytes = QByteArray();
-		if (!result.isNull()) {
-			auto buffer = QBuffer(&bytes);
-			const auto format = (type == FileType::AnimatedSticker)
-				? "WEBP"
-				: (type == FileType::WallPaper && result.hasAlphaChannel())
-				? "PNG"
-				: "JPG";
-			result.save(&buffer, format, kGoodThumbQuality);
-		}
-		if (!filepath.isEmpty()) {
-			location->accessDisable();
-		}
-		const auto bytesSize = bytes.size();
-		ready(
-			std::move(guard),
-			std::move(result),
-			bytesSize,
-			std::move(bytes));
-	});
+	auto start = [=, location = std::move(location)](
+			base::binary_guard &&guard) mutable {
+		crl::async([
+			=,
+			guard = std::move(guard),
+			location = std::move(location)
+		]() mutable {
+			const auto finished = gsl::finally([] {
+				crl::on_main(GenerationFinished);
+			});
+			if (!guard) {
+				return;
+			}
+			const auto filepath = (location && location->accessEnable())
+				? location->name()
+				: QString();
+			auto result = Prepare(filepath, data, type);
+			auto bytes = QByteArray();
+			if (!result.isNull() && guard) {
+				auto buffer = QBuffer(&bytes);
+				const auto format = (type == FileType::AnimatedSticker)
+					? "WEBP"
+					: (type == FileType::WallPaper && result.hasAlphaChannel())
+					? "PNG"
+					: "JPG";
+				result.save(&buffer, format, kGoodThumbQuality);
+			}
+			if (!filepath.isEmpty()) {
+				location->accessDisable();
+			}
+			const auto bytesSize = bytes.size();
+			ready(
+				std::move(guard),
+				std::move(result),
+				bytesSize,
+				std::move(bytes));
+		});
+	};
+	EnqueueGeneration(this, std::move(guard), std::move(start));
 }
 
 // NB: This method is called from crl::async(), 'this' is unreliable.
@@ -147,7 +223,10 @@ void GoodThumbSource::ready(
 }
 
 void GoodThumbSource::load(Data::FileOrigin origin) {
-	if (loading() || _empty) {
+	if (loading()) {
+		RefreshGeneration(this);
+		return;
+	} else if (_empty) {
 		return;
 	}
 	auto callback = [=, guard = _loading.make_guard()](
@@ -38,7 +38,7 @@ void Groups::registerMessage(not_null<HistoryItem*> item) {
 	if (items.size() < kMaxItemsInGroup) {
 		items.insert(findPositionForItem(items, item), item);
 		if (items.size() > 1) {
-			refreshViews(items);
+			refreshViewsDelayed(item->groupId());
 		}
 	}
 }
@@ -56,7 +56,7 @@ void Groups::unregisterMessage(not_null<const HistoryItem*> item) {
 		if (removed != last) {
 			items.erase(removed, last);
 			if (!items.empty()) {
-				refreshViews(items);
+				refreshViews(groupId);
 			} else {
 				_groups.erase(i);
 			}
@@ -83,7 +83,7 @@ void Groups::refreshMessage(
 	auto &items = i->second.items;
 
 	if (justRefreshViews) {
-		refreshViews(items);
+		refreshViews(groupId);
 		return;
 	}
 
@@ -104,7 +104,7 @@ void Groups::refreshMessage(
 	} else {
 		Unexpected("Position of item in Groups::refreshMessage().");
 	}
-	refreshViews(items);
+	refreshViews(groupId);
 }
 
 HistoryItemsList::const_iterator Groups::findPositionForItem(
@@ -139,9 +139,31 @@ const Group *Groups::find(not_null<HistoryItem*> item) const {
 	return nullptr;
 }
 
-void Groups::refreshViews(const HistoryItemsList &items) {
-	for (const auto item : items) {
-		_data->requestItemViewRefresh(item);
+void Groups::refreshViews(MessageGroupId groupId) {
+	_pendingRefresh.remove(groupId);
+	const auto i = _groups.find(groupId);
+	if (i != end(_groups)) {
+		for (const auto item : i->second.items) {
+			_data->requestItemViewRefresh(item);
+		}
+	}
+}
+
+void Groups::refreshViewsDelayed(MessageGroupId groupId) {
+	// The views of the old items stay valid until the refresh,
+	// so a whole album arriving in one slice is laid out once.
+	if (_pendingRefresh.empty()) {
+		crl::on_main(this, [=] {
+			refreshPendingViews();
+		});
+	}
+	_pendingRefresh.emplace(groupId);
+}
+
+void Groups::refreshPendingViews() {
+	const auto groupIds = base::take(_pendingRefresh);
+	for (const auto groupId : groupIds) {
+		refreshViews(groupId);
 	}
 }
 
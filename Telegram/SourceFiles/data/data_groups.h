@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "data/data_types.h"
+#include "base/weak_ptr.h"
 
 namespace Data {
 
@@ -18,7 +19,7 @@ struct Group {
 
 };
 
-class Groups {
+class Groups final : public base::has_weak_ptr {
 public:
 	Groups(not_null<Session*> data);
 
@@ -35,12 +36,17 @@ private:
 	HistoryItemsList::const_iterator findPositionForItem(
 		const HistoryItemsList &group,
 		not_null<HistoryItem*> item);
-	void refreshViews(const HistoryItemsList &items);
+	void refreshViews(MessageGroupId groupId);
+	void refreshViewsDelayed(MessageGroupId groupId);
+	void refreshPendingViews();
 
 	not_null<Session*> _data;
 	std::map<MessageGroupId, Group> _groups;
 	std::map<MessageGroupId, MessageGroupId> _alias;
 
+	// Albums that got new items in this event loop iteration.
+	base::flat_set<MessageGroupId> _pendingRefresh;
+
 };
 
 } // namespace Data
@@ -162,7 +162,9 @@ void PeerData::updateNameDelayed(
 	}
 	fillNames();
 	if (update.flags) {
-		Notify::PeerUpdated().notify(update, true);
+		// Merged with other updates of this peer until the queued pass,
+		// so a peer renamed several times in a row is reindexed once.
+		Notify::peerUpdatedDelayed(update);
 	}
 }
 
@@ -46,6 +46,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_game.h"
 #include "data/data_poll.h"
 #include "base/unixtime.h"
+#include "base/tracing.h"
 #include "styles/style_boxes.h" // st::backgroundSize
 
 namespace Data {
@@ -802,6 +803,50 @@ History *Session::historyLoaded(const PeerData *peer) {
 	return peer ? historyLoaded(peer->id) : nullptr;
 }
 
+void Session::historyShown(not_null<History*> history) {
+	const auto i = ranges::find(_shownHistories, history);
+	if (i != end(_shownHistories)) {
+		_shownHistories.erase(i);
+	}
+	_shownHistories.push_back(history);
+	if (!_unloadColdHistoriesScheduled) {
+		_unloadColdHistoriesScheduled = true;
+		crl::on_main(_session, [=] { unloadColdHistories(); });
+	}
+}
+
+void Session::unloadColdHistories() {
+	_unloadColdHistoriesScheduled = false;
+	if (_shownHistories.empty()) {
+		return;
+	}
+	const auto limit = _session->settings().loadedMessagesLimit();
+	const auto loaded = [&](not_null<History*> history) {
+		const auto migrated = history->migrateFrom();
+		return history->loadedMessagesCount()
+			+ (migrated ? migrated->loadedMessagesCount() : 0);
+	};
+
+	// The last shown history may be still displayed, it is never unloaded.
+	auto total = loaded(_shownHistories.back());
+	auto i = end(_shownHistories) - 1;
+	while (i != begin(_shownHistories)) {
+		const auto history = *--i;
+		const auto count = loaded(history);
+		if (!count) {
+			i = _shownHistories.erase(i);
+		} else if (total + count > limit) {
+			if (const auto migrated = history->migrateFrom()) {
+				migrated->unloadCold();
+			}
+			history->unloadCold();
+			i = _shownHistories.erase(i);
+		} else {
+			total += count;
+		}
+	}
+}
+
 void Session::deleteConversationLocally(not_null<PeerData*> peer) {
 	const auto history = historyLoaded(peer);
 	if (history) {
@@ -1717,6 +1762,7 @@ void Session::updateEditedMessage(const MTPMessage &data) {
 void Session::processMessages(
 		const QVector<MTPMessage> &data,
 		NewMessageType type) {
+	TRACE_ZONE("Data::Session::processMessages");
 	auto indices = base::flat_map<uint64, int>();
 	for (int i = 0, l = data.size(); i != l; ++i) {
 		const auto &message = data[i];
@@ -142,6 +142,10 @@ public:
 
 	void deleteConversationLocally(not_null<PeerData*> peer);
 
+	// Unloads the least recently shown histories beyond the limit
+	// of loaded messages from settings.
+	void historyShown(not_null<History*> history);
+
 	void registerSendAction(
 		not_null<History*> history,
 		not_null<UserData*> user,
@@ -597,6 +601,7 @@ public:
 	void notifyPollUpdateDelayed(not_null<PollData*> poll);
 	bool hasPendingWebPageGamePollNotification() const;
 	void sendWebPageGamePollNotifications();
+	void unloadColdHistories();
 
 	void stopAutoplayAnimations();
 
@@ -961,6 +966,8 @@ private:
 
 	std::unordered_map<PeerId, std::unique_ptr<PeerData>> _peers;
 	std::unordered_map<PeerId, std::unique_ptr<History>> _histories;
+	std::vector<not_null<History*>> _shownHistories; // Oldest first.
+	bool _unloadColdHistoriesScheduled = false;
 
 	MessageIdsList _mimeForwardIds;
 
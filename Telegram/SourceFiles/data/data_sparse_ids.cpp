@@ -205,13 +205,40 @@ bool SparseIdsSliceBuilder::applyUpdate(
 	auto skippedAfter = (update.range.till == ServerMaxMsgId)
 		? 0
 		: std::optional<int> {};
+	if (!needMergeMessages) {
+		mergeSliceData(
+			update.count,
+			base::flat_set<MsgId> {},
+			skippedBefore,
+			skippedAfter);
+		return true;
+	}
+
+	// The storage sends its whole loaded slice, that can be very large.
+	// Only the ids around the key would survive sliceToLimits() anyway.
+	const auto &messages = *update.messages;
+	const auto around = ranges::lower_bound(messages, _key);
+	const auto from = (around - begin(messages) > _limitBefore)
+		? (around - _limitBefore)
+		: begin(messages);
+	const auto till = (end(messages) - around > _limitAfter + 1)
+		? (around + _limitAfter + 1)
+		: end(messages);
+	if (!_key
+		|| from == till
+		|| (from == begin(messages) && till == end(messages))) {
+		mergeSliceData(
+			update.count,
+			messages,
+			skippedBefore,
+			skippedAfter);
+		return true;
+	}
 	mergeSliceData(
 		update.count,
-		needMergeMessages
-			? *update.messages
-			: base::flat_set<MsgId> {},
-		skippedBefore,
-		skippedAfter);
+		base::flat_set<MsgId>(from, till),
+		skippedBefore | func::add(int(from - begin(messages))),
+		skippedAfter | func::add(int(end(messages) - till)));
 	return true;
 }
 
@@ -14,6 +14,9 @@ public:
 	BotCommand(const QString &command, const QString &description);
 
 	bool setDescription(const QString &description);
+	const QString &description() const {
+		return _description;
+	}
 	const Ui::Text::String &descriptionText() const;
 
 	QString command;
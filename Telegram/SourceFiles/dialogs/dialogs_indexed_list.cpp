@@ -12,6 +12,47 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+// Name words are sorted, so all the words starting with the given one
+// follow it right away.
+[[nodiscard]] bool HasWordStartingWith(
+		const base::flat_set<QString> &nameWords,
+		const QString &word) {
+	const auto i = std::lower_bound(
+		nameWords.begin(),
+		nameWords.end(),
+		word);
+	return (i != nameWords.end()) && i->startsWith(word);
+}
+
+template <typename Rows>
+[[nodiscard]] std::vector<not_null<Row*>> FilterRows(
+		const Rows &rows,
+		const QStringList &words) {
+	auto result = std::vector<not_null<Row*>>();
+	for (const auto row : rows) {
+		const auto &nameWords = row->entry()->chatListNameWords();
+		const auto allFound = ranges::all_of(words, [&](
+				const QString &word) {
+			return HasWordStartingWith(nameWords, word);
+		});
+		if (allFound) {
+			result.push_back(row);
+		}
+	}
+	return result;
+}
+
+[[nodiscard]] std::vector<not_null<Row*>> FilterRows(
+		const List *rows,
+		const QStringList &words) {
+	return rows
+		? FilterRows(*rows, words)
+		: std::vector<not_null<Row*>>();
+}
+
+} // namespace
 
 IndexedList::IndexedList(SortMode sortMode)
 : _sortMode(sortMode)
@@ -20,6 +61,7 @@ IndexedList::IndexedList(SortMode sortMode)
 }
 
 RowsByLetter IndexedList::addToEnd(Key key) {
+	invalidateFilterCache();
 	RowsByLetter result;
 	if (!_list.contains(key)) {
 		result.emplace(0, _list.addToEnd(key));
@@ -35,6 +77,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 }
 
 Row *IndexedList::addByName(Key key) {
+	invalidateFilterCache();
 	if (const auto row = _list.getRow(key)) {
 		return row;
 	}
@@ -51,6 +94,7 @@ Row *IndexedList::addByName(Key key) {
 }
 
 void IndexedList::adjustByDate(const RowsByLetter &links) {
+	invalidateFilterCache();
 	for (const auto [ch, row] : links) {
 		if (ch == QChar(0)) {
 			_list.adjustByDate(row);
@@ -63,6 +107,7 @@ void IndexedList::adjustByDate(const RowsByLetter &links) {
 }
 
 void IndexedList::moveToTop(Key key) {
+	invalidateFilterCache();
 	if (_list.moveToTop(key)) {
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
@@ -91,6 +136,8 @@ void IndexedList::peerNameChanged(
 		const base::flat_set<QChar> &oldLetters) {
 	Expects(_sortMode != SortMode::Date);
 
+	invalidateFilterCache();
+
 	if (const auto history = peer->owner().historyLoaded(peer)) {
 		if (_sortMode == SortMode::Name) {
 			adjustByName(history, oldLetters);
@@ -106,6 +153,8 @@ void IndexedList::peerNameChanged(
 		const base::flat_set<QChar> &oldLetters) {
 	Expects(_sortMode == SortMode::Date);
 
+	invalidateFilterCache();
+
 	if (const auto history = peer->owner().historyLoaded(peer)) {
 		adjustNames(list, history, oldLetters);
 	}
@@ -187,6 +236,7 @@ void IndexedList::adjustNames(
 }
 
 void IndexedList::del(Key key, Row *replacedBy) {
+	invalidateFilterCache();
 	if (_list.del(key, replacedBy)) {
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
@@ -197,54 +247,53 @@ void IndexedList::del(Key key, Row *replacedBy) {
 }
 
 void IndexedList::clear() {
+	invalidateFilterCache();
 	_index.clear();
 }
 
 std::vector<not_null<Row*>> IndexedList::filtered(
 		const QStringList &words) const {
-	const auto minimal = [&]() -> const Dialogs::List* {
-		if (empty()) {
-			return nullptr;
+	const auto narrows = [&] {
+		if (!_filterCache) {
+			return false;
 		}
-		auto result = (const Dialogs::List*)nullptr;
-		for (const auto &word : words) {
-			if (word.isEmpty()) {
+		auto checked = false;
+		for (const auto &previous : _filterCache->words) {
+			if (previous.isEmpty()) {
 				continue;
 			}
-			const auto found = filtered(word[0]);
-			if (!found || found->empty()) {
-				return nullptr;
-			} else if (!result || result->size() > found->size()) {
-				result = found;
+			checked = true;
+			const auto extended = ranges::find_if(words, [&](
+					const QString &word) {
+				return word.startsWith(previous);
+			});
+			if (extended == end(words)) {
+				return false;
 			}
 		}
-		return result;
+		return checked;
 	}();
-	auto result = std::vector<not_null<Row*>>();
-	if (!minimal || minimal->empty()) {
-		return result;
+	auto result = narrows
+		? FilterRows(_filterCache->rows, words)
+		: FilterRows(minimalFor(words), words);
+	_filterCache = FilterCache{ words, result };
+	return result;
+}
+
+const List *IndexedList::minimalFor(const QStringList &words) const {
+	if (empty()) {
+		return nullptr;
 	}
-	result.reserve(minimal->size());
-	for (const auto row : *minimal) {
-		const auto &nameWords = row->entry()->chatListNameWords();
-		const auto found = [&](const QString &word) {
-			for (const auto &name : nameWords) {
-				if (name.startsWith(word)) {
-					return true;
-				}
-			}
-			return false;
-		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
-			}
-			return true;
-		}();
-		if (allFound) {
-			result.push_back(row);
+	auto result = (const List*)nullptr;
+	for (const auto &word : words) {
+		if (word.isEmpty()) {
+			continue;
+		}
+		const auto found = filtered(word[0]);
+		if (!found || found->empty()) {
+			return nullptr;
+		} else if (!result || result->size() > found->size()) {
+			result = found;
 		}
 	}
 	return result;
@@ -74,6 +74,8 @@ public:
 	iterator find(int y, int h) { return all().find(y, h); }
 
 private:
+	[[nodiscard]] const List *minimalFor(const QStringList &words) const;
+
 	void adjustByName(
 		Key key,
 		const base::flat_set<QChar> &oldChars);
@@ -82,9 +84,20 @@ private:
 		not_null<History*> history,
 		const base::flat_set<QChar> &oldChars);
 
+	// Typing in the search field makes each query narrow the previous
+	// one, so its results are filtered instead of the whole letter list.
+	struct FilterCache {
+		QStringList words;
+		std::vector<not_null<Row*>> rows;
+	};
+	void invalidateFilterCache() {
+		_filterCache = std::nullopt;
+	}
+
 	SortMode _sortMode = SortMode();
 	List _list, _empty;
 	base::flat_map<QChar, List> _index;
+	mutable std::optional<FilterCache> _filterCache;
 
 };
 
@@ -14,6 +14,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 //#include "history/feed/history_feed_section.h" // #feed
 #include "history/history.h"
 #include "history/history_item.h"
+#include "history/view/history_view_element.h"
 #include "core/shortcuts.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
@@ -220,8 +221,7 @@ InnerWidget::InnerWidget(
 			this->update();
 		}
 		if (update.flags & (UpdateFlag::PhotoChanged | UpdateFlag::UserOccupiedChanged)) {
-			this->update();
-			emit App::main()->dialogsUpdated();
+			_peerPhotosChanged = true;
 		}
 		if (update.flags & UpdateFlag::UserIsContact) {
 			if (update.peer->isUser()) {
@@ -236,6 +236,16 @@ InnerWidget::InnerWidget(
 		}
 	}));
 
+	Notify::PeerUpdatesSent(
+	) | rpl::filter([=] {
+		return base::take(_peerPhotosChanged);
+	}) | rpl::start_with_next([=] {
+		// Many photos may change in one big update, the visible
+		// userpics are loaded here only once for all of them.
+		this->update();
+		emit App::main()->dialogsUpdated();
+	}, lifetime());
+
 	_controller->activeChatEntryValue(
 	) | rpl::combine_previous(
 	) | rpl::start_with_next([=](
@@ -2075,6 +2085,59 @@ bool InnerWidget::searchReceived(
 	return lastDateFound != 0;
 }
 
+void InnerWidget::searchInLoaded(const QString &query) {
+	const auto history = _searchInChat.history();
+	if (!history) {
+		return;
+	}
+	const auto words = TextUtilities::PrepareSearchWords(query);
+	if (words.isEmpty() && !_searchFromUser) {
+		return;
+	}
+	const auto matches = [&](not_null<HistoryItem*> item) {
+		if (item->serviceMsg()
+			|| (_searchFromUser && item->from() != _searchFromUser)) {
+			return false;
+		} else if (words.isEmpty()) {
+			return true;
+		}
+		const auto text = item->rawText();
+		if (text.isEmpty()) {
+			return false;
+		}
+		const auto textWords = TextUtilities::PrepareSearchWords(text);
+		return ranges::all_of(words, [&](const QString &word) {
+			return ranges::any_of(textWords, [&](const QString &textWord) {
+				return textWord.startsWith(word);
+			});
+		});
+	};
+
+	clearSearchResults(false);
+	const auto collect = [&](not_null<History*> history) {
+		for (auto i = history->blocks.rbegin(); i != history->blocks.rend(); ++i) {
+			const auto &messages = (*i)->messages;
+			for (auto j = messages.rbegin(); j != messages.rend(); ++j) {
+				if (_searchResults.size() == SearchPerPage) {
+					return;
+				}
+				const auto item = (*j)->data();
+				if (matches(item)) {
+					_searchResults.push_back(
+						std::make_unique<FakeRow>(_searchInChat, item));
+				}
+			}
+		}
+	};
+	collect(history);
+	if (_searchInMigrated) {
+		collect(_searchInMigrated);
+	}
+	_searchedCount = int(_searchResults.size());
+
+	refresh();
+}
+
 void InnerWidget::peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
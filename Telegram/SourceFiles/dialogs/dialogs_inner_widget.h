@@ -73,6 +73,11 @@ public:
 		HistoryItem *inject,
 		SearchRequestType type,
 		int fullCount);
+
+	// Shows the matching messages of the searched chat loaded in memory,
+	// until the search results from the server arrive.
+	void searchInLoaded(const QString &query);
+
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -309,6 +314,7 @@ private:
 
 	Mode _mode = Mode();
 	bool _mouseSelection = false;
+	bool _peerPhotosChanged = false;
 	std::optional<QPoint> _lastMousePosition;
 	Qt::MouseButton _pressButton = Qt::LeftButton;
 
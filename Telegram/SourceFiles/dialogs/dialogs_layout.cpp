@@ -246,7 +246,20 @@ void paintRow(
 	p.fillRect(fullRect, bg);
 	row->paintRipple(p, 0, 0, fullWidth, &ripple->c);
 
-	if (flags & Flag::SavedMessages) {
+	// Typing and online animations update only a part of the row,
+	// the parts outside of the clip are not painted at all.
+	const auto clip = p.hasClipping()
+		? p.clipBoundingRect().toAlignedRect()
+		: fullRect;
+	const auto paints = [&](QRect rect) {
+		return clip.intersects(rtlrect(rect, fullWidth));
+	};
+
+	auto nameleft = st::dialogsPadding.x()
+		+ st::dialogsPhotoSize
+		+ st::dialogsPhotoPadding;
+	if (!paints(QRect(0, 0, nameleft, st::dialogsRowHeight))) {
+	} else if (flags & Flag::SavedMessages) {
 		Ui::EmptyUserpic::PaintSavedMessages(
 			p,
 			st::dialogsPadding.x(),
@@ -276,9 +289,6 @@ void paintRow(
 			st::dialogsPhotoSize);
 	}
 
-	auto nameleft = st::dialogsPadding.x()
-		+ st::dialogsPhotoSize
-		+ st::dialogsPhotoPadding;
 	if (fullWidth <= nameleft) {
 		if (!draft && item && !item->isEmpty()) {
 			paintCounterCallback();
@@ -364,7 +374,14 @@ void paintRow(
 			PaintRowDate(p, date, rectForName, active, selected);
 		}
 
-		paintItemCallback(nameleft, namewidth);
+		const auto textRect = QRect(
+			nameleft,
+			texttop,
+			fullWidth - nameleft,
+			st::dialogsRowHeight - texttop);
+		if (paints(textRect)) {
+			paintItemCallback(nameleft, namewidth);
+		}
 	} else if (entry->isPinnedDialog() && !entry->fixedOnTopIndex()) {
 		auto availableWidth = namewidth;
 		auto &icon = (active ? st::dialogsPinnedIconActive : (selected ? st::dialogsPinnedIconOver : st::dialogsPinnedIcon));
@@ -408,7 +425,8 @@ void paintRow(
 		sendStateIcon->paint(p, rectForName.topLeft() + QPoint(rectForName.width(), 0), fullWidth);
 	}
 
-	if (flags & Flag::SavedMessages) {
+	if (!paints(rectForName)) {
+	} else if (flags & Flag::SavedMessages) {
 		auto text = tr::lng_saved_messages(tr::now);
 		const auto textWidth = st::msgNameFont->width(text);
 		if (textWidth > rectForName.width()) {
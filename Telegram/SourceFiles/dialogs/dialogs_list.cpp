@@ -84,19 +84,22 @@ void List::adjustByName(not_null<Row*> row) {
 void List::adjustByDate(not_null<Row*> row) {
 	Expects(_sortMode == SortMode::Date);
 
+	// The other rows are sorted, so a new message in a chat far down
+	// the list costs a binary search and a pointer move, not a scan.
 	const auto key = row->sortKey();
 	const auto index = row->pos();
 	const auto i = _rows.begin() + index;
-	const auto before = std::find_if(i + 1, _rows.end(), [&](Row *row) {
-		return (row->sortKey() <= key);
-	});
+	const auto before = std::partition_point(
+		i + 1,
+		_rows.end(),
+		[&](not_null<Row*> row) { return (row->sortKey() > key); });
 	if (before != i + 1) {
 		rotate(i, i + 1, before);
 	} else {
-		const auto from = std::make_reverse_iterator(i);
-		const auto after = std::find_if(from, _rows.rend(), [&](Row *row) {
-			return (row->sortKey() >= key);
-		}).base();
+		const auto after = std::partition_point(
+			_rows.begin(),
+			i,
+			[&](not_null<Row*> row) { return (row->sortKey() >= key); });
 		if (after != i) {
 			rotate(after, i, i + 1);
 		}
@@ -11,6 +11,21 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+void CheckUnreadState(const UnreadState &state) {
+#ifdef _DEBUG
+	// The total is a sum of entry states, so it can't go below zero.
+	Assert(state.messages >= state.messagesMuted);
+	Assert(state.chats >= state.chatsMuted);
+	Assert(state.marks >= state.marksMuted);
+	Assert(state.messagesMuted >= 0);
+	Assert(state.chatsMuted >= 0);
+	Assert(state.marksMuted >= 0);
+#endif // _DEBUG
+}
+
+} // namespace
 
 MainList::MainList(rpl::producer<int> pinnedLimit)
 : _all(SortMode::Date)
@@ -56,6 +71,7 @@ void MainList::unreadStateChanged(
 		const UnreadState &wasState,
 		const UnreadState &nowState) {
 	_unreadState += nowState - wasState;
+	CheckUnreadState(_unreadState);
 }
 
 void MainList::unreadEntryChanged(
@@ -66,6 +82,7 @@ void MainList::unreadEntryChanged(
 	} else {
 		_unreadState -= state;
 	}
+	CheckUnreadState(_unreadState);
 }
 
 UnreadState MainList::unreadState() const {
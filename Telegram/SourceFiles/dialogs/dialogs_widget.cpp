@@ -752,6 +752,8 @@ bool Widget::onSearchMessages(bool searchCache) {
 				i.value(),
 				0);
 			result = true;
+		} else if (_searchQuery != q || _searchQueryFrom != _searchFromUser) {
+			_inner->searchInLoaded(q);
 		}
 	} else if (_searchQuery != q || _searchQueryFrom != _searchFromUser) {
 		_searchQuery = q;
@@ -22,8 +22,7 @@ namespace {
 
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 128 * 1024;
-constexpr auto kFileRequestsCount = 2;
-constexpr auto kFileNextRequestDelay = crl::time(20);
+constexpr auto kFileRequestsCount = 4;
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
 constexpr auto kTopPeerSliceLimit = 100;
@@ -183,6 +182,7 @@ struct ApiWrap::FileProcess {
 	struct Request {
 		int offset = 0;
 		QByteArray bytes;
+		mtpRequestId id = 0;
 	};
 	std::deque<Request> requests;
 };
@@ -231,6 +231,11 @@ struct ApiWrap::ChatProcess {
 	std::optional<Data::MessagesSlice> slice;
 	bool lastSlice = false;
 	int fileIndex = 0;
+
+	// The next slice is requested while the files of this one load.
+	std::optional<MTPmessages_Messages> preloaded;
+	bool preloading = false;
+	bool preloadedAwaited = false;
 };
 
 
@@ -353,7 +358,9 @@ auto ApiWrap::mainRequest(Request &&request) {
 	auto original = std::move(_mtp.request(MTPInvokeWithTakeout<Request>(
 		MTP_long(*_takeoutId),
 		std::forward<Request>(request)
-	)).toDC(MTP::ShiftDcId(0, MTP::kExportDcShift)));
+	)).toDC(
+		MTP::ShiftDcId(0, MTP::kExportDcShift)
+	).withPriority(MTP::RequestPriority::Bulk));
 
 	return RequestBuilder<MTPInvokeWithTakeout<Request>>(
 		std::move(original),
@@ -1276,6 +1283,13 @@ void ApiWrap::requestMessagesSlice() {
 	if (!count) {
 		loadMessagesFiles({});
 		return;
+	} else if (_chatProcess->preloaded) {
+		const auto result = *base::take(_chatProcess->preloaded);
+		messagesSliceReceived(result);
+		return;
+	} else if (_chatProcess->preloading) {
+		_chatProcess->preloadedAwaited = true;
+		return;
 	}
 	requestChatMessages(
 		_chatProcess->info.splits[_chatProcess->localSplitIndex],
@@ -1283,21 +1297,52 @@ void ApiWrap::requestMessagesSlice() {
 		-kMessagesSliceLimit,
 		kMessagesSliceLimit,
 		[=](const MTPmessages_Messages &result) {
+		messagesSliceReceived(result);
+	});
+}
+
+void ApiWrap::messagesSliceReceived(const MTPmessages_Messages &result) {
+	Expects(_chatProcess != nullptr);
+
+	result.match([&](const MTPDmessages_messagesNotModified &data) {
+		error("Unexpected messagesNotModified received.");
+	}, [&](const auto &data) {
+		if constexpr (MTPDmessages_messages::Is<decltype(data)>()) {
+			_chatProcess->lastSlice = true;
+		}
+		auto slice = Data::ParseMessagesSlice(
+			_chatProcess->context,
+			data.vmessages(),
+			data.vusers(),
+			data.vchats(),
+			_chatProcess->info.relativePath);
+		if (!_chatProcess->lastSlice && !slice.list.empty()) {
+			preloadMessagesSlice(slice.list.back().id + 1);
+		}
+		loadMessagesFiles(std::move(slice));
+	});
+}
+
+void ApiWrap::preloadMessagesSlice(int offsetId) {
+	Expects(_chatProcess != nullptr);
+	Expects(!_chatProcess->preloading);
+	Expects(!_chatProcess->preloaded);
+
+	_chatProcess->preloading = true;
+	requestChatMessages(
+		_chatProcess->info.splits[_chatProcess->localSplitIndex],
+		offsetId,
+		-kMessagesSliceLimit,
+		kMessagesSliceLimit,
+		[=](const MTPmessages_Messages &result) {
 		Expects(_chatProcess != nullptr);
 
-		result.match([&](const MTPDmessages_messagesNotModified &data) {
-			error("Unexpected messagesNotModified received.");
-		}, [&](const auto &data) {
-			if constexpr (MTPDmessages_messages::Is<decltype(data)>()) {
-				_chatProcess->lastSlice = true;
-			}
-			loadMessagesFiles(Data::ParseMessagesSlice(
-				_chatProcess->context,
-				data.vmessages(),
-				data.vusers(),
-				data.vchats(),
-				_chatProcess->info.relativePath));
-		});
+		_chatProcess->preloading = false;
+		if (base::take(_chatProcess->preloadedAwaited)) {
+			messagesSliceReceived(result);
+		} else {
+			_chatProcess->preloaded = result;
+		}
 	});
 }
 
@@ -1611,33 +1656,28 @@ auto ApiWrap::prepareFileProcess(const Data::File &file) const
 }
 
 void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
+	if (!_fileProcess) {
 		return;
 	}
-
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	fileRequest(
-		_fileProcess->location,
-		_fileProcess->offset
-	).done([=](const MTPupload_File &result) {
-		filePartDone(offset, result);
-	}).send();
-	_fileProcess->offset += kFileChunkSize;
-
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
-		//const auto runner = _runner;
-		//crl::on_main([=] {
-		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
-		//		runner([=] {
-		//			loadFilePart();
-		//		});
-		//	});
-		//});
+	// Parts of a file with a known size are requested a few at once,
+	// otherwise one by one until an empty part is received.
+	const auto more = [&] {
+		const auto &process = *_fileProcess;
+		return (process.requests.size() < kFileRequestsCount)
+			&& (process.size > 0
+				? (process.offset < process.size)
+				: process.requests.empty());
+	};
+	while (more()) {
+		const auto offset = _fileProcess->offset;
+		_fileProcess->requests.push_back({ offset });
+		_fileProcess->requests.back().id = fileRequest(
+			_fileProcess->location,
+			offset
+		).done([=](const MTPupload_File &result) {
+			filePartDone(offset, result);
+		}).send();
+		_fileProcess->offset += kFileChunkSize;
 	}
 }
 
@@ -1707,6 +1747,9 @@ void ApiWrap::filePartUnavailable() {
 
 	LOG(("Export Error: File unavailable."));
 
+	for (const auto &request : _fileProcess->requests) {
+		_mtp.request(request.id).cancel();
+	}
 	base::take(_fileProcess)->done(QString());
 }
 
@@ -144,6 +144,8 @@ private:
 	void checkFirstMessageDate(int localSplitIndex, int count);
 	void messagesCountLoaded(int localSplitIndex, int count);
 	void requestMessagesSlice();
+	void messagesSliceReceived(const MTPmessages_Messages &result);
+	void preloadMessagesSlice(int offsetId);
 	void requestChatMessages(
 		int splitIndex,
 		int offsetId,
@@ -91,14 +91,39 @@ auto CalculateThumbSize(
 	};
 }
 
+bool NeedsEscaping(const char *p, const char *end) {
+	const auto ch = *p;
+	switch (ch) {
+	case '"':
+	case '&':
+	case '\'':
+	case '<':
+	case '>': return true;
+	}
+	return (ch >= 0 && ch < 32)
+		|| (ch == char(0xE2)
+			&& (p + 2 < end)
+			&& *(p + 1) == char(0x80)
+			&& (*(p + 2) == char(0xA8) || *(p + 2) == char(0xA9)));
+}
+
 QByteArray SerializeString(const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
 	const auto end = begin + size;
 
+	// Most texts have nothing to escape and are shared without a copy.
+	auto clean = begin;
+	while (clean != end && !NeedsEscaping(clean, end)) {
+		++clean;
+	}
+	if (clean == end) {
+		return value;
+	}
 	auto result = QByteArray();
-	result.reserve(size * 6);
-	for (auto p = begin; p != end; ++p) {
+	result.reserve(size * 2);
+	result.append(begin, clean - begin);
+	for (auto p = clean; p != end; ++p) {
 		const auto ch = *p;
 		if (ch == '\n') {
 			result.append("<br>", 4);
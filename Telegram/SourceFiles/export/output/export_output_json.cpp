@@ -23,15 +23,34 @@ namespace {
 
 using Context = details::JsonContext;
 
+bool NeedsEscaping(const char *p, const char *end) {
+	const auto ch = *p;
+	switch (ch) {
+	case '"':
+	case '\\': return true;
+	}
+	return (ch >= 0 && ch < 32)
+		|| (ch == char(0xE2)
+			&& (p + 2 < end)
+			&& *(p + 1) == char(0x80)
+			&& (*(p + 2) == char(0xA8) || *(p + 2) == char(0xA9)));
+}
+
 QByteArray SerializeString(const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
 	const auto end = begin + size;
 
+	// Most texts have nothing to escape and are copied in one allocation.
+	auto clean = begin;
+	while (clean != end && !NeedsEscaping(clean, end)) {
+		++clean;
+	}
 	auto result = QByteArray();
-	result.reserve(2 + size * 4);
+	result.reserve(2 + ((clean == end) ? size : (size * 4)));
 	result.append('"');
-	for (auto p = begin; p != end; ++p) {
+	result.append(begin, clean - begin);
+	for (auto p = clean; p != end; ++p) {
 		const auto ch = *p;
 		if (ch == '\n') {
 			result.append("\\n", 2);
@@ -99,8 +118,16 @@ QByteArray SerializeObject(
 	const auto guard = gsl::finally([&] { context.nesting.pop_back(); });
 	const auto next = '\n' + Indentation(context);
 
+	auto size = 3 + indent.size();
+	for (const auto &[key, value] : values) {
+		if (!value.isEmpty()) {
+			size += 5 + next.size() + key.size() + value.size();
+		}
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('{');
 	for (const auto &[key, value] : values) {
 		if (value.isEmpty()) {
@@ -124,8 +151,14 @@ QByteArray SerializeArray(
 	const auto indent = Indentation(context.nesting.size());
 	const auto next = '\n' + Indentation(context.nesting.size() + 1);
 
+	auto size = 3 + indent.size();
+	for (const auto &value : values) {
+		size += 1 + next.size() + value.size();
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('[');
 	for (const auto &value : values) {
 		if (first) {
@@ -388,6 +388,7 @@ struct Data {
 	QString TxtDomainString = cTestMode()
 		? qsl("tapv3.stel.com")
 		: qsl("apv3.stel.com");
+	QByteArray SimpleConfigCache;
 	bool PhoneCallsEnabled = true;
 	bool BlockedMode = false;
 	int32 CaptionLengthMax = 1024;
@@ -442,6 +443,7 @@ struct Data {
 	int CallOutputVolume = 100;
 	int CallInputVolume = 100;
 	bool CallAudioDuckingEnabled = true;
+	DBICallJitterPreset CallJitterPreset = dbicjDefault;
 };
 
 } // namespace internal
@@ -517,6 +519,7 @@ DefineVar(Global, int32, CallConnectTimeoutMs);
 DefineVar(Global, int32, CallPacketTimeoutMs);
 DefineVar(Global, int32, WebFileDcId);
 DefineVar(Global, QString, TxtDomainString);
+DefineVar(Global, QByteArray, SimpleConfigCache);
 DefineVar(Global, bool, PhoneCallsEnabled);
 DefineVar(Global, bool, BlockedMode);
 DefineVar(Global, int32, CaptionLengthMax);
@@ -571,5 +574,6 @@ DefineVar(Global, QString, CallInputDeviceID);
 DefineVar(Global, int, CallOutputVolume);
 DefineVar(Global, int, CallInputVolume);
 DefineVar(Global, bool, CallAudioDuckingEnabled);
+DefineVar(Global, DBICallJitterPreset, CallJitterPreset);
 
 } // namespace Global
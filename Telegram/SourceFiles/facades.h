@@ -252,6 +252,7 @@ DeclareVar(int32, CallConnectTimeoutMs);
 DeclareVar(int32, CallPacketTimeoutMs);
 DeclareVar(int32, WebFileDcId);
 DeclareVar(QString, TxtDomainString);
+DeclareVar(QByteArray, SimpleConfigCache);
 DeclareVar(bool, PhoneCallsEnabled);
 DeclareVar(bool, BlockedMode);
 DeclareVar(int32, CaptionLengthMax);
@@ -296,6 +297,7 @@ DeclareVar(QString, CallInputDeviceID);
 DeclareVar(int, CallOutputVolume);
 DeclareVar(int, CallInputVolume);
 DeclareVar(bool, CallAudioDuckingEnabled);
+DeclareVar(DBICallJitterPreset, CallJitterPreset);
 
 } // namespace Global
 
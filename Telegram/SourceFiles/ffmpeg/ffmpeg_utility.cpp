@@ -18,6 +18,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 extern "C" {
 #include <libavutil/opt.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
 } // extern "C"
 
 namespace FFmpeg {
@@ -42,6 +44,65 @@ void AlignedImageBufferCleanupHandler(void* data) {
 		&& (aspect.den <= aspect.num * kMaxScaleByAspectRatio);
 }
 
+[[nodiscard]] std::vector<AVHWDeviceType> HwDeviceTypes() {
+	return {
+#if defined Q_OS_WIN
+		AV_HWDEVICE_TYPE_D3D11VA,
+		AV_HWDEVICE_TYPE_DXVA2,
+#elif defined Q_OS_MAC // Q_OS_WIN
+		AV_HWDEVICE_TYPE_VIDEOTOOLBOX,
+#else // Q_OS_WIN || Q_OS_MAC
+		AV_HWDEVICE_TYPE_VAAPI,
+		AV_HWDEVICE_TYPE_VDPAU,
+#endif // Q_OS_WIN || Q_OS_MAC
+	};
+}
+
+// The hardware pixel format is kept in AVCodecContext::opaque.
+AVPixelFormat GetHwFormat(
+		AVCodecContext *context,
+		const AVPixelFormat *formats) {
+	const auto wanted = AVPixelFormat(
+		reinterpret_cast<intptr_t>(context->opaque));
+	auto software = AV_PIX_FMT_NONE;
+	for (auto format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+		if (*format == wanted) {
+			return wanted;
+		}
+		const auto descriptor = av_pix_fmt_desc_get(*format);
+		if (software == AV_PIX_FMT_NONE
+			&& descriptor
+			&& !(descriptor->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+			software = *format;
+		}
+	}
+	return software;
+}
+
+[[nodiscard]] bool InitHwDevice(
+		not_null<AVCodecContext*> context,
+		not_null<const AVCodec*> codec,
+		AVHWDeviceType type) {
+	for (auto i = 0;; ++i) {
+		const auto config = avcodec_get_hw_config(codec, i);
+		if (!config) {
+			return false;
+		}
+		const auto method = AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX;
+		if ((config->methods & method) && config->device_type == type) {
+			auto device = (AVBufferRef*)nullptr;
+			if (av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0)) {
+				return false;
+			}
+			context->hw_device_ctx = device;
+			context->opaque = reinterpret_cast<void*>(
+				intptr_t(config->pix_fmt));
+			context->get_format = GetHwFormat;
+			return true;
+		}
+	}
+}
+
 [[nodiscard]] bool IsAlignedImage(const QImage &image) {
 	return !(reinterpret_cast<uintptr_t>(image.bits()) % kAlignImageBy)
 		&& !(image.bytesPerLine() % kAlignImageBy);
@@ -177,7 +238,31 @@ void FormatDeleter::operator()(AVFormatContext *value) {
 	}
 }
 
-CodecPointer MakeCodecPointer(not_null<AVStream*> stream) {
+CodecPointer MakeCodecPointer(not_null<AVStream*> stream, bool hwAllowed) {
+	if (hwAllowed) {
+		for (const auto type : HwDeviceTypes()) {
+			auto error = AvErrorWrap();
+
+			auto result = CodecPointer(avcodec_alloc_context3(nullptr));
+			const auto context = result.get();
+			if (!context
+				|| avcodec_parameters_to_context(context, stream->codecpar)) {
+				break;
+			}
+			av_codec_set_pkt_timebase(context, stream->time_base);
+			av_opt_set_int(context, "refcounted_frames", 1, 0);
+
+			const auto codec = avcodec_find_decoder(context->codec_id);
+			if (!codec || !InitHwDevice(context, codec, type)) {
+				continue;
+			} else if ((error = avcodec_open2(context, codec, nullptr))) {
+				LogError(qstr("avcodec_open2 (hw)"), error);
+				continue;
+			}
+			return result;
+		}
+	}
+
 	auto error = AvErrorWrap();
 
 	auto result = CodecPointer(avcodec_alloc_context3(nullptr));
@@ -205,6 +290,15 @@ CodecPointer MakeCodecPointer(not_null<AVStream*> stream) {
 	return result;
 }
 
+QString CodecHwAccelName(not_null<AVCodecContext*> context) {
+	if (!context->hw_device_ctx) {
+		return QString();
+	}
+	const auto device = reinterpret_cast<const AVHWDeviceContext*>(
+		context->hw_device_ctx->data);
+	return QString::fromLatin1(av_hwdevice_get_type_name(device->type));
+}
+
 void CodecDeleter::operator()(AVCodecContext *value) {
 	if (value) {
 		avcodec_free_context(&value);
@@ -219,6 +313,31 @@ bool FrameHasData(AVFrame *frame) {
 	return (frame && frame->data[0] != nullptr);
 }
 
+AvErrorWrap TransferHwFrame(not_null<AVFrame*> frame, FramePointer &storage) {
+	if (!frame->hw_frames_ctx) {
+		return AvErrorWrap();
+	} else if (!storage) {
+		storage = MakeFramePointer();
+		if (!storage) {
+			return AvErrorWrap(AVERROR(ENOMEM));
+		}
+	}
+	auto error = AvErrorWrap(av_hwframe_transfer_data(
+		storage.get(),
+		frame,
+		0));
+	if (!error) {
+		error = av_frame_copy_props(storage.get(), frame);
+	}
+	if (error) {
+		av_frame_unref(storage.get());
+		return error;
+	}
+	av_frame_unref(frame);
+	av_frame_move_ref(frame, storage.get());
+	return error;
+}
+
 void ClearFrameMemory(AVFrame *frame) {
 	if (FrameHasData(frame)) {
 		av_frame_unref(frame);
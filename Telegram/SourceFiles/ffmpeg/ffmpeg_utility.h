@@ -136,7 +136,14 @@ struct CodecDeleter {
 	void operator()(AVCodecContext *value);
 };
 using CodecPointer = std::unique_ptr<AVCodecContext, CodecDeleter>;
-[[nodiscard]] CodecPointer MakeCodecPointer(not_null<AVStream*> stream);
+
+// With hwAllowed tries the platform hardware decoders before software.
+[[nodiscard]] CodecPointer MakeCodecPointer(
+	not_null<AVStream*> stream,
+	bool hwAllowed = false);
+
+// Empty for software decoding.
+[[nodiscard]] QString CodecHwAccelName(not_null<AVCodecContext*> context);
 
 struct FrameDeleter {
 	void operator()(AVFrame *value);
@@ -144,6 +151,11 @@ struct FrameDeleter {
 using FramePointer = std::unique_ptr<AVFrame, FrameDeleter>;
 [[nodiscard]] FramePointer MakeFramePointer();
 [[nodiscard]] bool FrameHasData(AVFrame *frame);
+
+// Downloads a frame decoded by a hardware decoder to system memory.
+[[nodiscard]] AvErrorWrap TransferHwFrame(
+	not_null<AVFrame*> frame,
+	FramePointer &storage);
 void ClearFrameMemory(AVFrame *frame);
 
 struct SwscaleDeleter {
@@ -51,6 +51,7 @@ constexpr auto kMaxChannelAdmins = 200;
 constexpr auto kScrollDateHideTimeout = 1000;
 constexpr auto kEventsFirstPage = 20;
 constexpr auto kEventsPerPage = 50;
+constexpr auto kMaxLoadedItems = 400;
 
 } // namespace
 
@@ -361,14 +362,120 @@ void InnerWidget::repaintScrollDateCallback() {
 }
 
 void InnerWidget::checkPreloadMore() {
-	if (_visibleTop + PreloadHeightsCount * (_visibleBottom - _visibleTop) > height()) {
+	// Keep at least one more page loaded beyond the visible area.
+	const auto preloadHeight = PreloadHeightsCount
+		* (_visibleBottom - _visibleTop);
+	if (_visibleTop + preloadHeight > height()
+		|| countItemsBelow(_visibleBottom) < kEventsPerPage) {
 		preloadMore(Direction::Down);
 	}
-	if (_visibleTop < PreloadHeightsCount * (_visibleBottom - _visibleTop)) {
+	if (_visibleTop < preloadHeight
+		|| countItemsAbove(_visibleTop) < kEventsPerPage) {
 		preloadMore(Direction::Up);
 	}
 }
 
+int InnerWidget::countItemsAbove(int top) const {
+	const auto begin = std::rbegin(_items), end = std::rend(_items);
+	const auto from = std::lower_bound(begin, end, top, [this](auto &&elem, int value) {
+		return this->itemTop(elem) + elem->height() <= value;
+	});
+	return int(from - begin);
+}
+
+int InnerWidget::countItemsBelow(int bottom) const {
+	const auto begin = std::rbegin(_items), end = std::rend(_items);
+	const auto till = std::lower_bound(begin, end, bottom, [this](auto &&elem, int value) {
+		return this->itemTop(elem) < value;
+	});
+	return int(end - till);
+}
+
+bool InnerWidget::unloadFarItemsAllowed(int from, int till) const {
+	for (auto i = from; i != till; ++i) {
+		const auto view = _items[i].get();
+		if (view == _visibleTopItem
+			|| view == _mouseActionItem
+			|| view == _selectedItem
+			|| view == _scrollDateLastItem) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void InnerWidget::unloadFarItems(Direction loaded) {
+	if (int(_items.size()) <= kMaxLoadedItems) {
+		return;
+	}
+	const auto keepHeight = 2 * PreloadHeightsCount
+		* (_visibleBottom - _visibleTop);
+	const auto forget = [&](int from, int till) {
+		for (auto i = from; i != till; ++i) {
+			_itemsByData.erase(_items[i]->data());
+		}
+		_items.erase(begin(_items) + from, begin(_items) + till);
+	};
+	if (loaded == Direction::Up) {
+		// Unload the newest events below, keeping their ids with zero
+		// items count, so that they are requested back page by page.
+		const auto far = std::min(
+			countItemsBelow(_visibleBottom + keepHeight),
+			countItemsBelow(_visibleBottom) - 2 * kEventsPerPage);
+		auto removed = 0;
+		for (auto i = _eventIds.rbegin(); i != _eventIds.rend(); ++i) {
+			if (!i->second) {
+				continue;
+			}
+			const auto count = i->second;
+			if (removed + count > far
+				|| int(_items.size()) - removed <= kMaxLoadedItems
+				|| !unloadFarItemsAllowed(removed, removed + count)) {
+				break;
+			}
+			removed += count;
+			i->second = 0;
+		}
+		if (!removed) {
+			return;
+		}
+		forget(0, removed);
+		_items.front()->setAttachToNext(false);
+		request(base::take(_preloadDownRequestId)).cancel();
+		_downLoaded = false;
+	} else {
+		// Unload the oldest events above, they are requested back by
+		// the usual loading up from the minimal loaded id.
+		const auto far = std::min(
+			countItemsAbove(_visibleTop - keepHeight),
+			countItemsAbove(_visibleTop) - 2 * kEventsPerPage);
+		auto removed = 0;
+		while (!_eventIds.empty()) {
+			const auto first = _eventIds.begin();
+			const auto count = first->second;
+			const auto till = int(_items.size()) - removed;
+			if (removed + count > far
+				|| till <= kMaxLoadedItems
+				|| !unloadFarItemsAllowed(till - count, till)) {
+				break;
+			}
+			removed += count;
+			_eventIds.erase(first);
+		}
+		if (!removed) {
+			return;
+		}
+		forget(int(_items.size()) - removed, int(_items.size()));
+		const auto top = _items.back().get();
+		top->setDisplayDate(true);
+		top->setAttachToPrevious(false);
+		request(base::take(_preloadUpRequestId)).cancel();
+		_upLoaded = false;
+	}
+	updateMinMaxIds();
+	updateSize();
+}
+
 void InnerWidget::applyFilter(FilterValue &&value) {
 	if (_filter != value) {
 		_filter = value;
@@ -614,6 +721,19 @@ void InnerWidget::preloadMore(Direction direction) {
 	auto maxId = (direction == Direction::Up) ? _minId : 0;
 	auto minId = (direction == Direction::Up) ? 0 : _maxId;
 	auto perPage = _items.empty() ? kEventsFirstPage : kEventsPerPage;
+	if (direction == Direction::Down && !_filterChanged) {
+		// Request the unloaded events right above the loaded ones.
+		auto count = 0;
+		for (auto i = _eventIds.upper_bound(_maxId); i != _eventIds.end(); ++i) {
+			maxId = i->first + 1;
+			if (++count == perPage) {
+				break;
+			}
+		}
+		if (count) {
+			perPage = count + 1;
+		}
+	}
 	requestId = request(MTPchannels_GetAdminLog(
 		MTP_flags(flags),
 		_channel->inputChannel,
@@ -632,6 +752,9 @@ void InnerWidget::preloadMore(Direction direction) {
 		_channel->owner().processUsers(results.vusers());
 		_channel->owner().processChats(results.vchats());
 		if (!loadedFlag) {
+			if (maxId && direction == Direction::Down && !_filterChanged) {
+				forgetUnloadedEvents(maxId);
+			}
 			addEvents(direction, results.vevents().v);
 		}
 	}).fail([this, &requestId, &loadedFlag](const RPCError &error) {
@@ -648,7 +771,11 @@ void InnerWidget::addEvents(Direction direction, const QVector<MTPChannelAdminLo
 
 	auto up = (direction == Direction::Up);
 	if (events.empty()) {
-		(up ? _upLoaded : _downLoaded) = true;
+		if (up || _eventIds.upper_bound(_maxId) == _eventIds.end()) {
+			(up ? _upLoaded : _downLoaded) = true;
+		} else {
+			checkPreloadMore();
+		}
 		update();
 		return;
 	}
@@ -664,13 +791,14 @@ void InnerWidget::addEvents(Direction direction, const QVector<MTPChannelAdminLo
 	for (const auto &event : events) {
 		event.match([&](const MTPDchannelAdminLogEvent &data) {
 			const auto id = data.vid().v;
-			if (_eventIds.find(id) != _eventIds.end()) {
+			const auto i = _eventIds.find(id);
+			if (i != _eventIds.end() && i->second > 0) {
 				return;
 			}
 
 			auto count = 0;
 			const auto addOne = [&](OwnedItem item) {
-				_eventIds.emplace(id);
+				++_eventIds[id];
 				_itemsByData.emplace(item->data(), item.get());
 				addToItems.push_back(std::move(item));
 				++count;
@@ -702,16 +830,31 @@ void InnerWidget::addEvents(Direction direction, const QVector<MTPChannelAdminLo
 		}
 		updateMinMaxIds();
 		itemsAdded(direction, newItemsCount - oldItemsCount);
+		unloadFarItems(direction);
 	}
 	update();
 }
 
+void InnerWidget::forgetUnloadedEvents(uint64 tillId) {
+	// Unloaded events that were requested will be added back if they
+	// still exist, others have expired and shouldn't be requested again.
+	auto i = _eventIds.upper_bound(_maxId);
+	while (i != _eventIds.end() && i->first < tillId) {
+		i = _eventIds.erase(i);
+	}
+}
+
 void InnerWidget::updateMinMaxIds() {
 	if (_eventIds.empty() || _filterChanged) {
 		_maxId = _minId = 0;
 	} else {
-		_maxId = *_eventIds.rbegin();
-		_minId = *_eventIds.begin();
+		// Unloaded events have zero items and are all above the loaded.
+		auto last = _eventIds.rbegin();
+		while (!last->second && std::next(last) != _eventIds.rend()) {
+			++last;
+		}
+		_maxId = last->first;
+		_minId = _eventIds.begin()->first;
 		if (_minId == 1) {
 			_upLoaded = true;
 		}
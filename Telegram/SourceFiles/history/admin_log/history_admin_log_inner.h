@@ -172,6 +172,10 @@ private:
 
 	void requestAdmins();
 	void checkPreloadMore();
+	int countItemsAbove(int top) const;
+	int countItemsBelow(int bottom) const;
+	void unloadFarItems(Direction loaded);
+	bool unloadFarItemsAllowed(int from, int till) const;
 	void updateVisibleTopItem();
 	void preloadMore(Direction direction);
 	void itemsAdded(Direction direction, int addedCount);
@@ -182,6 +186,7 @@ private:
 	void clearAfterFilterChange();
 	void clearAndRequestLog();
 	void addEvents(Direction direction, const QVector<MTPChannelAdminLogEvent> &events);
+	void forgetUnloadedEvents(uint64 tillId);
 	Element *viewForItem(const HistoryItem *item);
 
 	void toggleScrollDateShown();
@@ -219,7 +224,7 @@ private:
 	not_null<ChannelData*> _channel;
 	not_null<History*> _history;
 	std::vector<OwnedItem> _items;
-	std::set<uint64> _eventIds;
+	std::map<uint64, int> _eventIds; // Event id -> items generated.
 	std::map<not_null<const HistoryItem*>, not_null<Element*>> _itemsByData;
 	base::flat_set<FullMsgId> _animatedStickersPlayed;
 	int _itemsTop = 0;
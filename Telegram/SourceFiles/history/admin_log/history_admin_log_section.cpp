@@ -304,7 +304,7 @@ Dialogs::RowDescriptor Widget::activeChat() const {
 
 QPixmap Widget::grabForShowAnimation(const Window::SectionSlideParams &params) {
 	if (params.withTopBarShadow) _fixedBarShadow->hide();
-	auto result = Ui::GrabWidget(this);
+	auto result = GrabForSlide(this);
 	if (params.withTopBarShadow) _fixedBarShadow->show();
 	return result;
 }
@@ -150,7 +150,7 @@ public:
 
 	void setItems(
 			std::vector<OwnedItem> &&items,
-			std::set<uint64> &&eventIds,
+			std::map<uint64, int> &&eventIds,
 			bool upLoaded,
 			bool downLoaded) {
 		_items = std::move(items);
@@ -170,7 +170,7 @@ public:
 	std::vector<OwnedItem> takeItems() {
 		return std::move(_items);
 	}
-	std::set<uint64> takeEventIds() {
+	std::map<uint64, int> takeEventIds() {
 		return std::move(_eventIds);
 	}
 	std::shared_ptr<LocalIdManager> takeIdManager() {
@@ -195,7 +195,7 @@ private:
 	std::vector<not_null<UserData*>> _admins;
 	std::vector<not_null<UserData*>> _adminsCanEdit;
 	std::vector<OwnedItem> _items;
-	std::set<uint64> _eventIds;
+	std::map<uint64, int> _eventIds;
 	bool _upLoaded = false;
 	bool _downLoaded = true;
 	std::shared_ptr<LocalIdManager> _idManager;
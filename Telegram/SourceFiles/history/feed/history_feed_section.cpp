@@ -268,7 +268,7 @@ void Widget::updateAdaptiveLayout() {
 
 QPixmap Widget::grabForShowAnimation(const Window::SectionSlideParams &params) {
 	if (params.withTopBarShadow) _topBarShadow->hide();
-	auto result = Ui::GrabWidget(this);
+	auto result = GrabForSlide(this);
 	if (params.withTopBarShadow) _topBarShadow->show();
 	return result;
 }
@@ -2746,9 +2746,11 @@ HistoryItem *History::lastSentMessage() const {
 }
 
 void History::resizeToWidth(int newWidth) {
-	const auto resizeAllItems = (_width != newWidth);
+	resizeToWidth(newWidth, 0, std::numeric_limits<int>::max());
+}
 
-	if (!resizeAllItems && !hasPendingResizedItems()) {
+void History::resizeToWidth(int newWidth, int from, int till) {
+	if (_width == newWidth && !hasPendingResizedItems()) {
 		return;
 	}
 	_flags &= ~(Flag::f_has_pending_resized_items);
@@ -2756,14 +2758,58 @@ void History::resizeToWidth(int newWidth) {
 	_width = newWidth;
 	int y = 0;
 	for (const auto &block : blocks) {
+		const auto visible = (y < till) && (y + block->height() > from);
+		const auto resizeAllItems = visible && (block->width() != newWidth);
 		block->setY(y);
 		y += block->resizeGetHeight(newWidth, resizeAllItems);
 	}
 	_height = y;
 }
 
+bool History::hasOutdatedBlocks() const {
+	return _width && ranges::find_if(blocks, [&](const auto &block) {
+		return (block->width() != _width);
+	}) != end(blocks);
+}
+
+bool History::resizeOutdatedBlocks(int from, int till, crl::time deadline) {
+	if (!_width) {
+		return false;
+	}
+	auto found = false;
+	for (const auto &block : blocks) {
+		if (block->width() != _width
+			&& block->y() < till
+			&& block->y() + block->height() > from) {
+			block->resizeGetHeight(_width, true);
+			found = true;
+		}
+	}
+	for (const auto &block : blocks) {
+		if (block->width() != _width) {
+			if (crl::now() >= deadline) {
+				break;
+			}
+			block->resizeGetHeight(_width, true);
+			found = true;
+		}
+	}
+	if (found) {
+		auto y = 0;
+		for (const auto &block : blocks) {
+			block->setY(y);
+			y += block->height();
+		}
+		_height = y;
+	}
+	return found;
+}
+
 void History::forceFullResize() {
 	_width = 0;
+	for (const auto &block : blocks) {
+		block->forceFullResize();
+	}
 	_flags |= Flag::f_has_pending_resized_items;
 }
 
@@ -3080,6 +3126,23 @@ void History::clear(ClearType type) {
 	}
 }
 
+int History::loadedMessagesCount() const {
+	auto result = 0;
+	for (const auto &block : blocks) {
+		result += int(block->messages.size());
+	}
+	return result;
+}
+
+void History::unloadCold() {
+	for (const auto &block : blocks) {
+		for (const auto &message : block->messages) {
+			message->data()->releaseText();
+		}
+	}
+	clear(ClearType::Unload);
+}
+
 void History::clearUpTill(MsgId availableMinId) {
 	auto minId = minMsgId();
 	if (!minId || minId > availableMinId) {
@@ -3142,14 +3205,19 @@ HistoryBlock::HistoryBlock(not_null<History*> history)
 
 int HistoryBlock::resizeGetHeight(int newWidth, bool resizeAllItems) {
 	auto y = 0;
+	auto resizedAll = true;
 	for (const auto &message : messages) {
 		message->setY(y);
 		if (resizeAllItems || message->pendingResize()) {
 			y += message->resizeGetHeight(newWidth);
 		} else {
 			y += message->height();
+			resizedAll = false;
 		}
 	}
+	if (resizedAll || _width == newWidth) {
+		_width = newWidth;
+	}
 	_height = y;
 	return _height;
 }
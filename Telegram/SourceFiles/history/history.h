@@ -90,6 +90,13 @@ public:
 		ClearHistory,
 	};
 	void clear(ClearType type);
+
+	// Messages with views in the loaded blocks.
+	[[nodiscard]] int loadedMessagesCount() const;
+
+	// Unloads the blocks of a history that is not shown and releases
+	// the parsed texts of its messages to save memory.
+	void unloadCold();
 	void clearUpTill(MsgId availableMinId);
 
 	void applyGroupAdminChanges(const base::flat_set<UserId> &changes);
@@ -207,6 +214,16 @@ public:
 	HistoryItem *lastSentMessage() const;
 
 	void resizeToWidth(int newWidth);
+
+	// For a new width lays out only the blocks that intersect the range
+	// [from, till), others keep their old heights and become outdated.
+	void resizeToWidth(int newWidth, int from, int till);
+
+	// Lays out the outdated blocks that intersect [from, till) and then
+	// the other ones until the deadline, returns true if any were resized.
+	bool resizeOutdatedBlocks(int from, int till, crl::time deadline);
+	[[nodiscard]] bool hasOutdatedBlocks() const;
+
 	void forceFullResize();
 	int height() const;
 
@@ -544,6 +561,15 @@ public:
 	void refreshView(not_null<Element*> view);
 
 	int resizeGetHeight(int newWidth, bool resizeAllItems);
+
+	// The width all the messages were laid out for the last time.
+	int width() const {
+		return _width;
+	}
+	void forceFullResize() {
+		_width = 0;
+	}
+
 	int y() const {
 		return _y;
 	}
@@ -586,6 +612,7 @@ protected:
 	const not_null<History*> _history;
 
 	int _y = 0;
+	int _width = 0;
 	int _height = 0;
 	int _indexInHistory = -1;
 
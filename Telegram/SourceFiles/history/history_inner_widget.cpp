@@ -35,6 +35,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "chat_helpers/stickers.h"
 #include "history/history_widget.h"
 #include "base/unixtime.h"
+#include "base/tracing.h"
 #include "mainwindow.h"
 #include "mainwidget.h"
 #include "layout.h"
@@ -228,6 +229,7 @@ void HistoryInner::repaintItem(const HistoryItem *item) {
 
 void HistoryInner::repaintItem(const Element *view) {
 	if (_widget->skipItemRepaint()) {
+		_repaintSkipped.emplace(view->data()->fullId());
 		return;
 	}
 	const auto top = itemTop(view);
@@ -236,6 +238,14 @@ void HistoryInner::repaintItem(const Element *view) {
 	}
 }
 
+void HistoryInner::repaintSkippedItems() {
+	for (const auto &itemId : base::take(_repaintSkipped)) {
+		if (const auto item = session().data().message(itemId)) {
+			repaintItem(item);
+		}
+	}
+}
+
 template <bool TopToBottom, typename Method>
 void HistoryInner::enumerateItemsInHistory(History *history, int historytop, Method method) {
 	// No displayed messages in this history.
@@ -544,6 +554,7 @@ void HistoryInner::paintEmpty(Painter &p, int width, int height) {
 }
 
 void HistoryInner::paintEvent(QPaintEvent *e) {
+	TRACE_ZONE("HistoryInner::paintEvent");
 	if (Ui::skipPaintEvent(this, e)) {
 		return;
 	}
@@ -1917,22 +1928,25 @@ TextForMimeData HistoryInner::getSelectedText() const {
 
 	const auto timeFormat = qsl(", [dd.MM.yy hh:mm]\n");
 	auto groups = base::flat_set<not_null<const Data::Group*>>();
-	auto fullSize = 0;
-	auto texts = base::flat_map<Data::MessagePosition, TextForMimeData>();
+
+	// Parts are collected unsorted and written to the result in one pass.
+	struct Part {
+		Data::MessagePosition position;
+		not_null<HistoryItem*> item;
+		QString time;
+		TextForMimeData text;
+	};
+	auto parts = std::vector<Part>();
+	parts.reserve(selected.size());
 
 	const auto wrapItem = [&](
 			not_null<HistoryItem*> item,
 			TextForMimeData &&unwrapped) {
-		auto time = ItemDateTime(item).toString(timeFormat);
-		auto part = TextForMimeData();
-		auto size = item->author()->name.size()
-			+ time.size()
-			+ unwrapped.expanded.size();
-		part.reserve(size);
-		part.append(item->author()->name).append(time);
-		part.append(std::move(unwrapped));
-		texts.emplace(item->position(), part);
-		fullSize += size;
+		parts.push_back({
+			item->position(),
+			item,
+			ItemDateTime(item).toString(timeFormat),
+			std::move(unwrapped) });
 	};
 	const auto addItem = [&](not_null<HistoryItem*> item) {
 		wrapItem(item, HistoryItemText(item));
@@ -1958,12 +1972,25 @@ TextForMimeData HistoryInner::getSelectedText() const {
 			addItem(item);
 		}
 	}
+	if (parts.empty()) {
+		return TextForMimeData();
+	}
+	ranges::sort(parts, std::less<>(), &Part::position);
 
-	auto result = TextForMimeData();
 	const auto sep = qstr("\n\n");
-	result.reserve(fullSize + (texts.size() - 1) * sep.size());
-	for (auto i = texts.begin(), e = texts.end(); i != e;) {
-		result.append(std::move(i->second));
+	auto fullSize = (int(parts.size()) - 1) * sep.size();
+	auto entitiesCount = 0;
+	for (const auto &part : parts) {
+		fullSize += part.item->author()->name.size()
+			+ part.time.size()
+			+ part.text.expanded.size();
+		entitiesCount += part.text.rich.entities.size();
+	}
+	auto result = TextForMimeData();
+	result.reserve(fullSize, entitiesCount);
+	for (auto i = begin(parts), e = end(parts); i != e;) {
+		result.append(i->item->author()->name).append(i->time);
+		result.append(std::move(i->text));
 		if (++i != e) {
 			result.append(sep);
 		}
@@ -2001,10 +2028,23 @@ void HistoryInner::recountHistoryGeometry() {
 		accumulate_max(oldHistoryPaddingTop, st::msgMargin.top() + st::msgMargin.bottom() + st::msgPadding.top() + st::msgPadding.bottom() + st::msgNameFont->height + st::botDescSkip + _botAbout->height);
 	}
 
-	_history->resizeToWidth(_contentWidth);
+	// Until the visible area is known all messages are laid out.
+	const auto margin = (_visibleAreaBottom - _visibleAreaTop);
+	const auto resizeToWidth = [&](not_null<History*> history, int top) {
+		if (top < 0 || margin <= 0) {
+			history->resizeToWidth(_contentWidth);
+		} else {
+			history->resizeToWidth(
+				_contentWidth,
+				_visibleAreaTop - margin - top,
+				_visibleAreaBottom + margin - top);
+		}
+	};
+	const auto historyTopWas = historyTop();
 	if (_migrated) {
-		_migrated->resizeToWidth(_contentWidth);
+		resizeToWidth(_migrated, migratedTop());
 	}
+	resizeToWidth(_history, historyTopWas);
 
 	// With migrated history we perhaps do not need to display
 	// the first _history message date (just skip it by height).
@@ -2104,6 +2144,28 @@ void HistoryInner::updateBotInfo(bool recount) {
 	}
 }
 
+bool HistoryInner::resizeOutdatedBlocks(crl::time deadline) {
+	const auto margin = (_visibleAreaBottom - _visibleAreaTop);
+	const auto resize = [&](History *history, int top) {
+		return history
+			&& (top >= 0)
+			&& history->resizeOutdatedBlocks(
+				_visibleAreaTop - margin - top,
+				_visibleAreaBottom + margin - top,
+				deadline);
+	};
+	const auto htop = historyTop();
+	const auto mtop = migratedTop();
+	const auto migrated = resize(_migrated, mtop);
+	const auto history = resize(_history, htop);
+	return migrated || history;
+}
+
+bool HistoryInner::hasOutdatedBlocks() const {
+	return _history->hasOutdatedBlocks()
+		|| (_migrated && _migrated->hasOutdatedBlocks());
+}
+
 bool HistoryInner::wasSelectedText() const {
 	return _wasSelectedText;
 }
@@ -2152,7 +2214,7 @@ void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 		scrollDateHideByTimer();
 	}
 
-	// Unload lottie animations.
+	// Unload lottie animations and stop far scrolled gifs.
 	const auto pages = kUnloadHeavyPartsPages;
 	const auto from = _visibleAreaTop - pages * visibleAreaHeight;
 	const auto till = _visibleAreaBottom + pages * visibleAreaHeight;
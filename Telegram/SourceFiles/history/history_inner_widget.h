@@ -64,9 +64,17 @@ public:
 	void recountHistoryGeometry();
 	void updateSize();
 
+	// Messages far from the visible area are laid out for the new width
+	// later, returns true if some heights were changed.
+	bool resizeOutdatedBlocks(crl::time deadline);
+	[[nodiscard]] bool hasOutdatedBlocks() const;
+
 	void repaintItem(const HistoryItem *item);
 	void repaintItem(const Element *view);
 
+	// Items that requested a repaint while scrolling are repainted later.
+	void repaintSkippedItems();
+
 	bool canCopySelected() const;
 	bool canDeleteSelected() const;
 
@@ -332,6 +340,7 @@ private:
 	SelectedItems _selected;
 
 	base::flat_set<not_null<const HistoryItem*>> _animatedStickersPlayed;
+	base::flat_set<FullMsgId> _repaintSkipped;
 
 	MouseAction _mouseAction = MouseAction::None;
 	TextSelectType _mouseSelectType = TextSelectType::Letters;
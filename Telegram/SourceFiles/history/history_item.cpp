@@ -729,8 +729,24 @@ MessageGroupId HistoryItem::groupId() const {
 	return _groupId;
 }
 
+Ui::Text::String &HistoryItem::text() {
+	if (_deferredText) {
+		auto text = std::move(*base::take(_deferredText));
+		parseDeferredText(std::move(text));
+	}
+	return _text;
+}
+
+const Ui::Text::String &HistoryItem::text() const {
+	return const_cast<HistoryItem*>(this)->text();
+}
+
+QString HistoryItem::rawText() const {
+	return _deferredText ? _deferredText->text : _text.toString();
+}
+
 bool HistoryItem::isEmpty() const {
-	return _text.isEmpty()
+	return emptyText()
 		&& !_media
 		&& !Has<HistoryMessageLogEntryOriginal>();
 }
@@ -740,7 +756,7 @@ QString HistoryItem::notificationText() const {
 		if (_media) {
 			return _media->notificationText();
 		} else if (!emptyText()) {
-			return _text.toString();
+			return text().toString();
 		}
 		return QString();
 	}();
@@ -757,7 +773,7 @@ QString HistoryItem::inDialogsText(DrawInDialog way) const {
 			}
 			return _media->chatListText();
 		} else if (!emptyText()) {
-			return TextUtilities::Clean(_text.toString());
+			return TextUtilities::Clean(text().toString());
 		}
 		return QString();
 	};
@@ -8,9 +8,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/runtime_composer.h"
+#include "base/object_pool.h"
 #include "base/flags.h"
 #include "base/value_ordering.h"
 #include "data/data_media_types.h"
+#include "history/view/history_view_text_heights.h"
 
 enum class UnreadMentionType;
 struct HistoryMessageReplyMarkup;
@@ -56,7 +58,9 @@ class ElementDelegate;
 
 struct HiddenSenderInfo;
 
-class HistoryItem : public RuntimeComposer<HistoryItem> {
+class HistoryItem
+	: public RuntimeComposer<HistoryItem>
+	, public base::pooled<HistoryItem> {
 public:
 	static not_null<HistoryItem*> Create(
 		not_null<History*> history,
@@ -250,7 +254,14 @@ public:
 		Ui::Text::String &cache) const;
 
 	bool emptyText() const {
-		return _text.isEmpty();
+		return !_deferredText && _text.isEmpty();
+	}
+
+	// Plain text of the message, doesn't parse the deferred text.
+	[[nodiscard]] QString rawText() const;
+
+	// Frees the parsed text, it will be parsed again when it is needed.
+	virtual void releaseText() {
 	}
 
 	bool isPinned() const;
@@ -345,9 +356,18 @@ protected:
 
 	void setGroupId(MessageGroupId groupId);
 
+	// Parses the text kept by the deferred setText() if there is one.
+	[[nodiscard]] Ui::Text::String &text();
+	[[nodiscard]] const Ui::Text::String &text() const;
+	virtual void parseDeferredText(TextWithEntities &&text) {
+	}
+
 	Ui::Text::String _text = { st::msgMinWidth };
-	int _textWidth = -1;
-	int _textHeight = 0;
+	HistoryView::TextHeights _textHeights;
+
+	// Messages loaded far from the viewport may never be displayed,
+	// so their text is parsed only when it is needed for the first time.
+	std::unique_ptr<TextWithEntities> _deferredText;
 
 	std::unique_ptr<Data::Media> _savedMedia;
 	std::unique_ptr<Data::Media> _media;
@@ -389,6 +389,7 @@ struct HistoryDocumentCaptioned : public RuntimeComponent<HistoryDocumentCaption
 	HistoryDocumentCaptioned();
 
 	Ui::Text::String _caption;
+	HistoryView::TextHeights _captionHeights;
 };
 
 struct HistoryDocumentNamed : public RuntimeComponent<HistoryDocumentNamed, HistoryView::Document> {
@@ -91,7 +91,7 @@ TextForMimeData HistoryItemText(not_null<HistoryItem*> item) {
 		titleResult.append('\n').append(std::move(descriptionResult));
 		return titleResult;
 	}();
-	auto result = textResult;
+	auto result = std::move(textResult);
 	if (result.empty()) {
 		result = std::move(mediaResult);
 	} else if (!mediaResult.empty()) {
@@ -45,6 +45,17 @@ namespace {
 
 constexpr auto kPinnedMessageTextLimit = 16;
 
+// Isolated emoji are registered right away, so texts that may be ones
+// are parsed immediately. Any letter makes a text not an isolated emoji.
+[[nodiscard]] bool MayBeIsolatedEmoji(const QString &text) {
+	for (const auto ch : text) {
+		if (ch.isLetter()) {
+			return false;
+		}
+	}
+	return true;
+}
+
 MTPDmessage::Flags NewForwardedFlags(
 		not_null<PeerData*> peer,
 		UserId from,
@@ -183,7 +194,7 @@ void FastShareMessage(not_null<HistoryItem*> item) {
 		}
 		not_null<PeerData*> peer;
 		MessageIdsList msgIds;
-		base::flat_set<mtpRequestId> requests;
+		bool submitted = false;
 	};
 	const auto history = item->history();
 	const auto owner = &history->owner();
@@ -220,7 +231,7 @@ void FastShareMessage(not_null<HistoryItem*> item) {
 			QVector<PeerData*> &&result,
 			TextWithTags &&comment,
 			bool silent) {
-		if (!data->requests.empty()) {
+		if (data->submitted) {
 			return; // Share clicked already.
 		}
 		auto items = history->owner().idsToItems(data->msgIds);
@@ -254,15 +265,6 @@ void FastShareMessage(not_null<HistoryItem*> item) {
 			return;
 		}
 
-		auto doneCallback = [=](const MTPUpdates &updates, mtpRequestId requestId) {
-			history->session().api().applyUpdates(updates);
-			data->requests.remove(requestId);
-			if (data->requests.empty()) {
-				Ui::Toast::Show(tr::lng_share_done(tr::now));
-				Ui::hideLayer();
-			}
-		};
-
 		const auto sendFlags = MTPmessages_ForwardMessages::Flag(0)
 			| MTPmessages_ForwardMessages::Flag::f_with_my_score
 			| (isGroup
@@ -276,13 +278,8 @@ void FastShareMessage(not_null<HistoryItem*> item) {
 		for (const auto fullId : data->msgIds) {
 			msgIds.push_back(MTP_int(fullId.msg));
 		}
-		auto generateRandom = [&] {
-			auto result = QVector<MTPlong>(data->msgIds.size());
-			for (auto &value : result) {
-				value = rand_value<MTPlong>();
-			}
-			return result;
-		};
+		auto histories = std::vector<not_null<History*>>();
+		histories.reserve(result.size());
 		for (const auto peer : result) {
 			const auto history = peer->owner().history(peer);
 			if (!comment.text.isEmpty()) {
@@ -291,21 +288,18 @@ void FastShareMessage(not_null<HistoryItem*> item) {
 				message.clearDraft = false;
 				history->session().api().sendMessage(std::move(message));
 			}
-			auto request = MTPmessages_ForwardMessages(
-				MTP_flags(sendFlags),
-				data->peer->input,
-				MTP_vector<MTPint>(msgIds),
-				MTP_vector<MTPlong>(generateRandom()),
-				peer->input);
-			history->sendRequestId = MTP::send(
-				request,
-				rpcDone(base::duplicate(doneCallback)),
-				nullptr,
-				0,
-				0,
-				history->sendRequestId);
-			data->requests.insert(history->sendRequestId);
+			histories.push_back(history);
 		}
+		data->submitted = true;
+		history->session().api().forwardMessagesToMany(
+			data->peer,
+			msgIds,
+			histories,
+			sendFlags,
+			[] {
+				Ui::Toast::Show(tr::lng_share_done(tr::now));
+				Ui::hideLayer();
+			});
 	};
 	auto filterCallback = [isGame](PeerData *peer) {
 		if (peer->canWrite()) {
@@ -1092,34 +1086,59 @@ void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
 	clearIsolatedEmoji();
 	if (_media && _media->consumeMessageText(textWithEntities)) {
 		setEmptyText();
+	} else if (!_media && MayBeIsolatedEmoji(textWithEntities.text)) {
+		_deferredText = nullptr;
+		applyText(textWithEntities);
 	} else {
+		_deferredText = std::make_unique<TextWithEntities>(
+			textWithEntities);
+		_textHeights.clear();
+	}
+}
+
+void HistoryMessage::releaseText() {
+	if (_deferredText
+		|| _media
+		|| emptyText()
+		|| MayBeIsolatedEmoji(_text.toString())) {
+		return;
+	}
+	_deferredText = std::make_unique<TextWithEntities>(
+		_text.toTextWithEntities());
+	_text = Ui::Text::String(st::msgMinWidth);
+	_textHeights.clear();
+}
+
+void HistoryMessage::parseDeferredText(TextWithEntities &&text) {
+	applyText(text);
+}
+
+void HistoryMessage::applyText(const TextWithEntities &textWithEntities) {
+	_text.setMarkedText(
+		st::messageTextStyle,
+		textWithEntities,
+		Ui::ItemTextOptions(this));
+	if (!textWithEntities.text.isEmpty() && _text.isEmpty()) {
+		// If server has allowed some text that we've trim-ed entirely,
+		// just replace it with something so that UI won't look buggy.
 		_text.setMarkedText(
 			st::messageTextStyle,
-			textWithEntities,
+			{ QString::fromUtf8(":-("), EntitiesInText() },
 			Ui::ItemTextOptions(this));
-		if (!textWithEntities.text.isEmpty() && _text.isEmpty()) {
-			// If server has allowed some text that we've trim-ed entirely,
-			// just replace it with something so that UI won't look buggy.
-			_text.setMarkedText(
-				st::messageTextStyle,
-				{ QString::fromUtf8(":-("), EntitiesInText() },
-				Ui::ItemTextOptions(this));
-		} else if (!_media) {
-			checkIsolatedEmoji();
-		}
-		_textWidth = -1;
-		_textHeight = 0;
+	} else if (!_media) {
+		checkIsolatedEmoji();
 	}
+	_textHeights.clear();
 }
 
 void HistoryMessage::setEmptyText() {
+	_deferredText = nullptr;
 	_text.setMarkedText(
 		st::messageTextStyle,
 		{ QString(), EntitiesInText() },
 		Ui::ItemTextOptions(this));
 
-	_textWidth = -1;
-	_textHeight = 0;
+	_textHeights.clear();
 }
 
 void HistoryMessage::clearIsolatedEmoji() {
@@ -1179,25 +1198,25 @@ void HistoryMessage::setReplyMarkup(const MTPReplyMarkup *markup) {
 }
 
 Ui::Text::IsolatedEmoji HistoryMessage::isolatedEmoji() const {
-	return _text.toIsolatedEmoji();
+	return text().toIsolatedEmoji();
 }
 
 TextWithEntities HistoryMessage::originalText() const {
 	if (emptyText()) {
 		return { QString(), EntitiesInText() };
 	}
-	return _text.toTextWithEntities();
+	return text().toTextWithEntities();
 }
 
 TextForMimeData HistoryMessage::clipboardText() const {
 	if (emptyText()) {
 		return TextForMimeData();
 	}
-	return _text.toTextForMimeData();
+	return text().toTextForMimeData();
 }
 
 bool HistoryMessage::textHasLinks() const {
-	return emptyText() ? false : _text.hasLinks();
+	return emptyText() ? false : text().hasLinks();
 }
 
 void HistoryMessage::setViewsCount(int32 count) {
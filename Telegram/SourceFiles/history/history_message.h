@@ -139,6 +139,7 @@ public:
 	[[nodiscard]] TextWithEntities originalText() const override;
 	[[nodiscard]] TextForMimeData clipboardText() const override;
 	[[nodiscard]] bool textHasLinks() const override;
+	void releaseText() override;
 
 	[[nodiscard]] int viewsCount() const override;
 	bool updateDependencyItem() override;
@@ -161,6 +162,8 @@ public:
 
 private:
 	void setEmptyText();
+	void parseDeferredText(TextWithEntities &&text) override;
+	void applyText(const TextWithEntities &textWithEntities);
 	[[nodiscard]] bool isTooOldForEdit(TimeId now) const;
 	[[nodiscard]] bool isLegacyMessage() const {
 		return _flags & MTPDmessage::Flag::f_legacy;
@@ -579,8 +579,7 @@ void HistoryService::setServiceText(const PreparedText &prepared) {
 		// Link indices start with 1.
 		_text.setLink(++linkIndex, link);
 	}
-	_textWidth = -1;
-	_textHeight = 0;
+	_textHeights.clear();
 }
 
 void HistoryService::markMediaAsReadHook() {
@@ -706,8 +705,7 @@ void HistoryService::removeMedia() {
 	if (!_media) return;
 
 	_media.reset();
-	_textWidth = -1;
-	_textHeight = 0;
+	_textHeights.clear();
 	history()->owner().requestItemResize(this);
 }
 
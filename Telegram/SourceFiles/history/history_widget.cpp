@@ -98,7 +98,10 @@ namespace {
 
 constexpr auto kMessagesPerPageFirst = 30;
 constexpr auto kMessagesPerPage = 50;
+constexpr auto kMessagesPerPageMax = 100;
 constexpr auto kPreloadHeightsCount = 3; // when 3 screens to scroll left make a preload request
+constexpr auto kScrollSpeedTimeout = crl::time(200);
+constexpr auto kScrollSpeedMax = 20.; // pixels per millisecond
 constexpr auto kTabbedSelectorToggleTooltipTimeoutMs = 3000;
 constexpr auto kTabbedSelectorToggleTooltipCount = 3;
 constexpr auto kScrollToVoiceAfterScrolledMs = 1000;
@@ -112,6 +115,8 @@ constexpr auto kSaveDraftAnywayTimeout = 5000;
 constexpr auto kSaveCloudDraftIdleTimeout = 14000;
 constexpr auto kRecordingUpdateDelta = crl::time(100);
 constexpr auto kRefreshSlowmodeLabelTimeout = crl::time(200);
+constexpr auto kResizeOutdatedDelay = crl::time(16);
+constexpr auto kResizeOutdatedBudget = crl::time(8);
 
 ApiWrap::RequestMessageDataCallback replyEditMessageDataCallback() {
 	return [](ChannelData *channel, MsgId msgId) {
@@ -332,6 +337,7 @@ HistoryWidget::HistoryWidget(
 	connect(Media::Capture::instance(), SIGNAL(error()), this, SLOT(onRecordError()));
 	connect(Media::Capture::instance(), SIGNAL(updated(quint16,qint32)), this, SLOT(onRecordUpdate(quint16,qint32)));
 	connect(Media::Capture::instance(), SIGNAL(done(QByteArray,VoiceWaveform,qint32)), this, SLOT(onRecordDone(QByteArray,VoiceWaveform,qint32)));
+	connect(Media::Capture::instance(), SIGNAL(encoded(QByteArray)), this, SLOT(onRecordEncoded(QByteArray)));
 
 	_attachToggle->addClickHandler(App::LambdaDelayed(
 		st::historyAttach.ripple.hideDuration,
@@ -344,6 +350,7 @@ HistoryWidget::HistoryWidget(
 	_scrollTimer.setSingleShot(false);
 
 	_highlightTimer.setCallback([this] { updateHighlightedMessage(); });
+	_resizeOutdatedTimer.setCallback([=] { resizeOutdatedBlocksByTimer(); });
 
 	_membersDropdownShowTimer.setSingleShot(true);
 	connect(&_membersDropdownShowTimer, SIGNAL(timeout()), this, SLOT(onMembersDropdownShow()));
@@ -477,8 +484,13 @@ HistoryWidget::HistoryWidget(
 
 	session().data().viewResizeRequest(
 	) | rpl::start_with_next([=](not_null<HistoryView::Element*> view) {
-		if (view->data()->mainView() == view) {
-			updateHistoryGeometry();
+		if (view->data()->mainView() == view
+			&& !_updateHistoryGeometryQueued) {
+			_updateHistoryGeometryQueued = true;
+			crl::on_main(this, [=] {
+				_updateHistoryGeometryQueued = false;
+				updateHistoryGeometry();
+			});
 		}
 	}, lifetime());
 
@@ -949,6 +961,10 @@ void HistoryWidget::start() {
 	subscribe(session().api().fullPeerUpdated(), [this](PeerData *peer) {
 		fullPeerUpdated(peer);
 	});
+	session().api().webPagePreviewReceived(
+	) | rpl::start_with_next([=](const ApiWrap::WebPagePreview &data) {
+		gotPreview(data.links, data.page);
+	}, lifetime());
 }
 
 void HistoryWidget::onMentionInsert(UserData *user) {
@@ -1329,13 +1345,30 @@ void HistoryWidget::onRecordDone(
 		QByteArray result,
 		VoiceWaveform waveform,
 		qint32 samples) {
-	if (!canWriteMessage() || result.isEmpty()) return;
+	const auto streamedId = base::take(_recordingStreamedId);
+	if (!canWriteMessage() || result.isEmpty()) {
+		if (streamedId) {
+			session().uploader().cancelStreamed(streamedId);
+		}
+		return;
+	}
 
 	ActivateWindow(controller());
 	const auto duration = samples / Media::Player::kDefaultFrequency;
 	auto options = ApiWrap::SendOptions(_history);
 	options.replyTo = replyToId();
-	session().api().sendVoiceMessage(result, waveform, duration, options);
+	session().api().sendVoiceMessage(
+		result,
+		waveform,
+		duration,
+		options,
+		streamedId);
+}
+
+void HistoryWidget::onRecordEncoded(QByteArray bytes) {
+	if (_recordingStreamedId) {
+		session().uploader().feedStreamed(_recordingStreamedId, bytes);
+	}
 }
 
 void HistoryWidget::onRecordUpdate(quint16 level, qint32 samples) {
@@ -1699,7 +1732,6 @@ void HistoryWidget::showHistory(
 	_replyEditMsg = nullptr;
 	_editMsgId = _replyToId = 0;
 	_previewData = nullptr;
-	_previewCache.clear();
 	_fieldBarCancel->hide();
 
 	_membersDropdownShowTimer.stop();
@@ -1757,6 +1789,7 @@ void HistoryWidget::showHistory(
 			&& (!_history->loadedAtTop() || !_migrated->loadedAtBottom())) {
 			_migrated->clear(History::ClearType::Unload);
 		}
+		_peer->owner().historyShown(_history);
 
 		_topBar->setActiveChat(_history);
 		updateTopBarSelection();
@@ -2302,11 +2335,13 @@ void HistoryWidget::messagesReceived(PeerData *peer, const MTPmessages_Messages
 
 	if (_preloadRequest == requestId) {
 		auto to = toMigrated ? _migrated : _history;
+		preloadReceived(_preloadRequestSent);
 		addMessagesToFront(peer, *histList);
 		_preloadRequest = 0;
 		preloadHistoryIfNeeded();
 	} else if (_preloadDownRequest == requestId) {
 		auto to = toMigrated ? _migrated : _history;
+		preloadReceived(_preloadDownRequestSent);
 		addMessagesToBack(peer, *histList);
 		_preloadDownRequest = 0;
 		preloadHistoryIfNeeded();
@@ -2478,13 +2513,14 @@ void HistoryWidget::loadMessages() {
 	auto offsetId = from->minMsgId();
 	auto addOffset = 0;
 	auto loadCount = offsetId
-		? kMessagesPerPage
+		? preloadCount()
 		: kMessagesPerPageFirst;
 	auto offsetDate = 0;
 	auto maxId = 0;
 	auto minId = 0;
 	auto historyHash = 0;
 
+	_preloadRequestSent = crl::now();
 	_preloadRequest = MTP::send(
 		MTPmessages_GetHistory(
 			from->peer->input,
@@ -2512,7 +2548,7 @@ void HistoryWidget::loadMessagesDown() {
 		return;
 	}
 
-	auto loadCount = kMessagesPerPage;
+	auto loadCount = preloadCount();
 	auto addOffset = -loadCount;
 	auto offsetId = from->maxMsgId();
 	if (!offsetId) {
@@ -2525,6 +2561,7 @@ void HistoryWidget::loadMessagesDown() {
 	auto minId = 0;
 	auto historyHash = 0;
 
+	_preloadDownRequestSent = crl::now();
 	_preloadDownRequest = MTP::send(
 		MTPmessages_GetHistory(
 			from->peer->input,
@@ -2620,6 +2657,10 @@ void HistoryWidget::visibleAreaUpdated() {
 		auto scrollTop = _scroll->scrollTop();
 		auto scrollBottom = scrollTop + _scroll->height();
 		_list->visibleAreaUpdated(scrollTop, scrollBottom);
+		if (resizeOutdatedBlocks(0)) {
+			// Called again from updateHistoryGeometry() with fresh heights.
+			return;
+		}
 		if (_history->loadedAtBottom() && (_history->unreadCount() > 0 || (_migrated && _migrated->unreadCount() > 0))) {
 			const auto unread = firstUnreadMessage();
 			const auto unreadVisible = unread
@@ -2639,19 +2680,55 @@ void HistoryWidget::preloadHistoryIfNeeded() {
 		return;
 	}
 
+	auto scrollTop = _scroll->scrollTop();
+	if (scrollTop != _lastScrollTop) {
+		const auto now = crl::now();
+		updateScrollSpeed(scrollTop - _lastScrollTop, now - _lastScrolled);
+		_lastScrolled = now;
+		_lastScrollTop = scrollTop;
+	}
+
 	updateHistoryDownVisibility();
 	if (!_scrollToAnimation.animating()) {
 		preloadHistoryByScroll();
 		checkReplyReturns();
 	}
+}
 
-	auto scrollTop = _scroll->scrollTop();
-	if (scrollTop != _lastScrollTop) {
-		_lastScrolled = crl::now();
-		_lastScrollTop = scrollTop;
+void HistoryWidget::updateScrollSpeed(int delta, crl::time elapsed) {
+	// Scroll top jumps when messages are added above, that isn't speed.
+	const auto speed = (_synteticScrollEvent
+		|| elapsed <= 0
+		|| elapsed >= kScrollSpeedTimeout)
+		? 0.
+		: std::min(std::abs(delta) / double(elapsed), kScrollSpeedMax);
+	_scrollSpeed = (_scrollSpeed + speed) / 2.;
+}
+
+void HistoryWidget::preloadReceived(crl::time sent) {
+	if (sent > 0) {
+		const auto latency = crl::now() - sent;
+		_preloadLatency = _preloadLatency
+			? (_preloadLatency + latency) / 2
+			: latency;
 	}
 }
 
+int HistoryWidget::preloadHeight() const {
+	// Enough to keep scrolling at the current speed until the data arrives.
+	return kPreloadHeightsCount * _scroll->height()
+		+ int(std::round(_scrollSpeed * _preloadLatency));
+}
+
+int HistoryWidget::preloadCount() const {
+	const auto height = std::max(_scroll->height(), 1);
+	const auto screens = preloadHeight() / double(height);
+	return std::clamp(
+		int(std::round(kMessagesPerPage * screens / kPreloadHeightsCount)),
+		kMessagesPerPage,
+		kMessagesPerPageMax);
+}
+
 void HistoryWidget::preloadHistoryByScroll() {
 	if (_firstLoadRequest || _scroll->isHidden() || !_peer) {
 		return;
@@ -2659,11 +2736,11 @@ void HistoryWidget::preloadHistoryByScroll() {
 
 	auto scrollTop = _scroll->scrollTop();
 	auto scrollTopMax = _scroll->scrollTopMax();
-	auto scrollHeight = _scroll->height();
-	if (scrollTop + kPreloadHeightsCount * scrollHeight >= scrollTopMax) {
+	const auto preload = preloadHeight();
+	if (scrollTop + preload >= scrollTopMax) {
 		loadMessagesDown();
 	}
-	if (scrollTop <= kPreloadHeightsCount * scrollHeight) {
+	if (scrollTop <= preload) {
 		loadMessages();
 	}
 }
@@ -3191,6 +3268,10 @@ void HistoryWidget::recordStartCallback() {
 
 	emit Media::Capture::instance()->start();
 
+	if (_recordingStreamedId) {
+		session().uploader().cancelStreamed(_recordingStreamedId);
+	}
+	_recordingStreamedId = session().uploader().startStreamed();
 	_recording = _inField = true;
 	updateControlsVisibility();
 	activate();
@@ -3224,6 +3305,10 @@ void HistoryWidget::mouseReleaseEvent(QMouseEvent *e) {
 
 void HistoryWidget::stopRecording(bool send) {
 	emit Media::Capture::instance()->stop(send);
+	if (!send && _recordingStreamedId) {
+		session().uploader().cancelStreamed(
+			base::take(_recordingStreamedId));
+	}
 
 	_recordingLevel = anim::value();
 	_recordingAnimation.stop();
@@ -4620,7 +4705,7 @@ QPixmap HistoryWidget::grabForShowAnimation(
 	}
 	_inGrab = true;
 	updateControlsGeometry();
-	auto result = Ui::GrabWidget(this);
+	auto result = Window::SectionWidget::GrabForSlide(this);
 	_inGrab = false;
 	updateControlsGeometry();
 	if (params.withTopBarShadow) {
@@ -4644,7 +4729,7 @@ void HistoryWidget::onUpdateHistoryItems() {
 
 	auto ms = crl::now();
 	if (_lastScrolled + kSkipRepaintWhileScrollMs <= ms) {
-		_list->update();
+		_list->repaintSkippedItems();
 	} else {
 		_updateHistoryItems.start(_lastScrolled + kSkipRepaintWhileScrollMs - ms);
 	}
@@ -4954,6 +5039,28 @@ void HistoryWidget::updateListSize() {
 		_scroll->hide();
 	}
 	_updateHistoryGeometryRequired = true;
+	if (!_resizeOutdatedTimer.isActive() && _list->hasOutdatedBlocks()) {
+		_resizeOutdatedTimer.callOnce(kResizeOutdatedDelay);
+	}
+}
+
+bool HistoryWidget::resizeOutdatedBlocks(crl::time deadline) {
+	if (!_list
+		|| !_historyInited
+		|| _firstLoadRequest
+		|| _a_show.animating()
+		|| !_list->resizeOutdatedBlocks(deadline)) {
+		return false;
+	}
+	updateHistoryGeometry();
+	return true;
+}
+
+void HistoryWidget::resizeOutdatedBlocksByTimer() {
+	resizeOutdatedBlocks(crl::now() + kResizeOutdatedBudget);
+	if (_list && _list->hasOutdatedBlocks()) {
+		_resizeOutdatedTimer.callOnce(kResizeOutdatedDelay);
+	}
 }
 
 bool HistoryWidget::hasPendingResizedItems() const {
@@ -5914,7 +6021,6 @@ void HistoryWidget::cancelFieldAreaState() {
 }
 
 void HistoryWidget::previewCancel() {
-	MTP::cancel(base::take(_previewRequest));
 	_previewData = nullptr;
 	_previewLinks.clear();
 	updatePreview();
@@ -5930,23 +6036,18 @@ void HistoryWidget::checkPreview() {
 	}
 	const auto newLinks = _parsedLinks.join(' ');
 	if (_previewLinks != newLinks) {
-		MTP::cancel(base::take(_previewRequest));
 		_previewLinks = newLinks;
 		if (_previewLinks.isEmpty()) {
 			if (_previewData && _previewData->pendingTill >= 0) {
 				previewCancel();
 			}
 		} else {
-			const auto i = _previewCache.constFind(_previewLinks);
-			if (i == _previewCache.cend()) {
-				_previewRequest = MTP::send(
-					MTPmessages_GetWebPagePreview(
-						MTP_flags(0),
-						MTP_string(_previewLinks),
-						MTPVector<MTPMessageEntity>()),
-					rpcDone(&HistoryWidget::gotPreview, _previewLinks));
-			} else if (i.value()) {
-				_previewData = session().data().webpage(i.value());
+			const auto cached = session().api().cachedWebPagePreview(
+				_previewLinks);
+			if (!cached) {
+				session().api().requestWebPagePreview(_previewLinks);
+			} else if (*cached) {
+				_previewData = session().data().webpage(*cached);
 				updatePreview();
 			} else {
 				if (_previewData && _previewData->pendingTill >= 0) previewCancel();
@@ -5961,38 +6062,15 @@ void HistoryWidget::requestPreview() {
 		|| _previewLinks.isEmpty()) {
 		return;
 	}
-	_previewRequest = MTP::send(
-		MTPmessages_GetWebPagePreview(
-			MTP_flags(0),
-			MTP_string(_previewLinks),
-			MTPVector<MTPMessageEntity>()),
-		rpcDone(&HistoryWidget::gotPreview, _previewLinks));
+	session().api().requestWebPagePreview(_previewLinks);
 }
 
-void HistoryWidget::gotPreview(QString links, const MTPMessageMedia &result, mtpRequestId req) {
-	if (req == _previewRequest) {
-		_previewRequest = 0;
-	}
-	if (result.type() == mtpc_messageMediaWebPage) {
-		const auto &data = result.c_messageMediaWebPage().vwebpage();
-		const auto page = session().data().processWebpage(data);
-		_previewCache.insert(links, page->id);
-		if (page->pendingTill > 0 && page->pendingTill <= base::unixtime::now()) {
-			page->pendingTill = -1;
-		}
-		if (links == _previewLinks && !_previewCancelled) {
-			_previewData = (page->id && page->pendingTill >= 0)
-				? page.get()
-				: nullptr;
-			updatePreview();
-		}
-		session().data().sendWebPageGamePollNotifications();
-	} else if (result.type() == mtpc_messageMediaEmpty) {
-		_previewCache.insert(links, 0);
-		if (links == _previewLinks && !_previewCancelled) {
-			_previewData = nullptr;
-			updatePreview();
-		}
+void HistoryWidget::gotPreview(const QString &links, WebPageData *page) {
+	if (links == _previewLinks && !_previewCancelled) {
+		_previewData = (page && page->id && page->pendingTill >= 0)
+			? page
+			: nullptr;
+		updatePreview();
 	}
 }
 
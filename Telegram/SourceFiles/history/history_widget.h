@@ -301,6 +301,7 @@ public slots:
 	void onRecordError();
 	void onRecordDone(QByteArray result, VoiceWaveform waveform, qint32 samples);
 	void onRecordUpdate(quint16 level, qint32 samples);
+	void onRecordEncoded(QByteArray bytes);
 
 	void onUpdateHistoryItems();
 
@@ -548,14 +549,11 @@ private:
 
 	void checkPreview();
 	void requestPreview();
-	void gotPreview(QString links, const MTPMessageMedia &media, mtpRequestId req);
+	void gotPreview(const QString &links, WebPageData *page);
 
 	QStringList _parsedLinks;
 	QString _previewLinks;
 	WebPageData *_previewData = nullptr;
-	typedef QMap<QString, WebPageId> PreviewCache;
-	PreviewCache _previewCache;
-	mtpRequestId _previewRequest = 0;
 	Ui::Text::String _previewTitle;
 	Ui::Text::String _previewDescription;
 	base::Timer _previewTimer;
@@ -594,6 +592,8 @@ private:
 	};
 	void updateHistoryGeometry(bool initial = false, bool loadedDown = false, const ScrollChange &change = { ScrollChangeNone, 0 });
 	void updateListSize();
+	bool resizeOutdatedBlocks(crl::time deadline);
+	void resizeOutdatedBlocksByTimer();
 
 	// Does any of the shown histories has this flag set.
 	bool hasPendingResizedItems() const;
@@ -641,6 +641,12 @@ private:
 	int countInitialScrollTop();
 	int countAutomaticScrollTop();
 	void preloadHistoryByScroll();
+	void updateScrollSpeed(int delta, crl::time elapsed);
+	void preloadReceived(crl::time sent);
+
+	// Both grow with the scroll speed and the preload requests latency.
+	[[nodiscard]] int preloadHeight() const;
+	[[nodiscard]] int preloadCount() const;
 	void checkReplyReturns();
 	void scrollToAnimationCallback(FullMsgId attachToId, int relativeTo);
 
@@ -658,6 +664,10 @@ private:
 	mtpRequestId _firstLoadRequest = 0;
 	mtpRequestId _preloadRequest = 0;
 	mtpRequestId _preloadDownRequest = 0;
+	crl::time _preloadRequestSent = 0;
+	crl::time _preloadDownRequestSent = 0;
+	crl::time _preloadLatency = 0;
+	double _scrollSpeed = 0.;
 
 	MsgId _delayedShowAtMsgId = -1;
 	mtpRequestId _delayedShowAtRequest = 0;
@@ -671,6 +681,10 @@ private:
 	bool _historyInited = false;
 	// If updateListSize() was called without updateHistoryGeometry().
 	bool _updateHistoryGeometryRequired = false;
+	// Resize requests of a batch are applied in one updateHistoryGeometry().
+	bool _updateHistoryGeometryQueued = false;
+	// Lays out the messages far from the visible area after a resize.
+	base::Timer _resizeOutdatedTimer;
 	int _addToScroll = 0;
 
 	int _lastScrollTop = 0; // gifs optimization
@@ -736,6 +750,7 @@ private:
 	bool _inPinnedMsg = false;
 	bool _inClickable = false;
 	int _recordingSamples = 0;
+	uint64 _recordingStreamedId = 0;
 	int _recordCancelWidth;
 
 	rpl::lifetime _uploaderSubscriptions;
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "history/view/history_view_object.h"
 #include "base/runtime_composer.h"
+#include "base/object_pool.h"
 #include "base/flags.h"
 
 class HistoryBlock;
@@ -128,6 +129,7 @@ struct DateBadge : public RuntimeComponent<DateBadge, Element> {
 class Element
 	: public Object
 	, public RuntimeComposer<Element>
+	, public base::pooled<Element>
 	, public ClickHandlerHost {
 public:
 	Element(
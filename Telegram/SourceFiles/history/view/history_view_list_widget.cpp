@@ -41,6 +41,7 @@ namespace HistoryView {
 namespace {
 
 constexpr auto kScrollDateHideTimeout = 1000;
+constexpr auto kUnloadHeavyPartsPages = 3;
 constexpr auto kPreloadedScreensCount = 4;
 constexpr auto kPreloadIfLessThanScreens = 2;
 constexpr auto kPreloadedScreensCountFull
@@ -589,6 +590,13 @@ void ListWidget::visibleTopBottomUpdated(
 	}
 	_controller->floatPlayerAreaUpdated().notify(true);
 	_applyUpdatedScrollState.call();
+
+	// Unload lottie animations and stop far scrolled gifs.
+	const auto pages = kUnloadHeavyPartsPages;
+	const auto visibleHeight = visibleBottom - visibleTop;
+	const auto from = _visibleTop - pages * visibleHeight;
+	const auto till = _visibleBottom + pages * visibleHeight;
+	session().data().unloadHeavyViewParts(this, from, till);
 }
 
 void ListWidget::applyUpdatedScrollState() {
@@ -1430,25 +1438,23 @@ TextForMimeData ListWidget::getSelectedText() const {
 
 	const auto timeFormat = qsl(", [dd.MM.yy hh:mm]\n");
 	auto groups = base::flat_set<not_null<const Data::Group*>>();
-	auto fullSize = 0;
-	auto texts = std::vector<std::pair<
-		not_null<HistoryItem*>,
-		TextForMimeData>>();
-	texts.reserve(selected.size());
+
+	// Parts are collected unsorted and written to the result in one pass.
+	struct Part {
+		not_null<HistoryItem*> item;
+		QString time;
+		TextForMimeData text;
+	};
+	auto parts = std::vector<Part>();
+	parts.reserve(selected.size());
 
 	const auto wrapItem = [&](
 			not_null<HistoryItem*> item,
 			TextForMimeData &&unwrapped) {
-		auto time = ItemDateTime(item).toString(timeFormat);
-		auto part = TextForMimeData();
-		auto size = item->author()->name.size()
-			+ time.size()
-			+ unwrapped.expanded.size();
-		part.reserve(size);
-		part.append(item->author()->name).append(time);
-		part.append(std::move(unwrapped));
-		texts.emplace_back(std::move(item), std::move(part));
-		fullSize += size;
+		parts.push_back({
+			item,
+			ItemDateTime(item).toString(timeFormat),
+			std::move(unwrapped) });
 	};
 	const auto addItem = [&](not_null<HistoryItem*> item) {
 		wrapItem(item, HistoryItemText(item));
@@ -1476,17 +1482,27 @@ TextForMimeData ListWidget::getSelectedText() const {
 			}
 		}
 	}
-	ranges::sort(texts, [&](
-			const std::pair<not_null<HistoryItem*>, TextForMimeData> &a,
-			const std::pair<not_null<HistoryItem*>, TextForMimeData> &b) {
-		return _delegate->listIsLessInOrder(a.first, b.first);
+	if (parts.empty()) {
+		return TextForMimeData();
+	}
+	ranges::sort(parts, [&](const Part &a, const Part &b) {
+		return _delegate->listIsLessInOrder(a.item, b.item);
 	});
 
+	const auto sep = qstr("\n\n");
+	auto fullSize = (int(parts.size()) - 1) * sep.size();
+	auto entitiesCount = 0;
+	for (const auto &part : parts) {
+		fullSize += part.item->author()->name.size()
+			+ part.time.size()
+			+ part.text.expanded.size();
+		entitiesCount += part.text.rich.entities.size();
+	}
 	auto result = TextForMimeData();
-	auto sep = qstr("\n\n");
-	result.reserve(fullSize + (texts.size() - 1) * sep.size());
-	for (auto i = begin(texts), e = end(texts); i != e;) {
-		result.append(std::move(i->second));
+	result.reserve(fullSize, entitiesCount);
+	for (auto i = begin(parts), e = end(parts); i != e;) {
+		result.append(i->item->author()->name).append(i->time);
+		result.append(std::move(i->text));
 		if (++i != e) {
 			result.append(sep);
 		}
@@ -0,0 +1,51 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "ui/text/text.h"
+
+#include <array>
+
+namespace HistoryView {
+
+// Text heights counted for the last few widths, so that returning to
+// a recent width (like toggling the third column) costs no layout.
+class TextHeights final {
+public:
+	[[nodiscard]] int count(const Ui::Text::String &text, int width) const {
+		for (const auto &entry : _entries) {
+			if (entry.width == width) {
+				return entry.height;
+			}
+		}
+		auto &entry = _entries[_next];
+		_next = (_next + 1) % kCount;
+		entry.width = width;
+		entry.height = text.countHeight(width);
+		return entry.height;
+	}
+
+	// Must be called each time the text or its skip block is changed.
+	void clear() {
+		_entries = {};
+		_next = 0;
+	}
+
+private:
+	static constexpr auto kCount = 3;
+
+	struct Entry {
+		int width = -1;
+		int height = 0;
+	};
+	mutable std::array<Entry, kCount> _entries;
+	mutable int _next = 0;
+
+};
+
+} // namespace HistoryView
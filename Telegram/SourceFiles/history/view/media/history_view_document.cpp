@@ -120,6 +120,9 @@ QSize Document::countOptimalSize() {
 			_parent->skipBlockWidth(),
 			_parent->skipBlockHeight());
 	}
+	if (captioned) {
+		captioned->_captionHeights.clear();
+	}
 	auto thumbed = Get<HistoryDocumentThumbed>();
 	if (thumbed) {
 		_data->loadThumbnail(_realParent->fullId());
@@ -171,7 +174,7 @@ QSize Document::countOptimalSize() {
 		auto captionw = maxWidth
 			- st::msgPadding.left()
 			- st::msgPadding.right();
-		minHeight += captioned->_caption.countHeight(captionw);
+		minHeight += captioned->_captionHeights.count(captioned->_caption, captionw);
 		if (isBubbleBottom()) {
 			minHeight += st::msgPadding.bottom();
 		}
@@ -196,7 +199,7 @@ QSize Document::countCurrentSize(int newWidth) {
 		newHeight -= st::msgFileTopMinus;
 	}
 	auto captionw = newWidth - st::msgPadding.left() - st::msgPadding.right();
-	newHeight += captioned->_caption.countHeight(captionw);
+	newHeight += captioned->_captionHeights.count(captioned->_caption, captionw);
 	if (isBubbleBottom()) {
 		newHeight += st::msgPadding.bottom();
 	}
@@ -597,7 +600,7 @@ TextState Document::textState(QPoint point, StateRequest request) const {
 			return result;
 		}
 		auto captionw = width() - st::msgPadding.left() - st::msgPadding.right();
-		painth -= captioned->_caption.countHeight(captionw);
+		painth -= captioned->_captionHeights.count(captioned->_caption, captionw);
 		if (isBubbleBottom()) {
 			painth -= st::msgPadding.bottom();
 		}
@@ -56,6 +56,9 @@ public:
 	void stopAnimation() override {
 		if (_attach) _attach->stopAnimation();
 	}
+	void unloadHeavyPart() override {
+		if (_attach) _attach->unloadHeavyPart();
+	}
 
 	not_null<GameData*> game() {
 		return _data;
@@ -58,6 +58,7 @@ Gif::Gif(
 }
 
 QSize Gif::countOptimalSize() {
+	_captionHeights.clear();
 	if (_parent->media() != this) {
 		_caption = Ui::Text::String();
 	} else if (_caption.hasSkipBlock()) {
@@ -100,7 +101,7 @@ QSize Gif::countOptimalSize() {
 	if (_parent->hasBubble()) {
 		if (!_caption.isEmpty()) {
 			auto captionw = maxWidth - st::msgPadding.left() - st::msgPadding.right();
-			minHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+			minHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 			if (isBubbleBottom()) {
 				minHeight += st::msgPadding.bottom();
 			}
@@ -182,7 +183,7 @@ QSize Gif::countCurrentSize(int newWidth) {
 	if (_parent->hasBubble()) {
 		if (!_caption.isEmpty()) {
 			auto captionw = newWidth - st::msgPadding.left() - st::msgPadding.right();
-			newHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+			newHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 			if (isBubbleBottom()) {
 				newHeight += st::msgPadding.bottom();
 			}
@@ -269,7 +270,7 @@ void Gif::draw(Painter &p, const QRect &r, TextSelection selection, crl::time ms
 
 	if (bubble) {
 		if (!_caption.isEmpty()) {
-			painth -= st::mediaCaptionSkip + _caption.countHeight(captionw);
+			painth -= st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 			if (isBubbleBottom()) {
 				painth -= st::msgPadding.bottom();
 			}
@@ -543,7 +544,7 @@ TextState Gif::textState(QPoint point, StateRequest request) const {
 
 	if (bubble && !_caption.isEmpty()) {
 		auto captionw = paintw - st::msgPadding.left() - st::msgPadding.right();
-		painth -= _caption.countHeight(captionw);
+		painth -= _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			painth -= st::msgPadding.bottom();
 		}
@@ -885,10 +886,15 @@ void Gif::stopAnimation() {
 void Gif::setClipReader(::Media::Clip::ReaderPointer gif) {
 	if (_gif) {
 		history()->owner().unregisterAutoplayAnimation(_gif.get());
+		history()->owner().unregisterHeavyViewPart(_parent);
 	}
 	_gif = std::move(gif);
 	if (_gif) {
 		history()->owner().registerAutoplayAnimation(_gif.get(), _parent);
+
+		// Far scrolled readers are destroyed without waiting for the
+		// Clip::Manager to notice that their frames are not painted.
+		history()->owner().registerHeavyViewPart(_parent);
 	}
 }
 
@@ -57,6 +57,9 @@ public:
 	}
 
 	void stopAnimation() override;
+	void unloadHeavyPart() override {
+		stopAnimation();
+	}
 
 	TextWithEntities getCaption() const override {
 		return _caption.toTextWithEntities();
@@ -110,6 +113,7 @@ private:
 	int _thumbw = 1;
 	int _thumbh = 1;
 	Ui::Text::String _caption;
+	TextHeights _captionHeights;
 	::Media::Clip::ReaderPointer _gif;
 
 	void setStatusSize(int newSize) const;
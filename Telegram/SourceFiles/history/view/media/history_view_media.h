@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "history/view/history_view_object.h"
+#include "history/view/history_view_text_heights.h"
 
 struct HistoryMessageEdited;
 struct TextSelection;
@@ -62,6 +62,7 @@ GroupedMedia::GroupedMedia(
 }
 
 QSize GroupedMedia::countOptimalSize() {
+	_captionHeights.clear();
 	if (_caption.hasSkipBlock()) {
 		_caption.updateSkipBlock(
 			_parent->skipBlockWidth(),
@@ -95,7 +96,7 @@ QSize GroupedMedia::countOptimalSize() {
 
 	if (!_caption.isEmpty()) {
 		auto captionw = maxWidth - st::msgPadding.left() - st::msgPadding.right();
-		minHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+		minHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			minHeight += st::msgPadding.bottom();
 		}
@@ -144,7 +145,7 @@ QSize GroupedMedia::countCurrentSize(int newWidth) {
 
 	if (!_caption.isEmpty()) {
 		const auto captionw = newWidth - st::msgPadding.left() - st::msgPadding.right();
-		newHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+		newHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			newHeight += st::msgPadding.bottom();
 		}
@@ -197,7 +198,7 @@ void GroupedMedia::draw(
 		const auto outbg = _parent->hasOutLayout();
 		const auto captiony = height()
 			- (isBubbleBottom() ? st::msgPadding.bottom() : 0)
-			- _caption.countHeight(captionw);
+			- _captionHeights.count(_caption, captionw);
 		p.setPen(outbg ? (selected ? st::historyTextOutFgSelected : st::historyTextOutFg) : (selected ? st::historyTextInFgSelected : st::historyTextInFg));
 		_caption.draw(p, st::msgPadding.left(), captiony, captionw, style::al_left, 0, -1, selection);
 	} else if (_parent->media() == this) {
@@ -248,7 +249,7 @@ TextState GroupedMedia::textState(QPoint point, StateRequest request) const {
 		const auto captionw = width() - st::msgPadding.left() - st::msgPadding.right();
 		const auto captiony = height()
 			- (isBubbleBottom() ? st::msgPadding.bottom() : 0)
-			- _caption.countHeight(captionw);
+			- _captionHeights.count(_caption, captionw);
 		if (QRect(st::msgPadding.left(), captiony, captionw, height() - captiony).contains(point)) {
 			return TextState(_parent->data(), _caption.getState(
 				point - QPoint(st::msgPadding.left(), captiony),
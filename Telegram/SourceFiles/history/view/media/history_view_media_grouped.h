@@ -122,6 +122,7 @@ private:
 		StateRequest request) const;
 
 	Ui::Text::String _caption;
+	TextHeights _captionHeights;
 	std::vector<Part> _parts;
 	bool _needBubble = false;
 
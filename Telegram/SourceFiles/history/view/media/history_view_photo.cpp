@@ -58,6 +58,7 @@ void Photo::create(FullMsgId contextId, PeerData *chat) {
 }
 
 QSize Photo::countOptimalSize() {
+	_captionHeights.clear();
 	if (_parent->media() != this) {
 		_caption = Ui::Text::String();
 	} else if (_caption.hasSkipBlock()) {
@@ -92,7 +93,7 @@ QSize Photo::countOptimalSize() {
 	minHeight = qMax(th, st::minPhotoSize);
 	if (_parent->hasBubble() && !_caption.isEmpty()) {
 		auto captionw = maxActualWidth - st::msgPadding.left() - st::msgPadding.right();
-		minHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+		minHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			minHeight += st::msgPadding.bottom();
 		}
@@ -132,7 +133,7 @@ QSize Photo::countCurrentSize(int newWidth) {
 		const auto captionw = newWidth
 			- st::msgPadding.left()
 			- st::msgPadding.right();
-		newHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+		newHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			newHeight += st::msgPadding.bottom();
 		}
@@ -181,7 +182,7 @@ void Photo::draw(Painter &p, const QRect &r, TextSelection selection, crl::time
 	} else {
 		if (bubble) {
 			if (!_caption.isEmpty()) {
-				painth -= st::mediaCaptionSkip + _caption.countHeight(captionw);
+				painth -= st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 				if (isBubbleBottom()) {
 					painth -= st::msgPadding.bottom();
 				}
@@ -288,7 +289,7 @@ TextState Photo::textState(QPoint point, StateRequest request) const {
 		const auto captionw = paintw
 			- st::msgPadding.left()
 			- st::msgPadding.right();
-		painth -= _caption.countHeight(captionw);
+		painth -= _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			painth -= st::msgPadding.bottom();
 		}
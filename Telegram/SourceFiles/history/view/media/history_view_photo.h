@@ -96,6 +96,7 @@ private:
 	int _pixw = 1;
 	int _pixh = 1;
 	Ui::Text::String _caption;
+	TextHeights _captionHeights;
 
 };
 
@@ -83,6 +83,7 @@ QSize Video::countOptimalDimensions() const {
 }
 
 QSize Video::countOptimalSize() {
+	_captionHeights.clear();
 	if (_parent->media() != this) {
 		_caption = Ui::Text::String();
 	} else if (_caption.hasSkipBlock()) {
@@ -105,7 +106,7 @@ QSize Video::countOptimalSize() {
 		const auto captionw = maxWidth
 			- st::msgPadding.left()
 			- st::msgPadding.right();
-		minHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+		minHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			minHeight += st::msgPadding.bottom();
 		}
@@ -132,7 +133,7 @@ QSize Video::countCurrentSize(int newWidth) {
 		const auto captionw = newWidth
 			- st::msgPadding.left()
 			- st::msgPadding.right();
-		newHeight += st::mediaCaptionSkip + _caption.countHeight(captionw);
+		newHeight += st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			newHeight += st::msgPadding.bottom();
 		}
@@ -170,7 +171,7 @@ void Video::draw(Painter &p, const QRect &r, TextSelection selection, crl::time
 
 	if (bubble) {
 		if (!_caption.isEmpty()) {
-			painth -= st::mediaCaptionSkip + _caption.countHeight(captionw);
+			painth -= st::mediaCaptionSkip + _captionHeights.count(_caption, captionw);
 			if (isBubbleBottom()) {
 				painth -= st::msgPadding.bottom();
 			}
@@ -334,7 +335,7 @@ TextState Video::textState(QPoint point, StateRequest request) const {
 		const auto captionw = paintw
 			- st::msgPadding.left()
 			- st::msgPadding.right();
-		painth -= _caption.countHeight(captionw);
+		painth -= _captionHeights.count(_caption, captionw);
 		if (isBubbleBottom()) {
 			painth -= st::msgPadding.bottom();
 		}
@@ -98,6 +98,7 @@ private:
 	int _thumbw = 1;
 	int _thumbh = 1;
 	Ui::Text::String _caption;
+	TextHeights _captionHeights;
 
 	QString _downloadSize;
 
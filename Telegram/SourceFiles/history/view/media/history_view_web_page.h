@@ -62,6 +62,9 @@ public:
 	void stopAnimation() override {
 		if (_attach) _attach->stopAnimation();
 	}
+	void unloadHeavyPart() override {
+		if (_attach) _attach->unloadHeavyPart();
+	}
 
 	not_null<WebPageData*> webpage() {
 		return _data;
@@ -902,8 +902,19 @@ void ListWidget::refreshRows() {
 	markLayoutsStale();
 
 	_sections.clear();
-	auto section = Section(_type);
 	auto count = _slice.size();
+
+	// Free the layouts that left the slice before creating the new ones,
+	// so that their pooled memory is reused while scrolling.
+	for (auto i = 0; i != count; ++i) {
+		const auto j = _layouts.find(GetUniversalId(_slice[i]));
+		if (j != _layouts.end()) {
+			j->second.stale = false;
+		}
+	}
+	clearStaleLayouts();
+
+	auto section = Section(_type);
 	for (auto i = count; i != 0;) {
 		auto universalId = GetUniversalId(_slice[--i]);
 		if (auto layout = getLayout(universalId)) {
@@ -924,8 +935,6 @@ void ListWidget::refreshRows() {
 		}
 	}
 
-	clearStaleLayouts();
-
 	resizeToWidth(width());
 	restoreScrollState();
 	mouseActionUpdate();
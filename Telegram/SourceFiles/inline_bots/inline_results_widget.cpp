@@ -1030,13 +1030,17 @@ void Widget::inlineBotChanged() {
 	_inlineRequestId = 0;
 	_inlineQuery = _inlineNextQuery = _inlineNextOffset = QString();
 	_inlineBot = nullptr;
-	_inlineCache.clear();
 	_inner->inlineBotChanged();
 	_inner->hideInlineRowsPanel();
 
 	Notify::inlineBotRequesting(false);
 }
 
+void Widget::clearInlineCache() {
+	_inner->inlineBotChanged();
+	_inlineCache.clear();
+}
+
 void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 	_inlineRequestId = 0;
 	Notify::inlineBotRequesting(false);
@@ -1052,6 +1056,8 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 
 		if (it == _inlineCache.cend()) {
 			it = _inlineCache.emplace(_inlineQuery, std::make_unique<internal::CacheEntry>()).first;
+			it->second->expires = crl::now()
+				+ d.vcache_time().v * crl::time(1000);
 		}
 		auto entry = it->second.get();
 		entry->nextOffset = qs(d.vnext_offset().value_or_empty());
@@ -1095,12 +1101,24 @@ void Widget::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 		force = true;
 	}
 
+	// Results are kept while the same bot is reopened in the same chat,
+	// until the cache_time of any of them passes.
+	if (_inlineCacheBot != bot || _inlineCachePeer != peer) {
+		clearInlineCache();
+		_inlineCacheBot = bot;
+		_inlineCachePeer = peer;
+	}
+
 	if (_inlineQuery != query || force) {
 		if (_inlineRequestId) {
 			MTP::cancel(_inlineRequestId);
 			_inlineRequestId = 0;
 			Notify::inlineBotRequesting(false);
 		}
+		const auto i = _inlineCache.find(query);
+		if (i != _inlineCache.cend() && i->second->expires <= crl::now()) {
+			clearInlineCache();
+		}
 		if (_inlineCache.find(query) != _inlineCache.cend()) {
 			_inlineRequestTimer.stop();
 			_inlineQuery = _inlineNextQuery = query;
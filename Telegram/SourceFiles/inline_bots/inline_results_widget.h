@@ -47,6 +47,7 @@ struct CacheEntry {
 	QString nextOffset;
 	QString switchPmText, switchPmStartToken;
 	Results results;
+	crl::time expires = 0;
 };
 
 class Inner
@@ -237,6 +238,7 @@ private:
 	void updateContentHeight();
 
 	void inlineBotChanged();
+	void clearInlineCache();
 	int showInlineRows(bool newResults);
 	void recountContentMaxHeight();
 	bool refreshInlineRows(int *added = nullptr);
@@ -264,6 +266,8 @@ private:
 	QPointer<internal::Inner> _inner;
 
 	std::map<QString, std::unique_ptr<internal::CacheEntry>> _inlineCache;
+	UserData *_inlineCacheBot = nullptr;
+	PeerData *_inlineCachePeer = nullptr;
 	QTimer _inlineRequestTimer;
 
 	UserData *_inlineBot = nullptr;
@@ -98,6 +98,7 @@ details::InitData Init(
 details::InitData Init(
 		const QByteArray &content,
 		FnMut<void(QByteArray &&cached)> put,
+		CacheChunks chunks,
 		const QByteArray &cached,
 		const FrameRequest &request,
 		Quality quality,
@@ -107,7 +108,11 @@ details::InitData Init(
 	if (const auto error = ContentError(content)) {
 		return *error;
 	}
-	auto cache = std::make_unique<Cache>(cached, request, std::move(put));
+	auto cache = std::make_unique<Cache>(
+		cached,
+		request,
+		std::move(put),
+		std::move(chunks));
 	const auto prepare = !cache->framesCount()
 		|| (cache->framesReady() < cache->framesCount());
 	auto animation = prepare
@@ -163,6 +168,39 @@ QImage ReadThumbnail(const QByteArray &content) {
 	});
 }
 
+bool PrepareCache(
+		FnMut<void(QByteArray &&cached)> put,
+		CacheChunks chunks,
+		const QByteArray &cached,
+		const QByteArray &content,
+		const FrameRequest &request,
+		Quality quality,
+		Fn<bool()> cancelled) {
+	auto data = Init(
+		content,
+		std::move(put),
+		std::move(chunks),
+		cached,
+		request,
+		quality,
+		nullptr);
+	return data.match([&](const std::unique_ptr<SharedState> &state) {
+		if (state->allFramesCached()) {
+			return true;
+		}
+		auto frame = QImage();
+		for (auto i = 1, count = state->framesCount(); i != count; ++i) {
+			if (cancelled()) {
+				return false;
+			}
+			state->renderFrame(frame, request, i);
+		}
+		return true;
+	}, [](Error) {
+		return true;
+	});
+}
+
 Animation::Animation(
 	not_null<Player*> player,
 	const QByteArray &content,
@@ -183,6 +221,7 @@ Animation::Animation(
 	not_null<Player*> player,
 	FnMut<void(FnMut<void(QByteArray &&cached)>)> get, // Main thread.
 	FnMut<void(QByteArray &&cached)> put, // Unknown thread.
+	CacheChunks chunks,
 	const QByteArray &content,
 	const FrameRequest &request,
 	Quality quality,
@@ -194,6 +233,7 @@ Animation::Animation(
 			auto result = Init(
 				content,
 				std::move(put),
+				std::move(chunks),
 				cached,
 				request,
 				quality,
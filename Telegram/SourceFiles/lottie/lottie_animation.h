@@ -29,6 +29,17 @@ std::shared_ptr<FrameRenderer> MakeFrameRenderer();
 
 QImage ReadThumbnail(const QByteArray &content);
 
+// Renders the frames missing in the cache on the calling thread.
+// Returns false if stopped because cancelled() returned true.
+bool PrepareCache(
+	FnMut<void(QByteArray &&cached)> put,
+	CacheChunks chunks,
+	const QByteArray &cached,
+	const QByteArray &content,
+	const FrameRequest &request,
+	Quality quality,
+	Fn<bool()> cancelled);
+
 namespace details {
 
 using InitData = base::variant<std::unique_ptr<SharedState>, Error>;
@@ -56,6 +67,7 @@ public:
 		not_null<Player*> player,
 		FnMut<void(FnMut<void(QByteArray &&cached)>)> get, // Main thread.
 		FnMut<void(QByteArray &&cached)> put, // Unknown thread.
+		CacheChunks chunks,
 		const QByteArray &content,
 		const FrameRequest &request,
 		Quality quality,
@@ -10,12 +10,22 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "lottie/lottie_frame_renderer.h"
 #include "ffmpeg/ffmpeg_utility.h"
 #include "base/bytes.h"
+#include "base/build_config.h"
 
 #include <QDataStream>
 #include <lz4.h>
 #include <lz4hc.h>
 #include <range/v3/numeric/accumulate.hpp>
 
+#ifdef ARCH_CPU_X86_FAMILY
+#include <emmintrin.h>
+#ifdef COMPILER_MSVC
+#define TDESKTOP_XOR_TARGET
+#else // COMPILER_MSVC
+#define TDESKTOP_XOR_TARGET __attribute__((target("sse2")))
+#endif // COMPILER_MSVC
+#endif // ARCH_CPU_X86_FAMILY
+
 namespace Lottie {
 namespace {
 
@@ -24,9 +34,45 @@ constexpr auto kAlignStorage = 16;
 // Must not exceed max database allowed entry size.
 constexpr auto kMaxCacheSize = 10 * 1024 * 1024;
 
+// Larger caches are written as a header and kMaxCacheSize chunks.
+constexpr auto kMaxChunkedCacheSize = 64 * 1024 * 1024;
+constexpr auto kMaxCacheChunks = 32;
+
+// Seeking decodes at most that many frames to reach the requested one.
+constexpr auto kKeyframeInterval = 30;
+
+#ifdef ARCH_CPU_X86_FAMILY
+
+// Both storages are aligned by kAlignStorage.
+TDESKTOP_XOR_TARGET void XorSSE2(uchar *to, const uchar *from, int amount) {
+	static_assert(kAlignStorage % sizeof(__m128i) == 0);
+
+	const auto blocks = amount / int(sizeof(__m128i));
+	const auto fromBlocks = reinterpret_cast<const __m128i*>(from);
+	const auto toBlocks = reinterpret_cast<__m128i*>(to);
+	for (auto i = 0; i != blocks; ++i) {
+		_mm_store_si128(
+			toBlocks + i,
+			_mm_xor_si128(
+				_mm_load_si128(toBlocks + i),
+				_mm_load_si128(fromBlocks + i)));
+	}
+	for (auto i = blocks * int(sizeof(__m128i)); i != amount; ++i) {
+		to[i] ^= from[i];
+	}
+}
+
+#endif // ARCH_CPU_X86_FAMILY
+
 void Xor(EncodedStorage &to, const EncodedStorage &from) {
 	Expects(to.size() == from.size());
 
+#ifdef ARCH_CPU_X86_FAMILY
+	XorSSE2(
+		reinterpret_cast<uchar*>(to.data()),
+		reinterpret_cast<const uchar*>(from.data()),
+		from.size());
+#else // ARCH_CPU_X86_FAMILY
 	using Block = std::conditional_t<
 		sizeof(void*) == sizeof(uint64),
 		uint64,
@@ -45,6 +91,7 @@ void Xor(EncodedStorage &to, const EncodedStorage &from) {
 	for (auto i = amount - left; i != amount; ++i) {
 		toBytes[i] ^= fromBytes[i];
 	}
+#endif // ARCH_CPU_X86_FAMILY
 }
 
 bool UncompressToRaw(EncodedStorage &to, bytes::const_span from) {
@@ -372,12 +419,13 @@ int EncodedStorage::aBytesPerLine() const {
 Cache::Cache(
 	const QByteArray &data,
 	const FrameRequest &request,
-	FnMut<void(QByteArray &&cached)> put)
+	FnMut<void(QByteArray &&cached)> put,
+	CacheChunks chunks)
 : _data(data)
-, _put(std::move(put)) {
+, _put(std::move(put))
+, _chunks(std::move(chunks)) {
 	if (!readHeader(request)) {
-		_framesReady = 0;
-		_data = QByteArray();
+		dropData();
 	}
 }
 
@@ -419,7 +467,9 @@ bool Cache::readHeader(const FrameRequest &request) {
 
 	auto encoder = qint32(0);
 	stream >> encoder;
-	if (static_cast<Encoder>(encoder) != Encoder::YUV420A4_LZ4) {
+	if (static_cast<Encoder>(encoder) != Encoder::YUV420A4_LZ4
+		&& static_cast<Encoder>(encoder) != Encoder::YUV420A4_LZ4_Keyframes
+		&& static_cast<Encoder>(encoder) != Encoder::YUV420A4_LZ4_Chunked) {
 		return false;
 	}
 	auto size = QSize();
@@ -452,10 +502,141 @@ bool Cache::readHeader(const FrameRequest &request) {
 	_frameRate = frameRate;
 	_framesCount = framesCount;
 	_framesReady = framesReady;
+	_keyframeOffsets.clear();
+	if (_encoder == Encoder::YUV420A4_LZ4_Chunked) {
+		if (!readChunks(stream)) {
+			return false;
+		}
+	} else if (canSeek() && !indexKeyframes(0, headerSize())) {
+		return false;
+	}
 	prepareBuffers();
 	return renderFrame(_firstFrame, request, 0);
 }
 
+bool Cache::readChunks(QDataStream &stream) {
+	auto count = qint32(0);
+	stream >> count;
+	if (stream.status() != QDataStream::Ok
+		|| !_chunks
+		|| (count <= 0)
+		|| (count > kMaxCacheChunks)) {
+		return false;
+	}
+	_chunksTable.reserve(count);
+	for (auto i = 0; i != count; ++i) {
+		auto firstFrame = qint32(0);
+		auto size = qint32(0);
+		stream >> firstFrame >> size;
+		const auto previous = _chunksTable.empty()
+			? -1
+			: _chunksTable.back().firstFrame;
+		if (stream.status() != QDataStream::Ok
+			|| (!i && firstFrame != 0)
+			|| (firstFrame <= previous)
+			|| (firstFrame >= _framesReady)
+			|| (firstFrame % kKeyframeInterval)
+			|| (size <= 0)
+			|| (size > kMaxCacheSize)) {
+			return false;
+		}
+		_chunksTable.push_back({ firstFrame, size });
+	}
+	return true;
+}
+
+bool Cache::loadChunk(int index) {
+	if (_chunksTable.empty()) {
+		return true;
+	}
+	const auto i = std::upper_bound(
+		begin(_chunksTable),
+		end(_chunksTable),
+		index,
+		[](int index, const Chunk &chunk) {
+			return index < chunk.firstFrame;
+		});
+	const auto chunk = int(i - begin(_chunksTable)) - 1;
+	Assert(chunk >= 0);
+	if (chunk == _chunkLoaded) {
+		return true;
+	}
+	_data = _chunks.get(chunk);
+	_chunkLoaded = chunk;
+	_offsetFrameIndex = -1;
+	_keyframeOffsets.clear();
+	return (_data.size() == _chunksTable[chunk].size)
+		&& indexKeyframes(dataFirstFrame(), dataFirstOffset());
+}
+
+int Cache::dataFirstFrame() const {
+	return (_chunkLoaded >= 0) ? _chunksTable[_chunkLoaded].firstFrame : 0;
+}
+
+int Cache::dataFirstOffset() const {
+	return (_chunkLoaded >= 0) ? 0 : headerSize();
+}
+
+int Cache::dataFramesEnd() const {
+	return (_chunkLoaded >= 0
+		&& _chunkLoaded + 1 < int(_chunksTable.size()))
+		? _chunksTable[_chunkLoaded + 1].firstFrame
+		: _framesReady;
+}
+
+bool Cache::canSeek() const {
+	return (_encoder == Encoder::YUV420A4_LZ4_Keyframes)
+		|| (_encoder == Encoder::YUV420A4_LZ4_Chunked);
+}
+
+bool Cache::indexKeyframes(int fromIndex, int fromOffset) {
+	auto offset = fromOffset;
+	for (auto index = fromIndex; index != dataFramesEnd(); ++index) {
+		auto length = qint32(0);
+		if (offset + int(sizeof(length)) > _data.size()) {
+			return false;
+		}
+		memcpy(&length, _data.constData() + offset, sizeof(length));
+		const auto keyframe = !(index % kKeyframeInterval);
+		if (keyframe) {
+			if (length <= 0) {
+				return false;
+			}
+			_keyframeOffsets.push_back(offset);
+		}
+		offset += sizeof(length) + std::abs(length);
+	}
+	return (offset <= _data.size());
+}
+
+bool Cache::seek(int index) {
+	Expects(index > dataFirstFrame() && index < _framesReady);
+
+	const auto first = dataFirstFrame();
+	const auto keyframe = (index - first) / kKeyframeInterval;
+	if (!canSeek() || keyframe >= int(_keyframeOffsets.size())) {
+		return false;
+	}
+	const auto keyframeIndex = first + keyframe * kKeyframeInterval;
+
+	// Skipping a few frames forward doesn't need the keyframe.
+	if (_offsetFrameIndex <= keyframeIndex || _offsetFrameIndex > index) {
+		_offset = _keyframeOffsets[keyframe];
+		_offsetFrameIndex = keyframeIndex;
+	}
+	while (_offsetFrameIndex != index) {
+		const auto [ok, xored] = readCompressedFrame();
+		if (!ok) {
+			return false;
+		} else if (xored) {
+			Xor(_previous, _uncompressed);
+		} else {
+			std::swap(_uncompressed, _previous);
+		}
+	}
+	return true;
+}
+
 QImage Cache::takeFirstFrame() {
 	return std::move(_firstFrame);
 }
@@ -464,22 +645,30 @@ bool Cache::renderFrame(
 		QImage &to,
 		const FrameRequest &request,
 		int index) {
-	Expects(index >= _framesReady
-		|| index == _offsetFrameIndex
-		|| index == 0);
-
 	if (index >= _framesReady) {
 		return false;
 	} else if (request.size(_original) != _size) {
 		return false;
-	} else if (index == 0) {
-		_offset = headerSize();
-		_offsetFrameIndex = 0;
+	} else if (!loadChunk(index)) {
+		dropData();
+		return false;
+	}
+	const auto first = dataFirstFrame();
+	if (index == first) {
+		_offset = dataFirstOffset();
+		_offsetFrameIndex = first;
+	} else if (index != _offsetFrameIndex) {
+		Assert(canSeek());
+
+		// Frames waiting in _encode can't be seeked to yet.
+		if (!seek(index)) {
+			_offsetFrameIndex = -1;
+			return false;
+		}
 	}
 	const auto [ok, xored] = readCompressedFrame();
-	if (!ok || (xored && index == 0)) {
-		_framesReady = 0;
-		_data = QByteArray();
+	if (!ok || (xored && index == first)) {
+		dropData();
 		return false;
 	} else if (index + 1 == _framesReady && _data.size() > _offset) {
 		_data.resize(_offset);
@@ -498,23 +687,28 @@ void Cache::appendFrame(
 		const FrameRequest &request,
 		int index) {
 	if (request.size(_original) != _size) {
-		_framesReady = 0;
-		_data = QByteArray();
+		dropData();
 	}
 	if (index != _framesReady) {
 		return;
 	}
 	if (index == 0) {
+		dropData();
 		_size = request.size(_original);
+		_encoder = Encoder::YUV420A4_LZ4_Keyframes;
 		_encode = EncodeFields();
 		_encode.compressedFrames.reserve(_framesCount);
 		prepareBuffers();
 	}
 	Assert(frame.size() == _size);
+
+	// Encoding overwrites the last decoded frame.
+	_offsetFrameIndex = -1;
 	Encode(_uncompressed, frame, _encode.cache, _encode.context);
+	const auto keyframe = !(index % kKeyframeInterval);
 	CompressAndSwapFrame(
 		_encode.compressBuffer,
-		(index != 0) ? &_encode.xorCompressBuffer : nullptr,
+		keyframe ? nullptr : &_encode.xorCompressBuffer,
 		_uncompressed,
 		_previous);
 	const auto compressed = _encode.compressBuffer;
@@ -541,7 +735,8 @@ void Cache::finalizeEncoding() {
 		+ _encode.totalSize;
 	if (_data.isEmpty()) {
 		_data.reserve(size);
-		writeHeader();
+		QDataStream stream(&_data, QIODevice::WriteOnly);
+		writeHeader(stream, _encoder);
 	} else {
 		updateFramesReadyCount();
 	}
@@ -553,23 +748,96 @@ void Cache::finalizeEncoding() {
 		memcpy(to, block.data(), amount);
 		to += amount;
 	}
+	if (canSeek()) {
+		const auto fromIndex = _framesReady
+			- int(_encode.compressedFrames.size());
+		if (!indexKeyframes(fromIndex, offset)) {
+			_keyframeOffsets.clear();
+		}
+	}
 	if (_data.size() <= kMaxCacheSize) {
 		_put(QByteArray(_data));
+	} else if (_framesReady == _framesCount) {
+		putChunked();
 	}
 	_encode = EncodeFields();
 }
 
-int Cache::headerSize() const {
-	return 8 * sizeof(qint32);
+void Cache::putChunked() {
+	const auto keyframes = int(_keyframeOffsets.size());
+	if (!_chunks
+		|| _encoder != Encoder::YUV420A4_LZ4_Keyframes
+		|| _data.size() > kMaxChunkedCacheSize
+		|| !keyframes) {
+		return;
+	}
+	const auto endOffset = [&](int keyframe) {
+		return (keyframe == keyframes)
+			? _data.size()
+			: _keyframeOffsets[keyframe];
+	};
+	auto table = std::vector<Chunk>();
+	for (auto from = 0; from != keyframes;) {
+		const auto start = _keyframeOffsets[from];
+		auto till = from + 1;
+		if (endOffset(till) - start > kMaxCacheSize) {
+			return;
+		}
+		while (till != keyframes
+			&& endOffset(till + 1) - start <= kMaxCacheSize) {
+			++till;
+		}
+		table.push_back({
+			from * kKeyframeInterval,
+			endOffset(till) - start
+		});
+		from = till;
+	}
+	if (int(table.size()) > kMaxCacheChunks) {
+		return;
+	}
+	for (auto i = 0, count = int(table.size()); i != count; ++i) {
+		const auto offset = _keyframeOffsets[
+			table[i].firstFrame / kKeyframeInterval];
+		_chunks.put(i, _data.mid(offset, table[i].size));
+	}
+
+	// Put the header after the chunks it describes.
+	auto header = QByteArray();
+	{
+		QDataStream stream(&header, QIODevice::WriteOnly);
+		writeHeader(stream, Encoder::YUV420A4_LZ4_Chunked);
+		stream << qint32(table.size());
+		for (const auto &chunk : table) {
+			stream << qint32(chunk.firstFrame) << qint32(chunk.size);
+		}
+	}
+	_put(std::move(header));
+
+	// Keep only one chunk in memory, the next frame loads it again.
+	_encoder = Encoder::YUV420A4_LZ4_Chunked;
+	_chunksTable = std::move(table);
+	_chunkLoaded = -1;
+	_data = QByteArray();
+	_keyframeOffsets.clear();
+	_offsetFrameIndex = -1;
 }
 
-void Cache::writeHeader() {
-	Expects(_data.isEmpty());
+void Cache::dropData() {
+	_framesReady = 0;
+	_data = QByteArray();
+	_keyframeOffsets.clear();
+	_chunksTable.clear();
+	_chunkLoaded = -1;
+}
 
-	QDataStream stream(&_data, QIODevice::WriteOnly);
+int Cache::headerSize() const {
+	return 8 * sizeof(qint32);
+}
 
+void Cache::writeHeader(QDataStream &stream, Encoder encoder) const {
 	stream
-		<< static_cast<qint32>(_encoder)
+		<< static_cast<qint32>(encoder)
 		<< _size
 		<< _original
 		<< qint32(_frameRate)
@@ -8,15 +8,15 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "ffmpeg/ffmpeg_utility.h"
+#include "lottie/lottie_common.h"
 
 #include <QImage>
 #include <QSize>
 #include <QByteArray>
+#include <QDataStream>
 
 namespace Lottie {
 
-struct FrameRequest;
-
 class EncodedStorage {
 public:
 	void allocate(int width, int height);
@@ -54,12 +54,15 @@ class Cache {
 public:
 	enum class Encoder : qint8 {
 		YUV420A4_LZ4,
+		YUV420A4_LZ4_Keyframes, // Not XOR-d frame every kKeyframeInterval.
+		YUV420A4_LZ4_Chunked, // Keyframes format split in CacheChunks.
 	};
 
 	Cache(
 		const QByteArray &data,
 		const FrameRequest &request,
-		FnMut<void(QByteArray &&cached)> put);
+		FnMut<void(QByteArray &&cached)> put,
+		CacheChunks chunks);
 
 	void init(
 		QSize original,
@@ -72,6 +75,9 @@ public:
 	[[nodiscard]] QSize originalSize() const;
 	[[nodiscard]] QImage takeFirstFrame();
 
+	// If true renderFrame() accepts any ready frame index.
+	[[nodiscard]] bool canSeek() const;
+
 	[[nodiscard]] bool renderFrame(
 		QImage &to,
 		const FrameRequest &request,
@@ -88,6 +94,10 @@ private:
 		bool ok = false;
 		bool xored = false;
 	};
+	struct Chunk {
+		int firstFrame = 0;
+		int size = 0;
+	};
 	struct EncodeFields {
 		std::vector<QByteArray> compressedFrames;
 		QByteArray compressBuffer;
@@ -100,10 +110,21 @@ private:
 	void prepareBuffers();
 	void finalizeEncoding();
 
-	void writeHeader();
+	void writeHeader(QDataStream &stream, Encoder encoder) const;
 	void updateFramesReadyCount();
+	void putChunked();
+	void dropData();
 	[[nodiscard]] bool readHeader(const FrameRequest &request);
+	[[nodiscard]] bool readChunks(QDataStream &stream);
 	[[nodiscard]] ReadResult readCompressedFrame();
+	[[nodiscard]] bool indexKeyframes(int fromIndex, int fromOffset);
+	[[nodiscard]] bool seek(int index);
+
+	// In the chunked format _data holds only one chunk of frames.
+	[[nodiscard]] bool loadChunk(int index);
+	[[nodiscard]] int dataFirstFrame() const;
+	[[nodiscard]] int dataFirstOffset() const;
+	[[nodiscard]] int dataFramesEnd() const;
 
 	QByteArray _data;
 	EncodeFields _encode;
@@ -118,8 +139,12 @@ private:
 	int _framesReady = 0;
 	int _offset = 0;
 	int _offsetFrameIndex = 0;
-	Encoder _encoder = Encoder::YUV420A4_LZ4;
+	std::vector<int> _keyframeOffsets;
+	std::vector<Chunk> _chunksTable;
+	int _chunkLoaded = -1;
+	Encoder _encoder = Encoder::YUV420A4_LZ4_Keyframes;
 	FnMut<void(QByteArray &&cached)> _put;
+	CacheChunks _chunks;
 
 };
 
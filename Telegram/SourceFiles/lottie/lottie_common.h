@@ -56,6 +56,24 @@ enum class Quality : char {
 	High,
 };
 
+// Reduced renders at most 30 frames per second, Low at most 15 and at
+// half the resolution where the frames are not cached.
+enum class Detail : char {
+	Full,
+	Reduced,
+	Low,
+};
+
+// Additional records for caches that don't fit in a single one.
+struct CacheChunks {
+	Fn<QByteArray(int index)> get; // Unknown thread, may block.
+	Fn<void(int index, QByteArray &&chunk)> put; // Unknown thread.
+
+	explicit operator bool() const {
+		return get && put;
+	}
+};
+
 struct ColorReplacements {
 	std::vector<std::pair<std::uint32_t, std::uint32_t>> replacements;
 	uint8 tag = 0;
@@ -11,12 +11,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "lottie/lottie_animation.h"
 #include "lottie/lottie_cache.h"
 #include "base/flat_map.h"
+#include "base/tracing.h"
 #include "logs.h"
 
 #include <QPainter>
+#include <QThread>
 #include <rlottie.h>
+#include <crl/crl.h>
 #include <range/v3/algorithm/find.hpp>
-#include <range/v3/algorithm/count_if.hpp>
 
 namespace Images {
 QImage prepareColored(QColor add, QImage image);
@@ -29,6 +31,10 @@ std::weak_ptr<FrameRenderer> GlobalInstance;
 
 constexpr auto kImageFormat = QImage::Format_ARGB32_Premultiplied;
 
+// All frames of one animation are kept when it is shared, so only
+// small ones, like in the stickers panel, are worth sharing.
+constexpr auto kSharedFramesMaxSize = 8 * 1024 * 1024;
+
 bool GoodStorageForFrame(const QImage &storage, QSize size) {
 	return !storage.isNull()
 		&& (storage.format() == kImageFormat)
@@ -58,6 +64,16 @@ int GetLottieFrameIndex(not_null<rlottie::Animation*> animation, Quality quality
 
 } // namespace
 
+struct SharedFrames {
+	explicit SharedFrames(int count) : frames(count) {
+	}
+
+	// Written only by the filler until ready is set, then read only.
+	std::vector<QImage> frames;
+	std::atomic<bool> ready = false;
+	int filled = 0;
+};
+
 class FrameRendererObject final {
 public:
 	explicit FrameRendererObject(
@@ -84,6 +100,9 @@ private:
 
 	void queueGenerateFrames();
 	void generateFrames();
+	void shareFrames(Entry &entry);
+	void unshareFrames(Entry &entry);
+	void renderParallel(std::vector<SharedState::RenderResult> &results);
 
 	crl::weak_on_queue<FrameRendererObject> _weak;
 	std::vector<Entry> _entries;
@@ -154,6 +173,7 @@ void FrameRendererObject::append(
 		std::unique_ptr<SharedState> state,
 		const FrameRequest &request) {
 	_entries.push_back({ std::move(state), request });
+	shareFrames(_entries.back());
 	queueGenerateFrames();
 }
 
@@ -166,25 +186,114 @@ void FrameRendererObject::updateFrameRequest(
 		const FrameRequest &request) {
 	const auto i = ranges::find(_entries, entry, &StateFromEntry);
 	Assert(i != end(_entries));
-	i->request = request;
+	if (i->request != request) {
+		unshareFrames(*i);
+		i->request = request;
+		shareFrames(*i);
+	}
 }
 
 void FrameRendererObject::remove(not_null<SharedState*> entry) {
 	const auto i = ranges::find(_entries, entry, &StateFromEntry);
 	Assert(i != end(_entries));
+	unshareFrames(*i);
 	_entries.erase(i);
 }
 
+void FrameRendererObject::shareFrames(Entry &entry) {
+	const auto state = entry.state.get();
+	for (auto &other : _entries) {
+		if (&other == &entry
+			|| other.request != entry.request
+			|| !state->canShareFrames(*other.state, entry.request)) {
+			continue;
+		}
+		auto frames = other.state->sharedFrames();
+		if (!frames) {
+			frames = std::make_shared<SharedFrames>(state->framesCount());
+			other.state->setSharedFrames(frames, true);
+		}
+		state->setSharedFrames(std::move(frames), false);
+		return;
+	}
+}
+
+void FrameRendererObject::unshareFrames(Entry &entry) {
+	const auto frames = entry.state->sharedFrames();
+	if (!frames) {
+		return;
+	}
+	entry.state->setSharedFrames(nullptr, false);
+
+	// Pass the filling to any other animation that still shares frames.
+	for (auto &other : _entries) {
+		if (other.state->sharedFrames() == frames) {
+			other.state->setSharedFrames(frames, true);
+			return;
+		}
+	}
+}
+
+void FrameRendererObject::renderParallel(
+		std::vector<SharedState::RenderResult> &results) {
+	const auto count = int(_entries.size());
+	results.resize(count);
+	const auto threads = std::min(QThread::idealThreadCount(), count);
+	if (threads < 2) {
+		for (auto i = 0; i != count; ++i) {
+			const auto &entry = _entries[i];
+			results[i] = entry.state->renderNextFrame(entry.request);
+		}
+		return;
+	}
+
+	// Each entry is taken by exactly one thread, so the frames of one
+	// animation are still rendered in order. The calling thread takes
+	// entries as well, so a busy thread pool only makes it slower.
+	struct Shared {
+		std::atomic<int> next{ 0 };
+		crl::semaphore finished;
+	};
+	const auto shared = std::make_shared<Shared>();
+	const auto entries = _entries.data();
+	const auto till = results.data();
+	const auto process = [=] {
+		auto result = 0;
+		while (true) {
+			const auto index = shared->next++;
+			if (index >= count) {
+				return result;
+			}
+			const auto &entry = entries[index];
+			till[index] = entry.state->renderNextFrame(entry.request);
+			++result;
+		}
+	};
+	for (auto i = 1; i != threads; ++i) {
+		crl::async([=] {
+			for (auto j = process(); j != 0; --j) {
+				shared->finished.release();
+			}
+		});
+	}
+	auto left = count - process();
+	while (left--) {
+		shared->finished.acquire();
+	}
+}
+
 void FrameRendererObject::generateFrames() {
+	auto results = std::vector<SharedState::RenderResult>();
+	renderParallel(results);
+
 	auto players = base::flat_map<Player*, base::weak_ptr<Player>>();
-	const auto renderOne = [&](const Entry &entry) {
-		const auto result = entry.state->renderNextFrame(entry.request);
+	auto rendered = false;
+	for (const auto &result : results) {
 		if (const auto player = result.notify.get()) {
 			players.emplace(player, result.notify);
 		}
-		return result.rendered;
-	};
-	const auto rendered = ranges::count_if(_entries, renderOne);
+		rendered = rendered || result.rendered;
+	}
 	if (rendered) {
 		if (!players.empty()) {
 			crl::on_main([players = std::move(players)] {
@@ -299,6 +408,7 @@ void SharedState::renderFrame(
 		QImage &image,
 		const FrameRequest &request,
 		int index) {
+	TRACE_ZONE("Lottie::SharedState::renderFrame");
 	if (!isValid()) {
 		return;
 	}
@@ -309,7 +419,11 @@ void SharedState::renderFrame(
 	if (!GoodStorageForFrame(image, size)) {
 		image = CreateFrameStorage(size);
 	}
-	if (_cache && _cache->renderFrame(image, request, index)) {
+	if (!index) {
+		_cacheSkippedFrames = false;
+	}
+	const auto useCache = _cache && !_cacheSkippedFrames;
+	if (useCache && _cache->renderFrame(image, request, index)) {
 		return;
 	} else if (!_animation) {
 		_animation = details::CreateFromContent(_content, _replacements);
@@ -324,7 +438,7 @@ void SharedState::renderFrame(
 	_animation->renderSync(
 		GetLottieFrameIndex(_animation.get(), _quality, index),
 		surface);
-	if (_cache) {
+	if (useCache) {
 		_cache->appendFrame(image, request, index);
 		if (_cache->framesReady() == _cache->framesCount()) {
 			_animation = nullptr;
@@ -360,10 +474,32 @@ void SharedState::renderNextFrame(
 		const FrameRequest &request) {
 	Expects(_info.framesCount > 0);
 
-	renderFrame(
-		frame->original,
-		request,
-		(++_frameIndex) % _info.framesCount);
+	const auto detail = _detail.load(std::memory_order_relaxed);
+	_frameIndex += countFrameStep(detail);
+	const auto index = _frameIndex % _info.framesCount;
+	const auto shared = _sharedFrames.get();
+	if (shared && shared->ready.load(std::memory_order_acquire)) {
+		frame->original = shared->frames[index];
+
+		// Old caches decode frames one after another from the first.
+		if (_cache && !_cache->canSeek()) {
+			_cacheSkippedFrames = true;
+		}
+	} else {
+		renderFrame(
+			frame->original,
+			countRenderRequest(detail, request),
+			index);
+		if (shared
+			&& _sharedFramesFiller
+			&& shared->frames[index].isNull()
+			&& !frame->original.isNull()) {
+			shared->frames[index] = frame->original;
+			if (++shared->filled == int(shared->frames.size())) {
+				shared->ready.store(true, std::memory_order_release);
+			}
+		}
+	}
 	frame->request = request;
 	PrepareFrameByRequest(frame);
 	frame->index = _frameIndex;
@@ -411,6 +547,38 @@ auto SharedState::renderNextFrame(const FrameRequest &request)
 	Unexpected("Counter value in Lottie::SharedState::renderNextFrame.");
 }
 
+int SharedState::countFrameStep(Detail detail) const {
+	const auto limit = (detail == Detail::Low)
+		? (kNormalFrameRate / 2)
+		: (detail == Detail::Reduced)
+		? kNormalFrameRate
+		: _info.frameRate;
+
+	// Caches are filled with all frames one after another.
+	const auto canSkip = !_cache
+		|| (_cache->canSeek()
+			&& _cache->framesReady() == _cache->framesCount());
+	return (canSkip && _info.frameRate > limit)
+		? (_info.frameRate / limit)
+		: 1;
+}
+
+FrameRequest SharedState::countRenderRequest(
+		Detail detail,
+		const FrameRequest &request) const {
+	// Cached and shared frames must have the requested size.
+	if (detail != Detail::Low || _cache || _sharedFrames) {
+		return request;
+	}
+	auto result = request;
+	result.box /= 2;
+	return result.empty() ? request : result;
+}
+
+void SharedState::setDetail(Detail detail) {
+	_detail.store(detail, std::memory_order_relaxed);
+}
+
 crl::time SharedState::countFrameDisplayTime(int index) const {
 	return _started
 		+ _delay
@@ -453,6 +621,10 @@ int SharedState::framesCount() const {
 	return _info.framesCount;
 }
 
+bool SharedState::allFramesCached() const {
+	return _cache && (_cache->framesReady() == _cache->framesCount());
+}
+
 crl::time SharedState::nextFrameDisplayTime() const {
 	const auto frameDisplayTime = [&](int counter) {
 		const auto next = (counter + 1) % (2 * kFramesCount);
@@ -565,6 +737,38 @@ bool SharedState::markFrameShown() {
 	Unexpected("Counter value in Lottie::SharedState::markFrameShown.");
 }
 
+bool SharedState::canShareFrames(
+		const SharedState &other,
+		const FrameRequest &request) const {
+	if (!isValid()
+		|| _content.isEmpty()
+		|| _quality != other._quality
+		|| _replacements != other._replacements
+		|| _info.framesCount != other._info.framesCount
+		|| _info.size != other._info.size) {
+		return false;
+	}
+	const auto size = request.box.isEmpty()
+		? _info.size
+		: request.size(_info.size);
+	const auto total = int64(size.width())
+		* size.height()
+		* 4
+		* _info.framesCount;
+	return (total <= kSharedFramesMaxSize) && (_content == other._content);
+}
+
+const std::shared_ptr<SharedFrames> &SharedState::sharedFrames() const {
+	return _sharedFrames;
+}
+
+void SharedState::setSharedFrames(
+		std::shared_ptr<SharedFrames> frames,
+		bool filler) {
+	_sharedFrames = std::move(frames);
+	_sharedFramesFiller = _sharedFrames && filler;
+}
+
 SharedState::~SharedState() = default;
 
 std::shared_ptr<FrameRenderer> FrameRenderer::CreateIndependent() {
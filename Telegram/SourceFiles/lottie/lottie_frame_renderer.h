@@ -34,6 +34,7 @@ inline constexpr auto kDisplayedInitial = crl::time(-1);
 
 class Player;
 class Cache;
+struct SharedFrames;
 
 struct Frame {
 	QImage original;
@@ -74,6 +75,7 @@ public:
 
 	[[nodiscard]] not_null<Frame*> frameForPaint();
 	[[nodiscard]] int framesCount() const;
+	[[nodiscard]] bool allFramesCached() const;
 	[[nodiscard]] crl::time nextFrameDisplayTime() const;
 	void addTimelineDelay(crl::time delayed, int skippedFrames = 0);
 	void markFrameDisplayed(crl::time now);
@@ -87,6 +89,17 @@ public:
 	};
 	[[nodiscard]] RenderResult renderNextFrame(const FrameRequest &request);
 
+	// Identical animations with identical requests render each frame
+	// once, the rest take the frames when all of them are ready.
+	[[nodiscard]] bool canShareFrames(
+		const SharedState &other,
+		const FrameRequest &request) const;
+	[[nodiscard]] const std::shared_ptr<SharedFrames> &sharedFrames() const;
+	void setSharedFrames(std::shared_ptr<SharedFrames> frames, bool filler);
+
+	// Applied from the next rendered frame.
+	void setDetail(Detail detail);
+
 	~SharedState();
 
 private:
@@ -102,6 +115,10 @@ private:
 		not_null<Frame*> frame,
 		const FrameRequest &request);
 	[[nodiscard]] crl::time countFrameDisplayTime(int index) const;
+	[[nodiscard]] int countFrameStep(Detail detail) const;
+	[[nodiscard]] FrameRequest countRenderRequest(
+		Detail detail,
+		const FrameRequest &request) const;
 	[[nodiscard]] not_null<Frame*> getFrame(int index);
 	[[nodiscard]] not_null<const Frame*> getFrame(int index) const;
 	[[nodiscard]] int counter() const;
@@ -123,9 +140,14 @@ private:
 
 	int _frameIndex = 0;
 	int _skippedFrames = 0;
+	std::atomic<Detail> _detail = Detail::Full;
 	const Information _info;
 	const Quality _quality = Quality::Default;
 
+	std::shared_ptr<SharedFrames> _sharedFrames;
+	bool _sharedFramesFiller = false;
+	bool _cacheSkippedFrames = false;
+
 	const std::unique_ptr<Cache> _cache;
 
 	std::unique_ptr<rlottie::Animation> _animation;
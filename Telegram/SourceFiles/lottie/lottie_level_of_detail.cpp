@@ -0,0 +1,77 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "lottie/lottie_level_of_detail.h"
+
+#include "logs.h"
+
+namespace Lottie {
+namespace {
+
+constexpr auto kLateFrameDelay = crl::time(1000) / 30;
+constexpr auto kMissesToReduce = 3;
+constexpr auto kScrollingTimeout = crl::time(400);
+constexpr auto kRestoreTimeout = crl::time(2000);
+
+[[nodiscard]] Detail Lower(Detail detail) {
+	return (detail == Detail::Full) ? Detail::Reduced : Detail::Low;
+}
+
+[[nodiscard]] Detail Higher(Detail detail) {
+	return (detail == Detail::Low) ? Detail::Reduced : Detail::Full;
+}
+
+} // namespace
+
+Detail LevelOfDetail::current() const {
+	return _detail;
+}
+
+int LevelOfDetail::missedDeadlines() const {
+	return _missedTotal;
+}
+
+bool LevelOfDetail::scrolled(crl::time now) {
+	_scrolled = now;
+	return update(now);
+}
+
+bool LevelOfDetail::frameDisplayed(crl::time now, crl::time late) {
+	if (late > kLateFrameDelay) {
+		++_missedRecently;
+		++_missedTotal;
+	} else if (_missedRecently > 0) {
+		--_missedRecently;
+	}
+	return update(now);
+}
+
+bool LevelOfDetail::update(crl::time now) {
+	const auto was = _detail;
+	const auto scrolling = (_scrolled != kTimeUnknown)
+		&& (now - _scrolled < kScrollingTimeout);
+	if (_missedRecently >= kMissesToReduce && _detail != Detail::Low) {
+		_detail = Lower(_detail);
+		_missedRecently = 0;
+		DEBUG_LOG(("Lottie Info: Lower detail after %1 missed deadlines."
+			).arg(_missedTotal));
+	} else if (scrolling && _detail == Detail::Full) {
+		_detail = Detail::Reduced;
+	} else if (!scrolling
+		&& _detail != Detail::Full
+		&& !_missedRecently
+		&& (now - _changed >= kRestoreTimeout)) {
+		_detail = Higher(_detail);
+	}
+	if (_detail == was) {
+		return false;
+	}
+	_changed = now;
+	return true;
+}
+
+} // namespace Lottie
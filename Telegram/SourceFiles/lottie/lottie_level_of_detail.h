@@ -0,0 +1,37 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "lottie/lottie_common.h"
+
+namespace Lottie {
+
+// Chooses the Detail for the animations of one player, lowering it
+// while the user scrolls or the frames are displayed too late.
+class LevelOfDetail final {
+public:
+	[[nodiscard]] Detail current() const;
+
+	// Both return true if the current() value has changed.
+	bool scrolled(crl::time now);
+	bool frameDisplayed(crl::time now, crl::time late);
+
+	[[nodiscard]] int missedDeadlines() const;
+
+private:
+	bool update(crl::time now);
+
+	Detail _detail = Detail::Full;
+	crl::time _scrolled = kTimeUnknown;
+	crl::time _changed = kTimeUnknown;
+	int _missedRecently = 0;
+	int _missedTotal = 0;
+
+};
+
+} // namespace Lottie
@@ -39,12 +39,14 @@ MultiPlayer::~MultiPlayer() {
 not_null<Animation*> MultiPlayer::append(
 		FnMut<void(FnMut<void(QByteArray &&cached)>)> get, // Main thread.
 		FnMut<void(QByteArray &&cached)> put, // Unknown thread.
+		CacheChunks chunks,
 		const QByteArray &content,
 		const FrameRequest &request) {
 	_animations.push_back(std::make_unique<Animation>(
 		this,
 		std::move(get),
 		std::move(put),
+		std::move(chunks),
 		content,
 		request,
 		_quality));
@@ -76,6 +78,7 @@ void MultiPlayer::startAtRightTime(std::unique_ptr<SharedState> state) {
 		lastSyncTime,
 		_delay);
 	state->start(this, _started, _delay, frameIndex);
+	state->setDetail(_detail.current());
 	const auto request = state->frameForPaint()->request;
 	_renderer->append(std::move(state), request);
 }
@@ -260,6 +263,22 @@ void MultiPlayer::unpauseAndKeepUp(not_null<Animation*> animation) {
 	_paused.erase(i);
 }
 
+void MultiPlayer::markScrolled() {
+	if (_detail.scrolled(crl::now())) {
+		applyDetail();
+	}
+}
+
+void MultiPlayer::applyDetail() {
+	const auto detail = _detail.current();
+	for (const auto &[animation, state] : _active) {
+		state->setDetail(detail);
+	}
+	for (const auto &[animation, info] : _paused) {
+		info.state->setDetail(detail);
+	}
+}
+
 void MultiPlayer::failed(not_null<Animation*> animation, Error error) {
 	//_updates.fire({ animation, error });
 }
@@ -318,6 +337,9 @@ void MultiPlayer::checkNextFrameRender() {
 
 		markFrameDisplayed(now);
 		addTimelineDelay(now - _nextFrameTime);
+		if (_detail.frameDisplayed(now, now - _nextFrameTime)) {
+			applyDetail();
+		}
 		_lastSyncTime = now;
 		_nextFrameTime = kFrameDisplayTimeAlreadyDone;
 		processPending();
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "lottie/lottie_player.h"
+#include "lottie/lottie_level_of_detail.h"
 #include "base/timer.h"
 #include "base/algorithm.h"
 #include "base/flat_set.h"
@@ -47,6 +48,7 @@ public:
 	not_null<Animation*> append(
 		FnMut<void(FnMut<void(QByteArray &&cached)>)> get, // Main thread.
 		FnMut<void(QByteArray &&cached)> put, // Unknown thread.
+		CacheChunks chunks,
 		const QByteArray &content,
 		const FrameRequest &request);
 	not_null<Animation*> append(
@@ -60,6 +62,9 @@ public:
 	void pause(not_null<Animation*> animation);
 	void unpause(not_null<Animation*> animation);
 
+	// Lowers the detail of all the animations for a short while.
+	void markScrolled();
+
 private:
 	struct PausedInfo {
 		not_null<SharedState*> state;
@@ -90,6 +95,7 @@ private:
 	void pauseAndSaveState(not_null<Animation*> animation);
 	void unpauseAndKeepUp(not_null<Animation*> animation);
 	void removeNow(not_null<Animation*> animation);
+	void applyDetail();
 
 	Quality _quality = Quality::Default;
 	base::Timer _timer;
@@ -106,6 +112,7 @@ private:
 	crl::time _lastSyncTime = kTimeUnknown;
 	crl::time _delay = 0;
 	crl::time _nextFrameTime = kTimeUnknown;
+	LevelOfDetail _detail;
 	rpl::event_stream<MultiUpdate> _updates;
 	rpl::lifetime _lifetime;
 
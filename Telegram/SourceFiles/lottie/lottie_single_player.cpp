@@ -25,6 +25,7 @@ SinglePlayer::SinglePlayer(
 SinglePlayer::SinglePlayer(
 	FnMut<void(FnMut<void(QByteArray &&cached)>)> get, // Main thread.
 	FnMut<void(QByteArray &&cached)> put, // Unknown thread.
+	CacheChunks chunks,
 	const QByteArray &content,
 	const FrameRequest &request,
 	Quality quality,
@@ -34,6 +35,7 @@ SinglePlayer::SinglePlayer(
 	this,
 	std::move(get),
 	std::move(put),
+	std::move(chunks),
 	content,
 	request,
 	quality,
@@ -127,6 +129,9 @@ void SinglePlayer::checkNextFrameRender() {
 
 		_state->markFrameDisplayed(now);
 		_state->addTimelineDelay(now - _nextFrameTime);
+		if (_detail.frameDisplayed(now, now - _nextFrameTime)) {
+			_state->setDetail(_detail.current());
+		}
 
 		_nextFrameTime = kFrameDisplayTimeAlreadyDone;
 		_updates.fire({ DisplayFrameRequest() });
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "lottie/lottie_player.h"
 #include "lottie/lottie_animation.h"
+#include "lottie/lottie_level_of_detail.h"
 #include "base/timer.h"
 
 #include <rpl/event_stream.h>
@@ -37,6 +38,7 @@ public:
 	SinglePlayer(
 		FnMut<void(FnMut<void(QByteArray &&cached)>)> get, // Main thread.
 		FnMut<void(QByteArray &&cached)> put, // Unknown thread.
+		CacheChunks chunks,
 		const QByteArray &content,
 		const FrameRequest &request,
 		Quality quality = Quality::Default,
@@ -70,6 +72,7 @@ private:
 	base::Timer _timer;
 	const std::shared_ptr<FrameRenderer> _renderer;
 	SharedState *_state = nullptr;
+	LevelOfDetail _detail;
 	crl::time _nextFrameTime = kTimeUnknown;
 	rpl::event_stream<Update, Error> _updates;
 	rpl::lifetime _lifetime;
@@ -37,6 +37,7 @@ namespace {
 
 constexpr auto kAutoLockTimeoutLateMs = crl::time(3000);
 constexpr auto kLegacyCallsPeerToPeerNobody = 4;
+constexpr auto kMinLoadedMessagesLimit = 1000;
 
 } // namespace
 
@@ -107,6 +108,7 @@ QByteArray Settings::serialize() const {
 		stream << qint32(_variables.replaceEmoji.current() ? 1 : 0);
 		stream << qint32(_variables.suggestEmoji ? 1 : 0);
 		stream << qint32(_variables.suggestStickersByEmoji ? 1 : 0);
+		stream << qint32(_variables.loadedMessagesLimit);
 	}
 	return result;
 }
@@ -153,6 +155,7 @@ void Settings::constructFromSerialized(const QByteArray &serialized) {
 	qint32 replaceEmoji = _variables.replaceEmoji.current() ? 1 : 0;
 	qint32 suggestEmoji = _variables.suggestEmoji ? 1 : 0;
 	qint32 suggestStickersByEmoji = _variables.suggestStickersByEmoji ? 1 : 0;
+	qint32 loadedMessagesLimit = _variables.loadedMessagesLimit;
 
 	stream >> selectorTab;
 	stream >> lastSeenWarningSeen;
@@ -252,6 +255,9 @@ void Settings::constructFromSerialized(const QByteArray &serialized) {
 		stream >> suggestEmoji;
 		stream >> suggestStickersByEmoji;
 	}
+	if (!stream.atEnd()) {
+		stream >> loadedMessagesLimit;
+	}
 	if (stream.status() != QDataStream::Ok) {
 		LOG(("App Error: "
 			"Bad data for Settings::constructFromSerialized()"));
@@ -331,6 +337,11 @@ void Settings::constructFromSerialized(const QByteArray &serialized) {
 	_variables.replaceEmoji = (replaceEmoji == 1);
 	_variables.suggestEmoji = (suggestEmoji == 1);
 	_variables.suggestStickersByEmoji = (suggestStickersByEmoji == 1);
+	setLoadedMessagesLimit(loadedMessagesLimit);
+}
+
+void Settings::setLoadedMessagesLimit(int limit) {
+	_variables.loadedMessagesLimit = std::max(limit, kMinLoadedMessagesLimit);
 }
 
 void Settings::setSupportChatsTimeSlice(int slice) {
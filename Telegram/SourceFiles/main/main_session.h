@@ -268,11 +268,18 @@ public:
 		_variables.suggestStickersByEmoji = value;
 	}
 
+	// Messages kept loaded in the recently shown histories.
+	[[nodiscard]] int loadedMessagesLimit() const {
+		return _variables.loadedMessagesLimit;
+	}
+	void setLoadedMessagesLimit(int limit);
+
 private:
 	struct Variables {
 		Variables();
 
 		static constexpr auto kDefaultDialogsWidthRatio = 5. / 14;
+		static constexpr auto kDefaultLoadedMessagesLimit = 10000;
 		static constexpr auto kDefaultThirdColumnWidth = 0;
 
 		bool lastSeenWarningSeen = false;
@@ -307,6 +314,7 @@ private:
 		rpl::variable<bool> replaceEmoji = true;
 		bool suggestEmoji = true;
 		bool suggestStickersByEmoji = true;
+		int loadedMessagesLimit = kDefaultLoadedMessagesLimit;
 
 		static constexpr auto kDefaultSupportChatsLimitSlice
 			= 7 * 24 * 60 * 60;
@@ -114,8 +114,13 @@ constexpr auto kNoUpdatesAfterSleepTimeout = 60 * crl::time(1000);
 // Send channel views each second.
 constexpr auto kSendViewsTimeout = crl::time(1000);
 
-// Cache background scaled image after 3s.
-constexpr auto kCacheBackgroundTimeout = 3000;
+// Cache background scaled image after 0.2s, keep the last 3 sizes.
+constexpr auto kCacheBackgroundTimeout = crl::time(200);
+constexpr auto kCachedBackgroundsCount = 3;
+
+// Apply a large difference in parts, letting a frame be painted between.
+constexpr auto kDifferenceChunkBudget = crl::time(8);
+constexpr auto kDifferenceChunkSize = 20;
 
 enum class DataIsLoadedResult {
 	NotLoaded = 0,
@@ -926,45 +931,93 @@ void MainWidget::removeDialog(Dialogs::Key key) {
 }
 
 void MainWidget::cacheBackground() {
-	if (Window::Theme::Background()->colorForFill()) {
+	const auto background = Window::Theme::Background();
+	if (background->colorForFill() || _cachingBackground) {
 		return;
-	} else if (Window::Theme::Background()->tile()) {
-		auto &bg = Window::Theme::Background()->pixmapForTiled();
-
-		auto result = QImage(_willCacheFor.width() * cIntRetinaFactor(), _willCacheFor.height() * cIntRetinaFactor(), QImage::Format_RGB32);
-		result.setDevicePixelRatio(cRetinaFactor());
-		{
+	}
+	const auto size = _willCacheFor.size();
+	const auto cached = ranges::find(
+		_cachedBackgrounds,
+		size,
+		&CachedBackground::size);
+	if (cached != end(_cachedBackgrounds) || size.isEmpty()) {
+		return;
+	}
+	const auto tile = background->tile();
+	if (_cachedBackgroundSource.isNull()) {
+		_cachedBackgroundSource = tile
+			? background->pixmapForTiled().toImage()
+			: background->pixmap().toImage();
+	}
+	_cachingBackground = true;
+
+	// Scaling a large wallpaper is slow, so it is done in the background.
+	crl::async([
+		=,
+		source = _cachedBackgroundSource,
+		generation = _cachedBackgroundGeneration,
+		ratio = cRetinaFactor(),
+		intRatio = cIntRetinaFactor()
+	] {
+		auto to = QRect();
+		auto result = QImage();
+		if (tile) {
+			to = QRect(QPoint(), size);
+			result = QImage(
+				size * intRatio,
+				QImage::Format_RGB32);
+			result.setDevicePixelRatio(ratio);
 			QPainter p(&result);
-			auto left = 0;
-			auto top = 0;
-			auto right = _willCacheFor.width();
-			auto bottom = _willCacheFor.height();
-			auto w = bg.width() / cRetinaFactor();
-			auto h = bg.height() / cRetinaFactor();
-			auto sx = 0;
-			auto sy = 0;
-			auto cx = qCeil(_willCacheFor.width() / w);
-			auto cy = qCeil(_willCacheFor.height() / h);
-			for (int i = sx; i < cx; ++i) {
-				for (int j = sy; j < cy; ++j) {
-					p.drawPixmap(QPointF(i * w, j * h), bg);
+			const auto w = source.width() / ratio;
+			const auto h = source.height() / ratio;
+			const auto cx = qCeil(size.width() / w);
+			const auto cy = qCeil(size.height() / h);
+			for (auto i = 0; i < cx; ++i) {
+				for (auto j = 0; j < cy; ++j) {
+					p.drawImage(QPointF(i * w, j * h), source);
 				}
 			}
-		}
-		_cachedX = 0;
-		_cachedY = 0;
-		_cachedBackground = App::pixmapFromImageInPlace(std::move(result));
-	} else {
-		auto &bg = Window::Theme::Background()->pixmap();
+		} else {
+			auto from = QRect();
+			Window::Theme::ComputeBackgroundRects(
+				QRect(QPoint(), size),
+				source.size(),
+				to,
+				from);
+			result = source.copy(from).scaled(
+				to.size() * intRatio,
+				Qt::IgnoreAspectRatio,
+				Qt::SmoothTransformation);
+			result.setDevicePixelRatio(ratio);
+		}
+		crl::on_main(this, [=, result = std::move(result)]() mutable {
+			cacheBackgroundDone(generation, size, to, std::move(result));
+		});
+	});
+}
 
-		QRect to, from;
-		Window::Theme::ComputeBackgroundRects(_willCacheFor, bg.size(), to, from);
-		_cachedX = to.x();
-		_cachedY = to.y();
-		_cachedBackground = App::pixmapFromImageInPlace(bg.toImage().copy(from).scaled(to.width() * cIntRetinaFactor(), to.height() * cIntRetinaFactor(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-		_cachedBackground.setDevicePixelRatio(cRetinaFactor());
+void MainWidget::cacheBackgroundDone(
+		int generation,
+		QSize size,
+		QRect to,
+		QImage &&image) {
+	_cachingBackground = false;
+	if (generation != _cachedBackgroundGeneration) {
+		cacheBackground();
+		return;
 	}
-	_cachedFor = _willCacheFor;
+	if (_cachedBackgrounds.size() >= kCachedBackgroundsCount) {
+		_cachedBackgrounds.erase(begin(_cachedBackgrounds));
+	}
+	_cachedBackgrounds.push_back({
+		size,
+		to,
+		App::pixmapFromImageInPlace(std::move(image))
+	});
+	if (_willCacheFor.size() != size) {
+		cacheBackground();
+	}
+	update();
 }
 
 crl::time MainWidget::highlightStartTime(not_null<const HistoryItem*> item) const {
@@ -1322,22 +1375,56 @@ bool MainWidget::isIdle() const {
 }
 
 void MainWidget::clearCachedBackground() {
-	_cachedBackground = QPixmap();
+	_cachedBackgrounds.clear();
+	_cachedBackgroundSource = QImage();
+	++_cachedBackgroundGeneration;
 	_cacheBackgroundTimer.cancel();
 	update();
 }
 
-QPixmap MainWidget::cachedBackground(const QRect &forRect, int &x, int &y) {
-	if (!_cachedBackground.isNull() && forRect == _cachedFor) {
-		x = _cachedX;
-		y = _cachedY;
-		return _cachedBackground;
+QPixmap MainWidget::cachedBackground(const QRect &forRect, QRect &to) {
+	const auto size = forRect.size();
+	const auto i = ranges::find(
+		_cachedBackgrounds,
+		size,
+		&CachedBackground::size);
+	if (i != end(_cachedBackgrounds)) {
+		if (i + 1 != end(_cachedBackgrounds)) {
+			std::rotate(i, i + 1, end(_cachedBackgrounds));
+		}
+		const auto &cached = _cachedBackgrounds.back();
+		to = cached.to;
+		return cached.pixmap;
 	}
-	if (_willCacheFor != forRect || !_cacheBackgroundTimer.isActive()) {
+	if (_willCacheFor != forRect) {
 		_willCacheFor = forRect;
-		_cacheBackgroundTimer.callOnce(kCacheBackgroundTimeout);
+		if (!_cacheBackgroundTimer.isActive()) {
+			_cacheBackgroundTimer.callOnce(kCacheBackgroundTimeout);
+		}
+	}
+
+	// Stretching a tiled background would scale the pattern.
+	const auto background = Window::Theme::Background();
+	if (_cachedBackgrounds.empty()
+		|| background->colorForFill()
+		|| background->tile()) {
+		return QPixmap();
 	}
-	return QPixmap();
+	const auto distance = [&](const CachedBackground &cached) {
+		return std::abs(cached.size.width() - size.width())
+			+ std::abs(cached.size.height() - size.height());
+	};
+	const auto nearest = ranges::min_element(
+		_cachedBackgrounds,
+		ranges::less(),
+		distance);
+	auto from = QRect();
+	Window::Theme::ComputeBackgroundRects(
+		forRect,
+		background->pixmap().size(),
+		to,
+		from);
+	return nearest->pixmap;
 }
 
 void MainWidget::updateScrollColors() {
@@ -1833,7 +1920,7 @@ Window::SectionSlideParams MainWidget::prepareShowAnimation(
 
 	auto sectionTop = getMainSectionTop();
 	if (selectingPeer() && Adaptive::OneColumn()) {
-		result.oldContentCache = Ui::GrabWidget(this, QRect(
+		result.oldContentCache = Window::SectionWidget::GrabForSlide(this, QRect(
 			0,
 			sectionTop,
 			_dialogsWidth,
@@ -1843,7 +1930,7 @@ Window::SectionSlideParams MainWidget::prepareShowAnimation(
 	} else if (!Adaptive::OneColumn() || !_history->isHidden()) {
 		result.oldContentCache = _history->grabForShowAnimation(result);
 	} else {
-		result.oldContentCache = Ui::GrabWidget(this, QRect(
+		result.oldContentCache = Window::SectionWidget::GrabForSlide(this, QRect(
 			0,
 			sectionTop,
 			_dialogsWidth,
@@ -2137,7 +2224,7 @@ QPixmap MainWidget::grabForShowAnimation(const Window::SectionSlideParams &param
 
 	auto sectionTop = getMainSectionTop();
 	if (Adaptive::OneColumn()) {
-		result = Ui::GrabWidget(this, QRect(
+		result = Window::SectionWidget::GrabForSlide(this, QRect(
 			0,
 			sectionTop,
 			_dialogsWidth,
@@ -2147,7 +2234,7 @@ QPixmap MainWidget::grabForShowAnimation(const Window::SectionSlideParams &param
 		if (_thirdShadow) {
 			_thirdShadow->hide();
 		}
-		result = Ui::GrabWidget(this, QRect(
+		result = Window::SectionWidget::GrabForSlide(this, QRect(
 			_dialogsWidth,
 			sectionTop,
 			width() - _dialogsWidth,
@@ -2955,6 +3042,60 @@ void MainWidget::gotState(const MTPupdates_State &state) {
 	updateOnline();
 }
 
+bool MainWidget::gotDifferenceData(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	const auto type = (from < end) ? mtpTypeId(*from) : mtpTypeId(0);
+	if (type != mtpc_updates_difference
+		&& type != mtpc_updates_differenceSlice) {
+		auto difference = MTPupdates_Difference();
+		if (!difference.read(from, end)) {
+			return false;
+		}
+		gotDifference(difference);
+		return true;
+	}
+	++from;
+
+	// Chats and users are applied as they are read, the messages need
+	// them and are sorted before applying, so they are kept as a vector.
+	auto messages = MTPVector<MTPMessage>();
+	auto other = MTPVector<MTPUpdate>();
+	auto state = MTPupdates_State();
+	const auto skip = [](auto&&) {};
+	const auto processChat = [&](const MTPChat &chat) {
+		session().data().processChat(chat);
+	};
+	const auto processUser = [&](const MTPUser &user) {
+		session().data().processUser(user);
+	};
+	if (!messages.read(from, end)
+		|| !MTP::ReadVectorElements<MTPEncryptedMessage>(from, end, skip)
+		|| !other.read(from, end)
+		|| !MTP::ReadVectorElements<MTPChat>(from, end, processChat)
+		|| !MTP::ReadVectorElements<MTPUser>(from, end, processUser)
+		|| !state.read(from, end)) {
+		return false;
+	}
+	_failDifferenceTimeout = 1;
+	session().checkAutoLock();
+	feedMessageIds(other);
+	applyDifference(messages, other, [=] {
+		if (type == mtpc_updates_differenceSlice) {
+			auto &s = state.c_updates_state();
+			updSetState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
+
+			_ptsWaiter.setRequesting(false);
+
+			MTP_LOG(0, ("getDifference { good - after a slice of difference was received }%1").arg(cTestMode() ? " TESTMODE" : ""));
+			getDifference();
+		} else {
+			gotState(state);
+		}
+	});
+	return true;
+}
+
 void MainWidget::gotDifference(const MTPupdates_Difference &difference) {
 	_failDifferenceTimeout = 1;
 
@@ -2970,21 +3111,23 @@ void MainWidget::gotDifference(const MTPupdates_Difference &difference) {
 	} break;
 	case mtpc_updates_differenceSlice: {
 		auto &d = difference.c_updates_differenceSlice();
-		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates());
-
-		auto &s = d.vintermediate_state().c_updates_state();
-		updSetState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
+		const auto state = d.vintermediate_state();
+		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates(), [=] {
+			auto &s = state.c_updates_state();
+			updSetState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
 
-		_ptsWaiter.setRequesting(false);
+			_ptsWaiter.setRequesting(false);
 
-		MTP_LOG(0, ("getDifference { good - after a slice of difference was received }%1").arg(cTestMode() ? " TESTMODE" : ""));
-		getDifference();
+			MTP_LOG(0, ("getDifference { good - after a slice of difference was received }%1").arg(cTestMode() ? " TESTMODE" : ""));
+			getDifference();
+		});
 	} break;
 	case mtpc_updates_difference: {
 		auto &d = difference.c_updates_difference();
-		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates());
-
-		gotState(d.vstate());
+		const auto state = d.vstate();
+		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates(), [=] {
+			gotState(state);
+		});
 	} break;
 	case mtpc_updates_differenceTooLong: {
 		auto &d = difference.c_updates_differenceTooLong();
@@ -3072,13 +3215,79 @@ void MainWidget::feedDifference(
 		const MTPVector<MTPUser> &users,
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
-		const MTPVector<MTPUpdate> &other) {
+		const MTPVector<MTPUpdate> &other,
+		Fn<void()> done) {
 	session().checkAutoLock();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
 	feedMessageIds(other);
-	session().data().processMessages(msgs, NewMessageType::Unread);
-	feedUpdateVector(other, true);
+	applyDifference(msgs, other, std::move(done));
+}
+
+void MainWidget::applyDifference(
+		const MTPVector<MTPMessage> &msgs,
+		const MTPVector<MTPUpdate> &other,
+		Fn<void()> done) {
+	Expects(_differenceApplying == nullptr);
+
+	// Messages are added in the order of their ids, like the
+	// Data::Session::processMessages() does for the whole vector.
+	auto messages = msgs.v;
+	std::stable_sort(
+		messages.begin(),
+		messages.end(),
+		[](const MTPMessage &a, const MTPMessage &b) {
+			return uint32(IdFromMessage(a)) < uint32(IdFromMessage(b));
+		});
+	_differenceApplying = std::make_unique<DifferenceApplying>();
+	_differenceApplying->messages = std::move(messages);
+	_differenceApplying->updates = other.v;
+	_differenceApplying->done = std::move(done);
+	applyDifferenceChunk();
+}
+
+void MainWidget::applyDifferenceChunk() {
+	Expects(_differenceApplying != nullptr);
+
+	const auto applying = _differenceApplying.get();
+	const auto &messages = applying->messages;
+	const auto &updates = applying->updates;
+	const auto deadline = crl::now() + kDifferenceChunkBudget;
+	do {
+		if (applying->messagesApplied < messages.size()) {
+			const auto from = applying->messagesApplied;
+			const auto count = std::min(
+				kDifferenceChunkSize,
+				messages.size() - from);
+			session().data().processMessages(
+				messages.mid(from, count),
+				NewMessageType::Unread);
+			applying->messagesApplied += count;
+		} else if (applying->updatesApplied < updates.size()) {
+			const auto from = applying->updatesApplied;
+			const auto till = from + std::min(
+				kDifferenceChunkSize,
+				updates.size() - from);
+			for (auto i = from; i != till; ++i) {
+				if (updates[i].type() != mtpc_updateMessageID) {
+					feedUpdate(updates[i]);
+				}
+			}
+			applying->updatesApplied = till;
+		} else {
+			break;
+		}
+	} while (crl::now() < deadline);
+	session().data().sendHistoryChangeNotifications();
+
+	if (applying->messagesApplied < messages.size()
+		|| applying->updatesApplied < updates.size()) {
+		InvokeQueued(this, [=] { applyDifferenceChunk(); });
+		return;
+	}
+	const auto done = std::move(applying->done);
+	_differenceApplying = nullptr;
+	done();
 }
 
 bool MainWidget::failDifference(const RPCError &error) {
@@ -3146,7 +3355,7 @@ void MainWidget::getDifference() {
 
 	_getDifferenceTimeByPts = 0;
 
-	if (requestingDifference()) return;
+	if (requestingDifference() || _differenceApplying) return;
 
 	_bySeqUpdates.clear();
 	_bySeqTimer.cancel();
@@ -3163,7 +3372,7 @@ void MainWidget::getDifference() {
 			MTPint(),
 			MTP_int(updDate),
 			MTP_int(updQts)),
-		rpcDone(&MainWidget::gotDifference),
+		rpcDone(&MainWidget::gotDifferenceData),
 		rpcFail(&MainWidget::failDifference));
 }
 
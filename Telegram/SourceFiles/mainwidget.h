@@ -214,7 +214,9 @@ public:
 
 	bool isIdle() const;
 
-	QPixmap cachedBackground(const QRect &forRect, int &x, int &y);
+	// Returns the cached background for the size or for the nearest one.
+	// If the size doesn't match, the pixmap should be stretched to "to".
+	QPixmap cachedBackground(const QRect &forRect, QRect &to);
 	void updateScrollColors();
 
 	void setChatBackground(
@@ -379,9 +381,22 @@ private:
 	void saveSectionInStack();
 
 	void getChannelDifference(ChannelData *channel, ChannelDifferenceRequest from = ChannelDifferenceRequest::Unknown);
+	[[nodiscard]] bool gotDifferenceData(
+		const mtpPrime *from,
+		const mtpPrime *end);
 	void gotDifference(const MTPupdates_Difference &diff);
 	bool failDifference(const RPCError &e);
-	void feedDifference(const MTPVector<MTPUser> &users, const MTPVector<MTPChat> &chats, const MTPVector<MTPMessage> &msgs, const MTPVector<MTPUpdate> &other);
+	void feedDifference(
+		const MTPVector<MTPUser> &users,
+		const MTPVector<MTPChat> &chats,
+		const MTPVector<MTPMessage> &msgs,
+		const MTPVector<MTPUpdate> &other,
+		Fn<void()> done);
+	void applyDifference(
+		const MTPVector<MTPMessage> &msgs,
+		const MTPVector<MTPUpdate> &other,
+		Fn<void()> done);
+	void applyDifferenceChunk();
 	void gotState(const MTPupdates_State &state);
 	void updSetState(int32 pts, int32 date, int32 qts, int32 seq);
 	void gotChannelDifference(ChannelData *channel, const MTPupdates_ChannelDifference &diff);
@@ -407,6 +422,11 @@ private:
 	void clearHider(not_null<Window::HistoryHider*> instance);
 
 	void cacheBackground();
+	void cacheBackgroundDone(
+		int generation,
+		QSize size,
+		QRect to,
+		QImage &&image);
 	void clearCachedBackground();
 
 	not_null<Media::Player::FloatDelegate*> floatPlayerDelegate();
@@ -496,6 +516,17 @@ private:
 
 	PtsWaiter _ptsWaiter;
 
+	// Large differences are applied in parts between frames,
+	// the pts waiter keeps requesting until all of them are done.
+	struct DifferenceApplying {
+		QVector<MTPMessage> messages;
+		QVector<MTPUpdate> updates;
+		int messagesApplied = 0;
+		int updatesApplied = 0;
+		Fn<void()> done;
+	};
+	std::unique_ptr<DifferenceApplying> _differenceApplying;
+
 	ChannelGetDifferenceTime _channelGetDifferenceTimeByPts, _channelGetDifferenceTimeAfterFail;
 	crl::time _getDifferenceTimeByPts = 0;
 	crl::time _getDifferenceTimeAfterFail = 0;
@@ -521,10 +552,16 @@ private:
 	crl::time _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
-	QPixmap _cachedBackground;
-	QRect _cachedFor, _willCacheFor;
-	int _cachedX = 0;
-	int _cachedY = 0;
+	struct CachedBackground {
+		QSize size;
+		QRect to;
+		QPixmap pixmap;
+	};
+	std::vector<CachedBackground> _cachedBackgrounds; // Most recent last.
+	QImage _cachedBackgroundSource;
+	QRect _willCacheFor;
+	int _cachedBackgroundGeneration = 0;
+	bool _cachingBackground = false;
 	base::Timer _cacheBackgroundTimer;
 
 	PhotoData *_deletingPhoto = nullptr;
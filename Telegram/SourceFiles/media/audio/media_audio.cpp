@@ -1674,13 +1674,25 @@ public:
 
 		auto fmt = format();
 		auto peak = uint16(0);
-		auto callback = [&](uint16 sample) {
-			accumulate_max(peak, sample);
-			sumbytes += Media::Player::kWaveformSamplesCount;
-			if (sumbytes >= countbytes) {
-				sumbytes -= countbytes;
-				peaks.push_back(peak);
-				peak = 0;
+
+		// Each sample adds kWaveformSamplesCount to sumbytes and a peak
+		// is done when it reaches countbytes, so runs of samples between
+		// two peaks can be reduced all at once.
+		const auto countPeaks = [&](const auto *samples, int64 count) {
+			constexpr auto kStep = int64(Media::Player::kWaveformSamplesCount);
+			while (count > 0) {
+				const auto tillPeak = (countbytes - sumbytes + kStep - 1)
+					/ kStep;
+				const auto take = std::min(count, std::max(tillPeak, int64(1)));
+				accumulate_max(peak, Media::Audio::MaxSample(samples, take));
+				sumbytes += take * kStep;
+				if (sumbytes >= countbytes) {
+					sumbytes -= countbytes;
+					peaks.push_back(peak);
+					peak = 0;
+				}
+				samples += take;
+				count -= take;
 			}
 		};
 		while (processed < countbytes) {
@@ -1695,11 +1707,15 @@ public:
 				continue;
 			}
 
-			auto sampleBytes = bytes::make_span(buffer);
+			const auto data = buffer.constData();
 			if (fmt == AL_FORMAT_MONO8 || fmt == AL_FORMAT_STEREO8) {
-				Media::Audio::IterateSamples<uchar>(sampleBytes, callback);
+				countPeaks(
+					reinterpret_cast<const uchar*>(data),
+					int64(buffer.size()));
 			} else if (fmt == AL_FORMAT_MONO16 || fmt == AL_FORMAT_STEREO16) {
-				Media::Audio::IterateSamples<int16>(sampleBytes, callback);
+				countPeaks(
+					reinterpret_cast<const int16*>(data),
+					int64(buffer.size() / sizeof(int16)));
 			}
 			processed += sampleSize() * samples;
 		}
@@ -380,14 +380,16 @@ TG_FORCE_INLINE uint16 ReadOneSample(int16 data) {
 	return qAbs(data);
 }
 
-template <typename SampleType, typename Callback>
-void IterateSamples(bytes::const_span bytes, Callback &&callback) {
-	auto samplesPointer = reinterpret_cast<const SampleType*>(bytes.data());
-	auto samplesCount = bytes.size() / sizeof(SampleType);
-	auto samplesData = gsl::make_span(samplesPointer, samplesCount);
-	for (auto sampleData : samplesData) {
-		callback(ReadOneSample(sampleData));
+// The largest ReadOneSample() of the samples, in a loop without
+// branches, so that compilers can vectorize it.
+template <typename SampleType>
+uint16 MaxSample(const SampleType *samples, int64 count) {
+	auto result = uint16(0);
+	for (auto i = int64(0); i != count; ++i) {
+		const auto sample = ReadOneSample(samples[i]);
+		result = (sample > result) ? sample : result;
 	}
+	return result;
 }
 
 } // namespace Audio
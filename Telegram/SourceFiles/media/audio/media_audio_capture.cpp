@@ -54,6 +54,7 @@ Instance::Instance() : _inner(new Inner(&_thread)) {
 	connect(this, SIGNAL(stop(bool)), _inner, SLOT(onStop(bool)));
 	connect(_inner, SIGNAL(done(QByteArray, VoiceWaveform, qint32)), this, SIGNAL(done(QByteArray, VoiceWaveform, qint32)));
 	connect(_inner, SIGNAL(updated(quint16, qint32)), this, SIGNAL(updated(quint16, qint32)));
+	connect(_inner, SIGNAL(encoded(QByteArray)), this, SIGNAL(encoded(QByteArray)));
 	connect(_inner, SIGNAL(error()), this, SIGNAL(error()));
 	connect(&_thread, SIGNAL(started()), _inner, SLOT(onInit()));
 	connect(&_thread, SIGNAL(finished()), _inner, SLOT(deleteLater()));
@@ -110,6 +111,7 @@ struct Instance::Inner::Private {
 
 	QByteArray data;
 	int32 dataPos = 0;
+	int32 dataEmitted = 0;
 
 	int64 waveformMod = 0;
 	int64 waveformEach = (kCaptureFrequency / 100);
@@ -345,6 +347,7 @@ void Instance::Inner::onStop(bool needResult) {
 		if ((_captured.size() % sizeof(short)) || (d->fullSamples + capturedSamples < kCaptureFrequency) || (capturedSamples < fadeSamples)) {
 			d->fullSamples = 0;
 			d->dataPos = 0;
+			d->dataEmitted = 0;
 			d->data.clear();
 			d->waveformMod = 0;
 			d->waveformPeak = 0;
@@ -370,6 +373,7 @@ void Instance::Inner::onStop(bool needResult) {
 			if (encoded != _captured.size()) {
 				d->fullSamples = 0;
 				d->dataPos = 0;
+				d->dataEmitted = 0;
 				d->data.clear();
 				d->waveformMod = 0;
 				d->waveformPeak = 0;
@@ -466,6 +470,7 @@ void Instance::Inner::onStop(bool needResult) {
 		d->levelMax = 0;
 
 		d->dataPos = 0;
+		d->dataEmitted = 0;
 		d->data.clear();
 
 		d->waveformMod = 0;
@@ -536,6 +541,12 @@ void Instance::Inner::onTimeout() {
 			memmove(_captured.data(), _captured.constData() + encoded, goodSize);
 			_captured.resize(goodSize);
 		}
+
+		// Pass the encoded bytes further while still recording.
+		if (d->data.size() > d->dataEmitted) {
+			emit encoded(d->data.mid(d->dataEmitted));
+			d->dataEmitted = d->data.size();
+		}
 	} else {
 		DEBUG_LOG(("Audio Capture: no samples to capture."));
 	}
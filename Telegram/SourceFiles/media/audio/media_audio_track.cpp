@@ -66,14 +66,24 @@ void Track::fillFromData(bytes::vector &&data) {
 	auto peakEachSample = (format == AL_FORMAT_STEREO8 || format == AL_FORMAT_STEREO16) ? (_peakEachPosition * 2) : _peakEachPosition;
 	_peakValueMin = 0x7FFF;
 	_peakValueMax = 0;
-	auto peakCallback = [this, &peakValue, &peakSamples, peakEachSample](uint16 sample) {
-		accumulate_max(peakValue, sample);
-		if (++peakSamples >= peakEachSample) {
-			peakSamples -= peakEachSample;
-			_peaks.push_back(peakValue);
-			accumulate_max(_peakValueMax, peakValue);
-			accumulate_min(_peakValueMin, peakValue);
-			peakValue = 0;
+	const auto countPeaks = [&](const auto *samples, int64 count) {
+		while (count > 0) {
+			const auto take = std::min(
+				count,
+				int64(peakEachSample - peakSamples));
+			accumulate_max(
+				peakValue,
+				Media::Audio::MaxSample(samples, take));
+			peakSamples += int(take);
+			if (peakSamples >= peakEachSample) {
+				peakSamples -= peakEachSample;
+				_peaks.push_back(peakValue);
+				accumulate_max(_peakValueMax, peakValue);
+				accumulate_min(_peakValueMin, peakValue);
+				peakValue = 0;
+			}
+			samples += take;
+			count -= take;
 		}
 	};
 	do {
@@ -85,10 +95,15 @@ void Track::fillFromData(bytes::vector &&data) {
 			_samplesCount += samplesAdded;
 			_samples.insert(_samples.end(), sampleBytes.data(), sampleBytes.data() + sampleBytes.size());
 			if (peaksCount) {
+				const auto data = sampleBytes.data();
 				if (format == AL_FORMAT_MONO8 || format == AL_FORMAT_STEREO8) {
-					Media::Audio::IterateSamples<uchar>(sampleBytes, peakCallback);
+					countPeaks(
+						reinterpret_cast<const uchar*>(data),
+						int64(sampleBytes.size()));
 				} else if (format == AL_FORMAT_MONO16 || format == AL_FORMAT_STEREO16) {
-					Media::Audio::IterateSamples<int16>(sampleBytes, peakCallback);
+					countPeaks(
+						reinterpret_cast<const int16*>(data),
+						int64(sampleBytes.size() / sizeof(int16)));
 				}
 			}
 		}
@@ -25,9 +25,33 @@ namespace Media {
 namespace Clip {
 namespace {
 
+constexpr auto kMinThreadsCount = 2;
+constexpr auto kMaxThreadsCount = 16;
+
+// Load levels are measured in microseconds of decoding per second.
+// Until measured a reader is estimated by its frame area: a frame of
+// AverageGifSize pixels takes about 1 ms to decode, 25 times a second.
+constexpr auto kEstimatedCostOfAverageSize = 25'000;
+constexpr auto kCostMeasureWindow = crl::time(1000);
+
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+int ThreadsCount() {
+	static const auto result = std::clamp(
+		QThread::idealThreadCount(),
+		kMinThreadsCount,
+		kMaxThreadsCount);
+	return result;
+}
+
+int EstimatedCost(int width, int height) {
+	const auto area = (width > 0 && height > 0)
+		? int64(width) * height
+		: int64(AverageGifSize);
+	return int(area * kEstimatedCostOfAverageSize / AverageGifSize);
+}
+
 QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	auto needResize = (original.width() != request.framew) || (original.height() != request.frameh);
 	auto needOuterFill = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -106,7 +130,7 @@ Reader::Reader(const QByteArray &data, Callback &&callback, Mode mode, crl::time
 }
 
 void Reader::init(const FileLocation &location, const QByteArray &data) {
-	if (threads.size() < ClipThreadsCount) {
+	if (threads.size() < ThreadsCount()) {
 		_threadIndex = threads.size();
 		threads.push_back(new QThread());
 		managers.push_back(new Manager(threads.back()));
@@ -446,6 +470,10 @@ public:
 	}
 
 	ProcessResult finishProcess(crl::time ms) {
+		const auto started = crl::profile();
+		const auto guard = gsl::finally([&] {
+			_costSpent += crl::profile() - started;
+		});
 		auto frameMs = _seekPositionMs + ms - _animationStarted;
 		auto readResult = _implementation->readFramesTill(frameMs, ms);
 		if (readResult == internal::ReaderImplementation::ReadResult::EndOfFile) {
@@ -591,6 +619,11 @@ private:
 	int _width = 0;
 	int _height = 0;
 
+	// This reader's part of the manager load level.
+	int _cost = 0;
+	crl::time _costWindowStart = 0;
+	crl::profile_time _costSpent = 0;
+
 	bool _hasAudio = false;
 	crl::time _durationMs = 0;
 	crl::time _animationStarted = 0;
@@ -624,7 +657,7 @@ Manager::Manager(QThread *thread) {
 
 void Manager::append(Reader *reader, const FileLocation &location, const QByteArray &data) {
 	reader->_private = new ReaderPrivate(reader, location, data);
-	_loadLevel.fetchAndAddRelaxed(AverageGifSize);
+	updateCost(reader->_private, EstimatedCost(0, 0));
 	update(reader);
 }
 
@@ -692,7 +725,9 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, c
 	}
 
 	if (result == ProcessResult::Started) {
-		_loadLevel.fetchAndAddRelaxed(reader->_width * reader->_height - AverageGifSize);
+		updateCost(reader, EstimatedCost(reader->_width, reader->_height));
+		reader->_costWindowStart = ms;
+		reader->_costSpent = 0;
 		it.key()->_durationMs = reader->_durationMs;
 		it.key()->_hasAudio = reader->_hasAudio;
 	}
@@ -734,7 +769,7 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, c
 
 Manager::ResultHandleState Manager::handleResult(ReaderPrivate *reader, ProcessResult result, crl::time ms) {
 	if (!handleProcessResult(reader, result, ms)) {
-		_loadLevel.fetchAndAddRelaxed(-1 * (reader->_width > 0 ? reader->_width * reader->_height : AverageGifSize));
+		updateCost(reader, 0);
 		delete reader;
 		return ResultHandleRemove;
 	}
@@ -760,12 +795,30 @@ Manager::ResultHandleState Manager::handleResult(ReaderPrivate *reader, ProcessR
 				reader->_frame = index;
 			}
 		}
-		return handleResult(reader, reader->finishProcess(ms), ms);
+		const auto result = reader->finishProcess(ms);
+		measureCost(reader, ms);
+		return handleResult(reader, result, ms);
 	}
 
 	return ResultHandleContinue;
 }
 
+void Manager::updateCost(ReaderPrivate *reader, int cost) {
+	_loadLevel.fetchAndAddRelaxed(cost - reader->_cost);
+	reader->_cost = cost;
+}
+
+void Manager::measureCost(ReaderPrivate *reader, crl::time ms) {
+	const auto elapsed = ms - reader->_costWindowStart;
+	if (elapsed < kCostMeasureWindow) {
+		return;
+	}
+	const auto spent = reader->_costSpent;
+	updateCost(reader, int(spent * 1000 / elapsed));
+	reader->_costWindowStart = ms;
+	reader->_costSpent = 0;
+}
+
 void Manager::process() {
 	if (_processingInThread) {
 		_needReProcess = true;
@@ -826,7 +879,7 @@ void Manager::process() {
 			QMutexLocker lock(&_readerPointersMutex);
 			auto it = constUnsafeFindReaderPointer(reader);
 			if (it == _readerPointers.cend()) {
-				_loadLevel.fetchAndAddRelaxed(-1 * (reader->_width > 0 ? reader->_width * reader->_height : AverageGifSize));
+				updateCost(reader, 0);
 				delete reader;
 				i = _readers.erase(i);
 				continue;
@@ -212,6 +212,8 @@ public slots:
 private:
 
 	void clear();
+	void updateCost(ReaderPrivate *reader, int cost);
+	void measureCost(ReaderPrivate *reader, crl::time ms);
 
 	QAtomicInt _loadLevel;
 	using ReaderPointers = QMap<Reader*, QAtomicInt>;
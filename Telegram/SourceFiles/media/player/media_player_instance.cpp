@@ -310,6 +310,24 @@ bool Instance::moveInPlaylist(
 	return false;
 }
 
+void Instance::preloadNext(not_null<Data*> data) {
+	if (!data->playlistIndex) {
+		return;
+	}
+	const auto item = itemByIndex(data, *data->playlistIndex + 1);
+	const auto media = item ? item->media() : nullptr;
+	const auto document = media ? media->document() : nullptr;
+	if (!document
+		|| !(document->isAudioFile()
+			|| document->isVoiceMessage()
+			|| document->isVideoMessage())) {
+		return;
+	}
+	data->nextReader = document->owner().documentStreamedReader(
+		document,
+		item->fullId());
+}
+
 bool Instance::previousAvailable(AudioMsgId::Type type) const {
 	const auto data = getData(type);
 	Assert(data != nullptr);
@@ -396,6 +414,7 @@ void Instance::playStreamed(
 		audioId,
 		&audioId.audio()->owner(),
 		std::move(reader));
+	data->nextReader = nullptr;
 
 	data->streamed->player.updates(
 	) | rpl::start_with_next_error([=](Streaming::Update &&update) {
@@ -697,7 +716,14 @@ void Instance::handleStreamingUpdate(
 		data->streamed->info.video.state.position = update.position;
 		emitUpdate(data->type);
 	}, [&](PreloadedAudio &update) {
-		data->streamed->info.audio.state.receivedTill = update.till;
+		auto &state = data->streamed->info.audio.state;
+		state.receivedTill = update.till;
+		if (!data->nextReader
+			&& state.duration != kTimeUnknown
+			&& state.receivedTill >= state.duration) {
+			// The current track is fully received, start the next one.
+			preloadNext(data);
+		}
 		//emitUpdate(data->type, [](AudioMsgId) { return true; });
 	}, [&](UpdateAudio &update) {
 		data->streamed->info.audio.state.position = update.position;
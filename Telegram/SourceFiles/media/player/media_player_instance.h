@@ -182,6 +182,9 @@ private:
 		bool isPlaying = false;
 		bool resumeOnCallEnd = false;
 		std::unique_ptr<Streamed> streamed;
+
+		// Keeps the next item reader with its header read in advance.
+		std::shared_ptr<Streaming::Reader> nextReader;
 	};
 
 	Instance();
@@ -212,6 +215,7 @@ private:
 	void playlistUpdated(not_null<Data*> data);
 	bool moveInPlaylist(not_null<Data*> data, int delta, bool autonext);
 	HistoryItem *itemByIndex(not_null<Data*> data, int index);
+	void preloadNext(not_null<Data*> data);
 
 	void handleStreamingUpdate(
 		not_null<Data*> data,
@@ -54,6 +54,7 @@ struct VideoInformation {
 	QSize size;
 	QImage cover;
 	int rotation = 0;
+	QString hwAccel; // Empty for software decoding.
 };
 
 struct AudioInformation {
@@ -117,6 +118,10 @@ struct FrameRequest {
 	RectParts corners = RectPart::AllCorners;
 	bool strict = true;
 
+	// If false, YUV420 frames may be left unconverted for painting
+	// from planes, VideoTrack::frame() then converts them on demand.
+	bool requireARGB32 = true;
+
 	static FrameRequest NonStrict() {
 		auto result = FrameRequest();
 		result.strict = false;
@@ -131,12 +136,26 @@ struct FrameRequest {
 		return (resize == other.resize)
 			&& (outer == other.outer)
 			&& (radius == other.radius)
-			&& (corners == other.corners);
+			&& (corners == other.corners)
+			&& (requireARGB32 == other.requireARGB32);
 	}
 	bool operator!=(const FrameRequest &other) const {
 		return !(*this == other);
 	}
 };
 
+struct FrameYUV420 {
+	struct Plane {
+		const uchar *data = nullptr;
+		int stride = 0;
+	};
+
+	QSize size;
+	QSize chromaSize;
+	Plane y;
+	Plane u;
+	Plane v;
+};
+
 } // namespace Streaming
 } // namespace Media
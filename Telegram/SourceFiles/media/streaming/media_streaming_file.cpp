@@ -17,6 +17,9 @@ namespace {
 
 constexpr auto kMaxSingleReadAmount = 8 * 1024 * 1024;
 
+// Hardware decoding is tried starting from 720p videos.
+constexpr auto kHwAccelMinArea = 1280 * 720;
+
 } // namespace
 
 File::Context::Context(
@@ -140,7 +143,10 @@ Stream File::Context::initStream(
 		}
 	}
 
-	result.codec = FFmpeg::MakeCodecPointer(info);
+	const auto hwAllowed = (type == AVMEDIA_TYPE_VIDEO)
+		&& (info->codecpar->width * info->codecpar->height
+			>= kHwAccelMinArea);
+	result.codec = FFmpeg::MakeCodecPointer(info, hwAllowed);
 	if (!result.codec) {
 		return result;
 	}
@@ -252,6 +258,7 @@ void File::Context::start(crl::time position) {
 	}
 
 	_reader->headerDone();
+	_reader->setPlaybackDuration(std::max(video.duration, audio.duration));
 	if (_reader->isRemoteLoader()) {
 		sendFullInCache(true);
 	}
@@ -36,6 +36,7 @@ LoaderMtproto::~LoaderMtproto() {
 	for (const auto [index, amount] : _amountByDcIndex) {
 		changeRequestedAmount(index, -amount);
 	}
+	_owner->streamingRequestsIncrement(-_requestsCounted);
 }
 
 std::optional<Storage::Cache::Key> LoaderMtproto::baseCacheKey() const {
@@ -71,6 +72,7 @@ void LoaderMtproto::stop() {
 			_sender.requestCanceller(),
 			&base::flat_map<int, mtpRequestId>::value_type::second);
 		_requested.clear();
+		countRequests();
 	});
 }
 
@@ -109,7 +111,14 @@ void LoaderMtproto::changeRequestedAmount(int index, int amount) {
 	_amountByDcIndex[index] += amount;
 }
 
+void LoaderMtproto::countRequests() {
+	const auto count = int(_requests.size());
+	_owner->streamingRequestsIncrement(count - _requestsCounted);
+	_requestsCounted = count;
+}
+
 void LoaderMtproto::sendNext() {
+	countRequests();
 	if (_requests.size() >= kMaxConcurrentRequests) {
 		return;
 	}
@@ -135,6 +144,8 @@ void LoaderMtproto::sendNext() {
 		requestFailed(offset, error, usedFileReference);
 	}).toDC(
 		MTP::downloadDcId(_dcId, index)
+	).withPriority(
+		MTP::RequestPriority::Interactive
 	).send();
 	_requests.emplace(offset, id);
 
@@ -60,6 +60,7 @@ private:
 		const QVector<MTPFileHash> &hashes);
 	void cancelForOffset(int offset);
 	void changeRequestedAmount(int index, int amount);
+	void countRequests();
 
 	const not_null<Storage::Downloader*> _owner;
 
@@ -74,6 +75,7 @@ private:
 
 	PriorityQueue _requested;
 	base::flat_map<int, mtpRequestId> _requests;
+	int _requestsCounted = 0;
 	base::flat_map<int, int> _amountByDcIndex;
 	rpl::event_stream<LoadedPart> _parts;
 
@@ -21,6 +21,11 @@ namespace {
 constexpr auto kBufferFor = 3 * crl::time(1000);
 constexpr auto kLoadInAdvanceForRemote = 64 * crl::time(1000);
 constexpr auto kLoadInAdvanceForLocal = 5 * crl::time(1000);
+constexpr auto kMinLoadInAdvance = kBufferFor + crl::time(1000);
+
+// Packets read in advance wait in the track queues in memory,
+// so high bitrate files are read at most 64 MB ahead.
+constexpr auto kMaxBytesInAdvance = int64(64 * 1024 * 1024);
 constexpr auto kMsFrequency = 1000; // 1000 ms per second.
 
 // If we played for 3 seconds and got stuck it looks like we're loading
@@ -63,6 +68,7 @@ void SaveValidVideoInformation(
 	to.size = from.size;
 	to.cover = std::move(from.cover);
 	to.rotation = from.rotation;
+	to.hwAccel = std::move(from.hwAccel);
 }
 
 void SaveValidStartInformation(Information &to, Information &&from) {
@@ -355,6 +361,7 @@ bool Player::fileProcessPacket(FFmpeg::Packet &&packet) {
 			FFmpeg::PacketPosition(packet, _audio->streamTimeBase()),
 			crl::time(0),
 			computeAudioDuration() - 1);
+		updateBytesPerSecond(native.size, till);
 		crl::on_main(&_sessionGuard, [=] {
 			audioReceivedTill(till);
 		});
@@ -368,6 +375,7 @@ bool Player::fileProcessPacket(FFmpeg::Packet &&packet) {
 			FFmpeg::PacketPosition(packet, _video->streamTimeBase()),
 			crl::time(0),
 			computeVideoDuration() - 1);
+		updateBytesPerSecond(native.size, till);
 		crl::on_main(&_sessionGuard, [=] {
 			videoReceivedTill(till);
 		});
@@ -500,8 +508,30 @@ void Player::savePreviousReceivedTill(
 		: kTimeUnknown;
 }
 
+void Player::updateBytesPerSecond(int size, crl::time position) {
+	if (_bytesByPacketsFrom == kTimeUnknown) {
+		_bytesByPacketsFrom = position;
+	}
+	_bytesByPackets += size;
+	const auto duration = position - _bytesByPacketsFrom;
+	if (duration > 0) {
+		_bytesPerSecond = int(std::min(
+			_bytesByPackets * kMsFrequency / int64(duration),
+			int64(std::numeric_limits<int>::max())));
+	}
+}
+
 crl::time Player::loadInAdvanceFor() const {
-	return _remoteLoader ? kLoadInAdvanceForRemote : kLoadInAdvanceForLocal;
+	const auto result = _remoteLoader
+		? kLoadInAdvanceForRemote
+		: kLoadInAdvanceForLocal;
+	const auto bytesPerSecond = _bytesPerSecond.load();
+	if (bytesPerSecond <= 0) {
+		return result;
+	}
+	const auto limit = crl::time(
+		kMaxBytesInAdvance * kMsFrequency / bytesPerSecond);
+	return std::clamp(limit, kMinLoadInAdvance, result);
 }
 
 crl::time Player::computeTotalDuration() const {
@@ -713,6 +743,9 @@ void Player::stop(bool stillActive) {
 	_readTillEnd = false;
 	_loopingShift = 0;
 	_durationByPackets = 0;
+	_bytesByPackets = 0;
+	_bytesByPacketsFrom = kTimeUnknown;
+	_bytesPerSecond = 0;
 	_durationByLastAudioPacket = 0;
 	_durationByLastVideoPacket = 0;
 	const auto header = _information.headerSize;
@@ -794,6 +827,12 @@ QImage Player::frame(const FrameRequest &request) const {
 	return _video->frame(request);
 }
 
+const FrameYUV420 *Player::frameYUV420(const FrameRequest &request) const {
+	Expects(_video != nullptr);
+
+	return _video->frameYUV420(request);
+}
+
 Media::Player::TrackState Player::prepareLegacyState() const {
 	using namespace Media::Player;
 
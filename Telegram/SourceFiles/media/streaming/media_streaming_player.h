@@ -61,6 +61,8 @@ public:
 
 	[[nodiscard]] QSize videoSize() const;
 	[[nodiscard]] QImage frame(const FrameRequest &request) const;
+	[[nodiscard]] const FrameYUV420 *frameYUV420(
+		const FrameRequest &request) const;
 
 	[[nodiscard]] Media::Player::TrackState prepareLegacyState() const;
 
@@ -116,6 +118,9 @@ private:
 		crl::time previousReceivedTill);
 	[[nodiscard]] crl::time loadInAdvanceFor() const;
 
+	// Called from the demuxer thread.
+	void updateBytesPerSecond(int size, crl::time position);
+
 	template <typename Track>
 	int durationByPacket(const Track &track, const FFmpeg::Packet &packet);
 
@@ -185,6 +190,9 @@ private:
 	crl::time _loopingShift = 0;
 	crl::time _previousReceivedTill = kTimeUnknown;
 	std::atomic<int> _durationByPackets = 0;
+	int64 _bytesByPackets = 0;
+	crl::time _bytesByPacketsFrom = kTimeUnknown;
+	std::atomic<int> _bytesPerSecond = 0;
 	int _durationByLastAudioPacket = 0;
 	int _durationByLastVideoPacket = 0;
 
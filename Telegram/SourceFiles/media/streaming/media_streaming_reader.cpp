@@ -23,12 +23,20 @@ constexpr auto kMaxOnlyInHeader = 80 * kPartSize;
 constexpr auto kPartsOutsideFirstSliceGood = 8;
 constexpr auto kSlicesInMemory = 2;
 
-// 1 MB of parts are requested from cloud ahead of reading demand.
+// Over this count of slices in memory in all readers each of them
+// keeps only the slice being read, 128 MB in total.
+constexpr auto kSlicesInMemoryTotal = 16;
+
+// At least 1 MB of parts are requested from cloud ahead of reading demand,
+// more for high bitrate videos, enough for some seconds of playback.
 constexpr auto kPreloadPartsAhead = 8;
+constexpr auto kPreloadDuration = crl::time(8000);
 constexpr auto kDownloaderRequestsLimit = 4;
 
 using PartsMap = base::flat_map<int, QByteArray>;
 
+std::atomic<int> SlicesInMemoryTotal = 0;
+
 struct ParsedCacheEntry {
 	PartsMap parts;
 	std::optional<PartsMap> included;
@@ -59,6 +67,14 @@ int SlicesCount(int size) {
 	return (size + kInSlice - 1) / kInSlice;
 }
 
+int ComplexSerializedSize(const PartsMap &parts) {
+	auto result = int(sizeof(int32) * (1 + 2 * parts.size()));
+	for (const auto &[offset, part] : parts) {
+		result += part.size();
+	}
+	return result;
+}
+
 int MaxSliceSize(int sliceNumber, int size) {
 	return !sliceNumber
 		? size
@@ -262,14 +278,14 @@ void Reader::Slice::addPart(int offset, QByteArray bytes) {
 	}
 }
 
-auto Reader::Slice::prepareFill(int from, int till) -> PrepareFillResult {
+auto Reader::Slice::prepareFill(int from, int till, int preloadParts)
+-> PrepareFillResult {
 	auto result = PrepareFillResult();
 
 	result.ready = false;
 	const auto fromOffset = (from / kPartSize) * kPartSize;
 	const auto tillPart = (till + kPartSize - 1) / kPartSize;
-	const auto preloadTillOffset = (tillPart + kPreloadPartsAhead)
-		* kPartSize;
+	const auto preloadTillOffset = (tillPart + preloadParts) * kPartSize;
 
 	const auto after = ranges::upper_bound(
 		parts,
@@ -333,7 +349,8 @@ auto Reader::Slice::offsetsFromLoader(int from, int till) const
 }
 
 Reader::Slices::Slices(int size, bool useCache)
-: _size(size) {
+: _size(size)
+, _preloadParts(kPreloadPartsAhead) {
 	Expects(size > 0);
 
 	if (useCache) {
@@ -346,6 +363,10 @@ Reader::Slices::Slices(int size, bool useCache)
 	}
 }
 
+Reader::Slices::~Slices() {
+	SlicesInMemoryTotal -= int(_usedSlices.size());
+}
+
 bool Reader::Slices::headerModeUnknown() const {
 	return (_headerMode == HeaderMode::Unknown);
 }
@@ -381,6 +402,10 @@ void Reader::Slices::headerDone(bool fromCache) {
 	}
 }
 
+void Reader::Slices::setPreloadParts(int count) {
+	_preloadParts = count;
+}
+
 int Reader::Slices::headerSize() const {
 	return _header.parts.size() * kPartSize;
 }
@@ -595,9 +620,15 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 	const auto firstTill = std::min(kInSlice, till - fromSlice * kInSlice);
 	const auto secondFrom = 0;
 	const auto secondTill = till - (fromSlice + 1) * kInSlice;
-	const auto first = _data[fromSlice].prepareFill(firstFrom, firstTill);
+	const auto first = _data[fromSlice].prepareFill(
+		firstFrom,
+		firstTill,
+		_preloadParts);
 	const auto second = (fromSlice + 1 < tillSlice)
-		? _data[fromSlice + 1].prepareFill(secondFrom, secondTill)
+		? _data[fromSlice + 1].prepareFill(
+			secondFrom,
+			secondTill,
+			_preloadParts)
 		: Slice::PrepareFillResult();
 	handlePrepareResult(fromSlice, first);
 	if (fromSlice + 1 < tillSlice) {
@@ -635,7 +666,7 @@ auto Reader::Slices::fillFromHeader(int offset, bytes::span buffer)
 	const auto from = offset;
 	const auto till = int(offset + buffer.size());
 
-	const auto prepared = _header.prepareFill(from, till);
+	const auto prepared = _header.prepareFill(from, till, _preloadParts);
 	for (const auto full : prepared.offsetsFromLoader.values()) {
 		if (full < _size) {
 			result.offsetsFromLoader.add(full);
@@ -687,6 +718,7 @@ void Reader::Slices::markSliceUsed(int sliceIndex) {
 	const auto end = _usedSlices.end();
 	if (i == end) {
 		_usedSlices.push_back(sliceIndex);
+		++SlicesInMemoryTotal;
 	} else {
 		const auto next = i + 1;
 		if (next != end) {
@@ -702,12 +734,16 @@ int Reader::Slices::maxSliceSize(int sliceNumber) const {
 Reader::SerializedSlice Reader::Slices::serializeAndUnloadUnused() {
 	using Flag = Slice::Flag;
 
+	const auto limit = (SlicesInMemoryTotal > kSlicesInMemoryTotal)
+		? 1
+		: kSlicesInMemory;
 	if (_headerMode == HeaderMode::Unknown
-		|| _usedSlices.size() <= kSlicesInMemory) {
+		|| int(_usedSlices.size()) <= limit) {
 		return {};
 	}
 	const auto purgeSlice = _usedSlices.front();
 	_usedSlices.pop_front();
+	--SlicesInMemoryTotal;
 	if (!(_data[purgeSlice].flags & Flag::LoadedFromCache)) {
 		// If the only data in this slice was from _header, just leave it.
 		return {};
@@ -765,9 +801,16 @@ Reader::SerializedSlice Reader::Slices::serializeAndUnloadSlice(
 			result.data.append(part);
 		}
 	} else {
-		result.data = serializeComplexSlice(slice);
+		// Serialize everything to one buffer, without growing it,
+		// the padding below adds at most two more bytes.
+		result.data.reserve(ComplexSerializedSize(slice.parts)
+			+ (writeHeaderAndSlice
+				? ComplexSerializedSize(_data[0].parts)
+				: 0)
+			+ 2);
+		serializeComplexSlice(slice, result.data);
 		if (writeHeaderAndSlice) {
-			result.data.append(serializeAndUnloadFirstSliceNoHeader());
+			serializeAndUnloadFirstSliceNoHeader(result.data);
 		}
 
 		// Make sure this data won't be taken for full continuous data.
@@ -796,11 +839,11 @@ void Reader::Slices::unloadSlice(Slice &slice) const {
 	}
 }
 
-QByteArray Reader::Slices::serializeComplexSlice(const Slice &slice) const {
-	auto result = QByteArray();
+void Reader::Slices::serializeComplexSlice(
+		const Slice &slice,
+		QByteArray &result) const {
 	const auto count = slice.parts.size();
 	const auto intSize = sizeof(int32);
-	result.reserve(count * kPartSize + 2 * intSize * (count + 1));
 	const auto appendInt = [&](int value) {
 		auto serialized = int32(value);
 		result.append(
@@ -813,19 +856,18 @@ QByteArray Reader::Slices::serializeComplexSlice(const Slice &slice) const {
 		appendInt(part.size());
 		result.append(part);
 	}
-	return result;
 }
 
-QByteArray Reader::Slices::serializeAndUnloadFirstSliceNoHeader() {
+void Reader::Slices::serializeAndUnloadFirstSliceNoHeader(
+		QByteArray &result) {
 	Expects(_data[0].flags & Slice::Flag::LoadedFromCache);
 
 	auto &slice = _data[0];
 	for (const auto &[offset, part] : _header.parts) {
 		slice.parts.erase(offset);
 	}
-	auto result = serializeComplexSlice(slice);
+	serializeComplexSlice(slice, result);
 	unloadSlice(slice);
-	return result;
 }
 
 Reader::SerializedSlice Reader::Slices::unloadToCache() {
@@ -1172,6 +1214,18 @@ void Reader::headerDone() {
 	_slices.headerDone(false);
 }
 
+void Reader::setPlaybackDuration(crl::time duration) {
+	if (duration <= 0 || duration == kDurationUnavailable) {
+		return;
+	}
+	const auto bytesPerSecond = int64(size()) * 1000 / duration;
+	const auto parts = bytesPerSecond * kPreloadDuration / 1000 / kPartSize;
+	_slices.setPreloadParts(int(std::clamp(
+		parts + 1,
+		int64(kPreloadPartsAhead),
+		int64(kLoadFromRemoteMax))));
+}
+
 int Reader::headerSize() const {
 	return _slices.headerSize();
 }
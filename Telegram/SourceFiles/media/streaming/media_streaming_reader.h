@@ -48,6 +48,7 @@ public:
 		not_null<crl::semaphore*> notify);
 	[[nodiscard]] std::optional<Error> streamingError() const;
 	void headerDone();
+	void setPlaybackDuration(crl::time duration);
 	[[nodiscard]] int headerSize() const;
 	[[nodiscard]] bool fullInCache() const;
 
@@ -69,7 +70,7 @@ public:
 	~Reader();
 
 private:
-	static constexpr auto kLoadFromRemoteMax = 8;
+	static constexpr auto kLoadFromRemoteMax = 32;
 
 	struct CacheHelper;
 
@@ -118,7 +119,7 @@ private:
 
 		void processCacheData(PartsMap &&data);
 		void addPart(int offset, QByteArray bytes);
-		PrepareFillResult prepareFill(int from, int till);
+		PrepareFillResult prepareFill(int from, int till, int preloadParts);
 
 		// Get up to kLoadFromRemoteMax not loaded parts in from-till range.
 		StackIntVector<kLoadFromRemoteMax> offsetsFromLoader(
@@ -133,8 +134,10 @@ private:
 	class Slices {
 	public:
 		Slices(int size, bool useCache);
+		~Slices();
 
 		void headerDone(bool fromCache);
+		void setPreloadParts(int count);
 		[[nodiscard]] int headerSize() const;
 		[[nodiscard]] bool fullInCache() const;
 		[[nodiscard]] bool headerWontBeFilled() const;
@@ -169,9 +172,10 @@ private:
 		[[nodiscard]] SerializedSlice serializeAndUnloadSlice(
 			int sliceNumber);
 		[[nodiscard]] SerializedSlice serializeAndUnloadUnused();
-		[[nodiscard]] QByteArray serializeComplexSlice(
-			const Slice &slice) const;
-		[[nodiscard]] QByteArray serializeAndUnloadFirstSliceNoHeader();
+		void serializeComplexSlice(
+			const Slice &slice,
+			QByteArray &result) const;
+		void serializeAndUnloadFirstSliceNoHeader(QByteArray &result);
 		void markSliceUsed(int sliceIndex);
 		[[nodiscard]] bool computeIsGoodHeader() const;
 		[[nodiscard]] FillResult fillFromHeader(
@@ -186,6 +190,7 @@ private:
 		std::deque<int> _usedSlices;
 		int _size = 0;
 		HeaderMode _headerMode = HeaderMode::Unknown;
+		int _preloadParts = 0;
 		bool _fullInCache = false;
 
 	};
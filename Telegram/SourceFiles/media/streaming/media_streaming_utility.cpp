@@ -72,8 +72,15 @@ FFmpeg::AvErrorWrap ReadNextFrame(Stream &stream) {
 		error = avcodec_receive_frame(
 			stream.codec.get(),
 			stream.frame.get());
-		if (!error
-			|| error.code() != AVERROR(EAGAIN)
+		if (!error) {
+			error = FFmpeg::TransferHwFrame(
+				stream.frame.get(),
+				stream.hwTransferFrame);
+			if (error) {
+				LogError(qstr("av_hwframe_transfer_data"), error);
+			}
+			return error;
+		} else if (error.code() != AVERROR(EAGAIN)
 			|| stream.queue.empty()) {
 			return error;
 		}
@@ -101,6 +108,20 @@ QImage ConvertFrame(
 		AVFrame *frame,
 		QSize resize,
 		QImage storage) {
+	return ConvertFrame(
+		stream.swscale,
+		stream.rotation,
+		frame,
+		resize,
+		std::move(storage));
+}
+
+QImage ConvertFrame(
+		FFmpeg::SwscalePointer &swscale,
+		int rotation,
+		AVFrame *frame,
+		QSize resize,
+		QImage storage) {
 	Expects(frame != nullptr);
 
 	const auto frameSize = QSize(frame->width, frame->height);
@@ -115,7 +136,7 @@ QImage ConvertFrame(
 	}
 	if (resize.isEmpty()) {
 		resize = frameSize;
-	} else if (FFmpeg::RotationSwapWidthHeight(stream.rotation)) {
+	} else if (FFmpeg::RotationSwapWidthHeight(rotation)) {
 		resize.transpose();
 	}
 
@@ -141,11 +162,8 @@ QImage ConvertFrame(
 			from += deltaFrom;
 		}
 	} else {
-		stream.swscale = MakeSwscalePointer(
-			frame,
-			resize,
-			&stream.swscale);
-		if (!stream.swscale) {
+		swscale = MakeSwscalePointer(frame, resize, &swscale);
+		if (!swscale) {
 			return QImage();
 		}
 
@@ -154,7 +172,7 @@ QImage ConvertFrame(
 		int linesize[AV_NUM_DATA_POINTERS] = { storage.bytesPerLine(), 0 };
 
 		const auto lines = sws_scale(
-			stream.swscale.get(),
+			swscale.get(),
 			frame->data,
 			frame->linesize,
 			0,
@@ -174,6 +192,23 @@ QImage ConvertFrame(
 	return storage;
 }
 
+bool ExtractYUV420(not_null<AVFrame*> frame, FrameYUV420 &planes) {
+	if (frame->format != AV_PIX_FMT_YUV420P
+		|| frame->width <= 0
+		|| frame->height <= 0
+		|| !FFmpeg::FrameHasData(frame)) {
+		return false;
+	}
+	planes.size = QSize(frame->width, frame->height);
+	planes.chromaSize = QSize(
+		(frame->width + 1) / 2,
+		(frame->height + 1) / 2);
+	planes.y = { frame->data[0], frame->linesize[0] };
+	planes.u = { frame->data[1], frame->linesize[1] };
+	planes.v = { frame->data[2], frame->linesize[2] };
+	return true;
+}
+
 QImage PrepareByRequest(
 		const QImage &original,
 		const FrameRequest &request,
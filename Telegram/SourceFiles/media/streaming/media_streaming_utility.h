@@ -41,6 +41,7 @@ struct Stream {
 	int rotation = 0;
 	AVRational aspect = FFmpeg::kNormalAspect;
 	FFmpeg::SwscalePointer swscale;
+	FFmpeg::FramePointer hwTransferFrame;
 };
 
 [[nodiscard]] crl::time FramePosition(const Stream &stream);
@@ -57,6 +58,15 @@ struct Stream {
 	AVFrame *frame,
 	QSize resize,
 	QImage storage);
+[[nodiscard]] QImage ConvertFrame(
+	FFmpeg::SwscalePointer &swscale,
+	int rotation,
+	AVFrame *frame,
+	QSize resize,
+	QImage storage);
+[[nodiscard]] bool ExtractYUV420(
+	not_null<AVFrame*> frame,
+	FrameYUV420 &planes);
 [[nodiscard]] QImage PrepareByRequest(
 	const QImage &original,
 	const FrameRequest &request,
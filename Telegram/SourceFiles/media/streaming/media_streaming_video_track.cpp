@@ -305,16 +305,25 @@ void VideoTrackObject::presentFrameIfNeeded() {
 		Expects(frame->position != kFinishedPosition);
 
 		frame->request = _request;
+		if (!frame->request.requireARGB32
+			&& ExtractYUV420(frame->decoded.get(), frame->yuv420)) {
+			frame->format = FrameFormat::YUV420;
+			frame->prepared = QImage();
+			Ensures(VideoTrack::IsRasterized(frame));
+			return;
+		}
 		frame->original = ConvertFrame(
 			_stream,
 			frame->decoded.get(),
 			frame->request.resize,
 			std::move(frame->original));
 		if (frame->original.isNull()) {
+			frame->format = FrameFormat::None;
 			frame->prepared = QImage();
 			fail(Error::InvalidData);
 			return;
 		}
+		frame->format = FrameFormat::ARGB32;
 
 		VideoTrack::PrepareFrameByRequest(frame);
 
@@ -478,6 +487,7 @@ void VideoTrackObject::callReady() {
 	}
 	data.cover = frame->original;
 	data.rotation = _stream.rotation;
+	data.hwAccel = FFmpeg::CodecHwAccelName(_stream.codec.get());
 	data.state.duration = _stream.duration;
 	data.state.position = _syncTimePoint.trackTime;
 	data.state.receivedTill = _readTillEnd
@@ -523,6 +533,7 @@ void VideoTrack::Shared::init(QImage &&cover, crl::time position) {
 	Expects(!initialized());
 
 	_frames[0].original = std::move(cover);
+	_frames[0].format = FrameFormat::ARGB32;
 	_frames[0].position = position;
 
 	// Usually main thread sets displayed time before _counter increment.
@@ -718,7 +729,7 @@ crl::time VideoTrack::Shared::markFrameDisplayed(crl::time now) {
 
 not_null<VideoTrack::Frame*> VideoTrack::Shared::frameForPaint() {
 	const auto result = getFrame(counter() / 2);
-	Assert(!result->original.isNull());
+	Assert(result->format != FrameFormat::None);
 	Assert(result->position != kTimeUnknown);
 	Assert(result->displayed != kTimeUnknown);
 
@@ -734,7 +745,7 @@ VideoTrack::VideoTrack(
 : _streamIndex(stream.index)
 , _streamTimeBase(stream.timeBase)
 , _streamDuration(stream.duration)
-//, _streamRotation(stream.rotation)
+, _streamRotation(stream.rotation)
 //, _streamAspect(stream.aspect)
 , _shared(std::make_unique<Shared>())
 , _wrapped(
@@ -801,8 +812,9 @@ crl::time VideoTrack::markFrameDisplayed(crl::time now) {
 	return result;
 }
 
-QImage VideoTrack::frame(const FrameRequest &request) {
-	const auto frame = _shared->frameForPaint();
+bool VideoTrack::updateFrameRequest(
+		not_null<Frame*> frame,
+		const FrameRequest &request) {
 	const auto changed = (frame->request != request)
 		&& (request.strict || !frame->request.strict);
 	if (changed) {
@@ -811,9 +823,36 @@ QImage VideoTrack::frame(const FrameRequest &request) {
 			unwrapped.updateFrameRequest(request);
 		});
 	}
+	return changed;
+}
+
+QImage VideoTrack::frame(const FrameRequest &request) {
+	const auto frame = _shared->frameForPaint();
+	auto changed = updateFrameRequest(frame, request);
+	if (frame->format == FrameFormat::YUV420) {
+		frame->original = ConvertFrame(
+			_swscale,
+			_streamRotation,
+			frame->decoded.get(),
+			frame->request.resize,
+			std::move(frame->original));
+		if (frame->original.isNull()) {
+			return QImage();
+		}
+		frame->format = FrameFormat::ARGB32;
+		changed = true;
+	}
 	return PrepareFrameByRequest(frame, !changed);
 }
 
+const FrameYUV420 *VideoTrack::frameYUV420(const FrameRequest &request) {
+	const auto frame = _shared->frameForPaint();
+	updateFrameRequest(frame, request);
+	return (frame->format == FrameFormat::YUV420)
+		? &frame->yuv420
+		: nullptr;
+}
+
 QImage VideoTrack::PrepareFrameByRequest(
 		not_null<Frame*> frame,
 		bool useExistingPrepared) {
@@ -837,7 +876,7 @@ bool VideoTrack::IsDecoded(not_null<const Frame*> frame) {
 
 bool VideoTrack::IsRasterized(not_null<const Frame*> frame) {
 	return IsDecoded(frame)
-		&& !frame->original.isNull();
+		&& (frame->format != FrameFormat::None);
 }
 
 bool VideoTrack::IsStale(not_null<const Frame*> frame, crl::time trackTime) {
@@ -49,6 +49,10 @@ public:
 	[[nodiscard]] crl::time markFrameDisplayed(crl::time now);
 	[[nodiscard]] crl::time nextFrameDisplayTime() const;
 	[[nodiscard]] QImage frame(const FrameRequest &request);
+
+	// Planes of the current frame if it was left in YUV420, else nullptr.
+	// Valid until the next markFrameDisplayed() or frame() call.
+	[[nodiscard]] const FrameYUV420 *frameYUV420(const FrameRequest &request);
 	[[nodiscard]] rpl::producer<> checkNextFrame() const;
 	[[nodiscard]] rpl::producer<> waitingForData() const;
 
@@ -58,9 +62,17 @@ public:
 private:
 	friend class VideoTrackObject;
 
+	enum class FrameFormat {
+		None,
+		ARGB32,
+		YUV420,
+	};
+
 	struct Frame {
 		FFmpeg::FramePointer decoded = FFmpeg::MakeFramePointer();
 		QImage original;
+		FrameYUV420 yuv420;
+		FrameFormat format = FrameFormat::None;
 		crl::time position = kTimeUnknown;
 		crl::time displayed = kTimeUnknown;
 		crl::time display = kTimeUnknown;
@@ -117,6 +129,9 @@ private:
 
 	};
 
+	bool updateFrameRequest(
+		not_null<Frame*> frame,
+		const FrameRequest &request);
 	static QImage PrepareFrameByRequest(
 		not_null<Frame*> frame,
 		bool useExistingPrepared = false);
@@ -129,10 +144,13 @@ private:
 	const int _streamIndex = 0;
 	const AVRational _streamTimeBase;
 	const crl::time _streamDuration = 0;
-	//const int _streamRotation = 0;
+	const int _streamRotation = 0;
 	//AVRational _streamAspect = kNormalAspect;
 	std::unique_ptr<Shared> _shared;
 
+	// Converts YUV420 frames left for painting from planes.
+	FFmpeg::SwscalePointer _swscale;
+
 	using Implementation = VideoTrackObject;
 	crl::object_on_queue<Implementation> _wrapped;
 
@@ -142,6 +142,7 @@ public:
 	void setState(State state);
 	State state() const;
 	bool removed() const;
+	bool ready() const;
 
 	void paint(Painter &p, int x, int y, int outerWidth, float64 progress);
 	ClickHandlerPtr getState(QPoint point) const;
@@ -325,6 +326,10 @@ bool GroupThumbs::Thumb::removed() const {
 	return (_state == State::Dying) && _hiding && !_opacity.current();
 }
 
+bool GroupThumbs::Thumb::ready() const {
+	return !_image || !_full.isNull();
+}
+
 void GroupThumbs::Thumb::paint(
 		Painter &p,
 		int x,
@@ -624,13 +629,17 @@ void GroupThumbs::clear() {
 }
 
 void GroupThumbs::startDelayedAnimation() {
+	_strip = QPixmap();
 	_animation.stop();
 	_waitingForAnimationStart = true;
 	countUpdatedRect();
 }
 
 void GroupThumbs::resizeToWidth(int newWidth) {
-	_width = newWidth;
+	if (_width != newWidth) {
+		_width = newWidth;
+		_strip = QPixmap();
+	}
 }
 
 int GroupThumbs::height() const {
@@ -661,7 +670,38 @@ void GroupThumbs::update() {
 	_updateRequests.fire_copy(_updatedRect);
 }
 
+bool GroupThumbs::stripCacheAllowed() const {
+	return !_waitingForAnimationStart
+		&& !_animation.animating()
+		&& _dying.empty()
+		&& !_items.empty()
+		&& ranges::all_of(_items, [](not_null<Thumb*> thumb) {
+			return thumb->ready();
+		});
+}
+
+void GroupThumbs::validateStrip() {
+	if (!_strip.isNull()) {
+		return;
+	}
+	_strip = QPixmap(
+		QSize(_width, st::mediaviewGroupHeight) * cIntRetinaFactor());
+	_strip.setDevicePixelRatio(cRetinaFactor());
+	_strip.fill(Qt::transparent);
+	Painter p(&_strip);
+	for (const auto &cacheItem : _cache) {
+		cacheItem.second->paint(p, _width / 2, 0, _width, 1.);
+	}
+}
+
 void GroupThumbs::paint(Painter &p, int x, int y, int outerWidth) {
+	// While nothing moves the whole strip is painted from one pixmap,
+	// the overlay repaints this area on each frame of a video.
+	if (stripCacheAllowed()) {
+		validateStrip();
+		p.drawPixmap(x, y + st::mediaviewGroupPadding.top(), _strip);
+		return;
+	}
 	const auto progress = _waitingForAnimationStart
 		? 0.
 		: _animation.value(1.);
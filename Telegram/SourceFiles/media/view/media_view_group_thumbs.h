@@ -110,6 +110,8 @@ private:
 	void markRestAsDying();
 	void animatePreviouslyAlive(const std::vector<not_null<Thumb*>> &old);
 	void startDelayedAnimation();
+	bool stripCacheAllowed() const;
+	void validateStrip();
 
 	Context _context;
 	bool _waitingForAnimationStart = true;
@@ -119,6 +121,7 @@ private:
 	base::flat_map<Key, std::unique_ptr<Thumb>> _cache;
 	int _width = 0;
 	QRect _updatedRect;
+	QPixmap _strip;
 
 	rpl::event_stream<QRect> _updateRequests;
 	rpl::event_stream<Key> _activateStream;
@@ -48,6 +48,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "styles/style_mediaview.h"
 #include "styles/style_history.h"
 
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QOpenGLShaderProgram>
+#endif // USE_OPENGL_OVERLAY_WIDGET
+
 namespace Media {
 namespace View {
 namespace {
@@ -171,6 +176,193 @@ struct OverlayWidget::Collage {
 	CollageKey key;
 };
 
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+
+// Uploads the planes to three luminance textures and converts them
+// to RGB in the fragment shader, saving the swscale pass per frame.
+class OverlayWidget::YUV420Painter final : protected QOpenGLFunctions {
+public:
+	[[nodiscard]] bool init();
+	void paint(
+		const Streaming::FrameYUV420 &frame,
+		QRect rect,
+		QSize outer,
+		int rotation);
+	~YUV420Painter();
+
+private:
+	void upload(
+		int index,
+		const Streaming::FrameYUV420::Plane &plane,
+		QSize size);
+
+	QOpenGLContext *_context = nullptr;
+	QOpenGLShaderProgram _program;
+	std::array<GLuint, 3> _textures = { { 0 } };
+	std::array<QSize, 3> _sizes;
+
+};
+
+bool OverlayWidget::YUV420Painter::init() {
+	_context = QOpenGLContext::currentContext();
+	if (!_context) {
+		return false;
+	}
+	initializeOpenGLFunctions();
+	const auto vertex = _program.addShaderFromSourceCode(
+		QOpenGLShader::Vertex,
+		"attribute vec2 position;\n"
+		"attribute vec2 texcoord;\n"
+		"varying vec2 v_texcoord;\n"
+		"void main() {\n"
+		"	gl_Position = vec4(position, 0.0, 1.0);\n"
+		"	v_texcoord = texcoord;\n"
+		"}\n");
+
+	// BT.601 limited range, the usual colorspace of streamed videos.
+	const auto fragment = _program.addShaderFromSourceCode(
+		QOpenGLShader::Fragment,
+		"varying vec2 v_texcoord;\n"
+		"uniform sampler2D y_texture;\n"
+		"uniform sampler2D u_texture;\n"
+		"uniform sampler2D v_texture;\n"
+		"void main() {\n"
+		"	float y = 1.164 * (texture2D(y_texture, v_texcoord).r - 0.0625);\n"
+		"	float u = texture2D(u_texture, v_texcoord).r - 0.5;\n"
+		"	float v = texture2D(v_texture, v_texcoord).r - 0.5;\n"
+		"	gl_FragColor = vec4(\n"
+		"		y + 1.596 * v,\n"
+		"		y - 0.391 * u - 0.813 * v,\n"
+		"		y + 2.018 * u,\n"
+		"		1.0);\n"
+		"}\n");
+	if (!vertex
+		|| !fragment
+		|| !_program.link()
+		|| !_program.bind()) {
+		return false;
+	}
+	_program.setUniformValue("y_texture", 0);
+	_program.setUniformValue("u_texture", 1);
+	_program.setUniformValue("v_texture", 2);
+	_program.release();
+
+	glGenTextures(_textures.size(), _textures.data());
+	for (const auto texture : _textures) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+void OverlayWidget::YUV420Painter::upload(
+		int index,
+		const Streaming::FrameYUV420::Plane &plane,
+		QSize size) {
+	glActiveTexture(GL_TEXTURE0 + index);
+	glBindTexture(GL_TEXTURE_2D, _textures[index]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, plane.stride);
+	if (_sizes[index] != size) {
+		_sizes[index] = size;
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			GL_LUMINANCE,
+			size.width(),
+			size.height(),
+			0,
+			GL_LUMINANCE,
+			GL_UNSIGNED_BYTE,
+			plane.data);
+	} else {
+		glTexSubImage2D(
+			GL_TEXTURE_2D,
+			0,
+			0,
+			0,
+			size.width(),
+			size.height(),
+			GL_LUMINANCE,
+			GL_UNSIGNED_BYTE,
+			plane.data);
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void OverlayWidget::YUV420Painter::paint(
+		const Streaming::FrameYUV420 &frame,
+		QRect rect,
+		QSize outer,
+		int rotation) {
+	upload(0, frame.y, frame.size);
+	upload(1, frame.u, frame.chromaSize);
+	upload(2, frame.v, frame.chromaSize);
+
+	const auto x = [&](int value) {
+		return GLfloat(2. * value / outer.width() - 1.);
+	};
+	const auto y = [&](int value) {
+		return GLfloat(1. - 2. * value / outer.height());
+	};
+	const auto left = x(rect.x());
+	const auto right = x(rect.x() + rect.width());
+	const auto top = y(rect.y());
+	const auto bottom = y(rect.y() + rect.height());
+	const GLfloat positions[] = {
+		left, top,
+		right, top,
+		right, bottom,
+		left, bottom,
+	};
+
+	// Texture coordinates of the top-left, top-right, bottom-right and
+	// bottom-left screen corners, shifted by one corner per 90 degrees.
+	const GLfloat corners[] = {
+		0.f, 0.f,
+		1.f, 0.f,
+		1.f, 1.f,
+		0.f, 1.f,
+	};
+	const auto shift = (rotation / 90) % 4;
+	GLfloat texcoords[8];
+	for (auto i = 0; i != 4; ++i) {
+		const auto from = (i + 4 - shift) % 4;
+		texcoords[i * 2] = corners[from * 2];
+		texcoords[i * 2 + 1] = corners[from * 2 + 1];
+	}
+
+	_program.bind();
+	const auto position = _program.attributeLocation("position");
+	const auto texcoord = _program.attributeLocation("texcoord");
+	_program.enableAttributeArray(position);
+	_program.enableAttributeArray(texcoord);
+	_program.setAttributeArray(position, positions, 2);
+	_program.setAttributeArray(texcoord, texcoords, 2);
+	glDisable(GL_BLEND);
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	_program.disableAttributeArray(position);
+	_program.disableAttributeArray(texcoord);
+	_program.release();
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+OverlayWidget::YUV420Painter::~YUV420Painter() {
+	// Otherwise the textures are freed together with the context.
+	if (_context && QOpenGLContext::currentContext() == _context) {
+		glDeleteTextures(_textures.size(), _textures.data());
+	}
+}
+
+#endif // USE_OPENGL_OVERLAY_WIDGET
+
 struct OverlayWidget::Streamed {
 	template <typename Callback>
 	Streamed(
@@ -367,15 +559,22 @@ bool OverlayWidget::videoIsGifv() const {
 	return _streamed && _doc->isAnimation() && !_doc->isVideoMessage();
 }
 
+Streaming::FrameRequest OverlayWidget::videoFrameRequest() const {
+	auto result = Streaming::FrameRequest();
+	//result.radius = (_doc && _doc->isVideoMessage())
+	//	? ImageRoundRadius::Ellipse
+	//	: ImageRoundRadius::None;
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+	result.requireARGB32 = _yuv420Failed;
+#endif // USE_OPENGL_OVERLAY_WIDGET
+	return result;
+}
+
 QImage OverlayWidget::videoFrame() const {
 	Expects(videoShown());
 
-	auto request = Streaming::FrameRequest();
-	//request.radius = (_doc && _doc->isVideoMessage())
-	//	? ImageRoundRadius::Ellipse
-	//	: ImageRoundRadius::None;
 	return _streamed->player.ready()
-		? _streamed->player.frame(request)
+		? _streamed->player.frame(videoFrameRequest())
 		: _streamed->info.video.cover;
 }
 
@@ -977,6 +1176,14 @@ void OverlayWidget::clearData() {
 
 OverlayWidget::~OverlayWidget() {
 	delete base::take(_menu);
+
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+	if (_yuv420Painter) {
+		makeCurrent();
+		_yuv420Painter = nullptr;
+		doneCurrent();
+	}
+#endif // USE_OPENGL_OVERLAY_WIDGET
 }
 
 void OverlayWidget::clickHandlerActiveChanged(const ClickHandlerPtr &p, bool active) {
@@ -2718,7 +2925,45 @@ void OverlayWidget::checkGroupThumbsAnimation() {
 	}
 }
 
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+bool OverlayWidget::paintVideoFrameYUV420(Painter &p) {
+	Expects(_streamed != nullptr);
+
+	if (_yuv420Failed || !_streamed->player.ready()) {
+		return false;
+	}
+	const auto frame = _streamed->player.frameYUV420(videoFrameRequest());
+	if (!frame) {
+		return false;
+	}
+	p.beginNativePainting();
+	if (!_yuv420Painter) {
+		_yuv420Painter = std::make_unique<YUV420Painter>();
+		if (!_yuv420Painter->init()) {
+			LOG(("OpenGL Error: Could not init YUV420 video painter."));
+			_yuv420Painter = nullptr;
+			_yuv420Failed = true;
+			p.endNativePainting();
+			return false;
+		}
+	}
+	_yuv420Painter->paint(
+		*frame,
+		contentRect(),
+		size(),
+		_streamed->info.video.rotation);
+	p.endNativePainting();
+	return true;
+}
+#endif // USE_OPENGL_OVERLAY_WIDGET
+
 void OverlayWidget::paintTransformedVideoFrame(Painter &p) {
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+	if (paintVideoFrameYUV420(p)) {
+		return;
+	}
+#endif // USE_OPENGL_OVERLAY_WIDGET
+
 	const auto rect = contentRect();
 	const auto image = videoFrameForDirectPaint();
 	//if (_fullScreenVideo) {
@@ -3135,7 +3380,7 @@ bool OverlayWidget::moveToNext(int delta) {
 		return false;
 	}
 	auto newIndex = *_index + delta;
-	return moveToEntity(entityByIndex(newIndex));
+	return moveToEntity(entityByIndex(newIndex), delta);
 }
 
 bool OverlayWidget::moveToEntity(const Entity &entity, int preloadDelta) {
@@ -3166,9 +3411,17 @@ void OverlayWidget::preloadData(int delta) {
 	if (!_index) {
 		return;
 	}
-	auto from = *_index + (delta ? delta : -1);
-	auto till = *_index + (delta ? delta * kPreloadCount : 1);
-	if (from > till) std::swap(from, till);
+	// Going in one direction preloads further in it, for the first
+	// display both neighbours are preloaded.
+	auto indices = std::vector<int>();
+	if (delta != 0) {
+		for (auto i = 1; i <= kPreloadCount; ++i) {
+			indices.push_back(*_index + delta * i);
+		}
+	} else {
+		indices.push_back(*_index - 1);
+		indices.push_back(*_index + 1);
+	}
 
 	if (delta != 0) {
 		auto forgetIndex = *_index - delta * 2;
@@ -3180,7 +3433,7 @@ void OverlayWidget::preloadData(int delta) {
 		}
 	}
 
-	for (auto index = from; index != till; ++index) {
+	for (const auto index : indices) {
 		auto entity = entityByIndex(index);
 		if (auto photo = base::get_if<not_null<PhotoData*>>(&entity.data)) {
 			(*photo)->download(fileOrigin());
@@ -39,6 +39,7 @@ struct TrackState;
 namespace Streaming {
 struct Information;
 struct Update;
+struct FrameRequest;
 enum class Error;
 } // namespace Streaming
 } // namespace Media
@@ -304,12 +305,16 @@ private:
 	[[nodiscard]] bool videoShown() const;
 	[[nodiscard]] QSize videoSize() const;
 	[[nodiscard]] bool videoIsGifv() const;
+	[[nodiscard]] Streaming::FrameRequest videoFrameRequest() const;
 	[[nodiscard]] QImage videoFrame() const;
 	[[nodiscard]] QImage videoFrameForDirectPaint() const;
 	[[nodiscard]] QImage transformVideoFrame(QImage frame) const;
 	[[nodiscard]] bool documentContentShown() const;
 	[[nodiscard]] bool documentBubbleShown() const;
 	void paintTransformedVideoFrame(Painter &p);
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+	bool paintVideoFrameYUV420(Painter &p);
+#endif // USE_OPENGL_OVERLAY_WIDGET
 	void clearStreaming();
 
 	QBrush _transparentBrush;
@@ -375,6 +380,12 @@ private:
 	Ui::RadialAnimation _radial;
 	QImage _radialCache;
 
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+	class YUV420Painter;
+	std::unique_ptr<YUV420Painter> _yuv420Painter;
+	bool _yuv420Failed = false;
+#endif // USE_OPENGL_OVERLAY_WIDGET
+
 	History *_migrated = nullptr;
 	History *_history = nullptr; // if conversation photos or files overview
 	PeerData *_peer = nullptr;
@@ -71,6 +71,7 @@ class ConcurrentSender : public base::has_weak_ptr {
 		void setFailHandler(InvokeFullFail &&invoke) noexcept;
 		void setFailSkipPolicy(FailSkipPolicy policy) noexcept;
 		void setAfter(mtpRequestId requestId) noexcept;
+		void setPriority(RequestPriority priority) noexcept;
 
 	private:
 		not_null<ConcurrentSender*> _sender;
@@ -105,6 +106,8 @@ public:
 			ShiftedDcId dcId) noexcept;
 		[[nodiscard]] SpecificRequestBuilder &afterDelay(
 			crl::time ms) noexcept;
+		[[nodiscard]] SpecificRequestBuilder &withPriority(
+			RequestPriority priority) noexcept;
 
 #ifndef MTP_SENDER_USE_GENERIC_HANDLERS
 		// Allow code completion to show response type.
@@ -244,6 +247,14 @@ auto ConcurrentSender::SpecificRequestBuilder<Request>::afterDelay(
 	return *this;
 }
 
+template <typename Request>
+auto ConcurrentSender::SpecificRequestBuilder<Request>::withPriority(
+	RequestPriority priority
+) noexcept -> SpecificRequestBuilder & {
+	setPriority(priority);
+	return *this;
+}
+
 #ifndef MTP_SENDER_USE_GENERIC_HANDLERS
 // Allow code completion to show response type.
 template <typename Request>
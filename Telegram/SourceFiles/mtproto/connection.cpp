@@ -12,6 +12,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/rpc_sender.h"
 #include "mtproto/dc_options.h"
 #include "mtproto/connection_abstract.h"
+#include "mtproto/mtp_aes_ige.h"
+#include "storage/localstorage.h"
 #include "zlib.h"
 #include "core/application.h"
 #include "core/launcher.h"
@@ -19,6 +21,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/openssl_help.h"
 #include "base/qthelp_url.h"
 #include "base/unixtime.h"
+#include "base/tracing.h"
 
 extern "C" {
 #include <openssl/bn.h>
@@ -41,6 +44,9 @@ constexpr auto kRecreateKeyId = AuthKey::KeyId(0xFFFFFFFFFFFFFFFFULL);
 constexpr auto kIntSize = static_cast<int>(sizeof(mtpPrime));
 constexpr auto kMaxModExpSize = 256;
 constexpr auto kWaitForBetterTimeout = crl::time(2000);
+constexpr auto kTestConnectionStagger = crl::time(250);
+constexpr auto kPreferredConnectionStagger = crl::time(1000);
+constexpr auto kPreferredConnectionPriority = 8;
 constexpr auto kMinConnectedTimeout = crl::time(1000);
 constexpr auto kMaxConnectedTimeout = crl::time(8000);
 constexpr auto kMinReceiveTimeout = crl::time(4000);
@@ -49,6 +55,9 @@ constexpr auto kMarkConnectionOldTimeout = crl::time(192000);
 constexpr auto kPingDelayDisconnect = 60;
 constexpr auto kPingSendAfter = crl::time(30000);
 constexpr auto kPingSendAfterForce = crl::time(45000);
+constexpr auto kTelemetryPeriod = crl::time(1000);
+constexpr auto kMaxContainerMessages = 1000;
+constexpr auto kMaxLowPriorityContainerSize = 64 * 1024;
 constexpr auto kTestModeDcIdShift = 10000;
 
 // If we can't connect for this time we will ask _instance to update config.
@@ -220,11 +229,195 @@ ModExpFirst CreateModExp(
 	}
 }
 
+// Leaves in toSend and returns the requests for the next container.
+// Each priority class with waiting requests gets at least one of them,
+// background and bulk requests beyond that are limited in size.
+PreRequestMap TakeDeferredRequests(PreRequestMap &toSend) {
+	const auto low = [](const SecureRequest &request) {
+		return (request->priority >= RequestPriority::Background);
+	};
+	const auto limited = (toSend.size() > kMaxContainerMessages)
+		|| ranges::any_of(toSend, [&](const auto &pair) {
+			return low(pair.second);
+		});
+	if (!limited) {
+		return {};
+	}
+
+	// Stable sort keeps the request id order inside a priority class.
+	auto ordered = std::vector<std::pair<mtpRequestId, SecureRequest>>(
+		toSend.begin(),
+		toSend.end());
+	ranges::stable_sort(ordered, ranges::less(), [](const auto &pair) {
+		return pair.second->priority;
+	});
+
+	auto selected = base::flat_set<mtpRequestId>();
+	auto lowSize = 0;
+	const auto canTake = [&](const SecureRequest &request) {
+		// An invokeAfter dependency must never be sent after the request.
+		const auto &after = request->after;
+		return !after
+			|| !toSend.contains(after->requestId)
+			|| selected.contains(after->requestId);
+	};
+	const auto take = [&](const auto &pair) {
+		selected.emplace(pair.first);
+		if (low(pair.second)) {
+			lowSize += pair.second.messageSize() * sizeof(mtpPrime);
+		}
+	};
+	auto classStart = ordered.begin();
+	while (classStart != ordered.end()) {
+		const auto priority = classStart->second->priority;
+		const auto classEnd = std::find_if(classStart, ordered.end(), [&](
+				const auto &pair) {
+			return (pair.second->priority != priority);
+		});
+		const auto first = std::find_if(classStart, classEnd, [&](
+				const auto &pair) {
+			return canTake(pair.second);
+		});
+		if (first != classEnd) {
+			take(*first);
+		}
+		classStart = classEnd;
+	}
+	for (const auto &pair : ordered) {
+		if (selected.size() >= kMaxContainerMessages) {
+			break;
+		} else if (selected.contains(pair.first) || !canTake(pair.second)) {
+			continue;
+		} else if (low(pair.second)
+			&& (lowSize + pair.second.messageSize() * sizeof(mtpPrime)
+				> kMaxLowPriorityContainerSize)) {
+			continue;
+		}
+		take(pair);
+	}
+
+	auto result = PreRequestMap();
+	for (auto i = toSend.begin(); i != toSend.end();) {
+		if (selected.contains(i->first)) {
+			++i;
+		} else {
+			result.emplace(i->first, std::move(i->second));
+			i = toSend.erase(i);
+		}
+	}
+	return result;
+}
+
+// Validated dh primes and precomputed g_b values, shared by connections.
+class DhCache final {
+public:
+	[[nodiscard]] bool checkPrime(bytes::const_span primeBytes, int g);
+
+	// Each returned value is used only once.
+	[[nodiscard]] ModExpFirst takeModExp(int g, bytes::const_span primeBytes);
+
+	// Starts precomputing for the last used dh parameters.
+	void warmUp();
+
+private:
+	using Key = std::pair<int, bytes::vector>;
+
+	void refill(const Key &key);
+
+	QMutex _mutex;
+	base::flat_set<Key> _goodPrimes;
+	base::flat_map<Key, std::vector<ModExpFirst>> _modExps;
+	base::flat_set<Key> _refilling;
+	std::optional<Key> _lastUsed;
+
+};
+
+constexpr auto kPrecomputedModExpsCount = 4;
+
+DhCache &GetDhCache() {
+	// Never destroyed, because refilling may run on exit.
+	static const auto result = new DhCache();
+	return *result;
+}
+
+bool DhCache::checkPrime(bytes::const_span primeBytes, int g) {
+	auto key = Key(g, bytes::make_vector(primeBytes));
+	{
+		QMutexLocker lock(&_mutex);
+		if (_goodPrimes.contains(key)) {
+			return true;
+		}
+	}
+	if (!IsPrimeAndGood(primeBytes, g)) {
+		return false;
+	}
+	QMutexLocker lock(&_mutex);
+	_goodPrimes.emplace(std::move(key));
+	return true;
+}
+
+ModExpFirst DhCache::takeModExp(int g, bytes::const_span primeBytes) {
+	const auto key = Key(g, bytes::make_vector(primeBytes));
+	auto result = std::optional<ModExpFirst>();
+	{
+		QMutexLocker lock(&_mutex);
+		_lastUsed = key;
+		auto &list = _modExps[key];
+		if (!list.empty()) {
+			result = std::move(list.back());
+			list.pop_back();
+		}
+	}
+	refill(key);
+	if (result) {
+		return std::move(*result);
+	}
+	auto randomSeed = bytes::vector(ModExpFirst::kRandomPowerSize);
+	bytes::set_random(randomSeed);
+	return CreateModExp(g, primeBytes, randomSeed);
+}
+
+void DhCache::warmUp() {
+	auto key = std::optional<Key>();
+	{
+		QMutexLocker lock(&_mutex);
+		key = _lastUsed;
+	}
+	if (key) {
+		refill(*key);
+	}
+}
+
+void DhCache::refill(const Key &key) {
+	{
+		QMutexLocker lock(&_mutex);
+		if (_modExps[key].size() >= kPrecomputedModExpsCount
+			|| !_refilling.emplace(key).second) {
+			return;
+		}
+	}
+	crl::async([=] {
+		while (true) {
+			auto randomSeed = bytes::vector(ModExpFirst::kRandomPowerSize);
+			bytes::set_random(randomSeed);
+			auto modExp = CreateModExp(key.first, key.second, randomSeed);
+
+			QMutexLocker lock(&_mutex);
+			auto &list = _modExps[key];
+			list.push_back(std::move(modExp));
+			if (list.size() >= kPrecomputedModExpsCount) {
+				_refilling.remove(key);
+				return;
+			}
+		}
+	});
+}
+
 void wrapInvokeAfter(SecureRequest &to, const SecureRequest &from, const RequestMap &haveSent, int32 skipBeforeRequest = 0) {
 	const auto afterId = *(mtpMsgId*)(from->after->data() + 4);
-	const auto i = afterId ? haveSent.constFind(afterId) : haveSent.cend();
+	const auto i = afterId ? haveSent.find(afterId) : haveSent.cend();
 	int32 size = to->size(), lenInInts = (from.innerLength() >> 2), headlen = 4, fulllen = headlen + lenInInts;
-	if (i == haveSent.constEnd()) { // no invoke after or such msg was not sent or was completed recently
+	if (i == haveSent.cend()) { // no invoke after or such msg was not sent or was completed recently
 		to->resize(size + fulllen + skipBeforeRequest);
 		if (skipBeforeRequest) {
 			memcpy(to->data() + size, from->constData() + 4, headlen * sizeof(mtpPrime));
@@ -342,16 +535,57 @@ Connection::~Connection() {
 	}
 }
 
+int ConnectionPrivate::testConnectionPriority(
+		DcOptions::Variants::Protocol protocol,
+		const QString &ip,
+		int port,
+		const bytes::vector &protocolSecret) const {
+	const auto base = (qthelp::is_ipv6(ip) ? 0 : 1)
+		+ (protocol == DcOptions::Variants::Tcp ? 1 : 0)
+		+ (protocolSecret.empty() ? 0 : 1);
+
+	// History outweighs the static preference of TCP over IPv4.
+	const auto rating = _instance->dcOptions()->endpointRating(
+		BareDcId(_shiftedDcId),
+		protocol,
+		ip.toStdString(),
+		port);
+	return base + rating * (kPreferredConnectionPriority / 2);
+}
+
+void ConnectionPrivate::startNextTestConnection() {
+	if (_pendingTestConnections.empty()) {
+		return;
+	}
+	auto next = std::move(_pendingTestConnections.front());
+	_pendingTestConnections.erase(begin(_pendingTestConnections));
+
+	DEBUG_LOG(("MTP Info: starting test connection to %1:%2, priority %3."
+		).arg(next.ip
+		).arg(next.port
+		).arg(next.priority));
+	appendTestConnection(
+		next.protocol,
+		next.ip,
+		next.port,
+		next.protocolSecret,
+		next.priority);
+	if (!_pendingTestConnections.empty()) {
+		_startNextTestTimer.callOnce(
+			(next.priority >= kPreferredConnectionPriority
+				? kPreferredConnectionStagger
+				: kTestConnectionStagger));
+	}
+}
+
 void ConnectionPrivate::appendTestConnection(
 		DcOptions::Variants::Protocol protocol,
 		const QString &ip,
 		int port,
-		const bytes::vector &protocolSecret) {
+		const bytes::vector &protocolSecret,
+		int priority) {
 	QWriteLocker lock(&stateConnMutex);
 
-	const auto priority = (qthelp::is_ipv6(ip) ? 0 : 1)
-		+ (protocol == DcOptions::Variants::Tcp ? 1 : 0)
-		+ (protocolSecret.empty() ? 0 : 1);
 	_testConnections.push_back({
 		AbstractConnection::Create(
 			_instance,
@@ -359,7 +593,10 @@ void ConnectionPrivate::appendTestConnection(
 			thread(),
 			protocolSecret,
 			_connectionOptions->proxy),
-		priority
+		priority,
+		protocol,
+		ip,
+		port
 	});
 	const auto weak = _testConnections.back().data.get();
 	connect(weak, &AbstractConnection::error, [=](int errorCode) {
@@ -408,6 +645,8 @@ void ConnectionPrivate::destroyAllConnections() {
 	_waitForBetterTimer.cancel();
 	_waitForReceivedTimer.cancel();
 	_waitForConnectedTimer.cancel();
+	_startNextTestTimer.cancel();
+	_pendingTestConnections.clear();
 	_testConnections.clear();
 	_connection = nullptr;
 }
@@ -423,6 +662,7 @@ ConnectionPrivate::ConnectionPrivate(
 , _state(DisconnectedState)
 , _shiftedDcId(shiftedDcId)
 , _owner(owner)
+, _startNextTestTimer(thread, [=] { startNextTestConnection(); })
 , _retryTimer(thread, [=] { retryByTimer(); })
 , _oldConnectionTimer(thread, [=] { markConnectionOld(); })
 , _waitForConnectedTimer(thread, [=] { waitConnectedFailed(); })
@@ -431,6 +671,7 @@ ConnectionPrivate::ConnectionPrivate(
 , _waitForReceived(kMinReceiveTimeout)
 , _waitForConnected(kMinConnectedTimeout)
 , _pingSender(thread, [=] { sendPingByTimer(); })
+, _telemetryTimer(thread, [=] { sendTelemetry(); })
 , sessionData(data) {
 	Expects(_shiftedDcId != 0);
 
@@ -533,13 +774,13 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 	auto setSeqNumbers = RequestMap();
 	auto replaces = QMap<mtpMsgId, mtpMsgId>();
 	for (auto i = haveSent.cbegin(), e = haveSent.cend(); i != e; ++i) {
-		if (!i.value().isSentContainer()) {
-			if (!*(mtpMsgId*)(i.value()->constData() + 4)) continue;
+		if (!i->second.isSentContainer()) {
+			if (!*(mtpMsgId*)(i->second->constData() + 4)) continue;
 
-			mtpMsgId id = i.key();
+			mtpMsgId id = i->first;
 			if (id > newId) {
 				while (true) {
-					if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+					if (toResend.find(newId) == toResend.cend() && wereAcked.find(newId) == wereAcked.cend() && haveSent.find(newId) == haveSent.cend()) {
 						break;
 					}
 					const auto m = base::unixtime::mtproto_msg_id();
@@ -551,22 +792,22 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 				MTP_LOG(_shiftedDcId, ("Replacing msgId %1 to %2!").arg(id).arg(newId));
 				replaces.insert(id, newId);
 				id = newId;
-				*(mtpMsgId*)(i.value()->data() + 4) = id;
+				*(mtpMsgId*)(i->second->data() + 4) = id;
 			}
-			setSeqNumbers.insert(id, i.value());
+			setSeqNumbers.insert_or_assign(id, i->second);
 		}
 	}
 	for (auto i = toResend.cbegin(), e = toResend.cend(); i != e; ++i) { // collect all non-container requests
-		const auto j = toSend.constFind(i.value());
+		const auto j = toSend.find(i->second);
 		if (j == toSend.cend()) continue;
 
-		if (!j.value().isSentContainer()) {
-			if (!*(mtpMsgId*)(j.value()->constData() + 4)) continue;
+		if (!j->second.isSentContainer()) {
+			if (!*(mtpMsgId*)(j->second->constData() + 4)) continue;
 
-			mtpMsgId id = i.key();
+			mtpMsgId id = i->first;
 			if (id > newId) {
 				while (true) {
-					if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+					if (toResend.find(newId) == toResend.cend() && wereAcked.find(newId) == wereAcked.cend() && haveSent.find(newId) == haveSent.cend()) {
 						break;
 					}
 					const auto m = base::unixtime::mtproto_msg_id();
@@ -578,9 +819,9 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 				MTP_LOG(_shiftedDcId, ("Replacing msgId %1 to %2!").arg(id).arg(newId));
 				replaces.insert(id, newId);
 				id = newId;
-				*(mtpMsgId*)(j.value()->data() + 4) = id;
+				*(mtpMsgId*)(j->second->data() + 4) = id;
 			}
-			setSeqNumbers.insert(id, j.value());
+			setSeqNumbers.insert_or_assign(id, j->second);
 		}
 	}
 
@@ -589,34 +830,34 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 	sessionData->setSession(session);
 
 	for (auto i = setSeqNumbers.cbegin(), e = setSeqNumbers.cend(); i != e; ++i) { // generate new seq_numbers
-		bool wasNeedAck = (*(i.value()->data() + 6) & 1);
-		*(i.value()->data() + 6) = sessionData->nextRequestSeqNumber(wasNeedAck);
+		bool wasNeedAck = (*(i->second->data() + 6) & 1);
+		*(i->second->data() + 6) = sessionData->nextRequestSeqNumber(wasNeedAck);
 	}
 	if (!replaces.isEmpty()) {
 		for (auto i = replaces.cbegin(), e = replaces.cend(); i != e; ++i) { // replace msgIds keys in all data structs
 			const auto j = haveSent.find(i.key());
 			if (j != haveSent.cend()) {
-				const auto req = j.value();
+				const auto req = j->second;
 				haveSent.erase(j);
-				haveSent.insert(i.value(), req);
+				haveSent.insert_or_assign(i.value(), req);
 			}
 			const auto k = toResend.find(i.key());
 			if (k != toResend.cend()) {
-				const auto req = k.value();
+				const auto req = k->second;
 				toResend.erase(k);
-				toResend.insert(i.value(), req);
+				toResend.insert_or_assign(i.value(), req);
 			}
 			const auto l = wereAcked.find(i.key());
 			if (l != wereAcked.cend()) {
-				const auto req = l.value();
+				const auto req = l->second;
 				wereAcked.erase(l);
-				wereAcked.insert(i.value(), req);
+				wereAcked.insert_or_assign(i.value(), req);
 			}
 		}
 		for (auto i = haveSent.cbegin(), e = haveSent.cend(); i != e; ++i) { // replace msgIds in saved containers
-			if (i.value().isSentContainer()) {
-				mtpMsgId *ids = (mtpMsgId*)(i.value()->data() + 8);
-				for (uint32 j = 0, l = (i.value()->size() - 8) >> 1; j < l; ++j) {
+			if (i->second.isSentContainer()) {
+				mtpMsgId *ids = (mtpMsgId*)(i->second->data() + 8);
+				for (uint32 j = 0, l = (i->second->size() - 8) >> 1; j < l; ++j) {
 					const auto k = replaces.constFind(ids[j]);
 					if (k != replaces.cend()) {
 						ids[j] = k.value();
@@ -667,7 +908,7 @@ mtpMsgId ConnectionPrivate::replaceMsgId(SecureRequest &request, mtpMsgId newId)
 			auto &haveSent = sessionData->haveSentMap();
 
 			while (true) {
-				if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+				if (toResend.find(newId) == toResend.cend() && wereAcked.find(newId) == wereAcked.cend() && haveSent.find(newId) == haveSent.cend()) {
 					break;
 				}
 				const auto m = base::unixtime::mtproto_msg_id();
@@ -678,27 +919,27 @@ mtpMsgId ConnectionPrivate::replaceMsgId(SecureRequest &request, mtpMsgId newId)
 
 			const auto i = toResend.find(oldMsgId);
 			if (i != toResend.cend()) {
-				const auto req = i.value();
+				const auto req = i->second;
 				toResend.erase(i);
-				toResend.insert(newId, req);
+				toResend.insert_or_assign(newId, req);
 			}
 
 			const auto j = wereAcked.find(oldMsgId);
 			if (j != wereAcked.cend()) {
-				const auto req = j.value();
+				const auto req = j->second;
 				wereAcked.erase(j);
-				wereAcked.insert(newId, req);
+				wereAcked.insert_or_assign(newId, req);
 			}
 
 			const auto k = haveSent.find(oldMsgId);
 			if (k != haveSent.cend()) {
-				const auto req = k.value();
+				const auto req = k->second;
 				haveSent.erase(k);
-				haveSent.insert(newId, req);
+				haveSent.insert_or_assign(newId, req);
 			}
 
 			for (auto l = haveSent.begin(); l != haveSent.cend(); ++l) {
-				const auto req = l.value();
+				const auto req = l->second;
 				if (req.isSentContainer()) {
 					const auto ids = (mtpMsgId *)(req->data() + 8);
 					for (uint32 i = 0, l = (req->size() - 8) >> 1; i < l; ++i) {
@@ -734,6 +975,7 @@ mtpMsgId ConnectionPrivate::placeToContainer(SecureRequest &toSendRequest, mtpMs
 }
 
 void ConnectionPrivate::tryToSend() {
+	TRACE_ZONE("MTP::ConnectionPrivate::tryToSend");
 	QReadLocker lockFinished(&sessionDataMutex);
 	if (!sessionData || !_connection) {
 		return;
@@ -872,6 +1114,7 @@ void ConnectionPrivate::tryToSend() {
 	}
 
 	bool needAnyResponse = false;
+	auto hasDeferred = false;
 	SecureRequest toSendRequest;
 	{
 		QWriteLocker locker1(sessionData->toSendMutex());
@@ -880,6 +1123,9 @@ void ConnectionPrivate::tryToSend() {
 		auto &toSend = prependOnly ? toSendDummy : sessionData->toSendMap();
 		if (prependOnly) locker1.unlock();
 
+		auto deferred = TakeDeferredRequests(toSend);
+		hasDeferred = !deferred.empty();
+
 		uint32 toSendCount = toSend.size();
 		if (pingRequest) ++toSendCount;
 		if (ackRequest) ++toSendCount;
@@ -889,11 +1135,11 @@ void ConnectionPrivate::tryToSend() {
 
 		if (!toSendCount) return; // nothing to send
 
-		auto first = pingRequest ? pingRequest : (ackRequest ? ackRequest : (resendRequest ? resendRequest : (stateRequest ? stateRequest : (httpWaitRequest ? httpWaitRequest : toSend.cbegin().value()))));
+		auto first = pingRequest ? pingRequest : (ackRequest ? ackRequest : (resendRequest ? resendRequest : (stateRequest ? stateRequest : (httpWaitRequest ? httpWaitRequest : toSend.cbegin()->second))));
 		if (toSendCount == 1 && first->msDate > 0) { // if can send without container
 			toSendRequest = first;
 			if (!prependOnly) {
-				toSend.clear();
+				toSend = std::move(deferred);
 				locker1.unlock();
 			}
 
@@ -913,7 +1159,7 @@ void ConnectionPrivate::tryToSend() {
 
 					QWriteLocker locker2(sessionData->haveSentMutex());
 					auto &haveSent = sessionData->haveSentMap();
-					haveSent.insert(msgId, toSendRequest);
+					haveSent.insert_or_assign(msgId, toSendRequest);
 
 					if (needsLayer && !toSendRequest->needsLayer) needsLayer = false;
 					if (toSendRequest->after) {
@@ -942,7 +1188,7 @@ void ConnectionPrivate::tryToSend() {
 					needAnyResponse = true;
 				} else {
 					QWriteLocker locker3(sessionData->wereAckedMutex());
-					sessionData->wereAckedMap().insert(msgId, toSendRequest->requestId);
+					sessionData->wereAckedMap().insert_or_assign(msgId, toSendRequest->requestId);
 				}
 			}
 		} else { // send in container
@@ -954,8 +1200,8 @@ void ConnectionPrivate::tryToSend() {
 			if (stateRequest) containerSize += stateRequest.messageSize();
 			if (httpWaitRequest) containerSize += httpWaitRequest.messageSize();
 			for (auto i = toSend.begin(), e = toSend.end(); i != e; ++i) {
-				containerSize += i.value().messageSize();
-				if (needsLayer && i.value()->needsLayer) {
+				containerSize += i->second.messageSize();
+				if (needsLayer && i->second->needsLayer) {
 					containerSize += initSizeInInts;
 					willNeedInit = true;
 				}
@@ -973,6 +1219,8 @@ void ConnectionPrivate::tryToSend() {
 				containerSize + 3 * toSend.size());
 			toSendRequest->push_back(mtpc_msg_container);
 			toSendRequest->push_back(toSendCount);
+			++_containersCount;
+			_containerMessagesCount += toSendCount;
 
 			// check for a valid container
 			auto bigMsgId = base::unixtime::mtproto_msg_id();
@@ -998,7 +1246,7 @@ void ConnectionPrivate::tryToSend() {
 				needAnyResponse = true;
 			}
 			for (auto i = toSend.begin(), e = toSend.end(); i != e; ++i) {
-				auto &req = i.value();
+				auto &req = i->second;
 				auto msgId = prepareToSend(req, bigMsgId);
 				if (msgId > bigMsgId) {
 					msgId = replaceMsgId(req, bigMsgId);
@@ -1027,11 +1275,11 @@ void ConnectionPrivate::tryToSend() {
 							*(toSendRequest->data() + reqNeedsLayer + 3) += initSize;
 							added = true;
 						}
-						haveSent.insert(msgId, req);
+						haveSent.insert_or_assign(msgId, req);
 
 						needAnyResponse = true;
 					} else {
-						wereAcked.insert(msgId, req->requestId);
+						wereAcked.insert_or_assign(msgId, req->requestId);
 					}
 				}
 				if (!added) {
@@ -1043,7 +1291,7 @@ void ConnectionPrivate::tryToSend() {
 			if (stateRequest) {
 				mtpMsgId msgId = placeToContainer(toSendRequest, bigMsgId, haveSentArr, stateRequest);
 				stateRequest->msDate = 0; // 0 for state request, do not request state of it
-				haveSent.insert(msgId, stateRequest);
+				haveSent.insert_or_assign(msgId, stateRequest);
 			}
 			if (resendRequest) placeToContainer(toSendRequest, bigMsgId, haveSentArr, resendRequest);
 			if (ackRequest) placeToContainer(toSendRequest, bigMsgId, haveSentArr, ackRequest);
@@ -1052,14 +1300,18 @@ void ConnectionPrivate::tryToSend() {
 			mtpMsgId contMsgId = prepareToSend(toSendRequest, bigMsgId);
 			*(mtpMsgId*)(haveSentIdsWrap->data() + 4) = contMsgId;
 			(*haveSentIdsWrap)[6] = 0; // for container, msDate = 0, seqNo = 0
-			haveSent.insert(contMsgId, haveSentIdsWrap);
-			toSend.clear();
+			haveSent.insert_or_assign(contMsgId, haveSentIdsWrap);
+			toSend = std::move(deferred);
 		}
 	}
 	sendSecureRequest(
 		std::move(toSendRequest),
 		needAnyResponse,
 		lockFinished);
+	if (hasDeferred) {
+		// Newer interactive requests will be placed before the deferred.
+		InvokeQueued(this, [=] { tryToSend(); });
+	}
 }
 
 void ConnectionPrivate::retryByTimer() {
@@ -1129,7 +1381,7 @@ void ConnectionPrivate::connectToServer(bool afterConfig) {
 	destroyAllConnections();
 	if (_connectionOptions->proxy.type == ProxyData::Type::Mtproto) {
 		// host, port, secret for mtproto proxy are taken from proxy.
-		appendTestConnection(DcOptions::Variants::Tcp, {}, 0, {});
+		appendTestConnection(DcOptions::Variants::Tcp, {}, 0, {}, 0);
 	} else {
 		using Variants = DcOptions::Variants;
 		const auto special = (_dcType == DcType::Temporary);
@@ -1160,14 +1412,26 @@ void ConnectionPrivate::connectToServer(bool afterConfig) {
 					continue;
 				}
 				for (const auto &endpoint : variants.data[address][protocol]) {
-					appendTestConnection(
-						static_cast<Variants::Protocol>(protocol),
-						QString::fromStdString(endpoint.ip),
-						endpoint.port,
-						endpoint.secret);
+					auto pending = PendingTestConnection();
+					pending.protocol = static_cast<Variants::Protocol>(
+						protocol);
+					pending.ip = QString::fromStdString(endpoint.ip);
+					pending.port = endpoint.port;
+					pending.protocolSecret = endpoint.secret;
+					pending.priority = testConnectionPriority(
+						pending.protocol,
+						pending.ip,
+						pending.port,
+						pending.protocolSecret);
+					_pendingTestConnections.push_back(std::move(pending));
 				}
 			}
 		}
+		ranges::stable_sort(
+			_pendingTestConnections,
+			std::greater<>(),
+			&PendingTestConnection::priority);
+		startNextTestConnection();
 	}
 	if (_testConnections.empty()) {
 		if (_instance->isKeysDestroyer()) {
@@ -1247,6 +1511,8 @@ void ConnectionPrivate::restart() {
 }
 
 void ConnectionPrivate::onSentSome(uint64 size) {
+	_bytesSent += size;
+	countTraffic();
 	if (!_waitForReceivedTimer.isActive()) {
 		auto remain = static_cast<uint64>(_waitForReceived);
 		if (!_oldConnection) {
@@ -1285,6 +1551,44 @@ void ConnectionPrivate::onReceivedSome() {
 	}
 }
 
+void ConnectionPrivate::countTraffic() {
+	if (!_telemetryTimer.isActive()) {
+		_telemetryPeriodStart = crl::now();
+		_telemetryTimer.callOnce(kTelemetryPeriod);
+	}
+}
+
+void ConnectionPrivate::sendTelemetry() {
+	QReadLocker lockFinished(&sessionDataMutex);
+	if (!sessionData) {
+		return;
+	}
+	const auto duration = std::max(
+		crl::now() - _telemetryPeriodStart,
+		crl::time(1));
+	auto telemetry = ConnectionTelemetry();
+	telemetry.shiftedDcId = _shiftedDcId;
+	telemetry.rtt = _rtt;
+	telemetry.bytesSentPerSecond = base::take(_bytesSent) * 1000 / duration;
+	telemetry.bytesReceivedPerSecond = base::take(_bytesReceived)
+		* 1000
+		/ duration;
+	telemetry.resendsCount = base::take(_resendsCount);
+	telemetry.containersCount = base::take(_containersCount);
+	telemetry.containerMessagesCount = base::take(_containerMessagesCount);
+	{
+		QWriteLocker locker(sessionData->toSendMutex());
+		telemetry.toSendCount = sessionData->toSendMap().size();
+	}
+	{
+		QReadLocker locker(sessionData->haveSentMutex());
+		telemetry.haveSentCount = sessionData->haveSentMap().size();
+	}
+	InvokeQueued(_instance, [instance = _instance, telemetry] {
+		instance->telemetryReceived(telemetry);
+	});
+}
+
 void ConnectionPrivate::markConnectionOld() {
 	_oldConnection = true;
 	_waitForReceived = kMinReceiveTimeout;
@@ -1340,6 +1644,16 @@ void ConnectionPrivate::waitReceivedFailed() {
 }
 
 void ConnectionPrivate::waitConnectedFailed() {
+	if (!_pendingTestConnections.empty()) {
+		DEBUG_LOG(("MTP Info: can't connect in %1ms, "
+			"starting all test connections").arg(_waitForConnected));
+		while (!_pendingTestConnections.empty()) {
+			startNextTestConnection();
+		}
+		_startNextTestTimer.cancel();
+		_waitForConnectedTimer.callOnce(_waitForConnected);
+		return;
+	}
 	DEBUG_LOG(("MTP Info: can't connect in %1ms").arg(_waitForConnected));
 	auto maxTimeout = kMaxConnectedTimeout;
 	for (const auto &connection : _testConnections) {
@@ -1362,6 +1676,13 @@ void ConnectionPrivate::waitBetterFailed() {
 
 void ConnectionPrivate::connectingTimedOut() {
 	for (const auto &connection : _testConnections) {
+		if (!connection.ip.isEmpty()) {
+			_instance->dcOptions()->endpointFailed(
+				BareDcId(_shiftedDcId),
+				connection.protocol,
+				connection.ip.toStdString(),
+				connection.port);
+		}
 		connection.data->timedOut();
 	}
 	doDisconnect();
@@ -1403,10 +1724,12 @@ void ConnectionPrivate::requestCDNConfig() {
 }
 
 void ConnectionPrivate::handleReceived() {
+	TRACE_ZONE("MTP::ConnectionPrivate::handleReceived");
 	QReadLocker lockFinished(&sessionDataMutex);
 	if (!sessionData) return;
 
 	onReceivedSome();
+	countTraffic();
 
 	auto restartOnError = [this, &lockFinished] {
 		lockFinished.unlock();
@@ -1428,16 +1751,50 @@ void ConnectionPrivate::handleReceived() {
 		return restartOnError();
 	}
 
+	constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
+	constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
+	constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
+	constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
+
+	// Decrypt all queued packets in place at once, bad ones are skipped
+	// here and rejected one by one below.
+	auto batch = std::vector<AesIgeBatchItem>();
+	batch.reserve(_connection->received().size());
+	for (auto &buffer : _connection->received()) {
+		const auto intsCount = uint32(buffer.size());
+		if ((intsCount < kMinimalIntsCount)
+			|| (intsCount > kMaxMessageLength / kIntSize)
+			|| (keyId != *(const uint64*)buffer.constData())) {
+			continue;
+		}
+		const auto ints = buffer.data();
+		const auto encryptedInts = ints + kExternalHeaderIntsCount;
+		const auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
+		const auto msgKey = *(MTPint128*)(ints + 2);
+
+		MTPint256 aesKey, aesIV;
+#ifdef TDESKTOP_MTPROTO_OLD
+		key->prepareAES_oldmtp(msgKey, aesKey, aesIV, false);
+#else // TDESKTOP_MTPROTO_OLD
+		key->prepareAES(msgKey, aesKey, aesIV, false);
+#endif // TDESKTOP_MTPROTO_OLD
+
+		auto item = AesIgeBatchItem();
+		item.src = item.dst = encryptedInts;
+		item.len = encryptedIntsCount * kIntSize;
+		memcpy(item.key.data(), &aesKey, item.key.size());
+		memcpy(item.iv.data(), &aesIV, item.iv.size());
+		batch.push_back(item);
+	}
+	aesIgeDecryptBatch(batch);
+
 	while (!_connection->received().empty()) {
 		auto intsBuffer = std::move(_connection->received().front());
+		_bytesReceived += intsBuffer.size() * kIntSize;
 		_connection->received().pop_front();
 
-		constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
-		constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
-		constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
-		constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
 		auto intsCount = uint32(intsBuffer.size());
-		auto ints = intsBuffer.constData();
+		auto ints = intsBuffer.data();
 		if ((intsCount < kMinimalIntsCount) || (intsCount > kMaxMessageLength / kIntSize)) {
 			LOG(("TCP Error: bad message received, len %1").arg(intsCount * kIntSize));
 			TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(ints, intsCount * kIntSize).str()));
@@ -1454,16 +1811,11 @@ void ConnectionPrivate::handleReceived() {
 		auto encryptedInts = ints + kExternalHeaderIntsCount;
 		auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
 		auto encryptedBytesCount = encryptedIntsCount * kIntSize;
-		auto decryptedBuffer = QByteArray(encryptedBytesCount, Qt::Uninitialized);
 		auto msgKey = *(MTPint128*)(ints + 2);
 
-#ifdef TDESKTOP_MTPROTO_OLD
-		aesIgeDecrypt_oldmtp(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, key, msgKey);
-#else // TDESKTOP_MTPROTO_OLD
-		aesIgeDecrypt(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, key, msgKey);
-#endif // TDESKTOP_MTPROTO_OLD
-
-		auto decryptedInts = reinterpret_cast<const mtpPrime*>(decryptedBuffer.constData());
+		// Already decrypted in place, so that a large response can
+		// later be moved out of the received buffer without copying.
+		auto decryptedInts = static_cast<const mtpPrime*>(encryptedInts);
 		auto serverSalt = *(uint64*)&decryptedInts[0];
 		auto session = *(uint64*)&decryptedInts[2];
 		auto msgId = *(uint64*)&decryptedInts[4];
@@ -1585,7 +1937,7 @@ void ConnectionPrivate::handleReceived() {
 			needToHandle = sessionData->receivedIdsSet().registerMsgId(msgId, needAck);
 		}
 		if (needToHandle) {
-			res = handleOneReceived(from, end, msgId, serverTime, serverSalt, badTime);
+			res = handleOneReceived(from, end, msgId, serverTime, serverSalt, badTime, &intsBuffer);
 		}
 		{
 			QWriteLocker lock(sessionData->receivedIdsMutex());
@@ -1636,7 +1988,7 @@ void ConnectionPrivate::handleReceived() {
 	}
 }
 
-ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime) {
+ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime, mtpBuffer *owner) {
 	const auto cons = mtpTypeId(*from);
 
 	switch (cons) {
@@ -1647,7 +1999,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 		if (response.empty()) {
 			return HandleResult::RestartConnection;
 		}
-		return handleOneReceived(response.data(), response.data() + response.size(), msgId, serverTime, serverSalt, badTime);
+		return handleOneReceived(response.data(), response.data() + response.size(), msgId, serverTime, serverSalt, badTime, &response);
 	}
 
 	case mtpc_msg_container: {
@@ -1702,9 +2054,11 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 				QWriteLocker lock(sessionData->receivedIdsMutex());
 				needToHandle = sessionData->receivedIdsSet().registerMsgId(inMsgId.v, needAck);
 			}
+			// Nothing is read after the last message, so it may take the buffer.
+			const auto last = (i + 1 == msgsCount);
 			auto res = HandleResult::Success; // if no need to handle, then succeed
 			if (needToHandle) {
-				res = handleOneReceived(from, otherEnd, inMsgId.v, serverTime, serverSalt, badTime);
+				res = handleOneReceived(from, otherEnd, inMsgId.v, serverTime, serverSalt, badTime, last ? owner : nullptr);
 				badTime = false;
 			}
 			if (res != HandleResult::Success) {
@@ -1766,11 +2120,11 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 						QWriteLocker locker(sessionData->haveSentMutex());
 						auto &haveSent = sessionData->haveSentMap();
 
-						const auto i = haveSent.constFind(resendId);
+						const auto i = haveSent.find(resendId);
 						if (i == haveSent.cend()) {
 							LOG(("Message Error: Container not found!"));
 						} else {
-							request = i.value();
+							request = i->second;
 						}
 					}
 					if (request) {
@@ -1906,7 +2260,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 						state |= 0x02;
 					} else {
 						state |= 0x04;
-						if (wereAcked.constFind(reqMsgId) != wereAckedEnd) {
+						if (wereAcked.find(reqMsgId) != wereAckedEnd) {
 							state |= 0x80; // we know, that server knows, that we received request
 						}
 						if (msgIdState == ReceivedMsgIds::State::NeedsAck) { // need ack, so we sent ack
@@ -1937,7 +2291,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 		{ // find this request in session-shared sent requests map
 			QReadLocker locker(sessionData->haveSentMutex());
 			const auto &haveSent = sessionData->haveSentMap();
-			const auto replyTo = haveSent.constFind(reqMsgId);
+			const auto replyTo = haveSent.find(reqMsgId);
 			if (replyTo == haveSent.cend()) { // do not look in toResend, because we do not resend msgs_state_req requests
 				DEBUG_LOG(("Message Error: such message was not sent recently %1").arg(reqMsgId));
 				return (badTime ? HandleResult::Ignored : HandleResult::Success);
@@ -1950,7 +2304,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 
 				badTime = false;
 			}
-			requestBuffer = replyTo.value();
+			requestBuffer = replyTo->second;
 		}
 		QVector<MTPlong> toAckReq(1, MTP_long(reqMsgId)), toAck;
 		requestsAcked(toAck, true);
@@ -2112,6 +2466,14 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 				return HandleResult::RestartConnection;
 			}
 			typeId = response[0];
+		} else if (owner) {
+			const auto offset = from - owner->constData();
+			const auto size = end - from;
+			Assert(offset >= 0 && offset + size <= owner->size());
+
+			response = base::take(*owner);
+			memmove(response.data(), response.constData() + offset, size * sizeof(mtpPrime));
+			response.resize(size);
 		} else {
 			response.resize(end - from);
 			memcpy(response.data(), from, (end - from) * sizeof(mtpPrime));
@@ -2163,8 +2525,8 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 			const auto &haveSent = sessionData->haveSentMap();
 			toResend.reserve(haveSent.size());
 			for (auto i = haveSent.cbegin(), e = haveSent.cend(); i != e; ++i) {
-				if (i.key() >= firstMsgId) break;
-				if (i.value()->requestId) toResend.push_back(i.key());
+				if (i->first >= firstMsgId) break;
+				if (i->second->requestId) toResend.push_back(i->first);
 			}
 		}
 		resendMany(toResend, 10, true);
@@ -2242,12 +2604,34 @@ mtpBuffer ConnectionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) c
 	mtpBuffer result; // * 4 because of mtpPrime type
 	result.resize(0);
 
-	MTPstring packed;
-	if (!packed.read(from, end)) { // read packed string as serialized mtp string type
+	// Read the packed bytes in place instead of copying them to MTPstring.
+	const auto bytes = reinterpret_cast<const uchar*>(from);
+	const auto bytesEnd = reinterpret_cast<const uchar*>(end);
+	const auto large = (from < end) && (bytes[0] == 254);
+	const auto packedLen = (from >= end)
+		? uint32(0)
+		: large
+		? (uint32(bytes[1]) | (uint32(bytes[2]) << 8) | (uint32(bytes[3]) << 16))
+		: uint32(bytes[0]);
+	const auto packed = bytes + (large ? 4 : 1);
+	if (from >= end || packed + packedLen > bytesEnd) {
 		LOG(("RPC Error: could not read gziped bytes."));
 		return result;
 	}
-	uint32 packedLen = packed.v.size(), unpackedChunk = packedLen, unpackedLen = 0;
+
+	// The gzip trailer has the unpacked size, so usually the first
+	// buffer fits the whole result. Otherwise it grows by doubling.
+	auto unpackedChunk = packedLen;
+	if (packedLen >= 4) {
+		const auto trailer = packed + packedLen - 4;
+		const auto unpackedLen = uint32(trailer[0])
+			| (uint32(trailer[1]) << 8)
+			| (uint32(trailer[2]) << 16)
+			| (uint32(trailer[3]) << 24);
+		if (unpackedLen > 0 && unpackedLen <= uint32(kMaxMessageLength)) {
+			unpackedChunk = (unpackedLen / sizeof(mtpPrime)) + 1;
+		}
+	}
 
 	z_stream stream;
 	stream.zalloc = 0;
@@ -2261,7 +2645,7 @@ mtpBuffer ConnectionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) c
 		return result;
 	}
 	stream.avail_in = packedLen;
-	stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
+	stream.next_in = const_cast<Bytef*>(packed);
 
 	stream.avail_out = 0;
 	while (!stream.avail_out) {
@@ -2272,9 +2656,10 @@ mtpBuffer ConnectionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) c
 		if (res != Z_OK && res != Z_STREAM_END) {
 			inflateEnd(&stream);
 			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
-			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.v.constData(), packedLen).str()));
+			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed, packedLen).str()));
 			return mtpBuffer();
 		}
+		unpackedChunk = result.size();
 	}
 	if (stream.avail_out & 0x03) {
 		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
@@ -2322,23 +2707,27 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 				mtpMsgId msgId = ids[i].v;
 				const auto req = haveSent.find(msgId);
 				if (req != haveSent.cend()) {
-					if (!req.value()->msDate) {
+					if (!req->second->msDate) {
 						DEBUG_LOG(("Message Info: container ack received, msgId %1").arg(ids[i].v));
-						uint32 inContCount = ((*req)->size() - 8) / 2;
-						const mtpMsgId *inContId = (const mtpMsgId *)(req.value()->constData() + 8);
+						uint32 inContCount = (req->second->size() - 8) / 2;
+						const mtpMsgId *inContId = (const mtpMsgId *)(req->second->constData() + 8);
 						toAckMore.reserve(toAckMore.size() + inContCount);
 						for (uint32 j = 0; j < inContCount; ++j) {
 							toAckMore.push_back(MTP_long(*(inContId++)));
 						}
 						haveSent.erase(req);
 					} else {
-						mtpRequestId reqId = req.value()->requestId;
+						if (byResponse) {
+							const auto sample = crl::now() - req->second->msDate;
+							_rtt = _rtt ? ((_rtt * 7 + sample) / 8) : sample;
+						}
+						mtpRequestId reqId = req->second->requestId;
 						bool moveToAcked = byResponse;
 						if (!moveToAcked) { // ignore ACK, if we need a response (if we have a handler)
 							moveToAcked = !_instance->hasCallbacks(reqId);
 						}
 						if (moveToAcked) {
-							wereAcked.insert(msgId, reqId);
+							wereAcked.insert_or_assign(msgId, reqId);
 							haveSent.erase(req);
 						} else {
 							DEBUG_LOG(("Message Info: ignoring ACK for msgId %1 because request %2 requires a response").arg(msgId).arg(reqId));
@@ -2350,7 +2739,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 					auto &toResend = sessionData->toResendMap();
 					const auto reqIt = toResend.find(msgId);
 					if (reqIt != toResend.cend()) {
-						const auto reqId = reqIt.value();
+						const auto reqId = reqIt->second;
 						bool moveToAcked = byResponse;
 						if (!moveToAcked) { // ignore ACK, if we need a response (if we have a handler)
 							moveToAcked = !_instance->hasCallbacks(reqId);
@@ -2360,9 +2749,9 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 							auto &toSend = sessionData->toSendMap();
 							const auto req = toSend.find(reqId);
 							if (req != toSend.cend()) {
-								wereAcked.insert(msgId, req.value()->requestId);
-								if (req.value()->requestId != reqId) {
-									DEBUG_LOG(("Message Error: for msgId %1 found resent request, requestId %2, contains requestId %3").arg(msgId).arg(reqId).arg(req.value()->requestId));
+								wereAcked.insert_or_assign(msgId, req->second->requestId);
+								if (req->second->requestId != reqId) {
+									DEBUG_LOG(("Message Error: for msgId %1 found resent request, requestId %2, contains requestId %3").arg(msgId).arg(reqId).arg(req->second->requestId));
 								} else {
 									DEBUG_LOG(("Message Info: acked msgId %1 that was prepared to resend, requestId %2").arg(msgId).arg(reqId));
 								}
@@ -2385,13 +2774,14 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 		if (ackedCount > kIdsBufferSize) {
 			DEBUG_LOG(("Message Info: removing some old acked sent msgIds %1").arg(ackedCount - kIdsBufferSize));
 			clearedBecauseTooOld.reserve(ackedCount - kIdsBufferSize);
-			while (ackedCount-- > kIdsBufferSize) {
-				auto i = wereAcked.begin();
+			const auto till = wereAcked.begin()
+				+ (ackedCount - kIdsBufferSize);
+			for (auto i = wereAcked.begin(); i != till; ++i) {
 				clearedBecauseTooOld.push_back(RPCCallbackClear(
-					i.value(),
+					i->second,
 					RPCError::TimeoutError));
-				wereAcked.erase(i);
 			}
+			wereAcked.erase(wereAcked.begin(), till);
 		}
 	}
 
@@ -2453,6 +2843,7 @@ void ConnectionPrivate::handleMsgsStates(const QVector<MTPlong> &ids, const QByt
 
 void ConnectionPrivate::resend(quint64 msgId, qint64 msCanWait, bool forceContainer, bool sendMsgStateInfo) {
 	if (msgId == _pingMsgId) return;
+	++_resendsCount;
 	emit resendAsync(msgId, msCanWait, forceContainer, sendMsgStateInfo);
 }
 
@@ -2463,6 +2854,7 @@ void ConnectionPrivate::resendMany(QVector<quint64> msgIds, qint64 msCanWait, bo
 			--l;
 		}
 	}
+	_resendsCount += msgIds.size();
 	emit resendManyAsync(msgIds, msCanWait, forceContainer, sendMsgStateInfo);
 }
 
@@ -2492,18 +2884,18 @@ void ConnectionPrivate::onConnected(
 	const auto j = ranges::find_if(
 		_testConnections,
 		[&](const TestConnection &test) { return test.priority > my; });
-	if (j != end(_testConnections)) {
+	if (j != end(_testConnections)
+		&& my < kPreferredConnectionPriority) {
+		// Not yet started connections are not waited for.
 		DEBUG_LOG(("MTP Info: connection %1 succeed, "
 			"waiting for %2.").arg(i->data->tag()).arg(j->data->tag()));
 		_waitForBetterTimer.callOnce(kWaitForBetterTimeout);
 	} else {
-		DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
+		DEBUG_LOG(("MTP Info: connection %1 succeed, using it."
+			).arg(i->data->tag()));
 		_waitForBetterTimer.cancel();
-		_connection = std::move(i->data);
-		_testConnections.clear();
-
 		lockFinished.unlock();
-		updateAuthKey();
+		acceptTestConnection(std::move(*i));
 	}
 }
 
@@ -2511,9 +2903,12 @@ void ConnectionPrivate::onDisconnected(
 		not_null<AbstractConnection*> connection) {
 	removeTestConnection(connection);
 
-	if (_testConnections.empty()) {
+	if (_testConnections.empty() && _pendingTestConnections.empty()) {
 		destroyAllConnections();
 		restart();
+	} else if (_testConnections.empty()) {
+		_startNextTestTimer.cancel();
+		startNextTestConnection();
 	} else {
 		confirmBestConnection();
 	}
@@ -2537,9 +2932,27 @@ void ConnectionPrivate::confirmBestConnection() {
 	DEBUG_LOG(("MTP Info: can't connect through better, using %1."
 		).arg(i->data->tag()));
 
-	_connection = std::move(i->data);
+	acceptTestConnection(std::move(*i));
+}
+
+void ConnectionPrivate::acceptTestConnection(TestConnection test) {
+	_connection = std::move(test.data);
 	_testConnections.clear();
+	_startNextTestTimer.cancel();
+	_pendingTestConnections.clear();
 
+	if (!test.ip.isEmpty()) {
+		const auto changed = _instance->dcOptions()->endpointConnected(
+			BareDcId(_shiftedDcId),
+			test.protocol,
+			test.ip.toStdString(),
+			test.port);
+		if (changed) {
+			InvokeQueued(_instance, [] {
+				Local::writeSettings();
+			});
+		}
+	}
 	updateAuthKey();
 }
 
@@ -2607,6 +3020,9 @@ void ConnectionPrivate::updateAuthKey() 	{
 	lockFinished.unlock();
 
 	sendNotSecureRequest(MTPReq_pq_multi(nonce));
+
+	// Most likely the server will send the same dh parameters as before.
+	GetDhCache().warmUp();
 }
 
 void ConnectionPrivate::clearMessages() {
@@ -2792,7 +3208,7 @@ void ConnectionPrivate::dhParamsAnswered() {
 		base::unixtime::update(dh_inner_data.vserver_time().v);
 
 		// check that dhPrime and (dhPrime - 1) / 2 are really prime
-		if (!IsPrimeAndGood(bytes::make_span(dh_inner_data.vdh_prime().v), dh_inner_data.vg().v)) {
+		if (!GetDhCache().checkPrime(bytes::make_span(dh_inner_data.vdh_prime().v), dh_inner_data.vg().v)) {
 			LOG(("AuthKey Error: bad dh_prime primality!"));
 			return restart();
 		}
@@ -2837,10 +3253,10 @@ void ConnectionPrivate::dhClientParamsSend() {
 		return restart();
 	}
 
-	// gen rand 'b'
-	auto randomSeed = bytes::vector(ModExpFirst::kRandomPowerSize);
-	bytes::set_random(randomSeed);
-	auto g_b_data = CreateModExp(_authKeyData->g, _authKeyStrings->dh_prime, randomSeed);
+	// gen rand 'b', usually precomputed
+	auto g_b_data = GetDhCache().takeModExp(
+		_authKeyData->g,
+		_authKeyStrings->dh_prime);
 	if (g_b_data.modexp.empty()) {
 		LOG(("AuthKey Error: could not generate good g_b."));
 		return restart();
@@ -3075,10 +3491,25 @@ void ConnectionPrivate::onError(
 			instance->badConfigurationError();
 		});
 	}
+	const auto i = ranges::find(
+		_testConnections,
+		connection.get(),
+		[](const TestConnection &test) { return test.data.get(); });
+	if (i != end(_testConnections) && !i->ip.isEmpty()) {
+		_instance->dcOptions()->endpointFailed(
+			BareDcId(_shiftedDcId),
+			i->protocol,
+			i->ip.toStdString(),
+			i->port);
+	}
 	removeTestConnection(connection);
 
-	if (_testConnections.empty()) {
+	if (_testConnections.empty() && _pendingTestConnections.empty()) {
 		handleError(errorCode);
+	} else if (_testConnections.empty()) {
+		// Don't wait for the stagger when everything started has failed.
+		_startNextTestTimer.cancel();
+		startNextTestConnection();
 	} else {
 		confirmBestConnection();
 	}
@@ -3246,24 +3677,24 @@ mtpRequestId ConnectionPrivate::wasSent(mtpMsgId msgId) const {
 	{
 		QReadLocker locker(sessionData->haveSentMutex());
 		const auto &haveSent = sessionData->haveSentMap();
-		const auto i = haveSent.constFind(msgId);
+		const auto i = haveSent.find(msgId);
 		if (i != haveSent.cend()) {
-			return i.value()->requestId
-				? i.value()->requestId
+			return i->second->requestId
+				? i->second->requestId
 				: mtpRequestId(0xFFFFFFFF);
 		}
 	}
 	{
 		QReadLocker locker(sessionData->toResendMutex());
 		const auto &toResend = sessionData->toResendMap();
-		const auto i = toResend.constFind(msgId);
-		if (i != toResend.cend()) return i.value();
+		const auto i = toResend.find(msgId);
+		if (i != toResend.cend()) return i->second;
 	}
 	{
 		QReadLocker locker(sessionData->wereAckedMutex());
 		const auto &wereAcked = sessionData->wereAckedMap();
-		const auto i = wereAcked.constFind(msgId);
-		if (i != wereAcked.cend()) return i.value();
+		const auto i = wereAcked.find(msgId);
+		if (i != wereAcked.cend()) return i->second;
 	}
 	return 0;
 }
@@ -150,6 +150,16 @@ private:
 	struct TestConnection {
 		ConnectionPointer data;
 		int priority = 0;
+		DcOptions::Variants::Protocol protocol = DcOptions::Variants::Tcp;
+		QString ip;
+		int port = 0;
+	};
+	struct PendingTestConnection {
+		DcOptions::Variants::Protocol protocol = DcOptions::Variants::Tcp;
+		QString ip;
+		int port = 0;
+		bytes::vector protocolSecret;
+		int priority = 0;
 	};
 	void connectToServer(bool afterConfig = false);
 	void connectingTimedOut();
@@ -170,10 +180,14 @@ private:
 	void waitBetterFailed();
 	void markConnectionOld();
 	void sendPingByTimer();
+	void countTraffic();
+	void sendTelemetry();
 
 	void destroyAllConnections();
 	void confirmBestConnection();
+	void acceptTestConnection(TestConnection test);
 	void removeTestConnection(not_null<AbstractConnection*> connection);
+	void startNextTestConnection();
 	int16 getProtocolDcId() const;
 
 	mtpMsgId placeToContainer(
@@ -197,7 +211,9 @@ private:
 		ResetSession,
 		ParseError,
 	};
-	[[nodiscard]] HandleResult handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime);
+	// If owner is passed, the message is the last thing read from it,
+	// so a response can be moved out of it instead of being copied.
+	[[nodiscard]] HandleResult handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime, mtpBuffer *owner = nullptr);
 	mtpBuffer ungzip(const mtpPrime *from, const mtpPrime *end) const;
 	void handleMsgsStates(const QVector<MTPlong> &ids, const QByteArray &states, QVector<MTPlong> &acked);
 
@@ -211,7 +227,13 @@ private:
 		DcOptions::Variants::Protocol protocol,
 		const QString &ip,
 		int port,
-		const bytes::vector &protocolSecret);
+		const bytes::vector &protocolSecret,
+		int priority);
+	[[nodiscard]] int testConnectionPriority(
+		DcOptions::Variants::Protocol protocol,
+		const QString &ip,
+		int port,
+		const bytes::vector &protocolSecret) const;
 
 	// if badTime received - search for ids in sessionData->haveSent and sessionData->wereAcked and sync time/salt, return true if found
 	bool requestsFixTimeSalt(const QVector<MTPlong> &ids, int32 serverTime, uint64 serverSalt);
@@ -241,6 +263,10 @@ private:
 	not_null<Connection*> _owner;
 	ConnectionPointer _connection;
 	std::vector<TestConnection> _testConnections;
+
+	// Sorted by priority, started one by one for racing.
+	std::vector<PendingTestConnection> _pendingTestConnections;
+	base::Timer _startNextTestTimer;
 	crl::time _startedConnectingAt = 0;
 
 	base::Timer _retryTimer; // exp retry timer
@@ -265,6 +291,16 @@ private:
 	mtpMsgId _pingMsgId = 0;
 	base::Timer _pingSender;
 
+	// Accumulated for MTP::ConnectionTelemetry.
+	base::Timer _telemetryTimer;
+	crl::time _telemetryPeriodStart = 0;
+	crl::time _rtt = 0;
+	int64 _bytesSent = 0;
+	int64 _bytesReceived = 0;
+	int _resendsCount = 0;
+	int _containersCount = 0;
+	int _containerMessagesCount = 0;
+
 	bool restarted = false;
 	bool _finished = false;
 
@@ -38,12 +38,9 @@ void HttpConnection::sendData(mtpBuffer &&buffer) {
 
 	int32 requestSize = (buffer.size() - 2) * sizeof(mtpPrime);
 
-	QNetworkRequest request(url());
-	request.setHeader(QNetworkRequest::ContentLengthHeader, QVariant(requestSize));
-	request.setHeader(QNetworkRequest::ContentTypeHeader, QVariant(qsl("application/x-www-form-urlencoded")));
-
+	// QNetworkAccessManager sets the Content-Length from the data.
 	TCP_LOG(("HTTP Info: sending %1 len request").arg(requestSize));
-	_requests.insert(_manager.post(request, QByteArray((const char*)(&buffer[2]), requestSize)));
+	_requests.insert(_manager.post(_request, QByteArray((const char*)(&buffer[2]), requestSize)));
 }
 
 void HttpConnection::disconnectFromServer() {
@@ -68,6 +65,10 @@ void HttpConnection::connectToServer(
 		const bytes::vector &protocolSecret,
 		int16 protocolDcId) {
 	_address = address;
+	_request = QNetworkRequest(url());
+	_request.setHeader(
+		QNetworkRequest::ContentTypeHeader,
+		QVariant(qsl("application/x-www-form-urlencoded")));
 	connect(
 		&_manager,
 		&QNetworkAccessManager::finished,
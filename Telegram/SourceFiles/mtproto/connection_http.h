@@ -55,6 +55,9 @@ private:
 	QNetworkAccessManager _manager;
 	QString _address;
 
+	// Url and headers are the same for all the requests.
+	QNetworkRequest _request;
+
 	QSet<QNetworkReply*> _requests;
 
 	crl::time _pingTime = 0;
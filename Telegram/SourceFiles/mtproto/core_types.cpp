@@ -38,6 +38,116 @@ uint32 CountPaddingAmountInInts(uint32 requestSize, bool extended) {
 
 } // namespace
 
+namespace internal {
+
+struct TypeDataChunk {
+	// The arena holds one reference while it allocates from the chunk.
+	QAtomicInt alive = { 1 };
+	std::size_t used = 0;
+};
+
+namespace {
+
+constexpr auto kTypeDataChunkSize = std::size_t(16 * 1024);
+constexpr auto kTypeDataAlignment = alignof(std::max_align_t);
+
+// Placed before each object, chunk is nullptr for heap objects.
+struct alignas(std::max_align_t) TypeDataHeader {
+	TypeDataChunk *chunk = nullptr;
+};
+
+constexpr auto kTypeDataChunkStart = (sizeof(TypeDataChunk)
+	+ kTypeDataAlignment
+	- 1) / kTypeDataAlignment * kTypeDataAlignment;
+
+thread_local TypeDataArena *CurrentTypeDataArena = nullptr;
+
+constexpr std::size_t AlignedTypeDataSize(std::size_t size) {
+	return (sizeof(TypeDataHeader) + size + kTypeDataAlignment - 1)
+		/ kTypeDataAlignment
+		* kTypeDataAlignment;
+}
+
+void ReleaseTypeDataChunk(TypeDataChunk *chunk) {
+	if (!chunk->alive.deref()) {
+		chunk->~TypeDataChunk();
+		::operator delete(chunk);
+	}
+}
+
+} // namespace
+
+TypeDataArena::TypeDataArena() : _previous(CurrentTypeDataArena) {
+	CurrentTypeDataArena = this;
+}
+
+TypeDataArena::~TypeDataArena() {
+	Expects(CurrentTypeDataArena == this);
+
+	releaseChunk();
+	CurrentTypeDataArena = _previous;
+}
+
+TypeDataArena *TypeDataArena::Current() {
+	return CurrentTypeDataArena;
+}
+
+void *TypeDataArena::allocate(std::size_t size) {
+	const auto full = AlignedTypeDataSize(size);
+	if (full > (kTypeDataChunkSize - kTypeDataChunkStart) / 4) {
+		return nullptr;
+	} else if (!_chunk
+		|| kTypeDataChunkStart + _chunk->used + full > kTypeDataChunkSize) {
+		releaseChunk();
+		_chunk = new (::operator new(kTypeDataChunkSize)) TypeDataChunk();
+	}
+	const auto address = reinterpret_cast<char*>(_chunk)
+		+ kTypeDataChunkStart
+		+ _chunk->used;
+	_chunk->used += full;
+	_chunk->alive.ref();
+	const auto header = new (address) TypeDataHeader{ _chunk };
+	return header + 1;
+}
+
+void TypeDataArena::releaseChunk() {
+	if (_chunk) {
+		ReleaseTypeDataChunk(base::take(_chunk));
+	}
+}
+
+void *TypeData::operator new(std::size_t size) {
+	return operator new(size, nullptr);
+}
+
+void *TypeData::operator new(std::size_t size, TypeDataArena *arena) {
+	if (arena) {
+		if (const auto result = arena->allocate(size)) {
+			return result;
+		}
+	}
+	const auto address = ::operator new(AlignedTypeDataSize(size));
+	return new (address) TypeDataHeader() + 1;
+}
+
+void TypeData::operator delete(void *data) {
+	if (!data) {
+		return;
+	}
+	const auto header = static_cast<TypeDataHeader*>(data) - 1;
+	if (const auto chunk = header->chunk) {
+		ReleaseTypeDataChunk(chunk);
+	} else {
+		::operator delete(header);
+	}
+}
+
+void TypeData::operator delete(void *data, TypeDataArena *arena) {
+	operator delete(data);
+}
+
+} // namespace internal
+
 SecureRequest::SecureRequest(const details::SecureRequestCreateTag &tag)
 : _data(std::make_shared<SecureRequestData>(tag)) {
 }
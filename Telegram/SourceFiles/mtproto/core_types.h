@@ -62,6 +62,30 @@ constexpr int GetDcIdShift(ShiftedDcId shiftedDcId) {
 namespace MTP {
 namespace internal {
 
+struct TypeDataChunk;
+
+// While alive, the data read by generated types on this thread is
+// bump-allocated in chunks, each freed when its last object is freed.
+class TypeDataArena final {
+public:
+	TypeDataArena();
+	TypeDataArena(const TypeDataArena &other) = delete;
+	TypeDataArena &operator=(const TypeDataArena &other) = delete;
+	~TypeDataArena();
+
+	[[nodiscard]] static TypeDataArena *Current();
+
+	// Returns nullptr if the size is too large for a chunk.
+	[[nodiscard]] void *allocate(std::size_t size);
+
+private:
+	void releaseChunk();
+
+	TypeDataArena *_previous = nullptr;
+	TypeDataChunk *_chunk = nullptr;
+
+};
+
 class TypeData {
 public:
 	TypeData() = default;
@@ -73,6 +97,14 @@ public:
 	virtual ~TypeData() {
 	}
 
+	static void *operator new(std::size_t size);
+
+	// Allocates on the heap if arena is nullptr.
+	static void *operator new(std::size_t size, TypeDataArena *arena);
+
+	static void operator delete(void *data);
+	static void operator delete(void *data, TypeDataArena *arena);
+
 private:
 	void incrementCounter() const {
 		_counter.ref();
@@ -269,6 +301,15 @@ struct is_boxed<MTPBoxed<T>> : std::true_type {
 template <typename T>
 constexpr bool is_boxed_v = is_boxed<T>::value;
 
+// Containers are filled by priority, with background and bulk requests
+// limited in size so that they don't delay the interactive ones.
+enum class RequestPriority : uchar {
+	Interactive,
+	Normal,
+	Background,
+	Bulk,
+};
+
 class SecureRequestData;
 class SecureRequest {
 public:
@@ -330,6 +371,7 @@ public:
 
 	mtpRequestId requestId = 0;
 	SecureRequest after;
+	RequestPriority priority = RequestPriority::Normal;
 	bool needsLayer = false;
 
 };
@@ -769,6 +811,10 @@ public:
 
 	uint32 innerLength() const {
 		auto result = uint32(sizeof(uint32));
+		if constexpr (kFixedItemPrimes > 0) {
+			return result
+				+ uint32(v.size() * kFixedItemPrimes * sizeof(mtpPrime));
+		}
 		for (const auto &item : v) {
 			result += item.innerLength();
 		}
@@ -793,6 +839,22 @@ public:
 		return true;
 	}
 	void write(mtpBuffer &to) const {
+		if constexpr (kFixedItemPrimes > 0) {
+			// Id vectors are written without growing the buffer per item.
+			const auto was = to.size();
+			to.resize(was + 1 + v.size() * kFixedItemPrimes);
+			auto data = to.data() + was;
+			*data++ = v.size();
+			for (const auto &item : v) {
+				if constexpr (std::is_same_v<T, MTPint>) {
+					*data++ = (mtpPrime)item.v;
+				} else {
+					*data++ = (mtpPrime)(item.v & 0xFFFFFFFFL);
+					*data++ = (mtpPrime)(item.v >> 32);
+				}
+			}
+			return;
+		}
 		to.push_back(v.size());
 		for (const auto &item : v) {
 			item.write(to);
@@ -802,6 +864,12 @@ public:
 	QVector<T> v;
 
 private:
+	static constexpr auto kFixedItemPrimes = std::is_same_v<T, MTPint>
+		? 1
+		: std::is_same_v<T, MTPlong>
+		? 2
+		: 0;
+
 	explicit MTPvector(QVector<T> &&data) : v(std::move(data)) {
 	}
 
@@ -840,6 +908,32 @@ inline MTPvector<T> MTP_vector() {
 template <typename T>
 using MTPVector = MTPBoxed<MTPvector<T>>;
 
+namespace MTP {
+
+// Reads a boxed Vector<T> passing each element to the callback as soon as
+// it is read, without keeping the whole vector in memory.
+template <typename T, typename Callback>
+[[nodiscard]] bool ReadVectorElements(
+		const mtpPrime *&from,
+		const mtpPrime *end,
+		Callback &&callback) {
+	if (from + 2 > end || mtpTypeId(*from) != mtpc_vector) {
+		return false;
+	}
+	++from;
+	const auto count = static_cast<uint32>(*(from++));
+	for (auto i = uint32(0); i != count; ++i) {
+		auto item = T();
+		if (!item.read(from, end)) {
+			return false;
+		}
+		callback(std::move(item));
+	}
+	return true;
+}
+
+} // namespace MTP
+
 template <typename T>
 inline bool operator==(const MTPvector<T> &a, const MTPvector<T> &b) {
 	return a.c_vector().v == b.c_vector().v;
@@ -382,7 +382,24 @@ QByteArray DcOptions::serialize() const {
 		}
 	}
 
-	constexpr auto kVersion = 1;
+	// Preferred endpoints.
+	auto preferred = std::vector<EndpointKey>();
+	{
+		QMutexLocker locker(&_endpointHistoryMutex);
+		for (const auto &[dcId, key] : _preferredEndpoints) {
+			if (isTemporaryDcId(dcId)) {
+				continue;
+			}
+			preferred.push_back(key);
+
+			// dcId + protocol + port
+			size += sizeof(qint32) + sizeof(qint32) + sizeof(qint32);
+			size += sizeof(qint32) + std::get<2>(key).size();
+		}
+	}
+	size += sizeof(qint32);
+
+	constexpr auto kVersion = 2;
 
 	auto result = QByteArray();
 	result.reserve(size);
@@ -417,6 +434,16 @@ QByteArray DcOptions::serialize() const {
 				<< Serialize::bytes(key.n)
 				<< Serialize::bytes(key.e);
 		}
+
+		// Preferred endpoints.
+		stream << qint32(preferred.size());
+		for (const auto &[dcId, protocol, ip, port] : preferred) {
+			stream << qint32(dcId)
+				<< qint32(protocol)
+				<< qint32(port)
+				<< qint32(ip.size());
+			stream.writeRawData(ip.data(), ip.size());
+		}
 	}
 	return result;
 }
@@ -511,6 +538,95 @@ void DcOptions::constructFromSerialized(const QByteArray &serialized) {
 			}
 		}
 	}
+
+	// Read preferred endpoints
+	if (version > 1 && !stream.atEnd()) {
+		auto count = qint32(0);
+		stream >> count;
+		if (stream.status() != QDataStream::Ok) {
+			LOG(("MTP Error: Bad data for preferred endpoints in DcOptions::constructFromSerialized()"));
+			return;
+		}
+
+		QMutexLocker locker(&_endpointHistoryMutex);
+		_preferredEndpoints.clear();
+		for (auto i = 0; i != count; ++i) {
+			qint32 dcId = 0, protocol = 0, port = 0, ipSize = 0;
+			stream >> dcId >> protocol >> port >> ipSize;
+
+			constexpr auto kMaxIpSize = 45;
+			if (ipSize <= 0
+				|| ipSize > kMaxIpSize
+				|| protocol < 0
+				|| protocol >= Variants::ProtocolCount) {
+				LOG(("MTP Error: Bad data inside preferred endpoints in DcOptions::constructFromSerialized()"));
+				return;
+			}
+			auto ip = std::string(ipSize, ' ');
+			stream.readRawData(ip.data(), ipSize);
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("MTP Error: Bad data inside preferred endpoints in DcOptions::constructFromSerialized()"));
+				return;
+			}
+			_preferredEndpoints.emplace(
+				DcId(dcId),
+				EndpointKey(DcId(dcId), protocol, ip, port));
+		}
+	}
+}
+
+bool DcOptions::endpointConnected(
+		DcId dcId,
+		Variants::Protocol protocol,
+		const std::string &ip,
+		int port) {
+	auto key = EndpointKey(dcId, protocol, ip, port);
+
+	QMutexLocker locker(&_endpointHistoryMutex);
+	++_endpointHistory[key].successes;
+	const auto i = _preferredEndpoints.find(dcId);
+	if (i == end(_preferredEndpoints)) {
+		_preferredEndpoints.emplace(dcId, std::move(key));
+		return true;
+	} else if (i->second != key) {
+		i->second = std::move(key);
+		return true;
+	}
+	return false;
+}
+
+void DcOptions::endpointFailed(
+		DcId dcId,
+		Variants::Protocol protocol,
+		const std::string &ip,
+		int port) {
+	const auto key = EndpointKey(dcId, protocol, ip, port);
+
+	QMutexLocker locker(&_endpointHistoryMutex);
+	++_endpointHistory[key].failures;
+}
+
+int DcOptions::endpointRating(
+		DcId dcId,
+		Variants::Protocol protocol,
+		const std::string &ip,
+		int port) const {
+	const auto key = EndpointKey(dcId, protocol, ip, port);
+
+	QMutexLocker locker(&_endpointHistoryMutex);
+	const auto i = _preferredEndpoints.find(dcId);
+	const auto j = _endpointHistory.find(key);
+	const auto history = (j != end(_endpointHistory))
+		? j->second
+		: EndpointHistory();
+	if (i != end(_preferredEndpoints) && i->second == key) {
+		return (history.failures > history.successes) ? 0 : 2;
+	} else if (history.successes > history.failures) {
+		return 1;
+	} else if (history.failures > history.successes) {
+		return -1;
+	}
+	return 0;
 }
 
 DcOptions::Ids DcOptions::configEnumDcIds() const {
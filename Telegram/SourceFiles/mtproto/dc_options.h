@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <string>
 #include <vector>
 #include <map>
+#include <tuple>
 
 namespace MTP {
 
@@ -89,6 +90,26 @@ public:
 	Variants lookup(DcId dcId, DcType type, bool throughProxy) const;
 	DcType dcType(ShiftedDcId shiftedDcId) const;
 
+	// Connection racing results, the last winner is kept over restarts.
+	// Returns true if the winner for this dc has changed.
+	bool endpointConnected(
+		DcId dcId,
+		Variants::Protocol protocol,
+		const std::string &ip,
+		int port);
+	void endpointFailed(
+		DcId dcId,
+		Variants::Protocol protocol,
+		const std::string &ip,
+		int port);
+
+	// 2 for the last winner, 1 for mostly good, -1 for mostly failing.
+	[[nodiscard]] int endpointRating(
+		DcId dcId,
+		Variants::Protocol protocol,
+		const std::string &ip,
+		int port) const;
+
 	void setCDNConfig(const MTPDcdnConfig &config);
 	bool hasCDNKeysForDc(DcId dcId) const;
 	bool getDcRSAKey(DcId dcId, const QVector<MTPlong> &fingerprints, internal::RSAPublicKey *result) const;
@@ -133,6 +154,15 @@ private:
 	std::map<DcId, std::map<uint64, internal::RSAPublicKey>> _cdnPublicKeys;
 	mutable QReadWriteLock _useThroughLockers;
 
+	struct EndpointHistory {
+		int successes = 0;
+		int failures = 0;
+	};
+	using EndpointKey = std::tuple<DcId, int, std::string, int>;
+	std::map<EndpointKey, EndpointHistory> _endpointHistory;
+	std::map<DcId, EndpointKey> _preferredEndpoints;
+	mutable QMutex _endpointHistoryMutex;
+
 	mutable base::Observable<Ids> _changed;
 
 	// True when we have overriden options from a .tdesktop-endpoints file.
@@ -58,13 +58,15 @@ constexpr ShiftedDcId updaterDcId(DcId dcId) {
 	return ShiftDcId(dcId, kUpdaterDcShift);
 }
 
+// Storage::Downloader opens more download sessions per dc when needed.
 constexpr auto kDownloadSessionsCount = 2;
+constexpr auto kDownloadSessionsCountMax = 8;
 constexpr auto kUploadSessionsCount = 2;
 
 namespace internal {
 
 constexpr ShiftedDcId downloadDcId(DcId dcId, int index) {
-	static_assert(kDownloadSessionsCount < kMaxMediaDcCount, "Too large MTPDownloadSessionsCount!");
+	static_assert(kDownloadSessionsCountMax < kMaxMediaDcCount, "Too large MTPDownloadSessionsCount!");
 	return ShiftDcId(dcId, kBaseDownloadDcShift + index);
 };
 
@@ -72,12 +74,12 @@ constexpr ShiftedDcId downloadDcId(DcId dcId, int index) {
 
 // send(req, callbacks, MTP::downloadDcId(dc, index)) - for download shifted dc id
 inline ShiftedDcId downloadDcId(DcId dcId, int index) {
-	Expects(index >= 0 && index < kDownloadSessionsCount);
+	Expects(index >= 0 && index < kDownloadSessionsCountMax);
 	return internal::downloadDcId(dcId, index);
 }
 
 inline constexpr bool isDownloadDcId(ShiftedDcId shiftedDcId) {
-	return (shiftedDcId >= internal::downloadDcId(0, 0)) && (shiftedDcId < internal::downloadDcId(0, kDownloadSessionsCount - 1) + kDcShift);
+	return (shiftedDcId >= internal::downloadDcId(0, 0)) && (shiftedDcId < internal::downloadDcId(0, kDownloadSessionsCountMax - 1) + kDcShift);
 }
 
 inline bool isCdnDc(MTPDdcOption::Flags flags) {
@@ -171,8 +173,9 @@ inline mtpRequestId send(
 		RPCResponseHandler &&callbacks = {},
 		ShiftedDcId dcId = 0,
 		crl::time msCanWait = 0,
-		mtpRequestId after = 0) {
-	return MainInstance()->send(request, std::move(callbacks), dcId, msCanWait, after);
+		mtpRequestId after = 0,
+		RequestPriority priority = RequestPriority::Normal) {
+	return MainInstance()->send(request, std::move(callbacks), dcId, msCanWait, after, priority);
 }
 
 template <typename TRequest>
@@ -182,8 +185,9 @@ inline mtpRequestId send(
 		RPCFailHandlerPtr &&onFail = nullptr,
 		ShiftedDcId dcId = 0,
 		crl::time msCanWait = 0,
-		mtpRequestId after = 0) {
-	return MainInstance()->send(request, std::move(onDone), std::move(onFail), dcId, msCanWait, after);
+		mtpRequestId after = 0,
+		RequestPriority priority = RequestPriority::Normal) {
+	return MainInstance()->send(request, std::move(onDone), std::move(onFail), dcId, msCanWait, after, priority);
 }
 
 inline void sendAnything(ShiftedDcId shiftedDcId = 0, crl::time msCanWait = 0) {
@@ -0,0 +1,253 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/mtp_aes_ige.h"
+
+#include "base/build_config.h"
+
+extern "C" {
+#include <openssl/aes.h>
+} // extern "C"
+
+#ifdef ARCH_CPU_X86_FAMILY
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#ifdef COMPILER_MSVC
+#include <intrin.h>
+#define TDESKTOP_AES_TARGET
+#else // COMPILER_MSVC
+#define TDESKTOP_AES_TARGET __attribute__((target("sse2,aes")))
+#endif // COMPILER_MSVC
+#endif // ARCH_CPU_X86_FAMILY
+
+namespace MTP {
+namespace {
+
+constexpr auto kBlockSize = 16;
+
+#ifdef ARCH_CPU_X86_FAMILY
+
+// Enough interleaved buffers to hide the latency of one aesdec.
+constexpr auto kLanes = 4;
+constexpr auto kRounds = 14;
+
+bool DetectAesInstructions() {
+#ifdef COMPILER_MSVC
+	int info[4] = { 0 };
+	__cpuid(info, 1);
+	return ((info[2] >> 25) & 1) != 0;
+#else // COMPILER_MSVC
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("aes");
+#endif // COMPILER_MSVC
+}
+
+struct Lane {
+	__m128i keys[kRounds + 1];
+	__m128i previousCipher;
+	__m128i previousPlain;
+	const uchar *from = nullptr;
+	uchar *till = nullptr;
+	uint32 blocks = 0;
+};
+
+TDESKTOP_AES_TARGET inline __m128i ExpandFirst(
+		__m128i key,
+		__m128i assist) {
+	assist = _mm_shuffle_epi32(assist, 0xFF);
+	auto shifted = _mm_slli_si128(key, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	return _mm_xor_si128(key, assist);
+}
+
+TDESKTOP_AES_TARGET inline __m128i ExpandSecond(
+		__m128i first,
+		__m128i key) {
+	const auto assist = _mm_shuffle_epi32(
+		_mm_aeskeygenassist_si128(first, 0x00),
+		0xAA);
+	auto shifted = _mm_slli_si128(key, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	return _mm_xor_si128(key, assist);
+}
+
+// The round constant must be an immediate value.
+template <int Rcon>
+TDESKTOP_AES_TARGET inline void ExpandPair(__m128i *keys, int index) {
+	keys[index] = ExpandFirst(
+		keys[index - 2],
+		_mm_aeskeygenassist_si128(keys[index - 1], Rcon));
+	if (index + 1 <= kRounds) {
+		keys[index + 1] = ExpandSecond(keys[index], keys[index - 1]);
+	}
+}
+
+TDESKTOP_AES_TARGET void PrepareDecryptKeys(
+		__m128i *keys,
+		const bytes::array<32> &key) {
+	__m128i encrypt[kRounds + 1];
+	encrypt[0] = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(key.data()));
+	encrypt[1] = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(key.data() + 16));
+	ExpandPair<0x01>(encrypt, 2);
+	ExpandPair<0x02>(encrypt, 4);
+	ExpandPair<0x04>(encrypt, 6);
+	ExpandPair<0x08>(encrypt, 8);
+	ExpandPair<0x10>(encrypt, 10);
+	ExpandPair<0x20>(encrypt, 12);
+	ExpandPair<0x40>(encrypt, 14);
+
+	// Equivalent inverse cipher round keys.
+	keys[0] = encrypt[kRounds];
+	for (auto i = 1; i != kRounds; ++i) {
+		keys[i] = _mm_aesimc_si128(encrypt[kRounds - i]);
+	}
+	keys[kRounds] = encrypt[0];
+}
+
+TDESKTOP_AES_TARGET void PrepareLane(
+		Lane &lane,
+		const AesIgeBatchItem &item) {
+	PrepareDecryptKeys(lane.keys, item.key);
+
+	// OpenSSL IGE layout: previous cipher block, then previous plain.
+	lane.previousCipher = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(item.iv.data()));
+	lane.previousPlain = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(item.iv.data() + 16));
+	lane.from = static_cast<const uchar*>(item.src);
+	lane.till = static_cast<uchar*>(item.dst);
+	lane.blocks = item.len / kBlockSize;
+}
+
+template <int Count>
+TDESKTOP_AES_TARGET void DecryptLanes(Lane *lanes, uint32 blocks) {
+	__m128i cipher[Count];
+	__m128i state[Count];
+	for (auto step = uint32(0); step != blocks; ++step) {
+		for (auto i = 0; i != Count; ++i) {
+			cipher[i] = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(lanes[i].from));
+			state[i] = _mm_xor_si128(
+				_mm_xor_si128(cipher[i], lanes[i].previousPlain),
+				lanes[i].keys[0]);
+		}
+		for (auto round = 1; round != kRounds; ++round) {
+			for (auto i = 0; i != Count; ++i) {
+				state[i] = _mm_aesdec_si128(
+					state[i],
+					lanes[i].keys[round]);
+			}
+		}
+		for (auto i = 0; i != Count; ++i) {
+			state[i] = _mm_xor_si128(
+				_mm_aesdeclast_si128(state[i], lanes[i].keys[kRounds]),
+				lanes[i].previousCipher);
+
+			// The cipher block is already loaded, so dst may be src.
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(lanes[i].till),
+				state[i]);
+			lanes[i].previousCipher = cipher[i];
+			lanes[i].previousPlain = state[i];
+			lanes[i].from += kBlockSize;
+			lanes[i].till += kBlockSize;
+			lanes[i].blocks -= 1;
+		}
+	}
+}
+
+TDESKTOP_AES_TARGET void DecryptInterleaved(
+		gsl::span<const AesIgeBatchItem> items) {
+	auto lanes = std::array<Lane, kLanes>();
+	auto active = 0;
+	auto next = items.begin();
+	while (true) {
+		// Refill finished lanes, keeping the active ones in front.
+		while (active != kLanes && next != items.end()) {
+			if (next->len >= kBlockSize) {
+				PrepareLane(lanes[active++], *next);
+			}
+			++next;
+		}
+		if (!active) {
+			break;
+		}
+		auto blocks = lanes[0].blocks;
+		for (auto i = 1; i != active; ++i) {
+			blocks = std::min(blocks, lanes[i].blocks);
+		}
+		switch (active) {
+		case 4: DecryptLanes<4>(lanes.data(), blocks); break;
+		case 3: DecryptLanes<3>(lanes.data(), blocks); break;
+		case 2: DecryptLanes<2>(lanes.data(), blocks); break;
+		case 1: DecryptLanes<1>(lanes.data(), blocks); break;
+		}
+		for (auto i = 0; i != active;) {
+			if (lanes[i].blocks) {
+				++i;
+			} else if (i != --active) {
+				lanes[i] = lanes[active];
+			}
+		}
+	}
+}
+
+#endif // ARCH_CPU_X86_FAMILY
+
+} // namespace
+
+void aesIgeDecryptBatch(gsl::span<const AesIgeBatchItem> items) {
+#ifdef ARCH_CPU_X86_FAMILY
+	if (aesIgeBatchAccelerated()) {
+		DecryptInterleaved(items);
+		return;
+	}
+#endif // ARCH_CPU_X86_FAMILY
+	details::aesIgeDecryptBatchFallback(items);
+}
+
+bool aesIgeBatchAccelerated() {
+#ifdef ARCH_CPU_X86_FAMILY
+	static const auto result = DetectAesInstructions();
+	return result;
+#else // ARCH_CPU_X86_FAMILY
+	return false;
+#endif // ARCH_CPU_X86_FAMILY
+}
+
+namespace details {
+
+void aesIgeDecryptBatchFallback(gsl::span<const AesIgeBatchItem> items) {
+	for (const auto &item : items) {
+		auto iv = item.iv;
+		AES_KEY aes;
+		AES_set_decrypt_key(
+			reinterpret_cast<const uchar*>(item.key.data()),
+			256,
+			&aes);
+		AES_ige_encrypt(
+			static_cast<const uchar*>(item.src),
+			static_cast<uchar*>(item.dst),
+			item.len,
+			&aes,
+			reinterpret_cast<uchar*>(iv.data()),
+			AES_DECRYPT);
+	}
+}
+
+} // namespace details
+} // namespace MTP
@@ -0,0 +1,35 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+#include "base/bytes.h"
+
+namespace MTP {
+
+struct AesIgeBatchItem {
+	const void *src = nullptr;
+	void *dst = nullptr; // May be equal to src.
+	uint32 len = 0; // Multiple of the block size.
+	bytes::array<32> key = { { gsl::byte() } };
+	bytes::array<32> iv = { { gsl::byte() } };
+};
+
+// IGE chaining is serial inside one buffer, so with AES instructions
+// available several independent buffers are decrypted interleaved.
+void aesIgeDecryptBatch(gsl::span<const AesIgeBatchItem> items);
+
+[[nodiscard]] bool aesIgeBatchAccelerated();
+
+namespace details {
+
+// Always the OpenSSL decryption, one buffer after another.
+void aesIgeDecryptBatchFallback(gsl::span<const AesIgeBatchItem> items);
+
+} // namespace details
+} // namespace MTP
@@ -0,0 +1,103 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "mtproto/mtp_aes_ige.h"
+
+#include <chrono>
+#include <vector>
+
+namespace {
+
+constexpr auto kBuffers = 11;
+constexpr auto kLargeBuffers = 16;
+constexpr auto kLargeSize = 512 * 1024;
+
+bytes::vector Generate(int size, int seed) {
+	auto result = bytes::vector(size);
+	for (auto i = 0; i != size; ++i) {
+		result[i] = bytes::type((i * 31 + seed * 17) % 251);
+	}
+	return result;
+}
+
+template <int Size>
+bytes::array<Size> GenerateArray(int seed) {
+	auto result = bytes::array<Size>();
+	const auto data = Generate(Size, seed);
+	std::copy(begin(data), end(data), begin(result));
+	return result;
+}
+
+std::vector<MTP::AesIgeBatchItem> Prepare(
+		std::vector<bytes::vector> &from,
+		std::vector<bytes::vector> &till) {
+	auto result = std::vector<MTP::AesIgeBatchItem>();
+	for (auto i = 0, count = int(from.size()); i != count; ++i) {
+		auto item = MTP::AesIgeBatchItem();
+		item.src = from[i].data();
+		item.dst = till[i].data();
+		item.len = uint32(from[i].size());
+		item.key = GenerateArray<32>(i);
+		item.iv = GenerateArray<32>(i + 1000);
+		result.push_back(item);
+	}
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("batched aes ige decryption", "[mtp_aes_ige]") {
+	auto encrypted = std::vector<bytes::vector>();
+	for (auto i = 0; i != kBuffers; ++i) {
+		encrypted.push_back(Generate(16 * (1 + (i * 37) % 200), i));
+	}
+	SECTION("matches openssl decryption") {
+		auto expected = encrypted;
+		auto result = encrypted;
+		MTP::details::aesIgeDecryptBatchFallback(
+			Prepare(encrypted, expected));
+		MTP::aesIgeDecryptBatch(Prepare(encrypted, result));
+		REQUIRE(result == expected);
+	}
+	SECTION("decrypts in place") {
+		auto expected = encrypted;
+		auto result = encrypted;
+		MTP::details::aesIgeDecryptBatchFallback(
+			Prepare(encrypted, expected));
+		MTP::aesIgeDecryptBatch(Prepare(result, result));
+		REQUIRE(result == expected);
+	}
+	SECTION("skips empty buffers") {
+		auto empty = std::vector<bytes::vector>(2);
+		auto items = Prepare(empty, empty);
+		MTP::aesIgeDecryptBatch(items);
+		REQUIRE(empty[0].empty());
+	}
+}
+
+TEST_CASE("batched aes ige decryption speed", "[mtp_aes_ige]") {
+	auto buffers = std::vector<bytes::vector>();
+	for (auto i = 0; i != kLargeBuffers; ++i) {
+		buffers.push_back(Generate(kLargeSize, i));
+	}
+	const auto measure = [&](auto &&method) {
+		const auto start = std::chrono::steady_clock::now();
+		method(Prepare(buffers, buffers));
+		return std::chrono::steady_clock::now() - start;
+	};
+	const auto fallback = measure([](auto &&items) {
+		MTP::details::aesIgeDecryptBatchFallback(items);
+	});
+	const auto batch = measure([](auto &&items) {
+		MTP::aesIgeDecryptBatch(items);
+	});
+	if (MTP::aesIgeBatchAccelerated()) {
+		REQUIRE(batch <= fallback);
+	}
+}
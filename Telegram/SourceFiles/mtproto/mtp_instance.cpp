@@ -25,6 +25,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "lang/lang_instance.h"
 #include "lang/lang_cloud_manager.h"
 #include "base/timer.h"
+#include "base/flat_map.h"
 
 namespace MTP {
 namespace {
@@ -32,6 +33,29 @@ namespace {
 constexpr auto kConfigBecomesOldIn = 2 * 60 * crl::time(1000);
 constexpr auto kConfigBecomesOldForBlockedIn = 8 * crl::time(1000);
 
+// Identical in-flight requests of these read-only methods share one query.
+bool IsCoalescableRequest(const SecureRequest &request) {
+	if (request->size() <= SecureRequest::kMessageBodyPosition) {
+		return false;
+	}
+	const auto type = mtpTypeId(
+		request->constData()[SecureRequest::kMessageBodyPosition]);
+	switch (type) {
+	case mtpc_users_getUsers:
+	case mtpc_users_getFullUser:
+	case mtpc_messages_getMessages:
+	case mtpc_channels_getMessages:
+	case mtpc_messages_getChats:
+	case mtpc_channels_getChannels:
+	case mtpc_messages_getFullChat:
+	case mtpc_channels_getFullChannel:
+	case mtpc_messages_getPeerSettings:
+	case mtpc_help_getConfig:
+		return true;
+	}
+	return false;
+}
+
 } // namespace
 
 class Instance::Private : private Sender {
@@ -99,7 +123,23 @@ public:
 		const SecureRequest &request,
 		RPCResponseHandler &&callbacks);
 	SecureRequest getRequest(mtpRequestId requestId);
+	bool coalesceRequest(
+		mtpRequestId requestId,
+		const SecureRequest &request,
+		RPCResponseHandler &callbacks,
+		ShiftedDcId shiftedDcId);
+	bool cancelCoalesced(mtpRequestId requestId);
+	bool hasCoalesced(mtpRequestId requestId);
+	void doneCoalesced(
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end);
+	void failCoalesced(mtpRequestId requestId, const RPCError &error);
+	void forgetCoalesced(mtpRequestId requestId);
 	void clearCallbacksDelayed(std::vector<RPCCallbackClear> &&ids);
+	void telemetryReceived(const ConnectionTelemetry &telemetry);
+	rpl::producer<ConnectionTelemetry> telemetryUpdates() const;
+	std::vector<ConnectionTelemetry> telemetry() const;
 	void execCallback(mtpRequestId requestId, const mtpPrime *from, const mtpPrime *end);
 	bool hasCallbacks(mtpRequestId requestId);
 	void globalCallback(const mtpPrime *from, const mtpPrime *end);
@@ -211,6 +251,18 @@ private:
 	std::map<mtpRequestId, SecureRequest> _requestMap;
 	QReadWriteLock _requestMapLock;
 
+	// Requests waiting for the result of an identical in-flight request.
+	using CoalescedKey = std::pair<ShiftedDcId, QVector<mtpPrime>>;
+	struct CoalescedRequest {
+		CoalescedKey key;
+		std::vector<mtpRequestId> followers;
+		bool canceled = false;
+	};
+	std::map<CoalescedKey, mtpRequestId> _coalescedLeaders;
+	base::flat_map<mtpRequestId, CoalescedRequest> _coalesced;
+	base::flat_map<mtpRequestId, mtpRequestId> _coalescedFollowers;
+	QMutex _coalescedLock;
+
 	std::deque<std::pair<mtpRequestId, crl::time>> _delayedRequests;
 
 	std::map<mtpRequestId, int> _requestsDelays;
@@ -219,6 +271,9 @@ private:
 
 	std::map<DcId, std::vector<mtpRequestId>> _authWaiters;
 
+	base::flat_map<ShiftedDcId, ConnectionTelemetry> _telemetry;
+	rpl::event_stream<ConnectionTelemetry> _telemetryUpdates;
+
 	RPCResponseHandler _globalHandler;
 	Fn<void(ShiftedDcId shiftedDcId, int32 state)> _stateChangedHandler;
 	Fn<void(ShiftedDcId shiftedDcId)> _sessionResetHandler;
@@ -309,6 +364,7 @@ void Instance::Private::applyDomainIps(
 		const QString &host,
 		const QStringList &ips,
 		crl::time expireAt) {
+	auto changed = false;
 	const auto applyToProxy = [&](ProxyData &proxy) {
 		if (!proxy.tryCustomResolve() || proxy.host != host) {
 			return false;
@@ -333,6 +389,7 @@ void Instance::Private::applyDomainIps(
 		for (const auto &ip : copy) {
 			proxy.resolvedIPs.push_back(ip);
 		}
+		changed = true;
 		return true;
 	};
 	for (auto &proxy : Global::RefProxiesList()) {
@@ -344,6 +401,9 @@ void Instance::Private::applyDomainIps(
 			session.second->refreshOptions();
 		}
 	}
+	if (changed) {
+		Local::writeSettings();
+	}
 	emit _instance->proxyDomainResolved(host, ips, expireAt);
 }
 
@@ -365,13 +425,18 @@ void Instance::Private::setGoodProxyDomain(
 		}
 		return true;
 	};
+	auto changed = false;
 	for (auto &proxy : Global::RefProxiesList()) {
-		applyToProxy(proxy);
+		changed = applyToProxy(proxy) || changed;
 	}
 	if (applyToProxy(Global::RefSelectedProxy())
 		&& (Global::ProxySettings() == ProxyData::Settings::Enabled)) {
 		Core::App().refreshGlobalProxy();
 	}
+	if (changed) {
+		// Keep the good address first for the next start.
+		Local::writeSettings();
+	}
 }
 
 void Instance::Private::suggestMainDcId(DcId mainDcId) {
@@ -536,6 +601,9 @@ void Instance::Private::cancel(mtpRequestId requestId) {
 	if (!requestId) return;
 
 	DEBUG_LOG(("MTP Info: Cancel request %1.").arg(requestId));
+	if (cancelCoalesced(requestId)) {
+		return;
+	}
 	const auto shiftedDcId = queryRequestByDc(requestId);
 	auto msgId = mtpMsgId(0);
 	{
@@ -898,6 +966,10 @@ void Instance::Private::sendRequest(
 		crl::time msCanWait,
 		bool needsLayer,
 		mtpRequestId afterRequestId) {
+	if (!afterRequestId
+		&& coalesceRequest(requestId, request, callbacks, shiftedDcId)) {
+		return;
+	}
 	const auto session = getSession(shiftedDcId);
 
 	request->requestId = requestId;
@@ -927,6 +999,7 @@ void Instance::Private::registerRequest(
 void Instance::Private::unregisterRequest(mtpRequestId requestId) {
 	DEBUG_LOG(("MTP Info: unregistering request %1.").arg(requestId));
 
+	forgetCoalesced(requestId);
 	_requestsDelays.erase(requestId);
 
 	{
@@ -954,6 +1027,13 @@ void Instance::Private::storeRequest(
 
 SecureRequest Instance::Private::getRequest(mtpRequestId requestId) {
 	auto result = SecureRequest();
+	{
+		QMutexLocker locker(&_coalescedLock);
+		const auto i = _coalescedFollowers.find(requestId);
+		if (i != end(_coalescedFollowers)) {
+			requestId = i->second;
+		}
+	}
 	{
 		QReadLocker locker(&_requestMapLock);
 		auto it = _requestMap.find(requestId);
@@ -964,6 +1044,174 @@ SecureRequest Instance::Private::getRequest(mtpRequestId requestId) {
 	return result;
 }
 
+bool Instance::Private::coalesceRequest(
+		mtpRequestId requestId,
+		const SecureRequest &request,
+		RPCResponseHandler &callbacks,
+		ShiftedDcId shiftedDcId) {
+	if (!IsCoalescableRequest(request)) {
+		return false;
+	}
+	const auto body = request->constData()
+		+ SecureRequest::kMessageBodyPosition;
+	const auto length = request.innerLength() / sizeof(mtpPrime);
+	auto key = CoalescedKey(
+		shiftedDcId,
+		QVector<mtpPrime>(length));
+	std::copy(body, body + length, key.second.begin());
+
+	QMutexLocker locker(&_coalescedLock);
+	const auto i = _coalescedLeaders.find(key);
+	if (i == end(_coalescedLeaders)) {
+		const auto leader = requestId;
+		_coalescedLeaders.emplace(key, leader);
+		_coalesced.emplace(leader, CoalescedRequest{ std::move(key) });
+		return false;
+	}
+	const auto leader = i->second;
+	DEBUG_LOG(("MTP Info: Request %1 coalesced with request %2."
+		).arg(requestId
+		).arg(leader));
+	_coalesced[leader].followers.push_back(requestId);
+	_coalescedFollowers.emplace(requestId, leader);
+	if (callbacks.onDone || callbacks.onFail) {
+		QMutexLocker locker(&_parserMapLock);
+		_parserMap.emplace(requestId, std::move(callbacks));
+	}
+	return true;
+}
+
+bool Instance::Private::cancelCoalesced(mtpRequestId requestId) {
+	auto cancelLeader = mtpRequestId(0);
+	{
+		QMutexLocker locker(&_coalescedLock);
+		const auto i = _coalescedFollowers.find(requestId);
+		if (i != end(_coalescedFollowers)) {
+			const auto leader = i->second;
+			_coalescedFollowers.erase(i);
+
+			auto &coalesced = _coalesced[leader];
+			coalesced.followers.erase(ranges::remove(
+				coalesced.followers,
+				requestId
+			), end(coalesced.followers));
+			if (coalesced.canceled && coalesced.followers.empty()) {
+				cancelLeader = leader;
+			}
+		} else {
+			const auto j = _coalesced.find(requestId);
+			if (j == end(_coalesced) || j->second.followers.empty()) {
+				return false;
+			}
+
+			// Keep the query running for the requests waiting for it.
+			j->second.canceled = true;
+		}
+	}
+	clearCallbacks(requestId);
+	if (cancelLeader) {
+		cancel(cancelLeader);
+	}
+	return true;
+}
+
+bool Instance::Private::hasCoalesced(mtpRequestId requestId) {
+	QMutexLocker locker(&_coalescedLock);
+	const auto i = _coalesced.find(requestId);
+	return (i != end(_coalesced)) && !i->second.followers.empty();
+}
+
+void Instance::Private::doneCoalesced(
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	auto followers = std::vector<mtpRequestId>();
+	{
+		QMutexLocker locker(&_coalescedLock);
+		const auto i = _coalesced.find(requestId);
+		if (i == _coalesced.end() || i->second.followers.empty()) {
+			return;
+		}
+		followers = base::take(i->second.followers);
+		for (const auto follower : followers) {
+			_coalescedFollowers.remove(follower);
+		}
+	}
+	for (const auto follower : followers) {
+		auto h = RPCResponseHandler();
+		{
+			QMutexLocker locker(&_parserMapLock);
+			auto it = _parserMap.find(follower);
+			if (it == _parserMap.end()) {
+				continue;
+			}
+			h = std::move(it->second);
+			_parserMap.erase(it);
+		}
+		if (h.onDone && !(*h.onDone)(follower, from, end) && h.onFail) {
+			(*h.onFail)(follower, RPCError::Local(
+				"RESPONSE_PARSE_FAILED",
+				"Response parse failed."));
+		}
+	}
+}
+
+void Instance::Private::failCoalesced(
+		mtpRequestId requestId,
+		const RPCError &error) {
+	auto followers = std::vector<mtpRequestId>();
+	{
+		QMutexLocker locker(&_coalescedLock);
+		const auto i = _coalesced.find(requestId);
+		if (i == end(_coalesced) || i->second.followers.empty()) {
+			return;
+		}
+		followers = base::take(i->second.followers);
+		for (const auto follower : followers) {
+			_coalescedFollowers.remove(follower);
+		}
+	}
+	for (const auto follower : followers) {
+		auto h = RPCResponseHandler();
+		{
+			QMutexLocker locker(&_parserMapLock);
+			auto it = _parserMap.find(follower);
+			if (it == _parserMap.end()) {
+				continue;
+			}
+			h = std::move(it->second);
+			_parserMap.erase(it);
+		}
+
+		// The default handling was already done for the shared query.
+		if (h.onFail) {
+			(*h.onFail)(follower, error);
+		}
+	}
+}
+
+void Instance::Private::forgetCoalesced(mtpRequestId requestId) {
+	auto followers = std::vector<mtpRequestId>();
+	{
+		QMutexLocker locker(&_coalescedLock);
+		const auto i = _coalesced.find(requestId);
+		if (i == end(_coalesced)) {
+			return;
+		}
+		_coalescedLeaders.erase(i->second.key);
+		followers = std::move(i->second.followers);
+		for (const auto follower : followers) {
+			_coalescedFollowers.remove(follower);
+		}
+		_coalesced.erase(i);
+	}
+	if (!followers.empty()) {
+		QMutexLocker locker(&_parserMapLock);
+		for (const auto follower : followers) {
+			_parserMap.erase(follower);
+		}
+	}
+}
 
 void Instance::Private::clearCallbacks(mtpRequestId requestId, int32 errorCode) {
 	RPCResponseHandler h;
@@ -978,6 +1226,13 @@ void Instance::Private::clearCallbacks(mtpRequestId requestId, int32 errorCode)
 			_parserMap.erase(it);
 		}
 	}
+	if (errorCode && hasCoalesced(requestId)) {
+		failCoalesced(requestId, RPCError::Local(
+			"CLEAR_CALLBACK",
+			QString("did not handle request %1, error code %2"
+			).arg(requestId
+			).arg(errorCode)));
+	}
 	if (errorCode && found) {
 		LOG(("API Error: callbacks cleared without handling! "
 			"Request: %1, error code: %2"
@@ -1035,6 +1290,25 @@ void Instance::Private::clearCallbacks(
 	}
 }
 
+void Instance::Private::telemetryReceived(
+		const ConnectionTelemetry &telemetry) {
+	_telemetry[telemetry.shiftedDcId] = telemetry;
+	_telemetryUpdates.fire_copy(telemetry);
+}
+
+rpl::producer<ConnectionTelemetry> Instance::Private::telemetryUpdates() const {
+	return _telemetryUpdates.events();
+}
+
+std::vector<ConnectionTelemetry> Instance::Private::telemetry() const {
+	auto result = std::vector<ConnectionTelemetry>();
+	result.reserve(_telemetry.size());
+	for (const auto &[shiftedDcId, telemetry] : _telemetry) {
+		result.push_back(telemetry);
+	}
+	return result;
+}
+
 void Instance::Private::execCallback(
 		mtpRequestId requestId,
 		const mtpPrime *from,
@@ -1050,7 +1324,7 @@ void Instance::Private::execCallback(
 			DEBUG_LOG(("RPC Info: found parser for request %1, trying to parse response...").arg(requestId));
 		}
 	}
-	if (h.onDone || h.onFail) {
+	if (h.onDone || h.onFail || hasCoalesced(requestId)) {
 		const auto handleError = [&](const RPCError &error) {
 			DEBUG_LOG(("RPC Info: "
 				"error received, code %1, type %2, description: %3"
@@ -1058,8 +1332,9 @@ void Instance::Private::execCallback(
 				).arg(error.type()
 				).arg(error.description()));
 			if (rpcErrorOccured(requestId, h, error)) {
+				failCoalesced(requestId, error);
 				unregisterRequest(requestId);
-			} else {
+			} else if (h.onDone || h.onFail) {
 				QMutexLocker locker(&_parserMapLock);
 				_parserMap.emplace(requestId, h);
 			}
@@ -1075,6 +1350,8 @@ void Instance::Private::execCallback(
 				"RESPONSE_PARSE_FAILED",
 				"Error parse failed."));
 		} else {
+			// Most of the response tree is freed right after handling.
+			const auto arena = internal::TypeDataArena();
 			if (h.onDone) {
 				if (!(*h.onDone)(requestId, from, end)) {
 					handleError(RPCError::Local(
@@ -1082,6 +1359,7 @@ void Instance::Private::execCallback(
 						"Response parse failed."));
 				}
 			}
+			doneCoalesced(requestId, from, end);
 			unregisterRequest(requestId);
 		}
 	} else {
@@ -1091,9 +1369,14 @@ void Instance::Private::execCallback(
 }
 
 bool Instance::Private::hasCallbacks(mtpRequestId requestId) {
-	QMutexLocker locker(&_parserMapLock);
-	auto it = _parserMap.find(requestId);
-	return (it != _parserMap.cend());
+	{
+		QMutexLocker locker(&_parserMapLock);
+		auto it = _parserMap.find(requestId);
+		if (it != _parserMap.cend()) {
+			return true;
+		}
+	}
+	return hasCoalesced(requestId);
 }
 
 void Instance::Private::globalCallback(const mtpPrime *from, const mtpPrime *end) {
@@ -1101,6 +1384,7 @@ void Instance::Private::globalCallback(const mtpPrime *from, const mtpPrime *end
 		return;
 	}
 	// Handle updates.
+	const auto arena = internal::TypeDataArena();
 	[[maybe_unused]] bool result = (*_globalHandler.onDone)(0, from, end);
 }
 
@@ -1723,6 +2007,18 @@ void Instance::clearCallbacksDelayed(std::vector<RPCCallbackClear> &&ids) {
 	_private->clearCallbacksDelayed(std::move(ids));
 }
 
+void Instance::telemetryReceived(const ConnectionTelemetry &telemetry) {
+	_private->telemetryReceived(telemetry);
+}
+
+rpl::producer<ConnectionTelemetry> Instance::telemetryUpdates() const {
+	return _private->telemetryUpdates();
+}
+
+std::vector<ConnectionTelemetry> Instance::telemetry() const {
+	return _private->telemetry();
+}
+
 void Instance::execCallback(mtpRequestId requestId, const mtpPrime *from, const mtpPrime *end) {
 	_private->execCallback(requestId, from, end);
 }
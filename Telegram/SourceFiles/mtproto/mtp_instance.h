@@ -23,6 +23,19 @@ class AuthKey;
 using AuthKeyPtr = std::shared_ptr<AuthKey>;
 using AuthKeysList = std::vector<AuthKeyPtr>;
 
+// Sent by each connection about once a second while it has traffic.
+struct ConnectionTelemetry {
+	ShiftedDcId shiftedDcId = 0;
+	crl::time rtt = 0; // Smoothed request -> response time.
+	int64 bytesSentPerSecond = 0;
+	int64 bytesReceivedPerSecond = 0;
+	int resendsCount = 0;
+	int containersCount = 0;
+	int containerMessagesCount = 0;
+	int toSendCount = 0;
+	int haveSentCount = 0;
+};
+
 class Instance : public QObject {
 	Q_OBJECT
 
@@ -72,11 +85,14 @@ public:
 			RPCResponseHandler &&callbacks = {},
 			ShiftedDcId shiftedDcId = 0,
 			crl::time msCanWait = 0,
-			mtpRequestId afterRequestId = 0) {
+			mtpRequestId afterRequestId = 0,
+			RequestPriority priority = RequestPriority::Normal) {
 		const auto requestId = GetNextRequestId();
+		auto serialized = SecureRequest::Serialize(request);
+		serialized->priority = priority;
 		sendSerialized(
 			requestId,
-			SecureRequest::Serialize(request),
+			std::move(serialized),
 			std::move(callbacks),
 			shiftedDcId,
 			msCanWait,
@@ -91,13 +107,15 @@ public:
 			RPCFailHandlerPtr &&onFail = nullptr,
 			ShiftedDcId shiftedDcId = 0,
 			crl::time msCanWait = 0,
-			mtpRequestId afterRequestId = 0) {
+			mtpRequestId afterRequestId = 0,
+			RequestPriority priority = RequestPriority::Normal) {
 		return send(
 			request,
 			RPCResponseHandler(std::move(onDone), std::move(onFail)),
 			shiftedDcId,
 			msCanWait,
-			afterRequestId);
+			afterRequestId,
+			priority);
 	}
 
 	template <typename Request>
@@ -164,6 +182,10 @@ public:
 
 	void clearCallbacksDelayed(std::vector<RPCCallbackClear> &&ids);
 
+	void telemetryReceived(const ConnectionTelemetry &telemetry);
+	[[nodiscard]] rpl::producer<ConnectionTelemetry> telemetryUpdates() const;
+	[[nodiscard]] std::vector<ConnectionTelemetry> telemetry() const;
+
 	void execCallback(mtpRequestId requestId, const mtpPrime *from, const mtpPrime *end);
 	bool hasCallbacks(mtpRequestId requestId);
 	void globalCallback(const mtpPrime *from, const mtpPrime *end);
@@ -0,0 +1,106 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+#include "base/flat_map.h"
+
+#include <vector>
+
+namespace MTP {
+
+// Collects keys requested until the next flush() into one request per
+// group, like message ids per channel for channels.getMessages.
+template <typename Group, typename Key>
+class RequestBatcher final {
+public:
+	using Callback = Fn<void(Group, Key)>;
+
+	// Sends the request for all keys and returns its request id.
+	// The response handlers must call finish() with that request id.
+	using Sender = Fn<mtpRequestId(Group, const std::vector<Key>&)>;
+
+	explicit RequestBatcher(Sender sender) : _sender(std::move(sender)) {
+	}
+
+	// Returns true if the key waits for the next flush().
+	bool add(Group group, Key key, Callback callback = nullptr) {
+		auto &request = _groups[group][key];
+		if (callback) {
+			request.callbacks.push_back(std::move(callback));
+		}
+		return !request.requestId;
+	}
+
+	void flush() {
+		auto keys = std::vector<Key>();
+		for (auto &[group, requests] : _groups) {
+			keys.clear();
+			for (const auto &[key, request] : requests) {
+				if (!request.requestId) {
+					keys.push_back(key);
+				}
+			}
+			if (keys.empty()) {
+				continue;
+			}
+			const auto requestId = _sender(group, keys);
+			for (auto &[key, request] : requests) {
+				if (!request.requestId) {
+					request.requestId = requestId;
+				}
+			}
+		}
+	}
+
+	// Called both when the request is done and when it has failed.
+	void finish(Group group, mtpRequestId requestId) {
+		const auto i = _groups.find(group);
+		if (i == end(_groups)) {
+			return;
+		}
+		auto finished = std::vector<std::pair<Key, std::vector<Callback>>>();
+		auto &requests = i->second;
+		for (auto j = begin(requests); j != end(requests);) {
+			if (j->second.requestId == requestId) {
+				finished.emplace_back(
+					j->first,
+					std::move(j->second.callbacks));
+				j = requests.erase(j);
+			} else {
+				++j;
+			}
+		}
+		if (requests.empty()) {
+			_groups.erase(i);
+		}
+
+		// Callbacks may add new keys, so invoke them after erasing.
+		for (const auto &[key, callbacks] : finished) {
+			for (const auto &callback : callbacks) {
+				callback(group, key);
+			}
+		}
+	}
+
+	[[nodiscard]] bool empty() const {
+		return _groups.empty();
+	}
+
+private:
+	struct Request {
+		mtpRequestId requestId = 0;
+		std::vector<Callback> callbacks;
+	};
+
+	Sender _sender;
+	base::flat_map<Group, base::flat_map<Key, Request>> _groups;
+
+};
+
+} // namespace MTP
@@ -0,0 +1,69 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "mtproto/request_batcher.h"
+
+#include <map>
+
+TEST_CASE("request batcher merges keys per group", "[request_batcher]") {
+	auto sent = std::map<mtpRequestId, std::pair<int, std::vector<int>>>();
+	auto nextRequestId = mtpRequestId(0);
+	auto batcher = MTP::RequestBatcher<int, int>([&](
+			int group,
+			const std::vector<int> &keys) {
+		sent.emplace(++nextRequestId, std::make_pair(group, keys));
+		return nextRequestId;
+	});
+	auto finished = std::vector<std::pair<int, int>>();
+	const auto callback = [&](int group, int key) {
+		finished.emplace_back(group, key);
+	};
+
+	REQUIRE(batcher.add(0, 3, callback));
+	REQUIRE(batcher.add(0, 1, callback));
+	REQUIRE(batcher.add(7, 2, callback));
+	REQUIRE(batcher.add(0, 3, callback));
+	batcher.flush();
+	REQUIRE(sent.size() == 2);
+	REQUIRE(sent[1].first == 0);
+	REQUIRE(sent[1].second == (std::vector<int>{ 1, 3 }));
+	REQUIRE(sent[2].first == 7);
+	REQUIRE(sent[2].second == std::vector<int>{ 2 });
+
+	SECTION("keys in flight are not sent again") {
+		REQUIRE(!batcher.add(0, 1, callback));
+		REQUIRE(batcher.add(0, 4, callback));
+		batcher.flush();
+		REQUIRE(sent.size() == 3);
+		REQUIRE(sent[3].second == std::vector<int>{ 4 });
+	}
+	SECTION("finish calls back every waiting caller") {
+		batcher.finish(0, 1);
+		const auto expected = std::vector<std::pair<int, int>>{
+			{ 0, 1 },
+			{ 0, 3 },
+			{ 0, 3 },
+		};
+		REQUIRE(finished == expected);
+		REQUIRE(!batcher.empty());
+		batcher.finish(7, 2);
+		REQUIRE(finished.size() == 4);
+		REQUIRE(batcher.empty());
+	}
+	SECTION("callbacks may request the same key again") {
+		auto again = false;
+		batcher.add(7, 2, [&](int group, int key) {
+			again = batcher.add(group, key);
+		});
+		batcher.finish(7, 2);
+		REQUIRE(again);
+		batcher.flush();
+		REQUIRE(sent.size() == 3);
+	}
+}
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/variant.h"
+#include "base/weak_ptr.h"
 
 namespace MTP {
 
@@ -74,6 +75,73 @@ class Sender {
 
 		};
 
+		// Reads the response on a background thread, calls the handler
+		// on the main thread if the request was not cancelled meanwhile.
+		template <typename Response, template <typename> typename PolicyTemplate>
+		class DoneAsyncHandler : public RPCAbstractDoneHandler {
+			using Policy = PolicyTemplate<Response>;
+			using Callback = typename Policy::Callback;
+
+		public:
+			DoneAsyncHandler(
+				not_null<Sender*> sender,
+				Callback handler,
+				std::shared_ptr<RPCFailHandlerPtr> fail)
+			: _sender(sender)
+			, _handler(std::move(handler))
+			, _fail(std::move(fail)) {
+			}
+
+			bool operator()(mtpRequestId requestId, const mtpPrime *from, const mtpPrime *end) override {
+				auto buffer = mtpBuffer(end - from);
+				if (end > from) {
+					memcpy(buffer.data(), from, (end - from) * sizeof(mtpPrime));
+				}
+				crl::async([
+					requestId,
+					sender = _sender,
+					handler = std::move(_handler),
+					fail = base::take(*_fail),
+					guard = base::make_weak(&_sender->_guard),
+					buffer = std::move(buffer)
+				]() mutable {
+					const auto arena = internal::TypeDataArena();
+					auto result = Response();
+					auto data = buffer.constData();
+					const auto till = data + buffer.size();
+					const auto parsed = result.read(data, till);
+					buffer = mtpBuffer();
+					crl::on_main(guard, [
+						requestId,
+						sender,
+						parsed,
+						handler = std::move(handler),
+						fail = std::move(fail),
+						result = std::move(result)
+					]() mutable {
+						if (!sender->senderRequestHandled(requestId)) {
+							return;
+						} else if (!parsed) {
+							if (fail) {
+								(*fail)(requestId, RPCError::Local(
+									"RESPONSE_PARSE_FAILED",
+									"Response parse failed."));
+							}
+						} else if (handler) {
+							Policy::handle(std::move(handler), requestId, std::move(result));
+						}
+					});
+				});
+				return true;
+			}
+
+		private:
+			not_null<Sender*> _sender;
+			Callback _handler;
+			std::shared_ptr<RPCFailHandlerPtr> _fail;
+
+		};
+
 		struct FailPlainPolicy {
 			using Callback = FnMut<void(const RPCError &error)>;
 			static void handle(Callback &&handler, mtpRequestId requestId, const RPCError &error) {
@@ -138,6 +206,13 @@ class Sender {
 		}
 		void setDoneHandler(RPCDoneHandlerPtr &&handler) noexcept {
 			_done = std::move(handler);
+			_doneAsyncFail = nullptr;
+		}
+		void setDoneAsyncHandler(
+				RPCDoneHandlerPtr &&handler,
+				std::shared_ptr<RPCFailHandlerPtr> fail) noexcept {
+			_done = std::move(handler);
+			_doneAsyncFail = std::move(fail);
 		}
 		void setFailHandler(FailPlainHandler &&handler) noexcept {
 			_fail = std::move(handler);
@@ -151,6 +226,9 @@ class Sender {
 		void setAfter(mtpRequestId requestId) noexcept {
 			_afterRequestId = requestId;
 		}
+		void setPriority(RequestPriority priority) noexcept {
+			_priority = priority;
+		}
 
 		ShiftedDcId takeDcId() const noexcept {
 			return _dcId;
@@ -162,16 +240,23 @@ class Sender {
 			return std::move(_done);
 		}
 		RPCFailHandlerPtr takeOnFail() {
+			auto result = RPCFailHandlerPtr();
 			if (auto handler = base::get_if<FailPlainHandler>(&_fail)) {
-				return std::make_shared<FailHandler<FailPlainPolicy>>(_sender, std::move(*handler), _failSkipPolicy);
+				result = std::make_shared<FailHandler<FailPlainPolicy>>(_sender, std::move(*handler), _failSkipPolicy);
 			} else if (auto handler = base::get_if<FailRequestIdHandler>(&_fail)) {
-				return std::make_shared<FailHandler<FailRequestIdPolicy>>(_sender, std::move(*handler), _failSkipPolicy);
+				result = std::make_shared<FailHandler<FailRequestIdPolicy>>(_sender, std::move(*handler), _failSkipPolicy);
+			}
+			if (const auto fail = base::take(_doneAsyncFail)) {
+				*fail = result;
 			}
-			return RPCFailHandlerPtr();
+			return result;
 		}
 		mtpRequestId takeAfter() const noexcept {
 			return _afterRequestId;
 		}
+		RequestPriority takePriority() const noexcept {
+			return _priority;
+		}
 
 		not_null<Sender*> sender() const noexcept {
 			return _sender;
@@ -185,9 +270,11 @@ class Sender {
 		ShiftedDcId _dcId = 0;
 		crl::time _canWait = 0;
 		RPCDoneHandlerPtr _done;
+		std::shared_ptr<RPCFailHandlerPtr> _doneAsyncFail;
 		base::variant<FailPlainHandler, FailRequestIdHandler> _fail;
 		FailSkipPolicy _failSkipPolicy = FailSkipPolicy::Simple;
 		mtpRequestId _afterRequestId = 0;
+		RequestPriority _priority = RequestPriority::Normal;
 
 	};
 
@@ -220,6 +307,17 @@ public:
 			setDoneHandler(std::make_shared<DoneHandler<typename Request::ResponseType, DoneRequestIdPolicy>>(sender(), std::move(callback)));
 			return *this;
 		}
+		// For large responses, keeps the parsing out of the main thread.
+		[[nodiscard]] SpecificRequestBuilder &doneAsync(FnMut<void(const typename Request::ResponseType &result)> callback) {
+			auto fail = std::make_shared<RPCFailHandlerPtr>();
+			setDoneAsyncHandler(std::make_shared<DoneAsyncHandler<typename Request::ResponseType, DonePlainPolicy>>(sender(), std::move(callback), fail), fail);
+			return *this;
+		}
+		[[nodiscard]] SpecificRequestBuilder &doneAsync(FnMut<void(const typename Request::ResponseType &result, mtpRequestId requestId)> callback) {
+			auto fail = std::make_shared<RPCFailHandlerPtr>();
+			setDoneAsyncHandler(std::make_shared<DoneAsyncHandler<typename Request::ResponseType, DoneRequestIdPolicy>>(sender(), std::move(callback), fail), fail);
+			return *this;
+		}
 		[[nodiscard]] SpecificRequestBuilder &fail(FnMut<void(const RPCError &error)> callback) noexcept {
 			setFailHandler(std::move(callback));
 			return *this;
@@ -240,6 +338,10 @@ public:
 			setAfter(requestId);
 			return *this;
 		}
+		[[nodiscard]] SpecificRequestBuilder &withPriority(RequestPriority priority) noexcept {
+			setPriority(priority);
+			return *this;
+		}
 
 		mtpRequestId send() {
 			const auto id = MainInstance()->send(
@@ -248,7 +350,8 @@ public:
 				takeOnFail(),
 				takeDcId(),
 				takeCanWait(),
-				takeAfter());
+				takeAfter(),
+				takePriority());
 			registerRequest(id);
 			return id;
 		}
@@ -375,12 +478,14 @@ private:
 	void senderRequestRegister(mtpRequestId requestId) {
 		_requests.emplace(MainInstance(), requestId);
 	}
-	void senderRequestHandled(mtpRequestId requestId) {
+	bool senderRequestHandled(mtpRequestId requestId) {
 		auto it = _requests.find(requestId);
 		if (it != _requests.cend()) {
 			it->handled();
 			_requests.erase(it);
+			return true;
 		}
+		return false;
 	}
 	void senderRequestCancel(mtpRequestId requestId) {
 		auto it = _requests.find(requestId);
@@ -390,6 +495,7 @@ private:
 	}
 
 	base::flat_set<RequestWrap, RequestWrapComparator> _requests;
+	base::has_weak_ptr _guard;
 
 };
 
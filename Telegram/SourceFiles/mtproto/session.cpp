@@ -61,6 +61,28 @@ ConnectionOptions::ConnectionOptions(
 , useTcp(useTcp) {
 }
 
+SendQueue::~SendQueue() {
+	takeAll([](SecureRequest&&) {});
+}
+
+void SendQueue::push(const SecureRequest &request) {
+	const auto node = new Node{ request };
+	node->next = _head.load(std::memory_order_relaxed);
+	while (!_head.compare_exchange_weak(
+		node->next,
+		node,
+		std::memory_order_release,
+		std::memory_order_relaxed)) {
+	}
+}
+
+void SessionData::takeQueuedToSend() const {
+	_toSendQueue.takeAll([&](SecureRequest &&request) {
+		const auto requestId = request->requestId;
+		_toSend.insert_or_assign(requestId, std::move(request));
+	});
+}
+
 void SessionData::setKey(const AuthKeyPtr &key) {
 	if (_authKey != key) {
 		uint64 session = rand_value<uint64>();
@@ -97,19 +119,19 @@ void SessionData::clear(Instance *instance) {
 		auto receivedResponsesEnd = _receivedResponses.cend();
 		clearCallbacks.reserve(_haveSent.size() + _wereAcked.size());
 		for (auto i = _haveSent.cbegin(), e = _haveSent.cend(); i != e; ++i) {
-			auto requestId = i.value()->requestId;
+			auto requestId = i->second->requestId;
 			if (!_receivedResponses.contains(requestId)) {
 				clearCallbacks.push_back(requestId);
 			}
 		}
 		for (auto i = _toResend.cbegin(), e = _toResend.cend(); i != e; ++i) {
-			auto requestId = i.value();
+			auto requestId = i->second;
 			if (!_receivedResponses.contains(requestId)) {
 				clearCallbacks.push_back(requestId);
 			}
 		}
 		for (auto i = _wereAcked.cbegin(), e = _wereAcked.cend(); i != e; ++i) {
-			auto requestId = i.value();
+			auto requestId = i->second;
 			if (!_receivedResponses.contains(requestId)) {
 				clearCallbacks.push_back(requestId);
 			}
@@ -318,22 +340,22 @@ void Session::checkRequestsByTimer() {
 		const auto haveSentCount = haveSent.size();
 		auto ms = crl::now();
 		for (auto i = haveSent.begin(), e = haveSent.end(); i != e; ++i) {
-			auto &req = i.value();
+			auto &req = i->second;
 			if (req->msDate > 0) {
 				if (req->msDate + kCheckResendTimeout < ms) { // need to resend or check state
 					if (req.messageSize() < kResendThreshold) { // resend
 						resendingIds.reserve(haveSentCount);
-						resendingIds.push_back(i.key());
+						resendingIds.push_back(i->first);
 					} else {
 						req->msDate = ms;
 						stateRequestIds.reserve(haveSentCount);
-						stateRequestIds.push_back(i.key());
+						stateRequestIds.push_back(i->first);
 					}
 				}
 			} else if (base::unixtime::now()
-					> int32(i.key() >> 32) + kContainerLives) {
+					> int32(i->first >> 32) + kContainerLives) {
 				removingIds.reserve(haveSentCount);
-				removingIds.push_back(i.key());
+				removingIds.push_back(i->first);
 			}
 		}
 	}
@@ -362,8 +384,8 @@ void Session::checkRequestsByTimer() {
 			for (uint32 i = 0, l = removingIds.size(); i < l; ++i) {
 				auto j = haveSent.find(removingIds[i]);
 				if (j != haveSent.cend()) {
-					if (j.value()->requestId) {
-						clearCallbacks.push_back(j.value()->requestId);
+					if (j->second->requestId) {
+						clearCallbacks.push_back(j->second->requestId);
 					}
 					haveSent.erase(j);
 				}
@@ -422,7 +444,7 @@ int32 Session::requestState(mtpRequestId requestId) const {
 
 	QWriteLocker locker(data.toSendMutex());
 	const auto &toSend = data.toSendMap();
-	const auto i = toSend.constFind(requestId);
+	const auto i = toSend.find(requestId);
 	if (i != toSend.cend()) {
 		return MTP::RequestSending;
 	} else {
@@ -480,7 +502,7 @@ mtpRequestId Session::resend(quint64 msgId, qint64 msCanWait, bool forceContaine
 			return 0;
 		}
 
-		request = i.value();
+		request = i->second;
 		haveSent.erase(i);
 	}
 	if (request.isSentContainer()) { // for container just resend all messages we can
@@ -495,7 +517,7 @@ mtpRequestId Session::resend(quint64 msgId, qint64 msCanWait, bool forceContaine
 		sendPrepared(request, msCanWait, false);
 		{
 			QWriteLocker locker(data.toResendMutex());
-			data.toResendMap().insert(msgId, request->requestId);
+			data.toResendMap().insert_or_assign(msgId, request->requestId);
 		}
 		return request->requestId;
 	} else {
@@ -516,8 +538,8 @@ void Session::resendAll() {
 		const auto &haveSent = data.haveSentMap();
 		toResend.reserve(haveSent.size());
 		for (auto i = haveSent.cbegin(), e = haveSent.cend(); i != e; ++i) {
-			if (i.value()->requestId) {
-				toResend.push_back(i.key());
+			if (i->second->requestId) {
+				toResend.push_back(i->first);
 			}
 		}
 	}
@@ -532,15 +554,11 @@ void Session::sendPrepared(
 		bool newRequest) {
 	DEBUG_LOG(("MTP Info: adding request to toSendMap, msCanWait %1"
 		).arg(msCanWait));
-	{
-		QWriteLocker locker(data.toSendMutex());
-		data.toSendMap().insert(request->requestId, request);
-
-		if (newRequest) {
-			*(mtpMsgId*)(request->data() + 4) = 0;
-			*(request->data() + 6) = 0;
-		}
+	if (newRequest) {
+		*(mtpMsgId*)(request->data() + 4) = 0;
+		*(request->data() + 6) = 0;
 	}
+	data.queueToSend(request);
 
 	DEBUG_LOG(("MTP Info: added, requestId %1").arg(request->requestId));
 
@@ -7,9 +7,12 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
+#include "base/flat_map.h"
 #include "base/timer.h"
 #include "mtproto/rpc_sender.h"
 
+#include <atomic>
+
 namespace MTP {
 
 class Instance;
@@ -24,20 +27,20 @@ constexpr auto kIdsBufferSize = 400;
 class Dcenter;
 class Connection;
 
-using PreRequestMap = QMap<mtpRequestId, SecureRequest>;
-using RequestMap = QMap<mtpMsgId, SecureRequest>;
+// Both msg_ids and request_ids are mostly increasing, so new entries
+// are appended to the end of the flat storage and old ones are acked
+// or resent from its front.
+using PreRequestMap = base::flat_map<mtpRequestId, SecureRequest>;
+using RequestMap = base::flat_map<mtpMsgId, SecureRequest>;
 
-class RequestIdsMap : public QMap<mtpMsgId, mtpRequestId> {
+class RequestIdsMap : public base::flat_map<mtpMsgId, mtpRequestId> {
 public:
-	using ParentType = QMap<mtpMsgId, mtpRequestId>;
-
 	mtpMsgId min() const {
-		return size() ? cbegin().key() : 0;
+		return empty() ? 0 : front().first;
 	}
 
 	mtpMsgId max() const {
-		ParentType::const_iterator e(cend());
-		return size() ? (--e).key() : 0;
+		return empty() ? 0 : back().first;
 	}
 
 };
@@ -96,6 +99,50 @@ private:
 
 };
 
+// Lock-free queue of requests, pushed from any thread. All the queued
+// requests are taken at once, only by one consumer at a time.
+class SendQueue {
+public:
+	SendQueue() = default;
+	SendQueue(const SendQueue &other) = delete;
+	SendQueue &operator=(const SendQueue &other) = delete;
+	~SendQueue();
+
+	void push(const SecureRequest &request);
+
+	template <typename Callback>
+	void takeAll(Callback &&callback);
+
+private:
+	struct Node {
+		SecureRequest request;
+		Node *next = nullptr;
+	};
+
+	std::atomic<Node*> _head = nullptr;
+
+};
+
+template <typename Callback>
+void SendQueue::takeAll(Callback &&callback) {
+	auto list = _head.exchange(nullptr, std::memory_order_acquire);
+
+	// Nodes were pushed to the front, restore the order of pushes.
+	auto first = (Node*)nullptr;
+	while (list) {
+		const auto next = list->next;
+		list->next = first;
+		first = list;
+		list = next;
+	}
+	while (first) {
+		const auto node = first;
+		first = first->next;
+		callback(std::move(node->request));
+		delete node;
+	}
+}
+
 using SerializedMessage = mtpBuffer;
 
 inline bool ResponseNeedsAck(const SerializedMessage &response) {
@@ -214,10 +261,18 @@ public:
 		return &_stateRequestLock;
 	}
 
+	// Adds a request without any locks, it is moved to toSendMap() later.
+	void queueToSend(const SecureRequest &request) {
+		_toSendQueue.push(request);
+	}
+
+	// Requires toSendMutex() locked for writing.
 	PreRequestMap &toSendMap() {
+		takeQueuedToSend();
 		return _toSend;
 	}
 	const PreRequestMap &toSendMap() const {
+		takeQueuedToSend();
 		return _toSend;
 	}
 	RequestMap &haveSentMap() {
@@ -280,6 +335,8 @@ public:
 	void clear(Instance *instance);
 
 private:
+	void takeQueuedToSend() const;
+
 	uint64 _session = 0;
 	uint64 _salt = 0;
 
@@ -292,7 +349,8 @@ private:
 	bool _layerInited = false;
 	ConnectionOptions _options;
 
-	PreRequestMap _toSend; // map of request_id -> request, that is waiting to be sent
+	mutable SendQueue _toSendQueue; // requests added by sendPrepared(), not yet in toSend
+	mutable PreRequestMap _toSend; // map of request_id -> request, that is waiting to be sent
 	RequestMap _haveSent; // map of msg_id -> request, that was sent, msDate = 0 for msgs_state_req (no resend / state req), msDate = 0, seqNo = 0 for containers
 	RequestIdsMap _toResend; // map of msg_id -> request_id, that request_id -> request lies in toSend and is waiting to be resent
 	ReceivedMsgIds _receivedIds; // set of received msg_id's, for checking new msg_ids
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/rsa_public_key.h"
 #include "mtproto/dc_options.h"
 #include "mtproto/auth_key.h"
+#include "storage/localstorage.h"
 #include "base/unixtime.h"
 #include "base/openssl_help.h"
 
@@ -25,7 +26,6 @@ struct DnsEntry {
 	crl::time TTL = 0;
 };
 
-constexpr auto kSendNextTimeout = crl::time(1000);
 constexpr auto kMinTimeToLive = 10 * crl::time(1000);
 constexpr auto kMaxTimeToLive = 300 * crl::time(1000);
 
@@ -267,15 +267,23 @@ SpecialConfigRequest::SpecialConfigRequest(
 	Expects((_callback == nullptr) != (_timeDoneCallback == nullptr));
 
 	_manager.setProxy(QNetworkProxy::NoProxy);
-	_attempts = {
+	if (_callback && !Global::SimpleConfigCache().isEmpty()) {
+		// The last good config is tried while the fresh one is requested.
+		InvokeQueued(this, [=] {
+			handleResponse(Global::SimpleConfigCache());
+		});
+	}
+	auto attempts = std::vector<Attempt>{
 		//{ Type::App, qsl("software-download.microsoft.com") },
 	};
 	for (const auto &domain : DnsDomains()) {
-		_attempts.push_back({ Type::Dns, domain });
+		attempts.push_back({ Type::Dns, domain });
+	}
+
+	// All the attempts are raced, the first good response wins.
+	for (const auto &attempt : attempts) {
+		performRequest(attempt);
 	}
-	std::random_device rd;
-	ranges::shuffle(_attempts, std::mt19937(rd()));
-	sendNextRequest();
 }
 
 SpecialConfigRequest::SpecialConfigRequest(
@@ -292,19 +300,6 @@ SpecialConfigRequest::SpecialConfigRequest(Fn<void()> timeDoneCallback)
 : SpecialConfigRequest(nullptr, std::move(timeDoneCallback), QString()) {
 }
 
-void SpecialConfigRequest::sendNextRequest() {
-	Expects(!_attempts.empty());
-
-	const auto attempt = _attempts.back();
-	_attempts.pop_back();
-	if (!_attempts.empty()) {
-		App::CallDelayed(kSendNextTimeout, this, [=] {
-			sendNextRequest();
-		});
-	}
-	performRequest(attempt);
-}
-
 void SpecialConfigRequest::performRequest(const Attempt &attempt) {
 	const auto type = attempt.type;
 	auto url = QUrl();
@@ -337,10 +332,10 @@ void SpecialConfigRequest::performRequest(const Attempt &attempt) {
 	});
 }
 
-void SpecialConfigRequest::handleHeaderUnixtime(
+bool SpecialConfigRequest::handleHeaderUnixtime(
 		not_null<QNetworkReply*> reply) {
 	if (reply->error() != QNetworkReply::NoError) {
-		return;
+		return false;
 	}
 	const auto date = QString::fromLatin1([&] {
 		for (const auto &pair : reply->rawHeaderPairs()) {
@@ -352,36 +347,56 @@ void SpecialConfigRequest::handleHeaderUnixtime(
 	}());
 	if (date.isEmpty()) {
 		LOG(("Config Error: No 'Date' header received."));
-		return;
+		return false;
 	}
 	const auto parsed = ParseHttpDate(date);
 	if (!parsed.isValid()) {
 		LOG(("Config Error: Bad 'Date' header received: %1").arg(date));
-		return;
+		return false;
 	}
 	base::unixtime::http_update(parsed.toTime_t());
 	if (_timeDoneCallback) {
 		_timeDoneCallback();
 	}
+	return true;
 }
 
 void SpecialConfigRequest::requestFinished(
 		Type type,
 		not_null<QNetworkReply*> reply) {
-	handleHeaderUnixtime(reply);
+	const auto timeUpdated = handleHeaderUnixtime(reply);
 	const auto result = finalizeRequest(reply);
 	if (!_callback) {
+		if (timeUpdated) {
+			destroyRequests();
+		}
 		return;
 	}
 
-	switch (type) {
-	//case Type::App: handleResponse(result); break;
-	case Type::Dns: {
-		constexpr auto kTypeRestriction = 16; // TXT
-		handleResponse(ConcatenateDnsTxtFields(
-			ParseDnsResponse(result, kTypeRestriction)));
-	} break;
-	default: Unexpected("Type in SpecialConfigRequest::requestFinished.");
+	const auto bytes = [&] {
+		switch (type) {
+		//case Type::App: return result;
+		case Type::Dns: {
+			constexpr auto kTypeRestriction = 16; // TXT
+			return ConcatenateDnsTxtFields(
+				ParseDnsResponse(result, kTypeRestriction));
+		}
+		}
+		Unexpected("Type in SpecialConfigRequest::requestFinished.");
+	}();
+	if (!handleResponse(bytes)) {
+		return;
+	}
+	destroyRequests();
+	if (Global::SimpleConfigCache() != bytes) {
+		Global::SetSimpleConfigCache(bytes);
+		Local::writeSettings();
+	}
+}
+
+void SpecialConfigRequest::destroyRequests() {
+	for (auto &request : base::take(_requests)) {
+		request.destroy();
 	}
 }
 
@@ -469,9 +484,9 @@ bool SpecialConfigRequest::decryptSimpleConfig(const QByteArray &bytes) {
 	return true;
 }
 
-void SpecialConfigRequest::handleResponse(const QByteArray &bytes) {
+bool SpecialConfigRequest::handleResponse(const QByteArray &bytes) {
 	if (!decryptSimpleConfig(bytes)) {
-		return;
+		return false;
 	}
 	Assert(_simpleConfig.type() == mtpc_help_configSimple);
 	const auto &config = _simpleConfig.c_help_configSimple();
@@ -482,11 +497,11 @@ void SpecialConfigRequest::handleResponse(const QByteArray &bytes) {
 			).arg(config.vdate().v
 			).arg(config.vexpires().v
 			).arg(now));
-		return;
+		return false;
 	}
 	if (config.vrules().v.empty()) {
 		LOG(("Config Error: Empty simple config received."));
-		return;
+		return false;
 	}
 	for (const auto &rule : config.vrules().v) {
 		Assert(rule.type() == mtpc_accessPointRule);
@@ -523,6 +538,7 @@ void SpecialConfigRequest::handleResponse(const QByteArray &bytes) {
 			}
 		}
 	}
+	return true;
 }
 
 DomainResolver::DomainResolver(Fn<void(
@@ -539,9 +555,7 @@ void DomainResolver::resolve(const QString &domain) {
 }
 
 void DomainResolver::resolve(const AttemptKey &key) {
-	if (_attempts.find(key) != end(_attempts)) {
-		return;
-	} else if (_requests.find(key) != end(_requests)) {
+	if (_requests.find(key) != end(_requests)) {
 		return;
 	}
 	const auto i = _cache.find(key);
@@ -550,11 +564,10 @@ void DomainResolver::resolve(const AttemptKey &key) {
 		checkExpireAndPushResult(key.domain);
 		return;
 	}
-	auto hosts = DnsDomains();
-	std::random_device rd;
-	ranges::shuffle(hosts, std::mt19937(rd()));
-	_attempts.emplace(key, Attempts{ std::move(hosts) });
-	sendNextRequest(key);
+	// All the hosts are raced, the first good response wins.
+	for (const auto &host : DnsDomains()) {
+		performRequest(key, host);
+	}
 }
 
 void DomainResolver::checkExpireAndPushResult(const QString &domain) {
@@ -573,24 +586,6 @@ void DomainResolver::checkExpireAndPushResult(const QString &domain) {
 	});
 }
 
-void DomainResolver::sendNextRequest(const AttemptKey &key) {
-	auto i = _attempts.find(key);
-	if (i == end(_attempts)) {
-		return;
-	}
-	auto &attempts = i->second;
-	auto &hosts = attempts.hosts;
-	const auto host = hosts.back();
-	hosts.pop_back();
-
-	if (!hosts.empty()) {
-		App::CallDelayed(kSendNextTimeout, &attempts.guard, [=] {
-			sendNextRequest(key);
-		});
-	}
-	performRequest(key, host);
-}
-
 void DomainResolver::performRequest(
 		const AttemptKey &key,
 		const QString &host) {
@@ -623,8 +618,13 @@ void DomainResolver::requestFinished(
 	if (response.empty()) {
 		return;
 	}
-	_requests.erase(key);
-	_attempts.erase(key);
+	const auto i = _requests.find(key);
+	if (i != end(_requests)) {
+		for (auto &request : i->second) {
+			request.destroy();
+		}
+		_requests.erase(i);
+	}
 
 	auto entry = CacheEntry();
 	auto ttl = kMaxTimeToLive;
@@ -53,12 +53,12 @@ private:
 		Fn<void()> timeDoneCallback,
 		const QString &phone);
 
-	void sendNextRequest();
 	void performRequest(const Attempt &attempt);
 	void requestFinished(Type type, not_null<QNetworkReply*> reply);
-	void handleHeaderUnixtime(not_null<QNetworkReply*> reply);
+	bool handleHeaderUnixtime(not_null<QNetworkReply*> reply);
 	QByteArray finalizeRequest(not_null<QNetworkReply*> reply);
-	void handleResponse(const QByteArray &bytes);
+	void destroyRequests();
+	bool handleResponse(const QByteArray &bytes);
 	bool decryptSimpleConfig(const QByteArray &bytes);
 
 	Fn<void(
@@ -71,7 +71,6 @@ private:
 	MTPhelp_ConfigSimple _simpleConfig;
 
 	QNetworkAccessManager _manager;
-	std::vector<Attempt> _attempts;
 	std::vector<ServiceWebRequest> _requests;
 
 };
@@ -104,14 +103,7 @@ private:
 		crl::time expireAt = 0;
 
 	};
-	struct Attempts {
-		std::vector<QString> hosts;
-		base::has_weak_ptr guard;
-
-	};
-
 	void resolve(const AttemptKey &key);
-	void sendNextRequest(const AttemptKey &key);
 	void performRequest(const AttemptKey &key, const QString &host);
 	void checkExpireAndPushResult(const QString &domain);
 	void requestFinished(
@@ -127,7 +119,6 @@ private:
 		crl::time expireAt)> _callback;
 
 	QNetworkAccessManager _manager;
-	std::map<AttemptKey, Attempts> _attempts;
 	std::map<AttemptKey, std::vector<ServiceWebRequest>> _requests;
 	std::map<AttemptKey, CacheEntry> _cache;
 	crl::time _lastTimestamp = 0;
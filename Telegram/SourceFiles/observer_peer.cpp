@@ -27,6 +27,7 @@ void FinishCallback() {
 }
 
 base::Observable<PeerUpdate, PeerUpdatedHandler> PeerUpdatedObservable;
+rpl::event_stream<> PeerUpdatesSentStream;
 
 } // namespace
 
@@ -86,6 +87,11 @@ void peerUpdatedSendDelayed() {
 		std::swap(smallList, *SmallUpdates);
 		SmallUpdates->resize(0);
 	}
+	PeerUpdatesSentStream.fire({});
+}
+
+rpl::producer<> PeerUpdatesSent() {
+	return PeerUpdatesSentStream.events();
 }
 
 base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated() {
@@ -88,6 +88,10 @@ inline void peerUpdatedDelayed(PeerData *peer, PeerUpdate::Flags events) {
 }
 void peerUpdatedSendDelayed();
 
+// Fires once after all the delayed updates were sent, so that the work
+// that is common for many updated peers can be done only once.
+rpl::producer<> PeerUpdatesSent();
+
 class PeerUpdatedHandler {
 public:
 	template <typename Lambda>
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "layout.h"
+#include "base/object_pool.h"
 #include "core/click_handler_types.h"
 #include "ui/effects/animations.h"
 #include "ui/effects/radial_animation.h"
@@ -59,7 +60,9 @@ public:
 
 };
 
-class ItemBase : public AbstractItem {
+class ItemBase
+	: public AbstractItem
+	, public base::pooled<ItemBase> {
 public:
 	ItemBase(not_null<HistoryItem*> parent);
 
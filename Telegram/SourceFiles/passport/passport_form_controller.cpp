@@ -28,6 +28,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/localstorage.h"
 #include "storage/file_upload.h"
 #include "storage/file_download.h"
+#include "styles/style_passport.h"
 
 namespace Passport {
 namespace {
@@ -74,6 +75,31 @@ QImage ReadImage(bytes::const_span buffer) {
 		buffer.size()));
 }
 
+int ScanThumbSize() {
+	return st::passportScanRow.size * cIntRetinaFactor();
+}
+
+// Scans are displayed only as small squares, so we keep just those.
+QImage ReadScanThumb(bytes::const_span buffer, int size) {
+	const auto image = ReadImage(buffer);
+	if (image.isNull()) {
+		return image;
+	}
+	const auto side = std::min(image.width(), image.height());
+	const auto square = image.copy(
+		(image.width() - side) / 2,
+		(image.height() - side) / 2,
+		side,
+		side);
+	return (side > size)
+		? square.scaled(
+			size,
+			size,
+			Qt::IgnoreAspectRatio,
+			Qt::SmoothTransformation)
+		: square;
+}
+
 Value::Type ConvertType(const MTPSecureValueType &type) {
 	using Type = Value::Type;
 	switch (type.type()) {
@@ -1374,10 +1400,13 @@ void FormController::uploadScan(
 		return std::nullopt;
 	}();
 	auto &scan = nonconst->fileInEdit(type, fileIndex);
-	encryptFile(scan, std::move(content), [=](UploadScanData &&result) {
-		uploadEncryptedFile(
-			nonconst->fileInEdit(type, fileIndex),
-			std::move(result));
+	encryptFile(scan, std::move(content), [=](
+			UploadScanData &&result,
+			QImage &&thumb) {
+		auto &file = nonconst->fileInEdit(type, fileIndex);
+		file.fields.image = std::move(thumb);
+		_scanUpdated.fire(&file);
+		uploadEncryptedFile(file, std::move(result));
 	});
 }
 
@@ -1404,7 +1433,6 @@ void FormController::prepareFile(
 	file.fields.dcId = MTP::maindc();
 	file.fields.secret = GenerateSecretBytes();
 	file.fields.date = base::unixtime::now();
-	file.fields.image = ReadImage(bytes::make_span(content));
 	file.fields.downloadOffset = file.fields.size;
 
 	_scanUpdated.fire(&file);
@@ -1413,7 +1441,7 @@ void FormController::prepareFile(
 void FormController::encryptFile(
 		EditFile &file,
 		QByteArray &&content,
-		Fn<void(UploadScanData &&result)> callback) {
+		Fn<void(UploadScanData &&result, QImage &&thumb)> callback) {
 	prepareFile(file, content);
 
 	const auto weak = std::weak_ptr<bool>(file.guard);
@@ -1421,8 +1449,10 @@ void FormController::encryptFile(
 		=,
 		fileId = file.fields.id,
 		bytes = std::move(content),
-		fileSecret = file.fields.secret
+		fileSecret = file.fields.secret,
+		thumbSize = ScanThumbSize()
 	] {
+		auto thumb = ReadScanThumb(bytes::make_span(bytes), thumbSize);
 		auto data = EncryptData(
 			bytes::make_span(bytes),
 			fileSecret);
@@ -1435,9 +1465,13 @@ void FormController::encryptFile(
 			result.bytes.data(),
 			result.bytes.size(),
 			result.md5checksum.data());
-		crl::on_main([=, encrypted = std::move(result)]() mutable {
+		crl::on_main([
+			=,
+			encrypted = std::move(result),
+			thumb = std::move(thumb)
+		]() mutable {
 			if (weak.lock()) {
-				callback(std::move(encrypted));
+				callback(std::move(encrypted), std::move(thumb));
 			}
 		});
 	});
@@ -1741,18 +1775,35 @@ void FormController::loadFile(File &file) {
 
 void FormController::fileLoadDone(FileKey key, const QByteArray &bytes) {
 	if (const auto [value, file] = findFile(key); file != nullptr) {
-		const auto decrypted = DecryptData(
-			bytes::make_span(bytes),
-			file->hash,
-			file->secret);
-		if (decrypted.empty()) {
-			fileLoadFail(key);
-			return;
-		}
+		crl::async([
+			=,
+			hash = file->hash,
+			secret = file->secret,
+			thumbSize = ScanThumbSize()
+		] {
+			const auto decrypted = DecryptData(
+				bytes::make_span(bytes),
+				hash,
+				secret);
+			const auto failed = decrypted.empty();
+			auto thumb = failed
+				? QImage()
+				: ReadScanThumb(decrypted, thumbSize);
+			crl::on_main(this, [=, thumb = std::move(thumb)]() mutable {
+				if (failed) {
+					fileLoadFail(key);
+				} else {
+					fileDecrypted(key, std::move(thumb));
+				}
+			});
+		});
+	}
+}
+
+void FormController::fileDecrypted(FileKey key, QImage &&thumb) {
+	if (const auto [value, file] = findFile(key); file != nullptr) {
 		file->downloadOffset = file->size;
-		file->image = App::readImage(QByteArray::fromRawData(
-			reinterpret_cast<const char*>(decrypted.data()),
-			decrypted.size()));
+		file->image = std::move(thumb);
 		if (const auto fileInEdit = findEditFile(key)) {
 			fileInEdit->fields.image = file->image;
 			fileInEdit->fields.downloadOffset = file->downloadOffset;
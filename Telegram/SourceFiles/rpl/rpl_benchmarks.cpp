@@ -0,0 +1,79 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "base/benchmark.h"
+
+#include <rpl/rpl.h>
+
+BENCHMARK("rpl event_stream fire through filter and map") {
+	auto sum = int64();
+	auto lifetime = rpl::lifetime();
+	auto stream = rpl::event_stream<int>();
+	stream.events(
+	) | rpl::filter([](int value) {
+		return (value % 3) != 0;
+	}) | rpl::map([](int value) {
+		return int64(value) * 2;
+	}) | rpl::start_with_next([&](int64 value) {
+		sum += value;
+	}, lifetime);
+
+	for (auto i = 0; i != iterations; ++i) {
+		stream.fire_copy(i);
+	}
+	base::benchmark::Consume(sum);
+}
+
+BENCHMARK("rpl event_stream fire to 16 consumers") {
+	auto sum = int64();
+	auto lifetime = rpl::lifetime();
+	auto stream = rpl::event_stream<int>();
+	for (auto j = 0; j != 16; ++j) {
+		stream.events() | rpl::start_with_next([&](int value) {
+			sum += value;
+		}, lifetime);
+	}
+
+	for (auto i = 0; i != iterations; ++i) {
+		stream.fire_copy(i);
+	}
+	base::benchmark::Consume(sum);
+}
+
+BENCHMARK("rpl combine of two variables") {
+	auto sum = int64();
+	auto lifetime = rpl::lifetime();
+	auto first = rpl::variable<int>(0);
+	auto second = rpl::variable<int>(0);
+	rpl::combine(
+		first.value(),
+		second.value()
+	) | rpl::start_with_next([&](int a, int b) {
+		sum += a + b;
+	}, lifetime);
+
+	for (auto i = 0; i != iterations; ++i) {
+		((i & 1) ? first : second) = i;
+	}
+	base::benchmark::Consume(sum);
+}
+
+BENCHMARK("rpl producer chain construction") {
+	for (auto i = 0; i != iterations; ++i) {
+		auto sum = int64();
+		const auto lifetime = rpl::single(
+			i
+		) | rpl::then(
+			rpl::single(i + 1)
+		) | rpl::map([](int value) {
+			return value * 2;
+		}) | rpl::start_with_next([&](int value) {
+			sum += value;
+		});
+		base::benchmark::Consume(sum);
+	}
+}
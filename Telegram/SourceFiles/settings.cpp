@@ -22,6 +22,7 @@ QString gWorkingDir, gExeDir, gExeName;
 
 QStringList gSendPaths;
 QString gStartUrl;
+QString gUpdatesMirror;
 
 QString gDialogLastPath, gDialogHelperPath; // optimize QFileDialog
 
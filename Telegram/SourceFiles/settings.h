@@ -153,6 +153,7 @@ inline bool passcodeCanTry() {
 
 DeclareSetting(QStringList, SendPaths);
 DeclareSetting(QString, StartUrl);
+DeclareSetting(QString, UpdatesMirror);
 
 DeclareSetting(float64, RetinaFactor);
 DeclareSetting(int32, IntRetinaFactor);
@@ -298,6 +298,34 @@ void Calls::setupContent(not_null<Window::SessionController*> controller) {
 	}, content->lifetime());
 #endif // Q_OS_MAC && !OS_MAC_STORE
 
+	const auto jitterPresets = std::vector<QString>{
+		tr::lng_settings_call_jitter_default(tr::now),
+		tr::lng_settings_call_jitter_low_latency(tr::now),
+		tr::lng_settings_call_jitter_stable(tr::now),
+	};
+	AddButtonWithLabel(
+		content,
+		tr::lng_settings_call_jitter_preset(),
+		rpl::single(
+			jitterPresets[Global::CallJitterPreset()]
+		) | rpl::then(
+			_jitterPresetNameStream.events()
+		),
+		st::settingsButton
+	)->addClickHandler([=] {
+		const auto save = crl::guard(this, [=](int option) {
+			_jitterPresetNameStream.fire_copy(jitterPresets[option]);
+			Global::SetCallJitterPreset(DBICallJitterPreset(option));
+			Local::writeUserSettings();
+			::Calls::RefreshJitterPreset();
+		});
+		Ui::show(Box<SingleChoiceBox>(
+			tr::lng_settings_call_jitter_preset(),
+			jitterPresets,
+			int(Global::CallJitterPreset()),
+			save));
+	});
+
 	AddButton(
 		content,
 		tr::lng_settings_call_open_system_prefs(),
@@ -40,6 +40,7 @@ private:
 	rpl::event_stream<QString> _outputNameStream;
 	rpl::event_stream<QString> _inputNameStream;
 	rpl::event_stream<QString> _micTestTextStream;
+	rpl::event_stream<QString> _jitterPresetNameStream;
 	bool _needWriteSettings = false;
 	std::unique_ptr<tgvoip::AudioInputTester> _micTester;
 	Ui::LevelMeter *_micTestLevel = nullptr;
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "platform/platform_specific.h"
 #include "ui/toast/toast.h"
 #include "mainwidget.h"
+#include "mainwindow.h"
 #include "data/data_session.h"
 #include "storage/localstorage.h"
 #include "boxes/confirm_box.h"
@@ -20,8 +21,10 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/dc_options.h"
 #include "core/file_utilities.h"
 #include "core/update_checker.h"
+#include "core/memory_counters.h"
 #include "window/themes/window_theme.h"
 #include "window/themes/window_theme_editor.h"
+#include "window/window_scroll_benchmark.h"
 #include "media/audio/media_audio_track.h"
 
 namespace Settings {
@@ -40,6 +43,18 @@ auto GenerateCodes() {
 	codes.emplace(qsl("viewlogs"), [](::Main::Session *session) {
 		File::ShowInFolder(cWorkingDir() + "log.txt");
 	});
+	codes.emplace(qsl("memorystats"), [](::Main::Session *session) {
+		Core::LogMemoryReport();
+		Ui::show(Box<InformBox>(Core::MemoryReport()));
+	});
+	codes.emplace(qsl("scrollbenchmark"), [](::Main::Session *session) {
+		if (const auto window = App::wnd()) {
+			Ui::hideSettingsAndLayer(anim::type::instant);
+			App::CallDelayed(1000, window, [=] {
+				Window::RunScrollBenchmark(window);
+			});
+		}
+	});
 	codes.emplace(qsl("testmode"), [](::Main::Session *session) {
 		auto text = cTestMode() ? qsl("Do you want to disable TEST mode?") : qsl("Do you want to enable TEST mode?\n\nYou will be switched to test cloud.");
 		Ui::show(Box<ConfirmBox>(text, [] {
@@ -30,6 +30,10 @@ bool BinlogWrapper::failed() const {
 	return _failed;
 }
 
+int64 BinlogWrapper::recordsOffset() const {
+	return _binlog.offset() - _part.size();
+}
+
 std::optional<BasicHeader> BinlogWrapper::ReadHeader(
 		File &binlog,
 		const Settings &settings) {
@@ -43,6 +47,9 @@ std::optional<BasicHeader> BinlogWrapper::ReadHeader(
 	} else if (settings.trackEstimatedTime
 		!= !!(result.flags & result.kTrackEstimatedTime)) {
 		return {};
+	} else if (settings.tagPlaceDirectories
+		!= !!(result.flags & result.kTagPlaceDirectories)) {
+		return {};
 	}
 	return result;
 }
@@ -69,7 +76,7 @@ bool BinlogWrapper::readPart() {
 		left,
 		int64(_full.size() - _part.size()));
 	Assert(amount > 0);
-	const auto readBytes = _binlog.read(
+	const auto readBytes = _binlog.readParallel(
 		_full.subspan(_part.size(), amount));
 	if (!readBytes) {
 		return no();
@@ -104,6 +111,7 @@ void BinlogWrapper::finish(size_type rollback) {
 	}
 	rollback += _part.size();
 	_binlog.seek(_binlog.offset() - rollback);
+	_part = bytes::span();
 }
 
 } // namespace details
@@ -26,6 +26,9 @@ public:
 	bool finished() const;
 	bool failed() const;
 
+	// Offset of the first record that wasn't processed yet.
+	int64 recordsOffset() const;
+
 	static std::optional<BasicHeader> ReadHeader(
 		File &binlog,
 		const Settings &settings);
@@ -9,11 +9,45 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "storage/cache/storage_cache_database_object.h"
 #include "storage/cache/storage_cache_binlog_reader.h"
+#include "base/concurrent_timer.h"
 #include <unordered_set>
 
 namespace Storage {
 namespace Cache {
 namespace details {
+namespace {
+
+struct CompactProgress {
+	int64 readTill = 0;
+	int64 compactSize = 0;
+};
+
+std::optional<CompactProgress> ReadCompactProgress(const QString &path) {
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+	const auto bytes = file.read(sizeof(CompactProgress));
+	if (bytes.size() != sizeof(CompactProgress)) {
+		return std::nullopt;
+	}
+	return *reinterpret_cast<const CompactProgress*>(bytes.data());
+}
+
+bool WriteCompactProgress(const QString &path, CompactProgress value) {
+	const auto bytes = QByteArray::fromRawData(
+		reinterpret_cast<const char*>(&value),
+		sizeof(value));
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly)) {
+		return false;
+	} else if (file.write(bytes) != bytes.size()) {
+		return false;
+	}
+	return file.flush();
+}
+
+} // namespace
 
 class CompactorObject {
 public:
@@ -32,23 +66,38 @@ private:
 	using Entry = DatabaseObject::Entry;
 	using Raw = DatabaseObject::Raw;
 	using RawSpan = gsl::span<const Raw>;
+	struct Chunk {
+		std::vector<Key> stored;
+		std::vector<Key> removed;
+		std::vector<uint8> removedTags;
+	};
 	static QString CompactFilename();
+	static QString ProgressFilename();
 
 	void start();
 	QString binlogPath() const;
 	QString compactPath() const;
+	QString progressPath() const;
 	bool openBinlog();
 	bool readHeader();
 	bool openCompact();
+	bool resumeCompact();
 	void parseChunk();
 	void fail();
 	void done(int64 till);
 	void finish();
 	void finalize();
 
-	std::vector<Key> readChunk();
-	bool readBlock(std::vector<Key> &result);
-	void processValues(const std::vector<Raw> &values);
+	Chunk readChunk();
+	bool readBlock(Chunk &result);
+	void processValues(
+		const std::vector<Raw> &values,
+		std::vector<Key> &&removed,
+		std::vector<uint8> &&removedTags);
+	bool writeRemoved(std::vector<Key> &&removed);
+	bool writeRemovedTags(std::vector<uint8> &&removedTags);
+	bool writeProgress();
+	void scheduleNextChunk();
 
 	template <typename MultiRecord>
 	void initList();
@@ -80,6 +129,12 @@ private:
 		std::vector<MultiStore::Part>,
 		std::vector<MultiStoreWithTime::Part>> _list;
 
+	// When resuming a compaction started before the restart we don't know
+	// which keys were removed after the compact file was written.
+	bool _resumed = false;
+	crl::time _tickStarted = 0;
+	base::ConcurrentTimer _nextChunkTimer;
+
 };
 
 CompactorObject::CompactorObject(
@@ -98,7 +153,8 @@ CompactorObject::CompactorObject(
 , _key(std::move(key))
 , _info(info)
 , _wrapper(_binlog, _settings, _info.till)
-, _partSize(_settings.maxBundledRecords) { // Perhaps a better estimate?
+, _partSize(_settings.maxBundledRecords) // Perhaps a better estimate?
+, _nextChunkTimer(_weak, [=] { parseChunk(); }) {
 	Expects(_settings.compactChunkSize > 0);
 
 	_written.reserve(_info.keysCount);
@@ -114,8 +170,12 @@ void CompactorObject::initList() {
 }
 
 void CompactorObject::start() {
-	if (!openBinlog() || !readHeader() || !openCompact()) {
+	if (!openBinlog() || !readHeader()) {
 		fail();
+		return;
+	} else if (!resumeCompact() && !openCompact()) {
+		fail();
+		return;
 	}
 	if (_settings.trackEstimatedTime) {
 		initList<MultiStoreWithTime>();
@@ -129,6 +189,10 @@ QString CompactorObject::CompactFilename() {
 	return QStringLiteral("binlog-temp");
 }
 
+QString CompactorObject::ProgressFilename() {
+	return QStringLiteral("binlog-progress");
+}
+
 QString CompactorObject::binlogPath() const {
 	return _base + DatabaseObject::BinlogFilename();
 }
@@ -137,6 +201,10 @@ QString CompactorObject::compactPath() const {
 	return _base + CompactFilename();
 }
 
+QString CompactorObject::progressPath() const {
+	return _base + ProgressFilename();
+}
+
 bool CompactorObject::openBinlog() {
 	const auto path = binlogPath();
 	const auto result = _binlog.open(path, File::Mode::Read, _key);
@@ -164,9 +232,46 @@ bool CompactorObject::openCompact() {
 	return true;
 }
 
+bool CompactorObject::resumeCompact() {
+	const auto progress = ReadCompactProgress(progressPath());
+	if (!progress
+		|| progress->readTill < _binlog.offset()
+		|| progress->readTill > _info.till) {
+		return false;
+	}
+	const auto path = compactPath();
+	const auto result = _compact.open(path, File::Mode::ReadAppend, _key);
+	if (result != File::Result::Success) {
+		return false;
+	}
+	auto header = BasicHeader();
+	const auto headerBytes = bytes::object_as_span(&header);
+	const auto good = (_compact.size() == progress->compactSize)
+		&& (_compact.read(headerBytes) == headerBytes.size())
+		&& !bytes::compare(headerBytes, bytes::object_as_span(&_header))
+		&& _compact.seek(progress->compactSize)
+		&& _binlog.seek(progress->readTill);
+	if (!good) {
+		_compact.close();
+		_binlog.seek(sizeof(BasicHeader));
+		return false;
+	}
+	_resumed = true;
+	return true;
+}
+
+bool CompactorObject::writeProgress() {
+	auto progress = CompactProgress();
+	progress.readTill = _wrapper.recordsOffset();
+	progress.compactSize = _compact.size();
+	return WriteCompactProgress(progressPath(), progress);
+}
+
 void CompactorObject::fail() {
+	_nextChunkTimer.cancel();
 	_compact.close();
 	QFile(compactPath()).remove();
+	QFile(progressPath()).remove();
 	_database.with([](DatabaseObject &database) {
 		database.compactorFail();
 	});
@@ -192,6 +297,7 @@ void CompactorObject::finish() {
 void CompactorObject::finalize() {
 	_binlog.close();
 	_compact.close();
+	QFile(progressPath()).remove();
 
 	auto lastCatchUp = 0;
 	auto from = _info.till;
@@ -236,18 +342,19 @@ bool CompactorObject::writeMultiStore() {
 	const auto guard = gsl::finally([&] { list.clear(); });
 	const auto size = list.size();
 	auto header = MultiRecord(size);
-	if (_compact.write(bytes::object_as_span(&header))
-		&& _compact.write(bytes::make_span(list))) {
+	if (_compact.writeVectored({
+			bytes::object_as_span(&header),
+			bytes::make_span(list) })) {
 		_compact.flush();
 		return true;
 	}
 	return false;
 }
 
-std::vector<Key> CompactorObject::readChunk() {
+auto CompactorObject::readChunk() -> Chunk {
 	const auto limit = _settings.compactChunkSize;
-	auto result = std::vector<Key>();
-	while (result.size() < limit) {
+	auto result = Chunk();
+	while (result.stored.size() + result.removed.size() < limit) {
 		if (!readBlock(result)) {
 			break;
 		}
@@ -255,9 +362,9 @@ std::vector<Key> CompactorObject::readChunk() {
 	return result;
 }
 
-bool CompactorObject::readBlock(std::vector<Key> &result) {
+bool CompactorObject::readBlock(Chunk &result) {
 	const auto push = [&](const Store &store) {
-		result.push_back(store.key);
+		result.stored.push_back(store.key);
 		return true;
 	};
 	const auto pushMulti = [&](const auto &element) {
@@ -266,58 +373,111 @@ bool CompactorObject::readBlock(std::vector<Key> &result) {
 		}
 		return true;
 	};
+	const auto pushRemoved = [&](const auto &element) {
+		if (_resumed) {
+			while (const auto key = element()) {
+				result.removed.push_back(*key);
+			}
+		}
+		return true;
+	};
+	const auto pushRemovedTag = [&](const RemoveTag &record) {
+		if (_resumed) {
+			result.removedTags.push_back(record.tag);
+		}
+		return true;
+	};
 	if (_settings.trackEstimatedTime) {
 		BinlogReader<
 			StoreWithTime,
 			MultiStoreWithTime,
 			MultiRemove,
-			MultiAccess> reader(_wrapper);
+			MultiAccess,
+			RemoveTag> reader(_wrapper);
 		return !reader.readTillEnd([&](const StoreWithTime &record) {
 			return push(record);
 		}, [&](const MultiStoreWithTime &header, const auto &element) {
 			return pushMulti(element);
 		}, [&](const MultiRemove &header, const auto &element) {
-			return true;
+			return pushRemoved(element);
 		}, [&](const MultiAccess &header, const auto &element) {
 			return true;
+		}, [&](const RemoveTag &record) {
+			return pushRemovedTag(record);
 		});
 	} else {
 		BinlogReader<
 			Store,
 			MultiStore,
-			MultiRemove> reader(_wrapper);
+			MultiRemove,
+			RemoveTag> reader(_wrapper);
 		return !reader.readTillEnd([&](const Store &record) {
 			return push(record);
 		}, [&](const MultiStore &header, const auto &element) {
 			return pushMulti(element);
 		}, [&](const MultiRemove &header, const auto &element) {
-			return true;
+			return pushRemoved(element);
+		}, [&](const RemoveTag &record) {
+			return pushRemovedTag(record);
 		});
 	}
 }
 
 void CompactorObject::parseChunk() {
-	auto keys = readChunk();
+	if (!_tickStarted) {
+		_tickStarted = crl::now();
+	}
+	auto chunk = readChunk();
 	if (_wrapper.failed()) {
 		fail();
 		return;
-	} else if (keys.empty()) {
+	} else if (chunk.stored.empty()
+		&& chunk.removed.empty()
+		&& chunk.removedTags.empty()) {
 		finish();
 		return;
 	}
 	_database.with([
 		weak = _weak,
-		keys = std::move(keys)
-	](DatabaseObject &database) {
-		auto result = database.getManyRaw(keys);
-		weak.with([result = std::move(result)](CompactorObject &that) {
-			that.processValues(result);
+		chunk = std::move(chunk)
+	](DatabaseObject &database) mutable {
+		auto result = database.getManyRaw(chunk.stored);
+		auto removed = std::move(chunk.removed);
+		auto removedTags = std::move(chunk.removedTags);
+		if (!removed.empty()) {
+			// Skip the keys that were stored again after being removed.
+			const auto present = database.getManyRaw(removed);
+			const auto restored = [&](const Key &key) {
+				return ranges::find(present, key, &Raw::first)
+					!= end(present);
+			};
+			removed.erase(
+				ranges::remove_if(removed, restored),
+				end(removed));
+		}
+		weak.with([
+			result = std::move(result),
+			removed = std::move(removed),
+			removedTags = std::move(removedTags)
+		](CompactorObject &that) mutable {
+			that.processValues(
+				result,
+				std::move(removed),
+				std::move(removedTags));
 		});
 	});
 }
 
 void CompactorObject::processValues(
-		const std::vector<std::pair<Key, Entry>> &values) {
+		const std::vector<std::pair<Key, Entry>> &values,
+		std::vector<Key> &&removed,
+		std::vector<uint8> &&removedTags) {
+	// Tags are removed before the current values of this chunk are written,
+	// so only the values written in the previous chunks are affected.
+	if (!writeRemovedTags(std::move(removedTags))) {
+		fail();
+		return;
+	}
 	auto left = gsl::make_span(values);
 	while (true) {
 		left = fillList(left);
@@ -328,7 +488,61 @@ void CompactorObject::processValues(
 			return;
 		}
 	}
-	parseChunk();
+	if (!writeList() || !writeRemoved(std::move(removed))) {
+		fail();
+		return;
+	}
+	writeProgress();
+
+	const auto readTill = _wrapper.recordsOffset();
+	_database.with([=](DatabaseObject &database) {
+		database.compactorProgress(readTill);
+	});
+	scheduleNextChunk();
+}
+
+bool CompactorObject::writeRemoved(std::vector<Key> &&removed) {
+	auto from = begin(removed);
+	const auto till = end(removed);
+	while (from != till) {
+		const auto count = std::min(
+			size_type(till - from),
+			_settings.maxBundledRecords);
+		auto header = MultiRemove(count);
+		const auto list = gsl::make_span(&*from, count);
+		if (!_compact.writeVectored({
+				bytes::object_as_span(&header),
+				bytes::make_span(list) })) {
+			return false;
+		}
+		from += count;
+	}
+	_compact.flush();
+	return true;
+}
+
+bool CompactorObject::writeRemovedTags(std::vector<uint8> &&removedTags) {
+	if (removedTags.empty()) {
+		return true;
+	}
+	for (const auto tag : removedTags) {
+		auto record = RemoveTag(tag);
+		if (!_compact.write(bytes::object_as_span(&record))) {
+			return false;
+		}
+	}
+	_compact.flush();
+	return true;
+}
+
+void CompactorObject::scheduleNextChunk() {
+	const auto now = crl::now();
+	if (now - _tickStarted < _settings.compactTickBudget) {
+		parseChunk();
+		return;
+	}
+	_tickStarted = 0;
+	_nextChunkTimer.callOnce(_settings.compactTickDelay);
 }
 
 auto CompactorObject::fillList(RawSpan values) -> RawSpan {
@@ -367,6 +581,7 @@ void CompactorObject::addListRecord(
 	if constexpr (std::is_same_v<RecordStore, StoreWithTime>) {
 		record.time.setRelative(raw.second.useTime);
 		record.time.system = _info.systemTime;
+		record.hits = raw.second.hits;
 	}
 	list.push_back(record);
 }
@@ -8,49 +8,244 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/cache/storage_cache_database.h"
 
 #include "storage/cache/storage_cache_database_object.h"
+#include "storage/cache/storage_cache_keys_filter.h"
+#include <rpl/combine.h>
+#include <QtCore/QDir>
+#include <QtCore/QMutex>
 
 namespace Storage {
 namespace Cache {
+namespace {
+
+using Settings = Database::Settings;
+using SettingsUpdate = Database::SettingsUpdate;
+using Stats = Database::Stats;
+
+size_type CountShards(const Settings &settings) {
+	return std::max(settings.shardsCount, size_type(1));
+}
+
+QString ShardPath(const QString &path, size_type index) {
+	// The first shard keeps the original path, so that a database opened
+	// with a single shard sees the same data as before.
+	return index
+		? (QDir(path).absolutePath() + '_' + QString::number(index))
+		: path;
+}
+
+int64 ShardSizeLimit(int64 limit, size_type count, size_type maxDataSize) {
+	return (limit > 0 && count > 1)
+		? std::max(limit / count, int64(maxDataSize) + 1)
+		: limit;
+}
+
+Settings ShardSettings(const Settings &settings) {
+	auto result = settings;
+	result.totalSizeLimit = ShardSizeLimit(
+		settings.totalSizeLimit,
+		CountShards(settings),
+		settings.maxDataSize);
+	return result;
+}
+
+SettingsUpdate ShardSettingsUpdate(
+		const SettingsUpdate &update,
+		size_type count,
+		size_type maxDataSize) {
+	auto result = update;
+	result.totalSizeLimit = ShardSizeLimit(
+		update.totalSizeLimit,
+		count,
+		maxDataSize);
+	return result;
+}
+
+Stats MergeStats(const std::vector<Stats> &list) {
+	auto result = Stats();
+	for (const auto &stats : list) {
+		result.full.count += stats.full.count;
+		result.full.totalSize += stats.full.totalSize;
+		for (const auto &[tag, summary] : stats.tagged) {
+			auto &merged = result.tagged[tag];
+			merged.count += summary.count;
+			merged.totalSize += summary.totalSize;
+		}
+		result.binlogSize += stats.binlogSize;
+		result.binlogExcess += stats.binlogExcess;
+		result.compactTill += stats.compactTill;
+		result.compactReadTill += stats.compactReadTill;
+		result.openDuration = std::max(
+			result.openDuration,
+			stats.openDuration);
+		result.binlogFlushes += stats.binlogFlushes;
+		for (auto i = 0; i != details::kCommitBatchBuckets; ++i) {
+			result.commitBatches[i] += stats.commitBatches[i];
+		}
+		result.clearing = result.clearing || stats.clearing;
+	}
+	return result;
+}
+
+struct ErrorGather {
+	QMutex mutex;
+	size_type left = 0;
+	Error error;
+	FnMut<void(Error)> done;
+};
+
+FnMut<void(Error)> GatherPart(const std::shared_ptr<ErrorGather> &state) {
+	if (!state) {
+		return nullptr;
+	}
+	return [=](Error error) {
+		QMutexLocker lock(&state->mutex);
+		if (error.type != Error::Type::None
+			&& state->error.type == Error::Type::None) {
+			state->error = error;
+		}
+		if (--state->left) {
+			return;
+		}
+		auto done = std::move(state->done);
+		const auto result = state->error;
+		lock.unlock();
+		done(result);
+	};
+}
+
+std::shared_ptr<ErrorGather> PrepareGather(
+		size_type count,
+		FnMut<void(Error)> &&done) {
+	if (!done) {
+		return nullptr;
+	}
+	auto result = std::make_shared<ErrorGather>();
+	result->left = count;
+	result->done = std::move(done);
+	return result;
+}
+
+FnMut<void(Error)> IgnoreError(FnMut<void()> &&done) {
+	if (!done) {
+		return nullptr;
+	}
+	return [done = std::move(done)](Error) mutable {
+		done();
+	};
+}
+
+} // namespace
 
 Database::Database(const QString &path, const Settings &settings)
-: _wrapped(path, settings) {
+: _shards(std::make_shared<Shards>())
+, _maxDataSize(settings.maxDataSize) {
+	const auto count = CountShards(settings);
+	const auto shardSettings = ShardSettings(settings);
+	_shards->reserve(count);
+	_filters.reserve(count);
+	for (auto i = size_type(0); i != count; ++i) {
+		_filters.push_back(std::make_shared<details::KeysFilter>());
+		_shards->push_back(std::make_unique<Wrapped>(
+			ShardPath(path, i),
+			shardSettings,
+			_filters.back()));
+	}
+}
+
+size_type Database::shardIndex(const Key &key) const {
+	const auto count = size_type(_shards->size());
+	if (count == 1) {
+		return 0;
+	}
+	const auto mixed = (key.high * 0x9E3779B97F4A7C15ULL) ^ key.low;
+	return size_type((mixed ^ (mixed >> 32)) % uint64(count));
+}
+
+auto Database::shard(const Key &key) const -> Wrapped& {
+	return *(*_shards)[shardIndex(key)];
+}
+
+void Database::remember(const Key &key) {
+	// Added before the request is queued, so that mayContain() right
+	// after put() never reports a miss.
+	_filters[shardIndex(key)]->add(key);
+}
+
+bool Database::mayContain(const Key &key) const {
+	return _filters[shardIndex(key)]->mayContain(key);
+}
+
+template <typename Method>
+void Database::withAll(Method &&method) {
+	for (const auto &shard : *_shards) {
+		shard->with(method);
+	}
 }
 
 void Database::reconfigure(const Settings &settings) {
-	_wrapped.with([settings](Implementation &unwrapped) mutable {
+	Expects(CountShards(settings) == _shards->size());
+
+	_maxDataSize = settings.maxDataSize;
+	withAll([settings = ShardSettings(settings)](
+			Implementation &unwrapped) mutable {
 		unwrapped.reconfigure(settings);
 	});
 }
 
 void Database::updateSettings(const SettingsUpdate &update) {
-	_wrapped.with([update](Implementation &unwrapped) mutable {
-		unwrapped.updateSettings(update);
+	const auto shardUpdate = ShardSettingsUpdate(
+		update,
+		_shards->size(),
+		_maxDataSize);
+	withAll([shardUpdate](Implementation &unwrapped) mutable {
+		unwrapped.updateSettings(shardUpdate);
 	});
 }
 
 void Database::open(EncryptionKey &&key, FnMut<void(Error)> &&done) {
-	_wrapped.with([
-		key = std::move(key),
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.open(std::move(key), std::move(done));
-	});
+	const auto gather = PrepareGather(_shards->size(), std::move(done));
+	for (const auto &shard : *_shards) {
+		shard->with([
+			key = base::duplicate(key),
+			done = GatherPart(gather)
+		](Implementation &unwrapped) mutable {
+			unwrapped.open(std::move(key), std::move(done));
+		});
+	}
 }
 
 void Database::close(FnMut<void()> &&done) {
-	_wrapped.with([
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.close(std::move(done));
-	});
+	const auto gather = PrepareGather(
+		_shards->size(),
+		IgnoreError(std::move(done)));
+	for (const auto &shard : *_shards) {
+		shard->with([
+			done = GatherPart(gather)
+		](Implementation &unwrapped) mutable {
+			unwrapped.close([done = std::move(done)]() mutable {
+				if (done) {
+					done(Error::NoError());
+				}
+			});
+		});
+	}
 }
 
 void Database::waitForCleaner(FnMut<void()> &&done) {
-	_wrapped.with([
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.waitForCleaner(std::move(done));
-	});
+	const auto gather = PrepareGather(
+		_shards->size(),
+		IgnoreError(std::move(done)));
+	for (const auto &shard : *_shards) {
+		shard->with([
+			done = GatherPart(gather)
+		](Implementation &unwrapped) mutable {
+			unwrapped.waitForCleaner([done = std::move(done)]() mutable {
+				if (done) {
+					done(Error::NoError());
+				}
+			});
+		});
+	}
 }
 
 void Database::put(
@@ -72,7 +267,7 @@ void Database::get(const Key &key, FnMut<void(QByteArray&&)> &&done) {
 }
 
 void Database::remove(const Key &key, FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	shard(key).with([
 		key,
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
@@ -94,7 +289,12 @@ void Database::copyIfEmpty(
 		const Key &from,
 		const Key &to,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	remember(to);
+	if (shardIndex(from) != shardIndex(to)) {
+		copyBetweenShards(from, to, false, std::move(done));
+		return;
+	}
+	shard(from).with([
 		from,
 		to,
 		done = std::move(done)
@@ -107,7 +307,12 @@ void Database::moveIfEmpty(
 		const Key &from,
 		const Key &to,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	remember(to);
+	if (shardIndex(from) != shardIndex(to)) {
+		copyBetweenShards(from, to, true, std::move(done));
+		return;
+	}
+	shard(from).with([
 		from,
 		to,
 		done = std::move(done)
@@ -116,11 +321,61 @@ void Database::moveIfEmpty(
 	});
 }
 
+void Database::copyBetweenShards(
+		const Key &from,
+		const Key &to,
+		bool removeSource,
+		FnMut<void(Error)> &&done) {
+	const auto weak = std::weak_ptr<Shards>(_shards);
+	const auto source = shardIndex(from);
+	const auto destination = shardIndex(to);
+	const auto write = [=](TaggedValue &&value, FnMut<void(Error)> &&done) {
+		if (const auto strong = weak.lock()) {
+			(*strong)[destination]->with([
+				to,
+				value = std::move(value),
+				done = std::move(done)
+			](Implementation &unwrapped) mutable {
+				unwrapped.putIfEmpty(to, std::move(value), std::move(done));
+			});
+		}
+	};
+	const auto read = [=](FnMut<void(Error)> &&done) {
+		if (const auto strong = weak.lock()) {
+			(*strong)[source]->with([=, done = std::move(done)](
+					Implementation &unwrapped) mutable {
+				unwrapped.get(from, [&](TaggedValue &&value) {
+					if (value.bytes.isEmpty()) {
+						if (done) {
+							done(Error::NoError());
+						}
+						return;
+					} else if (removeSource) {
+						unwrapped.remove(from, nullptr);
+					}
+					write(std::move(value), std::move(done));
+				});
+			});
+		}
+	};
+	(*_shards)[destination]->with([=, done = std::move(done)](
+			Implementation &unwrapped) mutable {
+		if (!unwrapped.getManyRaw({ to }).empty()) {
+			if (done) {
+				done(Error::NoError());
+			}
+			return;
+		}
+		read(std::move(done));
+	});
+}
+
 void Database::put(
 		const Key &key,
 		TaggedValue &&value,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	remember(key);
+	shard(key).with([
 		key,
 		value = std::move(value),
 		done = std::move(done)
@@ -133,7 +388,8 @@ void Database::putIfEmpty(
 		const Key &key,
 		TaggedValue &&value,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	remember(key);
+	shard(key).with([
 		key,
 		value = std::move(value),
 		done = std::move(done)
@@ -145,7 +401,7 @@ void Database::putIfEmpty(
 void Database::getWithTag(
 		const Key &key,
 		FnMut<void(TaggedValue&&)> &&done) {
-	_wrapped.with([
+	shard(key).with([
 		key,
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
@@ -153,48 +409,221 @@ void Database::getWithTag(
 	});
 }
 
+void Database::getMany(
+		std::vector<Key> &&keys,
+		FnMut<void(std::vector<QByteArray>&&)> &&done) {
+	if (done) {
+		auto untag = [done = std::move(done)](
+				std::vector<TaggedValue> &&values) mutable {
+			auto result = std::vector<QByteArray>();
+			result.reserve(values.size());
+			for (auto &value : values) {
+				result.push_back(std::move(value.bytes));
+			}
+			done(std::move(result));
+		};
+		getManyWithTag(std::move(keys), std::move(untag));
+	} else {
+		getManyWithTag(std::move(keys), nullptr);
+	}
+}
+
+void Database::getManyWithTag(
+		std::vector<Key> &&keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done) {
+	if (_shards->size() == 1) {
+		_shards->front()->with([
+			keys = std::move(keys),
+			done = std::move(done)
+		](Implementation &unwrapped) mutable {
+			unwrapped.getMany(keys, std::move(done));
+		});
+		return;
+	}
+
+	struct Gather {
+		QMutex mutex;
+		size_type left = 0;
+		std::vector<TaggedValue> values;
+		FnMut<void(std::vector<TaggedValue>&&)> done;
+	};
+	auto indices = std::vector<std::vector<int>>(_shards->size());
+	for (auto i = 0, count = int(keys.size()); i != count; ++i) {
+		indices[shardIndex(keys[i])].push_back(i);
+	}
+	const auto gather = std::make_shared<Gather>();
+	gather->values.resize(keys.size());
+	gather->done = std::move(done);
+	gather->left = size_type(ranges::count_if(indices, [](
+			const auto &list) {
+		return !list.empty();
+	}));
+	if (!gather->left) {
+		if (gather->done) {
+			gather->done(std::move(gather->values));
+		}
+		return;
+	}
+	for (auto i = size_type(0); i != _shards->size(); ++i) {
+		if (indices[i].empty()) {
+			continue;
+		}
+		auto request = std::vector<Key>();
+		request.reserve(indices[i].size());
+		for (const auto index : indices[i]) {
+			request.push_back(keys[index]);
+		}
+		(*_shards)[i]->with([
+			gather,
+			list = std::move(indices[i]),
+			request = std::move(request)
+		](Implementation &unwrapped) {
+			unwrapped.getMany(request, [&](
+					std::vector<TaggedValue> &&values) {
+				QMutexLocker lock(&gather->mutex);
+				for (auto k = 0, count = int(list.size()); k != count; ++k) {
+					gather->values[list[k]] = std::move(values[k]);
+				}
+				if (!--gather->left && gather->done) {
+					gather->done(std::move(gather->values));
+				}
+			});
+		});
+	}
+}
+
 void Database::getWithSizes(
 		const Key &key,
 		std::vector<Key> &&keys,
 		FnMut<void(QByteArray&&, std::vector<int>&&)> &&done) {
-	_wrapped.with([
-		key,
-		keys = std::move(keys),
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.getWithSizes(key, std::move(keys), std::move(done));
-	});
+	if (_shards->size() == 1) {
+		_shards->front()->with([
+			key,
+			keys = std::move(keys),
+			done = std::move(done)
+		](Implementation &unwrapped) mutable {
+			unwrapped.getWithSizes(key, std::move(keys), std::move(done));
+		});
+		return;
+	}
+
+	// Sizes of the keys living in other shards are gathered in parallel.
+	struct Gather {
+		QMutex mutex;
+		size_type left = 0;
+		QByteArray value;
+		std::vector<int> sizes;
+		FnMut<void(QByteArray&&, std::vector<int>&&)> done;
+	};
+	const auto main = shardIndex(key);
+	auto indices = std::vector<std::vector<int>>(_shards->size());
+	for (auto i = 0, count = int(keys.size()); i != count; ++i) {
+		indices[shardIndex(keys[i])].push_back(i);
+	}
+	const auto gather = std::make_shared<Gather>();
+	gather->sizes.resize(keys.size());
+	gather->done = std::move(done);
+	for (auto i = size_type(0); i != _shards->size(); ++i) {
+		if (i == main || !indices[i].empty()) {
+			++gather->left;
+		}
+	}
+	const auto finish = [=] {
+		if (--gather->left) {
+			return;
+		}
+		auto value = std::move(gather->value);
+		auto sizes = value.isEmpty()
+			? std::vector<int>()
+			: std::move(gather->sizes);
+		if (gather->done) {
+			gather->done(std::move(value), std::move(sizes));
+		}
+	};
+	const auto shared = std::make_shared<std::vector<Key>>(std::move(keys));
+	for (auto i = size_type(0); i != _shards->size(); ++i) {
+		if (i != main && indices[i].empty()) {
+			continue;
+		}
+		(*_shards)[i]->with([
+			=,
+			list = std::move(indices[i]),
+			withValue = (i == main)
+		](Implementation &unwrapped) {
+			auto request = std::vector<Key>();
+			request.reserve(list.size());
+			for (const auto index : list) {
+				request.push_back((*shared)[index]);
+			}
+			const auto found = unwrapped.getManyRaw(request);
+			auto value = QByteArray();
+			if (withValue) {
+				unwrapped.get(key, [&](TaggedValue &&result) {
+					value = std::move(result.bytes);
+				});
+			}
+			QMutexLocker lock(&gather->mutex);
+			auto j = begin(found);
+			for (auto k = 0, count = int(list.size()); k != count; ++k) {
+				if (j != end(found) && j->first == request[k]) {
+					gather->sizes[list[k]] = int(j->second.size);
+					++j;
+				}
+			}
+			if (withValue) {
+				gather->value = std::move(value);
+			}
+			finish();
+		});
+	}
 }
 
 auto Database::statsOnMain() const -> rpl::producer<Stats> {
-	return _wrapped.producer_on_main([](const Implementation &unwrapped) {
-		return unwrapped.stats();
-	});
+	auto list = std::vector<rpl::producer<Stats>>();
+	list.reserve(_shards->size());
+	for (const auto &shard : *_shards) {
+		list.push_back(shard->producer_on_main([](
+				const Implementation &unwrapped) {
+			return unwrapped.stats();
+		}));
+	}
+	if (list.size() == 1) {
+		return std::move(list.front());
+	}
+	return rpl::combine(std::move(list), MergeStats);
 }
 
 void Database::clear(FnMut<void(Error)> &&done) {
-	_wrapped.with([
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.clear(std::move(done));
-	});
+	const auto gather = PrepareGather(_shards->size(), std::move(done));
+	for (const auto &shard : *_shards) {
+		shard->with([
+			done = GatherPart(gather)
+		](Implementation &unwrapped) mutable {
+			unwrapped.clear(std::move(done));
+		});
+	}
 }
 
 void Database::clearByTag(uint8 tag, FnMut<void(Error)> &&done) {
-	_wrapped.with([
-		tag,
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.clearByTag(tag, std::move(done));
-	});
+	const auto gather = PrepareGather(_shards->size(), std::move(done));
+	for (const auto &shard : *_shards) {
+		shard->with([
+			tag,
+			done = GatherPart(gather)
+		](Implementation &unwrapped) mutable {
+			unwrapped.clearByTag(tag, std::move(done));
+		});
+	}
 }
 
 void Database::sync() {
-	auto semaphore = crl::semaphore();
-	_wrapped.with([&](Implementation &) {
-		semaphore.release();
-	});
-	semaphore.acquire();
+	for (const auto &shard : *_shards) {
+		auto semaphore = crl::semaphore();
+		shard->with([&](Implementation &) {
+			semaphore.release();
+		});
+		semaphore.acquire();
+	}
 }
 
 Database::~Database() = default;
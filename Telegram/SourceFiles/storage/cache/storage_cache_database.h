@@ -19,12 +19,14 @@ class EncryptionKey;
 namespace Cache {
 namespace details {
 class DatabaseObject;
+class KeysFilter;
 } // namespace details
 
 class Database {
 public:
 	using Settings = details::Settings;
 	using SettingsUpdate = details::SettingsUpdate;
+	using EvictionPolicy = details::EvictionPolicy;
 	Database(const QString &path, const Settings &settings);
 
 	void reconfigure(const Settings &settings);
@@ -64,11 +66,22 @@ public:
 		FnMut<void(Error)> &&done = nullptr);
 	void getWithTag(const Key &key, FnMut<void(TaggedValue&&)> &&done);
 
+	// Results are in the same order as keys, empty values for misses.
+	void getMany(
+		std::vector<Key> &&keys,
+		FnMut<void(std::vector<QByteArray>&&)> &&done);
+	void getManyWithTag(
+		std::vector<Key> &&keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done);
+
 	void getWithSizes(
 		const Key &key,
 		std::vector<Key> &&keys,
 		FnMut<void(QByteArray&&, std::vector<int>&&)> &&done);
 
+	// Can be called from any thread, false means a definite miss.
+	[[nodiscard]] bool mayContain(const Key &key) const;
+
 	using Stats = details::Stats;
 	using TaggedSummary = details::TaggedSummary;
 	rpl::producer<Stats> statsOnMain() const;
@@ -83,7 +96,24 @@ public:
 
 private:
 	using Implementation = details::DatabaseObject;
-	crl::object_on_queue<Implementation> _wrapped;
+	using Wrapped = crl::object_on_queue<Implementation>;
+	using Shards = std::vector<std::unique_ptr<Wrapped>>;
+
+	[[nodiscard]] size_type shardIndex(const Key &key) const;
+	[[nodiscard]] Wrapped &shard(const Key &key) const;
+	void remember(const Key &key);
+	template <typename Method>
+	void withAll(Method &&method);
+
+	void copyBetweenShards(
+		const Key &from,
+		const Key &to,
+		bool removeSource,
+		FnMut<void(Error)> &&done);
+
+	std::shared_ptr<Shards> _shards;
+	std::vector<std::shared_ptr<details::KeysFilter>> _filters;
+	size_type _maxDataSize = 0;
 
 };
 
@@ -0,0 +1,91 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "base/benchmark.h"
+
+#include "storage/cache/storage_cache_database.h"
+#include "storage/storage_encryption.h"
+#include <crl/crl.h>
+
+namespace {
+
+using namespace Storage::Cache;
+
+constexpr auto kValueSize = 4096;
+constexpr auto kKeysCount = 256;
+
+const auto name = QString("benchmark.db");
+
+crl::semaphore Semaphore;
+
+Storage::EncryptionKey DatabaseKey() {
+	return Storage::EncryptionKey(bytes::make_vector(
+		bytes::make_span("\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+").subspan(0, Storage::EncryptionKey::kSize)));
+}
+
+Database::Settings Settings() {
+	auto result = Database::Settings();
+	result.trackEstimatedTime = false;
+	return result;
+}
+
+// The database is opened and closed in each run, that is included.
+template <typename Callback>
+void WithDatabase(Callback &&callback) {
+	Database db(name, Settings());
+	db.open(DatabaseKey(), [](Error) { Semaphore.release(); });
+	Semaphore.acquire();
+	db.clear([](Error) { Semaphore.release(); });
+	Semaphore.acquire();
+
+	callback(db);
+
+	db.close([] { Semaphore.release(); });
+	Semaphore.acquire();
+}
+
+void Put(Database &db, int index) {
+	db.put(
+		Storage::Cache::Key{ uint64(index % kKeysCount), 1 },
+		QByteArray(kValueSize, char(index)),
+		[](Error) { Semaphore.release(); });
+	Semaphore.acquire();
+}
+
+} // namespace
+
+BENCHMARK("Storage::Cache::Database put 4KB") {
+	WithDatabase([&](Database &db) {
+		for (auto i = 0; i != iterations; ++i) {
+			Put(db, i);
+		}
+	});
+}
+
+BENCHMARK("Storage::Cache::Database get 4KB") {
+	WithDatabase([&](Database &db) {
+		for (auto i = 0; i != kKeysCount; ++i) {
+			Put(db, i);
+		}
+		auto size = int64();
+		for (auto i = 0; i != iterations; ++i) {
+			db.get(
+				Storage::Cache::Key{ uint64(i % kKeysCount), 1 },
+				[&](QByteArray &&value) {
+					size += value.size();
+					Semaphore.release();
+				});
+			Semaphore.acquire();
+		}
+		base::benchmark::Consume(size);
+	});
+}
@@ -10,14 +10,15 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/cache/storage_cache_cleaner.h"
 #include "storage/cache/storage_cache_compactor.h"
 #include "storage/cache/storage_cache_binlog_reader.h"
+#include "storage/cache/storage_cache_keys_filter.h"
 #include "storage/storage_encryption.h"
 #include "storage/storage_encrypted_file.h"
 #include "base/flat_map.h"
 #include "base/algorithm.h"
 #include <crl/crl.h>
 #include <xxhash.h>
+#include <lz4.h>
 #include <QtCore/QDir>
-#include <unordered_map>
 #include <set>
 
 namespace Storage {
@@ -32,6 +33,60 @@ uint32 CountChecksum(bytes::const_span data) {
 	return XXH32(data.data(), data.size(), seed);
 }
 
+struct CompressedHeader {
+	static constexpr auto kMagic = uint32(0x43345A4CU); // LZ4C
+
+	uint32 magic = kMagic;
+	uint32 size = 0;
+};
+
+QByteArray CompressValue(const QByteArray &value) {
+	constexpr auto kHeaderSize = int(sizeof(CompressedHeader));
+	const auto size = value.size();
+	const auto bound = LZ4_compressBound(size);
+	if (!bound) {
+		return QByteArray();
+	}
+	auto result = QByteArray(kHeaderSize + bound, Qt::Uninitialized);
+	const auto compressed = LZ4_compress_default(
+		value.constData(),
+		result.data() + kHeaderSize,
+		size,
+		bound);
+	if (compressed <= 0 || kHeaderSize + compressed >= size) {
+		return QByteArray();
+	}
+	result.resize(kHeaderSize + compressed);
+	auto header = CompressedHeader();
+	header.size = uint32(size);
+	memcpy(result.data(), &header, kHeaderSize);
+	return result;
+}
+
+QByteArray DecompressValue(QByteArray &&value) {
+	constexpr auto kHeaderSize = int(sizeof(CompressedHeader));
+	auto header = CompressedHeader();
+	if (value.size() <= kHeaderSize) {
+		return std::move(value);
+	}
+	memcpy(&header, value.constData(), kHeaderSize);
+	if (header.magic != CompressedHeader::kMagic
+		|| !header.size
+		|| header.size >= uint32(kDataSizeLimit)) {
+		return std::move(value);
+	}
+	auto result = QByteArray(int(header.size), Qt::Uninitialized);
+	const auto decompressed = LZ4_decompress_safe(
+		value.constData() + kHeaderSize,
+		result.data(),
+		value.size() - kHeaderSize,
+		result.size());
+	if (decompressed != result.size()) {
+		return std::move(value);
+	}
+	return result;
+}
+
 QString PlaceFromId(PlaceId place) {
 	auto result = QString();
 	result.reserve(15);
@@ -54,6 +109,16 @@ QString PlaceFromId(PlaceId place) {
 	return result;
 }
 
+constexpr auto kEvictionMaxHits = uint32(1024);
+constexpr auto kEvictionHitBonus = uint64(60 * 60); // One hour in seconds.
+constexpr auto kEvictionReferenceSize = uint64(64 * 1024);
+
+void CountHit(uint32 &hits) {
+	if (hits < std::numeric_limits<uint32>::max()) {
+		++hits;
+	}
+}
+
 int32 GetUnixtime() {
 	return std::max(int32(time(nullptr)), 1);
 }
@@ -66,8 +131,8 @@ DatabaseObject::Entry::Entry(
 	uint32 checksum,
 	size_type size,
 	uint64 useTime)
-: useTime(useTime)
-, size(size)
+: useTime(uint32(useTime))
+, size(int32(size))
 , checksum(checksum)
 , place(place)
 , tag(tag) {
@@ -76,12 +141,15 @@ DatabaseObject::Entry::Entry(
 DatabaseObject::DatabaseObject(
 	crl::weak_on_queue<DatabaseObject> weak,
 	const QString &path,
-	const Settings &settings)
+	const Settings &settings,
+	std::shared_ptr<KeysFilter> filter)
 : _weak(std::move(weak))
 , _base(ComputeBasePath(path))
 , _settings(settings)
+, _filter(std::move(filter))
 , _writeBundlesTimer(_weak, [=] { writeBundles(); checkCompactor(); })
-, _pruneTimer(_weak, [=] { prune(); }) {
+, _pruneTimer(_weak, [=] { prune(); })
+, _groupTimer(_weak, [=] { writeGroup(); }) {
 	checkSettings();
 }
 
@@ -128,10 +196,13 @@ Error DatabaseObject::ioError(const QString &path) const {
 void DatabaseObject::open(EncryptionKey &&key, FnMut<void(Error)> &&done) {
 	close(nullptr);
 
+	const auto start = crl::now();
 	const auto error = openSomeBinlog(std::move(key));
 	if (error.type != Error::Type::None) {
 		close(nullptr);
 	}
+	_openDuration = crl::now() - start;
+	pushStatsDelayed();
 	invokeCallback(done, error);
 }
 
@@ -214,6 +285,7 @@ File::Result DatabaseObject::openBinlog(
 	_key = std::move(key);
 	createCleaner();
 	readBinlog();
+	rebuildFilter();
 	return File::Result::Success;
 }
 
@@ -232,6 +304,9 @@ bool DatabaseObject::writeHeader() {
 	if (_settings.trackEstimatedTime) {
 		header.flags |= header.kTrackEstimatedTime;
 	}
+	if (_settings.tagPlaceDirectories) {
+		header.flags |= header.kTagPlaceDirectories;
+	}
 	return _binlog.write(bytes::object_as_span(&header));
 }
 
@@ -249,13 +324,20 @@ void DatabaseObject::readBinlogHelper(
 }
 
 void DatabaseObject::readBinlog() {
+	// Each entry takes at least one store record, so that is enough.
+	const auto recordSize = _settings.trackEstimatedTime
+		? sizeof(StoreWithTime)
+		: sizeof(Store);
+	_map.reserve(size_type(_binlog.size() / recordSize));
+
 	BinlogWrapper wrapper(_binlog, _settings);
 	if (_settings.trackEstimatedTime) {
 		BinlogReader<
 			StoreWithTime,
 			MultiStoreWithTime,
 			MultiRemove,
-			MultiAccess> reader(wrapper);
+			MultiAccess,
+			RemoveTag> reader(wrapper);
 		readBinlogHelper(reader, [&](const StoreWithTime &record) {
 			return processRecordStore(
 				&record,
@@ -266,20 +348,26 @@ void DatabaseObject::readBinlog() {
 			return processRecordMultiRemove(header, element);
 		}, [&](const MultiAccess &header, const auto &element) {
 			return processRecordMultiAccess(header, element);
+		}, [&](const RemoveTag &record) {
+			return processRecordRemoveTag(record);
 		});
 	} else {
 		BinlogReader<
 			Store,
 			MultiStore,
-			MultiRemove> reader(wrapper);
+			MultiRemove,
+			RemoveTag> reader(wrapper);
 		readBinlogHelper(reader, [&](const Store &record) {
 			return processRecordStore(&record, std::is_class<Store>{});
 		}, [&](const MultiStore &header, const auto &element) {
 			return processRecordMultiStore(header, element);
 		}, [&](const MultiRemove &header, const auto &element) {
 			return processRecordMultiRemove(header, element);
+		}, [&](const RemoveTag &record) {
+			return processRecordRemoveTag(record);
 		});
 	}
+	_map.shrink_to_fit();
 	adjustRelativeTime();
 	optimize();
 }
@@ -298,11 +386,27 @@ uint64 DatabaseObject::pruneBeforeTime() const {
 }
 
 void DatabaseObject::optimize() {
+	checkFilter();
 	if (!startDelayedPruning()) {
 		checkCompactor();
 	}
 }
 
+void DatabaseObject::checkFilter() {
+	if (_filter->stale(_map.size())) {
+		rebuildFilter();
+	}
+}
+
+void DatabaseObject::rebuildFilter() {
+	_filter->startRebuild();
+	auto builder = KeysFilter::Builder(_map.size());
+	for (const auto &[key, entry] : _map) {
+		builder.add(key);
+	}
+	_filter->finishRebuild(std::move(builder));
+}
+
 bool DatabaseObject::startDelayedPruning() {
 	if (!_settings.trackEstimatedTime || _map.empty()) {
 		return false;
@@ -443,18 +547,18 @@ void DatabaseObject::collectSizeStale(
 		return;
 	}
 
-	using Bucket = std::pair<const Key, Entry>;
+	using Bucket = Map::value_type;
 	auto oldest = base::flat_multi_map<
-		int64,
+		uint64,
 		const Bucket*,
 		std::greater<>>();
 	auto oldestTotalSize = int64();
 
-	const auto canRemoveFirst = [&](const Entry &adding) {
-		const auto totalSizeAfterAdd = oldestTotalSize + adding.size;
-		const auto &first = oldest.begin()->second->second;
-		return (adding.useTime <= first.useTime
-			&& (totalSizeAfterAdd - removeSize >= first.size));
+	const auto canRemoveFirst = [&](uint64 adding, size_type size) {
+		const auto totalSizeAfterAdd = oldestTotalSize + size;
+		const auto &[priority, first] = *oldest.begin();
+		return (adding <= priority
+			&& (totalSizeAfterAdd - removeSize >= first->second.size));
 	};
 
 	for (const auto &bucket : _map) {
@@ -462,18 +566,19 @@ void DatabaseObject::collectSizeStale(
 		if (stale.contains(bucket.first)) {
 			continue;
 		}
+		const auto priority = evictionPriority(entry);
 		const auto add = (oldestTotalSize < removeSize)
 			? true
-			: (entry.useTime < oldest.begin()->second->second.useTime);
+			: (priority < oldest.begin()->first);
 		if (!add) {
 			continue;
 		}
-		while (!oldest.empty() && canRemoveFirst(entry)) {
+		while (!oldest.empty() && canRemoveFirst(priority, entry.size)) {
 			oldestTotalSize -= oldest.begin()->second->second.size;
 			oldest.erase(oldest.begin());
 		}
 		oldestTotalSize += entry.size;
-		oldest.emplace(entry.useTime, &bucket);
+		oldest.emplace(priority, &bucket);
 	}
 
 	for (const auto &pair : oldest) {
@@ -482,6 +587,29 @@ void DatabaseObject::collectSizeStale(
 	staleTotalSize += oldestTotalSize;
 }
 
+uint64 DatabaseObject::evictionPriority(const Entry &entry) const {
+	// Priority is measured in relative seconds, like useTime, so that
+	// entries with different policies compete for the same space.
+	const auto i = _settings.evictionPolicies.find(entry.tag);
+	const auto policy = (i != end(_settings.evictionPolicies))
+		? i->second
+		: EvictionPolicy::LeastRecentlyUsed;
+	const auto hits = uint64(std::min(entry.hits, kEvictionMaxHits));
+	switch (policy) {
+	case EvictionPolicy::LeastRecentlyUsed:
+		return entry.useTime;
+	case EvictionPolicy::LeastFrequentlyUsed:
+		return entry.useTime + hits * kEvictionHitBonus;
+	case EvictionPolicy::SizeAware: {
+		// Like GDSF: frequently used small entries are kept longer.
+		const auto size = uint64(std::max(entry.size, int32(1)));
+		return entry.useTime
+			+ (hits * kEvictionHitBonus * kEvictionReferenceSize) / size;
+	}
+	}
+	Unexpected("Policy in DatabaseObject::evictionPriority.");
+}
+
 void DatabaseObject::adjustRelativeTime() {
 	if (!_settings.trackEstimatedTime) {
 		return;
@@ -527,7 +655,8 @@ bool DatabaseObject::processRecordStore(
 			Entry &entry,
 			not_null<const StoreWithTime*> record) {
 		applyTimePoint(record->time);
-		entry.useTime = record->time.getRelative();
+		entry.useTime = uint32(record->time.getRelative());
+		entry.hits = record->hits;
 		return true;
 	};
 	return processRecordStoreGeneric(record, postprocess);
@@ -574,13 +703,21 @@ bool DatabaseObject::processRecordMultiAccess(
 	while (const auto entry = element()) {
 		_binlogExcessLength += sizeof(*entry);
 		if (const auto i = _map.find(*entry); i != end(_map)) {
-			i->second.useTime = relative;
+			i->second.useTime = uint32(relative);
+			CountHit(i->second.hits);
 		}
 	}
 	return true;
 }
 
+bool DatabaseObject::processRecordRemoveTag(const RemoveTag &record) {
+	_binlogExcessLength += sizeof(record);
+	eraseMapEntriesByTag(record.tag);
+	return true;
+}
+
 void DatabaseObject::setMapEntry(const Key &key, Entry &&entry) {
+	_filter->add(key);
 	auto &already = _map[key];
 	updateStats(already, entry);
 	if (already.size != 0) {
@@ -651,6 +788,7 @@ void DatabaseObject::eraseMapEntry(const Map::const_iterator &i) {
 	if (i != end(_map)) {
 		const auto &entry = i->second;
 		updateStats(entry, Entry());
+		_filter->removed();
 		if (_minimalEntryTime != 0 && entry.useTime == _minimalEntryTime) {
 			Assert(_entriesWithMinimalTimeCount > 0);
 			if (!--_entriesWithMinimalTimeCount) {
@@ -661,6 +799,19 @@ void DatabaseObject::eraseMapEntry(const Map::const_iterator &i) {
 	}
 }
 
+void DatabaseObject::eraseMapEntriesByTag(uint8 tag) {
+	// Erasing invalidates the map iterators, so collect the keys first.
+	auto keys = std::vector<Key>();
+	for (const auto &[key, entry] : _map) {
+		if (entry.tag == tag) {
+			keys.push_back(key);
+		}
+	}
+	for (const auto &key : keys) {
+		eraseMapEntry(_map.find(key));
+	}
+}
+
 EstimatedTimePoint DatabaseObject::countTimePoint() const {
 	const auto now = GetUnixtime();
 	const auto delta = std::max(int64(now) - int64(_time.system), 0LL);
@@ -719,6 +870,7 @@ void DatabaseObject::compactorDone(
 	}
 	_binlogExcessLength -= _compactor.excessLength;
 	Assert(_binlogExcessLength >= 0);
+	pushStatsDelayed();
 }
 
 void DatabaseObject::compactorFail() {
@@ -729,6 +881,14 @@ void DatabaseObject::compactorFail() {
 		delay * 2,
 		kMaxDelayAfterFailure);
 	QFile(compactReadyPath()).remove();
+	pushStatsDelayed();
+}
+
+void DatabaseObject::compactorProgress(int64 readTill) {
+	if (_compactor.object) {
+		_compactor.readTill = readTill;
+		pushStatsDelayed();
+	}
 }
 
 void DatabaseObject::close(FnMut<void()> &&done) {
@@ -756,7 +916,10 @@ void DatabaseObject::clearState() {
 	_pushingStats = false;
 	_writeBundlesTimer.cancel();
 	_pruneTimer.cancel();
+	_groupTimer.cancel();
+	_group = GroupCommit();
 	_compactor = CompactorWrap();
+	_filter->reset();
 }
 
 void DatabaseObject::put(
@@ -770,6 +933,12 @@ void DatabaseObject::put(
 	_removing.erase(key);
 	_stale.erase(ranges::remove(_stale, key), end(_stale));
 
+	if (_settings.compressTags.contains(value.tag)) {
+		auto compressed = CompressValue(value.bytes);
+		if (!compressed.isEmpty()) {
+			value.bytes = std::move(compressed);
+		}
+	}
 	const auto checksum = CountChecksum(bytes::make_span(value.bytes));
 	const auto maybepath = writeKeyPlace(key, value, checksum);
 	if (!maybepath) {
@@ -804,7 +973,11 @@ void DatabaseObject::put(
 			invokeCallback(done, ioError(path));
 		} else {
 			data.flush();
-			invokeCallback(done, Error::NoError());
+			if (_group.records.empty()) {
+				invokeCallback(done, Error::NoError());
+			} else if (done) {
+				_group.callbacks.push_back(std::move(done));
+			}
 			optimize();
 		}
 	} break;
@@ -826,28 +999,46 @@ std::optional<QString> DatabaseObject::writeKeyPlaceGeneric(
 	record.key = key;
 	record.setSize(size);
 	record.checksum = checksum;
+	auto reusePlace = false;
 	if (const auto i = _map.find(key); i != end(_map)) {
 		const auto &already = i->second;
 		if (already.tag == record.tag
 			&& already.size == size
 			&& already.checksum == checksum
-			&& readValueData(already.place, size) == value.bytes) {
+			&& readValueData(already.tag, already.place, size)
+				== value.bytes) {
 			return QString();
 		}
-		record.place = already.place;
-	} else {
+		using Record = std::decay_t<StoreRecord>;
+		if constexpr (std::is_same_v<Record, StoreWithTime>) {
+			record.hits = already.hits;
+		}
+		if (already.tag == record.tag || !_settings.tagPlaceDirectories) {
+			record.place = already.place;
+			reusePlace = true;
+		} else {
+			// The value with a new tag goes to the new tag directory.
+			QFile(placePath(already.tag, already.place)).remove();
+		}
+	}
+	if (!reusePlace) {
 		do {
 			bytes::set_random(bytes::object_as_span(&record.place));
-		} while (!isFreePlace(record.place));
+		} while (!isFreePlace(record.tag, record.place));
 	}
-	const auto result = placePath(record.place);
-	auto writeable = record;
-	const auto success = _binlog.write(bytes::object_as_span(&writeable));
-	if (!success) {
-		_binlog.close();
-		return QString();
+	const auto result = placePath(record.tag, record.place);
+	if (_settings.groupCommitDelay > 0) {
+		groupStoreRecord(record);
+	} else {
+		auto writeable = record;
+		const auto success = _binlog.write(
+			bytes::object_as_span(&writeable));
+		if (!success) {
+			_binlog.close();
+			return QString();
+		}
+		flushBinlog();
 	}
-	_binlog.flush();
 
 	const auto applied = processRecordStore(
 		&record,
@@ -882,6 +1073,9 @@ Error DatabaseObject::writeExistingPlaceGeneric(
 		StoreRecord &&record,
 		const Key &key,
 		const Entry &entry) {
+	if (const auto error = writeGroup(); error.type != Error::Type::None) {
+		return error;
+	}
 	record.key = key;
 	record.tag = entry.tag;
 	record.setSize(entry.size);
@@ -891,19 +1085,23 @@ Error DatabaseObject::writeExistingPlaceGeneric(
 		if (already.tag == record.tag
 			&& already.size == entry.size
 			&& already.checksum == entry.checksum
-			&& (readValueData(already.place, already.size)
-				== readValueData(entry.place, entry.size))) {
+			&& (readValueData(already.tag, already.place, already.size)
+				== readValueData(entry.tag, entry.place, entry.size))) {
 			return Error::NoError();
 		}
 	}
 	record.place = entry.place;
+	using Record = std::decay_t<StoreRecord>;
+	if constexpr (std::is_same_v<Record, StoreWithTime>) {
+		record.hits = entry.hits;
+	}
 	auto writeable = record;
 	const auto success = _binlog.write(bytes::object_as_span(&writeable));
 	if (!success) {
 		_binlog.close();
 		return ioError(binlogPath());
 	}
-	_binlog.flush();
+	flushBinlog();
 
 	const auto applied = processRecordStore(
 		&record,
@@ -942,19 +1140,56 @@ void DatabaseObject::get(
 	}
 	const auto &entry = i->second;
 
-	auto bytes = readValueData(entry.place, entry.size);
+	auto bytes = readValue(entry);
 	if (bytes.isEmpty()) {
 		remove(key, nullptr);
 		invokeCallback(done, TaggedValue());
-	} else if (CountChecksum(bytes::make_span(bytes)) != entry.checksum) {
-		remove(key, nullptr);
-		invokeCallback(done, TaggedValue());
 	} else {
 		invokeCallback(done, TaggedValue(std::move(bytes), entry.tag));
 		recordEntryAccess(key);
 	}
 }
 
+void DatabaseObject::getMany(
+		const std::vector<Key> &keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done) {
+	using Found = std::pair<int, const Entry*>;
+	auto found = std::vector<Found>();
+	found.reserve(keys.size());
+	for (auto i = 0, count = int(keys.size()); i != count; ++i) {
+		if (const auto j = _map.find(keys[i]); j != end(_map)) {
+			found.emplace_back(i, &j->second);
+		}
+	}
+
+	// Read values ordered by place, so that the files from the same
+	// directory are accessed one after another.
+	ranges::sort(found, std::less<>(), [](const Found &value) {
+		return value.second->place;
+	});
+
+	auto result = std::vector<TaggedValue>(keys.size());
+	auto accessed = std::vector<Key>();
+	auto failed = std::vector<Key>();
+	accessed.reserve(found.size());
+	for (const auto &[index, entry] : found) {
+		auto bytes = readValue(*entry);
+		if (bytes.isEmpty()) {
+			failed.push_back(keys[index]);
+		} else {
+			result[index] = TaggedValue(std::move(bytes), entry->tag);
+			accessed.push_back(keys[index]);
+		}
+	}
+	for (const auto &key : failed) {
+		remove(key, nullptr);
+	}
+	invokeCallback(done, std::move(result));
+	for (const auto &key : accessed) {
+		recordEntryAccess(key);
+	}
+}
+
 void DatabaseObject::getWithSizes(
 		const Key &key,
 		std::vector<Key> &&keys,
@@ -975,9 +1210,10 @@ void DatabaseObject::getWithSizes(
 }
 
 QByteArray DatabaseObject::readValueData(
+		uint8 tag,
 		PlaceId place,
 		size_type size) const {
-	const auto path = placePath(place);
+	const auto path = placePath(tag, place);
 	File data;
 	const auto result = data.open(path, File::Mode::Read, _key);
 	switch (result) {
@@ -986,7 +1222,9 @@ QByteArray DatabaseObject::readValueData(
 	case File::Result::Success: {
 		auto result = QByteArray(size, Qt::Uninitialized);
 		const auto bytes = bytes::make_detached_span(result);
-		const auto read = data.readWithPadding(bytes);
+		const auto read = _settings.mapPlaceFiles
+			? data.readWithPaddingMapped(bytes)
+			: data.readWithPadding(bytes);
 		if (read != size) {
 			return QByteArray();
 		}
@@ -996,6 +1234,15 @@ QByteArray DatabaseObject::readValueData(
 	Unexpected("Result in DatabaseObject::get.");
 }
 
+QByteArray DatabaseObject::readValue(const Entry &entry) const {
+	auto result = readValueData(entry.tag, entry.place, entry.size);
+	if (!result.isEmpty()
+		&& CountChecksum(bytes::make_span(result)) != entry.checksum) {
+		return QByteArray();
+	}
+	return DecompressValue(std::move(result));
+}
+
 void DatabaseObject::recordEntryAccess(const Key &key) {
 	if (!_settings.trackEstimatedTime) {
 		return;
@@ -1011,7 +1258,7 @@ void DatabaseObject::remove(const Key &key, FnMut<void(Error)> &&done) {
 		_removing.emplace(key);
 		writeMultiRemoveLazy();
 
-		const auto path = placePath(i->second.place);
+		const auto path = placePath(i->second.tag, i->second.place);
 		eraseMapEntry(i);
 		if (QFile(path).remove() || !QFile(path).exists()) {
 			invokeCallback(done, Error::NoError());
@@ -1084,6 +1331,15 @@ Stats DatabaseObject::collectStats() const {
 	result.tagged = _taggedStats;
 	result.full.count = _map.size();
 	result.full.totalSize = _totalSize;
+	result.binlogSize = _binlog.isOpen() ? _binlog.size() : 0;
+	result.binlogExcess = _binlogExcessLength;
+	result.openDuration = _openDuration;
+	result.binlogFlushes = _binlogFlushes;
+	result.commitBatches = _commitBatches;
+	if (_compactor.object) {
+		result.compactTill = _compactor.till;
+		result.compactReadTill = _compactor.readTill;
+	}
 	result.clearing = (_cleaner.object != nullptr) || !_stale.empty();
 	return result;
 }
@@ -1102,10 +1358,83 @@ void DatabaseObject::writeMultiRemoveLazy() {
 	}
 }
 
+template <typename StoreRecord>
+void DatabaseObject::groupStoreRecord(const StoreRecord &record) {
+	if (_group.records.size() == _settings.maxBundledRecords) {
+		writeGroup();
+	}
+	auto grouped = StoreWithTime();
+	if constexpr (std::is_same_v<StoreRecord, StoreWithTime>) {
+		grouped = record;
+	} else {
+		static_cast<Store&>(grouped) = record;
+	}
+	_group.records.push_back(grouped);
+	if (_group.records.size() == 1) {
+		_groupTimer.callOnce(_settings.groupCommitDelay);
+	}
+}
+
+template <typename MultiRecord>
+bool DatabaseObject::writeGroupRecords(
+		const std::vector<StoreWithTime> &records) {
+	using Part = typename MultiRecord::Part;
+
+	const auto size = size_type(records.size());
+	auto header = MultiRecord(size);
+	auto list = std::vector<Part>();
+	list.reserve(size);
+	for (const auto &record : records) {
+		list.push_back(static_cast<const Part&>(record));
+	}
+	if (_binlog.writeVectored({
+			bytes::object_as_span(&header),
+			bytes::make_span(list) })) {
+		flushBinlog();
+		return true;
+	}
+	_binlog.close();
+	return false;
+}
+
+Error DatabaseObject::writeGroup() {
+	if (_group.records.empty()) {
+		return Error::NoError();
+	}
+	_groupTimer.cancel();
+	auto group = base::take(_group);
+	const auto written = _settings.trackEstimatedTime
+		? writeGroupRecords<MultiStoreWithTime>(group.records)
+		: writeGroupRecords<MultiStore>(group.records);
+	countGroupBatch(group.records.size());
+	const auto error = written ? Error::NoError() : ioError(binlogPath());
+	for (auto &callback : group.callbacks) {
+		callback(error);
+	}
+	return error;
+}
+
+void DatabaseObject::countGroupBatch(size_type size) {
+	auto bucket = 0;
+	while (size > 1 && bucket + 1 != kCommitBatchBuckets) {
+		size /= 2;
+		++bucket;
+	}
+	++_commitBatches[bucket];
+	pushStatsDelayed();
+}
+
+void DatabaseObject::flushBinlog() {
+	_binlog.flush();
+	++_binlogFlushes;
+}
+
 Error DatabaseObject::writeMultiRemove() {
 	Expects(_removing.size() <= _settings.maxBundledRecords);
 
-	if (_removing.empty()) {
+	if (const auto error = writeGroup(); error.type != Error::Type::None) {
+		return error;
+	} else if (_removing.empty()) {
 		return Error::NoError();
 	}
 	const auto size = _removing.size();
@@ -1115,9 +1444,10 @@ Error DatabaseObject::writeMultiRemove() {
 	for (const auto &key : base::take(_removing)) {
 		list.push_back(key);
 	}
-	if (_binlog.write(bytes::object_as_span(&header))
-		&& _binlog.write(bytes::make_span(list))) {
-		_binlog.flush();
+	if (_binlog.writeVectored({
+			bytes::object_as_span(&header),
+			bytes::make_span(list) })) {
+		flushBinlog();
 		_binlogExcessLength += bytes::object_as_span(&header).size()
 			+ bytes::make_span(list).size();
 		return Error::NoError();
@@ -1126,6 +1456,20 @@ Error DatabaseObject::writeMultiRemove() {
 	return ioError(binlogPath());
 }
 
+Error DatabaseObject::writeRemoveTag(uint8 tag) {
+	if (const auto error = writeMultiRemove(); error.type != Error::Type::None) {
+		return error;
+	}
+	auto record = RemoveTag(tag);
+	if (_binlog.write(bytes::object_as_span(&record))) {
+		flushBinlog();
+		_binlogExcessLength += sizeof(record);
+		return Error::NoError();
+	}
+	_binlog.close();
+	return ioError(binlogPath());
+}
+
 void DatabaseObject::writeMultiAccessLazy() {
 	if (_accessed.size() == _settings.maxBundledRecords) {
 		writeMultiAccess();
@@ -1145,6 +1489,9 @@ Error DatabaseObject::writeMultiAccessBlock() {
 	Expects(_settings.trackEstimatedTime);
 	Expects(_accessed.size() <= _settings.maxBundledRecords);
 
+	if (const auto error = writeGroup(); error.type != Error::Type::None) {
+		return error;
+	}
 	const auto time = countTimePoint();
 	const auto size = _accessed.size();
 	auto header = MultiAccess(time, size);
@@ -1158,13 +1505,15 @@ Error DatabaseObject::writeMultiAccessBlock() {
 	_time = time;
 	for (const auto &entry : list) {
 		if (const auto i = _map.find(entry); i != end(_map)) {
-			i->second.useTime = _time.getRelative();
+			i->second.useTime = uint32(_time.getRelative());
+			CountHit(i->second.hits);
 		}
 	}
 
-	if (_binlog.write(bytes::object_as_span(&header))
-		&& (!size || _binlog.write(bytes::make_span(list)))) {
-		_binlog.flush();
+	if (_binlog.writeVectored({
+			bytes::object_as_span(&header),
+			bytes::make_span(list) })) {
+		flushBinlog();
 		_binlogExcessLength += bytes::object_as_span(&header).size()
 			+ bytes::make_span(list).size();
 		return Error::NoError();
@@ -1194,6 +1543,14 @@ void DatabaseObject::createCleaner() {
 }
 
 void DatabaseObject::cleanerDone(Error error) {
+	if (_cleaner.again) {
+		// Some directories were added while the cleaner was working.
+		auto done = std::move(_cleaner.done);
+		_cleaner = CleanerWrap();
+		createCleaner();
+		_cleaner.done = std::move(done);
+		return;
+	}
 	invokeCallback(_cleaner.done);
 	_cleaner = CleanerWrap();
 	pushStatsDelayed();
@@ -1223,6 +1580,8 @@ void DatabaseObject::checkCompactor() {
 		base::duplicate(_key),
 		info);
 	_compactor.excessLength = _binlogExcessLength;
+	_compactor.till = info.till;
+	pushStatsDelayed();
 }
 
 void DatabaseObject::clear(FnMut<void(Error)> &&done) {
@@ -1244,6 +1603,10 @@ void DatabaseObject::clear(FnMut<void(Error)> &&done) {
 }
 
 void DatabaseObject::clearByTag(uint8 tag, FnMut<void(Error)> &&done) {
+	if (_settings.tagPlaceDirectories) {
+		clearTagDirectory(tag, std::move(done));
+		return;
+	}
 	const auto hadStale = !_stale.empty();
 	for (const auto &[key, entry] : _map) {
 		if (entry.tag == tag) {
@@ -1256,6 +1619,36 @@ void DatabaseObject::clearByTag(uint8 tag, FnMut<void(Error)> &&done) {
 	invokeCallback(done, Error::NoError());
 }
 
+void DatabaseObject::clearTagDirectory(
+		uint8 tag,
+		FnMut<void(Error)> &&done) {
+	const auto error = writeRemoveTag(tag);
+	if (error.type != Error::Type::None) {
+		invokeCallback(done, error);
+		return;
+	}
+	eraseMapEntriesByTag(tag);
+	pushStats();
+
+	// The directory is moved out of the current version directory,
+	// so that the cleaner removes it like an old version in background.
+	const auto path = tagPath(tag);
+	if (QDir(path).exists()) {
+		const auto moved = _base + QString::number(findAvailableVersion());
+		if (!QDir().rename(path, moved)) {
+			if (!QDir(path).removeRecursively()) {
+				invokeCallback(done, ioError(path));
+				return;
+			}
+		} else if (_cleaner.object) {
+			_cleaner.again = true;
+		} else {
+			createCleaner();
+		}
+	}
+	invokeCallback(done, Error::NoError());
+}
+
 void DatabaseObject::waitForCleaner(FnMut<void()> &&done) {
 	while (!_stale.empty()) {
 		clearStaleChunk();
@@ -1315,12 +1708,19 @@ auto DatabaseObject::readVersion() const -> Version {
 	return Version();
 }
 
-QString DatabaseObject::placePath(PlaceId place) const {
-	return _path + PlaceFromId(place);
+QString DatabaseObject::tagPath(uint8 tag) const {
+	Expects(_settings.tagPlaceDirectories);
+
+	return _path + QString("tag%1/").arg(int(tag), 2, 16, QChar('0'));
+}
+
+QString DatabaseObject::placePath(uint8 tag, PlaceId place) const {
+	return (_settings.tagPlaceDirectories ? tagPath(tag) : _path)
+		+ PlaceFromId(place);
 }
 
-bool DatabaseObject::isFreePlace(PlaceId place) const {
-	return !QFile(placePath(place)).exists();
+bool DatabaseObject::isFreePlace(uint8 tag, PlaceId place) const {
+	return !QFile(placePath(tag, place)).exists();
 }
 
 } // namespace details
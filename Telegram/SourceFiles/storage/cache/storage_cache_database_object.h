@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "storage/cache/storage_cache_database.h"
+#include "storage/cache/storage_cache_keys_map.h"
 #include "storage/storage_encrypted_file.h"
 #include "base/binary_guard.h"
 #include "base/concurrent_timer.h"
@@ -22,6 +23,7 @@ namespace details {
 
 class Cleaner;
 class Compactor;
+class KeysFilter;
 
 class DatabaseObject {
 public:
@@ -29,7 +31,8 @@ public:
 	DatabaseObject(
 		crl::weak_on_queue<DatabaseObject> weak,
 		const QString &path,
-		const Settings &settings);
+		const Settings &settings,
+		std::shared_ptr<KeysFilter> filter);
 	void reconfigure(const Settings &settings);
 	void updateSettings(const SettingsUpdate &update);
 
@@ -60,6 +63,9 @@ public:
 		const Key &key,
 		std::vector<Key> &&keys,
 		FnMut<void(QByteArray&&, std::vector<int>&&)> &&done);
+	void getMany(
+		const std::vector<Key> &keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done);
 
 	rpl::producer<Stats> stats() const;
 
@@ -72,6 +78,7 @@ public:
 
 	void compactorDone(const QString &path, int64 originalReadTill);
 	void compactorFail();
+	void compactorProgress(int64 readTill);
 
 	struct Entry {
 		Entry() = default;
@@ -82,12 +89,15 @@ public:
 			size_type size,
 			uint64 useTime);
 
-		uint64 useTime = 0;
-		size_type size = 0;
+		// Relative time is in seconds and fits in 32 bits until 2106.
+		uint32 useTime = 0;
+		int32 size = 0;
 		uint32 checksum = 0;
+		uint32 hits = 0;
 		PlaceId place = { { 0 } };
 		uint8 tag = 0;
 	};
+	static_assert(sizeof(Entry) == 24);
 	using Raw = std::pair<Key, Entry>;
 	std::vector<Raw> getManyRaw(const std::vector<Key> &keys) const;
 
@@ -98,15 +108,22 @@ private:
 		std::unique_ptr<Cleaner> object;
 		base::binary_guard guard;
 		FnMut<void()> done;
+		bool again = false;
 	};
 	struct CompactorWrap {
 		std::unique_ptr<Compactor> object;
 		int64 excessLength = 0;
+		int64 till = 0;
+		int64 readTill = 0;
 		crl::time nextAttempt = 0;
 		crl::time delayAfterFailure = 10 * crl::time(1000);
 		base::binary_guard guard;
 	};
-	using Map = std::unordered_map<Key, Entry>;
+	using Map = KeysMap<Entry>;
+	struct GroupCommit {
+		std::vector<StoreWithTime> records;
+		std::vector<FnMut<void(Error)>> callbacks;
+	};
 
 	template <typename Callback, typename ...Args>
 	void invokeCallback(Callback &&callback, Args &&...args) const;
@@ -151,8 +168,11 @@ private:
 	bool processRecordMultiAccess(
 		const MultiAccess &header,
 		const GetElement &element);
+	bool processRecordRemoveTag(const RemoveTag &record);
 
 	void optimize();
+	void checkFilter();
+	void rebuildFilter();
 	void checkCompactor();
 	void adjustRelativeTime();
 	bool startDelayedPruning();
@@ -168,6 +188,7 @@ private:
 	void collectSizeStale(
 		base::flat_set<Key> &stale,
 		int64 &staleTotalSize);
+	uint64 evictionPriority(const Entry &entry) const;
 	void startStaleClear();
 	void clearStaleNow(const base::flat_set<Key> &stale);
 	void clearStaleChunkDelayed();
@@ -180,16 +201,22 @@ private:
 
 	void setMapEntry(const Key &key, Entry &&entry);
 	void eraseMapEntry(const Map::const_iterator &i);
+	void eraseMapEntriesByTag(uint8 tag);
 	void recordEntryAccess(const Key &key);
-	QByteArray readValueData(PlaceId place, size_type size) const;
+	QByteArray readValueData(
+		uint8 tag,
+		PlaceId place,
+		size_type size) const;
+	QByteArray readValue(const Entry &entry) const;
 
 	Version findAvailableVersion() const;
 	QString versionPath() const;
 	bool writeVersion(Version version);
 	Version readVersion() const;
 
-	QString placePath(PlaceId place) const;
-	bool isFreePlace(PlaceId place) const;
+	QString tagPath(uint8 tag) const;
+	QString placePath(uint8 tag, PlaceId place) const;
+	bool isFreePlace(uint8 tag, PlaceId place) const;
 
 	template <typename StoreRecord>
 	std::optional<QString> writeKeyPlaceGeneric(
@@ -209,14 +236,23 @@ private:
 	Error writeExistingPlace(
 		const Key &key,
 		const Entry &entry);
+	template <typename StoreRecord>
+	void groupStoreRecord(const StoreRecord &record);
+	template <typename MultiRecord>
+	bool writeGroupRecords(const std::vector<StoreWithTime> &records);
+	Error writeGroup();
+	void countGroupBatch(size_type size);
+	void flushBinlog();
 	void writeMultiRemoveLazy();
 	Error writeMultiRemove();
 	void writeMultiAccessLazy();
 	Error writeMultiAccess();
 	Error writeMultiAccessBlock();
+	Error writeRemoveTag(uint8 tag);
 	void writeBundlesLazy();
 	void writeBundles();
 
+	void clearTagDirectory(uint8 tag, FnMut<void(Error)> &&done);
 	void createCleaner();
 	void cleanerDone(Error error);
 	void clearState();
@@ -224,6 +260,7 @@ private:
 	crl::weak_on_queue<DatabaseObject> _weak;
 	QString _base, _path;
 	Settings _settings;
+	std::shared_ptr<KeysFilter> _filter;
 	EncryptionKey _key;
 	File _binlog;
 	Map _map;
@@ -233,6 +270,10 @@ private:
 
 	EstimatedTimePoint _time;
 
+	GroupCommit _group;
+	int64 _binlogFlushes = 0;
+	std::array<int64, kCommitBatchBuckets> _commitBatches = { { 0 } };
+	crl::time _openDuration = 0;
 	int64 _binlogExcessLength = 0;
 	int64 _totalSize = 0;
 	uint64 _minimalEntryTime = 0;
@@ -245,6 +286,7 @@ private:
 
 	base::ConcurrentTimer _writeBundlesTimer;
 	base::ConcurrentTimer _pruneTimer;
+	base::ConcurrentTimer _groupTimer;
 
 	CleanerWrap _cleaner;
 	CompactorWrap _compactor;
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "catch.hpp"
 
 #include "storage/cache/storage_cache_database.h"
+#include "storage/cache/storage_cache_database_object.h"
 #include "storage/storage_encryption.h"
 #include "storage/storage_encrypted_file.h"
 #include "base/concurrent_timer.h"
@@ -111,6 +112,18 @@ QByteArray Get(Database &db, const Key &key) {
 	return Value;
 }
 
+auto Values = std::vector<QByteArray>();
+const auto GetValues = [](std::vector<QByteArray> values) {
+	Values = values;
+	Semaphore.release();
+};
+
+std::vector<QByteArray> GetMany(Database &db, std::vector<Key> keys) {
+	db.getMany(std::move(keys), GetValues);
+	Semaphore.acquire();
+	return Values;
+}
+
 Database::TaggedValue GetWithTag(Database &db, const Key &key) {
 	db.getWithTag(key, GetValueWithTag);
 	Semaphore.acquire();
@@ -446,6 +459,14 @@ TEST_CASE("encrypted cache db", "[storage_cache_database]") {
 		REQUIRE(Open(db, key).type == Error::Type::None);
 		REQUIRE((Get(db, Key{ 0, 1 }) == Test1()));
 		REQUIRE((Get(db, Key{ 1, 0 }) == Test2()));
+		const auto many = GetMany(db, { Key{ 1, 0 }, Key{ 1, 1 }, Key{ 0, 1 } });
+		REQUIRE(many.size() == 3);
+		REQUIRE((many[0] == Test2()));
+		REQUIRE(many[1].isEmpty());
+		REQUIRE((many[2] == Test1()));
+		REQUIRE(db.mayContain(Key{ 0, 1 }));
+		REQUIRE(db.mayContain(Key{ 1, 0 }));
+		REQUIRE(!db.mayContain(Key{ 1, 1 }));
 		Close(db);
 	}
 	SECTION("deleting in db by tag") {
@@ -512,6 +533,94 @@ TEST_CASE("encrypted cache db", "[storage_cache_database]") {
 	}
 }
 
+TEST_CASE("sharded cache db", "[storage_cache_database]") {
+	if (!DisableLargeTest) {
+		return;
+	}
+	auto settings = Settings;
+	settings.shardsCount = 3;
+	const auto count = 30U;
+	SECTION("writing sharded db") {
+		Database db(name, settings);
+
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		for (auto i = 0U; i != count; ++i) {
+			auto value = Test1();
+			value[0] = char('A') + i;
+			const auto result = Put(db, Key{ i, i * 3 }, std::move(value));
+			REQUIRE(result.type == Error::Type::None);
+		}
+		for (auto i = 0U; i != count; ++i) {
+			REQUIRE(CopyIfEmpty(db, Key{ i, i * 3 }, Key{ i, i * 3 + 1 }).type
+				== Error::Type::None);
+			REQUIRE(MoveIfEmpty(db, Key{ i, i * 3 }, Key{ i, i * 3 + 2 }).type
+				== Error::Type::None);
+		}
+		Close(db);
+	}
+	SECTION("reading sharded db") {
+		Database db(name, settings);
+
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		for (auto i = 0U; i != count; ++i) {
+			auto value = Test1();
+			value[0] = char('A') + i;
+			REQUIRE(Get(db, Key{ i, i * 3 }).isEmpty());
+			REQUIRE((Get(db, Key{ i, i * 3 + 1 }) == value));
+			REQUIRE((Get(db, Key{ i, i * 3 + 2 }) == value));
+		}
+		auto keys = std::vector<Key>();
+		for (auto i = 0U; i != count; ++i) {
+			keys.push_back(Key{ i, i * 3 + (i % 3) });
+		}
+		const auto many = GetMany(db, keys);
+		REQUIRE(many.size() == count);
+		for (auto i = 0U; i != count; ++i) {
+			auto value = Test1();
+			value[0] = char('A') + i;
+			REQUIRE((many[i] == ((i % 3) ? value : QByteArray())));
+		}
+		Close(db);
+	}
+}
+
+TEST_CASE("compressed cache db", "[storage_cache_database]") {
+	if (!DisableLargeTest) {
+		return;
+	}
+	const auto compressible = QByteArray(1000, 'a');
+	SECTION("writing compressed db") {
+		auto settings = Settings;
+		settings.maxDataSize = 1024;
+		settings.compressTags.emplace(uint8(1));
+		Database db(name, settings);
+
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE(Put(db, Key{ 0, 1 }, Database::TaggedValue(
+			QByteArray(compressible),
+			1)).type == Error::Type::None);
+		REQUIRE(Put(db, Key{ 0, 2 }, Database::TaggedValue(
+			Test1(),
+			1)).type == Error::Type::None);
+		const auto withTag = GetWithTag(db, Key{ 0, 1 });
+		REQUIRE(((withTag.bytes == compressible) && (withTag.tag == 1)));
+		REQUIRE((Get(db, Key{ 0, 2 }) == Test1()));
+		Close(db);
+	}
+	SECTION("reading compressed db without compression") {
+		auto settings = Settings;
+		settings.maxDataSize = 1024;
+		Database db(name, settings);
+
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE((Get(db, Key{ 0, 1 }) == compressible));
+		REQUIRE((Get(db, Key{ 0, 2 }) == Test1()));
+		Close(db);
+	}
+}
+
 TEST_CASE("cache db remove", "[storage_cache_database]") {
 	if (!DisableLargeTest) {
 		return;
@@ -538,6 +647,49 @@ TEST_CASE("cache db remove", "[storage_cache_database]") {
 	}
 }
 
+TEST_CASE("cache db tag directories", "[storage_cache_database]") {
+	if (!DisableLargeTest) {
+		return;
+	}
+	auto settings = Settings;
+	settings.tagPlaceDirectories = true;
+	SECTION("db clear by tag removes tag values") {
+		Database db(name, settings);
+
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE(Put(db, Key{ 5, 1 }, Database::TaggedValue(Test1(), 1)).type
+			== Error::Type::None);
+		REQUIRE(Put(db, Key{ 5, 2 }, Database::TaggedValue(Test1(), 2)).type
+			== Error::Type::None);
+		REQUIRE(Put(db, Key{ 6, 2 }, Database::TaggedValue(Test2(), 2)).type
+			== Error::Type::None);
+		REQUIRE(Put(db, Key{ 6, 1 }, Database::TaggedValue(Test2(), 2)).type
+			== Error::Type::None);
+		REQUIRE(Put(db, Key{ 6, 1 }, Database::TaggedValue(Test2(), 1)).type
+			== Error::Type::None);
+		REQUIRE(ClearByTag(db, 2).type == Error::Type::None);
+		REQUIRE((Get(db, Key{ 5, 1 }) == Test1()));
+		REQUIRE((Get(db, Key{ 6, 1 }) == Test2()));
+		REQUIRE(Get(db, Key{ 5, 2 }).isEmpty());
+		REQUIRE(Get(db, Key{ 6, 2 }).isEmpty());
+		REQUIRE(Put(db, Key{ 7, 2 }, Database::TaggedValue(Test1(), 2)).type
+			== Error::Type::None);
+		Close(db);
+	}
+	SECTION("db clear by tag written to binlog") {
+		Database db(name, settings);
+
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE((Get(db, Key{ 5, 1 }) == Test1()));
+		REQUIRE((Get(db, Key{ 6, 1 }) == Test2()));
+		REQUIRE(Get(db, Key{ 5, 2 }).isEmpty());
+		REQUIRE(Get(db, Key{ 6, 2 }).isEmpty());
+		REQUIRE((Get(db, Key{ 7, 2 }) == Test1()));
+		Close(db);
+	}
+}
+
 TEST_CASE("cache db bundled actions", "[storage_cache_database]") {
 	if (!DisableLargeTest) {
 		return;
@@ -601,6 +753,32 @@ TEST_CASE("cache db bundled actions", "[storage_cache_database]") {
 		Close(db);
 		REQUIRE(QFile(path).size() > size);
 	}
+	SECTION("db puts written in one group") {
+		auto settings = Settings;
+		settings.groupCommitDelay = crl::time(500);
+		Database db(name, settings);
+
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		const auto path = GetBinlogPath();
+		const auto size = QFile(path).size();
+		db.put(Key{ 0, 1 }, Test1(), nullptr);
+		db.put(Key{ 0, 2 }, Test2(), nullptr);
+		db.sync();
+		REQUIRE(QFile(path).size() == size);
+		REQUIRE((Get(db, Key{ 0, 2 }) == Test2()));
+		REQUIRE(Put(db, Key{ 0, 3 }, Test1()).type == Error::Type::None);
+		REQUIRE(QFile(path).size() == size
+			+ sizeof(details::MultiStore)
+			+ 3 * sizeof(details::Store));
+		Close(db);
+
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE((Get(db, Key{ 0, 1 }) == Test1()));
+		REQUIRE((Get(db, Key{ 0, 2 }) == Test2()));
+		REQUIRE((Get(db, Key{ 0, 3 }) == Test1()));
+		Close(db);
+	}
 }
 
 TEST_CASE("cache db limits", "[storage_cache_database]") {
@@ -672,6 +850,33 @@ TEST_CASE("cache db limits", "[storage_cache_database]") {
 		REQUIRE((Get(db, Key{ 2, 2 }) == Test2()));
 		Close(db);
 	}
+	SECTION("db size limit with frequency policy") {
+		auto settings = Settings;
+		settings.trackEstimatedTime = true;
+		settings.totalSizeLimit = 17 * 3 + 1;
+		settings.evictionPolicies.emplace(
+			uint8(0),
+			Database::EvictionPolicy::LeastFrequentlyUsed);
+		Database db(name, settings);
+
+		db.clear(nullptr);
+		db.open(base::duplicate(key), nullptr);
+		db.put(Key{ 0, 1 }, Test1(), nullptr);
+		db.get(Key{ 0, 1 }, nullptr);
+		AdvanceTime(4);
+		db.put(Key{ 1, 0 }, Test2(), nullptr);
+		db.put(Key{ 1, 1 }, Test1(), nullptr);
+		db.put(Key{ 2, 0 }, Test2(), nullptr);
+
+		// Removing { 1, 0 } will be scheduled, { 0, 1 } has a hit.
+		AdvanceTime(2);
+
+		REQUIRE((Get(db, Key{ 0, 1 }) == Test1()));
+		REQUIRE(Get(db, Key{ 1, 0 }).isEmpty());
+		REQUIRE((Get(db, Key{ 1, 1 }) == Test1()));
+		REQUIRE((Get(db, Key{ 2, 0 }) == Test2()));
+		Close(db);
+	}
 	SECTION("db time limit") {
 		auto settings = Settings;
 		settings.trackEstimatedTime = true;
@@ -738,3 +943,70 @@ TEST_CASE("large db", "[storage_cache_database]") {
 		Close(db);
 	}
 }
+
+TEST_CASE("large binlog open", "[storage_cache_database]") {
+	if (DisableLargeTest) {
+		return;
+	}
+	using namespace details;
+	constexpr auto kEntries = 1000 * 1000;
+	constexpr auto kBundle = 10 * 1000;
+	const auto makeKey = [](int index) {
+		return Key{ uint64(index) * 2, (uint64(index) << 32) + 3 };
+	};
+	SECTION("index memory") {
+		using Entry = DatabaseObject::Entry;
+		auto map = KeysMap<Entry>();
+		map.reserve(kEntries);
+		for (auto i = 0; i != kEntries; ++i) {
+			map[makeKey(i)] = Entry(PlaceId(), 0, 0, 1, 0);
+		}
+		REQUIRE(map.size() == kEntries);
+		const auto bytes = map.capacity()
+			* (sizeof(KeysMap<Entry>::value_type) * 8 + 1) / 8;
+		REQUIRE(bytes / kEntries <= 56);
+		for (auto i = 0; i != kEntries; i += 2) {
+			map.erase(map.find(makeKey(i)));
+		}
+		REQUIRE(map.size() == kEntries / 2);
+		REQUIRE(map.find(makeKey(0)) == end(map));
+		REQUIRE(map.find(makeKey(1)) != end(map));
+	}
+	SECTION("million entries open time") {
+		{
+			Database db(name, Settings);
+			REQUIRE(Clear(db).type == Error::Type::None);
+			REQUIRE(Open(db, key).type == Error::Type::None);
+			Close(db);
+		}
+		Storage::File binlog;
+		REQUIRE(binlog.open(
+			GetBinlogPath(),
+			Storage::File::Mode::Write,
+			key) == Storage::File::Result::Success);
+		auto header = BasicHeader();
+		REQUIRE(binlog.write(bytes::object_as_span(&header)));
+		auto list = std::vector<MultiStore::Part>(kBundle);
+		for (auto i = 0; i != kEntries; i += kBundle) {
+			auto multi = MultiStore(kBundle);
+			for (auto j = 0; j != kBundle; ++j) {
+				const auto index = i + j;
+				auto &record = list[j];
+				record = Store();
+				record.key = makeKey(index);
+				record.setSize(Test1().size());
+				memcpy(record.place.data(), &index, sizeof(index));
+			}
+			REQUIRE(binlog.write(bytes::object_as_span(&multi)));
+			REQUIRE(binlog.write(bytes::make_span(list)));
+		}
+		binlog.close();
+
+		Database db(name, Settings);
+		const auto start = crl::now();
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE(crl::now() - start < 10 * crl::time(1000));
+		REQUIRE(db.mayContain(makeKey(kEntries - 1)));
+		Close(db);
+	}
+}
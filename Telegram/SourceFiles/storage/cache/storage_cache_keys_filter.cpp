@@ -0,0 +1,126 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/cache/storage_cache_keys_filter.h"
+
+namespace Storage {
+namespace Cache {
+namespace details {
+namespace {
+
+// About one percent of false positives at full capacity.
+constexpr auto kBitsPerKey = size_type(10);
+constexpr auto kHashesCount = 7;
+constexpr auto kMinCapacity = size_type(1024);
+
+uint64 Mix(uint64 value) {
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDULL;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53ULL;
+	value ^= value >> 33;
+	return value;
+}
+
+template <typename Method>
+bool EnumerateBits(
+		size_type bitsCount,
+		const Key &key,
+		Method &&method) {
+	const auto first = Mix(key.high ^ Mix(key.low));
+	const auto second = Mix(key.low + 0x9E3779B97F4A7C15ULL) | 1;
+	for (auto i = 0; i != kHashesCount; ++i) {
+		const auto bit = (first + i * second) % uint64(bitsCount);
+		if (!method(size_type(bit / 64), uint64(1) << (bit % 64))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void AddToBits(std::vector<uint64> &bits, const Key &key) {
+	EnumerateBits(bits.size() * 64, key, [&](size_type word, uint64 mask) {
+		bits[word] |= mask;
+		return true;
+	});
+}
+
+} // namespace
+
+KeysFilter::Builder::Builder(size_type count)
+: _capacity(std::max(count * 2, kMinCapacity)) {
+	_bits.resize((_capacity * kBitsPerKey + 63) / 64, 0);
+}
+
+void KeysFilter::Builder::add(const Key &key) {
+	AddToBits(_bits, key);
+}
+
+bool KeysFilter::mayContain(const Key &key) const {
+	QMutexLocker lock(&_mutex);
+	if (!_ready) {
+		return true;
+	}
+	return EnumerateBits(_bits.size() * 64, key, [&](
+			size_type word,
+			uint64 mask) {
+		return (_bits[word] & mask) != 0;
+	});
+}
+
+void KeysFilter::add(const Key &key) {
+	QMutexLocker lock(&_mutex);
+	if (_ready) {
+		AddToBits(_bits, key);
+	}
+	if (_rebuilding) {
+		_pending.push_back(key);
+	}
+}
+
+void KeysFilter::removed() {
+	QMutexLocker lock(&_mutex);
+	++_removed;
+}
+
+void KeysFilter::reset() {
+	QMutexLocker lock(&_mutex);
+	_ready = _rebuilding = false;
+	_capacity = _removed = 0;
+	base::take(_bits);
+	base::take(_pending);
+}
+
+void KeysFilter::startRebuild() {
+	QMutexLocker lock(&_mutex);
+	_rebuilding = true;
+	_pending.clear();
+}
+
+void KeysFilter::finishRebuild(Builder &&builder) {
+	QMutexLocker lock(&_mutex);
+	Expects(_rebuilding);
+
+	// Keys added from other threads while the builder was filled.
+	for (const auto &key : base::take(_pending)) {
+		AddToBits(builder._bits, key);
+	}
+	_bits = std::move(builder._bits);
+	_capacity = builder._capacity;
+	_removed = 0;
+	_rebuilding = false;
+	_ready = true;
+}
+
+bool KeysFilter::stale(size_type count) const {
+	QMutexLocker lock(&_mutex);
+	return _ready && (count > _capacity || _removed > _capacity / 2);
+}
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
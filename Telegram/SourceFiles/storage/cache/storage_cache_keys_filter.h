@@ -0,0 +1,58 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_types.h"
+#include <QtCore/QMutex>
+
+namespace Storage {
+namespace Cache {
+namespace details {
+
+// Bloom filter of the keys stored in one database.
+// Checked from any thread, rebuilt on the database queue.
+class KeysFilter {
+public:
+	class Builder {
+	public:
+		explicit Builder(size_type count);
+
+		void add(const Key &key);
+
+	private:
+		friend class KeysFilter;
+
+		std::vector<uint64> _bits;
+		size_type _capacity = 0;
+
+	};
+
+	// Until the first finishRebuild() any key may be present.
+	[[nodiscard]] bool mayContain(const Key &key) const;
+	void add(const Key &key);
+	void removed();
+	void reset();
+
+	void startRebuild();
+	void finishRebuild(Builder &&builder);
+	[[nodiscard]] bool stale(size_type count) const;
+
+private:
+	mutable QMutex _mutex;
+	std::vector<uint64> _bits;
+	std::vector<Key> _pending;
+	size_type _capacity = 0;
+	size_type _removed = 0;
+	bool _ready = false;
+	bool _rebuilding = false;
+
+};
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
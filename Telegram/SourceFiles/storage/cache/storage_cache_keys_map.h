@@ -0,0 +1,259 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_types.h"
+
+namespace Storage {
+namespace Cache {
+namespace details {
+
+// Open addressing hash map with linear probing, all values are stored
+// in one array. Erasing moves elements, so it invalidates iterators.
+template <typename Value>
+class KeysMap {
+public:
+	using value_type = std::pair<Key, Value>;
+
+	template <bool Const>
+	class Iterator {
+	public:
+		using Owner = std::conditional_t<Const, const KeysMap, KeysMap>;
+		using reference = std::conditional_t<
+			Const,
+			const value_type&,
+			value_type&>;
+		using pointer = std::conditional_t<
+			Const,
+			const value_type*,
+			value_type*>;
+
+		reference operator*() const {
+			return _owner->_slots[_index];
+		}
+		pointer operator->() const {
+			return &_owner->_slots[_index];
+		}
+		Iterator &operator++() {
+			++_index;
+			skipEmpty();
+			return *this;
+		}
+		operator Iterator<true>() const {
+			return Iterator<true>(_owner, _index);
+		}
+
+		friend inline bool operator==(
+				const Iterator &a,
+				const Iterator &b) {
+			return (a._index == b._index);
+		}
+		friend inline bool operator!=(
+				const Iterator &a,
+				const Iterator &b) {
+			return !(a == b);
+		}
+
+	private:
+		friend class KeysMap;
+		template <bool>
+		friend class Iterator;
+
+		Iterator(Owner *owner, size_type index)
+		: _owner(owner)
+		, _index(index) {
+		}
+		void skipEmpty() {
+			const auto capacity = _owner->capacity();
+			while (_index != capacity && !_owner->used(_index)) {
+				++_index;
+			}
+		}
+
+		Owner *_owner = nullptr;
+		size_type _index = 0;
+
+	};
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	KeysMap() = default;
+
+	size_type size() const {
+		return _size;
+	}
+	bool empty() const {
+		return !_size;
+	}
+	size_type capacity() const {
+		return size_type(_slots.size());
+	}
+
+	iterator begin() {
+		auto result = iterator(this, 0);
+		result.skipEmpty();
+		return result;
+	}
+	iterator end() {
+		return iterator(this, capacity());
+	}
+	const_iterator begin() const {
+		auto result = const_iterator(this, 0);
+		result.skipEmpty();
+		return result;
+	}
+	const_iterator end() const {
+		return const_iterator(this, capacity());
+	}
+	friend inline iterator begin(KeysMap &map) {
+		return map.begin();
+	}
+	friend inline iterator end(KeysMap &map) {
+		return map.end();
+	}
+	friend inline const_iterator begin(const KeysMap &map) {
+		return map.begin();
+	}
+	friend inline const_iterator end(const KeysMap &map) {
+		return map.end();
+	}
+
+	iterator find(const Key &key) {
+		return iterator(this, findIndex(key));
+	}
+	const_iterator find(const Key &key) const {
+		return const_iterator(this, findIndex(key));
+	}
+
+	Value &operator[](const Key &key) {
+		if ((_size + 1) * kLoadDenominator > capacity() * kLoadNumerator) {
+			rehash(CapacityFor((_size + 1) * 3 / 2));
+		}
+		auto index = home(key);
+		for (; used(index); index = next(index)) {
+			if (_slots[index].first == key) {
+				return _slots[index].second;
+			}
+		}
+		markUsed(index, true);
+		_slots[index].first = key;
+		++_size;
+		return _slots[index].second;
+	}
+
+	void erase(const_iterator i) {
+		Expects(i._index < capacity() && used(i._index));
+
+		// Backward shift deletion, no tombstones are left.
+		auto hole = i._index;
+		for (auto j = next(hole); used(j); j = next(j)) {
+			const auto from = home(_slots[j].first);
+			if (distance(from, j) >= distance(hole, j)) {
+				_slots[hole] = std::move(_slots[j]);
+				hole = j;
+			}
+		}
+		markUsed(hole, false);
+		_slots[hole] = value_type();
+		--_size;
+	}
+
+	void reserve(size_type count) {
+		const auto required = CapacityFor(count);
+		if (required > capacity()) {
+			rehash(required);
+		}
+	}
+	void shrink_to_fit() {
+		const auto required = CapacityFor(_size);
+		if (required < capacity()) {
+			rehash(required);
+		}
+	}
+
+private:
+	static constexpr auto kLoadNumerator = size_type(4);
+	static constexpr auto kLoadDenominator = size_type(5);
+	static constexpr auto kMinCapacity = size_type(16);
+
+	static size_type CapacityFor(size_type count) {
+		return std::max(
+			(count * kLoadDenominator + kLoadNumerator - 1) / kLoadNumerator,
+			kMinCapacity);
+	}
+	static uint32 Mix(const Key &key) {
+		auto value = key.high ^ (key.low * 0x9E3779B97F4A7C15ULL);
+		value ^= value >> 31;
+		value *= 0xBF58476D1CE4E5B9ULL;
+		value ^= value >> 29;
+		return uint32(value);
+	}
+
+	size_type home(const Key &key) const {
+		// Capacity is not a power of two, map the hash without division.
+		return size_type((uint64(Mix(key)) * uint64(capacity())) >> 32);
+	}
+	size_type next(size_type index) const {
+		return (index + 1 == capacity()) ? 0 : (index + 1);
+	}
+	size_type distance(size_type from, size_type till) const {
+		return (till >= from) ? (till - from) : (till + capacity() - from);
+	}
+	bool used(size_type index) const {
+		return (_used[index / 64] & (uint64(1) << (index % 64))) != 0;
+	}
+	void markUsed(size_type index, bool used) {
+		const auto mask = uint64(1) << (index % 64);
+		if (used) {
+			_used[index / 64] |= mask;
+		} else {
+			_used[index / 64] &= ~mask;
+		}
+	}
+
+	size_type findIndex(const Key &key) const {
+		if (!_size) {
+			return capacity();
+		}
+		for (auto index = home(key); used(index); index = next(index)) {
+			if (_slots[index].first == key) {
+				return index;
+			}
+		}
+		return capacity();
+	}
+
+	void rehash(size_type count) {
+		auto slots = base::take(_slots);
+		auto used = base::take(_used);
+		_slots.resize(count);
+		_used.resize((count + 63) / 64, 0);
+		for (auto i = size_type(0), till = size_type(slots.size())
+			; i != till
+			; ++i) {
+			if (!(used[i / 64] & (uint64(1) << (i % 64)))) {
+				continue;
+			}
+			auto index = home(slots[i].first);
+			while (this->used(index)) {
+				index = next(index);
+			}
+			markUsed(index, true);
+			_slots[index] = std::move(slots[i]);
+		}
+	}
+
+	std::vector<value_type> _slots;
+	std::vector<uint64> _used;
+	size_type _size = 0;
+
+};
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
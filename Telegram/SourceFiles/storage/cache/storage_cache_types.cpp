@@ -133,6 +133,11 @@ size_type MultiAccess::validateCount() const {
 	return ReadFrom(count);
 }
 
+RemoveTag::RemoveTag(uint8 tag)
+: type(kType)
+, tag(tag) {
+}
+
 } // namespace details
 } // namespace Cache
 } // namespace Storage
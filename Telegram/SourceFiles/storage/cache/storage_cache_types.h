@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "base/basic_types.h"
 #include "base/flat_map.h"
+#include "base/flat_set.h"
 #include "base/optional.h"
 #include <crl/crl_time.h>
 #include <QtCore/QString>
@@ -64,6 +65,12 @@ constexpr auto kBundledRecordsLimit
 	= size_type(1 << (RecordsCount().size() * 8));
 constexpr auto kDataSizeLimit = size_type(1 << (EntrySize().size() * 8));
 
+enum class EvictionPolicy : uint8 {
+	LeastRecentlyUsed,
+	LeastFrequentlyUsed,
+	SizeAware,
+};
+
 struct Settings {
 	size_type maxBundledRecords = 16 * 1024;
 	size_type readBlockSize = 8 * 1024 * 1024;
@@ -74,6 +81,8 @@ struct Settings {
 	int64 compactAfterExcess = 8 * 1024 * 1024;
 	int64 compactAfterFullSize = 0;
 	size_type compactChunkSize = 16 * 1024;
+	crl::time compactTickBudget = 50;
+	crl::time compactTickDelay = 200;
 
 	bool trackEstimatedTime = true;
 	int64 totalSizeLimit = 1024 * 1024 * 1024;
@@ -81,7 +90,29 @@ struct Settings {
 	crl::time pruneTimeout = 5 * crl::time(1000);
 	crl::time maxPruneCheckTimeout = 3600 * crl::time(1000);
 
+	// Chooses what is removed when totalSizeLimit is exceeded.
+	// Tags not found here use EvictionPolicy::LeastRecentlyUsed.
+	base::flat_map<uint8, EvictionPolicy> evictionPolicies;
+
 	bool clearOnWrongKey = false;
+	bool mapPlaceFiles = false;
+
+	// Values with these tags are stored LZ4 compressed when that saves
+	// space. Compressed values are recognized on read for any tag.
+	base::flat_set<uint8> compressTags;
+
+	// Store records of puts made during this time are written together,
+	// put callbacks are called after that write. Zero disables grouping.
+	crl::time groupCommitDelay = 0;
+
+	// Each shard is a separate database with its own binlog and queue.
+	// Changing this value makes most of the existing entries unreachable.
+	size_type shardsCount = 1;
+
+	// Values of each tag are placed in a directory of their own, so that
+	// clearByTag removes the whole directory at once in the background.
+	// Changing this value clears the database.
+	bool tagPlaceDirectories = false;
 };
 
 struct SettingsUpdate {
@@ -101,9 +132,19 @@ struct TaggedSummary {
 	size_type count = 0;
 	int64 totalSize = 0;
 };
+
+// Group commits of 1, 2-3, 4-7, ..., 128 or more records.
+constexpr auto kCommitBatchBuckets = 8;
 struct Stats {
 	TaggedSummary full;
 	base::flat_map<uint8, TaggedSummary> tagged;
+	int64 binlogSize = 0;
+	int64 binlogExcess = 0;
+	int64 compactTill = 0; // Non-zero while the compactor is working.
+	int64 compactReadTill = 0;
+	crl::time openDuration = 0; // Time spent reading the binlog.
+	int64 binlogFlushes = 0;
+	std::array<int64, kCommitBatchBuckets> commitBatches = { { 0 } };
 	bool clearing = false;
 };
 
@@ -125,6 +166,7 @@ struct BasicHeader {
 	BasicHeader();
 
 	static constexpr auto kTrackEstimatedTime = 0x01U;
+	static constexpr auto kTagPlaceDirectories = 0x02U;
 
 	Format getFormat() const {
 		return static_cast<Format>(format);
@@ -170,7 +212,7 @@ struct Store {
 
 struct StoreWithTime : Store {
 	EstimatedTimePoint time;
-	uint32 reserved = 0;
+	uint32 hits = 0; // Count of MultiAccess records with this key.
 };
 
 struct MultiStore {
@@ -223,6 +265,19 @@ struct MultiAccess {
 	size_type validateCount() const;
 };
 
+struct RemoveTag {
+	static constexpr auto kType = RecordType(0x05);
+
+	explicit RemoveTag(uint8 tag = 0);
+
+	RecordType type = kType;
+	uint8 tag = 0;
+	uint16 reserved1 = 0;
+	uint32 reserved2 = 0;
+	uint32 reserved3 = 0;
+	uint32 reserved4 = 0;
+};
+
 } // namespace details
 } // namespace Cache
 } // namespace Storage
@@ -28,9 +28,18 @@ namespace {
 // How much time without download causes additional session kill.
 constexpr auto kKillSessionTimeout = crl::time(5000);
 
-// Max 16 file parts downloaded at the same time, 128 KB each.
+// Start with 16 file parts downloaded at the same time, 128 KB each.
+// Queue limits are counted in such parts, a larger part counts as several.
 constexpr auto kMaxFileQueries = 16;
 
+// The limit is adapted to the measured bandwidth-delay product.
+constexpr auto kMinFileQueries = 4;
+constexpr auto kMaxAdaptiveFileQueries = 64;
+constexpr auto kQueriesPerSession = 8;
+constexpr auto kAdjustPeriod = crl::time(1000);
+constexpr auto kMinRttLifetime = crl::time(10000);
+constexpr auto kFloodBackoff = crl::time(30000);
+
 // Max 8 http[s] files downloaded at the same time.
 constexpr auto kMaxWebFileQueries = 8;
 
@@ -40,35 +49,198 @@ constexpr auto kMaxWebFileQueries = 8;
 // fixed part size download for hash checking.
 constexpr auto kPartSize = 128 * 1024;
 
+// Large files use up to 1 MB parts if the queue fits several of them.
+constexpr auto kMaxPartSize = 1024 * 1024;
+constexpr auto kPartsInFlightForGrowth = 4;
+
+// Shares of the queries limit while streaming: a half for the files
+// loaded by the user and a quarter for the auto loaded ones.
+constexpr auto kUserShareWhileStreaming = 2;
+constexpr auto kAutoShareWhileStreaming = 4;
+
+// At most 4 auto loaded files are downloaded from a queue at the same
+// time and those larger than 1 MB wait for the user loaded files.
+constexpr auto kMaxAutoLoadersStarted = 4;
+constexpr auto kLargeAutoLoadSize = 1024 * 1024;
+
+// Partial downloads to files are saved for resuming after each 4 MB.
+constexpr auto kResumeSaveStep = 4 * 1024 * 1024;
+constexpr auto kResumeDelay = crl::time(5000);
+
+[[nodiscard]] int QueriesForPart(int limit) {
+	return std::max(limit / kPartSize, 1);
+}
+
 } // namespace
 
 Downloader::Downloader(not_null<ApiWrap*> api)
 : _api(api)
 , _killDownloadSessionsTimer([=] { killDownloadSessions(); })
-, _queueForWeb(kMaxWebFileQueries) {
+, _queueForWeb(kMaxWebFileQueries)
+, _resumeTimer([=] { resumePartialDownloads(); }) {
+	_resumeTimer.callOnce(kResumeDelay);
 }
 
 void Downloader::clearPriorities() {
 	++_priority;
 }
 
+Downloader::DcState &Downloader::dcState(MTP::DcId dcId) {
+	return _dcStates[dcId];
+}
+
 void Downloader::requestedAmountIncrement(MTP::DcId dcId, int index, int amount) {
-	Expects(index >= 0 && index < MTP::kDownloadSessionsCount);
+	Expects(index >= 0 && index < MTP::kDownloadSessionsCountMax);
 
 	using namespace rpl::mappers;
 
-	auto it = _requestedBytesAmount.find(dcId);
-	if (it == _requestedBytesAmount.cend()) {
-		it = _requestedBytesAmount.emplace(dcId, RequestedInDc { { 0 } }).first;
-	}
-	it->second[index] += amount;
+	auto &requested = dcState(dcId).requested;
+	requested[index] += amount;
 	if (amount > 0) {
 		killDownloadSessionsStop(dcId);
-	} else if (ranges::find_if(it->second, _1 > 0) == end(it->second)) {
+	} else if (ranges::find_if(requested, _1 > 0) == end(requested)) {
 		killDownloadSessionsStart(dcId);
 	}
 }
 
+void Downloader::streamingRequestsIncrement(int amount) {
+	Expects(_streamingRequests + amount >= 0);
+
+	if (!amount) {
+		return;
+	}
+	_streamingRequests += amount;
+	if (!_streamingRequests) {
+		// Let the throttled loaders use the whole limit again.
+		crl::on_main(this, [=] {
+			if (_streamingRequests) {
+				return;
+			}
+			for (auto &[dcId, queue] : _queuesForDc) {
+				FileLoader::LoadNextFromQueue(&queue);
+			}
+		});
+	}
+}
+
+int Downloader::queriesLimitFor(
+		not_null<const Queue*> queue,
+		bool autoLoading) const {
+	if (!_streamingRequests) {
+		return queue->queriesLimit;
+	}
+	const auto share = autoLoading
+		? kAutoShareWhileStreaming
+		: kUserShareWhileStreaming;
+	return std::max(queue->queriesLimit / share, 1);
+}
+
+bool Downloader::autoLoadingDeferred(
+		not_null<const Queue*> queue,
+		int size,
+		bool started) const {
+	const auto userQueries = queue->queriesCount - queue->autoQueriesCount;
+	if (userQueries > 0 && size > kLargeAutoLoadSize) {
+		return true;
+	}
+	return !started && (queue->autoLoadersCount >= kMaxAutoLoadersStarted);
+}
+
+void Downloader::requestSucceeded(
+		MTP::DcId dcId,
+		crl::time duration,
+		int amount) {
+	auto &state = dcState(dcId);
+	const auto now = crl::now();
+	const auto queue = queueForDc(dcId);
+	if (queue->queriesCount + 1 >= queue->queriesLimit) {
+		state.saturated = true;
+	}
+	state.rtt = state.rtt ? ((state.rtt * 7 + duration) / 8) : duration;
+	if (!state.minRtt
+		|| duration < state.minRtt
+		|| state.minRttUpdated + kMinRttLifetime < now) {
+		state.minRtt = duration;
+		state.minRttUpdated = now;
+	}
+	state.windowBytes += amount;
+	if (!state.windowStart) {
+		state.windowStart = now - duration;
+	}
+	if (now - state.windowStart >= kAdjustPeriod) {
+		adjustForDc(dcId, state, now);
+	}
+}
+
+void Downloader::adjustForDc(
+		MTP::DcId dcId,
+		DcState &state,
+		crl::time now) {
+	const auto queue = queueForDc(dcId);
+	const auto flood = (now < state.floodUntil);
+	state.bytesPerSecond = state.windowBytes
+		* 1000
+		/ std::max(now - state.windowStart, crl::time(1));
+
+	// Twice the bandwidth-delay product in flight keeps the link busy.
+	// Requests waiting in queues grow the rtt, but not the minimal rtt.
+	const auto delayProduct = state.bytesPerSecond * state.minRtt / 1000;
+	const auto wanted = int((2 * delayProduct + Storage::kPartSize - 1)
+		/ Storage::kPartSize);
+	auto limit = queue->queriesLimit;
+	if (wanted > limit) {
+		if (state.saturated && !flood) {
+			limit = std::min(wanted, limit * 3 / 2);
+		}
+	} else {
+		limit = std::max(wanted, limit * 3 / 4);
+	}
+	queue->queriesLimit = snap(
+		limit,
+		flood ? kMinFileQueries : kMaxFileQueries,
+		kMaxAdaptiveFileQueries);
+	state.sessionsCount = flood
+		? MTP::kDownloadSessionsCount
+		: snap(
+			(queue->queriesLimit + kQueriesPerSession - 1) / kQueriesPerSession,
+			MTP::kDownloadSessionsCount,
+			MTP::kDownloadSessionsCountMax);
+
+	state.windowStart = now;
+	state.windowBytes = 0;
+	state.saturated = false;
+	_dcStatsUpdated.fire_copy(dcId);
+}
+
+void Downloader::requestFlooded(MTP::DcId dcId) {
+	auto &state = dcState(dcId);
+	const auto queue = queueForDc(dcId);
+	queue->queriesLimit = std::max(queue->queriesLimit / 2, kMinFileQueries);
+	state.sessionsCount = MTP::kDownloadSessionsCount;
+	state.floodUntil = crl::now() + kFloodBackoff;
+	_dcStatsUpdated.fire_copy(dcId);
+}
+
+Downloader::DcStats Downloader::dcStats(MTP::DcId dcId) const {
+	auto result = DcStats();
+	const auto i = _dcStates.find(dcId);
+	if (i != end(_dcStates)) {
+		result.sessionsCount = i->second.sessionsCount;
+		result.bytesPerSecond = i->second.bytesPerSecond;
+		result.rtt = i->second.rtt;
+		result.minRtt = i->second.minRtt;
+	}
+	const auto j = _queuesForDc.find(dcId);
+	if (j != end(_queuesForDc)) {
+		result.queriesLimit = j->second.queriesLimit;
+	}
+	return result;
+}
+
+rpl::producer<MTP::DcId> Downloader::dcStatsUpdated() const {
+	return _dcStatsUpdated.events();
+}
+
 void Downloader::killDownloadSessionsStart(MTP::DcId dcId) {
 	if (!_killDownloadSessionTimes.contains(dcId)) {
 		_killDownloadSessionTimes.emplace(
@@ -93,7 +265,7 @@ void Downloader::killDownloadSessions() {
 	auto ms = crl::now(), left = MTP::kAckSendWaiting + kKillSessionTimeout;
 	for (auto i = _killDownloadSessionTimes.begin(); i != _killDownloadSessionTimes.end(); ) {
 		if (i->second <= ms) {
-			for (int j = 0; j < MTP::kDownloadSessionsCount; ++j) {
+			for (int j = 0; j < MTP::kDownloadSessionsCountMax; ++j) {
 				MTP::stopSession(MTP::downloadDcId(i->first, j));
 			}
 			i = _killDownloadSessionTimes.erase(i);
@@ -111,10 +283,11 @@ void Downloader::killDownloadSessions() {
 
 int Downloader::chooseDcIndexForRequest(MTP::DcId dcId) const {
 	auto result = 0;
-	auto it = _requestedBytesAmount.find(dcId);
-	if (it != _requestedBytesAmount.cend()) {
-		for (auto i = 1; i != MTP::kDownloadSessionsCount; ++i) {
-			if (it->second[i] < it->second[result]) {
+	auto it = _dcStates.find(dcId);
+	if (it != _dcStates.cend()) {
+		const auto &requested = it->second.requested;
+		for (auto i = 1; i != it->second.sessionsCount; ++i) {
+			if (requested[i] < requested[result]) {
 				result = i;
 			}
 		}
@@ -134,6 +307,76 @@ not_null<Downloader::Queue*> Downloader::queueForWeb() {
 	return &_queueForWeb;
 }
 
+void Downloader::resumePartialDownloads() {
+	for (const auto &key : Local::partialDownloads()) {
+		if (_resumedLoaders.contains(key)) {
+			continue;
+		}
+		const auto download = Local::readPartialDownload(key);
+		const auto location = download
+			? StorageFileLocation::FromSerialized(download->location)
+			: std::nullopt;
+		if (!location || !location->valid()) {
+			Local::removePartialDownload(key);
+			continue;
+		}
+		auto loader = std::make_unique<mtpFileLoader>(
+			*location,
+			(download->origin
+				? Data::FileOrigin(download->origin)
+				: Data::FileOrigin()),
+			download->type,
+			download->path,
+			download->size,
+			LoadToFileOnly,
+			LoadFromCloudOrLocal,
+			false,
+			0);
+		const auto raw = loader.get();
+		QObject::connect(raw, &FileLoader::progress, [=] {
+			if (raw->finished()) {
+				forgetResumedLoader(key, raw);
+			}
+		});
+		QObject::connect(raw, &FileLoader::failed, [=] {
+			forgetResumedLoader(key, raw);
+		});
+		_resumedLoaders.emplace(key, std::move(loader));
+		raw->start();
+	}
+}
+
+void Downloader::forgetResumedLoader(
+		MediaKey key,
+		not_null<FileLoader*> loader) {
+	// The loader is emitting a signal right now.
+	crl::on_main(this, [=] {
+		const auto i = _resumedLoaders.find(key);
+		if (i != end(_resumedLoaders) && i->second.get() == loader) {
+			_resumedLoaders.erase(i);
+		}
+	});
+}
+
+std::unique_ptr<FileLoader> Downloader::takeResumedLoader(
+		MediaKey key,
+		const QString &path) {
+	const auto i = _resumedLoaders.find(key);
+	if (i == end(_resumedLoaders)) {
+		return nullptr;
+	}
+	auto result = std::move(i->second);
+	_resumedLoaders.erase(i);
+	QObject::disconnect(result.get(), nullptr, nullptr, nullptr);
+	if (result->finished()) {
+		return nullptr;
+	} else if (!path.isEmpty() && path != result->fileName()) {
+		result->cancel();
+		return nullptr;
+	}
+	return result;
+}
+
 Downloader::~Downloader() {
 	killDownloadSessions();
 }
@@ -215,9 +458,13 @@ QImage FileLoader::imageData(const QSize &shrinkBox) const {
 	return _imageData;
 }
 
+bool FileLoader::imageDataReady() const {
+	return !_imageData.isNull() || (_locationType != UnknownFileLocation);
+}
+
 void FileLoader::readImage(const QSize &shrinkBox) const {
 	auto format = QByteArray();
-	auto image = App::readImage(_data, &format, false);
+	auto image = App::readImage(_data, &format, false, nullptr, shrinkBox);
 	if (!image.isNull()) {
 		if (!shrinkBox.isEmpty() && (image.width() > shrinkBox.width() || image.height() > shrinkBox.height())) {
 			_imageData = image.scaled(shrinkBox, Qt::KeepAspectRatio, Qt::SmoothTransformation);
@@ -325,7 +572,10 @@ void FileLoader::start() {
 	}
 
 	if (!_filename.isEmpty() && _toCache == LoadToFileOnly && !_fileIsOpen) {
-		_fileIsOpen = _file.open(QIODevice::WriteOnly);
+		const auto resumeOffset = prepareResume();
+		_fileIsOpen = resumeOffset
+			? (_file.open(QIODevice::ReadWrite) && _file.resize(resumeOffset))
+			: _file.open(QIODevice::WriteOnly);
 		if (!_fileIsOpen) {
 			return cancel(true);
 		}
@@ -449,7 +699,10 @@ bool FileLoader::tryLoadLocal() {
 
 	const auto weak = make_weak(this);
 	if (_toCache == LoadToCacheAsWell) {
-		loadLocal(cacheKey());
+		const auto key = cacheKey();
+		if (session().data().cache().mayContain(key)) {
+			loadLocal(key);
+		}
 		emit progress(this);
 	}
 	if (!weak) {
@@ -477,6 +730,9 @@ void FileLoader::cancel(bool fail) {
 		_file.close();
 		_fileIsOpen = false;
 		_file.remove();
+		if (const auto key = fileLocationKey()) {
+			Local::removePartialDownload(*key);
+		}
 	}
 	_data = QByteArray();
 	removeFromQueue();
@@ -499,12 +755,17 @@ void FileLoader::cancel(bool fail) {
 }
 
 void FileLoader::startLoading() {
-	if ((_queue->queriesCount >= _queue->queriesLimit) || _finished) {
+	if (queueFull() || _finished) {
 		return;
 	}
 	loadPart();
 }
 
+bool FileLoader::queueFull() const {
+	return (_queue->queriesCount
+		>= _downloader->queriesLimitFor(_queue, _autoLoading));
+}
+
 int FileLoader::currentOffset() const {
 	return (_fileIsOpen ? _file.size() : _data.size()) - _skippedBytes;
 }
@@ -595,6 +856,9 @@ bool FileLoader::finalizeResult() {
 	}
 	removeFromQueue();
 
+	if (const auto key = fileLocationKey()) {
+		Local::removePartialDownload(*key);
+	}
 	if (_localStatus == LocalStatus::NotFound) {
 		if (const auto key = fileLocationKey()) {
 			if (!_filename.isEmpty()) {
@@ -698,8 +962,8 @@ void mtpFileLoader::refreshFileReferenceFrom(
 		cancel(true);
 		return;
 	}
-	const auto offset = finishSentRequestGetOffset(requestId);
-	makeRequest(offset);
+	const auto requestData = finishSentRequest(requestId);
+	makeRequest(requestData.offset, requestData.limit);
 }
 
 bool mtpFileLoader::loadPart() {
@@ -707,13 +971,46 @@ bool mtpFileLoader::loadPart() {
 		return false;
 	} else if (_size && _nextRequestOffset >= _size) {
 		return false;
+	} else if (queueFull()) {
+		return false;
+	} else if (_autoLoading
+		&& _downloader->autoLoadingDeferred(
+			_queue,
+			_size,
+			!_sentRequests.empty())) {
+		return false;
 	}
 
-	makeRequest(_nextRequestOffset);
-	_nextRequestOffset += Storage::kPartSize;
+	const auto limit = chooseNextPartSize();
+	makeRequest(_nextRequestOffset, limit);
+	_nextRequestOffset += limit;
 	return true;
 }
 
+int mtpFileLoader::chooseNextPartSize() const {
+	// CDN file hashes and web files are limited to the fixed part size.
+	if (_cdnDcId
+		|| !_size
+		|| !base::get_if<StorageFileLocation>(&_location)) {
+		return Storage::kPartSize;
+	}
+
+	// Parts must not cross a 1 MB boundary, so offset is a multiple.
+	auto result = Storage::kPartSize;
+	while (result < Storage::kMaxPartSize) {
+		const auto larger = result * 2;
+		const auto wanted = larger * Storage::kPartsInFlightForGrowth;
+		if ((_nextRequestOffset % larger)
+			|| (_size - _nextRequestOffset < wanted)
+			|| (wanted > _downloader->queriesLimitFor(_queue, _autoLoading)
+				* Storage::kPartSize)) {
+			break;
+		}
+		result = larger;
+	}
+	return result;
+}
+
 MTP::DcId mtpFileLoader::dcId() const {
 	if (const auto storage = base::get_if<StorageFileLocation>(&_location)) {
 		return storage->dcId();
@@ -721,22 +1018,28 @@ MTP::DcId mtpFileLoader::dcId() const {
 	return Global::WebFileDcId();
 }
 
-mtpFileLoader::RequestData mtpFileLoader::prepareRequest(int offset) const {
+mtpFileLoader::RequestData mtpFileLoader::prepareRequest(
+		int offset,
+		int limit) const {
 	auto result = RequestData();
 	result.dcId = _cdnDcId ? _cdnDcId : dcId();
 	result.dcIndex = _size
 		? _downloader->chooseDcIndexForRequest(result.dcId)
 		: 0;
 	result.offset = offset;
+	result.limit = limit;
 	return result;
 }
 
 mtpRequestId mtpFileLoader::sendRequest(const RequestData &requestData) {
 	const auto offset = requestData.offset;
-	const auto limit = Storage::kPartSize;
+	const auto limit = requestData.limit;
 	const auto shiftedDcId = MTP::downloadDcId(
 		requestData.dcId,
 		requestData.dcIndex);
+	const auto priority = _autoLoading
+		? MTP::RequestPriority::Background
+		: MTP::RequestPriority::Normal;
 	if (_cdnDcId) {
 		Assert(requestData.dcId == _cdnDcId);
 		return MTP::send(
@@ -747,7 +1050,9 @@ mtpRequestId mtpFileLoader::sendRequest(const RequestData &requestData) {
 			rpcDone(&mtpFileLoader::cdnPartLoaded),
 			rpcFail(&mtpFileLoader::cdnPartFailed),
 			shiftedDcId,
-			50);
+			50,
+			0,
+			priority);
 	}
 	return _location.match([&](const WebFileLocation &location) {
 		return MTP::send(
@@ -760,7 +1065,9 @@ mtpRequestId mtpFileLoader::sendRequest(const RequestData &requestData) {
 			rpcDone(&mtpFileLoader::webPartLoaded),
 			rpcFail(&mtpFileLoader::partFailed),
 			shiftedDcId,
-			50);
+			50,
+			0,
+			priority);
 	}, [&](const GeoPointLocation &location) {
 		return MTP::send(
 			MTPupload_GetWebFile(
@@ -778,7 +1085,9 @@ mtpRequestId mtpFileLoader::sendRequest(const RequestData &requestData) {
 			rpcDone(&mtpFileLoader::webPartLoaded),
 			rpcFail(&mtpFileLoader::partFailed),
 			shiftedDcId,
-			50);
+			50,
+			0,
+			priority);
 	}, [&](const StorageFileLocation &location) {
 		return MTP::send(
 			MTPupload_GetFile(
@@ -791,15 +1100,23 @@ mtpRequestId mtpFileLoader::sendRequest(const RequestData &requestData) {
 				&mtpFileLoader::normalPartFailed,
 				location.fileReference()),
 			shiftedDcId,
-			50);
+			50,
+			0,
+			priority);
 	});
 }
 
-void mtpFileLoader::makeRequest(int offset) {
+void mtpFileLoader::makeRequest(int offset, int limit) {
 	Expects(!_finished);
 
-	auto requestData = prepareRequest(offset);
-	placeSentRequest(sendRequest(requestData), requestData);
+	// A large part is requested again in small ones after a cdn redirect.
+	const auto step = _cdnDcId ? Storage::kPartSize : limit;
+	for (auto part = 0; part < limit; part += step) {
+		const auto requestData = prepareRequest(
+			offset + part,
+			std::min(step, limit - part));
+		placeSentRequest(sendRequest(requestData), requestData);
+	}
 }
 
 void mtpFileLoader::requestMoreCdnFileHashes() {
@@ -814,6 +1131,7 @@ void mtpFileLoader::requestMoreCdnFileHashes() {
 	requestData.dcId = dcId();
 	requestData.dcIndex = 0;
 	requestData.offset = offset;
+	requestData.limit = Storage::kPartSize;
 	auto shiftedDcId = MTP::downloadDcId(
 		requestData.dcId,
 		requestData.dcIndex);
@@ -833,11 +1151,13 @@ void mtpFileLoader::normalPartLoaded(
 	Expects(!_finished);
 	Expects(result.type() == mtpc_upload_fileCdnRedirect || result.type() == mtpc_upload_file);
 
-	auto offset = finishSentRequestGetOffset(requestId);
+	const auto requestData = finishSentRequest(requestId);
+	const auto offset = requestData.offset;
 	if (result.type() == mtpc_upload_fileCdnRedirect) {
-		return switchToCDN(offset, result.c_upload_fileCdnRedirect());
+		return switchToCDN(requestData, result.c_upload_fileCdnRedirect());
 	}
 	auto buffer = bytes::make_span(result.c_upload_file().vbytes().v);
+	countLoadedPart(requestData, buffer.size());
 	return partLoaded(offset, buffer);
 }
 
@@ -845,7 +1165,9 @@ void mtpFileLoader::webPartLoaded(
 		const MTPupload_WebFile &result,
 		mtpRequestId requestId) {
 	result.match([&](const MTPDupload_webFile &data) {
-		const auto offset = finishSentRequestGetOffset(requestId);
+		const auto requestData = finishSentRequest(requestId);
+		const auto offset = requestData.offset;
+		countLoadedPart(requestData, data.vbytes().v.size());
 		if (!_size) {
 			_size = data.vsize().v;
 		} else if (data.vsize().v != _size) {
@@ -863,12 +1185,14 @@ void mtpFileLoader::webPartLoaded(
 void mtpFileLoader::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId requestId) {
 	Expects(!_finished);
 
-	const auto offset = finishSentRequestGetOffset(requestId);
+	const auto requestData = finishSentRequest(requestId);
+	const auto offset = requestData.offset;
 	result.match([&](const MTPDupload_cdnFileReuploadNeeded &data) {
 		auto requestData = RequestData();
 		requestData.dcId = dcId();
 		requestData.dcIndex = 0;
 		requestData.offset = offset;
+		requestData.limit = Storage::kPartSize;
 		const auto shiftedDcId = MTP::downloadDcId(
 			requestData.dcId,
 			requestData.dcIndex);
@@ -898,6 +1222,7 @@ void mtpFileLoader::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId
 
 		auto decryptInPlace = data.vbytes().v;
 		auto buffer = bytes::make_detached_span(decryptInPlace);
+		countLoadedPart(requestData, buffer.size());
 		MTP::aesCtrEncrypt(buffer, key.data(), &state);
 
 		switch (checkCdnFileHash(offset, buffer)) {
@@ -937,9 +1262,9 @@ mtpFileLoader::CheckCdnHashResult mtpFileLoader::checkCdnFileHash(
 void mtpFileLoader::reuploadDone(
 		const MTPVector<MTPFileHash> &result,
 		mtpRequestId requestId) {
-	auto offset = finishSentRequestGetOffset(requestId);
+	const auto requestData = finishSentRequest(requestId);
 	addCdnHashes(result.v);
-	makeRequest(offset);
+	makeRequest(requestData.offset, requestData.limit);
 }
 
 void mtpFileLoader::getCdnFileHashesDone(
@@ -1009,12 +1334,21 @@ void mtpFileLoader::placeSentRequest(
 	_downloader->requestedAmountIncrement(
 		requestData.dcId,
 		requestData.dcIndex,
-		Storage::kPartSize);
-	++_queue->queriesCount;
-	_sentRequests.emplace(requestId, requestData);
+		requestData.limit);
+	const auto queries = Storage::QueriesForPart(requestData.limit);
+	_queue->queriesCount += queries;
+	if (_autoLoading) {
+		_queue->autoQueriesCount += queries;
+		if (_sentRequests.empty()) {
+			++_queue->autoLoadersCount;
+		}
+	}
+	auto &sent = _sentRequests.emplace(requestId, requestData).first->second;
+	sent.sent = crl::now();
 }
 
-int mtpFileLoader::finishSentRequestGetOffset(mtpRequestId requestId) {
+mtpFileLoader::RequestData mtpFileLoader::finishSentRequest(
+		mtpRequestId requestId) {
 	auto it = _sentRequests.find(requestId);
 	Assert(it != _sentRequests.cend());
 
@@ -1022,18 +1356,116 @@ int mtpFileLoader::finishSentRequestGetOffset(mtpRequestId requestId) {
 	_downloader->requestedAmountIncrement(
 		requestData.dcId,
 		requestData.dcIndex,
-		-Storage::kPartSize);
+		-requestData.limit);
 
-	--_queue->queriesCount;
+	const auto queries = Storage::QueriesForPart(requestData.limit);
+	_queue->queriesCount -= queries;
 	_sentRequests.erase(it);
+	if (_autoLoading) {
+		_queue->autoQueriesCount -= queries;
+		if (_sentRequests.empty()) {
+			--_queue->autoLoadersCount;
+		}
+	}
+
+	return requestData;
+}
 
-	return requestData.offset;
+int mtpFileLoader::finishSentRequestGetOffset(mtpRequestId requestId) {
+	return finishSentRequest(requestId).offset;
+}
+
+void mtpFileLoader::countLoadedPart(
+		const RequestData &requestData,
+		int amount) {
+	_downloader->requestSucceeded(
+		requestData.dcId,
+		crl::now() - requestData.sent,
+		amount);
+}
+
+void mtpFileLoader::countFailedPart(
+		const RPCError &error,
+		mtpRequestId requestId) {
+	if (!MTP::isFloodError(error)) {
+		return;
+	}
+	const auto i = _sentRequests.find(requestId);
+	if (i != end(_sentRequests)) {
+		_downloader->requestFlooded(i->second.dcId);
+	}
+}
+
+int mtpFileLoader::prepareResume() {
+	const auto key = fileLocationKey();
+	if (!key || !base::get_if<StorageFileLocation>(&_location)) {
+		return 0;
+	}
+	const auto download = Local::readPartialDownload(*key);
+	if (!download) {
+		return 0;
+	}
+	const auto loaded = download->loaded;
+	if (download->path != _filename
+		|| download->size != _size
+		|| loaded <= 0
+		|| loaded >= _size
+		|| (loaded % Storage::kPartSize)
+		|| QFileInfo(_filename).size() < loaded) {
+		Local::removePartialDownload(*key);
+		return 0;
+	}
+	_nextRequestOffset = _resumeLoaded = _resumeSaved = loaded;
+	return loaded;
+}
+
+void mtpFileLoader::rememberResumePart(int offset, int size) {
+	if (!_fileIsOpen
+		|| _toCache != LoadToFileOnly
+		|| !_size
+		|| offset < _resumeLoaded) {
+		return;
+	} else if (offset > _resumeLoaded) {
+		_resumeParts.emplace(offset, size);
+		return;
+	}
+	_resumeLoaded += size;
+	for (auto i = _resumeParts.begin()
+		; (i != _resumeParts.end()) && (i->first == _resumeLoaded)
+		; i = _resumeParts.erase(i)) {
+		_resumeLoaded += i->second;
+	}
+	if (_resumeLoaded - _resumeSaved >= Storage::kResumeSaveStep
+		&& _resumeLoaded < _size) {
+		writeResumeState();
+	}
+}
+
+void mtpFileLoader::writeResumeState() {
+	const auto key = fileLocationKey();
+	const auto storage = base::get_if<StorageFileLocation>(&_location);
+	if (!key || !storage || !_file.flush()) {
+		return;
+	}
+	auto download = Local::PartialDownload();
+	download.location = storage->serialize();
+	if (const auto message = base::get_if<Data::FileOriginMessage>(
+			&_origin.data)) {
+		download.origin = *message;
+	}
+	download.path = _filename;
+	download.size = _size;
+	download.loaded = _resumeLoaded;
+	download.type = _locationType;
+	Local::writePartialDownload(*key, download);
+	_resumeSaved = _resumeLoaded;
 }
 
 bool mtpFileLoader::feedPart(int offset, bytes::const_span buffer) {
 	if (!writeResultPart(offset, buffer)) {
 		return false;
 	}
+	rememberResumePart(offset, buffer.size());
 	if (buffer.empty() || (buffer.size() % 1024)) { // bad next offset
 		_lastComplete = true;
 	}
@@ -1056,6 +1488,7 @@ bool mtpFileLoader::normalPartFailed(
 		QByteArray fileReference,
 		const RPCError &error,
 		mtpRequestId requestId) {
+	countFailedPart(error, requestId);
 	if (MTP::isDefaultHandledError(error)) {
 		return false;
 	}
@@ -1075,6 +1508,7 @@ bool mtpFileLoader::normalPartFailed(
 bool mtpFileLoader::partFailed(
 		const RPCError &error,
 		mtpRequestId requestId) {
+	countFailedPart(error, requestId);
 	if (MTP::isDefaultHandledError(error)) {
 		return false;
 	}
@@ -1085,6 +1519,7 @@ bool mtpFileLoader::partFailed(
 bool mtpFileLoader::cdnPartFailed(
 		const RPCError &error,
 		mtpRequestId requestId) {
+	countFailedPart(error, requestId);
 	if (MTP::isDefaultHandledError(error)) {
 		return false;
 	}
@@ -1094,9 +1529,9 @@ bool mtpFileLoader::cdnPartFailed(
 	}
 	if (error.type() == qstr("FILE_TOKEN_INVALID")
 		|| error.type() == qstr("REQUEST_TOKEN_INVALID")) {
-		auto offset = finishSentRequestGetOffset(requestId);
+		const auto requestData = finishSentRequest(requestId);
 		changeCDNParams(
-			offset,
+			requestData,
 			0,
 			QByteArray(),
 			QByteArray(),
@@ -1116,10 +1551,10 @@ void mtpFileLoader::cancelRequests() {
 }
 
 void mtpFileLoader::switchToCDN(
-		int offset,
+		const RequestData &requestData,
 		const MTPDupload_fileCdnRedirect &redirect) {
 	changeCDNParams(
-		offset,
+		requestData,
 		redirect.vdc_id().v,
 		redirect.vfile_token().v,
 		redirect.vencryption_key().v,
@@ -1138,7 +1573,7 @@ void mtpFileLoader::addCdnHashes(const QVector<MTPFileHash> &hashes) {
 }
 
 void mtpFileLoader::changeCDNParams(
-		int offset,
+		const RequestData &requestData,
 		MTP::DcId dcId,
 		const QByteArray &token,
 		const QByteArray &encryptionKey,
@@ -1163,19 +1598,18 @@ void mtpFileLoader::changeCDNParams(
 	addCdnHashes(hashes);
 
 	if (resendAllRequests && !_sentRequests.empty()) {
-		auto resendOffsets = std::vector<int>();
-		resendOffsets.reserve(_sentRequests.size());
+		auto resendRequests = std::vector<RequestData>();
+		resendRequests.reserve(_sentRequests.size());
 		while (!_sentRequests.empty()) {
 			auto requestId = _sentRequests.begin()->first;
 			MTP::cancel(requestId);
-			auto resendOffset = finishSentRequestGetOffset(requestId);
-			resendOffsets.push_back(resendOffset);
+			resendRequests.push_back(finishSentRequest(requestId));
 		}
-		for (auto resendOffset : resendOffsets) {
-			makeRequest(resendOffset);
+		for (const auto &resend : resendRequests) {
+			makeRequest(resend.offset, resend.limit);
 		}
 	}
-	makeRequest(offset);
+	makeRequest(requestData.offset, requestData.limit);
 }
 
 Storage::Cache::Key mtpFileLoader::cacheKey() const {
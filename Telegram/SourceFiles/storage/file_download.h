@@ -10,9 +10,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/observer.h"
 #include "base/timer.h"
 #include "base/binary_guard.h"
+#include "base/weak_ptr.h"
 #include "data/data_file_origin.h"
 
 class ApiWrap;
+class FileLoader;
 
 namespace Main {
 class Session;
@@ -32,13 +34,15 @@ constexpr auto kMaxWallPaperInMemory = kMaxFileInMemory;
 constexpr auto kMaxAnimationInMemory = kMaxFileInMemory; // 10 MB gif and mp4 animations held in memory while playing
 constexpr auto kMaxWallPaperDimension = 4096; // 4096x4096 is max area.
 
-class Downloader final {
+class Downloader final : public base::has_weak_ptr {
 public:
 	struct Queue {
 		Queue(int queriesLimit) : queriesLimit(queriesLimit) {
 		}
 		int queriesCount = 0;
 		int queriesLimit = 0;
+		int autoQueriesCount = 0;
+		int autoLoadersCount = 0;
 		FileLoader *start = nullptr;
 		FileLoader *end = nullptr;
 	};
@@ -59,30 +63,88 @@ public:
 		return _taskFinishedObservable;
 	}
 
+	struct DcStats {
+		int sessionsCount = 0;
+		int queriesLimit = 0;
+		int64 bytesPerSecond = 0;
+		crl::time rtt = 0;
+		crl::time minRtt = 0;
+	};
+
 	void requestedAmountIncrement(MTP::DcId dcId, int index, int amount);
 	int chooseDcIndexForRequest(MTP::DcId dcId) const;
 
+	// While parts of a played video are requested the other file loaders
+	// get only a share of the queries limit, auto loading the smallest.
+	void streamingRequestsIncrement(int amount);
+	[[nodiscard]] int queriesLimitFor(
+		not_null<const Queue*> queue,
+		bool autoLoading) const;
+
+	// Auto loaders wait while the queue has too many of them started,
+	// large ones wait while the user loads anything from this queue.
+	[[nodiscard]] bool autoLoadingDeferred(
+		not_null<const Queue*> queue,
+		int size,
+		bool started) const;
+
+	// Measurements for adapting the sessions count and queries limit.
+	void requestSucceeded(MTP::DcId dcId, crl::time duration, int amount);
+	void requestFlooded(MTP::DcId dcId);
+	[[nodiscard]] DcStats dcStats(MTP::DcId dcId) const;
+	[[nodiscard]] rpl::producer<MTP::DcId> dcStatsUpdated() const;
+
 	not_null<Queue*> queueForDc(MTP::DcId dcId);
 	not_null<Queue*> queueForWeb();
 
+	// Downloads interrupted by the last quit continue in background,
+	// until the document starts loading the same file again.
+	[[nodiscard]] std::unique_ptr<FileLoader> takeResumedLoader(
+		MediaKey key,
+		const QString &path);
+
 private:
+	using RequestedInDc = std::array<int64, MTP::kDownloadSessionsCountMax>;
+	struct DcState {
+		RequestedInDc requested = { { 0 } };
+		int sessionsCount = MTP::kDownloadSessionsCount;
+		bool saturated = false;
+		crl::time windowStart = 0;
+		int64 windowBytes = 0;
+		crl::time rtt = 0;
+		crl::time minRtt = 0;
+		crl::time minRttUpdated = 0;
+		int64 bytesPerSecond = 0;
+		crl::time floodUntil = 0;
+	};
+
+	DcState &dcState(MTP::DcId dcId);
+	void adjustForDc(MTP::DcId dcId, DcState &state, crl::time now);
+
 	void killDownloadSessionsStart(MTP::DcId dcId);
 	void killDownloadSessionsStop(MTP::DcId dcId);
 	void killDownloadSessions();
 
+	void resumePartialDownloads();
+	void forgetResumedLoader(MediaKey key, not_null<FileLoader*> loader);
+
 	not_null<ApiWrap*> _api;
 
 	base::Observable<void> _taskFinishedObservable;
 	int _priority = 1;
 
-	using RequestedInDc = std::array<int64, MTP::kDownloadSessionsCount>;
-	std::map<MTP::DcId, RequestedInDc> _requestedBytesAmount;
+	std::map<MTP::DcId, DcState> _dcStates;
+	rpl::event_stream<MTP::DcId> _dcStatsUpdated;
 
 	base::flat_map<MTP::DcId, crl::time> _killDownloadSessionTimes;
 	base::Timer _killDownloadSessionsTimer;
 
 	std::map<MTP::DcId, Queue> _queuesForDc;
 	Queue _queueForWeb;
+	int _streamingRequests = 0;
+
+	base::Timer _resumeTimer;
+	base::flat_map<MediaKey, std::unique_ptr<FileLoader>> _resumedLoaders;
 
 };
 
@@ -130,6 +192,9 @@ public:
 	}
 	QByteArray imageFormat(const QSize &shrinkBox = QSize()) const;
 	QImage imageData(const QSize &shrinkBox = QSize()) const;
+
+	// True if imageData() returns without decoding the bytes.
+	bool imageDataReady() const;
 	QString fileName() const {
 		return _filename;
 	}
@@ -188,6 +253,11 @@ protected:
 	virtual std::optional<MediaKey> fileLocationKey() const = 0;
 	virtual void cancelRequests() = 0;
 
+	// Returns the offset to continue writing the file from.
+	virtual int prepareResume() {
+		return 0;
+	}
+
 	void startLoading();
 	void removeFromQueue();
 	void cancel(bool failed);
@@ -195,6 +265,7 @@ protected:
 	void notifyAboutProgress();
 	static void LoadNextFromQueue(not_null<Queue*> queue);
 	virtual bool loadPart() = 0;
+	[[nodiscard]] bool queueFull() const;
 
 	bool writeResultPart(int offset, bytes::const_span buffer);
 	bool finalizeResult();
@@ -230,6 +301,8 @@ protected:
 	mutable QByteArray _imageFormat;
 	mutable QImage _imageData;
 
+	friend class Storage::Downloader;
+
 };
 
 class StorageImageLocation;
@@ -278,6 +351,8 @@ private:
 		MTP::DcId dcId = 0;
 		int dcIndex = 0;
 		int offset = 0;
+		int limit = 0;
+		crl::time sent = 0;
 	};
 	struct CdnFileHash {
 		CdnFileHash(int limit, QByteArray hash) : limit(limit), hash(hash) {
@@ -290,8 +365,9 @@ private:
 	void cancelRequests() override;
 
 	MTP::DcId dcId() const;
-	RequestData prepareRequest(int offset) const;
-	void makeRequest(int offset);
+	RequestData prepareRequest(int offset, int limit) const;
+	void makeRequest(int offset, int limit);
+	int chooseNextPartSize() const;
 
 	bool loadPart() override;
 	void normalPartLoaded(const MTPupload_File &result, mtpRequestId requestId);
@@ -310,10 +386,17 @@ private:
 
 	mtpRequestId sendRequest(const RequestData &requestData);
 	void placeSentRequest(mtpRequestId requestId, const RequestData &requestData);
+	RequestData finishSentRequest(mtpRequestId requestId);
 	int finishSentRequestGetOffset(mtpRequestId requestId);
-	void switchToCDN(int offset, const MTPDupload_fileCdnRedirect &redirect);
+	void countLoadedPart(const RequestData &requestData, int amount);
+	void countFailedPart(const RPCError &error, mtpRequestId requestId);
+
+	int prepareResume() override;
+	void rememberResumePart(int offset, int size);
+	void writeResumeState();
+	void switchToCDN(const RequestData &requestData, const MTPDupload_fileCdnRedirect &redirect);
 	void addCdnHashes(const QVector<MTPFileHash> &hashes);
-	void changeCDNParams(int offset, MTP::DcId dcId, const QByteArray &token, const QByteArray &encryptionKey, const QByteArray &encryptionIV, const QVector<MTPFileHash> &hashes);
+	void changeCDNParams(const RequestData &requestData, MTP::DcId dcId, const QByteArray &token, const QByteArray &encryptionKey, const QByteArray &encryptionIV, const QVector<MTPFileHash> &hashes);
 
 	enum class CheckCdnHashResult {
 		NoHash,
@@ -327,6 +410,11 @@ private:
 	bool _lastComplete = false;
 	int32 _nextRequestOffset = 0;
 
+	// Parts written after the first gap are kept until it is filled.
+	int _resumeLoaded = 0;
+	int _resumeSaved = 0;
+	base::flat_map<int, int> _resumeParts;
+
 	base::variant<
 		StorageFileLocation,
 		WebFileLocation,
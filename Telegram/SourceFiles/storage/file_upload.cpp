@@ -38,14 +38,36 @@ constexpr auto kDocumentUploadPartSize3 = 256 * 1024;
 // 512kb for large document ( <= 1500mb )
 constexpr auto kDocumentUploadPartSize4 = 512 * 1024;
 
-// One part each half second, if not uploaded faster.
-constexpr auto kUploadRequestInterval = crl::time(500);
+// Voice messages are sent while recording by parts of this size.
+constexpr auto kStreamedPartSize = kDocumentUploadPartSize0;
+
+// Parts of a file on disk read by a worker before they are sent.
+constexpr auto kReadAheadParts = 4;
+
+// Files uploaded at the same time, sharing the parallel size limit.
+constexpr auto kMaxUploadingFiles = 4;
 
 // How much time without upload causes additional session kill.
 constexpr auto kKillSessionTimeout = crl::time(5000);
 
 } // namespace
 
+// Owned by Uploader::File, used by a worker thread while a read runs.
+struct Uploader::DocumentReader {
+	explicit DocumentReader(const QString &path) : file(path) {
+	}
+
+	QFile file;
+	HashMd5 md5Hash;
+};
+
+// Recorded bytes, sent by full parts until the document is uploaded.
+struct Uploader::StreamedDocument {
+	QByteArray data;
+	int32 sentParts = 0;
+	bool failed = false;
+};
+
 struct Uploader::File {
 	File(const SendMediaReady &media);
 	File(const std::shared_ptr<FileLoadResult> &file);
@@ -65,7 +87,12 @@ struct Uploader::File {
 
 	HashMd5 md5Hash;
 
-	std::unique_ptr<QFile> docFile;
+	std::shared_ptr<DocumentReader> docReader;
+	std::deque<QByteArray> docReadParts;
+	int32 docReadCount = 0;
+	bool docReading = false;
+	int32 requestsCount = 0;
+	int32 docRequestsCount = 0;
 	int32 docSentParts = 0;
 	int32 docSize = 0;
 	int32 docPartSize = 0;
@@ -142,8 +169,6 @@ const QString &Uploader::File::filename() const {
 
 Uploader::Uploader(not_null<ApiWrap*> api)
 : _api(api) {
-	nextTimer.setSingleShot(true);
-	connect(&nextTimer, SIGNAL(timeout()), this, SLOT(sendNext()));
 	stopSessionsTimer.setSingleShot(true);
 	connect(&stopSessionsTimer, SIGNAL(timeout()), this, SLOT(stopSessions()));
 }
@@ -223,12 +248,79 @@ void Uploader::upload(
 			document->setLocation(FileLocation(file->filepath));
 		}
 	}
-	queue.emplace(msgId, File(file));
+	auto &added = queue.emplace(msgId, File(file)).first->second;
+	adoptStreamed(msgId, added);
+	sendNext();
+}
+
+uint64 Uploader::startStreamed() {
+	const auto id = rand_value<uint64>();
+	_streamed.emplace(id, StreamedDocument());
+	return id;
+}
+
+void Uploader::feedStreamed(uint64 id, const QByteArray &bytes) {
+	const auto i = _streamed.find(id);
+	if (i == end(_streamed) || i->second.failed) {
+		return;
+	}
+	auto &streamed = i->second;
+	streamed.data.append(bytes);
+	if (streamed.data.size() > kUseBigFilesFrom) {
+		// Big files parts require the parts count, it is not known yet.
+		streamed.failed = true;
+	}
 	sendNext();
 }
 
-void Uploader::currentFailed() {
-	auto j = queue.find(uploadingId);
+void Uploader::cancelStreamed(uint64 id) {
+	_streamed.erase(id);
+	for (auto i = requestsSent.begin(); i != requestsSent.end();) {
+		if (i->second.streamedId == id) {
+			MTP::cancel(i->first);
+			sentSize -= i->second.size;
+			sentSizes[i->second.dc] -= i->second.size;
+			i = requestsSent.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void Uploader::adoptStreamed(const FullMsgId &msgId, File &file) {
+	const auto id = file.id();
+	const auto i = _streamed.find(id);
+	if (i == end(_streamed)) {
+		return;
+	}
+	const auto &content = file.file->content;
+	if (i->second.failed
+		|| file.type() != SendMediaType::Audio
+		|| content.size() > kUseBigFilesFrom
+		|| !content.startsWith(i->second.data)) {
+		// The whole file will be sent once again.
+		cancelStreamed(id);
+		return;
+	}
+	const auto sentParts = i->second.sentParts;
+	_streamed.erase(i);
+
+	// The parts still being sent are finished as parts of this file.
+	for (auto &[requestId, request] : requestsSent) {
+		if (request.streamedId == id) {
+			request.fullId = msgId;
+			request.streamedId = 0;
+			++file.docRequestsCount;
+		}
+	}
+	const auto good = file.setPartSize(kStreamedPartSize);
+	Assert(good);
+	file.docSentParts = sentParts;
+	file.md5Hash.feed(content.constData(), sentParts * kStreamedPartSize);
+}
+
+void Uploader::failed(FullMsgId fullId) {
+	auto j = queue.find(fullId);
 	if (j != queue.end()) {
 		if (j->second.type() == SendMediaType::Photo) {
 			_photoFailed.fire_copy(j->first);
@@ -243,21 +335,22 @@ void Uploader::currentFailed() {
 		} else if (j->second.type() == SendMediaType::Secure) {
 			_secureFailed.fire_copy(j->first);
 		} else {
-			Unexpected("Type in Uploader::currentFailed.");
+			Unexpected("Type in Uploader::failed.");
 		}
 		queue.erase(j);
 	}
 
-	requestsSent.clear();
-	docRequestsSent.clear();
-	dcMap.clear();
-	uploadingId = FullMsgId();
-	sentSize = 0;
-	for (int i = 0; i < MTP::kUploadSessionsCount; ++i) {
-		sentSizes[i] = 0;
+	for (auto i = requestsSent.begin(); i != requestsSent.end();) {
+		if (i->second.fullId == fullId) {
+			MTP::cancel(i->first);
+			sentSize -= i->second.size;
+			sentSizes[i->second.dc] -= i->second.size;
+			i = requestsSent.erase(i);
+		} else {
+			++i;
+		}
 	}
-
-	sendNext();
+	uploading.erase(ranges::remove(uploading, fullId), uploading.end());
 }
 
 void Uploader::stopSessions() {
@@ -267,35 +360,150 @@ void Uploader::stopSessions() {
 }
 
 void Uploader::sendNext() {
-	if (sentSize >= kMaxUploadFileParallelSize || _pausedId.msg) return;
+	// Each acknowledged part frees the window, so the sending is paced
+	// by the acks instead of a timer.
+	while (sendStreamedPart() || sendPart()) {
+	}
+}
+
+int Uploader::chooseDc() const {
+	auto result = 0;
+	for (auto dc = 1; dc != MTP::kUploadSessionsCount; ++dc) {
+		if (sentSizes[dc] < sentSizes[result]) {
+			result = dc;
+		}
+	}
+	return result;
+}
+
+bool Uploader::sendStreamedPart() {
+	if (sentSize >= kMaxUploadFileParallelSize) {
+		return false;
+	}
+	for (auto &[id, streamed] : _streamed) {
+		const auto offset = streamed.sentParts * kStreamedPartSize;
+		if (streamed.failed
+			|| streamed.data.size() < offset + kStreamedPartSize) {
+			continue;
+		}
+		if (stopSessionsTimer.isActive()) {
+			stopSessionsTimer.stop();
+		}
+		const auto todc = chooseDc();
+		const auto requestId = MTP::send(
+			MTPupload_SaveFilePart(
+				MTP_long(id),
+				MTP_int(streamed.sentParts),
+				MTP_bytes(streamed.data.mid(offset, kStreamedPartSize))),
+			rpcDone(&Uploader::partLoaded),
+			rpcFail(&Uploader::partFailed),
+			MTP::uploadDcId(todc));
+		requestsSent.emplace(requestId, Request{
+			FullMsgId(),
+			todc,
+			kStreamedPartSize,
+			true,
+			id });
+		sentSize += kStreamedPartSize;
+		sentSizes[todc] += kStreamedPartSize;
+		++streamed.sentParts;
+		return true;
+	}
+	return false;
+}
+
+void Uploader::readAhead(const FullMsgId &msgId, File &file) {
+	if (file.docReading
+		|| file.docReadCount >= file.docPartsCount
+		|| int(file.docReadParts.size()) >= kReadAheadParts) {
+		return;
+	}
+	if (!file.docReader) {
+		file.docReader = std::make_shared<DocumentReader>(file.file
+			? file.file->filepath
+			: file.media.file);
+	}
+	file.docReading = true;
+	const auto reader = file.docReader;
+	const auto size = file.docPartSize;
+	const auto hash = (file.docSize <= kUseBigFilesFrom);
+	crl::async([=, weak = base::make_weak(this)] {
+		auto part = QByteArray();
+		if (reader->file.isOpen()
+			|| reader->file.open(QIODevice::ReadOnly)) {
+			part = reader->file.read(size);
+			if (hash) {
+				reader->md5Hash.feed(part.constData(), part.size());
+			}
+		}
+		crl::on_main(weak, [=, part = std::move(part)]() mutable {
+			partRead(msgId, reader.get(), std::move(part));
+		});
+	});
+}
+
+void Uploader::partRead(
+		const FullMsgId &msgId,
+		not_null<DocumentReader*> reader,
+		QByteArray &&part) {
+	const auto i = queue.find(msgId);
+	if (i == queue.end() || i->second.docReader.get() != reader) {
+		return;
+	}
+	auto &file = i->second;
+	file.docReading = false;
+	if (part.isEmpty()) {
+		failed(msgId);
+		sendNext();
+		return;
+	}
+	file.docReadParts.push_back(std::move(part));
+	++file.docReadCount;
+	readAhead(msgId, file);
+	sendNext();
+}
+
+bool Uploader::sendPart() {
+	if (sentSize >= kMaxUploadFileParallelSize || _pausedId.msg) {
+		return false;
+	}
 
 	bool stopping = stopSessionsTimer.isActive();
 	if (queue.empty()) {
-		if (!stopping) {
+		if (!stopping && _streamed.empty()) {
 			stopSessionsTimer.start(
 				MTP::kAckSendWaiting + kKillSessionTimeout);
 		}
-		return;
+		return false;
 	}
 
 	if (stopping) {
 		stopSessionsTimer.stop();
 	}
-	auto i = uploadingId.msg ? queue.find(uploadingId) : queue.begin();
-	if (!uploadingId.msg) {
-		uploadingId = i->first;
-	} else if (i == queue.end()) {
-		i = queue.begin();
-		uploadingId = i->first;
+	for (auto i = queue.begin()
+		; (i != queue.end()) && (int(uploading.size()) < kMaxUploadingFiles)
+		; ++i) {
+		if (ranges::find(uploading, i->first) == uploading.end()) {
+			uploading.push_back(i->first);
+		}
 	}
-	auto &uploadingData = i->second;
 
-	auto todc = 0;
-	for (auto dc = 1; dc != MTP::kUploadSessionsCount; ++dc) {
-		if (sentSizes[dc] < sentSizes[todc]) {
-			todc = dc;
+	// Files take turns, one part each, while they have parts ready.
+	for (auto i = 0, count = int(uploading.size()); i != count; ++i) {
+		const auto index = (nextUploading + i) % count;
+		const auto fullId = uploading[index];
+		const auto j = queue.find(fullId);
+		Assert(j != queue.end());
+		if (sendPart(fullId, j->second)) {
+			nextUploading = index + 1;
+			return true;
 		}
 	}
+	return false;
+}
+
+bool Uploader::sendPart(const FullMsgId &uploadingId, File &uploadingData) {
+	const auto todc = chooseDc();
 
 	auto &parts = uploadingData.file
 		? ((uploadingData.type() == SendMediaType::Photo
@@ -311,7 +519,8 @@ void Uploader::sendNext() {
 		: uploadingData.media.thumbId;
 	if (parts.isEmpty()) {
 		if (uploadingData.docSentParts >= uploadingData.docPartsCount) {
-			if (requestsSent.empty() && docRequestsSent.empty()) {
+			if (!uploadingData.requestsCount
+				&& !uploadingData.docRequestsCount) {
 				const auto silent = uploadingData.file
 					&& uploadingData.file->to.silent;
 				const auto edit = uploadingData.file &&
@@ -336,8 +545,11 @@ void Uploader::sendNext() {
 				} else if (uploadingData.type() == SendMediaType::File
 					|| uploadingData.type() == SendMediaType::WallPaper
 					|| uploadingData.type() == SendMediaType::Audio) {
+					auto &md5Hash = uploadingData.docReader
+						? uploadingData.docReader->md5Hash
+						: uploadingData.md5Hash;
 					QByteArray docMd5(32, Qt::Uninitialized);
-					hashMd5Hex(uploadingData.md5Hash.result(), docMd5.data());
+					hashMd5Hex(md5Hash.result(), docMd5.data());
 
 					const auto file = (uploadingData.docSize > kUseBigFilesFrom)
 						? MTP_inputFileBig(
@@ -380,11 +592,14 @@ void Uploader::sendNext() {
 						uploadingData.id(),
 						uploadingData.partsCount });
 				}
-				queue.erase(uploadingId);
-				uploadingId = FullMsgId();
-				sendNext();
+				const auto fullId = uploadingId;
+				uploading.erase(
+					ranges::remove(uploading, fullId),
+					uploading.end());
+				queue.erase(fullId);
+				return true;
 			}
-			return;
+			return false;
 		}
 
 		auto &content = uploadingData.file
@@ -392,20 +607,13 @@ void Uploader::sendNext() {
 			: uploadingData.media.data;
 		QByteArray toSend;
 		if (content.isEmpty()) {
-			if (!uploadingData.docFile) {
-				const auto filepath = uploadingData.file
-					? uploadingData.file->filepath
-					: uploadingData.media.file;
-				uploadingData.docFile = std::make_unique<QFile>(filepath);
-				if (!uploadingData.docFile->open(QIODevice::ReadOnly)) {
-					currentFailed();
-					return;
-				}
-			}
-			toSend = uploadingData.docFile->read(uploadingData.docPartSize);
-			if (uploadingData.docSize <= kUseBigFilesFrom) {
-				uploadingData.md5Hash.feed(toSend.constData(), toSend.size());
+			if (uploadingData.docReadParts.empty()) {
+				readAhead(uploadingId, uploadingData);
+				return false;
 			}
+			toSend = std::move(uploadingData.docReadParts.front());
+			uploadingData.docReadParts.pop_front();
+			readAhead(uploadingId, uploadingData);
 		} else {
 			const auto offset = uploadingData.docSentParts
 				* uploadingData.docPartSize;
@@ -420,8 +628,8 @@ void Uploader::sendNext() {
 		if ((toSend.size() > uploadingData.docPartSize)
 			|| ((toSend.size() < uploadingData.docPartSize
 				&& uploadingData.docSentParts + 1 != uploadingData.docPartsCount))) {
-			currentFailed();
-			return;
+			failed(uploadingId);
+			return true;
 		}
 		mtpRequestId requestId;
 		if (uploadingData.docSize > kUseBigFilesFrom) {
@@ -444,8 +652,12 @@ void Uploader::sendNext() {
 				rpcFail(&Uploader::partFailed),
 				MTP::uploadDcId(todc));
 		}
-		docRequestsSent.emplace(requestId, uploadingData.docSentParts);
-		dcMap.emplace(requestId, todc);
+		requestsSent.emplace(requestId, Request{
+			uploadingId,
+			todc,
+			uploadingData.docPartSize,
+			true });
+		++uploadingData.docRequestsCount;
 		sentSize += uploadingData.docPartSize;
 		sentSizes[todc] += uploadingData.docPartSize;
 
@@ -461,20 +673,25 @@ void Uploader::sendNext() {
 			rpcDone(&Uploader::partLoaded),
 			rpcFail(&Uploader::partFailed),
 			MTP::uploadDcId(todc));
-		requestsSent.emplace(requestId, part.value());
-		dcMap.emplace(requestId, todc);
+		requestsSent.emplace(requestId, Request{
+			uploadingId,
+			todc,
+			part.value().size(),
+			false });
+		++uploadingData.requestsCount;
 		sentSize += part.value().size();
 		sentSizes[todc] += part.value().size();
 
 		parts.erase(part);
 	}
-	nextTimer.start(kUploadRequestInterval);
+	return true;
 }
 
 void Uploader::cancel(const FullMsgId &msgId) {
 	uploaded.erase(msgId);
-	if (uploadingId == msgId) {
-		currentFailed();
+	if (ranges::find(uploading, msgId) != uploading.end()) {
+		failed(msgId);
+		sendNext();
 	} else {
 		queue.erase(msgId);
 	}
@@ -495,15 +712,12 @@ void Uploader::confirm(const FullMsgId &msgId) {
 void Uploader::clear() {
 	uploaded.clear();
 	queue.clear();
+	_streamed.clear();
+	uploading.clear();
 	for (const auto &requestData : requestsSent) {
 		MTP::cancel(requestData.first);
 	}
 	requestsSent.clear();
-	for (const auto &requestData : docRequestsSent) {
-		MTP::cancel(requestData.first);
-	}
-	docRequestsSent.clear();
-	dcMap.clear();
 	sentSize = 0;
 	for (int i = 0; i < MTP::kUploadSessionsCount; ++i) {
 		MTP::stopSession(MTP::uploadDcId(i));
@@ -513,65 +727,64 @@ void Uploader::clear() {
 }
 
 void Uploader::partLoaded(const MTPBool &result, mtpRequestId requestId) {
-	auto j = docRequestsSent.end();
-	auto i = requestsSent.find(requestId);
-	if (i == requestsSent.cend()) {
-		j = docRequestsSent.find(requestId);
-	}
-	if (i != requestsSent.cend() || j != docRequestsSent.cend()) {
-		if (mtpIsFalse(result)) { // failed to upload current file
-			currentFailed();
-			return;
-		} else {
-			auto dcIt = dcMap.find(requestId);
-			if (dcIt == dcMap.cend()) { // must not happen
-				currentFailed();
-				return;
-			}
-			auto dc = dcIt->second;
-			dcMap.erase(dcIt);
-
-			int32 sentPartSize = 0;
-			auto k = queue.find(uploadingId);
-			Assert(k != queue.cend());
-			auto &[fullId, file] = *k;
-			if (i != requestsSent.cend()) {
-				sentPartSize = i->second.size();
-				requestsSent.erase(i);
-			} else {
-				sentPartSize = file.docPartSize;
-				docRequestsSent.erase(j);
-			}
-			sentSize -= sentPartSize;
-			sentSizes[dc] -= sentPartSize;
-			if (file.type() == SendMediaType::Photo) {
-				file.fileSentSize += sentPartSize;
-				const auto photo = Auth().data().photo(file.id());
-				if (photo->uploading() && file.file) {
-					photo->uploadingData->size = file.file->partssize;
-					photo->uploadingData->offset = file.fileSentSize;
-				}
-				_photoProgress.fire_copy(fullId);
-			} else if (file.type() == SendMediaType::File
-				|| file.type() == SendMediaType::WallPaper
-				|| file.type() == SendMediaType::Audio) {
-				const auto document = Auth().data().document(file.id());
-				if (document->uploading()) {
-					const auto doneParts = file.docSentParts
-						- int(docRequestsSent.size());
-					document->uploadingData->offset = std::min(
-						document->uploadingData->size,
-						doneParts * file.docPartSize);
-				}
-				_documentProgress.fire_copy(fullId);
-			} else if (file.type() == SendMediaType::Secure) {
-				file.fileSentSize += sentPartSize;
-				_secureProgress.fire_copy({
-					fullId,
-					file.fileSentSize,
-					file.file->partssize });
-			}
+	const auto i = requestsSent.find(requestId);
+	if (i == requestsSent.end()) {
+		sendNext();
+		return;
+	}
+	const auto request = i->second;
+	requestsSent.erase(i);
+	sentSize -= request.size;
+	sentSizes[request.dc] -= request.size;
+
+	if (request.streamedId) {
+		const auto j = _streamed.find(request.streamedId);
+		if (j != end(_streamed) && mtpIsFalse(result)) {
+			j->second.failed = true;
 		}
+		sendNext();
+		return;
+	}
+
+	const auto k = queue.find(request.fullId);
+	Assert(k != queue.cend());
+	auto &[fullId, file] = *k;
+	if (request.document) {
+		--file.docRequestsCount;
+	} else {
+		--file.requestsCount;
+	}
+	if (mtpIsFalse(result)) { // failed to upload current file
+		failed(request.fullId);
+		sendNext();
+		return;
+	}
+	if (file.type() == SendMediaType::Photo) {
+		file.fileSentSize += request.size;
+		const auto photo = Auth().data().photo(file.id());
+		if (photo->uploading() && file.file) {
+			photo->uploadingData->size = file.file->partssize;
+			photo->uploadingData->offset = file.fileSentSize;
+		}
+		_photoProgress.fire_copy(fullId);
+	} else if (file.type() == SendMediaType::File
+		|| file.type() == SendMediaType::WallPaper
+		|| file.type() == SendMediaType::Audio) {
+		const auto document = Auth().data().document(file.id());
+		if (document->uploading()) {
+			const auto doneParts = file.docSentParts
+				- file.docRequestsCount;
+			document->uploadingData->offset = std::min(
+				document->uploadingData->size,
+				doneParts * file.docPartSize);
+		}
+		_documentProgress.fire_copy(fullId);
+	} else if (file.type() == SendMediaType::Secure) {
+		file.fileSentSize += request.size;
+		_secureProgress.fire_copy({
+			fullId,
+			file.fileSentSize,
+			file.file->partssize });
 	}
 
 	sendNext();
@@ -581,9 +794,19 @@ bool Uploader::partFailed(const RPCError &error, mtpRequestId requestId) {
 	if (MTP::isDefaultHandledError(error)) return false;
 
 	// failed to upload current file
-	if ((requestsSent.find(requestId) != requestsSent.cend())
-		|| (docRequestsSent.find(requestId) != docRequestsSent.cend())) {
-		currentFailed();
+	const auto i = requestsSent.find(requestId);
+	if (i != requestsSent.end()) {
+		if (const auto id = i->second.streamedId) {
+			const auto j = _streamed.find(id);
+			if (j != end(_streamed)) {
+				j->second.failed = true;
+			}
+			sentSize -= i->second.size;
+			sentSizes[i->second.dc] -= i->second.size;
+			requestsSent.erase(i);
+		} else {
+			failed(i->second.fullId);
+		}
 	}
 	sendNext();
 	return true;
@@ -7,6 +7,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
+#include "base/weak_ptr.h"
+
 struct FileLoadResult;
 struct SendMediaReady;
 class ApiWrap;
@@ -50,7 +52,10 @@ struct UploadSecureDone {
 	int partsCount = 0;
 };
 
-class Uploader : public QObject, public RPCSender {
+class Uploader
+	: public QObject
+	, public RPCSender
+	, public base::has_weak_ptr {
 	Q_OBJECT
 
 public:
@@ -62,6 +67,12 @@ public:
 		const FullMsgId &msgId,
 		const std::shared_ptr<FileLoadResult> &file);
 
+	// Voice messages are sent by parts while they are being recorded.
+	// The id is passed as the file id to the later upload() call.
+	[[nodiscard]] uint64 startStreamed();
+	void feedStreamed(uint64 id, const QByteArray &bytes);
+	void cancelStreamed(uint64 id);
+
 	void cancel(const FullMsgId &msgId);
 	void pause(const FullMsgId &msgId);
 	void confirm(const FullMsgId &msgId);
@@ -106,24 +117,44 @@ public slots:
 
 private:
 	struct File;
+	struct DocumentReader;
+	struct StreamedDocument;
+	struct Request {
+		FullMsgId fullId;
+		int dc = 0;
+		int size = 0;
+		bool document = false;
+		uint64 streamedId = 0;
+	};
+
+	int chooseDc() const;
+	bool sendStreamedPart();
+	bool sendPart();
+	bool sendPart(const FullMsgId &uploadingId, File &uploadingData);
+	void readAhead(const FullMsgId &msgId, File &file);
+	void partRead(
+		const FullMsgId &msgId,
+		not_null<DocumentReader*> reader,
+		QByteArray &&part);
 
 	void partLoaded(const MTPBool &result, mtpRequestId requestId);
 	bool partFailed(const RPCError &err, mtpRequestId requestId);
 
-	void currentFailed();
+	void adoptStreamed(const FullMsgId &msgId, File &file);
+	void failed(FullMsgId fullId);
 
 	not_null<ApiWrap*> _api;
-	base::flat_map<mtpRequestId, QByteArray> requestsSent;
-	base::flat_map<mtpRequestId, int32> docRequestsSent;
-	base::flat_map<mtpRequestId, int32> dcMap;
+	base::flat_map<mtpRequestId, Request> requestsSent;
 	uint32 sentSize = 0;
 	uint32 sentSizes[MTP::kUploadSessionsCount] = { 0 };
 
-	FullMsgId uploadingId;
+	std::vector<FullMsgId> uploading;
+	int nextUploading = 0;
 	FullMsgId _pausedId;
 	std::map<FullMsgId, File> queue;
 	std::map<FullMsgId, File> uploaded;
-	QTimer nextTimer, stopSessionsTimer;
+	std::map<uint64, StreamedDocument> _streamed;
+	QTimer stopSessionsTimer;
 
 	rpl::event_stream<UploadedPhoto> _photoReady;
 	rpl::event_stream<UploadedDocument> _documentReady;
@@ -305,7 +305,8 @@ SendMediaReady PrepareWallPaper(const QImage &image) {
 		0);
 }
 
-TaskQueue::TaskQueue(crl::time stopTimeoutMs) {
+TaskQueue::TaskQueue(crl::time stopTimeoutMs, int threads)
+: _threadsCount(std::max(threads, 1)) {
 	if (stopTimeoutMs > 0) {
 		_stopTimer = new QTimer(this);
 		connect(_stopTimer, SIGNAL(timeout()), this, SLOT(stop()));
@@ -321,7 +322,7 @@ TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
 		_tasksToProcess.push_back(std::move(task));
 	}
 
-	wakeThread();
+	wakeThreads();
 
 	return result;
 }
@@ -334,44 +335,55 @@ void TaskQueue::addTasks(std::vector<std::unique_ptr<Task>> &&tasks) {
 		}
 	}
 
-	wakeThread();
+	wakeThreads();
 }
 
-void TaskQueue::wakeThread() {
-	if (!_thread) {
-		_thread = new QThread();
+void TaskQueue::wakeThreads() {
+	if (_threads.empty()) {
+		for (auto i = 0; i != _threadsCount; ++i) {
+			const auto thread = new QThread();
+			const auto worker = new TaskQueueWorker(this);
+			worker->moveToThread(thread);
 
-		_worker = new TaskQueueWorker(this);
-		_worker->moveToThread(_thread);
+			connect(this, SIGNAL(taskAdded()), worker, SLOT(onTaskAdded()));
+			connect(worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
 
-		connect(this, SIGNAL(taskAdded()), _worker, SLOT(onTaskAdded()));
-		connect(_worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
-
-		_thread->start();
+			thread->start();
+			_threads.push_back(thread);
+			_workers.push_back(worker);
+		}
 	}
 	if (_stopTimer) _stopTimer->stop();
 	emit taskAdded();
 }
 
 void TaskQueue::cancelTask(TaskId id) {
-	const auto removeFrom = [&](std::deque<std::unique_ptr<Task>> &queue) {
+	{
+		QMutexLocker lock(&_tasksToProcessMutex);
 		const auto proj = [](const std::unique_ptr<Task> &task) {
 			return task->id();
 		};
-		auto i = ranges::find(queue, id, proj);
-		if (i != queue.end()) {
-			queue.erase(i);
-		}
-	};
-	{
-		QMutexLocker lock(&_tasksToProcessMutex);
-		removeFrom(_tasksToProcess);
-		if (_taskInProcessId == id) {
-			_taskInProcessId = TaskId();
+		const auto i = ranges::find(_tasksToProcess, id, proj);
+		if (i != _tasksToProcess.end()) {
+			_tasksToProcess.erase(i);
 		}
+		_tasksInProcess.erase(
+			ranges::remove(_tasksInProcess, id),
+			_tasksInProcess.end());
 	}
 	QMutexLocker lock(&_tasksToFinishMutex);
-	removeFrom(_tasksToFinish);
+	const auto i = ranges::find(_tasksToFinish, id, &TaskToFinish::id);
+	if (i != _tasksToFinish.end()) {
+		const auto wasFirst = (i == _tasksToFinish.begin());
+		_tasksToFinish.erase(i);
+
+		// The tasks after the first one may be waiting for it.
+		if (wasFirst
+			&& !_tasksToFinish.empty()
+			&& _tasksToFinish.front().task) {
+			crl::on_main(this, [=] { onTaskProcessed(); });
+		}
+	}
 }
 
 void TaskQueue::onTaskProcessed() {
@@ -379,8 +391,10 @@ void TaskQueue::onTaskProcessed() {
 		auto task = std::unique_ptr<Task>();
 		{
 			QMutexLocker lock(&_tasksToFinishMutex);
-			if (_tasksToFinish.empty()) break;
-			task = std::move(_tasksToFinish.front());
+			if (_tasksToFinish.empty() || !_tasksToFinish.front().task) {
+				break;
+			}
+			task = std::move(_tasksToFinish.front().task);
 			_tasksToFinish.pop_front();
 		}
 		task->finish();
@@ -388,24 +402,32 @@ void TaskQueue::onTaskProcessed() {
 
 	if (_stopTimer) {
 		QMutexLocker lock(&_tasksToProcessMutex);
-		if (_tasksToProcess.empty() && !_taskInProcessId) {
+		if (_tasksToProcess.empty() && _tasksInProcess.empty()) {
 			_stopTimer->start();
 		}
 	}
 }
 
 void TaskQueue::stop() {
-	if (_thread) {
-		_thread->requestInterruption();
-		_thread->quit();
+	for (const auto thread : _threads) {
+		thread->requestInterruption();
+		thread->quit();
+	}
+	if (!_threads.empty()) {
 		DEBUG_LOG(("Waiting for taskThread to finish"));
-		_thread->wait();
-		delete base::take(_worker);
-		delete base::take(_thread);
+	}
+	for (const auto thread : _threads) {
+		thread->wait();
+	}
+	for (const auto worker : base::take(_workers)) {
+		delete worker;
+	}
+	for (const auto thread : base::take(_threads)) {
+		delete thread;
 	}
 	_tasksToProcess.clear();
 	_tasksToFinish.clear();
-	_taskInProcessId = TaskId();
+	_tasksInProcess.clear();
 }
 
 TaskQueue::~TaskQueue() {
@@ -425,22 +447,36 @@ void TaskQueueWorker::onTaskAdded() {
 			if (!_queue->_tasksToProcess.empty()) {
 				task = std::move(_queue->_tasksToProcess.front());
 				_queue->_tasksToProcess.pop_front();
-				_queue->_taskInProcessId = task->id();
+				_queue->_tasksInProcess.push_back(task->id());
+
+				// Reserve the place of the task in the finish order.
+				QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
+				_queue->_tasksToFinish.push_back({ task->id() });
 			}
 		}
 
 		if (task) {
+			const auto id = task->id();
 			task->process();
 			bool emitTaskProcessed = false;
 			{
 				QMutexLocker lockToProcess(&_queue->_tasksToProcessMutex);
-				if (_queue->_taskInProcessId == task->id()) {
-					_queue->_taskInProcessId = TaskId();
-					someTasksLeft = !_queue->_tasksToProcess.empty();
+				someTasksLeft = !_queue->_tasksToProcess.empty();
+
+				auto &inProcess = _queue->_tasksInProcess;
+				const auto i = ranges::find(inProcess, id);
+				if (i != inProcess.end()) {
+					inProcess.erase(i);
 
 					QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
-					emitTaskProcessed = _queue->_tasksToFinish.empty();
-					_queue->_tasksToFinish.push_back(std::move(task));
+					auto &toFinish = _queue->_tasksToFinish;
+					const auto j = ranges::find(
+						toFinish,
+						id,
+						&TaskQueue::TaskToFinish::id);
+					Assert(j != toFinish.end());
+					j->task = std::move(task);
+					emitTaskProcessed = (j == toFinish.begin());
 				}
 			}
 			if (emitTaskProcessed) {
@@ -561,8 +597,9 @@ FileLoadTask::FileLoadTask(
 	int32 duration,
 	const VoiceWaveform &waveform,
 	const FileLoadTo &to,
-	const TextWithTags &caption)
-: _id(rand_value<uint64>())
+	const TextWithTags &caption,
+	uint64 streamedId)
+: _id(streamedId ? streamedId : rand_value<uint64>())
 , _to(to)
 , _content(voice)
 , _duration(duration)
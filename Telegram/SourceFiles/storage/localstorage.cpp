@@ -21,6 +21,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/export_settings.h"
 #include "core/crash_reports.h"
 #include "core/update_checker.h"
+#include "core/startup_timeline.h"
 #include "observer_peer.h"
 #include "mainwidget.h"
 #include "mainwindow.h"
@@ -34,6 +35,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session.h"
 #include "window/window_session_controller.h"
 #include "base/flags.h"
+#include "base/flat_map.h"
 #include "data/data_session.h"
 #include "history/history.h"
 
@@ -49,6 +51,7 @@ constexpr auto kFileLoaderQueueStopTimeout = crl::time(5000);
 constexpr auto kDefaultStickerInstallDate = TimeId(1);
 constexpr auto kProxyTypeShift = 1024;
 constexpr auto kWriteMapTimeout = crl::time(1000);
+constexpr auto kCacheShardsCount = 4;
 constexpr auto kSavedBackgroundFormat = QImage::Format_ARGB32_Premultiplied;
 
 constexpr auto kWallPaperLegacySerializeTagId = int32(-111);
@@ -615,6 +618,8 @@ enum {
 	dbiCallSettings = 0x5b,
 	dbiCacheSettings = 0x5c,
 	dbiTxtDomainString = 0x5d,
+	dbiSimpleConfigCache = 0x5e,
+	dbiProxyResolvedIPs = 0x5f,
 
 	dbiEncryptedWithSalt = 333,
 	dbiEncrypted = 444,
@@ -647,7 +652,9 @@ typedef QMap<QString, FileLocationPair> FileLocationPairs;
 FileLocationPairs _fileLocationPairs;
 typedef QMap<MediaKey, MediaKey> FileLocationAliases;
 FileLocationAliases _fileLocationAliases;
+base::flat_map<MediaKey, PartialDownload> _partialDownloads;
 FileKey _locationsKey = 0, _trustedBotsKey = 0;
+bool _locationsRead = false;
 
 using TrustedBots = OrderedSet<uint64>;
 TrustedBots _trustedBots;
@@ -720,7 +727,11 @@ void _writeLocations(WriteMapWhen when = WriteMapWhen::Soon) {
 	if (!_working()) return;
 
 	_manager->writingLocations();
-	if (_fileLocations.isEmpty()) {
+	if (!_locationsRead) {
+		// Nothing could have changed, don't overwrite the unread file.
+		return;
+	}
+	if (_fileLocations.isEmpty() && _partialDownloads.empty()) {
 		if (_locationsKey) {
 			clearKey(_locationsKey);
 			_locationsKey = 0;
@@ -758,6 +769,17 @@ void _writeLocations(WriteMapWhen when = WriteMapWhen::Soon) {
 			size += sizeof(quint64) * 2 + sizeof(quint64) * 2;
 		}
 
+		size += sizeof(quint32); // legacy web locations count
+		size += sizeof(quint32); // partial downloads count
+		for (const auto &[key, download] : _partialDownloads) {
+			// key + location + origin + path + size + loaded + type
+			size += sizeof(quint64) * 2
+				+ Serialize::bytearraySize(download.location)
+				+ sizeof(quint32) + sizeof(qint32)
+				+ Serialize::stringSize(download.path)
+				+ sizeof(qint32) * 3;
+		}
+
 		EncryptedDescriptor data(size);
 		auto legacyTypeField = 0;
 		for (FileLocations::const_iterator i = _fileLocations.cbegin(); i != _fileLocations.cend(); ++i) {
@@ -779,6 +801,21 @@ void _writeLocations(WriteMapWhen when = WriteMapWhen::Soon) {
 			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
 		}
 
+		data.stream << quint32(0);
+		data.stream << quint32(_partialDownloads.size());
+		for (const auto &[key, download] : _partialDownloads) {
+			data.stream
+				<< quint64(key.first)
+				<< quint64(key.second)
+				<< download.location
+				<< quint32(download.origin.channel)
+				<< qint32(download.origin.msg)
+				<< download.path
+				<< qint32(download.size)
+				<< qint32(download.loaded)
+				<< qint32(download.type);
+		}
+
 		FileWriteDescriptor file(_locationsKey);
 		file.writeEncrypted(data);
 	}
@@ -839,6 +876,50 @@ void _readLocations() {
 				clearKey(key, FileOption::User);
 			}
 		}
+		if (!locations.stream.atEnd()) {
+			auto partialDownloadsCount = quint32();
+			locations.stream >> partialDownloadsCount;
+			for (quint32 i = 0; i < partialDownloadsCount; ++i) {
+				quint64 first, second;
+				quint32 channel;
+				qint32 msg, size, loaded, type;
+				auto download = PartialDownload();
+				locations.stream
+					>> first
+					>> second
+					>> download.location
+					>> channel
+					>> msg
+					>> download.path
+					>> size
+					>> loaded
+					>> type;
+				if (locations.stream.status() != QDataStream::Ok) {
+					break;
+				}
+				download.origin = FullMsgId(channel, msg);
+				download.size = size;
+				download.loaded = loaded;
+				download.type = LocationType(type);
+				_partialDownloads.emplace(
+					MediaKey(first, second),
+					std::move(download));
+			}
+		}
+	}
+}
+
+// The locations file is large in accounts with a lot of downloaded media,
+// so it is read on the first access instead of in readMap.
+void _ensureLocationsRead() {
+	if (_locationsRead) {
+		return;
+	}
+	_locationsRead = true;
+	if (_locationsKey) {
+		const auto ms = crl::now();
+		_readLocations();
+		LOG(("Locations read time: %1").arg(crl::now() - ms));
 	}
 }
 
@@ -852,7 +933,7 @@ void applyReadContext(ReadSettingsContext &&context) {
 
 QByteArray serializeCallSettings(){
 	QByteArray result=QByteArray();
-	uint32 size = 3*sizeof(qint32) + Serialize::stringSize(Global::CallOutputDeviceID()) + Serialize::stringSize(Global::CallInputDeviceID());
+	uint32 size = 4*sizeof(qint32) + Serialize::stringSize(Global::CallOutputDeviceID()) + Serialize::stringSize(Global::CallInputDeviceID());
 	result.reserve(size);
 	QDataStream stream(&result, QIODevice::WriteOnly);
 	stream.setVersion(QDataStream::Qt_5_1);
@@ -861,6 +942,7 @@ QByteArray serializeCallSettings(){
 	stream << Global::CallInputDeviceID();
 	stream << qint32(Global::CallInputVolume());
 	stream << qint32(Global::CallAudioDuckingEnabled() ? 1 : 0);
+	stream << qint32(Global::CallJitterPreset());
 	return result;
 }
 
@@ -872,18 +954,29 @@ void deserializeCallSettings(QByteArray& settings){
 	qint32 outputVolume;
 	qint32 inputVolume;
 	qint32 duckingEnabled;
+	qint32 jitterPreset = dbicjDefault;
 
 	stream >> outputDeviceID;
 	stream >> outputVolume;
 	stream >> inputDeviceID;
 	stream >> inputVolume;
 	stream >> duckingEnabled;
+	if (!stream.atEnd()) {
+		stream >> jitterPreset;
+	}
 	if(_checkStreamStatus(stream)){
 		Global::SetCallOutputDeviceID(outputDeviceID);
 		Global::SetCallOutputVolume(outputVolume);
 		Global::SetCallInputDeviceID(inputDeviceID);
 		Global::SetCallInputVolume(inputVolume);
 		Global::SetCallAudioDuckingEnabled(duckingEnabled);
+		switch (jitterPreset) {
+		case dbicjDefault:
+		case dbicjLowLatency:
+		case dbicjStable:
+			Global::SetCallJitterPreset(DBICallJitterPreset(jitterPreset));
+			break;
+		}
 	}
 }
 
@@ -1242,6 +1335,45 @@ bool _readSetting(quint32 blockId, QDataStream &stream, int version, ReadSetting
 		Global::SetTxtDomainString(v);
 	} break;
 
+	case dbiSimpleConfigCache: {
+		QByteArray v;
+		stream >> v;
+		if (!_checkStreamStatus(stream)) return false;
+
+		Global::SetSimpleConfigCache(v);
+	} break;
+
+	case dbiProxyResolvedIPs: {
+		qint32 count = 0;
+		stream >> count;
+		if (!_checkStreamStatus(stream)) return false;
+
+		for (auto i = 0; i != count; ++i) {
+			QString host;
+			qint32 ipsCount = 0;
+			stream >> host >> ipsCount;
+			auto ips = std::vector<QString>();
+			for (auto j = 0; j < ipsCount; ++j) {
+				QString ip;
+				stream >> ip;
+				ips.push_back(ip);
+			}
+			if (!_checkStreamStatus(stream)) return false;
+
+			// Expired resolved IPs are tried while being resolved again.
+			const auto apply = [&](ProxyData &proxy) {
+				if (proxy.tryCustomResolve() && proxy.host == host) {
+					proxy.resolvedIPs = ips;
+					proxy.resolvedExpireAt = 0;
+				}
+			};
+			for (auto &proxy : Global::RefProxiesList()) {
+				apply(proxy);
+			}
+			apply(Global::RefSelectedProxy());
+		}
+	} break;
+
 	case dbiConnectionTypeOld: {
 		qint32 v;
 		stream >> v;
@@ -2377,9 +2509,7 @@ ReadMapState _readMap(const QByteArray &pass) {
 		_mapChanged = false;
 	}
 
-	if (_locationsKey) {
-		_readLocations();
-	}
+	_locationsRead = false;
 
 	_readUserSettings();
 	_readMtpData();
@@ -2623,6 +2753,7 @@ void writeSettings() {
 	size += sizeof(quint32) + Serialize::bytearraySize(dcOptionsSerialized);
 	size += sizeof(quint32) + Serialize::stringSize(cLoggedPhoneNumber());
 	size += sizeof(quint32) + Serialize::stringSize(Global::TxtDomainString());
+	size += sizeof(quint32) + Serialize::bytearraySize(Global::SimpleConfigCache());
 
 	auto &proxies = Global::RefProxiesList();
 	const auto &proxy = Global::SelectedProxy();
@@ -2636,6 +2767,19 @@ void writeSettings() {
 	for (const auto &proxy : proxies) {
 		size += sizeof(qint32) + Serialize::stringSize(proxy.host) + sizeof(qint32) + Serialize::stringSize(proxy.user) + Serialize::stringSize(proxy.password);
 	}
+	auto resolved = base::flat_map<QString, std::vector<QString>>();
+	for (const auto &proxy : proxies) {
+		if (proxy.tryCustomResolve() && !proxy.resolvedIPs.empty()) {
+			resolved.emplace(proxy.host, proxy.resolvedIPs);
+		}
+	}
+	size += sizeof(quint32) + sizeof(qint32);
+	for (const auto &[host, ips] : resolved) {
+		size += Serialize::stringSize(host) + sizeof(qint32);
+		for (const auto &ip : ips) {
+			size += Serialize::stringSize(ip);
+		}
+	}
 
 	// Theme keys and night mode.
 	size += sizeof(quint32) + sizeof(quint64) * 2 + sizeof(quint32);
@@ -2661,6 +2805,7 @@ void writeSettings() {
 	data.stream << quint32(dbiDcOptions) << dcOptionsSerialized;
 	data.stream << quint32(dbiLoggedPhoneNumber) << cLoggedPhoneNumber();
 	data.stream << quint32(dbiTxtDomainString) << Global::TxtDomainString();
+	data.stream << quint32(dbiSimpleConfigCache) << Global::SimpleConfigCache();
 	data.stream << quint32(dbiAnimationsDisabled) << qint32(anim::Disabled() ? 1 : 0);
 
 	data.stream << quint32(dbiConnectionType) << qint32(dbictProxiesList);
@@ -2672,6 +2817,13 @@ void writeSettings() {
 		data.stream << qint32(kProxyTypeShift + int(proxy.type));
 		data.stream << proxy.host << qint32(proxy.port) << proxy.user << proxy.password;
 	}
+	data.stream << quint32(dbiProxyResolvedIPs) << qint32(resolved.size());
+	for (const auto &[host, ips] : resolved) {
+		data.stream << host << qint32(ips.size());
+		for (const auto &ip : ips) {
+			data.stream << ip;
+		}
+	}
 
 	data.stream << quint32(dbiTryIPv6) << qint32(Global::TryIPv6());
 	data.stream
@@ -2759,7 +2911,10 @@ void writeAutoupdatePrefix(const QString &prefix) {
 QString readAutoupdatePrefix() {
 	Expects(!Core::UpdaterDisabled());
 
-	auto result = readAutoupdatePrefixRaw();
+	// A mirror given in the command line overrides the server prefix.
+	auto result = cUpdatesMirror().isEmpty()
+		? readAutoupdatePrefixRaw()
+		: cUpdatesMirror();
 	return result.replace(QRegularExpression("/+$"), QString());
 }
 
@@ -2774,6 +2929,7 @@ void reset() {
 	_fileLocations.clear();
 	_fileLocationPairs.clear();
 	_fileLocationAliases.clear();
+	_partialDownloads.clear();
 	_draftsNotReadMap.clear();
 	_locationsKey = _trustedBotsKey = 0;
 	_recentStickersKeyOld = 0;
@@ -3075,6 +3231,7 @@ void writeFileLocation(MediaKey location, const FileLocation &local) {
 	if (local.fname.isEmpty()) {
 		return;
 	}
+	_ensureLocationsRead();
 	if (!local.inMediaCache()) {
 		FileLocationAliases::const_iterator aliasIt = _fileLocationAliases.constFind(location);
 		if (aliasIt != _fileLocationAliases.cend()) {
@@ -3114,6 +3271,7 @@ void writeFileLocation(MediaKey location, const FileLocation &local) {
 }
 
 void removeFileLocation(MediaKey location) {
+	_ensureLocationsRead();
 	FileLocations::iterator i = _fileLocations.find(location);
 	if (i == _fileLocations.end()) {
 		return;
@@ -3124,7 +3282,41 @@ void removeFileLocation(MediaKey location) {
 	_writeLocations(WriteMapWhen::Fast);
 }
 
+void writePartialDownload(
+		MediaKey location,
+		const PartialDownload &download) {
+	_ensureLocationsRead();
+	_partialDownloads[location] = download;
+	_writeLocations();
+}
+
+std::optional<PartialDownload> readPartialDownload(MediaKey location) {
+	_ensureLocationsRead();
+	const auto i = _partialDownloads.find(location);
+	return (i != end(_partialDownloads))
+		? std::make_optional(i->second)
+		: std::nullopt;
+}
+
+void removePartialDownload(MediaKey location) {
+	_ensureLocationsRead();
+	if (_partialDownloads.remove(location)) {
+		_writeLocations(WriteMapWhen::Fast);
+	}
+}
+
+std::vector<MediaKey> partialDownloads() {
+	_ensureLocationsRead();
+	auto result = std::vector<MediaKey>();
+	result.reserve(_partialDownloads.size());
+	for (const auto &[key, download] : _partialDownloads) {
+		result.push_back(key);
+	}
+	return result;
+}
+
 FileLocation readFileLocation(MediaKey location) {
+	_ensureLocationsRead();
 	FileLocationAliases::const_iterator aliasIt = _fileLocationAliases.constFind(location);
 	if (aliasIt != _fileLocationAliases.cend()) {
 		location = aliasIt.value();
@@ -3164,6 +3356,16 @@ Storage::Cache::Database::Settings cacheSettings() {
 	result.totalSizeLimit = _cacheTotalSizeLimit;
 	result.totalTimeLimit = _cacheTotalTimeLimit;
 	result.maxDataSize = Storage::kMaxFileInMemory;
+	result.mapPlaceFiles = true;
+	result.shardsCount = kCacheShardsCount;
+	result.tagPlaceDirectories = true;
+
+	using Policy = Storage::Cache::Database::EvictionPolicy;
+	result.evictionPolicies.emplace(Data::kImageCacheTag, Policy::SizeAware);
+	result.evictionPolicies.emplace(
+		Data::kStickerCacheTag,
+		Policy::LeastFrequentlyUsed);
+	result.compressTags.emplace(uint8(0));
 	return result;
 }
 
@@ -4295,6 +4497,7 @@ Window::Theme::Saved readThemeAfterSwitch() {
 }
 
 void readLangPack() {
+	const auto phase = Core::Startup::Phase("Language pack");
 	FileReadDescriptor langpack;
 	if (!_langPackKey || !readEncryptedFile(langpack, _langPackKey, FileOption::Safe, SettingsKey)) {
 		return;
@@ -113,6 +113,20 @@ void writeFileLocation(MediaKey location, const FileLocation &local);
 FileLocation readFileLocation(MediaKey location);
 void removeFileLocation(MediaKey location);
 
+// A download to a file that was interrupted and can be resumed.
+struct PartialDownload {
+	QByteArray location; // Serialized StorageFileLocation.
+	FullMsgId origin;
+	QString path;
+	int32 size = 0;
+	int32 loaded = 0; // Every byte before this offset is already written.
+	LocationType type = LocationType();
+};
+void writePartialDownload(MediaKey location, const PartialDownload &download);
+std::optional<PartialDownload> readPartialDownload(MediaKey location);
+void removePartialDownload(MediaKey location);
+[[nodiscard]] std::vector<MediaKey> partialDownloads();
+
 Storage::EncryptionKey cacheKey();
 QString cachePath();
 Storage::Cache::Database::Settings cacheSettings();
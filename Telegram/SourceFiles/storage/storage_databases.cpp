@@ -71,14 +71,17 @@ DatabasePointer Databases::get(
 		const Cache::details::Settings &settings) {
 	if (const auto i = _map.find(path); i != end(_map)) {
 		auto &kept = i->second;
-		Assert(kept.destroying.alive());
-		kept.destroying = nullptr;
+		if (!kept.users++) {
+			Assert(kept.destroying.alive());
+			kept.destroying = nullptr;
+		}
 		kept.database->reconfigure(settings);
 		return DatabasePointer(this, kept.database);
 	}
 	const auto [i, ok] = _map.emplace(
 		path,
 		std::make_unique<Cache::Database>(path, settings));
+	++i->second.users;
 	return DatabasePointer(this, i->second.database);
 }
 
@@ -87,6 +90,10 @@ void Databases::destroy(Cache::Database *database) {
 		const auto &path = entry.first; // Need to capture it in lambda.
 		auto &kept = entry.second;
 		if (kept.database.get() == database) {
+			Assert(kept.users > 0);
+			if (--kept.users > 0) {
+				return;
+			}
 			Assert(!kept.destroying.alive());
 			database->close();
 			database->waitForCleaner([
@@ -46,6 +46,8 @@ private:
 
 };
 
+// Databases with the same path are shared between all their users.
+// A database is closed when the last DatabasePointer to it is destroyed.
 class Databases {
 public:
 	DatabasePointer get(
@@ -60,6 +62,7 @@ private:
 
 		std::unique_ptr<Cache::Database> database;
 		base::binary_guard destroying;
+		int users = 0;
 	};
 
 	void destroy(Cache::Database *database);
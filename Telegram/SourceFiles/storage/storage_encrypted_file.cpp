@@ -8,11 +8,17 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_encrypted_file.h"
 
 #include "base/openssl_help.h"
+#include "base/algorithm.h"
+#include <crl/crl.h>
+#include <QtCore/QThread>
+#include <atomic>
 
 namespace Storage {
 namespace {
 
 constexpr auto kBlockSize = CtrState::kBlockSize;
+constexpr auto kParallelDecryptPart = size_type(512 * 1024);
+constexpr auto kKeepBufferSize = size_type(1024 * 1024);
 
 enum class Format : uint32 {
 	Format_0,
@@ -210,6 +216,70 @@ size_type File::read(bytes::span bytes) {
 	return count;
 }
 
+size_type File::readParallel(bytes::span bytes) {
+	Expects(bytes.size() % kBlockSize == 0);
+
+	auto count = readPlain(bytes);
+	if (const auto back = -(count % kBlockSize)) {
+		if (!_data.seek(_data.pos() + back)) {
+			return 0;
+		}
+		count += back;
+	}
+	if (count) {
+		decryptParallel(bytes.subspan(0, count));
+	}
+	return count;
+}
+
+void File::decryptParallel(bytes::span bytes) {
+	Expects(_state.has_value());
+
+	const auto size = size_type(bytes.size());
+	const auto parts = std::min(
+		size_type(QThread::idealThreadCount()),
+		size / kParallelDecryptPart);
+	if (parts < 2) {
+		decrypt(bytes);
+		return;
+	}
+
+	// The calling thread takes parts as well, so if the thread pool is
+	// busy the helpers find nothing left to do and nobody waits forever.
+	struct Shared {
+		std::atomic<size_type> next{ 0 };
+		crl::semaphore finished;
+	};
+	const auto shared = std::make_shared<Shared>();
+	const auto partSize = ((size / parts) / kBlockSize) * kBlockSize;
+	const auto offset = _encryptionOffset;
+	auto process = [=, state = *_state]() mutable {
+		auto result = size_type(0);
+		while (true) {
+			const auto index = shared->next++;
+			if (index >= parts) {
+				return result;
+			}
+			const auto from = index * partSize;
+			const auto till = (index + 1 == parts) ? size : (from + partSize);
+			state.decrypt(bytes.subspan(from, till - from), offset + from);
+			++result;
+		}
+	};
+	for (auto i = size_type(1); i != parts; ++i) {
+		crl::async([=]() mutable {
+			for (auto j = process(); j != 0; --j) {
+				shared->finished.release();
+			}
+		});
+	}
+	auto left = parts - process();
+	while (left--) {
+		shared->finished.acquire();
+	}
+	_encryptionOffset += size;
+}
+
 bool File::write(bytes::span bytes) {
 	Expects(bytes.size() % kBlockSize == 0);
 
@@ -230,6 +300,41 @@ bool File::write(bytes::span bytes) {
 	return true;
 }
 
+bool File::writeVectored(std::initializer_list<bytes::const_span> parts) {
+	if (!isOpen()) {
+		return false;
+	}
+	auto size = size_type(0);
+	for (const auto &part : parts) {
+		size += part.size();
+	}
+	Expects(size % kBlockSize == 0);
+
+	const auto guard = gsl::finally([&] {
+		if (_buffer.capacity() > kKeepBufferSize) {
+			base::take(_buffer);
+		}
+	});
+	_buffer.resize(size);
+	const auto buffer = bytes::make_span(_buffer);
+	auto to = buffer;
+	for (const auto &part : parts) {
+		bytes::copy(to, part);
+		to = to.subspan(part.size());
+	}
+	encrypt(buffer);
+	const auto count = writePlain(buffer);
+	if (count != size) {
+		_encryptionOffset -= size;
+		if (count > 0) {
+			_data.seek(_data.pos() - count);
+		}
+		return false;
+	}
+	_dataSize = std::max(_dataSize, offset());
+	return true;
+}
+
 void File::decryptBack(bytes::span bytes) {
 	Expects(_encryptionOffset >= bytes.size());
 
@@ -262,6 +367,44 @@ size_type File::readWithPadding(bytes::span bytes) {
 	return size;
 }
 
+size_type File::readWithPaddingMapped(bytes::span bytes) {
+	Expects(isOpen());
+
+	const auto size = bytes.size();
+	const auto part = size % kBlockSize;
+	const auto good = size - part;
+	const auto padded = good + (part ? kBlockSize : 0);
+	if (!padded) {
+		return 0;
+	} else if (_dataSize - offset() < padded) {
+		return readWithPadding(bytes);
+	}
+	const auto position = _data.pos();
+	const auto mapped = _data.map(position, padded);
+	if (!mapped) {
+		return readWithPadding(bytes);
+	}
+	const auto guard = gsl::finally([&] { _data.unmap(mapped); });
+	const auto source = bytes::make_span(
+		reinterpret_cast<const bytes::type*>(mapped),
+		padded);
+	if (good) {
+		bytes::copy(bytes, source.subspan(0, good));
+		decrypt(bytes.subspan(0, good));
+	}
+	if (part) {
+		auto storage = bytes::array<kBlockSize>();
+		const auto tail = bytes::make_span(storage);
+		bytes::copy(tail, source.subspan(good));
+		decrypt(tail);
+		bytes::copy(bytes.subspan(good), tail.subspan(0, part));
+	}
+	if (!_data.seek(position + padded)) {
+		return 0;
+	}
+	return size;
+}
+
 bool File::writeWithPadding(bytes::span bytes) {
 	const auto size = bytes.size();
 	const auto part = size % kBlockSize;
@@ -296,6 +439,7 @@ void File::close() {
 	_data.setFileName(QString());
 	_dataSize = _encryptionOffset = 0;
 	_state = std::nullopt;
+	base::take(_buffer);
 }
 
 bool File::isOpen() const {
@@ -12,6 +12,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/bytes.h"
 #include "base/optional.h"
 
+#include <initializer_list>
+
 namespace Storage {
 
 class File {
@@ -32,9 +34,20 @@ public:
 	size_type read(bytes::span bytes);
 	bool write(bytes::span bytes);
 
+	// Gathers the parts to one buffer and writes it with a single call.
+	// The parts are left unencrypted, the offset is kept on failure.
+	bool writeVectored(std::initializer_list<bytes::const_span> parts);
+
+	// Same as read, but large blocks are decrypted on several threads.
+	size_type readParallel(bytes::span bytes);
+
 	size_type readWithPadding(bytes::span bytes);
 	bool writeWithPadding(bytes::span bytes);
 
+	// Same as readWithPadding, but decrypts straight from a memory mapping
+	// of the file instead of copying the data through the QFile buffer.
+	size_type readWithPaddingMapped(bytes::span bytes);
+
 	bool flush();
 
 	bool isOpen() const;
@@ -58,6 +71,7 @@ private:
 	size_type readPlain(bytes::span bytes);
 	size_type writePlain(bytes::const_span bytes);
 	void decrypt(bytes::span bytes);
+	void decryptParallel(bytes::span bytes);
 	void encrypt(bytes::span bytes);
 	void decryptBack(bytes::span bytes);
 
@@ -67,6 +81,7 @@ private:
 	int64 _dataSize = 0;
 
 	std::optional<CtrState> _state;
+	bytes::vector _buffer;
 
 };
 
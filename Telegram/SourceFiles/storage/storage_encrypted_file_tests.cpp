@@ -160,12 +160,89 @@ TEST_CASE("simple encrypted file", "[storage_encrypted_file]") {
 		REQUIRE(read == data.size());
 		REQUIRE(data == bytes::concatenate(Test1, Test1));
 	}
+	SECTION("reading file mapped") {
+		Storage::File file;
+
+		const auto result = file.open(
+			Name,
+			Storage::File::Mode::Read,
+			Key);
+		REQUIRE(result == Storage::File::Result::Success);
+
+		const auto full = bytes::concatenate(Test1, Test1);
+		auto data = bytes::vector(20);
+		const auto read = file.readWithPaddingMapped(data);
+		REQUIRE(read == data.size());
+		REQUIRE(data == bytes::make_vector(
+			bytes::make_span(full).subspan(0, data.size())));
+		REQUIRE(file.offset() == 2 * Test1.size());
+
+		auto rest = bytes::vector(Test1.size());
+		REQUIRE(file.readWithPaddingMapped(rest) == rest.size());
+		REQUIRE(rest == bytes::make_vector(Test1));
+	}
+	SECTION("vectored write and random access read") {
+		Storage::File file;
+		const auto result = file.open(
+			Name,
+			Storage::File::Mode::ReadAppend,
+			Key);
+		REQUIRE(result == Storage::File::Result::Success);
+		REQUIRE(file.seek(file.size()));
+
+		const auto first = bytes::make_vector(Test1);
+		const auto second = bytes::make_vector(Test2);
+		REQUIRE(file.writeVectored({ first, second }));
+		REQUIRE(first == bytes::make_vector(Test1));
+		REQUIRE(file.offset() == 5 * Test1.size());
+		REQUIRE(file.size() == 5 * Test1.size());
+
+		auto data = bytes::vector(Test2.size());
+		REQUIRE(file.seek(4 * Test1.size()));
+		REQUIRE(file.read(data) == data.size());
+		REQUIRE(data == second);
+		REQUIRE(file.seek(3 * Test1.size()));
+		REQUIRE(file.read(data) == data.size());
+		REQUIRE(data == first);
+	}
 	SECTION("moving file") {
 		const auto result = Storage::File::Move(Name, "other.file");
 		REQUIRE(result);
 	}
 }
 
+TEST_CASE("large encrypted file", "[storage_encrypted_file]") {
+	auto data = bytes::vector(4 * 1024 * 1024);
+	for (auto i = 0, count = int(data.size()); i != count; ++i) {
+		data[i] = bytes::type(i % 251);
+	}
+	const auto original = data;
+	SECTION("writing file") {
+		Storage::File file;
+		const auto result = file.open(
+			Name,
+			Storage::File::Mode::Write,
+			Key);
+		REQUIRE(result == Storage::File::Result::Success);
+		REQUIRE(file.write(data));
+	}
+	SECTION("reading file in parallel") {
+		Storage::File file;
+		const auto result = file.open(
+			Name,
+			Storage::File::Mode::Read,
+			Key);
+		REQUIRE(result == Storage::File::Result::Success);
+
+		auto first = bytes::vector(16);
+		REQUIRE(file.read(first) == first.size());
+		auto rest = bytes::vector(original.size() - first.size());
+		REQUIRE(file.readParallel(rest) == rest.size());
+		REQUIRE(bytes::concatenate(first, rest) == original);
+		REQUIRE(file.offset() == original.size());
+	}
+}
+
 TEST_CASE("two process encrypted file", "[storage_encrypted_file]") {
 	SECTION("writing file") {
 		Storage::File file;
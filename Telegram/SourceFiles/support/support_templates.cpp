@@ -18,6 +18,7 @@ namespace {
 
 constexpr auto kQueryLimit = 10;
 constexpr auto kWeightStep = 1000;
+constexpr auto kIndexPrefixLength = 3;
 
 struct Delta {
 	std::vector<const TemplatesQuestion*> added;
@@ -272,7 +273,7 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 	using Id = TemplatesIndex::Id;
 	using Term = TemplatesIndex::Term;
 
-	auto uniqueFirst = std::map<QChar, base::flat_set<Id>>();
+	auto uniquePrefixes = std::map<QString, base::flat_set<Id>>();
 	auto uniqueFull = std::map<Id, base::flat_set<Term>>();
 	const auto pushString = [&](
 			const Id &id,
@@ -280,7 +281,10 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 			int weight) {
 		const auto list = TextUtilities::PrepareSearchWords(string);
 		for (const auto &word : list) {
-			uniqueFirst[word[0]].emplace(id);
+			const auto length = std::min(word.size(), kIndexPrefixLength);
+			for (auto i = 1; i <= length; ++i) {
+				uniquePrefixes[word.left(i)].emplace(id);
+			}
 			uniqueFull[id].emplace(std::make_pair(word, weight));
 		}
 	};
@@ -296,8 +300,8 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 	}
 
 	auto result = TemplatesIndex();
-	for (const auto &[ch, unique] : uniqueFirst) {
-		result.first.emplace(ch, unique | ranges::to_vector);
+	for (const auto &[prefix, unique] : uniquePrefixes) {
+		result.prefixes.emplace(prefix, unique | ranges::to_vector);
 	}
 	for (const auto &[id, unique] : uniqueFull) {
 		result.full.emplace(id, unique | ranges::to_vector);
@@ -321,7 +325,7 @@ void ReplaceFileIndex(
 	}
 
 	using Id = TemplatesIndex::Id;
-	for (auto &[ch, list] : result.first) {
+	for (auto &[prefix, list] : result.prefixes) {
 		auto i = ranges::lower_bound(
 			list,
 			std::make_pair(path, QString()));
@@ -330,8 +334,8 @@ void ReplaceFileIndex(
 		});
 		list.erase(i, j);
 	}
-	for (auto &[ch, list] : source.first) {
-		auto &to = result.first[ch];
+	for (auto &[prefix, list] : source.prefixes) {
+		auto &to = result.prefixes[prefix];
 		to.insert(
 			end(to),
 			std::make_move_iterator(begin(list)),
@@ -426,6 +430,30 @@ QString UpdateFile(
 	return result;
 }
 
+std::map<QString, TemplatesKey> ComputeKeys(const TemplatesData &data) {
+	auto result = std::map<QString, TemplatesKey>();
+	for (const auto &[path, file] : data.files) {
+		for (const auto &[normalized, question] : file.questions) {
+			const auto id = std::make_pair(path, normalized);
+			for (const auto &key : question.normalizedKeys) {
+				const auto i = result.find(key);
+				if (i == end(result)) {
+					result.emplace(key, TemplatesKey{ id, id });
+				} else {
+					i->second.last = id;
+				}
+			}
+		}
+	}
+	return result;
+}
+
+const TemplatesQuestion &QuestionById(
+		const TemplatesData &data,
+		const TemplatesIndex::Id &id) {
+	return data.files.at(id.first).questions.at(id.second);
+}
+
 int CountMaxKeyLength(const TemplatesData &data) {
 	auto result = 0;
 	for (const auto &[path, file] : data.files) {
@@ -490,6 +518,7 @@ void Templates::load() {
 		]() mutable {
 			setData(std::move(result.result));
 			_index = std::move(result.index);
+			refreshCaches();
 			_errors.fire(std::move(result.errors));
 			crl::on_main(this, [=] {
 				if (base::take(_reloadAfterRead)) {
@@ -507,6 +536,11 @@ void Templates::setData(TemplatesData &&data) {
 	_maxKeyLength = CountMaxKeyLength(_data);
 }
 
+void Templates::refreshCaches() {
+	_keys = ComputeKeys(_data);
+	_lastQuery = TemplatesQuery();
+}
+
 void Templates::ensureUpdatesCreated() {
 	if (_updates) {
 		return;
@@ -595,6 +629,7 @@ void Templates::updateRequestFinished(QNetworkReply *reply) {
 				_session->data().serviceNotification({ full });
 			}
 			_data.files.at(path) = std::move(one.files.at(path));
+			refreshCaches();
 
 			_updates->requests.erase(path);
 			checkUpdateFinished();
@@ -620,16 +655,11 @@ auto Templates::matchExact(QString query) const
 
 	query = NormalizeKey(query);
 
-	for (const auto &[path, file] : _data.files) {
-		for (const auto &[normalized, question] : file.questions) {
-			for (const auto &key : question.normalizedKeys) {
-				if (key == query) {
-					return QuestionByKey{ question, key };
-				}
-			}
-		}
+	const auto i = _keys.find(query);
+	if (i == end(_keys)) {
+		return {};
 	}
-	return {};
+	return QuestionByKey{ QuestionById(_data, i->second.first), query };
 }
 
 auto Templates::matchFromEnd(QString query) const
@@ -645,42 +675,57 @@ auto Templates::matchFromEnd(QString query) const
 		queries.push_back(NormalizeKey(query.mid(size - i - 1)));
 	}
 
-	auto result = std::optional<QuestionByKey>();
-	for (const auto &[path, file] : _data.files) {
-		for (const auto &[normalized, question] : file.questions) {
-			for (const auto &key : question.normalizedKeys) {
-				if (key.size() <= queries.size()
-					&& queries[key.size() - 1] == key
-					&& (!result || result->key.size() <= key.size())) {
-					result = QuestionByKey{ question, key };
-				}
-			}
+	// The longest key wins, so check the longest suffixes first.
+	for (auto i = size; i != 0; --i) {
+		const auto &key = queries[i - 1];
+		if (key.size() != i) {
+			continue;
+		} else if (const auto j = _keys.find(key); j != end(_keys)) {
+			return QuestionByKey{ QuestionById(_data, j->second.last), key };
 		}
 	}
-	return result;
+	return {};
 }
 
 Templates::~Templates() = default;
 
 auto Templates::query(const QString &text) const -> std::vector<Question> {
+	using Id = TemplatesIndex::Id;
+	using Term = TemplatesIndex::Term;
+
 	const auto words = TextUtilities::PrepareSearchWords(text);
-	const auto questions = [&](const QString &word) {
-		const auto i = _index.first.find(word[0]);
-		return (i == end(_index.first)) ? 0 : i->second.size();
-	};
-	const auto best = ranges::min_element(words, std::less<>(), questions);
-	if (best == std::end(words)) {
+	if (words.isEmpty()) {
 		return {};
 	}
-	const auto narrowed = _index.first.find((*best)[0]);
-	if (narrowed == end(_index.first)) {
+
+	// While typing, each query only narrows down the previous one.
+	const auto narrowsLast = !_lastQuery.words.isEmpty()
+		&& ranges::all_of(_lastQuery.words, [&](const QString &word) {
+			return ranges::any_of(words, [&](const QString &other) {
+				return other.startsWith(word);
+			});
+		});
+	const auto candidates = [&]() -> const std::vector<Id>* {
+		if (narrowsLast) {
+			return &_lastQuery.matched;
+		}
+		const auto prefix = [](const QString &word) {
+			return word.left(kIndexPrefixLength);
+		};
+		const auto questions = [&](const QString &word) {
+			const auto i = _index.prefixes.find(prefix(word));
+			return (i == end(_index.prefixes)) ? 0 : i->second.size();
+		};
+		const auto best = ranges::min_element(words, std::less<>(), questions);
+		const auto narrowed = _index.prefixes.find(prefix(*best));
+		return (narrowed == end(_index.prefixes))
+			? nullptr
+			: &narrowed->second;
+	}();
+	if (!candidates) {
+		_lastQuery = TemplatesQuery{ words };
 		return {};
 	}
-	using Id = TemplatesIndex::Id;
-	using Term = TemplatesIndex::Term;
-	const auto questionById = [&](const Id &id) {
-		return _data.files.at(id.first).questions.at(id.second);
-	};
 
 	const auto computeWeight = [&](const Id &id) {
 		auto result = 0;
@@ -728,14 +773,27 @@ auto Templates::query(const QString &text) const -> std::vector<Question> {
 			return (a.first.second < b.first.second);
 		}
 	};
-	const auto good = narrowed->second | ranges::view::transform(
+	auto good = *candidates | ranges::view::transform(
 		pairById
 	) | ranges::view::filter([](const Pair &pair) {
 		return pair.second > 0;
-	}) | ranges::to_vector | ranges::action::stable_sort(sorter);
-	return good | ranges::view::transform([&](const Pair &pair) {
-		return questionById(pair.first);
-	}) | ranges::view::take(kQueryLimit) | ranges::to_vector;
+	}) | ranges::to_vector;
+	_lastQuery.matched = good | ranges::view::transform([](
+			const Pair &pair) {
+		return pair.first;
+	}) | ranges::to_vector;
+	_lastQuery.words = words;
+
+	const auto limit = std::min(int(good.size()), kQueryLimit);
+	std::partial_sort(
+		begin(good),
+		begin(good) + limit,
+		end(good),
+		sorter);
+	return good | ranges::view::take(limit) | ranges::view::transform([&](
+			const Pair &pair) {
+		return QuestionById(_data, pair.first);
+	}) | ranges::to_vector;
 }
 
 } // namespace Support
@@ -36,10 +36,21 @@ struct TemplatesIndex {
 	using Id = std::pair<QString, QString>; // filename, normalized question
 	using Term = std::pair<QString, int>; // search term, weight
 
-	std::map<QChar, std::vector<Id>> first;
+	// Questions by the first kIndexPrefixLength letters of their words.
+	std::map<QString, std::vector<Id>> prefixes;
 	std::map<Id, std::vector<Term>> full;
 };
 
+struct TemplatesKey {
+	TemplatesIndex::Id first; // Found by matchExact().
+	TemplatesIndex::Id last; // Found by matchFromEnd().
+};
+
+struct TemplatesQuery {
+	QStringList words;
+	std::vector<TemplatesIndex::Id> matched;
+};
+
 } // namespace details
 
 class Templates : public base::has_weak_ptr {
@@ -76,11 +87,14 @@ private:
 	void updateRequestFinished(QNetworkReply *reply);
 	void checkUpdateFinished();
 	void setData(details::TemplatesData &&data);
+	void refreshCaches();
 
 	not_null<Main::Session*> _session;
 
 	details::TemplatesData _data;
 	details::TemplatesIndex _index;
+	std::map<QString, details::TemplatesKey> _keys;
+	mutable details::TemplatesQuery _lastQuery;
 	rpl::event_stream<QStringList> _errors;
 	base::binary_guard _reading;
 	bool _reloadAfterRead = false;
@@ -64,7 +64,11 @@ Manager::Manager() {
 }
 
 void Manager::start(not_null<Basic*> animation) {
-	_forceImmediateUpdate = true;
+	// While other animations run the new one joins their next tick,
+	// an immediate tick would advance and repaint all of them off beat.
+	if (empty(_active) && empty(_starting)) {
+		_forceImmediateUpdate = true;
+	}
 	if (_updating) {
 		_starting.emplace_back(animation.get());
 	} else {
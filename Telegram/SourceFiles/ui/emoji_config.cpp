@@ -47,16 +47,24 @@ public:
 
 	bool cached() const;
 	void draw(QPainter &p, EmojiPtr emoji, int x, int y);
+	void draw(
+		QPainter &p,
+		const std::vector<std::pair<EmojiPtr, QPoint>> &list);
 
 private:
 	void readCache();
 	void generateCache();
 	void checkUniversalImages();
 	void pushSprite(QImage &&data);
+	const QPixmap &sprite(int index);
 
 	int _id = 0;
 	int _size = 0;
+
+	// Images are converted to pixmaps when their sprite is first drawn.
+	std::vector<QImage> _images;
 	std::vector<QPixmap> _sprites;
+	std::vector<std::shared_ptr<QFile>> _mapped;
 	base::binary_guard _generating;
 
 };
@@ -173,7 +181,9 @@ void ClearCurrentSetIdSync() {
 void SaveToFile(int id, const QImage &image, int size, int index) {
 	Expects(image.bytesPerLine() == image.width() * 4);
 
-	QFile f(CacheFilePath(size, index));
+	// The old cache file may still be mapped, so it is never rewritten.
+	const auto path = CacheFilePath(size, index);
+	QFile f(path + qsl(".new"));
 	if (!f.open(QIODevice::WriteOnly)) {
 		if (!QDir::current().mkpath(internal::CacheFileFolder())
 			|| !f.open(QIODevice::WriteOnly)) {
@@ -206,67 +216,81 @@ void SaveToFile(int id, const QImage &image, int size, int index) {
 		LOG(("App Error: Could not write emoji cache '%1' for size %2"
 			).arg(f.fileName()
 			).arg(size));
+		f.remove();
+		return;
+	}
+	f.close();
+	QFile(path).remove();
+	if (!f.rename(path)) {
+		LOG(("App Error: Could not replace emoji cache '%1' for size %2"
+			).arg(path
+			).arg(size));
+		f.remove();
 	}
 }
 
-QImage LoadFromFile(int id, int size, int index) {
+// Sprite pixels point right into the mapped cache file,
+// so the file must stay mapped while the sprite is used.
+struct CachedSprite {
+	QImage image;
+	std::shared_ptr<QFile> file;
+};
+
+CachedSprite LoadFromFile(int id, int size, int index) {
 	const auto rows = RowsCount(index);
 	const auto width = kImagesPerRow * size;
 	const auto height = rows * size;
 	const auto fileSize = 4 * sizeof(uint32)
 		+ (width * height * 4)
 		+ openssl::kSha256Size;
-	QFile f(CacheFilePath(size, index));
-	if (!f.exists()
-		|| f.size() != fileSize
-		|| !f.open(QIODevice::ReadOnly)) {
-		return QImage();
+	auto file = std::make_shared<QFile>(CacheFilePath(size, index));
+	if (!file->exists()
+		|| file->size() != fileSize
+		|| !file->open(QIODevice::ReadOnly)) {
+		return {};
+	}
+
+	// A private mapping, so that the image stays writable in memory.
+	const auto mapped = file->map(
+		0,
+		fileSize,
+		QFileDevice::MapPrivateOption);
+	if (!mapped) {
+		return {};
 	}
-	const auto read = [&](bytes::span data) {
-		return f.read(
-			reinterpret_cast<char*>(data.data()),
-			data.size()
-		) == data.size();
-	};
 	uint32 header[4] = { 0 };
-	if (!read(bytes::make_span(header))
-		|| header[0] != ComputeVersion(id)
+	memcpy(header, mapped, sizeof(header));
+	if (header[0] != ComputeVersion(id)
 		|| header[1] != size
 		|| header[2] != width
 		|| header[3] != height) {
-		return QImage();
+		return {};
 	}
+	const auto pixels = mapped + sizeof(header);
 	auto result = QImage(
+		pixels,
 		width,
 		height,
+		width * 4,
 		QImage::Format_ARGB32_Premultiplied);
-	Assert(result.bytesPerLine() == width * 4);
-	const auto data = bytes::make_span(
-		reinterpret_cast<bytes::type*>(result.bits()),
-		width * height * 4);
-	auto signature = bytes::vector(openssl::kSha256Size);
-	if (!read(data)
-		|| !read(signature)
-		//|| (bytes::compare(
-		//	signature,
-		//	openssl::Sha256(bytes::make_span(header), data)) != 0)
-		|| false) {
-		return QImage();
-	}
-	crl::async([=, signature = std::move(signature)] {
+	crl::async([=, file = file]() mutable {
 		// This should not happen (invalid signature),
 		// so we delay this check and fix only the next launch.
 		const auto data = bytes::make_span(
-			reinterpret_cast<const bytes::type*>(result.bits()),
+			reinterpret_cast<const bytes::type*>(pixels),
 			width * height * 4);
+		const auto signature = bytes::make_span(
+			reinterpret_cast<const bytes::type*>(pixels) + data.size(),
+			openssl::kSha256Size);
 		const auto result = bytes::compare(
 			signature,
 			openssl::Sha256(bytes::make_span(header), data));
 		if (result != 0) {
 			QFile(CacheFilePath(size, index)).remove();
 		}
+		crl::on_main([file = std::move(file)] {});
 	});
-	return result;
+	return { std::move(result), std::move(file) };
 }
 
 std::vector<QImage> LoadSprites(int id) {
@@ -927,6 +951,30 @@ void Draw(QPainter &p, EmojiPtr emoji, int size, int x, int y) {
 	}
 }
 
+void Draw(
+		QPainter &p,
+		const std::vector<std::pair<EmojiPtr, QPoint>> &list,
+		int size) {
+#if defined Q_OS_MAC && !defined OS_MAC_OLD
+	const auto s = (cScale() == kScaleForTouchBar)
+		? SizeLarge
+		: TouchbarSize;
+	if (size == s) {
+		for (const auto &[emoji, position] : list) {
+			TouchbarEmoji->draw(p, emoji, position.x(), position.y());
+		}
+		return;
+	}
+#endif
+	if (size == SizeNormal) {
+		InstanceNormal->draw(p, list);
+	} else if (size == SizeLarge) {
+		InstanceLarge->draw(p, list);
+	} else {
+		Unexpected("Size in Ui::Emoji::Draw.");
+	}
+}
+
 Instance::Instance(int size) : _id(Universal->id()), _size(size) {
 	Expects(Universal != nullptr);
 
@@ -946,25 +994,63 @@ void Instance::draw(QPainter &p, EmojiPtr emoji, int x, int y) {
 	if (Universal && Universal->id() != _id) {
 		generateCache();
 	}
-	const auto sprite = emoji->sprite();
-	if (sprite >= _sprites.size()) {
+	const auto index = emoji->sprite();
+	if (index >= _sprites.size()) {
 		Assert(Universal != nullptr);
 		Universal->draw(p, emoji, _size, x, y);
 		return;
 	}
 	p.drawPixmap(
 		QPoint(x, y),
-		_sprites[sprite],
+		sprite(index),
 		QRect(emoji->column() * _size, emoji->row() * _size, _size, _size));
 }
 
+void Instance::draw(
+		QPainter &p,
+		const std::vector<std::pair<EmojiPtr, QPoint>> &list) {
+	if (Universal && Universal->id() != _id) {
+		generateCache();
+	}
+	auto fragments = std::vector<std::vector<QPainter::PixmapFragment>>(
+		_sprites.size());
+	for (const auto &[emoji, position] : list) {
+		const auto index = emoji->sprite();
+		if (index >= _sprites.size()) {
+			Assert(Universal != nullptr);
+			Universal->draw(p, emoji, _size, position.x(), position.y());
+			continue;
+		}
+		const auto scale = 1. / sprite(index).devicePixelRatio();
+		const auto half = _size * scale / 2.;
+		fragments[index].push_back(QPainter::PixmapFragment::create(
+			QPointF(position) + QPointF(half, half),
+			QRectF(
+				emoji->column() * _size,
+				emoji->row() * _size,
+				_size,
+				_size),
+			scale,
+			scale));
+	}
+	for (auto i = 0, count = int(fragments.size()); i != count; ++i) {
+		if (!fragments[i].empty()) {
+			p.drawPixmapFragments(
+				fragments[i].data(),
+				int(fragments[i].size()),
+				sprite(i));
+		}
+	}
+}
+
 void Instance::readCache() {
 	for (auto i = 0; i != SpritesCount; ++i) {
-		auto image = LoadFromFile(_id, _size, i);
-		if (image.isNull()) {
+		auto cached = LoadFromFile(_id, _size, i);
+		if (cached.image.isNull()) {
 			return;
 		}
-		pushSprite(std::move(image));
+		pushSprite(std::move(cached.image));
+		_mapped.push_back(std::move(cached.file));
 	}
 }
 
@@ -974,7 +1060,9 @@ void Instance::checkUniversalImages() {
 	if (_id != Universal->id()) {
 		_id = Universal->id();
 		_generating = nullptr;
+		_images.clear();
 		_sprites.clear();
+		_mapped.clear();
 	}
 	if (!Universal->ensureLoaded() && Universal->id() != 0) {
 		ClearCurrentSetIdSync();
@@ -1009,8 +1097,19 @@ void Instance::generateCache() {
 }
 
 void Instance::pushSprite(QImage &&data) {
-	_sprites.push_back(App::pixmapFromImageInPlace(std::move(data)));
-	_sprites.back().setDevicePixelRatio(cRetinaFactor());
+	_images.push_back(std::move(data));
+	_sprites.emplace_back();
+}
+
+const QPixmap &Instance::sprite(int index) {
+	Expects(index >= 0 && index < _sprites.size());
+
+	auto &result = _sprites[index];
+	if (result.isNull()) {
+		result = App::pixmapFromImageInPlace(base::take(_images[index]));
+		result.setDevicePixelRatio(cRetinaFactor());
+	}
+	return result;
 }
 
 const std::shared_ptr<UniversalImages> &SourceImages() {
@@ -167,6 +167,12 @@ rpl::producer<> UpdatedRecent();
 const QPixmap &SinglePixmap(EmojiPtr emoji, int fontHeight);
 void Draw(QPainter &p, EmojiPtr emoji, int size, int x, int y);
 
+// Paints all emoji from the same sprite by one drawPixmapFragments().
+void Draw(
+	QPainter &p,
+	const std::vector<std::pair<EmojiPtr, QPoint>> &list,
+	int size);
+
 class UniversalImages {
 public:
 	explicit UniversalImages(int id);
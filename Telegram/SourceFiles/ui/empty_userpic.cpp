@@ -12,6 +12,39 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "styles/style_history.h"
 
 namespace Ui {
+namespace {
+
+// Rendered empty userpics are shared by all the places that paint
+// the same peer at the same size, dropping the least recently used.
+constexpr auto kMaxCachedBytes = 8 * 1024 * 1024;
+
+using CacheKey = std::tuple<InMemoryKey, QRgb, int, int>;
+
+struct CachedUserpic {
+	QPixmap pixmap;
+	uint64 lastUsed = 0;
+};
+
+base::flat_map<CacheKey, CachedUserpic> Cache;
+int64 CacheBytes = 0;
+uint64 CacheUsed = 0;
+
+int64 ComputeUsage(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * 4;
+}
+
+void DropLeastUsed() {
+	Expects(!Cache.empty());
+
+	const auto i = ranges::min_element(
+		Cache,
+		std::less<>(),
+		[](const auto &pair) { return pair.second.lastUsed; });
+	CacheBytes -= ComputeUsage(i->second.pixmap);
+	Cache.erase(i);
+}
+
+} // namespace
 
 EmptyUserpic::EmptyUserpic(const style::color &color, const QString &name)
 : _color(color) {
@@ -49,21 +82,81 @@ void EmptyUserpic::paint(
 		int y,
 		int outerWidth,
 		int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawEllipse(x, y, size, size);
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Circle);
 }
 
 void EmptyUserpic::paintRounded(Painter &p, int x, int y, int outerWidth, int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawRoundedRect(x, y, size, size, st::buttonRadius, st::buttonRadius);
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Rounded);
 }
 
 void EmptyUserpic::paintSquare(Painter &p, int x, int y, int outerWidth, int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.fillRect(x, y, size, size, p.brush());
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Square);
+}
+
+void EmptyUserpic::paintCached(
+		Painter &p,
+		int x,
+		int y,
+		int outerWidth,
+		int size,
+		Shape shape) const {
+	if (size <= 0) {
+		return;
+	}
+	x = rtl() ? (outerWidth - x - size) : x;
+	p.drawPixmap(x, y, cached(size, shape));
+}
+
+QPixmap EmptyUserpic::cached(int size, Shape shape) const {
+	// The key has both colors, so palette changes don't need a reset.
+	const auto key = CacheKey(
+		uniqueKey(),
+		st::historyPeerUserpicFg->c.rgba(),
+		size,
+		int(shape));
+	auto i = Cache.find(key);
+	if (i == end(Cache)) {
+		auto pixmap = generateCached(size, shape);
+		const auto usage = ComputeUsage(pixmap);
+		while (!Cache.empty() && CacheBytes + usage > kMaxCachedBytes) {
+			DropLeastUsed();
+		}
+		CacheBytes += usage;
+		i = Cache.emplace(key, CachedUserpic{ std::move(pixmap) }).first;
+	}
+	i->second.lastUsed = ++CacheUsed;
+	return i->second.pixmap;
+}
+
+QPixmap EmptyUserpic::generateCached(int size, Shape shape) const {
+	auto result = QImage(
+		QSize(size, size) * cIntRetinaFactor(),
+		QImage::Format_ARGB32_Premultiplied);
+	result.setDevicePixelRatio(cRetinaFactor());
+	result.fill(Qt::transparent);
+	{
+		Painter p(&result);
+		paint(p, 0, 0, size, size, [&] {
+			switch (shape) {
+			case Shape::Circle:
+				p.drawEllipse(0, 0, size, size);
+				break;
+			case Shape::Rounded:
+				p.drawRoundedRect(
+					0,
+					0,
+					size,
+					size,
+					st::buttonRadius,
+					st::buttonRadius);
+				break;
+			case Shape::Square:
+				p.fillRect(0, 0, size, size, p.brush());
+				break;
+			}
+		});
+	}
+	return App::pixmapFromImageInPlace(std::move(result));
 }
 
 void EmptyUserpic::PaintSavedMessages(
@@ -169,14 +262,7 @@ InMemoryKey EmptyUserpic::uniqueKey() const {
 }
 
 QPixmap EmptyUserpic::generate(int size) {
-	auto result = QImage(QSize(size, size) * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
-	result.setDevicePixelRatio(cRetinaFactor());
-	result.fill(Qt::transparent);
-	{
-		Painter p(&result);
-		paint(p, 0, 0, size, size);
-	}
-	return App::pixmapFromImageInPlace(std::move(result));
+	return cached(size, Shape::Circle);
 }
 
 void EmptyUserpic::fillString(const QString &name) {
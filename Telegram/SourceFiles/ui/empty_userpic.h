@@ -52,6 +52,22 @@ public:
 	~EmptyUserpic();
 
 private:
+	enum class Shape {
+		Circle,
+		Rounded,
+		Square,
+	};
+
+	void paintCached(
+		Painter &p,
+		int x,
+		int y,
+		int outerWidth,
+		int size,
+		Shape shape) const;
+	[[nodiscard]] QPixmap cached(int size, Shape shape) const;
+	[[nodiscard]] QPixmap generateCached(int size, Shape shape) const;
+
 	template <typename Callback>
 	void paint(
 		Painter &p,
@@ -10,6 +10,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Ui {
 namespace {
 
+constexpr auto kCachedLayoutsCount = 64;
+
 int Round(float64 value) {
 	return int(std::round(value));
 }
@@ -565,6 +567,20 @@ std::vector<GroupMediaLayout> ComplexLayouter::layout() const {
 	return result;
 }
 
+struct CachedLayout {
+	std::vector<QSize> sizes;
+	int maxWidth = 0;
+	int minWidth = 0;
+	int spacing = 0;
+	std::vector<GroupMediaLayout> result;
+};
+
+// Most recently used first, albums in a chat share a few layouts.
+std::vector<CachedLayout> &CachedLayouts() {
+	static auto result = std::vector<CachedLayout>();
+	return result;
+}
+
 } // namespace
 
 std::vector<GroupMediaLayout> LayoutMediaGroup(
@@ -572,7 +588,25 @@ std::vector<GroupMediaLayout> LayoutMediaGroup(
 		int maxWidth,
 		int minWidth,
 		int spacing) {
-	return Layouter(sizes, maxWidth, minWidth, spacing).layout();
+	auto &cache = CachedLayouts();
+	const auto i = ranges::find_if(cache, [&](const CachedLayout &entry) {
+		return (entry.maxWidth == maxWidth)
+			&& (entry.minWidth == minWidth)
+			&& (entry.spacing == spacing)
+			&& (entry.sizes == sizes);
+	});
+	if (i != end(cache)) {
+		std::rotate(begin(cache), i, i + 1);
+		return cache.front().result;
+	}
+	auto result = Layouter(sizes, maxWidth, minWidth, spacing).layout();
+	if (cache.size() == kCachedLayoutsCount) {
+		cache.pop_back();
+	}
+	cache.insert(
+		begin(cache),
+		CachedLayout{ sizes, maxWidth, minWidth, spacing, result });
+	return result;
 }
 
 RectParts GetCornersFromSides(RectParts sides) {
@@ -23,6 +23,12 @@ namespace {
 // After 128 MB of unpacked images we try to clear some memory.
 constexpr auto kMemoryForCache = 128 * 1024 * 1024;
 
+// Each image keeps this many scaled variants, least recently used first
+// to go, so that resizing a window doesn't pile them up.
+constexpr auto kMaxSizesCache = 8;
+
+auto SizesCacheUsed = uint64(0);
+
 std::map<QString, std::unique_ptr<Image>> LocalFileImages;
 std::map<QString, std::unique_ptr<Image>> WebUrlImages;
 std::unordered_map<InMemoryKey, std::unique_ptr<Image>> StorageImages;
@@ -38,11 +44,12 @@ int64 ComputeUsage(const QPixmap &image) {
 }
 
 int64 ComputeUsage(const QImage &image) {
-	return ComputeUsage(image.size());
+	return int64(image.bytesPerLine()) * image.height();
 }
 
 [[nodiscard]] Core::MediaActiveCache<const Image> &ActiveCache() {
 	static auto Instance = Core::MediaActiveCache<const Image>(
+		"Images",
 		kMemoryForCache,
 		[](const Image *image) { image->unload(); });
 	return Instance;
@@ -54,8 +61,11 @@ uint64 PixKey(int width, int height, Options options) {
 		| (static_cast<uint64>(options) << 48);
 }
 
-uint64 SinglePixKey(Options options) {
-	return PixKey(0, 0, options);
+// Copies of one media shown in several places at different sizes
+// keep a variant for each size, limited by kMaxSizesCache.
+uint64 SinglePixKey(QSize outer, Options options) {
+	constexpr auto kSingleFlag = (uint64(1) << 63);
+	return PixKey(outer.width(), outer.height(), options) | kSingleFlag;
 }
 
 } // namespace
@@ -541,6 +551,43 @@ bool Image::isNull() const {
 	return (this == Empty());
 }
 
+template <typename Generator>
+const QPixmap &Image::cachedPix(
+		uint64 key,
+		QSize outer,
+		Generator &&generator) const {
+	auto i = _sizesCache.find(key);
+	if (i != end(_sizesCache)
+		&& !outer.isEmpty()
+		&& i->second.pixmap.size() != outer) {
+		ActiveCache().decrement(ComputeUsage(i->second.pixmap));
+		_sizesCache.erase(i);
+		i = end(_sizesCache);
+	}
+	if (i == end(_sizesCache)) {
+		while (int(_sizesCache.size()) >= kMaxSizesCache) {
+			dropLeastUsedSize();
+		}
+		auto pixmap = generator();
+		pixmap.setDevicePixelRatio(cRetinaFactor());
+		ActiveCache().increment(ComputeUsage(pixmap));
+		i = _sizesCache.emplace(key, CachedPixmap{ std::move(pixmap) }).first;
+	}
+	i->second.lastUsed = ++SizesCacheUsed;
+	return i->second.pixmap;
+}
+
+void Image::dropLeastUsedSize() const {
+	Expects(!_sizesCache.empty());
+
+	const auto i = ranges::min_element(
+		_sizesCache,
+		std::less<>(),
+		[](const auto &pair) { return pair.second.lastUsed; });
+	ActiveCache().decrement(ComputeUsage(i->second.pixmap));
+	_sizesCache.erase(i);
+}
+
 const QPixmap &Image::pix(
 		Data::FileOrigin origin,
 		int32 w,
@@ -554,15 +601,9 @@ const QPixmap &Image::pix(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::None;
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixNoCache(origin, w, h, options);
+	});
 }
 
 const QPixmap &Image::pixRounded(
@@ -593,15 +634,9 @@ const QPixmap &Image::pixRounded(
 	} else if (radius == ImageRoundRadius::Ellipse) {
 		options |= Option::Circled | cornerOptions(corners);
 	}
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixNoCache(origin, w, h, options);
+	});
 }
 
 const QPixmap &Image::pixCircled(
@@ -617,15 +652,9 @@ const QPixmap &Image::pixCircled(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Circled;
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixNoCache(origin, w, h, options);
+	});
 }
 
 const QPixmap &Image::pixBlurredCircled(
@@ -641,15 +670,9 @@ const QPixmap &Image::pixBlurredCircled(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Circled | Option::Blurred;
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixNoCache(origin, w, h, options);
+	});
 }
 
 const QPixmap &Image::pixBlurred(
@@ -665,15 +688,9 @@ const QPixmap &Image::pixBlurred(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Blurred;
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixNoCache(origin, w, h, options);
+	});
 }
 
 const QPixmap &Image::pixColored(
@@ -690,15 +707,9 @@ const QPixmap &Image::pixColored(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Colored;
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixColoredNoCache(origin, add, w, h, true);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixColoredNoCache(origin, add, w, h, true);
+	});
 }
 
 const QPixmap &Image::pixBlurredColored(
@@ -715,15 +726,9 @@ const QPixmap &Image::pixBlurredColored(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Blurred | Option::Smooth | Option::Colored;
-	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixBlurredColoredNoCache(origin, add, w, h);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	return cachedPix(PixKey(w, h, options), QSize(), [&] {
+		return pixBlurredColoredNoCache(origin, add, w, h);
+	});
 }
 
 const QPixmap &Image::pixSingle(
@@ -762,18 +767,10 @@ const QPixmap &Image::pixSingle(
 		options |= Option::Colored;
 	}
 
-	auto k = SinglePixKey(options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend() || i->width() != (outerw * cIntRetinaFactor()) || i->height() != (outerh * cIntRetinaFactor())) {
-		if (i != _sizesCache.cend()) {
-			ActiveCache().decrement(ComputeUsage(*i));
-		}
-		auto p = pixNoCache(origin, w, h, options, outerw, outerh, colored);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	const auto outer = QSize(outerw, outerh) * cIntRetinaFactor();
+	return cachedPix(SinglePixKey(outer, options), outer, [&] {
+		return pixNoCache(origin, w, h, options, outerw, outerh, colored);
+	});
 }
 
 const QPixmap &Image::pixBlurredSingle(
@@ -808,18 +805,10 @@ const QPixmap &Image::pixBlurredSingle(
 		options |= Option::Circled | cornerOptions(corners);
 	}
 
-	auto k = SinglePixKey(options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend() || i->width() != (outerw * cIntRetinaFactor()) || i->height() != (outerh * cIntRetinaFactor())) {
-		if (i != _sizesCache.cend()) {
-			ActiveCache().decrement(ComputeUsage(*i));
-		}
-		auto p = pixNoCache(origin, w, h, options, outerw, outerh);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
-	}
-	return i.value();
+	const auto outer = QSize(outerw, outerh) * cIntRetinaFactor();
+	return cachedPix(SinglePixKey(outer, options), outer, [&] {
+		return pixNoCache(origin, w, h, options, outerw, outerh);
+	});
 }
 
 QPixmap Image::pixNoCache(
@@ -1002,8 +991,8 @@ void Image::setImageBytes(const QByteArray &bytes) {
 
 void Image::invalidateSizeCache() const {
 	auto &cache = ActiveCache();
-	for (const auto &image : std::as_const(_sizesCache)) {
-		cache.decrement(ComputeUsage(image));
+	for (const auto &[key, cached] : _sizesCache) {
+		cache.decrement(ComputeUsage(cached.pixmap));
 	}
 	_sizesCache.clear();
 }
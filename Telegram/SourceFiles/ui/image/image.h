@@ -233,11 +233,24 @@ public:
 	~Image();
 
 private:
+	struct CachedPixmap {
+		QPixmap pixmap;
+		uint64 lastUsed = 0;
+	};
+
 	void checkSource() const;
 	void invalidateSizeCache() const;
 
+	// An empty outer size means any size of the cached pixmap is fine.
+	template <typename Generator>
+	const QPixmap &cachedPix(
+		uint64 key,
+		QSize outer,
+		Generator &&generator) const;
+	void dropLeastUsedSize() const;
+
 	std::unique_ptr<Images::Source> _source;
-	mutable QMap<uint64, QPixmap> _sizesCache;
+	mutable std::map<uint64, CachedPixmap> _sizesCache;
 	mutable QImage _data;
 
 };
@@ -0,0 +1,125 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "ui/image/image_atlas.h"
+
+namespace Images {
+namespace {
+
+constexpr auto kPageSize = 1024;
+
+} // namespace
+
+Atlas::Atlas(QSize cell, int maxPages) : _maxPages(maxPages) {
+	setCell(cell);
+}
+
+QSize Atlas::cell() const {
+	return _cell;
+}
+
+void Atlas::setCell(QSize cell) {
+	if (_cell == cell) {
+		return;
+	}
+	clear();
+	_cell = cell;
+	_columns = cell.isEmpty()
+		? 0
+		: std::max(kPageSize / cell.width(), 1);
+	_rows = cell.isEmpty()
+		? 0
+		: std::max(kPageSize / cell.height(), 1);
+}
+
+void Atlas::clear() {
+	_pages.clear();
+	_places.clear();
+	_used = 0;
+}
+
+bool Atlas::contains(uint64 key) const {
+	return _places.contains(key);
+}
+
+QRect Atlas::cellRect(int index) const {
+	const auto inPage = index % (_columns * _rows);
+	return QRect(
+		QPoint(
+			(inPage % _columns) * _cell.width(),
+			(inPage / _columns) * _cell.height()),
+		_cell);
+}
+
+bool Atlas::insert(uint64 key, const QPixmap &pixmap) {
+	const auto perPage = _columns * _rows;
+	if (!perPage
+		|| pixmap.isNull()
+		|| pixmap.width() > _cell.width()
+		|| pixmap.height() > _cell.height()) {
+		return false;
+	}
+	const auto i = _places.find(key);
+	const auto index = (i != end(_places))
+		? -1
+		: _used;
+	const auto page = (index >= 0) ? (index / perPage) : i->second.page;
+	if (page >= _maxPages) {
+		return false;
+	} else if (page == int(_pages.size())) {
+		auto created = QPixmap(
+			_columns * _cell.width(),
+			_rows * _cell.height());
+		created.fill(Qt::transparent);
+		_pages.push_back({ std::move(created) });
+	}
+	const auto rect = (index >= 0)
+		? QRect(cellRect(index).topLeft(), pixmap.size())
+		: QRect(i->second.rect.topLeft(), pixmap.size());
+	{
+		QPainter p(&_pages[page].pixmap);
+		p.setCompositionMode(QPainter::CompositionMode_Source);
+		p.fillRect(QRect(rect.topLeft(), _cell), Qt::transparent);
+		p.drawPixmap(rect, pixmap);
+	}
+	_places[key] = Place{ page, rect, pixmap.devicePixelRatio() };
+	if (index >= 0) {
+		++_used;
+	}
+	return true;
+}
+
+bool Atlas::enqueue(uint64 key, QPoint position) {
+	const auto i = _places.find(key);
+	if (i == end(_places)) {
+		return false;
+	}
+	const auto &place = i->second;
+	const auto scale = 1. / place.ratio;
+	const auto center = QPointF(position)
+		+ QPointF(place.rect.width(), place.rect.height()) * (scale / 2.);
+	_pages[place.page].queued.push_back(QPainter::PixmapFragment::create(
+		center,
+		place.rect,
+		scale,
+		scale));
+	return true;
+}
+
+void Atlas::paint(QPainter &p) {
+	for (auto &page : _pages) {
+		if (!page.queued.empty()) {
+			p.drawPixmapFragments(
+				page.queued.data(),
+				int(page.queued.size()),
+				page.pixmap);
+			page.queued.clear();
+		}
+	}
+}
+
+} // namespace Images
@@ -0,0 +1,57 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/flat_map.h"
+
+namespace Images {
+
+// Keeps many small pixmaps in a few large pages, so that all the queued
+// ones are painted by one drawPixmapFragments() call for each page.
+class Atlas final {
+public:
+	explicit Atlas(QSize cell = QSize(), int maxPages = 4);
+
+	[[nodiscard]] QSize cell() const;
+	void setCell(QSize cell);
+	void clear();
+
+	[[nodiscard]] bool contains(uint64 key) const;
+
+	// Returns false if the pixmap doesn't fit in a cell or if there are
+	// no free cells left, the caller should paint it directly then.
+	bool insert(uint64 key, const QPixmap &pixmap);
+
+	// Returns false if the key was not inserted.
+	bool enqueue(uint64 key, QPoint position);
+	void paint(QPainter &p);
+
+private:
+	struct Place {
+		int page = 0;
+		QRect rect;
+		qreal ratio = 1.;
+	};
+	struct Page {
+		QPixmap pixmap;
+		std::vector<QPainter::PixmapFragment> queued;
+	};
+
+	[[nodiscard]] QRect cellRect(int index) const;
+
+	QSize _cell;
+	int _columns = 0;
+	int _rows = 0;
+	int _maxPages = 0;
+	int _used = 0;
+	std::vector<Page> _pages;
+	base::flat_map<uint64, Place> _places;
+
+};
+
+} // namespace Images
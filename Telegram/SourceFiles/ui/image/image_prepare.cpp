@@ -7,9 +7,311 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "ui/image/image_prepare.h"
 
+#include "base/build_config.h"
+
+#ifdef ARCH_CPU_X86_FAMILY
+#include <emmintrin.h>
+#ifdef COMPILER_MSVC
+#define TDESKTOP_SSE2_TARGET
+#else // COMPILER_MSVC
+#define TDESKTOP_SSE2_TARGET __attribute__((target("sse2")))
+#endif // COMPILER_MSVC
+#endif // ARCH_CPU_X86_FAMILY
+
 namespace Images {
 namespace {
 
+// Wallpaper sized images are blurred by bands of lines on a few threads.
+constexpr auto kBlurParallelMinPixels = 512 * 512;
+constexpr auto kBlurMaxThreads = 4;
+constexpr auto kBlurBandsPerThread = 2;
+
+// The float division of the SSE2 blur is exact up to this radius.
+constexpr auto kBlurMaxVectorRadius = 64;
+
+// Multiplies premultiplied pixels by the first byte of mask pixels,
+// the same as anim::unshifted(anim::shifted(pixel) * (mask + 1)).
+TG_FORCE_INLINE uint32 MaskPixel(uint32 pixel, uchar mask) {
+	const auto opacity = static_cast<anim::ShiftedMultiplier>(mask) + 1;
+	return anim::unshifted(anim::shifted(pixel) * opacity);
+}
+
+#ifdef ARCH_CPU_X86_FAMILY
+
+TDESKTOP_SSE2_TARGET void MaskLineSSE2(
+		uint32 *pixels,
+		const uchar *mask,
+		int maskBytesPerPixel,
+		int width) {
+	const auto zero = _mm_setzero_si128();
+	auto x = 0;
+	for (; x + 4 <= width; x += 4) {
+		const auto m0 = short(mask[0]) + 1;
+		const auto m1 = short(mask[maskBytesPerPixel]) + 1;
+		const auto m2 = short(mask[2 * maskBytesPerPixel]) + 1;
+		const auto m3 = short(mask[3 * maskBytesPerPixel]) + 1;
+		mask += 4 * maskBytesPerPixel;
+
+		const auto data = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(pixels + x));
+		const auto low = _mm_srli_epi16(
+			_mm_mullo_epi16(
+				_mm_unpacklo_epi8(data, zero),
+				_mm_set_epi16(m1, m1, m1, m1, m0, m0, m0, m0)),
+			8);
+		const auto high = _mm_srli_epi16(
+			_mm_mullo_epi16(
+				_mm_unpackhi_epi8(data, zero),
+				_mm_set_epi16(m3, m3, m3, m3, m2, m2, m2, m2)),
+			8);
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(pixels + x),
+			_mm_packus_epi16(low, high));
+	}
+	for (; x != width; ++x) {
+		pixels[x] = MaskPixel(pixels[x], *mask);
+		mask += maskBytesPerPixel;
+	}
+}
+
+#endif // ARCH_CPU_X86_FAMILY
+
+void MaskPixels(
+		uint32 *pixels,
+		int pixelsPerLine,
+		const uchar *mask,
+		int maskBytesPerPixel,
+		int maskBytesPerLine,
+		QSize size) {
+	for (auto y = 0; y != size.height(); ++y) {
+#ifdef ARCH_CPU_X86_FAMILY
+		MaskLineSSE2(pixels, mask, maskBytesPerPixel, size.width());
+#else // ARCH_CPU_X86_FAMILY
+		auto maskBytes = mask;
+		for (auto x = 0; x != size.width(); ++x) {
+			pixels[x] = MaskPixel(pixels[x], *maskBytes);
+			maskBytes += maskBytesPerPixel;
+		}
+#endif // ARCH_CPU_X86_FAMILY
+		pixels += pixelsPerLine;
+		mask += maskBytesPerLine;
+	}
+}
+
+void BlurLine(
+		const uchar *from,
+		uchar *to,
+		int step,
+		int length,
+		int radius,
+		const int *dv,
+		int *stack) {
+	const auto last = length - 1;
+	const auto div = 2 * radius + 1;
+	const auto radius_p1 = radius + 1;
+
+	auto rinsum = 0;
+	auto ginsum = 0;
+	auto binsum = 0;
+	auto routsum = 0;
+	auto goutsum = 0;
+	auto boutsum = 0;
+	auto rsum = 0;
+	auto gsum = 0;
+	auto bsum = 0;
+	for (auto i = -radius; i != radius + 1; ++i) {
+		const auto sir = &stack[(i + radius) * 3];
+		const auto pixel = from + std::clamp(i, 0, last) * step;
+		sir[0] = pixel[0];
+		sir[1] = pixel[1];
+		sir[2] = pixel[2];
+
+		const auto rbs = radius_p1 - std::abs(i);
+		rsum += sir[0] * rbs;
+		gsum += sir[1] * rbs;
+		bsum += sir[2] * rbs;
+		if (i > 0) {
+			rinsum += sir[0];
+			ginsum += sir[1];
+			binsum += sir[2];
+		} else {
+			routsum += sir[0];
+			goutsum += sir[1];
+			boutsum += sir[2];
+		}
+	}
+	auto stackpointer = radius;
+	for (auto x = 0; x != length; ++x) {
+		const auto result = to + x * step;
+		result[0] = dv[rsum];
+		result[1] = dv[gsum];
+		result[2] = dv[bsum];
+
+		rsum -= routsum;
+		gsum -= goutsum;
+		bsum -= boutsum;
+
+		const auto stackstart = (stackpointer - radius + div) % div;
+		const auto sir = &stack[stackstart * 3];
+
+		routsum -= sir[0];
+		goutsum -= sir[1];
+		boutsum -= sir[2];
+
+		const auto pixel = from + std::min(x + radius_p1, last) * step;
+		sir[0] = pixel[0];
+		sir[1] = pixel[1];
+		sir[2] = pixel[2];
+		rinsum += sir[0];
+		ginsum += sir[1];
+		binsum += sir[2];
+
+		rsum += rinsum;
+		gsum += ginsum;
+		bsum += binsum;
+		{
+			stackpointer = (stackpointer + 1) % div;
+			const auto sir = &stack[stackpointer * 3];
+
+			routsum += sir[0];
+			goutsum += sir[1];
+			boutsum += sir[2];
+
+			rinsum -= sir[0];
+			ginsum -= sir[1];
+			binsum -= sir[2];
+		}
+	}
+}
+
+#ifdef ARCH_CPU_X86_FAMILY
+
+TDESKTOP_SSE2_TARGET TG_FORCE_INLINE __m128i BlurLoad(
+		const uchar *pixel,
+		__m128i zero) {
+	return _mm_unpacklo_epi16(
+		_mm_unpacklo_epi8(
+			_mm_cvtsi32_si128(*reinterpret_cast<const int*>(pixel)),
+			zero),
+		zero);
+}
+
+struct BlurLanes {
+	__m128i value;
+};
+
+// All three channels of a pixel are blurred in lanes of one register,
+// the alpha byte of the result keeps the value it had in the target.
+TDESKTOP_SSE2_TARGET void BlurLineSSE2(
+		const uchar *from,
+		uchar *to,
+		int step,
+		int length,
+		int radius,
+		BlurLanes *stack) {
+	const auto zero = _mm_setzero_si128();
+	const auto last = length - 1;
+	const auto div = 2 * radius + 1;
+	const auto radius_p1 = radius + 1;
+
+	// (sum + 0.5) / divsum is never close enough to an integer to be
+	// rounded to it, so the truncated float result is sum / divsum.
+	const auto half = _mm_set1_ps(0.5f);
+	const auto multiplier = _mm_set1_ps(
+		1.f / float(radius_p1 * radius_p1));
+
+	auto insum = zero;
+	auto outsum = zero;
+	auto sum = zero;
+	for (auto i = -radius; i != radius + 1; ++i) {
+		const auto value = BlurLoad(from + std::clamp(i, 0, last) * step, zero);
+		stack[i + radius].value = value;
+
+		// Values fit in the low 16 bits of each lane.
+		sum = _mm_add_epi32(
+			sum,
+			_mm_madd_epi16(value, _mm_set1_epi32(radius_p1 - std::abs(i))));
+		if (i > 0) {
+			insum = _mm_add_epi32(insum, value);
+		} else {
+			outsum = _mm_add_epi32(outsum, value);
+		}
+	}
+	auto stackpointer = radius;
+	for (auto x = 0; x != length; ++x) {
+		const auto divided = _mm_cvttps_epi32(_mm_mul_ps(
+			_mm_add_ps(_mm_cvtepi32_ps(sum), half),
+			multiplier));
+		const auto packed = uint32(_mm_cvtsi128_si32(_mm_packus_epi16(
+			_mm_packs_epi32(divided, zero),
+			zero)));
+		const auto result = reinterpret_cast<uint32*>(to + x * step);
+		*result = (packed & 0x00FFFFFFU) | (*result & 0xFF000000U);
+
+		sum = _mm_sub_epi32(sum, outsum);
+
+		const auto stackstart = (stackpointer - radius + div) % div;
+		outsum = _mm_sub_epi32(outsum, stack[stackstart].value);
+
+		const auto value = BlurLoad(
+			from + std::min(x + radius_p1, last) * step,
+			zero);
+		stack[stackstart].value = value;
+		insum = _mm_add_epi32(insum, value);
+		sum = _mm_add_epi32(sum, insum);
+
+		stackpointer = (stackpointer + 1) % div;
+		outsum = _mm_add_epi32(outsum, stack[stackpointer].value);
+		insum = _mm_sub_epi32(insum, stack[stackpointer].value);
+	}
+}
+
+#endif // ARCH_CPU_X86_FAMILY
+
+// Calls method(from, till) for bands of lines [0, count), with large
+// images on several threads. The calling thread takes bands as well,
+// so a busy thread pool only makes it slower.
+template <typename Method>
+void BlurLines(int count, int pixels, Method method) {
+	const auto threads = (pixels >= kBlurParallelMinPixels)
+		? std::min(QThread::idealThreadCount(), kBlurMaxThreads)
+		: 1;
+	const auto bands = std::min(threads * kBlurBandsPerThread, count);
+	if (threads < 2 || bands < 2) {
+		method(0, count);
+		return;
+	}
+	struct Shared {
+		std::atomic<int> next{ 0 };
+		crl::semaphore finished;
+	};
+	const auto shared = std::make_shared<Shared>();
+	const auto process = [=] {
+		auto result = 0;
+		while (true) {
+			const auto band = shared->next++;
+			if (band >= bands) {
+				return result;
+			}
+			method(
+				count * band / bands,
+				count * (band + 1) / bands);
+			++result;
+		}
+	};
+	for (auto i = 1; i != threads; ++i) {
+		crl::async([=] {
+			for (auto j = process(); j != 0; --j) {
+				shared->finished.release();
+			}
+		});
+	}
+	auto left = bands - process();
+	while (left--) {
+		shared->finished.acquire();
+	}
+}
+
 TG_FORCE_INLINE uint64 blurGetColors(const uchar *p) {
 	return (uint64)p[0] + ((uint64)p[1] << 16) + ((uint64)p[2] << 32) + ((uint64)p[3] << 48);
 }
@@ -182,219 +484,88 @@ QImage BlurLargeImage(QImage image, int radius) {
 			QImage::Format_ARGB32_Premultiplied);
 	}
 	const auto pixels = image.bits();
-
-	const auto width_m1 = width - 1;
-	const auto height_m1 = height - 1;
-	const auto widthxheight = width * height;
-	const auto div = 2 * radius + 1;
-	const auto radius_p1 = radius + 1;
-	const auto divsum = radius_p1 * radius_p1;
-
-	const auto dvcount = 256 * divsum;
-	const auto buffers = (div * 3) // stack
-		+ std::max(width, height) // vmin
-		+ widthxheight * 3 // rgb
-		+ dvcount; // dv
-	auto storage = std::vector<int>(buffers);
-	auto taken = 0;
-	const auto take = [&](int size) {
-		const auto result = gsl::make_span(storage).subspan(taken, size);
-		taken += size;
-		return result;
-	};
-
-	// Small buffers
-	const auto stack = take(div * 3).data();
-	const auto vmin = take(std::max(width, height)).data();
-
-	// Large buffers
-	const auto rgb = take(widthxheight * 3).data();
-	const auto dvs = take(dvcount);
-
-	auto &&ints = ranges::view::ints;
-	for (auto &&[value, index] : ranges::view::zip(dvs, ints(0))) {
-		value = (index / divsum);
-	}
-	const auto dv = dvs.data();
-
-	// Variables
-	auto stackpointer = 0;
-	for (const auto x : ints(0, width)) {
-		vmin[x] = std::min(x + radius_p1, width_m1);
-	}
-	for (const auto y : ints(0, height)) {
-		auto rinsum = 0;
-		auto ginsum = 0;
-		auto binsum = 0;
-		auto routsum = 0;
-		auto goutsum = 0;
-		auto boutsum = 0;
-		auto rsum = 0;
-		auto gsum = 0;
-		auto bsum = 0;
-
-		const auto y_width = y * width;
-		for (const auto i : ints(-radius, radius + 1)) {
-			const auto sir = &stack[(i + radius) * 3];
-			const auto x = std::clamp(i, 0, width_m1);
-			const auto offset = (y_width + x) * 4;
-			sir[0] = pixels[offset];
-			sir[1] = pixels[offset + 1];
-			sir[2] = pixels[offset + 2];
-
-			const auto rbs = radius_p1 - std::abs(i);
-			rsum += sir[0] * rbs;
-			gsum += sir[1] * rbs;
-			bsum += sir[2] * rbs;
-
-			if (i > 0) {
-				rinsum += sir[0];
-				ginsum += sir[1];
-				binsum += sir[2];
-			} else {
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-			}
-		}
-		stackpointer = radius;
-
-		for (const auto x : ints(0, width)) {
-			const auto position = (y_width + x) * 3;
-			rgb[position] = dv[rsum];
-			rgb[position + 1] = dv[gsum];
-			rgb[position + 2] = dv[bsum];
-
-			rsum -= routsum;
-			gsum -= goutsum;
-			bsum -= boutsum;
-
-			const auto stackstart = (stackpointer - radius + div) % div;
-			const auto sir = &stack[stackstart * 3];
-
-			routsum -= sir[0];
-			goutsum -= sir[1];
-			boutsum -= sir[2];
-
-			const auto offset = (y_width + vmin[x]) * 4;
-			sir[0] = pixels[offset];
-			sir[1] = pixels[offset + 1];
-			sir[2] = pixels[offset + 2];
-			rinsum += sir[0];
-			ginsum += sir[1];
-			binsum += sir[2];
-
-			rsum += rinsum;
-			gsum += ginsum;
-			bsum += binsum;
-			{
-				stackpointer = (stackpointer + 1) % div;
-				const auto sir = &stack[stackpointer * 3];
-
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-
-				rinsum -= sir[0];
-				ginsum -= sir[1];
-				binsum -= sir[2];
-			}
-		}
+	const auto stride = width * 4;
+	const auto area = width * height;
+
+	// The horizontal pass result, the vertical pass reads it back.
+	auto storage = std::vector<uchar>(size_t(area) * 4);
+	const auto buffer = storage.data();
+
+#ifdef ARCH_CPU_X86_FAMILY
+	if (radius <= kBlurMaxVectorRadius) {
+		const auto blur = [&](
+				const uchar *from,
+				uchar *to,
+				int lineStep,
+				int step,
+				int length) {
+			return [=](int fromLine, int tillLine) {
+				auto stack = std::vector<BlurLanes>(2 * radius + 1);
+				for (auto line = fromLine; line != tillLine; ++line) {
+					BlurLineSSE2(
+						from + line * lineStep,
+						to + line * lineStep,
+						step,
+						length,
+						radius,
+						stack.data());
+				}
+			};
+		};
+		BlurLines(height, area, blur(pixels, buffer, stride, 4, width));
+		BlurLines(width, area, blur(buffer, pixels, 4, stride, height));
+		return image;
 	}
+#endif // ARCH_CPU_X86_FAMILY
 
-	for (const auto y : ints(0, height)) {
-		vmin[y] = std::min(y + radius_p1, height_m1) * width;
+	const auto divsum = (radius + 1) * (radius + 1);
+	auto dvs = std::vector<int>(256 * divsum);
+	for (auto i = 0, count = int(dvs.size()); i != count; ++i) {
+		dvs[i] = (i / divsum);
 	}
-	for (const auto x : ints(0, width)) {
-		auto rinsum = 0;
-		auto ginsum = 0;
-		auto binsum = 0;
-		auto routsum = 0;
-		auto goutsum = 0;
-		auto boutsum = 0;
-		auto rsum = 0;
-		auto gsum = 0;
-		auto bsum = 0;
-		for (const auto i : ints(-radius, radius + 1)) {
-			const auto y = std::clamp(i, 0, height_m1);
-			const auto position = (y * width + x) * 3;
-			const auto sir = &stack[(i + radius) * 3];
-
-			sir[0] = rgb[position];
-			sir[1] = rgb[position + 1];
-			sir[2] = rgb[position + 2];
-
-			const auto rbs = radius_p1 - std::abs(i);
-			rsum += sir[0] * rbs;
-			gsum += sir[1] * rbs;
-			bsum += sir[2] * rbs;
-			if (i > 0) {
-				rinsum += sir[0];
-				ginsum += sir[1];
-				binsum += sir[2];
-			} else {
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-			}
-		}
-		stackpointer = radius;
-		for (const auto y : ints(0, height)) {
-			const auto offset = (y * width + x) * 4;
-			pixels[offset] = dv[rsum];
-			pixels[offset + 1] = dv[gsum];
-			pixels[offset + 2] = dv[bsum];
-			rsum -= routsum;
-			gsum -= goutsum;
-			bsum -= boutsum;
-
-			const auto stackstart = (stackpointer - radius + div) % div;
-			const auto sir = &stack[stackstart * 3];
-
-			routsum -= sir[0];
-			goutsum -= sir[1];
-			boutsum -= sir[2];
-
-			const auto position = (vmin[y] + x) * 3;
-			sir[0] = rgb[position];
-			sir[1] = rgb[position + 1];
-			sir[2] = rgb[position + 2];
-
-			rinsum += sir[0];
-			ginsum += sir[1];
-			binsum += sir[2];
-
-			rsum += rinsum;
-			gsum += ginsum;
-			bsum += binsum;
-			{
-				stackpointer = (stackpointer + 1) % div;
-				const auto sir = &stack[stackpointer * 3];
-
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-
-				rinsum -= sir[0];
-				ginsum -= sir[1];
-				binsum -= sir[2];
+	const auto dv = dvs.data();
+	const auto blur = [&](
+			const uchar *from,
+			uchar *to,
+			int lineStep,
+			int step,
+			int length) {
+		return [=](int fromLine, int tillLine) {
+			auto stack = std::vector<int>((2 * radius + 1) * 3);
+			for (auto line = fromLine; line != tillLine; ++line) {
+				BlurLine(
+					from + line * lineStep,
+					to + line * lineStep,
+					step,
+					length,
+					radius,
+					dv,
+					stack.data());
 			}
-		}
-	}
+		};
+	};
+	BlurLines(height, area, blur(pixels, buffer, stride, 4, width));
+	BlurLines(width, area, blur(buffer, pixels, 4, stride, height));
 	return image;
 }
 
 void prepareCircle(QImage &img) {
 	Assert(!img.isNull());
 
-	img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+	img = std::move(img).convertToFormat(
+		QImage::Format_ARGB32_Premultiplied);
 	Assert(!img.isNull());
 
-	Painter p(&img);
-	p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-	p.drawImage(
-		QRect(QPoint(), img.size() / img.devicePixelRatio()),
-		circleMask(img.size()));
+	const auto &mask = circleMask(img.size());
+	Assert(mask.depth() == 32);
+
+	MaskPixels(
+		reinterpret_cast<uint32*>(img.bits()),
+		img.bytesPerLine() / 4,
+		mask.constBits(),
+		4,
+		mask.bytesPerLine(),
+		img.size());
 }
 
 void prepareRound(
@@ -430,21 +601,17 @@ void prepareRound(
 		auto maskBytesPerPixel = (mask.depth() >> 3);
 		auto maskBytesPerLine = mask.bytesPerLine();
 		auto maskBytesAdded = maskBytesPerLine - maskWidth * maskBytesPerPixel;
-		auto maskBytes = mask.constBits();
 		Assert(maskBytesAdded >= 0);
 		Assert(mask.depth() == (maskBytesPerPixel << 3));
 		auto imageIntsAdded = imageIntsPerLine - maskWidth * imageIntsPerPixel;
 		Assert(imageIntsAdded >= 0);
-		for (auto y = 0; y != maskHeight; ++y) {
-			for (auto x = 0; x != maskWidth; ++x) {
-				auto opacity = static_cast<anim::ShiftedMultiplier>(*maskBytes) + 1;
-				*imageInts = anim::unshifted(anim::shifted(*imageInts) * opacity);
-				maskBytes += maskBytesPerPixel;
-				imageInts += imageIntsPerPixel;
-			}
-			maskBytes += maskBytesAdded;
-			imageInts += imageIntsAdded;
-		}
+		MaskPixels(
+			imageInts,
+			imageIntsPerLine,
+			mask.constBits(),
+			maskBytesPerPixel,
+			maskBytesPerLine,
+			QSize(maskWidth, maskHeight));
 	};
 	if (corners & RectPart::TopLeft) maskCorner(intsTopLeft, cornerMasks[0]);
 	if (corners & RectPart::TopRight) maskCorner(intsTopRight, cornerMasks[1]);
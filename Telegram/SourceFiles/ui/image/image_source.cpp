@@ -14,8 +14,119 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_item.h"
 #include "history/history.h"
 #include "main/main_session.h"
+#include "core/media_active_cache.h"
 
 namespace Images {
+namespace {
+
+// Original bytes of remote images are kept up to 32 MB, so that an
+// unloaded image is decoded again without reading it from disk.
+constexpr auto kMemoryForCompressed = 32 * 1024 * 1024;
+
+[[nodiscard]] Core::MediaActiveCache<RemoteSource> &CompressedCache() {
+	static auto Instance = Core::MediaActiveCache<RemoteSource>(
+		"Compressed images",
+		kMemoryForCompressed,
+		[](RemoteSource *source) { source->dropCompressed(); });
+	return Instance;
+}
+
+// With more images waiting they are decoded right on the main thread.
+constexpr auto kMaxDecodingInParallel = 2;
+constexpr auto kMaxDecodingQueued = 64;
+
+[[nodiscard]] QImage DecodeImage(const QByteArray &bytes, QSize shrinkBox) {
+	auto result = App::readImage(bytes, nullptr, false, nullptr, shrinkBox);
+	if (!shrinkBox.isEmpty()
+		&& (result.width() > shrinkBox.width()
+			|| result.height() > shrinkBox.height())) {
+		return result.scaled(
+			shrinkBox,
+			Qt::KeepAspectRatio,
+			Qt::SmoothTransformation);
+	}
+	return result;
+}
+
+class Decoder final {
+public:
+	// Returns false if the queue is full.
+	bool enqueue(
+		QByteArray bytes,
+		QSize shrinkBox,
+		base::binary_guard guard,
+		FnMut<void(QImage &&image)> done);
+
+private:
+	struct Task {
+		QByteArray bytes;
+		QSize shrinkBox;
+		base::binary_guard guard;
+		FnMut<void(QImage &&image)> done;
+	};
+
+	void startNext();
+	void finished();
+
+	std::deque<Task> _queue;
+	int _running = 0;
+
+};
+
+[[nodiscard]] Decoder &DecoderInstance() {
+	static auto Instance = Decoder();
+	return Instance;
+}
+
+bool Decoder::enqueue(
+		QByteArray bytes,
+		QSize shrinkBox,
+		base::binary_guard guard,
+		FnMut<void(QImage &&image)> done) {
+	if (int(_queue.size()) >= kMaxDecodingQueued) {
+		return false;
+	}
+	_queue.push_back({
+		std::move(bytes),
+		shrinkBox,
+		std::move(guard),
+		std::move(done) });
+	startNext();
+	return true;
+}
+
+void Decoder::startNext() {
+	while (_running < kMaxDecodingInParallel && !_queue.empty()) {
+		auto task = std::move(_queue.front());
+		_queue.pop_front();
+		if (!task.guard) {
+			continue;
+		}
+		++_running;
+		crl::async([task = std::move(task)]() mutable {
+			auto image = task.guard
+				? DecodeImage(task.bytes, task.shrinkBox)
+				: QImage();
+			crl::on_main([
+				guard = std::move(task.guard),
+				done = std::move(task.done),
+				image = std::move(image)
+			]() mutable {
+				DecoderInstance().finished();
+				if (guard) {
+					done(std::move(image));
+				}
+			});
+		});
+	}
+}
+
+void Decoder::finished() {
+	--_running;
+	startNext();
+}
+
+} // namespace
 
 ImageSource::ImageSource(QImage &&data, const QByteArray &format)
 : _data(std::move(data))
@@ -280,10 +391,18 @@ QImage RemoteSource::takeLoaded() {
 		destroyLoader();
 		return QImage();
 	}
-	auto data = _loader->imageData(shrinkBox());
+	if (!_decoded) {
+		if (!_loader->imageDataReady() && startDecoding()) {
+			return QImage();
+		}
+		_decoded = _loader->imageData(shrinkBox());
+	}
+	auto data = *base::take(_decoded);
 	if (data.isNull()) {
 		// Bad content in the image.
 		data = Image::Empty()->original();
+	} else {
+		keepCompressed(_loader->bytes());
 	}
 
 	setInformation(_loader->bytes().size(), data.width(), data.height());
@@ -293,10 +412,26 @@ QImage RemoteSource::takeLoaded() {
 	return data;
 }
 
+bool RemoteSource::startDecoding() {
+	if (_decoding) {
+		return true;
+	}
+	return DecoderInstance().enqueue(
+		_loader->bytes(),
+		shrinkBox(),
+		_decoding.make_guard(),
+		[=](QImage &&image) {
+			_decoded = std::move(image);
+			Auth().downloaderTaskFinished().notify();
+		});
+}
+
 void RemoteSource::destroyLoader() {
 	if (!_loader) {
 		return;
 	}
+	_decoding = nullptr;
+	_decoded = std::nullopt;
 
 	const auto loader = base::take(_loader);
 	if (cancelled()) {
@@ -306,7 +441,7 @@ void RemoteSource::destroyLoader() {
 }
 
 void RemoteSource::loadLocal() {
-	if (_loader) {
+	if (_loader || loadCompressed()) {
 		return;
 	}
 
@@ -337,6 +472,40 @@ void RemoteSource::setImageBytes(const QByteArray &bytes) {
 	}
 }
 
+void RemoteSource::keepCompressed(const QByteArray &bytes) {
+	dropCompressed();
+	if (bytes.isEmpty() || bytes.size() > Storage::kMaxFileInMemory) {
+		return;
+	}
+	_compressed = bytes;
+	auto &cache = CompressedCache();
+	cache.increment(_compressed.size());
+	cache.up(this);
+}
+
+void RemoteSource::dropCompressed() {
+	if (_compressed.isEmpty()) {
+		return;
+	}
+	auto &cache = CompressedCache();
+	cache.decrement(_compressed.size());
+	cache.remove(this);
+	_compressed = QByteArray();
+}
+
+bool RemoteSource::loadCompressed() {
+	if (_loader || _compressed.isEmpty()) {
+		return false;
+	}
+	_loader = createLoader({}, LoadFromLocalOnly, true);
+	if (!_loader) {
+		return false;
+	}
+	_loader->finishWithBytes(_compressed);
+	CompressedCache().up(this);
+	return true;
+}
+
 bool RemoteSource::loading() {
 	return (_loader != nullptr);
 }
@@ -344,7 +513,7 @@ bool RemoteSource::loading() {
 void RemoteSource::automaticLoad(
 		Data::FileOrigin origin,
 		const HistoryItem *item) {
-	if (!item || cancelled()) {
+	if (loadCompressed() || !item || cancelled()) {
 		return;
 	}
 	const auto loadFromCloud = Data::AutoDownload::Should(
@@ -372,7 +541,7 @@ void RemoteSource::automaticLoadSettingsChanged() {
 }
 
 void RemoteSource::load(Data::FileOrigin origin) {
-	if (!_loader) {
+	if (!_loader && !loadCompressed()) {
 		_loader = createLoader(origin, LoadFromCloudOrLocal, false);
 	}
 	if (_loader) {
@@ -403,6 +572,8 @@ void RemoteSource::cancel() {
 
 void RemoteSource::unload() {
 	base::take(_loader);
+	_decoding = nullptr;
+	_decoded = std::nullopt;
 }
 
 float64 RemoteSource::progress() {
@@ -415,6 +586,7 @@ int RemoteSource::loadOffset() {
 
 RemoteSource::~RemoteSource() {
 	unload();
+	dropCompressed();
 }
 
 const StorageImageLocation &RemoteSource::location() {
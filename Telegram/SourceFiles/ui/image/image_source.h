@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "ui/image/image.h"
+#include "base/binary_guard.h"
 
 namespace Images {
 
@@ -136,6 +137,9 @@ public:
 
 	QByteArray bytesForCache() override;
 
+	// Called when the compressed images memory limit is exceeded.
+	void dropCompressed();
+
 	~RemoteSource();
 
 protected:
@@ -152,8 +156,18 @@ protected:
 private:
 	bool cancelled() const;
 	void destroyLoader();
+	void keepCompressed(const QByteArray &bytes);
+
+	// Returns true if the image will be decoded in the background.
+	bool startDecoding();
+
+	// Returns true if the loader was created from the kept bytes.
+	bool loadCompressed();
 
 	std::unique_ptr<FileLoader> _loader;
+	std::optional<QImage> _decoded;
+	base::binary_guard _decoding;
+	QByteArray _compressed;
 	bool _cancelled = false;
 
 };
@@ -15,12 +15,22 @@ uint32 colorKey(QColor c) {
 	return (((((uint32(c.red()) << 8) | uint32(c.green())) << 8) | uint32(c.blue())) << 8) | uint32(c.alpha());
 }
 
+// Colored pixmaps survive palette changes for that many palettes,
+// so that switching between two themes reuses them.
+constexpr auto kKeepPixmapsForPalettes = 2;
+
+struct IconPixmap {
+	QPixmap pixmap;
+	int paletteVersion = 0;
+};
+
 using IconMasks = QMap<const IconMask*, QImage>;
-using IconPixmaps = QMap<QPair<const IconMask*, uint32>, QPixmap>;
+using IconPixmaps = QMap<QPair<const IconMask*, uint32>, IconPixmap>;
 using IconDatas = OrderedSet<IconData*>;
 NeverFreedPointer<IconMasks> iconMasks;
 NeverFreedPointer<IconPixmaps> iconPixmaps;
 NeverFreedPointer<IconDatas> iconData;
+int iconPaletteVersion = 0;
 
 QImage createIconMask(const IconMask *mask, int scale) {
 	auto maskImage = QImage::fromData(mask->data(), mask->size(), "PNG");
@@ -269,12 +279,16 @@ void MonoIcon::ensureColorizedImage(QColor color) const {
 void MonoIcon::createCachedPixmap() const {
 	iconPixmaps.createIfNull();
 	auto key = qMakePair(_mask, colorKey(_color->c));
-	auto j = iconPixmaps->constFind(key);
-	if (j == iconPixmaps->cend()) {
+	auto j = iconPixmaps->find(key);
+	if (j == iconPixmaps->end()) {
 		auto image = colorizeImage(_maskImage, _color);
-		j = iconPixmaps->insert(key, App::pixmapFromImageInPlace(std::move(image)));
+		j = iconPixmaps->insert(key, IconPixmap{
+			App::pixmapFromImageInPlace(std::move(image)),
+			iconPaletteVersion });
+	} else {
+		j->paletteVersion = iconPaletteVersion;
 	}
-	_pixmap = j.value();
+	_pixmap = j->pixmap;
 	_size = _pixmap.size() / cIntRetinaFactor();
 }
 
@@ -333,7 +347,18 @@ int IconData::height() const {
 }
 
 void resetIcons() {
-	iconPixmaps.clear();
+	// Pixmaps are created again only for the icons that are painted.
+	++iconPaletteVersion;
+	if (iconPixmaps) {
+		const auto oldest = iconPaletteVersion - kKeepPixmapsForPalettes;
+		for (auto i = iconPixmaps->begin(); i != iconPixmaps->end();) {
+			if (i->paletteVersion < oldest) {
+				i = iconPixmaps->erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
 	if (iconData) {
 		for (auto data : *iconData) {
 			data->reset();
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "ui/text/text_entity.h"
+#include "ui/text/text_block.h"
 #include "core/click_handler.h"
 #include "base/flags.h"
 
@@ -69,7 +70,6 @@ static constexpr TextSelection AllTextSelection = { 0, 0xFFFF };
 namespace Ui {
 namespace Text {
 
-class AbstractBlock;
 struct IsolatedEmoji;
 
 struct StateRequest {
@@ -206,7 +206,7 @@ public:
 	~String();
 
 private:
-	using TextBlocks = std::vector<std::unique_ptr<AbstractBlock>>;
+	using TextBlocks = std::vector<Block>;
 	using TextLinks = QVector<ClickHandlerPtr>;
 
 	uint16 countBlockEnd(const TextBlocks::const_iterator &i, const TextBlocks::const_iterator &e) const;
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/crash_reports.h"
 
 #include <private/qfontengine_p.h>
+#include <mutex>
 
 // COPIED FROM qtextlayout.cpp AND MODIFIED
 namespace Ui {
@@ -145,6 +146,48 @@ static inline void addNextCluster(int &pos, int end, ScriptLine &line, int &glyp
 	++glyphCount;
 }
 
+// Words of short blocks, like sender names and service message texts,
+// are shaped once and reused by all the blocks with the same text.
+constexpr auto kMaxCachedBlockLength = 128;
+constexpr auto kMaxCachedBlocks = 4096;
+
+struct CachedBlock {
+	QVector<TextWord> words; // Positions are relative to the block.
+	QFixed width;
+	QFixed rpadding;
+};
+
+std::mutex CachedBlocksMutex;
+QHash<QString, CachedBlock> CachedBlocks;
+
+QString CachedBlockKey(
+		const QFont &font,
+		const QString &text,
+		QFixed minResizeWidth,
+		bool link) {
+	return font.key()
+		+ QChar('|')
+		+ QString::number(minResizeWidth.value())
+		+ (link ? qstr("|l|") : qstr("|t|"))
+		+ text;
+}
+
+std::optional<CachedBlock> LookupCachedBlock(const QString &key) {
+	std::lock_guard<std::mutex> lock(CachedBlocksMutex);
+	const auto i = CachedBlocks.constFind(key);
+	return (i != CachedBlocks.cend())
+		? std::make_optional(i.value())
+		: std::nullopt;
+}
+
+void StoreCachedBlock(const QString &key, CachedBlock &&block) {
+	std::lock_guard<std::mutex> lock(CachedBlocksMutex);
+	if (CachedBlocks.size() >= kMaxCachedBlocks) {
+		CachedBlocks.clear();
+	}
+	CachedBlocks.insert(key, std::move(block));
+}
+
 } // anonymous namespace
 
 class BlockParser {
@@ -331,6 +374,24 @@ TextBlock::TextBlock(const style::font &font, const QString &str, QFixed minResi
 		}
 
 		const auto part = str.mid(_from, length);
+		const auto key = (length <= kMaxCachedBlockLength)
+			? CachedBlockKey(blockFont->f, part, minResizeWidth, lnkIndex > 0)
+			: QString();
+		if (!key.isEmpty()) {
+			if (const auto cached = LookupCachedBlock(key)) {
+				_words.reserve(cached->words.size());
+				for (const auto &word : cached->words) {
+					_words.push_back(TextWord(
+						word.from() + _from,
+						word.f_width(),
+						word.f_rbearing(),
+						word.f_rpadding()));
+				}
+				_width = cached->width;
+				_rpadding = cached->rpadding;
+				return;
+			}
+		}
 
 		// Attempt to catch a crash in text processing
 		CrashReports::SetAnnotationRef("CrashString", &part);
@@ -339,6 +400,19 @@ TextBlock::TextBlock(const style::font &font, const QString &str, QFixed minResi
 		BlockParser parser(&engine, this, minResizeWidth, _from, part);
 
 		CrashReports::ClearAnnotationRef("CrashString");
+
+		if (!key.isEmpty()) {
+			auto cached = CachedBlock{ {}, _width, _rpadding };
+			cached.words.reserve(_words.size());
+			for (const auto &word : std::as_const(_words)) {
+				cached.words.push_back(TextWord(
+					word.from() - _from,
+					word.f_width(),
+					word.f_rbearing(),
+					word.f_rpadding()));
+			}
+			StoreCachedBlock(key, std::move(cached));
+		}
 	}
 }
 
@@ -363,5 +437,136 @@ SkipBlock::SkipBlock(const style::font &font, const QString &str, uint16 from, i
 	_width = w;
 }
 
+Block::Block(const Block &other) {
+	copyFrom(other);
+}
+
+Block::Block(Block &&other) noexcept {
+	moveFrom(other);
+}
+
+Block &Block::operator=(const Block &other) {
+	if (&other != this) {
+		destroy();
+		copyFrom(other);
+	}
+	return *this;
+}
+
+Block &Block::operator=(Block &&other) noexcept {
+	if (&other != this) {
+		destroy();
+		moveFrom(other);
+	}
+	return *this;
+}
+
+Block::~Block() {
+	destroy();
+}
+
+Block Block::Newline(
+		const style::font &font,
+		const QString &str,
+		uint16 from,
+		uint16 length,
+		uchar flags,
+		uint16 lnkIndex) {
+	return New<NewlineBlock>(font, str, from, length, flags, lnkIndex);
+}
+
+Block Block::Text(
+		const style::font &font,
+		const QString &str,
+		QFixed minResizeWidth,
+		uint16 from,
+		uint16 length,
+		uchar flags,
+		uint16 lnkIndex) {
+	return New<TextBlock>(
+		font,
+		str,
+		minResizeWidth,
+		from,
+		length,
+		flags,
+		lnkIndex);
+}
+
+Block Block::Emoji(
+		const style::font &font,
+		const QString &str,
+		uint16 from,
+		uint16 length,
+		uchar flags,
+		uint16 lnkIndex,
+		EmojiPtr emoji) {
+	return New<EmojiBlock>(font, str, from, length, flags, lnkIndex, emoji);
+}
+
+Block Block::Skip(
+		const style::font &font,
+		const QString &str,
+		uint16 from,
+		int32 w,
+		int32 h,
+		uint16 lnkIndex) {
+	return New<SkipBlock>(font, str, from, w, h, lnkIndex);
+}
+
+void Block::copyFrom(const Block &other) {
+	switch (other->type()) {
+	case TextBlockTNewline:
+		emplace<NewlineBlock>(other.unsafe<NewlineBlock>());
+		break;
+	case TextBlockTText:
+		emplace<TextBlock>(other.unsafe<TextBlock>());
+		break;
+	case TextBlockTEmoji:
+		emplace<EmojiBlock>(other.unsafe<EmojiBlock>());
+		break;
+	case TextBlockTSkip:
+		emplace<SkipBlock>(other.unsafe<SkipBlock>());
+		break;
+	default: Unexpected("Type in Block::copyFrom.");
+	}
+}
+
+void Block::moveFrom(Block &other) {
+	switch (other->type()) {
+	case TextBlockTNewline:
+		emplace<NewlineBlock>(std::move(other.unsafe<NewlineBlock>()));
+		break;
+	case TextBlockTText:
+		emplace<TextBlock>(std::move(other.unsafe<TextBlock>()));
+		break;
+	case TextBlockTEmoji:
+		emplace<EmojiBlock>(std::move(other.unsafe<EmojiBlock>()));
+		break;
+	case TextBlockTSkip:
+		emplace<SkipBlock>(std::move(other.unsafe<SkipBlock>()));
+		break;
+	default: Unexpected("Type in Block::moveFrom.");
+	}
+}
+
+void Block::destroy() {
+	switch (get()->type()) {
+	case TextBlockTNewline:
+		unsafe<NewlineBlock>().~NewlineBlock();
+		break;
+	case TextBlockTText:
+		unsafe<TextBlock>().~TextBlock();
+		break;
+	case TextBlockTEmoji:
+		unsafe<EmojiBlock>().~EmojiBlock();
+		break;
+	case TextBlockTSkip:
+		unsafe<SkipBlock>().~SkipBlock();
+		break;
+	default: Unexpected("Type in Block::destroy.");
+	}
+}
+
 } // namespace Text
 } // namespace Ui
@@ -9,6 +9,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include <private/qfixed_p.h>
 
+#include <algorithm>
+#include <type_traits>
+
 namespace Ui {
 namespace Text {
 
@@ -68,11 +71,10 @@ public:
 		return (_flags & 0xFF);
 	}
 
-	virtual std::unique_ptr<AbstractBlock> clone() const = 0;
-	virtual ~AbstractBlock() {
-	}
-
 protected:
+	// Blocks are destroyed only through Block, knowing their type.
+	~AbstractBlock() = default;
+
 	uint16 _from = 0;
 
 	uint32 _flags = 0; // 4 bits empty, 16 bits lnkIndex, 4 bits type, 8 bits flags
@@ -98,10 +100,6 @@ public:
 		return _nextDir;
 	}
 
-	std::unique_ptr<AbstractBlock> clone() const override {
-		return std::make_unique<NewlineBlock>(*this);
-	}
-
 private:
 	Qt::LayoutDirection _nextDir;
 
@@ -147,10 +145,6 @@ class TextBlock : public AbstractBlock {
 public:
 	TextBlock(const style::font &font, const QString &str, QFixed minResizeWidth, uint16 from, uint16 length, uchar flags, uint16 lnkIndex);
 
-	std::unique_ptr<AbstractBlock> clone() const override {
-		return std::make_unique<TextBlock>(*this);
-	}
-
 private:
 	friend class AbstractBlock;
 	QFixed real_f_rbearing() const {
@@ -171,10 +165,6 @@ class EmojiBlock : public AbstractBlock {
 public:
 	EmojiBlock(const style::font &font, const QString &str, uint16 from, uint16 length, uchar flags, uint16 lnkIndex, EmojiPtr emoji);
 
-	std::unique_ptr<AbstractBlock> clone() const override {
-		return std::make_unique<EmojiBlock>(*this);
-	}
-
 private:
 	EmojiPtr emoji = nullptr;
 
@@ -192,10 +182,6 @@ public:
 		return _height;
 	}
 
-	std::unique_ptr<AbstractBlock> clone() const override {
-		return std::make_unique<SkipBlock>(*this);
-	}
-
 private:
 	int32 _height;
 
@@ -205,5 +191,108 @@ private:
 
 };
 
+// Holds any block in place, so that the blocks of a text are stored
+// in one contiguous array instead of an allocation for each of them.
+class Block final {
+	static constexpr auto kSize = std::max({
+		sizeof(NewlineBlock),
+		sizeof(TextBlock),
+		sizeof(EmojiBlock),
+		sizeof(SkipBlock),
+	});
+	static constexpr auto kAlignment = std::max({
+		alignof(NewlineBlock),
+		alignof(TextBlock),
+		alignof(EmojiBlock),
+		alignof(SkipBlock),
+	});
+	using Storage = std::aligned_storage_t<kSize, kAlignment>;
+
+public:
+	Block(const Block &other);
+	Block(Block &&other) noexcept;
+	Block &operator=(const Block &other);
+	Block &operator=(Block &&other) noexcept;
+	~Block();
+
+	[[nodiscard]] static Block Newline(
+		const style::font &font,
+		const QString &str,
+		uint16 from,
+		uint16 length,
+		uchar flags,
+		uint16 lnkIndex);
+
+	[[nodiscard]] static Block Text(
+		const style::font &font,
+		const QString &str,
+		QFixed minResizeWidth,
+		uint16 from,
+		uint16 length,
+		uchar flags,
+		uint16 lnkIndex);
+
+	[[nodiscard]] static Block Emoji(
+		const style::font &font,
+		const QString &str,
+		uint16 from,
+		uint16 length,
+		uchar flags,
+		uint16 lnkIndex,
+		EmojiPtr emoji);
+
+	[[nodiscard]] static Block Skip(
+		const style::font &font,
+		const QString &str,
+		uint16 from,
+		int32 w,
+		int32 h,
+		uint16 lnkIndex);
+
+	// Pointer-like access, the same way as through a smart pointer.
+	[[nodiscard]] AbstractBlock *get() const {
+		return reinterpret_cast<AbstractBlock*>(
+			const_cast<Storage*>(&_data));
+	}
+	[[nodiscard]] AbstractBlock *operator->() const {
+		return get();
+	}
+	[[nodiscard]] AbstractBlock &operator*() const {
+		return *get();
+	}
+
+private:
+	Block() = default;
+
+	template <typename BlockType, typename ...Args>
+	[[nodiscard]] static Block New(Args &&...args) {
+		auto result = Block();
+		result.emplace<BlockType>(std::forward<Args>(args)...);
+		return result;
+	}
+
+	template <typename BlockType, typename ...Args>
+	void emplace(Args &&...args) {
+		new (&_data) BlockType(std::forward<Args>(args)...);
+	}
+
+	template <typename BlockType>
+	[[nodiscard]] BlockType &unsafe() {
+		return *reinterpret_cast<BlockType*>(&_data);
+	}
+
+	template <typename BlockType>
+	[[nodiscard]] const BlockType &unsafe() const {
+		return *reinterpret_cast<const BlockType*>(&_data);
+	}
+
+	void copyFrom(const Block &other);
+	void moveFrom(Block &other);
+	void destroy();
+
+	Storage _data;
+
+};
+
 } // namespace Text
 } // namespace Ui
@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "ui/text/text_entity.h"
 
+#include "ui/text/text_entity_triggers.h"
 #include "main/main_session.h"
 #include "lang/lang_tag.h"
 #include "base/qthelp_url.h"
@@ -1614,6 +1615,17 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 	int32 len = result.text.size(), commandOffset = rich ? 0 : len;
 	bool inLink = false, commandIsLink = false;
 	const QChar *start = result.text.constData(), *end = start + result.text.size();
+
+	// Each expression needs its trigger character in the match.
+	const auto triggers = FindEntityTriggers(result.text.utf16(), len);
+	const auto match = [&](
+			const QRegularExpression &expression,
+			int trigger,
+			int from) {
+		return (trigger >= from)
+			? expression.match(result.text, from)
+			: QRegularExpressionMatch();
+	};
 	for (int32 offset = 0, matchOffset = offset, mentionSkip = 0; offset < len;) {
 		if (commandOffset <= offset) {
 			for (commandOffset = offset; commandOffset < len; ++commandOffset) {
@@ -1624,11 +1636,11 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 				}
 			}
 		}
-		auto mDomain = qthelp::RegExpDomain().match(result.text, matchOffset);
-		auto mExplicitDomain = qthelp::RegExpDomainExplicit().match(result.text, matchOffset);
-		auto mHashtag = withHashtags ? RegExpHashtag().match(result.text, matchOffset) : QRegularExpressionMatch();
-		auto mMention = withMentions ? RegExpMention().match(result.text, qMax(mentionSkip, matchOffset)) : QRegularExpressionMatch();
-		auto mBotCommand = withBotCommands ? RegExpBotCommand().match(result.text, matchOffset) : QRegularExpressionMatch();
+		auto mDomain = match(qthelp::RegExpDomain(), triggers.dot, matchOffset);
+		auto mExplicitDomain = match(qthelp::RegExpDomainExplicit(), triggers.colon, matchOffset);
+		auto mHashtag = withHashtags ? match(RegExpHashtag(), triggers.hash, matchOffset) : QRegularExpressionMatch();
+		auto mMention = withMentions ? match(RegExpMention(), triggers.at, qMax(mentionSkip, matchOffset)) : QRegularExpressionMatch();
+		auto mBotCommand = withBotCommands ? match(RegExpBotCommand(), triggers.slash, matchOffset) : QRegularExpressionMatch();
 
 		auto lnkType = EntityType::Url;
 		int32 lnkStart = 0, lnkLength = 0;
@@ -1668,7 +1680,7 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 			}
 			if (!(start + mentionStart + 1)->isLetter() || !(start + mentionEnd - 1)->isLetterOrNumber()) {
 				mentionSkip = mentionEnd;
-				mMention = RegExpMention().match(result.text, qMax(mentionSkip, matchOffset));
+				mMention = match(RegExpMention(), triggers.at, qMax(mentionSkip, matchOffset));
 				if (mMention.hasMatch()) {
 					mentionStart = mMention.capturedStart();
 					mentionEnd = mMention.capturedEnd();
@@ -0,0 +1,102 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "ui/text/text_entity_triggers.h"
+
+#include "base/build_config.h"
+
+#ifdef ARCH_CPU_X86_FAMILY
+#include <emmintrin.h>
+#ifdef COMPILER_MSVC
+#define TDESKTOP_SSE2_TARGET
+#else // COMPILER_MSVC
+#define TDESKTOP_SSE2_TARGET __attribute__((target("sse2")))
+#endif // COMPILER_MSVC
+#endif // ARCH_CPU_X86_FAMILY
+
+namespace TextUtilities {
+namespace {
+
+inline void CheckTrigger(EntityTriggers &result, ushort ch, int index) {
+	switch (ch) {
+	case '.': result.dot = index; break;
+	case ':': result.colon = index; break;
+	case '#': result.hash = index; break;
+	case '@': result.at = index; break;
+	case '/': result.slash = index; break;
+	}
+}
+
+void FindTriggers(
+		EntityTriggers &result,
+		const ushort *text,
+		int from,
+		int till) {
+	for (auto i = from; i != till; ++i) {
+		CheckTrigger(result, text[i], i);
+	}
+}
+
+#ifdef ARCH_CPU_X86_FAMILY
+
+constexpr auto kChunk = 8;
+
+TDESKTOP_SSE2_TARGET EntityTriggers FindTriggersSSE2(
+		const ushort *text,
+		int length) {
+	const auto dot = _mm_set1_epi16('.');
+	const auto colon = _mm_set1_epi16(':');
+	const auto hash = _mm_set1_epi16('#');
+	const auto at = _mm_set1_epi16('@');
+	const auto slash = _mm_set1_epi16('/');
+
+	auto result = EntityTriggers();
+	const auto chunks = length - (length % kChunk);
+	for (auto i = 0; i != chunks; i += kChunk) {
+		const auto value = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(text + i));
+		const auto found = _mm_or_si128(
+			_mm_or_si128(
+				_mm_or_si128(
+					_mm_cmpeq_epi16(value, dot),
+					_mm_cmpeq_epi16(value, colon)),
+				_mm_or_si128(
+					_mm_cmpeq_epi16(value, hash),
+					_mm_cmpeq_epi16(value, at))),
+			_mm_cmpeq_epi16(value, slash));
+
+		// Most chunks have no triggers, the rare ones are checked by hand.
+		if (_mm_movemask_epi8(found)) {
+			FindTriggers(result, text, i, i + kChunk);
+		}
+	}
+	FindTriggers(result, text, chunks, length);
+	return result;
+}
+
+#endif // ARCH_CPU_X86_FAMILY
+
+} // namespace
+
+EntityTriggers FindEntityTriggers(const ushort *text, int length) {
+#ifdef ARCH_CPU_X86_FAMILY
+	return FindTriggersSSE2(text, length);
+#else // ARCH_CPU_X86_FAMILY
+	return details::FindEntityTriggersFallback(text, length);
+#endif // ARCH_CPU_X86_FAMILY
+}
+
+namespace details {
+
+EntityTriggers FindEntityTriggersFallback(const ushort *text, int length) {
+	auto result = EntityTriggers();
+	FindTriggers(result, text, 0, length);
+	return result;
+}
+
+} // namespace details
+} // namespace TextUtilities
@@ -0,0 +1,37 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+
+namespace TextUtilities {
+
+// Last positions of the characters every match of the entity regular
+// expressions contains, -1 if there is no such character in the text.
+// A regular expression can't match after the last of its characters.
+struct EntityTriggers {
+	int dot = -1; // Domains.
+	int colon = -1; // Domains with a protocol.
+	int hash = -1; // Hashtags.
+	int at = -1; // Mentions.
+	int slash = -1; // Bot commands.
+};
+
+[[nodiscard]] EntityTriggers FindEntityTriggers(
+	const ushort *text,
+	int length);
+
+namespace details {
+
+// Always the plain loop, one character after another.
+[[nodiscard]] EntityTriggers FindEntityTriggersFallback(
+	const ushort *text,
+	int length);
+
+} // namespace details
+} // namespace TextUtilities
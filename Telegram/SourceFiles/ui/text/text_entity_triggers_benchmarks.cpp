@@ -0,0 +1,60 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "base/benchmark.h"
+
+#include "ui/text/text_entity_triggers.h"
+#include <vector>
+
+namespace {
+
+using namespace TextUtilities;
+
+// A long message of words with a few links and mentions.
+const std::vector<ushort> &Text() {
+	static const auto result = [] {
+		const auto part = "Lorem ipsum dolor sit amet, consectetur "
+			"adipiscing elit @mention, sed do eiusmod tempor #hashtag "
+			"incididunt ut labore https://telegram.org et dolore magna\n";
+		auto result = std::vector<ushort>();
+		while (result.size() < 4096) {
+			for (auto ch = part; *ch; ++ch) {
+				result.push_back(ushort(uchar(*ch)));
+			}
+		}
+		return result;
+	}();
+	return result;
+}
+
+int64 Sum(const EntityTriggers &triggers) {
+	return triggers.dot
+		+ triggers.colon
+		+ triggers.hash
+		+ triggers.at
+		+ triggers.slash;
+}
+
+} // namespace
+
+BENCHMARK("FindEntityTriggers 4KB") {
+	const auto &text = Text();
+	for (auto i = 0; i != iterations; ++i) {
+		base::benchmark::Consume(Sum(FindEntityTriggers(
+			text.data(),
+			int(text.size()))));
+	}
+}
+
+BENCHMARK("FindEntityTriggersFallback 4KB") {
+	const auto &text = Text();
+	for (auto i = 0; i != iterations; ++i) {
+		base::benchmark::Consume(Sum(details::FindEntityTriggersFallback(
+			text.data(),
+			int(text.size()))));
+	}
+}
@@ -0,0 +1,106 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "ui/text/text_entity_triggers.h"
+
+#include <vector>
+
+namespace {
+
+using namespace TextUtilities;
+
+std::vector<ushort> Generate(int length, int seed) {
+	// Mostly letters, some triggers and some characters above latin1.
+	const ushort alphabet[] = {
+		'a', 'b', 'z', 'A', '0', ' ', '\n', '-', '_', '?',
+		'.', ':', '#', '@', '/', 0x0410, 0x2026, 0xFF0E, 0x2E40, 0xD83D,
+	};
+	constexpr auto kAlphabet = sizeof(alphabet) / sizeof(alphabet[0]);
+	auto result = std::vector<ushort>(length);
+	auto state = uint32(seed * 7919 + 1);
+	for (auto &ch : result) {
+		state = state * 1103515245U + 12345U;
+		const auto letter = (state >> 16) % 64;
+		ch = alphabet[(letter < kAlphabet) ? letter : (letter % 10)];
+	}
+	return result;
+}
+
+std::vector<ushort> FromLatin1(const char *text) {
+	auto result = std::vector<ushort>();
+	for (; *text; ++text) {
+		result.push_back(ushort(uchar(*text)));
+	}
+	return result;
+}
+
+void RequireEqual(const EntityTriggers &a, const EntityTriggers &b) {
+	REQUIRE(a.dot == b.dot);
+	REQUIRE(a.colon == b.colon);
+	REQUIRE(a.hash == b.hash);
+	REQUIRE(a.at == b.at);
+	REQUIRE(a.slash == b.slash);
+}
+
+} // namespace
+
+TEST_CASE("entity triggers are found", "[text_entity_triggers]") {
+	SECTION("empty text has no triggers") {
+		const auto result = FindEntityTriggers(nullptr, 0);
+		REQUIRE(result.dot == -1);
+		REQUIRE(result.colon == -1);
+		REQUIRE(result.hash == -1);
+		REQUIRE(result.at == -1);
+		REQUIRE(result.slash == -1);
+	}
+	SECTION("last positions are reported") {
+		const auto text = FromLatin1("@a #b /c d.e http://f @g");
+		const auto result = FindEntityTriggers(text.data(), int(text.size()));
+		REQUIRE(result.dot == 10);
+		REQUIRE(result.colon == 17);
+		REQUIRE(result.hash == 3);
+		REQUIRE(result.at == 22);
+		REQUIRE(result.slash == 19);
+	}
+	SECTION("similar characters are not triggers") {
+		const ushort text[] = { 0xFF0E, 0x2024, 0xFF03, 0xFF20, 0x2215,
+			0x012E, 0x013A, 0x0123, 0x0140, 0x012F };
+		RequireEqual(FindEntityTriggers(text, 10), EntityTriggers());
+	}
+	SECTION("matches the plain loop") {
+		for (auto length = 0; length != 80; ++length) {
+			const auto text = Generate(length, length);
+			RequireEqual(
+				FindEntityTriggers(text.data(), length),
+				details::FindEntityTriggersFallback(text.data(), length));
+		}
+		for (auto seed = 0; seed != 16; ++seed) {
+			const auto text = Generate(4096 + seed, seed);
+			const auto length = int(text.size());
+			RequireEqual(
+				FindEntityTriggers(text.data(), length),
+				details::FindEntityTriggersFallback(text.data(), length));
+		}
+	}
+	SECTION("reads nothing outside the text") {
+		auto text = Generate(40, 1);
+		for (auto &ch : text) {
+			if (ch == '.') {
+				ch = 'x';
+			}
+		}
+		text[0] = text[39] = '.';
+		for (auto from = 1; from != 9; ++from) {
+			const auto result = FindEntityTriggers(
+				text.data() + from,
+				38 - from);
+			REQUIRE(result.dot == -1);
+		}
+	}
+}
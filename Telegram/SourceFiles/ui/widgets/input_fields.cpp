@@ -2022,6 +2022,11 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 	while (true) {
 		FormattingAction action;
 
+		// Emoji found in one pass are replaced together, other actions
+		// found after them are left for the next pass.
+		auto emojis = std::vector<FormattingAction>();
+		auto stopPass = false;
+
 		auto fromBlock = document->findBlock(insertPosition);
 		auto tillBlock = document->findBlock(insertEnd);
 		if (tillBlock.isValid()) tillBlock = tillBlock.next();
@@ -2043,6 +2048,10 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 
 				auto format = fragment.charFormat();
 				if (!format.hasProperty(kTagProperty)) {
+					if (!emojis.empty()) {
+						stopPass = true;
+						break;
+					}
 					action.type = ActionType::RemoveTag;
 					action.intervalStart = fragmentPosition;
 					action.intervalEnd = fragmentPosition + fragment.length();
@@ -2060,6 +2069,10 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 				if (with.isValid()) {
 					const auto string = with.toString();
 					if (fragmentText != string) {
+						if (!emojis.empty()) {
+							stopPass = true;
+							break;
+						}
 						action.type = ActionType::ClearInstantReplace;
 						action.intervalStart = fragmentPosition
 							+ (fragmentText.startsWith(string)
@@ -2087,7 +2100,9 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 					const auto removeNewline = (_mode != Mode::MultiLine)
 						&& IsNewline(*ch);
 					if (removeNewline) {
-						if (action.type == ActionType::Invalid) {
+						if (!emojis.empty()) {
+							stopPass = true;
+						} else if (action.type == ActionType::Invalid) {
 							action.type = ActionType::RemoveNewline;
 							action.intervalStart = fragmentPosition + (ch - textStart);
 							action.intervalEnd = action.intervalStart + 1;
@@ -2099,10 +2114,13 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 					if (const auto emoji = Ui::Emoji::Find(ch, textEnd, &emojiLength)) {
 						// Replace emoji if no current action is prepared.
 						if (action.type == ActionType::Invalid) {
-							action.type = ActionType::InsertEmoji;
-							action.emoji = emoji;
-							action.intervalStart = fragmentPosition + (ch - textStart);
-							action.intervalEnd = action.intervalStart + emojiLength;
+							auto &entry = emojis.emplace_back();
+							entry.type = ActionType::InsertEmoji;
+							entry.emoji = emoji;
+							entry.intervalStart = fragmentPosition + (ch - textStart);
+							entry.intervalEnd = entry.intervalStart + emojiLength;
+							ch += emojiLength - 1;
+							continue;
 						}
 						break;
 					}
@@ -2111,6 +2129,9 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 						// Remove tag name till the end if no current action is prepared.
 						if (action.type != ActionType::Invalid) {
 							break;
+						} else if (!emojis.empty()) {
+							stopPass = true;
+							break;
 						}
 						breakTagOnNotLetter = false;
 						if (fragmentPosition + (ch - textStart) < breakTagOnNotLetterTill) {
@@ -2123,7 +2144,10 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 					if (tildeFormatting) { // Tilde symbol fix in OpenSans.
 						bool tilde = (ch->unicode() == '~');
 						if ((tilde && !isTildeFragment) || (!tilde && isTildeFragment)) {
-							if (action.type == ActionType::Invalid) {
+							if (!emojis.empty()) {
+								stopPass = true;
+								break;
+							} else if (action.type == ActionType::Invalid) {
 								action.type = ActionType::TildeFont;
 								action.intervalStart = fragmentPosition + (ch - textStart);
 								action.intervalEnd = action.intervalStart + 1;
@@ -2141,21 +2165,49 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 						++ch;
 					}
 				}
-				if (action.type != ActionType::Invalid) {
+				if (action.type != ActionType::Invalid || stopPass) {
 					break;
 				}
 			}
-			if (action.type != ActionType::Invalid) {
+			if (action.type != ActionType::Invalid || stopPass) {
 				break;
 			} else if (_mode != Mode::MultiLine
 				&& block.next() != document->end()) {
+				if (!emojis.empty()) {
+					break;
+				}
 				action.type = ActionType::RemoveNewline;
 				action.intervalStart = block.next().position() - 1;
 				action.intervalEnd = action.intervalStart + 1;
 				break;
 			}
 		}
-		if (action.type != ActionType::Invalid) {
+		if (!emojis.empty()) {
+			PrepareFormattingOptimization(document);
+
+			// Replace from the end, so that earlier positions stay valid.
+			auto removedBeforeEnd = 0;
+			auto removedBeforeLast = 0;
+			for (auto i = emojis.rbegin(); i != emojis.rend(); ++i) {
+				auto cursor = QTextCursor(
+					document->docHandle(),
+					i->intervalStart);
+				cursor.setPosition(i->intervalEnd, QTextCursor::KeepAnchor);
+				InsertEmojiAtCursor(cursor, i->emoji);
+
+				const auto removed = i->intervalEnd - i->intervalStart - 1;
+				if (insertEnd >= i->intervalEnd) {
+					removedBeforeEnd += removed;
+				}
+				if (i != emojis.rbegin()) {
+					removedBeforeLast += removed;
+				}
+			}
+			insertPosition = emojis.back().intervalStart
+				- removedBeforeLast
+				+ 1;
+			insertEnd -= removedBeforeEnd;
+		} else if (action.type != ActionType::Invalid) {
 			PrepareFormattingOptimization(document);
 
 			auto cursor = QTextCursor(
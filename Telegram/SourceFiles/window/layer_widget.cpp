@@ -52,6 +52,7 @@ public:
 		QPixmap &&specialLayerCache,
 		QPixmap &&layerCache);
 	void removeBodyCache();
+	[[nodiscard]] QPixmap takeBodyCache();
 	void startAnimation(Action action);
 	void skipAnimation(Action action);
 	void finishAnimating();
@@ -120,6 +121,12 @@ void LayerStackWidget::BackgroundWidget::removeBodyCache() {
 	}
 }
 
+QPixmap LayerStackWidget::BackgroundWidget::takeBodyCache() {
+	auto result = base::take(_bodyCache);
+	setAttribute(Qt::WA_OpaquePaintEvent, false);
+	return result;
+}
+
 void LayerStackWidget::BackgroundWidget::startAnimation(Action action) {
 	if (action == Action::ShowMainMenu) {
 		setMainMenuShown(true);
@@ -450,10 +457,19 @@ void LayerStackWidget::setCacheImages() {
 		setFocus();
 	}
 	if (_mainMenu) {
+		// While the previous animation is running the body is painted
+		// from its cache, so that grab is still what is on the screen.
+		bodyCache = _background->takeBodyCache();
 		removeBodyCache();
-		hideChildren();
-		bodyCache = Ui::GrabWidget(parentWidget());
-		showChildren();
+		const auto size = parentWidget()->size() * cIntRetinaFactor();
+		if (bodyCache.size() != size) {
+			hideChildren();
+			bodyCache = Ui::GrabWidget(
+				parentWidget(),
+				QRect(),
+				st::windowBg->c);
+			showChildren();
+		}
 		mainMenuCache = Ui::Shadow::grab(_mainMenu, st::boxRoundShadow, RectPart::Right);
 	}
 	setAttribute(Qt::WA_OpaquePaintEvent, !bodyCache.isNull());
@@ -1050,9 +1066,10 @@ QSize MediaPreviewWidget::currentDimensions() const {
 void MediaPreviewWidget::setupLottie() {
 	Expects(_document != nullptr);
 
-	_lottie = std::make_unique<Lottie::SinglePlayer>(
-		Lottie::ReadContent(_document->data(), _document->filepath()),
-		Lottie::FrameRequest{ currentDimensions() * cIntRetinaFactor() },
+	_lottie = Stickers::LottiePlayerFromDocument(
+		_document,
+		Stickers::LottieSize::MediaPreview,
+		currentDimensions() * cIntRetinaFactor(),
 		Lottie::Quality::High);
 
 	_lottie->updates(
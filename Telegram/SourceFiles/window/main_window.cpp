@@ -494,6 +494,16 @@ void MainWindow::updateUnreadCounter() {
 	const auto counter = account().sessionExists()
 		? account().session().data().unreadBadge()
 		: 0;
+	const auto muted = account().sessionExists()
+		&& account().session().data().unreadBadgeMuted();
+
+	// Most incoming messages in muted chats don't change the badge,
+	// and redrawing the tray icon is expensive on some platforms.
+	if (counter == _unreadCounter && muted == _unreadCounterMuted) {
+		return;
+	}
+	_unreadCounter = counter;
+	_unreadCounterMuted = muted;
 	_titleText = (counter > 0) ? qsl("Telegram (%1)").arg(counter) : qsl("Telegram");
 
 	unreadCounterChangedHook();
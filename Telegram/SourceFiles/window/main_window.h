@@ -180,6 +180,8 @@ private:
 	QIcon _icon;
 	bool _usingSupportIcon = false;
 	QString _titleText;
+	int _unreadCounter = -1;
+	bool _unreadCounterMuted = false;
 
 	bool _isActive = false;
 	base::Timer _isActiveTimer;
@@ -33,12 +33,17 @@ namespace {
 constexpr auto kMinimalAlertDelay = crl::time(500);
 constexpr auto kWaitingForAllGroupedDelay = crl::time(1000);
 
+// Not more than one notification in a second from one history,
+// the messages received meanwhile are shown by the last of them.
+constexpr auto kCoalesceDelay = crl::time(1000);
+
 } // namespace
 
 System::System(not_null<Main::Session*> session)
 : _session(session)
 , _waitTimer([=] { showNext(); })
-, _waitForAllGroupedTimer([=] { showGrouped(); }) {
+, _waitForAllGroupedTimer([=] { showGrouped(); })
+, _coalesceTimer([=] { showCoalesced(); }) {
 	createManager();
 
 	subscribe(settingsChanged(), [=](ChangeType type) {
@@ -139,6 +144,8 @@ void System::clearAll() {
 	_whenAlerts.clear();
 	_waiters.clear();
 	_settingWaiters.clear();
+	_lastShownAt.clear();
+	_coalesced.clear();
 }
 
 void System::clearFromHistory(History *history) {
@@ -149,6 +156,8 @@ void System::clearFromHistory(History *history) {
 	_whenAlerts.remove(history);
 	_waiters.remove(history);
 	_settingWaiters.remove(history);
+	_lastShownAt.remove(history);
+	_coalesced.remove(history);
 
 	_waitTimer.cancel();
 	showNext();
@@ -165,6 +174,8 @@ void System::clearAllFast() {
 	_whenAlerts.clear();
 	_waiters.clear();
 	_settingWaiters.clear();
+	_lastShownAt.clear();
+	_coalesced.clear();
 }
 
 void System::checkDelayed() {
@@ -222,6 +233,48 @@ void System::showGrouped() {
 	}
 }
 
+void System::showCoalesced(not_null<HistoryItem*> item) {
+	const auto history = item->history().get();
+	const auto now = crl::now();
+	const auto i = _lastShownAt.constFind(history);
+	if (i != _lastShownAt.cend() && now < i.value() + kCoalesceDelay) {
+		const auto delay = i.value() + kCoalesceDelay - now;
+		_coalesced.insert(history, item->fullId());
+		if (!_coalesceTimer.isActive()
+			|| _coalesceTimer.remainingTime() > delay) {
+			_coalesceTimer.callOnce(delay);
+		}
+		return;
+	}
+	_lastShownAt.insert(history, now);
+	_manager->showNotification(item, 0);
+}
+
+void System::showCoalesced() {
+	const auto now = crl::now();
+	auto next = crl::time(0);
+	for (auto i = _coalesced.begin(); i != _coalesced.end();) {
+		const auto history = i.key();
+		const auto when = _lastShownAt.value(history) + kCoalesceDelay;
+		if (when > now) {
+			if (!next || next > when) {
+				next = when;
+			}
+			++i;
+			continue;
+		}
+		const auto item = session().data().message(i.value());
+		i = _coalesced.erase(i);
+		if (item) {
+			_lastShownAt.insert(history, now);
+			_manager->showNotification(item, 0);
+		}
+	}
+	if (next) {
+		_coalesceTimer.callOnce(next - now);
+	}
+}
+
 void System::showNext() {
 	if (App::quitting()) return;
 
@@ -408,7 +461,7 @@ void System::showNext() {
 					// then there is no reason to wait for the timer
 					// to show the previous notification.
 					showGrouped();
-					_manager->showNotification(notifyItem, forwardedCount);
+					showCoalesced(notifyItem);
 				}
 
 				if (!history->hasNotification()) {
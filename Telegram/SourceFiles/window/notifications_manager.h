@@ -82,6 +82,8 @@ public:
 private:
 	void showNext();
 	void showGrouped();
+	void showCoalesced(not_null<HistoryItem*> item);
+	void showCoalesced();
 	void ensureSoundCreated();
 
 	not_null<Main::Session*> _session;
@@ -115,6 +117,10 @@ private:
 	int _lastForwardedCount = 0;
 	FullMsgId _lastHistoryItemId;
 
+	QMap<History*, crl::time> _lastShownAt;
+	QMap<History*, FullMsgId> _coalesced;
+	base::Timer _coalesceTimer;
+
 };
 
 class Manager {
@@ -86,8 +86,8 @@ void SectionWidget::PaintBackground(not_null<QWidget*> widget, QRect clip) {
 		return;
 	}
 	auto fromy = App::main()->backgroundFromY();
-	auto x = 0, y = 0;
-	auto cached = App::main()->cachedBackground(fill, x, y);
+	auto to = QRect();
+	auto cached = App::main()->cachedBackground(fill, to);
 	if (cached.isNull()) {
 		if (Window::Theme::Background()->tile()) {
 			auto &pix = Window::Theme::Background()->pixmapForTiled();
@@ -115,11 +115,19 @@ void SectionWidget::PaintBackground(not_null<QWidget*> widget, QRect clip) {
 			to.moveTop(to.top() + fromy);
 			p.drawPixmap(to, pix, from);
 		}
+	} else if (cached.size() == to.size() * cIntRetinaFactor()) {
+		p.drawPixmap(to.x(), fromy + to.y(), cached);
 	} else {
-		p.drawPixmap(x, fromy + y, cached);
+		p.drawPixmap(to.translated(0, fromy), cached);
 	}
 }
 
+QPixmap SectionWidget::GrabForSlide(
+		not_null<QWidget*> widget,
+		QRect rect) {
+	return Ui::GrabWidget(widget, rect, st::windowBg->c);
+}
+
 void SectionWidget::paintEvent(QPaintEvent *e) {
 	if (_showAnimation) {
 		Painter p(this);
@@ -99,7 +99,7 @@ public:
 	// This can be used to grab with or without top bar shadow.
 	// This will be protected when animation preparation will be done inside.
 	virtual QPixmap grabForShowAnimation(const SectionSlideParams &params) {
-		return Ui::GrabWidget(this);
+		return GrabForSlide(this);
 	}
 
 	// Attempt to show the required section inside the existing one.
@@ -130,6 +130,12 @@ public:
 
 	static void PaintBackground(not_null<QWidget*> widget, QRect clip);
 
+	// Grabs over an opaque fill, so slide frames copy the pixmap
+	// instead of blending it with alpha.
+	static QPixmap GrabForSlide(
+		not_null<QWidget*> widget,
+		QRect rect = QRect());
+
 protected:
 	void paintEvent(QPaintEvent *e) override;
 
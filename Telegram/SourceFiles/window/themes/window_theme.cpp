@@ -214,7 +214,10 @@ void applyBackground(QImage &&background, bool tiled, Instance *out) {
 	}
 }
 
-bool loadThemeFromCache(const QByteArray &content, const Cached &cache) {
+bool loadThemeFromCache(
+		const QByteArray &content,
+		const Cached &cache,
+		Instance *out = nullptr) {
 	if (cache.paletteChecksum != style::palette::Checksum()) {
 		return false;
 	}
@@ -234,12 +237,16 @@ bool loadThemeFromCache(const QByteArray &content, const Cached &cache) {
 		}
 	}
 
-	if (!style::main_palette::load(cache.colors)) {
+	if (out) {
+		if (!out->palette.load(cache.colors)) {
+			return false;
+		}
+	} else if (!style::main_palette::load(cache.colors)) {
 		return false;
 	}
 	Background()->saveAdjustableColors();
 	if (!background.isNull()) {
-		applyBackground(std::move(background), cache.tiled, nullptr);
+		applyBackground(std::move(background), cache.tiled, out);
 	}
 
 	return true;
@@ -912,10 +919,16 @@ void ChatBackground::toggleNightMode(std::optional<QString> themePath) {
 		preview->pathRelative = std::move(read.pathRelative);
 		preview->content = std::move(read.content);
 		preview->instance.cached = std::move(read.cache);
-		const auto loaded = loadTheme(
+
+		// The cached palette is valid while the theme file is the same.
+		const auto loaded = loadThemeFromCache(
 			preview->content,
 			preview->instance.cached,
-			&preview->instance);
+			&preview->instance)
+			|| loadTheme(
+				preview->content,
+				preview->instance.cached,
+				&preview->instance);
 		if (!loaded) {
 			return false;
 		}
@@ -91,6 +91,7 @@ public:
 
 private:
 	void addTogglesForArchive();
+	void addMarkAsRead();
 	//bool showInfo();
 	//void addTogglePin();
 	//void addInfo();
@@ -567,9 +568,20 @@ FolderFiller::FolderFiller(
 void FolderFiller::fill() {
 	if (_source == PeerMenuSource::ChatsList) {
 		addTogglesForArchive();
+		addMarkAsRead();
 	}
 }
 
+void FolderFiller::addMarkAsRead() {
+	const auto folder = _folder;
+	if (!folder->chatListUnreadCount() && !folder->chatListUnreadMark()) {
+		return;
+	}
+	_addAction(tr::lng_context_mark_read(tr::now), [=] {
+		folder->session().api().readServerHistories(folder);
+	});
+}
+
 void FolderFiller::addTogglesForArchive() {
 	if (_folder->id() != Data::Folder::kId) {
 		return;
@@ -0,0 +1,143 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "window/window_scroll_benchmark.h"
+
+#include "ui/widgets/scroll_area.h"
+#include "ui/effects/animations.h"
+#include "base/invoke_queued.h"
+#include "boxes/confirm_box.h"
+#include "facades.h"
+
+namespace Window {
+namespace {
+
+constexpr auto kPixelsPerSecond = 4000;
+constexpr auto kSlowFrame = crl::time(33);
+
+class ScrollBenchmark final : public QObject {
+public:
+	ScrollBenchmark(
+		not_null<QWidget*> window,
+		std::vector<QPointer<Ui::ScrollArea>> areas);
+
+private:
+	struct Result {
+		QString name;
+		std::vector<crl::time> frames;
+	};
+
+	bool step(crl::time now);
+	void next();
+	void finish();
+
+	std::vector<QPointer<Ui::ScrollArea>> _areas;
+	std::vector<Result> _results;
+	Ui::Animations::Basic _animation;
+	int _index = -1;
+	crl::time _last = 0;
+	float64 _position = 0.;
+	bool _down = true;
+
+};
+
+ScrollBenchmark::ScrollBenchmark(
+	not_null<QWidget*> window,
+	std::vector<QPointer<Ui::ScrollArea>> areas)
+: QObject(window)
+, _areas(std::move(areas))
+, _animation([=](crl::time now) { return step(now); }) {
+	next();
+}
+
+bool ScrollBenchmark::step(crl::time now) {
+	const auto area = _areas[_index].data();
+	if (!area) {
+		InvokeQueued(this, [=] { next(); });
+		return false;
+	}
+	const auto passed = _last ? (now - _last) : crl::time(0);
+	if (_last) {
+		_results.back().frames.push_back(passed);
+	}
+	_last = now;
+
+	const auto delta = passed * kPixelsPerSecond / 1000.;
+	_position += _down ? delta : -delta;
+	if (_down && _position >= area->scrollTopMax()) {
+		_position = area->scrollTopMax();
+		_down = false;
+	} else if (!_down && _position <= 0.) {
+		area->scrollToY(0);
+		InvokeQueued(this, [=] { next(); });
+		return false;
+	}
+	area->scrollToY(int(std::round(_position)));
+	return true;
+}
+
+void ScrollBenchmark::next() {
+	_animation.stop();
+	while (++_index < int(_areas.size())) {
+		const auto area = _areas[_index].data();
+		if (!area || !area->isVisible() || area->scrollTopMax() <= 0) {
+			continue;
+		}
+		const auto parent = area->parentWidget();
+		_results.push_back({ parent
+			? QString(parent->metaObject()->className())
+			: QString(area->metaObject()->className()) });
+		area->scrollToY(0);
+		_last = 0;
+		_position = 0.;
+		_down = true;
+		_animation.start();
+		return;
+	}
+	finish();
+}
+
+void ScrollBenchmark::finish() {
+	auto lines = QStringList();
+	for (auto &[name, frames] : _results) {
+		if (frames.empty()) {
+			continue;
+		}
+		ranges::sort(frames);
+		const auto count = int(frames.size());
+		const auto total = ranges::accumulate(frames, crl::time(0));
+		const auto slow = ranges::count_if(frames, [](crl::time frame) {
+			return frame > kSlowFrame;
+		});
+		lines.push_back(qsl("%1: %2 frames, %3 ms average, "
+			"%4 ms at 95%, %5 ms max, %6 slower than %7 ms"
+		).arg(name
+		).arg(count
+		).arg(total / float64(count), 0, 'f', 1
+		).arg(frames[(count * 95) / 100]
+		).arg(frames.back()
+		).arg(slow
+		).arg(kSlowFrame));
+	}
+	const auto report = lines.isEmpty()
+		? qsl("Nothing to scroll.")
+		: lines.join('\n');
+	LOG(("Scroll Benchmark:\n%1").arg(report));
+	Ui::show(Box<InformBox>(report));
+	deleteLater();
+}
+
+} // namespace
+
+void RunScrollBenchmark(not_null<QWidget*> window) {
+	const auto areas = window->findChildren<Ui::ScrollArea*>();
+	new ScrollBenchmark(
+		window,
+		std::vector<QPointer<Ui::ScrollArea>>(areas.begin(), areas.end()));
+}
+
+} // namespace Window
@@ -0,0 +1,16 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Window {
+
+// Scrolls each visible scroll area of the window down and back up at
+// a fixed speed, then logs and shows the frame times of every area.
+void RunScrollBenchmark(not_null<QWidget*> window);
+
+} // namespace Window
@@ -55,6 +55,8 @@
     'sources': [
       '<(src_loc)/mtproto/mtp_abstract_socket.cpp',
       '<(src_loc)/mtproto/mtp_abstract_socket.h',
+      '<(src_loc)/mtproto/mtp_aes_ige.cpp',
+      '<(src_loc)/mtproto/mtp_aes_ige.h',
       '<(src_loc)/mtproto/mtp_tcp_socket.cpp',
       '<(src_loc)/mtproto/mtp_tcp_socket.h',
       '<(src_loc)/mtproto/mtp_tls_socket.cpp',
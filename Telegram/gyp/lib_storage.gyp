@@ -24,6 +24,7 @@
       'libs_loc': '../../../Libraries',
       'official_build_target%': '',
       'submodules_loc': '../ThirdParty',
+      'lz4_loc': '<(submodules_loc)/lz4/lib',
       'pch_source': '<(src_loc)/storage/storage_pch.cpp',
       'pch_header': '<(src_loc)/storage/storage_pch.h',
     },
@@ -33,10 +34,12 @@
     'dependencies': [
       'crl.gyp:crl',
       'lib_base.gyp:lib_base',
+      'lib_lz4.gyp:lib_lz4',
     ],
     'export_dependent_settings': [
       'crl.gyp:crl',
       'lib_base.gyp:lib_base',
+      'lib_lz4.gyp:lib_lz4',
     ],
     'include_dirs': [
       '<(src_loc)',
@@ -46,6 +49,7 @@
       '<(submodules_loc)/variant/include',
       '<(submodules_loc)/crl/src',
       '<(submodules_loc)/xxHash',
+      '<(lz4_loc)',
     ],
     'sources': [
       '<(src_loc)/storage/storage_clear_legacy.cpp',
@@ -71,6 +75,9 @@
       '<(src_loc)/storage/cache/storage_cache_database.h',
       '<(src_loc)/storage/cache/storage_cache_database_object.cpp',
       '<(src_loc)/storage/cache/storage_cache_database_object.h',
+      '<(src_loc)/storage/cache/storage_cache_keys_filter.cpp',
+      '<(src_loc)/storage/cache/storage_cache_keys_filter.h',
+      '<(src_loc)/storage/cache/storage_cache_keys_map.h',
       '<(src_loc)/storage/cache/storage_cache_types.cpp',
       '<(src_loc)/storage/cache/storage_cache_types.h',
     ],
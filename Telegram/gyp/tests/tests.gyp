@@ -24,6 +24,8 @@
     'dependencies': [
       '<!@(<(list_tests_command))',
       'tests_storage',
+      'tests_mtproto',
+      'tests_text',
     ],
     'sources': [
       '<!@(<(list_tests_command) --sources)',
@@ -79,6 +81,15 @@
       '<(src_loc)/base/flat_set.h',
       '<(src_loc)/base/flat_set_tests.cpp',
     ],
+  }, {
+    'target_name': 'tests_object_pool',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/object_pool.h',
+      '<(src_loc)/base/object_pool_tests.cpp',
+    ],
   }, {
     'target_name': 'tests_rpl',
     'includes': [
@@ -138,5 +149,63 @@
         '<(src_loc)/platform/win/windows_dlls.h',
       ],
     }]],
+  }, {
+    'target_name': 'tests_mtproto',
+    'includes': [
+      'common_test.gypi',
+      '../openssl.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/mtproto/mtp_aes_ige.cpp',
+      '<(src_loc)/mtproto/mtp_aes_ige.h',
+      '<(src_loc)/mtproto/mtp_aes_ige_tests.cpp',
+      '<(src_loc)/mtproto/request_batcher.h',
+      '<(src_loc)/mtproto/request_batcher_tests.cpp',
+    ],
+  }, {
+    'target_name': 'tests_text',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/ui/text/text_entity_triggers.cpp',
+      '<(src_loc)/ui/text/text_entity_triggers.h',
+      '<(src_loc)/ui/text/text_entity_triggers_tests.cpp',
+    ],
+  }, {
+    'target_name': 'benchmarks',
+    'includes': [
+      '../common_executable.gypi',
+      '../qt.gypi',
+      '../openssl.gypi',
+    ],
+    'dependencies': [
+      '../lib_storage.gyp:lib_storage',
+    ],
+    'include_dirs': [
+      '<(src_loc)',
+      '<(submodules_loc)/GSL/include',
+      '<(submodules_loc)/variant/include',
+      '<(submodules_loc)/crl/src',
+      '<(libs_loc)/range-v3/include',
+    ],
+    'sources': [
+      '<(src_loc)/base/benchmark.h',
+      '<(src_loc)/base/benchmarks_main.cpp',
+      '<(src_loc)/base/flat_map_benchmarks.cpp',
+      '<(src_loc)/rpl/rpl_benchmarks.cpp',
+      '<(src_loc)/storage/cache/storage_cache_database_benchmarks.cpp',
+      '<(src_loc)/ui/text/text_entity_triggers.cpp',
+      '<(src_loc)/ui/text/text_entity_triggers.h',
+      '<(src_loc)/ui/text/text_entity_triggers_benchmarks.cpp',
+      '<(src_loc)/platform/win/windows_dlls.cpp',
+      '<(src_loc)/platform/win/windows_dlls.h',
+    ],
+    'conditions': [[ 'not build_win', {
+      'sources!': [
+        '<(src_loc)/platform/win/windows_dlls.cpp',
+        '<(src_loc)/platform/win/windows_dlls.h',
+      ],
+    }]],
   }],
 }